@@ -1,5 +1,6 @@
 // IR.cpp
 
+#include <ulib/process.h>
 #include <ulib/utility/dir_walk.h>
 #include <ulib/utility/string_ext.h>
 
@@ -32,8 +33,14 @@
 
 UCDB* cdb_names;
 UCDB* cdb_words;
+UCDB* cdb_stats;
+UCDB* cdb_delta_names;
+UCDB* cdb_delta_words;
+UCDB* cdb_delta_stats;
 
 int32_t              IR::operation; // 0 -> add, 1 -> sub, 2 -> del, 3 -> check
+uint32_t             IR::worker;
+uint32_t             IR::num_worker = 1;
 UPosting*            IR::posting;
 UTokenizer*          IR::t;
 UString*             IR::bad_words;
@@ -141,15 +148,27 @@ void IR::parse()
       UPosting::processWord(operation);
       }
 
+   UPosting::setDocLength(operation); // number of words of the document (for the ranking)
+
    if (operation == 2) UPosting::file->_unlink(); // del
 }
 
+static uint32_t num_file, num_dir;
+
 void IR::processFile()
 {
    U_TRACE(5, "IR::processFile()")
 
    U_INTERNAL_ASSERT_EQUALS(UDirWalk::isDirectory(), false)
 
+   // NB: with the parallel index the documents (the directories if 'directory as document') are partitioned between the workers...
+
+   if (num_worker > 1 &&
+       ((UPosting::dir_content_as_doc ? num_dir : num_file++) % num_worker) != worker)
+      {
+      return;
+      }
+
    UDirWalk::setFoundFile(*UPosting::filename);
 
    IR::parse();
@@ -167,6 +186,8 @@ void IR::processDirectory()
 
    UPosting::pos_start  = 0;
    UPosting::change_dir = true;
+
+   ++num_dir;
 }
 
 void IR::loadFiles()
@@ -220,3 +241,190 @@ void IR::loadFilters()
          }
       }
 }
+
+bool IR::loadFiles(uint32_t n)
+{
+   U_TRACE(5, "IR::loadFiles(%u)", n)
+
+   // NB: every worker (process) index its part of the documents and write the tables in a segment, after we merge the segments...
+
+   UProcess proc;
+   UString pathname;
+   UVector<UString> vpathname(n);
+
+   for (worker = 0, num_worker = n; worker < n; ++worker)
+      {
+      pathname.setBuffer(cfg_db.size() + 32U);
+
+      pathname.snprintf(U_CONSTANT_TO_PARAM("%vtbl_segment.%u"), cfg_db.rep, worker);
+
+      vpathname.push_back(pathname);
+
+      if (proc.fork() == false) U_ERROR("cannot fork the worker %u for the index", worker);
+
+      if (proc.child())
+         {
+         loadFiles();
+
+         UPosting::encodeAllEntry();
+
+         if (UPosting::writeSegment(pathname) == false) U_ERROR("cannot write the segment %V", pathname.rep);
+
+         U_EXIT(0);
+         }
+      }
+
+   (void) UFile::chdir(U_NULLPTR, true);
+
+   bool result = (proc.waitAll() == U_FAILED_NONE &&
+                  UPosting::mergeSegment(vpathname));
+
+   for (uint32_t i = 0; i < n; ++i) (void) UFile::_unlink(vpathname[i].c_str());
+
+   U_RETURN(result);
+}
+
+void IR::printThroughput()
+{
+   U_TRACE_NO_PARAM(5, "IR::printThroughput()")
+
+   (void) crono.stop();
+
+   double sec = crono.getTimeElapsed() / 1000.,
+          mb  = UPosting::num_byte / (1024. * 1024.);
+
+   if (sec <= 0.) sec = 0.001;
+
+   U_MESSAGE("indexed %u documents (%.2f MB) in %.3f sec: %.1f documents/s, %.2f MB/s", UPosting::num_doc, mb, sec, UPosting::num_doc / sec, mb / sec);
+}
+
+// DELTA SEGMENT (update)
+
+static UCDB* openDelta(const UString& pathname, bool ignore_case)
+{
+   U_TRACE(5, "::openDelta(%V,%b)", pathname.rep, ignore_case)
+
+   UCDB* cdb = new UCDB(pathname, ignore_case);
+
+   if (cdb->open()) U_RETURN_POINTER(cdb, UCDB);
+
+   U_DELETE(cdb)
+
+   U_RETURN_POINTER(U_NULLPTR, UCDB);
+}
+
+static void closeDelta(UCDB*& cdb)
+{
+   U_TRACE(5, "::closeDelta(%p)", cdb)
+
+   if (cdb)
+      {
+      if (cdb->isMapped()) cdb->munmap();
+
+      U_DELETE(cdb)
+
+      cdb = U_NULLPTR;
+      }
+}
+
+void IR::openDelta()
+{
+   U_TRACE_NO_PARAM(5, "IR::openDelta()")
+
+   U_INTERNAL_ASSERT_EQUALS(cdb_delta_names, U_NULLPTR)
+
+   cdb_delta_names = ::openDelta(cfg_db + U_STRING_FROM_CONSTANT("tbl_names.delta.cdb"), false);
+
+   if (cdb_delta_names)
+      {
+      cdb_delta_words = ::openDelta(cfg_db + U_STRING_FROM_CONSTANT("tbl_words.delta.cdb"), UPosting::ignore_case);
+      cdb_delta_stats = ::openDelta(cfg_db + U_STRING_FROM_CONSTANT("tbl_stats.delta.cdb"), false);
+      }
+
+   UPosting::initDelta();
+}
+
+void IR::closeDelta()
+{
+   U_TRACE_NO_PARAM(5, "IR::closeDelta()")
+
+   ::closeDelta(cdb_delta_names);
+   ::closeDelta(cdb_delta_words);
+   ::closeDelta(cdb_delta_stats);
+
+   UPosting::initDelta();
+}
+
+void IR::removeDelta()
+{
+   U_TRACE_NO_PARAM(5, "IR::removeDelta()")
+
+   (void) UFile::_unlink((cfg_db + U_STRING_FROM_CONSTANT("tbl_names.delta.cdb")).c_str());
+   (void) UFile::_unlink((cfg_db + U_STRING_FROM_CONSTANT("tbl_words.delta.cdb")).c_str());
+   (void) UFile::_unlink((cfg_db + U_STRING_FROM_CONSTANT("tbl_stats.delta.cdb")).c_str());
+}
+
+bool IR::writeTo(UCDB* cdb, UHashMap<UString>* tbl, uint32_t tbl_space, UString pathname)
+{
+   U_TRACE(5, "IR::writeTo(%p,%p,%u,%V)", cdb, tbl, tbl_space, pathname.rep)
+
+   if (tbl->empty())
+      {
+      (void) UFile::_unlink(pathname.c_str());
+
+      U_RETURN(true);
+      }
+
+   // NB: we write a temporary file and after we rename it, so the queries can use the database in the meantime...
+
+   bool result;
+   UString tmp = pathname + U_STRING_FROM_CONSTANT(".tmp");
+   UCDB x(tmp, tbl->ignoreCase());
+
+   if (cdb) x.setCdb64(cdb->isCdb64());
+
+   result = (x.writeTo(tbl, tbl_space) &&
+             UFile::_rename(tmp.c_str(), pathname.c_str()));
+
+   if (x.isMapped()) x.munmap();
+
+   U_RETURN(result);
+}
+
+bool IR::writeDelta()
+{
+   U_TRACE_NO_PARAM(5, "IR::writeDelta()")
+
+   // NB: the table of the names is the last, the queries consult the delta segment only if it exist...
+
+   if (writeTo(cdb_words, UPosting::tbl_words, UPosting::tbl_words_space, cfg_db + U_STRING_FROM_CONSTANT("tbl_words.delta.cdb")) &&
+       writeTo(cdb_stats, UPosting::tbl_stats, UPosting::tbl_stats_space, cfg_db + U_STRING_FROM_CONSTANT("tbl_stats.delta.cdb")) &&
+       writeTo(cdb_names, UPosting::tbl_name,  UPosting::tbl_name_space,  cfg_db + U_STRING_FROM_CONSTANT("tbl_names.delta.cdb")))
+      {
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+bool IR::mergeDelta()
+{
+   U_TRACE_NO_PARAM(5, "IR::mergeDelta()")
+
+   if (cdb_delta_names == U_NULLPTR) U_RETURN(true); // NB: nothing to merge...
+
+   UPosting::mergeDelta();
+
+   if (writeTo(cdb_stats, UPosting::tbl_stats, UPosting::tbl_stats_space, cdb_stats->getPath()) &&
+       writeTo(cdb_words, UPosting::tbl_words, UPosting::tbl_words_space, cdb_words->getPath()) &&
+       writeTo(cdb_names, UPosting::tbl_name,  UPosting::tbl_name_space,  cdb_names->getPath()))
+      {
+      closeDelta();
+
+      removeDelta();
+
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
@@ -5,6 +5,7 @@
 
 #include <ulib/db/rdb.h>
 #include <ulib/command.h>
+#include <ulib/timeval.h>
 #include <ulib/tokenizer.h>
 #include <ulib/file_config.h>
 #include <ulib/utility/services.h>
@@ -46,6 +47,13 @@ We can quickly find documents where the words appear close to each other by comp
 
 extern UCDB* cdb_names;
 extern UCDB* cdb_words;
+extern UCDB* cdb_stats;
+
+// NB: the delta segment written by update (consulted by the queries until it is merged in the index)...
+
+extern UCDB* cdb_delta_names;
+extern UCDB* cdb_delta_words;
+extern UCDB* cdb_delta_stats;
 
 class IR : public UApplication {
 public:
@@ -58,6 +66,7 @@ public:
    static UVector<UString>* suffix_bad_words;
    static UVector<UString>* suffix_skip_tag_xml;
    static int32_t operation; // 0 -> add, 1 -> sub, 2 -> del, 3 -> check
+   static uint32_t num_worker, worker; // parallel index: every worker index only its part of the documents
 
     IR()
       {
@@ -75,11 +84,21 @@ public:
 
       cdb_names = new U_CDB_CLASS(cfg_db + U_STRING_FROM_CONSTANT("tbl_names.cdb"), false);
       cdb_words = new U_CDB_CLASS(cfg_db + U_STRING_FROM_CONSTANT("tbl_words.cdb"), UPosting::ignore_case);
+      cdb_stats = new U_CDB_CLASS(cfg_db + U_STRING_FROM_CONSTANT("tbl_stats.cdb"), false);
 
       if (index ||
          (((U_CDB_CLASS*)cdb_names)->open( U_RDB_OPEN_NAMES ) &&
           ((U_CDB_CLASS*)cdb_words)->open( U_RDB_OPEN_WORDS )))
          {
+         // NB: the statistics for the ranking (number of words of the documents) can be missing on a database created before...
+
+         if (index == false)
+            {
+            (void) ((U_CDB_CLASS*)cdb_stats)->open( U_RDB_OPEN_NAMES );
+
+            openDelta();
+            }
+
          posting = new UPosting(cfg_dimension, parsing, index);
 
          if (parsing)
@@ -105,24 +124,30 @@ public:
 
       ((URDB*)cdb_names)->closeReorganize();
       ((URDB*)cdb_words)->closeReorganize();
+      ((URDB*)cdb_stats)->closeReorganize();
       }
 
    void deleteDB(bool brdb = false)
       {
       U_TRACE(5, "IR::deleteDB(%b)", brdb)
 
+      closeDelta();
+
       if (cdb_names->isMapped()) cdb_names->munmap();
       if (cdb_words->isMapped()) cdb_words->munmap();
+      if (cdb_stats->isMapped()) cdb_stats->munmap();
 
       if (brdb)
          {
          U_DELETE((URDB*)cdb_names)
          U_DELETE((URDB*)cdb_words)
+         U_DELETE((URDB*)cdb_stats)
          }
       else
          {
          U_DELETE(cdb_names)
          U_DELETE(cdb_words)
+         U_DELETE(cdb_stats)
          }
 
       UApplication::exit_value = 0;
@@ -131,6 +156,21 @@ public:
    void setBadWords();
    void loadFilters();
 
+   // DELTA SEGMENT
+
+   void openDelta();
+   void closeDelta();
+   void removeDelta();
+   bool writeDelta();
+   bool mergeDelta();
+
+   bool writeTo(UCDB* cdb, UHashMap<UString>* tbl, uint32_t tbl_space, UString pathname);
+
+   // THROUGHPUT (documents/s and MB/s)
+
+   void startCrono() { crono.start(); }
+   void printThroughput();
+
    void loadFileConfig()
       {
       U_TRACE(5, "IR::loadFileConfig()")
@@ -153,6 +193,7 @@ public:
       // DIR_CONTENT_AS_DOC  consider content of directory as one document (for pongo)
       // FILTER_EXT          preprocessing for files with suffix indicated
       // FILTER_CMD          preprocessing command for files with suffix indicated in FILTER_EXT
+      // DELTA_MAX_SIZE      size of the delta segment (update) over which it is merged in background
       // -----------------------------------------------------------------------------------------------
 
       cfg_db                       = cfg[U_STRING_FROM_CONSTANT("DB")],
@@ -168,6 +209,8 @@ public:
    static void processFile();
    static void processDirectory();
 
+   bool loadFiles(uint32_t n); // parallel index: n workers write a segment that after are merged
+
    void run(int argc, char* argv[], char* env[]) // MUST BE INLINE...
       {
       U_TRACE(5, "IR::run(%d,%p,%p)", argc, argv, env)
@@ -184,6 +227,7 @@ public:
       }
 
 protected:
+   UTimeVal crono;
    UFileConfig cfg;
    UString cfg_str, cfg_db, cfg_bad_words, cfg_bad_words_ext, cfg_skip_tag_xml, cfg_filter_ext, cfg_filter_cmd;
 };
@@ -74,8 +74,10 @@ __pure int WeightWord::compareObj(const void* obj1, const void* obj2)
    int cmp;
 
 #ifdef U_STDCPP_ENABLE
-   cmp = (((const WeightWord*)obj1)->word_freq < ((const WeightWord*)obj2)->word_freq ? 1 :
-          ((const WeightWord*)obj1)->word_freq > ((const WeightWord*)obj2)->word_freq ? 0 :
+   // NB: the results are ordered by decreasing weight (score of the ranking)...
+
+   cmp = (((const WeightWord*)obj1)->word_freq > ((const WeightWord*)obj2)->word_freq ? 1 :
+          ((const WeightWord*)obj1)->word_freq < ((const WeightWord*)obj2)->word_freq ? 0 :
           ((const WeightWord*)obj1)->filename.compare(((const WeightWord*)obj2)->filename) < 0);
 #else
    cmp = ((*(const WeightWord**)obj1)->word_freq < (*(const WeightWord**)obj2)->word_freq ?  1 :
@@ -93,6 +95,18 @@ void WeightWord::sortObjects()
    if (size() > 1) vec->sort(compareObj); 
 }
 
+void WeightWord::truncate(uint32_t n)
+{
+   U_TRACE(5, "WeightWord::truncate(%u)", n)
+
+   if (size() > n)
+      {
+      sortObjects();
+
+      vec->erase(n, vec->size());
+      }
+}
+
 void WeightWord::dumpObjects()
 {
    U_TRACE(5, "WeightWord::dumpObjects()")
@@ -121,6 +135,10 @@ Query::Query()
 
    U_NEW(UQueryParser, parser, UQueryParser);
    U_NEW_STRING(request, UString);
+
+   // NB: the compiled program of the boolean queries are cached (the same query is not parsed again)...
+
+   UQueryParser::setCache(128);
 }
 
 Query::~Query()
@@ -129,6 +147,8 @@ Query::~Query()
 
    clear();
 
+   UQueryParser::clearCache();
+
    U_DELETE(parser)
    U_DELETE(request)
 }
@@ -151,9 +171,9 @@ int Query::query_meta(UStringRep* word_rep, UStringRep* value)
    if (u_dosmatch(       word_rep->data(),       word_rep->size(),
                    UPosting::word->data(), UPosting::word->size(), UPosting::ignore_case ? FNM_CASEFOLD : 0))
       {
-      UPosting::posting->_assign(value);
+      UPosting::assignPosting(value, word_rep);
 
-      UPosting::callForPostingAndSetFilename(WeightWord::push);
+      if (*UPosting::posting) UPosting::callForPostingAndSetFilename(WeightWord::push);
       }
 
    U_RETURN(1);
@@ -172,15 +192,47 @@ int Query::push(UStringRep* str_inode, UStringRep* filename)
    U_RETURN(1);
 }
 
-int Query::query_expr(UStringRep* str_inode, UStringRep* filename)
+// the words for the ranking: the positives (the sub-word of a composite word, not the meta word), return the number of words
+
+uint32_t Query::getWordToRank(UVector<UString>* positives, UVector<UString>& vword)
 {
-   U_TRACE(5, "Query::query_expr(%#.*S,%.*S)", U_STRING_TO_TRACE(*str_inode), U_STRING_TO_TRACE(*filename))
+   U_TRACE(5, "Query::getWordToRank(%p,%p)", positives, &vword)
 
-   UPosting::setDocID(str_inode);
+   UString w;
+   uint32_t i, j, n = 0;
 
-   if (parser->evaluate()) push(str_inode, filename);
+   for (i = 0; i < positives->size(); ++i)
+      {
+      w = (*positives)[i];
 
-   U_RETURN(1);
+      if (w.find_first_of("?*", 0, 2) != U_NOT_FOUND) continue;
+
+      if (w.isQuoted('"') == false)
+         {
+         if (vword.find(w) == U_NOT_FOUND) vword.push_back(w);
+
+         ++n;
+
+         continue;
+         }
+
+      UVector<UString> vsub_word(w.substr(1, w.size()-2));
+
+      for (j = 0; j < vsub_word.size(); ++j)
+         {
+         w = vsub_word[j];
+
+         if (w.size() >= UPosting::min_word_size &&
+             vword.find(w) == U_NOT_FOUND)
+            {
+            vword.push_back(w);
+            }
+         }
+
+      n += 2; // NB: a composite word is not a simple disjunction...
+      }
+
+   U_RETURN(n);
 }
 
 // NB: may be there are difficult with quoting (MINGW)...
@@ -229,9 +281,9 @@ const char* Query::checkQuoting(char* argv[], uint32_t& len)
    U_RETURN_POINTER(ptr,const char);
 }
 
-void Query::run(const char* ptr, uint32_t len, UVector<WeightWord*>* vec)
+uint32_t Query::run(const char* ptr, uint32_t len, UVector<WeightWord*>* vec, uint32_t top_k)
 {
-   U_TRACE(5, "Query::run(%.*S,%u,%p)", len, ptr, len, vec)
+   U_TRACE(5, "Query::run(%.*S,%u,%p,%u)", len, ptr, len, vec, top_k)
 
    if (vec)
       {
@@ -240,6 +292,9 @@ void Query::run(const char* ptr, uint32_t len, UVector<WeightWord*>* vec)
       WeightWord::vec = vec;
       }
 
+   UPosting::top_k     = top_k;
+   UPosting::num_match = U_NOT_FOUND;
+
    *UPosting::word = UStringExt::removeEscape(UStringExt::trim(ptr, len));
 
    U_INTERNAL_DUMP("UPosting::word = %.*S", U_STRING_TO_TRACE(*UPosting::word))
@@ -253,11 +308,42 @@ void Query::run(const char* ptr, uint32_t len, UVector<WeightWord*>* vec)
       *UPosting::word = UStringExt::substitute(*UPosting::word, U_CONSTANT_TO_PARAM("not "),
                                                                 U_CONSTANT_TO_PARAM("NOT "));
 
-      if (parser->parse(*UPosting::word))
+      if (parser->compile(*UPosting::word))
          {
-         parser->startEvaluate(UPosting::findDocID);
+         UString result;
+         UVector<UString> vword;
+         bool bdisjunction = true;
+
+         parser->setFunction(UPosting::findDocID);
+
+         for (uint32_t i = 0, n = parser->getNumTerm(); i < n; ++i)
+            {
+            if (getWordToRank(parser->getPositives(i), vword) != 1 ||
+                parser->getNegatives(i)->size()               != 0)
+               {
+               bdisjunction = false;
+               }
+            }
+
+         if (bdisjunction &&
+             vword.size() == parser->getNumTerm())
+            {
+            // NB: disjunction of words, the best results with Block-Max WAND without the set of DocID...
 
-         cdb_names->callForAllEntryWithPattern(query_expr, U_NULLPTR);
+            UPosting::callForWAND(vword, WeightWord::push);
+            }
+         else
+            {
+            // NB: we evaluate every term of the disjunctive normal form on the posting (intersection of the positives minus the negatives)
+            //     instead of the loop for all doc name...
+
+            for (uint32_t i = 0, n = parser->getNumTerm(); i < n; ++i)
+               {
+               result = UPosting::unionDocID(result, UPosting::getDocID(parser->getPositives(i), parser->getNegatives(i)));
+               }
+
+            UPosting::callForDocID(result, vword, WeightWord::push);
+            }
          }
       }
    else
@@ -273,17 +359,28 @@ void Query::run(const char* ptr, uint32_t len, UVector<WeightWord*>* vec)
          {
          if (is_space) U_ERROR("syntax error on query");
 
-         if (UPosting::word->equal(U_CONSTANT_TO_PARAM("*"))) cdb_names->callForAllEntryWithPattern(push, U_NULLPTR);
+         if (UPosting::word->equal(U_CONSTANT_TO_PARAM("*"))) UPosting::callForAllDocName(push);
          else
             {
             WeightWord::check_for_duplicate = true;
 
-            cdb_words->callForAllEntryWithPattern(query_meta, U_NULLPTR);
+            UPosting::callForAllWord(query_meta);
 
             WeightWord::check_for_duplicate = false;
             }
          }
       }
+
+   // NB: without ranking (meta word) we select here the best results...
+
+   if (UPosting::num_match == U_NOT_FOUND)
+      {
+      UPosting::num_match = WeightWord::size();
+
+      if (top_k) WeightWord::truncate(top_k);
+      }
+
+   U_RETURN(UPosting::num_match);
 }
 
 // DEBUG
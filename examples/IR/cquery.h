@@ -68,6 +68,7 @@ public:
    static void push();
    static void clear();
    static void sortObjects();
+   static void truncate(uint32_t n);
    static void dumpObjects();
    static int  compareObj(const void* obj1, const void* obj2) __pure;
 
@@ -118,7 +119,9 @@ public:
 
    // SERVICES
 
-   void run(const char* ptr, uint32_t len, UVector<WeightWord*>* vec = U_NULLPTR);
+   // return the number of document that match (an estimate with the best top_k results, 0 -> all)
+
+   uint32_t run(const char* ptr, uint32_t len, UVector<WeightWord*>* vec = U_NULLPTR, uint32_t top_k = 0);
 
    static void        clear();
    static const char* checkQuoting(char* argv[], uint32_t& len); // NB: may be there are some difficult with quoting (MINGW)...
@@ -132,7 +135,7 @@ protected:
    static UQueryParser* parser;
 
    static int push(      UStringRep* str_inode, UStringRep* filename);
-   static int query_expr(UStringRep* str_inode, UStringRep* filename);
+   static uint32_t getWordToRank(UVector<UString>* positives, UVector<UString>& vword);
    static int query_meta(UStringRep*  word_rep, UStringRep* value);
 };
 
@@ -9,7 +9,8 @@
 
 #define U_OPTIONS \
 "purpose 'index document files to be searched by query...'\n" \
-"option c config 1 'path of configuration file' ''\n"
+"option c config  1 'path of configuration file' ''\n" \
+"option j workers 1 'number of processes that index in parallel (0 -> number of cpu)' '1'\n"
 
 #include "IR.h"
 
@@ -22,6 +23,12 @@ public:
 
       IR::run(argc, argv, env);
 
+      uint32_t n = (UApplication::isOptions() ? opt['j'].strtoul() : 1);
+
+      if (n == 0) n = u_get_num_cpu();
+
+      startCrono();
+
       if (IR::openCDB(true, true))
          {
          IR::setBadWords();
@@ -32,13 +39,29 @@ public:
 
       // operation = 0; // add
 
-         IR::loadFiles();
+         if (n > 1)
+            {
+            // NB: the workers write the tables (with the posting in block format) in a segment that we merge here...
 
-         // save hash table as constant database
+            if (IR::loadFiles(n) == false) U_ERROR("cannot merge the segments of the workers");
+            }
+         else
+            {
+            IR::loadFiles();
 
-         if (cdb_names->writeTo(UPosting::tbl_name,  UPosting::tbl_name_space) &&
+            UPosting::encodeAllEntry();
+            }
+
+         // save hash table as constant database (with the posting in block format)
+
+         IR::removeDelta();
+
+         if (cdb_names->writeTo(UPosting::tbl_name,  UPosting::tbl_name_space)  &&
+             cdb_stats->writeTo(UPosting::tbl_stats, UPosting::tbl_stats_space) &&
              cdb_words->writeTo(UPosting::tbl_words, UPosting::tbl_words_space))
             {
+            printThroughput();
+
             IR::deleteDB();
             }
          }
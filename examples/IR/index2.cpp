@@ -26,6 +26,10 @@ public:
 
       IR::run(argc, argv, env);
 
+      startCrono();
+
+      IR::removeDelta();
+
       if (IR::openCDB(true))
          {
          IR::setBadWords();
@@ -41,6 +45,9 @@ public:
          // register to constant database (CDB)
 
          IR::closeCDB(false);
+
+         printThroughput();
+
          IR::deleteDB();
          }
       }
@@ -10,7 +10,7 @@
 
 class IRDataSession : public UDataSession {
 public:
-   uint32_t sz, for_page;
+   uint32_t sz, tot, for_page; // NB: tot is the number of documents that match the query, vec keeps only the best results up to the last page requested...
    UVector<WeightWord*> vec;
    UString query, timerun, buffer_data;
 
@@ -20,7 +20,7 @@ public:
       {
       U_TRACE_CTOR(5, IRDataSession, "")
 
-      sz = for_page = 0;
+      sz = tot = for_page = 0;
       }
 
    ~IRDataSession()
@@ -38,7 +38,7 @@ public:
       {
       U_TRACE(5, "IRDataSession::clear()")
 
-      sz = for_page = 0;
+      sz = tot = for_page = 0;
 
               vec.clear();
             query.clear();
@@ -54,7 +54,7 @@ public:
 
       (void) buffer_data.reserve(U_CAPACITY);
 
-      buffer_data.snprintf(U_CONSTANT_TO_PARAM("%ld %u \"%.*s\" \"%.*s\" ["), creation, for_page, U_STRING_TO_TRACE(timerun), U_STRING_TO_TRACE(query));
+      buffer_data.snprintf(U_CONSTANT_TO_PARAM("%ld %u %u \"%.*s\" \"%.*s\" ["), creation, tot, for_page, U_STRING_TO_TRACE(timerun), U_STRING_TO_TRACE(query));
 
       sz = vec.size();
 
@@ -76,6 +76,7 @@ public:
 
 #  ifdef U_STDCPP_ENABLE
       is >> creation
+         >> tot
          >> for_page;
 
       is.get(); // skip ' '
@@ -97,8 +97,30 @@ static void usp_body_ir_web()
             }
          else
             {
-            UHTTP::num_item_tot = IR_SESSION.size();
-            UHTTP::num_page_cur = USP_FORM_VALUE(0).strtol();
+            UHTTP::num_item_tot      = IR_SESSION.tot;
+            UHTTP::num_page_cur      = USP_FORM_VALUE(0).strtol();
+            UHTTP::num_item_for_page = IR_SESSION.for_page;
+   
+            uint32_t top_k = UHTTP::num_page_cur * UHTTP::num_item_for_page;
+   
+            if (IR_SESSION.size() < top_k &&
+                IR_SESSION.size() < IR_SESSION.tot)
+               {
+               // NB: we have only the best results until the last page requested, so we ask the query for the results until this page...
+   
+               query->clear();
+   
+               (void) query->run(U_STRING_TO_PARAM(IR_SESSION.query), &IR_SESSION.vec, top_k);
+   
+               WeightWord::sortObjects();
+   
+               WeightWord::vec = U_NULLPTR;
+               IR_SESSION.sz   = IR_SESSION.vec.size();
+   
+               // NB: the number of matching documents can be an estimate with the top-k evaluation...
+   
+               if (IR_SESSION.sz < top_k) UHTTP::num_item_tot = IR_SESSION.tot = IR_SESSION.sz;
+               }
             }
          }
       }
@@ -120,11 +142,15 @@ static void usp_body_ir_web()
    
       crono->start();
    
-      query->run(U_STRING_TO_PARAM(IR_SESSION.query), &IR_SESSION.vec);
+      IR_SESSION.tot = query->run(U_STRING_TO_PARAM(IR_SESSION.query), &IR_SESSION.vec, UHTTP::num_item_for_page);
    
       crono->stop();
    
-      if ((UHTTP::num_item_tot = WeightWord::size()))
+      IR_SESSION.sz = IR_SESSION.vec.size();
+   
+      if (IR_SESSION.sz < UHTTP::num_item_for_page) IR_SESSION.tot = IR_SESSION.sz;
+   
+      if ((UHTTP::num_item_tot = IR_SESSION.tot))
          {
          UHTTP::num_page_start = 1;
          UHTTP::num_page_end   = UHTTP::num_item_for_page;
@@ -180,7 +206,7 @@ static void usp_body_ir_web()
    
             UString doc, snippet_doc(U_CAPACITY), basename, filename, pathname1(U_CAPACITY), pathname2(U_CAPACITY);
    
-            for (uint32_t i = UHTTP::num_page_start-1; i < UHTTP::num_page_end; ++i)
+            for (uint32_t i = UHTTP::num_page_start-1, n = U_min(UHTTP::num_page_end, IR_SESSION.size()); i < n; ++i)
                {
                filename = IR_SESSION.vec[i]->filename;
                basename = UStringExt::basename(filename);
@@ -6,27 +6,47 @@
 
 #include "posting.h"
 
+#include <math.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 extern UCDB* cdb_names;
 extern UCDB* cdb_words;
+extern UCDB* cdb_stats;
+extern UCDB* cdb_delta_names;
+extern UCDB* cdb_delta_words;
+extern UCDB* cdb_delta_stats;
+
+static UString* vdoc_id; // NB: collect DocID for addDocID() and addDocName()...
+static UString* vdelta;  // NB: sorted vector of the DocID of the delta segment, they are removed from the posting of the index...
 
 // public
 
 bool               UPosting::change_dir;
 bool               UPosting::ignore_case;
 bool               UPosting::dir_content_as_doc;
+uint64_t           UPosting::num_byte;
+uint32_t           UPosting::num_doc;
 UFile*             UPosting::file;
 UString*           UPosting::word;
 UString*           UPosting::content;
 UString*           UPosting::posting;
 UString*           UPosting::filename;
 UString*           UPosting::str_cur_doc_id;
+uint32_t           UPosting::top_k;
 uint32_t           UPosting::word_freq;
+uint32_t           UPosting::num_match;
+uint32_t           UPosting::doc_length;
 uint32_t           UPosting::min_word_size;
 uint32_t           UPosting::tbl_name_space;
 uint32_t           UPosting::tbl_words_space;
+uint32_t           UPosting::tbl_stats_space;
 uint32_t           UPosting::max_distance = 2;
 UHashMap<UString>* UPosting::tbl_name;
 UHashMap<UString>* UPosting::tbl_words;
+UHashMap<UString>* UPosting::tbl_stats;
 
 // private
 
@@ -81,1271 +101,3415 @@ static u_property property[32];
 #define POSTING_POS(n)             u_get_unalignedp32(ptr+sizeof(u_posting)+(n*sizeof(uint32_t)))
 #define POSTING_OFFSET_LAST_DOC_ID u_get_unalignedp32(data)
 
-UPosting::UPosting(uint32_t dimension, bool parsing, bool index)
+/**
+ * Block format (on database)
+ *
+ * uint32_t header = U_POSTING_FLAG | num DOC id (the offset of the last DOC id of the format in memory never have the high bit set)
+ *
+ * if there are more than one block, the skip table: for every block (uint64_t last DOC id, uint32_t offset of block,
+ * uint32_t max frequency of block - the upper bound of the score of the block for the ranking with Block-Max WAND)
+ *
+ * for every block of U_POSTING_BLOCK entry:
+ *
+ * DOC id    (varint) - the first is the delta from the last DOC id of the previous block (the complement for the first block)
+ * frequency (varint)
+ * positions (varint) - delta from the previous position of the same DOC id
+ */
+
+#define U_POSTING_FLAG       0x80000000U
+#define U_POSTING_BLOCK      128U
+#define U_POSTING_SKIP_ENTRY (sizeof(uint64_t)+sizeof(uint32_t)+sizeof(uint32_t))
+
+#define U_SKIP_LAST(c,b)     u_get_unalignedp64((c)->skip + ((b) * U_POSTING_SKIP_ENTRY))
+#define U_SKIP_OFFSET(c,b)   u_get_unalignedp32((c)->skip + ((b) * U_POSTING_SKIP_ENTRY) + sizeof(uint64_t))
+#define U_SKIP_MAX_FREQ(c,b) u_get_unalignedp32((c)->skip + ((b) * U_POSTING_SKIP_ENTRY) + sizeof(uint64_t) + sizeof(uint32_t))
+
+typedef struct u_posting_entry {
+   uint64_t doc_id;
+   char* ptr;
+} u_posting_entry;
+
+typedef struct u_posting_cursor {
+   const char* skip;      // skip table (NULL if only one block)
+   const char* base;      // start of the blocks
+   const char* ptr_pos;   // positions of the DOC id with index idx_pos
+   const char* start_pos; // positions of the first DOC id of the current block
+   uint64_t* vdoc;        // DOC id of the current block
+   uint32_t ndoc, nblock, iblock, idoc, n, idx_pos, max_freq; // max_freq: max frequency of the current block
+   uint32_t vfreq[U_POSTING_BLOCK];
+   uint64_t vbuf[U_POSTING_BLOCK];
+} u_posting_cursor;
+
+static inline char* u_put_varint(char* p, uint64_t v)
 {
-   U_TRACE_CTOR(5, UPosting, "%u,%b,%b", dimension, parsing, index)
+   while (v >= 0x80)
+      {
+      *p++ = (char)(v | 0x80);
 
-   U_INTERNAL_ASSERT_EQUALS(word, U_NULLPTR)
-   U_INTERNAL_ASSERT_EQUALS(posting, U_NULLPTR)
-   U_INTERNAL_ASSERT_EQUALS(filename, U_NULLPTR)
-   U_INTERNAL_ASSERT_EQUALS(str_cur_doc_id, U_NULLPTR)
+      v >>= 7;
+      }
 
-   U_NEW_STRING(word, UString);
-   U_NEW_STRING(posting, UString);
-   U_NEW_STRING(filename, UString);
-   U_NEW_STRING(str_cur_doc_id, UString(sizeof(cur_doc_id)));
+   *p++ = (char)v;
 
-   approximate_num_words = 2000 + (dimension * 8);
+   return p;
+}
+
+static inline uint64_t u_get_varint(const char*& p)
+{
+   uint64_t v = 0;
 
-   if (index)
+   for (uint32_t shift = 0; ; shift += 7)
       {
-      U_INTERNAL_ASSERT_EQUALS(tbl_name, U_NULLPTR)
-      U_INTERNAL_ASSERT_EQUALS(tbl_words, U_NULLPTR)
+      unsigned char c = *(const unsigned char*)p++;
 
-      dimension += dimension / 4;
+      v |= (uint64_t)(c & 0x7f) << shift;
 
-      U_NEW(UHashMap<UString>, tbl_name,  UHashMap<UString>(u_nextPowerOfTwo(dimension)));
-      U_NEW(UHashMap<UString>, tbl_words, UHashMap<UString>(u_nextPowerOfTwo(approximate_num_words), ignore_case));
+      if (c < 0x80) return v;
       }
+}
 
-   if (parsing)
+static inline void u_skip_varint(const char*& p, uint32_t n)
+{
+   while (n)
       {
-      U_INTERNAL_ASSERT_EQUALS(file, U_NULLPTR)
-      U_INTERNAL_ASSERT_EQUALS(content, U_NULLPTR)
-
-      U_NEW(UFile, file, UFile);
-      U_NEW_STRING(content, UString);
+      if ((*(const unsigned char*)p++ & 0x80) == 0) --n;
       }
 }
 
-void UPosting::resetVectorCompositeWord()
+static int u_compare_entry(const void* e1, const void* e2)
 {
-   U_TRACE(5, "UPosting::resetVectorCompositeWord()")
+   uint64_t d1 = ((const u_posting_entry*)e1)->doc_id,
+            d2 = ((const u_posting_entry*)e2)->doc_id;
 
-   U_DELETE(sub_word)
-   U_DELETE(vec_sub_word)
-   U_DELETE(vec_sub_word_posting)
+   return (d1 < d2 ? -1 : d1 > d2);
+}
 
-   sub_word             = U_NULLPTR;
-   vec_sub_word         = U_NULLPTR;
-   vec_sub_word_posting = U_NULLPTR;
-   vec_sub_word_size    = 0;
+static int u_compare_doc_id(const void* d1, const void* d2)
+{
+   return (*(const uint64_t*)d1 < *(const uint64_t*)d2 ? -1 : *(const uint64_t*)d1 > *(const uint64_t*)d2);
 }
 
-void UPosting::reset()
+static inline uint32_t u_sort_doc_id(uint64_t* vdoc, uint32_t n) // sort and remove duplicate...
 {
-   U_TRACE(5, "UPosting::reset()")
+   if (n < 2) return n;
 
-   max_distance      = 2;
-   sub_word_pos_prev = 0;
+   qsort(vdoc, n, sizeof(uint64_t), u_compare_doc_id);
 
-   if (vec_sub_word) resetVectorCompositeWord();
+   uint32_t i, k = 1;
 
-   if (vec_word)
+   for (i = 1; i < n; ++i)
       {
-      U_DELETE(vec_word)
-      U_DELETE(vec_entry)
-      U_DELETE(vec_posting)
-
-      vec_word    = U_NULLPTR;
-      vec_entry   = U_NULLPTR;
-      vec_posting = U_NULLPTR;
+      if (vdoc[i] != vdoc[k-1]) vdoc[k++] = vdoc[i];
       }
+
+   return k;
 }
 
-UPosting::~UPosting()
+// CURSOR ON THE DOC id OF A POSTING (block format or sorted vector of DOC id)
+
+static void u_load_block(u_posting_cursor* c, uint32_t b)
 {
-   U_TRACE_DTOR(5, UPosting)
+   U_INTERNAL_ASSERT_MINOR(b, c->nblock)
 
-   U_DELETE(posting)
-   U_DELETE(filename)
-   U_DELETE(str_cur_doc_id)
+   uint64_t doc_id;
+   uint32_t i, n = (b == c->nblock-1 ? c->ndoc - (b * U_POSTING_BLOCK) : U_POSTING_BLOCK);
+   const char* p;
 
-   if (tbl_name == U_NULLPTR) reset();
+   if (c->skip == U_NULLPTR)
+      {
+      p      = c->base;
+      doc_id = ~u_get_varint(p);
+      }
    else
       {
-      U_DELETE(tbl_name)
-      U_DELETE(tbl_words)
+      p      = c->base + U_SKIP_OFFSET(c, b);
+      doc_id = (b ? U_SKIP_LAST(c, b-1) + u_get_varint(p) : ~u_get_varint(p));
       }
 
-   U_DELETE(word)
+   c->vbuf[0]  = doc_id;
+   c->max_freq = 0;
 
-   if (file)
+   for (i = 1; i < n; ++i) c->vbuf[i] = (doc_id += u_get_varint(p));
+
+   for (i = 0; i < n; ++i)
       {
-      U_DELETE(file)
-      U_DELETE(content)
+      c->vfreq[i] = (uint32_t)u_get_varint(p);
+
+      if (c->vfreq[i] > c->max_freq) c->max_freq = c->vfreq[i];
       }
+
+   c->vdoc    = c->vbuf;
+   c->n       = n;
+   c->iblock  = b;
+   c->idoc    = 0;
+   c->idx_pos = 0;
+
+   c->ptr_pos = c->start_pos = p;
 }
 
-// #define U_OPTIMIZE
-// #define U_COMPRESS_ENTRY
+static void u_open_cursor(u_posting_cursor* c, const char* s)
+{
+   c->ndoc   = u_get_unalignedp32(s) & ~U_POSTING_FLAG;
+   c->nblock = (c->ndoc + U_POSTING_BLOCK - 1) / U_POSTING_BLOCK;
+   c->skip   = (c->nblock > 1 ? s + sizeof(uint32_t) : U_NULLPTR);
+   c->base   =                  s + sizeof(uint32_t) + (c->skip ? c->nblock * U_POSTING_SKIP_ENTRY : 0);
 
-// MANAGE POSTING VALUE ON DATABASE
+   U_INTERNAL_ASSERT_MAJOR(c->ndoc, 0)
 
-inline bool UPosting::decompress()
+   u_load_block(c, 0);
+}
+
+static void u_open_cursor(u_posting_cursor* c, const UString& vdoc) // sorted vector of DOC id (without positions)
 {
-   U_TRACE(5, "UPosting::decompress()")
+   c->skip     = U_NULLPTR;
+   c->base     = U_NULLPTR; // NB: without frequency and positions, for the ranking the frequency is 1...
+   c->vdoc     = (uint64_t*)vdoc.data();
+   c->ndoc     =
+   c->n        = vdoc.size() / sizeof(uint64_t);
+   c->nblock   =
+   c->max_freq = 1;
+   c->iblock   =
+   c->idoc     = 0;
+
+   U_INTERNAL_ASSERT_MAJOR(c->ndoc, 0)
+}
 
-#ifdef U_COMPRESS_ENTRY
-   if (posting->size() > (sizeof(uint32_t) * 4) &&
-       UStringExt::isCompress(*posting))
+static inline __pure uint32_t u_lower_bound(const uint64_t* v, uint32_t lo, uint32_t n, uint64_t x)
+{
+   uint32_t mid, hi, step = 1;
+
+   // galloping...
+
+   for (hi = lo; hi < n && v[hi] < x; step <<= 1)
       {
-      posting->decompress();
+      lo  = hi + 1;
+      hi += step;
+      }
 
-      U_RETURN(true);
+   if (hi > n) hi = n;
+
+   // ...then binary search in [lo,hi)
+
+   while (lo < hi)
+      {
+      mid = (lo + hi) / 2;
+
+      if (v[mid] < x) lo = mid + 1;
+      else            hi = mid;
       }
-#endif
 
-   U_RETURN(false);
+   return lo;
 }
 
-U_NO_EXPORT void UPosting::readPosting(UStringRep* word_rep, bool flag)
+static __pure uint32_t u_find_block(u_posting_cursor* c, uint64_t x) // index of the first block with last DOC id >= x (nblock if none)
 {
-   U_TRACE(5, "UPosting::readPosting(%p,%b)", word_rep, flag)
+   if (x <= c->vdoc[c->n-1]) return c->iblock;
 
-   U_INTERNAL_ASSERT_POINTER(cdb_words)
+   if (c->skip == U_NULLPTR) return c->nblock;
 
-   *posting = (word_rep ? (flag ? (*((URDB*)cdb_words))[word_rep]
-                                : (*        cdb_words) [word_rep])
-                        : ((URDB*)cdb_words)->UCDB::elem());
+   // galloping on the skip table...
 
-#ifdef U_COMPRESS_ENTRY
-   if (decompress() == false)
-#endif
+   uint32_t mid, lo = c->iblock + 1, hi = lo, step = 1;
+
+   for (; hi < c->nblock && U_SKIP_LAST(c, hi) < x; step <<= 1)
       {
-      // check if add operation...
+      lo  = hi + 1;
+      hi += step;
+      }
 
-      if (word_rep == U_NULLPTR) posting->duplicate(); // NB: need duplicate string because we need space on string constant..
+   if (hi > c->nblock) hi = c->nblock;
+
+   while (lo < hi)
+      {
+      mid = (lo + hi) / 2;
+
+      if (U_SKIP_LAST(c, mid) < x) lo = mid + 1;
+      else                         hi = mid;
       }
 
-   U_INTERNAL_ASSERT_EQUALS(UStringExt::isCompress(posting->data()), false)
+   return lo;
 }
 
-U_NO_EXPORT int UPosting::writePosting(int flag)
+static bool u_seek_block(u_posting_cursor* c, uint64_t x) // load the first block with last DOC id >= x
 {
-   U_TRACE(5, "UPosting::writePosting(%d)", flag)
+   uint32_t b = u_find_block(c, x);
 
-   U_INTERNAL_ASSERT_POINTER(cdb_words)
-   U_INTERNAL_ASSERT_EQUALS(UStringExt::isCompress(posting->data()), false)
+   if (b == c->nblock)
+      {
+      c->idoc = c->n; // NB: the end of the posting...
 
-#ifdef U_COMPRESS_ENTRY
-   if (posting->size() > U_CAPACITY) posting->compress();
-#endif
+      return false;
+      }
 
-   int result = ((URDB*)cdb_words)->store(*word, *posting, flag);
+   if (b != c->iblock) u_load_block(c, b);
 
-   U_RETURN(result);
+   return true;
 }
 
-// FIND CURRENT DOC ID ON POSTING
-
-inline bool UPosting::checkEntry(char* str, char* s, uint32_t n)
+static inline bool u_seek(u_posting_cursor* c, uint64_t x)
 {
-   U_TRACE(5, "UPosting::checkEntry(%p,%p,%u)", str, n)
+   if (u_seek_block(c, x) == false) return false;
 
-   U_INTERNAL_ASSERT_POINTER(s)
-   U_INTERNAL_ASSERT_POINTER(str)
+   c->idoc = u_lower_bound(c->vdoc, c->idoc, c->n, x);
 
-   uint32_t offset = (str - s);
+   U_INTERNAL_ASSERT_MINOR(c->idoc, c->n)
 
-   U_INTERNAL_DUMP("offset     = %u", offset)
-   U_INTERNAL_DUMP("size_entry = %u", POSTING_SIZE(str))
+   return (c->vdoc[c->idoc] == x);
+}
 
-   if ((offset % sizeof(uint32_t)) == 0 &&
-       POSTING_SIZE(str) <= (n - offset))
+static const char* u_get_positions(u_posting_cursor* c, uint32_t* freq) // positions of the current DOC id
+{
+   U_INTERNAL_ASSERT_MINOR(c->idoc, c->n)
+
+   if (c->idx_pos > c->idoc)
       {
-      U_RETURN(true);
+      c->idx_pos = 0;
+      c->ptr_pos = c->start_pos;
       }
 
-   U_RETURN(false);
+   for (; c->idx_pos < c->idoc; ++c->idx_pos) u_skip_varint(c->ptr_pos, c->vfreq[c->idx_pos]);
+
+   *freq = c->vfreq[c->idoc];
+
+   return c->ptr_pos;
 }
 
-U_NO_EXPORT __pure char* UPosting::find(char* s, uint32_t n, bool boptmize)
+static uint32_t u_get_doc_id(u_posting_cursor* c, uint64_t* vdoc)
 {
-   U_TRACE(5, "UPosting::find(%p,%u,%b)", s, n, boptmize)
-
-   U_INTERNAL_DUMP("cur_doc_id = %llu", cur_doc_id)
+   uint32_t b, n = 0;
 
-   if (boptmize)
+   for (b = 0; b < c->nblock; ++b)
       {
-      char* str;
+      if (b != c->iblock) u_load_block(c, b);
 
-      do {
-         str = (char*) u_find(s, n, ptr_cur_doc_id, sizeof(cur_doc_id));
+      (void) memcpy(vdoc + n, c->vdoc, c->n * sizeof(uint64_t));
 
-         if (str)
-            {
-            if (checkEntry(str, s, n)) U_RETURN(str);
+      n += c->n;
+      }
 
-            ++str;
+   U_INTERNAL_ASSERT_EQUALS(n, c->ndoc)
 
-            n = (s + n) - str;
-            s =           str;
-            }
-         }
-      while (str);
-      }
-   else
+   return n;
+}
+
+/**
+ * intersection of two sorted vector of DOC id with SIMD (SSE2): every step compare two DOC id of a
+ * with two DOC id of b (all the pairs with a shuffle), then advance the vector with the lower maximum
+ */
+
+static uint32_t u_intersect_block(const uint64_t* a, uint32_t na, const uint64_t* b, uint32_t nb, uint64_t* out)
+{
+   uint32_t i = 0, j = 0, k = 0;
+
+#ifdef __SSE2__
+   while ((i + 2) <= na &&
+          (j + 2) <= nb)
       {
-      char* str = s;
-      char* end = s + n;
+      __m128i va = _mm_loadu_si128((const __m128i*)(a+i)),
+              vb = _mm_loadu_si128((const __m128i*)(b+j)),
+              e1 = _mm_cmpeq_epi32(va, vb),
+              e2 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4E));
 
-      do {
-         if (POSTING64(str,doc_id) == cur_doc_id)
-            {
-            U_INTERNAL_DUMP("offset     = %u",   (str - s))
-            U_INTERNAL_DUMP("doc_id     = %llu", POSTING64(str,doc_id))
-            U_INTERNAL_DUMP("word_freq  = %u",   POSTING32(str,word_freq))
-            U_INTERNAL_DUMP("size_entry = %u",   POSTING_SIZE(str))
+      // 64 bit equality: both the 32 bit half must be equal...
 
-            U_RETURN(str);
-            }
+      e1 = _mm_and_si128(e1, _mm_shuffle_epi32(e1, 0xB1));
+      e2 = _mm_and_si128(e2, _mm_shuffle_epi32(e2, 0xB1));
 
-         str += POSTING_SIZE(str);
-         }
-      while (str < end);
+      int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(e1, e2)));
 
-      U_INTERNAL_ASSERT_EQUALS((str - s), (ptrdiff_t)n)
+      uint64_t amax = a[i+1], bmax = b[j+1];
+
+      if (mask & 1) out[k++] = a[i];
+      if (mask & 2) out[k++] = amax;
+
+      if (amax <= bmax) i += 2;
+      if (bmax <= amax) j += 2;
       }
+#endif
 
-   U_RETURN((char*)U_NULLPTR);
+   while (i < na &&
+          j < nb)
+      {
+      if      (a[i] < b[j]) ++i;
+      else if (a[i] > b[j]) ++j;
+      else
+         {
+         out[k++] = a[i++];
+
+         ++j;
+         }
+      }
+
+   return k;
 }
 
-U_NO_EXPORT bool UPosting::setPosting(bool bcache)
+static uint32_t u_intersect(uint64_t* vdoc, uint32_t n, u_posting_cursor* c) // NB: the result overwrite vdoc...
 {
-   U_TRACE(5, "UPosting::setPosting(%b)", bcache)
+   uint32_t i = 0, j, k = 0;
 
-   U_INTERNAL_ASSERT_POINTER(ptr_cur_doc_id)
-
-   if (bcache)
+   while (i < n &&
+          u_seek_block(c, vdoc[i]))
       {
-      static char* last_posting_ptr;
-      static uint32_t last_posting_sz;
-      static UStringRep* last_word_rep;
+      uint64_t last = c->vdoc[c->n-1];
 
-      if (word->rep != last_word_rep)
+      for (j = i + 1; j < n && vdoc[j] <= last; ++j) {}
+
+      if ((j - i) >= 8) // dense: SIMD intersection with the block...
          {
-         readPosting(last_word_rep = word->rep, false);
+         k += u_intersect_block(vdoc+i, j-i, c->vdoc + c->idoc, c->n - c->idoc, vdoc+k);
 
-         if (posting->empty()) last_posting_sz  = 0;
-         else
+         c->idoc = c->n - 1;
+         }
+      else // sparse: galloping in the block...
+         {
+         for (; i < j; ++i)
             {
-            last_posting_sz  = posting->size() - sizeof(uint32_t); // offset last DOC id
-            last_posting_ptr = posting->data() + sizeof(uint32_t);
+            c->idoc = u_lower_bound(c->vdoc, c->idoc, c->n, vdoc[i]);
+
+            if (c->vdoc[c->idoc] == vdoc[i]) vdoc[k++] = vdoc[i];
             }
          }
 
-      char* posting_ptr = (last_posting_sz ? find(last_posting_ptr, last_posting_sz, true) : U_NULLPTR);
-
-      if (posting_ptr) U_RETURN(true);
-
-      U_RETURN(false);
+      i = j;
       }
 
-   U_INTERNAL_ASSERT(*posting)
-
-// if (posting->empty()) U_RETURN(false);
-
-   ptr = find(posting->data() + sizeof(uint32_t), posting->size() - sizeof(uint32_t), false);
+   return k;
+}
 
-   U_INTERNAL_DUMP("ptr = %p", ptr)
+static uint32_t u_difference(uint64_t* vdoc, uint32_t n, u_posting_cursor* c) // NB: the result overwrite vdoc...
+{
+   uint32_t i, k = 0;
 
-   if (ptr) U_RETURN(true);
+   for (i = 0; i < n; ++i)
+      {
+      if (u_seek(c, vdoc[i]) == false) vdoc[k++] = vdoc[i];
+      }
 
-   U_RETURN(false);
+   return k;
 }
 
-U_NO_EXPORT bool UPosting::findCurrentDocIdOnPosting(UStringRep* value)
+static bool u_find_doc_id(const char* s, const UString& vdoc) // if the posting (block format) contains one of the DOC id (sorted vector)...
 {
-   U_TRACE(5, "UPosting::findCurrentDocIdOnPosting(%.*S)", U_STRING_TO_TRACE(*value))
-
-   posting->_assign(value);
-
-#ifdef U_COMPRESS_ENTRY
-   (void)decompress();
-#endif
+   u_posting_cursor c;
 
-   ptr = (char*) u_find(U_STRING_TO_PARAM(*posting), ptr_cur_doc_id, sizeof(cur_doc_id));
+   u_open_cursor(&c, s);
 
-   // check for collision...
+   const uint64_t* v = (const uint64_t*)vdoc.data();
 
-   if (ptr &&
-       checkEntry(ptr, U_STRING_TO_PARAM(*posting)))
+   for (uint32_t i = 0, n = vdoc.size() / sizeof(uint64_t); i < n; ++i)
       {
-      U_RETURN(true);
+      if (u_seek(&c, v[i])) return true;
       }
 
-   U_RETURN(false);
+   return false;
 }
 
-// DELETE WORD
-
-inline bool UPosting::isOneEntry()
-{
-   U_TRACE(5, "UPosting::isOneEntry()")
+/**
+ * RANKING: BM25 with the number of words of the document (tbl_stats) and the top-k best results with Block-Max WAND
+ *
+ * score(D,Q) = sum(idf(q) * (f(q,D) * (k1 + 1)) / (f(q,D) + k1 * (1 - b + b * |D| / avgdl)))
+ *
+ * idf(q) = log(1 + (N - n(q) + 0.5) / (n(q) + 0.5))
+ *
+ * the upper bound of a term (or of a block of the posting) is the score with the max frequency for a document of length 0...
+ */
+
+#define U_BM25_K1 1.2
+#define U_BM25_B  0.75
+
+#define U_POSTING_WEIGHT(score) (uint32_t)(((score) * 1000.0) + 0.5) // NB: the weight of the result (WeightWord) is the score x 1000...
+
+typedef struct u_posting_hit {
+   double score;
+   uint64_t doc_id;
+} u_posting_hit;
+
+typedef struct u_posting_term {
+   u_posting_cursor c;
+   double idf, ub; // ub: upper bound of the score of the term
+   uint64_t doc;   // current DOC id
+   bool end;
+} u_posting_term;
+
+static UString* vhit; // NB: min heap of the best top-k results (all the results if top-k is 0)...
+static uint32_t nhit;
+static double bm25_ndoc, bm25_avgdl, bm25_score;
+static bool bm25_doc_length;
+
+static const char u_stats_total[sizeof(uint64_t)] = { 0 }; // NB: key of the total number of words of the documents (the DocID is never 0)...
+
+static inline __pure double u_bm25(double idf, uint32_t freq, uint32_t doc_length)
+{
+   double norm = U_BM25_K1 * (1.0 - U_BM25_B + (doc_length ? U_BM25_B * doc_length / bm25_avgdl : U_BM25_B));
+
+   return idf * (freq * (U_BM25_K1 + 1.0)) / (freq + norm);
+}
+
+static inline double u_bm25_max(double idf, uint32_t freq) // upper bound
+{
+   return idf * (freq * (U_BM25_K1 + 1.0)) / (freq + (U_BM25_K1 * (1.0 - U_BM25_B)));
+}
+
+static inline __pure double u_idf(uint32_t ndoc)
+{
+   return log(1.0 + (bm25_ndoc - ndoc + 0.5) / (ndoc + 0.5));
+}
+
+static uint32_t u_get_doc_length(uint64_t doc_id)
+{
+   if (bm25_doc_length)
+      {
+      UPosting::str_cur_doc_id->setFromInode(&doc_id);
+
+      UString value;
+
+      if (cdb_delta_stats) value = (*cdb_delta_stats)[UPosting::str_cur_doc_id->rep];
+
+      if (value.empty()) value = (*cdb_stats)[UPosting::str_cur_doc_id->rep];
+
+      if (value.size() == sizeof(uint32_t)) return u_get_unalignedp32(value.data());
+      }
+
+   return 0; // NB: unknown, as the average...
+}
+
+static inline __pure uint32_t u_get_freq(u_posting_cursor* c) // frequency of the current DOC id
+{
+   return (c->base ? c->vfreq[c->idoc] : 1);
+}
+
+static uint32_t u_get_max_freq(u_posting_cursor* c)
+{
+   if (c->skip == U_NULLPTR) return c->max_freq;
+
+   uint32_t b, freq = 0;
+
+   for (b = 0; b < c->nblock; ++b) freq = U_max(freq, U_SKIP_MAX_FREQ(c, b));
+
+   return freq;
+}
+
+static inline double u_get_threshold(uint32_t k) // the min score of the best results
+{
+   return (k && nhit == k ? ((u_posting_hit*)vhit->data())[0].score : 0.0);
+}
+
+static void u_push_hit(uint32_t k, uint64_t doc_id, double score)
+{
+   uint32_t i, child;
+   u_posting_hit* h;
+
+   if (k == 0)
+      {
+      if ((vhit->capacity() - vhit->size()) < sizeof(u_posting_hit)) (void) vhit->reserve(vhit->size() + sizeof(u_posting_hit)); // NB: double the space...
+
+      h = (u_posting_hit*)vhit->data();
+
+      h[nhit].score  = score;
+      h[nhit].doc_id = doc_id;
+
+      vhit->size_adjust(++nhit * sizeof(u_posting_hit));
+
+      return;
+      }
+
+   h = (u_posting_hit*)vhit->data();
+
+   if (nhit < k) // sift up...
+      {
+      for (i = nhit++; i > 0 && h[(i-1)/2].score > score; i = (i-1)/2) h[i] = h[(i-1)/2];
+      }
+   else
+      {
+      if (score <= h[0].score) return;
+
+      // replace the min and sift down...
+
+      for (i = 0; (child = 2*i+1) < nhit; i = child)
+         {
+         if ((child+1) < nhit && h[child+1].score < h[child].score) ++child;
+
+         if (h[child].score >= score) break;
+
+         h[i] = h[child];
+         }
+      }
+
+   h[i].score  = score;
+   h[i].doc_id = doc_id;
+
+   vhit->size_adjust(nhit * sizeof(u_posting_hit));
+}
+
+static int u_compare_hit(const void* h1, const void* h2) // score desc, DOC id
+{
+   const u_posting_hit* a = (const u_posting_hit*)h1;
+   const u_posting_hit* b = (const u_posting_hit*)h2;
+
+   if (a->score != b->score) return (a->score > b->score ? -1 : 1);
+
+   return (a->doc_id < b->doc_id ? -1 : a->doc_id > b->doc_id);
+}
+
+static inline void u_term_set(u_posting_term* t)
+{
+   t->end = (t->c.idoc >= t->c.n);
+
+   if (t->end == false) t->doc = t->c.vdoc[t->c.idoc];
+}
+
+static inline void u_term_next(u_posting_term* t)
+{
+   if (++t->c.idoc == t->c.n &&
+       (t->c.iblock + 1) < t->c.nblock)
+      {
+      u_load_block(&(t->c), t->c.iblock + 1);
+      }
+
+   u_term_set(t);
+}
+
+static inline void u_term_seek(u_posting_term* t, uint64_t x)
+{
+   (void) u_seek(&(t->c), x);
+
+   u_term_set(t);
+}
+
+static inline bool u_term_less(const u_posting_term* t1, const u_posting_term* t2)
+{
+   if (t1->end) return false;
+   if (t2->end) return true;
+
+   return (t1->doc < t2->doc);
+}
+
+static double u_term_block_max(u_posting_term* t, uint64_t x, uint64_t* last) // upper bound of the block with DOC id x (without decode it)
+{
+   u_posting_cursor* c = &(t->c);
+
+   uint32_t b = u_find_block(c, x);
+
+   if (b == c->nblock)
+      {
+      *last = ~0ULL;
+
+      return 0.0;
+      }
+
+   if (b == c->iblock)
+      {
+      *last = c->vdoc[c->n-1];
+
+      return u_bm25_max(t->idf, c->max_freq);
+      }
+
+   *last = U_SKIP_LAST(c, b);
+
+   return u_bm25_max(t->idf, U_SKIP_MAX_FREQ(c, b));
+}
+
+UPosting::UPosting(uint32_t dimension, bool parsing, bool index)
+{
+   U_TRACE_CTOR(5, UPosting, "%u,%b,%b", dimension, parsing, index)
+
+   U_INTERNAL_ASSERT_EQUALS(word, U_NULLPTR)
+   U_INTERNAL_ASSERT_EQUALS(posting, U_NULLPTR)
+   U_INTERNAL_ASSERT_EQUALS(filename, U_NULLPTR)
+   U_INTERNAL_ASSERT_EQUALS(str_cur_doc_id, U_NULLPTR)
+
+   U_NEW_STRING(word, UString);
+   U_NEW_STRING(posting, UString);
+   U_NEW_STRING(filename, UString);
+   U_NEW_STRING(str_cur_doc_id, UString(sizeof(cur_doc_id)));
+
+   approximate_num_words = 2000 + (dimension * 8);
+
+   if (index) setIndex(dimension);
+
+   if (parsing)
+      {
+      U_INTERNAL_ASSERT_EQUALS(file, U_NULLPTR)
+      U_INTERNAL_ASSERT_EQUALS(content, U_NULLPTR)
+
+      U_NEW(UFile, file, UFile);
+      U_NEW_STRING(content, UString);
+      }
+}
+
+void UPosting::setIndex(uint32_t dimension)
+{
+   U_TRACE(5, "UPosting::setIndex(%u)", dimension)
+
+   U_INTERNAL_ASSERT_EQUALS(tbl_name, U_NULLPTR)
+   U_INTERNAL_ASSERT_EQUALS(tbl_words, U_NULLPTR)
+
+   dimension += dimension / 4;
+
+   U_NEW(UHashMap<UString>, tbl_name,  UHashMap<UString>(u_nextPowerOfTwo(dimension)));
+   U_NEW(UHashMap<UString>, tbl_stats, UHashMap<UString>(u_nextPowerOfTwo(dimension)));
+   U_NEW(UHashMap<UString>, tbl_words, UHashMap<UString>(u_nextPowerOfTwo(approximate_num_words), ignore_case));
+}
+
+void UPosting::resetVectorCompositeWord()
+{
+   U_TRACE(5, "UPosting::resetVectorCompositeWord()")
+
+   U_DELETE(sub_word)
+   U_DELETE(vec_sub_word)
+   U_DELETE(vec_sub_word_posting)
+
+   sub_word             = U_NULLPTR;
+   vec_sub_word         = U_NULLPTR;
+   vec_sub_word_posting = U_NULLPTR;
+   vec_sub_word_size    = 0;
+}
+
+void UPosting::reset()
+{
+   U_TRACE(5, "UPosting::reset()")
+
+   max_distance      = 2;
+   sub_word_pos_prev = 0;
+
+   if (vec_sub_word) resetVectorCompositeWord();
+
+   if (vdoc_id)
+      {
+      U_DELETE(vdoc_id)
+
+      vdoc_id = U_NULLPTR;
+      }
+
+   if (vhit)
+      {
+      U_DELETE(vhit)
+
+      vhit = U_NULLPTR;
+      }
+
+   if (vec_word)
+      {
+      U_DELETE(vec_word)
+      U_DELETE(vec_entry)
+      U_DELETE(vec_posting)
+
+      vec_word    = U_NULLPTR;
+      vec_entry   = U_NULLPTR;
+      vec_posting = U_NULLPTR;
+      }
+}
+
+UPosting::~UPosting()
+{
+   U_TRACE_DTOR(5, UPosting)
+
+   U_DELETE(posting)
+   U_DELETE(filename)
+   U_DELETE(str_cur_doc_id)
+
+   if (tbl_name == U_NULLPTR) reset();
+   else
+      {
+      U_DELETE(tbl_name)
+      U_DELETE(tbl_stats)
+      U_DELETE(tbl_words)
+      }
+
+   U_DELETE(word)
+
+   if (vdelta)
+      {
+      U_DELETE(vdelta)
+
+      vdelta = U_NULLPTR;
+      }
+
+   if (file)
+      {
+      U_DELETE(file)
+      U_DELETE(content)
+      }
+}
+
+// #define U_OPTIMIZE
+// #define U_COMPRESS_ENTRY
+
+// MANAGE POSTING VALUE ON DATABASE
+
+inline bool UPosting::isBlock()
+{
+   U_TRACE_NO_PARAM(5, "UPosting::isBlock()")
+
+   if (posting->size() > sizeof(uint32_t) &&
+       (u_get_unalignedp32(posting->data()) & U_POSTING_FLAG) != 0)
+      {
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+inline bool UPosting::decompress()
+{
+   U_TRACE(5, "UPosting::decompress()")
+
+   bool result = false;
+
+#ifdef U_COMPRESS_ENTRY
+   if (posting->size() > (sizeof(uint32_t) * 4) &&
+       UStringExt::isCompress(*posting))
+      {
+      posting->decompress();
+
+      result = true;
+      }
+#endif
+
+   if (isBlock())
+      {
+      decode();
+
+      result = true;
+      }
+
+   U_RETURN(result);
+}
+
+void UPosting::assignPosting(UStringRep* value, UStringRep* word_rep)
+{
+   U_TRACE(5, "UPosting::assignPosting(%p,%V)", value, word_rep)
+
+   posting->_assign(value);
+
+   if (word_rep) applyDelta(word_rep);
+
+   (void) decompress();
+}
+
+// ENCODE/DECODE POSTING (format in memory <=> block format on database)
+
+U_NO_EXPORT void UPosting::encode()
+{
+   U_TRACE_NO_PARAM(5, "UPosting::encode()")
+
+   U_INTERNAL_ASSERT(*posting)
+   U_INTERNAL_ASSERT_EQUALS(isBlock(), false)
+
+   char* p;
+   uint32_t i, k, b, freq, prev, n = 0, nfreq = 0;
+   char* start = posting->data() + sizeof(uint32_t);
+   char* end   = (char*) posting->pend();
+
+   for (p = start; p < end; p += POSTING_SIZE(p))
+      {
+      ++n;
+
+      nfreq += POSTING32(p,word_freq);
+      }
+
+   u_posting_entry* ventry = (u_posting_entry*) UMemoryPool::cmalloc(n, sizeof(u_posting_entry));
+
+   bool bsort = false;
+
+   for (i = 0, p = start; p < end; ++i, p += POSTING_SIZE(p))
+      {
+      ventry[i].ptr    = p;
+      ventry[i].doc_id = POSTING64(p,doc_id);
+
+      if (i &&
+          ventry[i].doc_id < ventry[i-1].doc_id)
+         {
+         bsort = true;
+         }
+      }
+
+   U_INTERNAL_ASSERT_EQUALS(i, n)
+
+   if (bsort) qsort(ventry, n, sizeof(u_posting_entry), u_compare_entry);
+
+   uint32_t nblock = (n + U_POSTING_BLOCK - 1) / U_POSTING_BLOCK,
+            sz_skip = (nblock > 1 ? nblock * U_POSTING_SKIP_ENTRY : 0);
+
+   UString s(sizeof(uint32_t) + sz_skip + (n * 15) + (nfreq * 5));
+
+   char* out  = s.data();
+   char* skip = out + sizeof(uint32_t);
+   char* base = skip + sz_skip;
+   char* q    = base;
+
+   u_put_unalignedp32(out, U_POSTING_FLAG | n);
+
+   for (b = 0; b < nblock; ++b)
+      {
+      uint32_t first = b * U_POSTING_BLOCK,
+               last  = U_min(n, first + U_POSTING_BLOCK);
+
+      if (sz_skip)
+         {
+         for (i = first, freq = 0; i < last; ++i) freq = U_max(freq, POSTING32(ventry[i].ptr,word_freq));
+
+         u_put_unalignedp64(skip + (b * U_POSTING_SKIP_ENTRY),                                       ventry[last-1].doc_id);
+         u_put_unalignedp32(skip + (b * U_POSTING_SKIP_ENTRY) + sizeof(uint64_t),                    q - base);
+         u_put_unalignedp32(skip + (b * U_POSTING_SKIP_ENTRY) + sizeof(uint64_t) + sizeof(uint32_t), freq);
+         }
+
+      q = u_put_varint(q, (b ? ventry[first].doc_id - ventry[first-1].doc_id : ~ventry[first].doc_id));
+
+      for (i = first+1; i < last; ++i) q = u_put_varint(q, ventry[i].doc_id - ventry[i-1].doc_id);
+      for (i = first;   i < last; ++i) q = u_put_varint(q, POSTING32(ventry[i].ptr,word_freq));
+
+      for (i = first; i < last; ++i)
+         {
+         uint32_t* vpos = (uint32_t*)(ventry[i].ptr+sizeof(u_posting));
+
+         for (k = 0, prev = 0, freq = POSTING32(ventry[i].ptr,word_freq); k < freq; ++k)
+            {
+            q = u_put_varint(q, (uint32_t)(u_get_unalignedp32(vpos+k) - prev)); // NB: modular delta, the positions are normally ascending...
+
+            prev = u_get_unalignedp32(vpos+k);
+            }
+         }
+      }
+
+   UMemoryPool::_free(ventry, n, sizeof(u_posting_entry));
+
+   s.size_adjust(q - out);
+
+   U_INTERNAL_DUMP("n = %u nblock = %u size = %u => %u", n, nblock, posting->size(), s.size())
+
+   *posting = s;
+}
+
+U_NO_EXPORT void UPosting::decode()
+{
+   U_TRACE_NO_PARAM(5, "UPosting::decode()")
+
+   U_INTERNAL_ASSERT(isBlock())
+
+   u_posting_cursor c;
+   uint32_t i, k, b, freq, prev, last = 0, nfreq = 0;
+
+   u_open_cursor(&c, posting->data());
+
+   for (b = 0; b < c.nblock; ++b)
+      {
+      if (b) u_load_block(&c, b);
+
+      for (i = 0; i < c.n; ++i) nfreq += c.vfreq[i];
+      }
+
+   UString s(sizeof(uint32_t) + (c.ndoc * sizeof(u_posting)) + (nfreq * sizeof(uint32_t)));
+
+   char* start = s.data();
+   char* q     = start + sizeof(uint32_t);
+
+   for (b = 0; b < c.nblock; ++b)
+      {
+      u_load_block(&c, b);
+
+      const char* p = c.start_pos;
+
+      for (i = 0; i < c.n; ++i)
+         {
+         freq = c.vfreq[i];
+
+         u_put_unalignedp64(&(((u_posting*)(q))->doc_id),    c.vdoc[i]);
+         u_put_unalignedp32(&(((u_posting*)(q))->word_freq), freq);
+
+         for (k = 0, prev = 0; k < freq; ++k)
+            {
+            prev += (uint32_t)u_get_varint(p);
+
+            u_put_unalignedp32(q+sizeof(u_posting)+(k*sizeof(uint32_t)), prev);
+            }
+
+         last = q - start;
+
+         q += POSTING_SIZE(q);
+         }
+      }
+
+   u_put_unalignedp32(start, last);
+
+   s.size_adjust(q - start);
+
+   *posting = s;
+}
+
+U_NO_EXPORT int UPosting::encodeEntry(UStringRep* word_rep, UStringRep* value)
+{
+   U_TRACE(5, "UPosting::encodeEntry(%V,%p)", word_rep, value)
+
+   posting->_assign(value);
+
+   tbl_words_space -= value->capacity();
+
+   encode();
+
+   tbl_words_space += posting->size();
+
+   tbl_words->replaceAfterFind(*posting);
+
+   U_RETURN(1);
+}
+
+void UPosting::encodeAllEntry()
+{
+   U_TRACE_NO_PARAM(5, "UPosting::encodeAllEntry()")
+
+   U_INTERNAL_ASSERT_POINTER(tbl_words)
+
+   tbl_words->callForAllEntry((bPFprpv)encodeEntry);
+
+   posting->clear();
+}
+
+U_NO_EXPORT void UPosting::readPosting(UStringRep* word_rep, bool flag)
+{
+   U_TRACE(5, "UPosting::readPosting(%p,%b)", word_rep, flag)
+
+   U_INTERNAL_ASSERT_POINTER(cdb_words)
+
+   *posting = (word_rep ? (flag ? (*((URDB*)cdb_words))[word_rep]
+                                : (*        cdb_words) [word_rep])
+                        : ((URDB*)cdb_words)->UCDB::elem());
+
+   if (decompress() == false)
+      {
+      // check if add operation...
+
+      if (word_rep == U_NULLPTR) posting->duplicate(); // NB: need duplicate string because we need space on string constant..
+      }
+
+   U_INTERNAL_ASSERT_EQUALS(UStringExt::isCompress(posting->data()), false)
+}
+
+inline void UPosting::setBlock()
+{
+   U_TRACE_NO_PARAM(5, "UPosting::setBlock()")
+
+#ifdef U_COMPRESS_ENTRY
+   if (posting->size() > (sizeof(uint32_t) * 4) &&
+       UStringExt::isCompress(*posting))
+      {
+      posting->decompress();
+      }
+#endif
+
+   if (*posting &&
+       isBlock() == false)
+      {
+      encode(); // NB: database created before the block format...
+      }
+}
+
+U_NO_EXPORT void UPosting::readBlock(UStringRep* word_rep)
+{
+   U_TRACE(5, "UPosting::readBlock(%V)", word_rep)
+
+   U_INTERNAL_ASSERT_POINTER(cdb_words)
+
+   *posting = (*cdb_words)[word_rep];
+
+   setBlock();
+
+   applyDelta(word_rep);
+}
+
+U_NO_EXPORT int UPosting::writePosting(int flag)
+{
+   U_TRACE(5, "UPosting::writePosting(%d)", flag)
+
+   U_INTERNAL_ASSERT_POINTER(cdb_words)
+   U_INTERNAL_ASSERT_EQUALS(UStringExt::isCompress(posting->data()), false)
+
+   encode();
+
+#ifdef U_COMPRESS_ENTRY
+   if (posting->size() > U_CAPACITY) posting->compress();
+#endif
+
+   int result = ((URDB*)cdb_words)->store(*word, *posting, flag);
+
+   U_RETURN(result);
+}
+
+// FIND CURRENT DOC ID ON POSTING
+
+inline bool UPosting::checkEntry(char* str, char* s, uint32_t n)
+{
+   U_TRACE(5, "UPosting::checkEntry(%p,%p,%u)", str, n)
+
+   U_INTERNAL_ASSERT_POINTER(s)
+   U_INTERNAL_ASSERT_POINTER(str)
+
+   uint32_t offset = (str - s);
+
+   U_INTERNAL_DUMP("offset     = %u", offset)
+   U_INTERNAL_DUMP("size_entry = %u", POSTING_SIZE(str))
+
+   if ((offset % sizeof(uint32_t)) == 0 &&
+       POSTING_SIZE(str) <= (n - offset))
+      {
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT __pure char* UPosting::find(char* s, uint32_t n, bool boptmize)
+{
+   U_TRACE(5, "UPosting::find(%p,%u,%b)", s, n, boptmize)
+
+   U_INTERNAL_DUMP("cur_doc_id = %llu", cur_doc_id)
+
+   if (boptmize)
+      {
+      char* str;
+
+      do {
+         str = (char*) u_find(s, n, ptr_cur_doc_id, sizeof(cur_doc_id));
+
+         if (str)
+            {
+            if (checkEntry(str, s, n)) U_RETURN(str);
+
+            ++str;
+
+            n = (s + n) - str;
+            s =           str;
+            }
+         }
+      while (str);
+      }
+   else
+      {
+      char* str = s;
+      char* end = s + n;
+
+      do {
+         if (POSTING64(str,doc_id) == cur_doc_id)
+            {
+            U_INTERNAL_DUMP("offset     = %u",   (str - s))
+            U_INTERNAL_DUMP("doc_id     = %llu", POSTING64(str,doc_id))
+            U_INTERNAL_DUMP("word_freq  = %u",   POSTING32(str,word_freq))
+            U_INTERNAL_DUMP("size_entry = %u",   POSTING_SIZE(str))
+
+            U_RETURN(str);
+            }
+
+         str += POSTING_SIZE(str);
+         }
+      while (str < end);
+
+      U_INTERNAL_ASSERT_EQUALS((str - s), (ptrdiff_t)n)
+      }
+
+   U_RETURN((char*)U_NULLPTR);
+}
+
+U_NO_EXPORT bool UPosting::setPosting(bool bcache)
+{
+   U_TRACE(5, "UPosting::setPosting(%b)", bcache)
+
+   U_INTERNAL_ASSERT_POINTER(ptr_cur_doc_id)
+
+   if (bcache)
+      {
+      static char* last_posting_ptr;
+      static uint32_t last_posting_sz;
+      static UStringRep* last_word_rep;
+
+      if (word->rep != last_word_rep)
+         {
+         readPosting(last_word_rep = word->rep, false);
+
+         if (posting->empty()) last_posting_sz  = 0;
+         else
+            {
+            last_posting_sz  = posting->size() - sizeof(uint32_t); // offset last DOC id
+            last_posting_ptr = posting->data() + sizeof(uint32_t);
+            }
+         }
+
+      char* posting_ptr = (last_posting_sz ? find(last_posting_ptr, last_posting_sz, true) : U_NULLPTR);
+
+      if (posting_ptr) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   U_INTERNAL_ASSERT(*posting)
+
+// if (posting->empty()) U_RETURN(false);
+
+   ptr = find(posting->data() + sizeof(uint32_t), posting->size() - sizeof(uint32_t), false);
+
+   U_INTERNAL_DUMP("ptr = %p", ptr)
+
+   if (ptr) U_RETURN(true);
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT bool UPosting::findCurrentDocIdOnPosting(UStringRep* value)
+{
+   U_TRACE(5, "UPosting::findCurrentDocIdOnPosting(%.*S)", U_STRING_TO_TRACE(*value))
+
+   posting->_assign(value);
+
+#ifdef U_COMPRESS_ENTRY
+   (void)decompress();
+#endif
+
+   ptr = (char*) u_find(U_STRING_TO_PARAM(*posting), ptr_cur_doc_id, sizeof(cur_doc_id));
+
+   // check for collision...
+
+   if (ptr &&
+       checkEntry(ptr, U_STRING_TO_PARAM(*posting)))
+      {
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+// DELETE WORD
+
+inline bool UPosting::isOneEntry()
+{
+   U_TRACE(5, "UPosting::isOneEntry()")
+
+   if (posting->size() == (sizeof(uint32_t) + POSTING_SIZE(ptr))) U_RETURN(true);
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT void UPosting::del()
+{
+   U_TRACE(5, "UPosting::del()")
+
+   U_INTERNAL_ASSERT(*word)
+   U_INTERNAL_ASSERT(*posting)
+   U_INTERNAL_ASSERT_POINTER(ptr)
+
+   data = posting->data();
+
+   U_INTERNAL_DUMP("word_freq       = %u",   POSTING32(ptr,word_freq))
+   U_INTERNAL_DUMP("size_entry      = %u",   POSTING_SIZE(ptr))
+   U_INTERNAL_DUMP("cur_doc_id      = %llu", cur_doc_id)
+   U_INTERNAL_DUMP("posting->size() = %u",   posting->size())
+   U_INTERNAL_DUMP("off_last_doc_id = %u",   POSTING_OFFSET_LAST_DOC_ID)
+
+   U_INTERNAL_ASSERT_MAJOR(POSTING32(ptr,word_freq), 0)
+
+   // check if other reference...
+
+   int result;
+
+   if (isOneEntry())
+      {
+      result = ((URDB*)cdb_words)->remove(*word);
+
+      if (result != 0)
+         {
+         U_ERROR("del(): error<%d> on operation remove word<%.*s> from index database", result, U_STRING_TO_TRACE(*word));
+         }
+
+      return;
+      }
+
+#if defined(DEBUG) || defined(U_TEST)
+   uint32_t last_offset = POSTING_OFFSET_LAST_DOC_ID;
+#endif
+
+   char* end = (char*) posting->pend();
+
+   do {
+      U_INTERNAL_DUMP("doc_id          = %lu", POSTING64(ptr,doc_id))
+
+      size_entry = POSTING_SIZE(ptr);
+
+      if (POSTING64(ptr,doc_id) == cur_doc_id) break;
+
+      ptr += size_entry;
+      }
+   while (ptr < end);
+
+   if (ptr >= end) U_ERROR("del(): cannot find DocID<%llu> reference for word<%.*s> on index database", cur_doc_id, U_STRING_TO_TRACE(*word));
+
+   (void) posting->replace(ptr - data, size_entry, 0, '\0');
+
+   // reassign value
+
+   data = posting->data();
+   ptr  = data + sizeof(uint32_t);
+   end  = (char*) posting->pend();
+
+   U_INTERNAL_DUMP("posting->size() = %u", posting->size())
+
+   U_INTERNAL_ASSERT_EQUALS(POSTING_OFFSET_LAST_DOC_ID, last_offset)
+
+   do {
+      size_entry = POSTING_SIZE(ptr);
+
+      ptr += size_entry;
+      }
+   while (ptr < end);
+
+   U_INTERNAL_ASSERT_EQUALS(ptr - data, (ptrdiff_t)posting->size())
+
+   u_put_unalignedp32(data, (ptr - data) - size_entry);
+
+   U_INTERNAL_DUMP("off_last_doc_id = %u", POSTING_OFFSET_LAST_DOC_ID)
+
+   U_INTERNAL_ASSERT_MINOR(POSTING_OFFSET_LAST_DOC_ID, last_offset)
+
+   result = writePosting(RDB_REPLACE);
+
+   if (result != 0) U_ERROR("del(): error<%d> on operation replace reference for word<%.*s> on index database", result, U_STRING_TO_TRACE(*word));
+}
+
+// ADD WORD
+
+inline void UPosting::init()
+{
+   U_TRACE(5, "UPosting::init()")
+
+   u_put_unalignedp64(&(((u_posting*)(ptr))->doc_id), cur_doc_id);
+   u_put_unalignedp32(&(((u_posting*)(ptr))->word_freq), 0);
+}
+
+inline void UPosting::checkCapacity()
+{
+   U_TRACE(5, "UPosting::checkCapacity()")
+
+   space = off_last_doc_id + size_entry + sizeof(off_last_doc_id);
+
+   U_INTERNAL_DUMP("space = %u", space)
+
+   if (space >= posting->capacity())
+      {
+      if (tbl_words) tbl_words_space -= posting->capacity();
+
+   // if (posting->uniq() == false) posting->duplicate();
+
+      posting->reserve(space * 2);
+
+      if (tbl_words)
+         {
+         tbl_words_space += posting->capacity();
+
+         tbl_words->replaceAfterFind(*posting);
+         }
+      }
+
+   data = posting->data();
+   ptr  = data + off_last_doc_id;
+}
+
+U_NO_EXPORT void UPosting::add()
+{
+   U_TRACE(5, "UPosting::add()")
+
+   U_INTERNAL_ASSERT(*word)
+
+   bool present = (tbl_words ?         tbl_words->find(*word)
+                             : ((URDB*)cdb_words)->find(*word));
+
+   if (present == false)
+      {
+      // first document for this word...
+
+      *posting = UString(U_CAPACITY);
+      data     = posting->data();
+      ptr      = data + sizeof(off_last_doc_id);
+
+      // setting off_last_doc_id for first document...
+
+      size_entry      = sizeof(u_posting);
+      off_last_doc_id = sizeof(off_last_doc_id);
+
+      u_put_unalignedp32(data, sizeof(off_last_doc_id));
+
+      init();
+
+      if (tbl_words)
+         {
+         tbl_words_space += word->size() + posting->capacity();
+
+         word->duplicate(); // NB: need duplicate string because depends on mmap()'s content of document...
+
+         UHashMap<void*>::lkey = word->rep;
+
+         tbl_words->insertAfterFind(*posting);
+         }
+      }
+   else
+      {
+      if (tbl_words) posting->_assign(tbl_words->elem());
+      else           readPosting(U_NULLPTR, false);
+
+   // U_ASSERT_EQUALS(0,find(posting->data() + sizeof(uint32_t), posting->size() - sizeof(uint32_t)))
+
+      data            = posting->data();
+      off_last_doc_id = POSTING_OFFSET_LAST_DOC_ID;
+      ptr             = data + off_last_doc_id;
+      size_entry      = POSTING_SIZE(ptr);
+
+      U_INTERNAL_DUMP("word_freq       = %u", POSTING32(ptr,word_freq))
+      U_INTERNAL_DUMP("size_entry      = %u", size_entry)
+      U_INTERNAL_DUMP("off_last_doc_id = %u", off_last_doc_id)
+
+      U_INTERNAL_ASSERT_MAJOR(POSTING32(ptr,word_freq), 0)
+
+      U_ASSERT((off_last_doc_id + size_entry) <= posting->capacity())
+
+      // NB: the posting read from database is sorted by DocID, so the current document can be not the last...
+
+      if (tbl_words == U_NULLPTR &&
+          POSTING64(ptr,doc_id) != cur_doc_id)
+         {
+         char* p = find(data + sizeof(uint32_t), posting->size() - sizeof(uint32_t), false);
+
+         if (p)
+            {
+            size_entry = POSTING_SIZE(p);
+
+            UString entry((void*)p, size_entry);
+
+            (void) posting->replace(p - data, size_entry, 0, '\0');
+            (void) posting->append(entry);
+
+            data            = posting->data();
+            off_last_doc_id = posting->size() - size_entry;
+            ptr             = data + off_last_doc_id;
+
+            u_put_unalignedp32(data, off_last_doc_id);
+            }
+         }
+
+      // check for new document...
+
+      if (POSTING64(ptr,doc_id) != cur_doc_id)
+         {
+         off_last_doc_id += size_entry;
+               size_entry = sizeof(u_posting);
+
+         u_put_unalignedp32(data, off_last_doc_id);
+
+         // check string capacity...
+
+         checkCapacity();
+
+         init();
+         }
+      }
+
+   U_INTERNAL_ASSERT_EQUALS(cur_doc_id,      POSTING64(ptr,doc_id))
+   U_INTERNAL_ASSERT_EQUALS(off_last_doc_id, POSTING_OFFSET_LAST_DOC_ID)
+
+   // check string capacity...
+
+   checkCapacity();
+
+   U_INTERNAL_ASSERT_EQUALS(cur_doc_id,      POSTING64(ptr,doc_id))
+   U_INTERNAL_ASSERT_EQUALS(off_last_doc_id, POSTING_OFFSET_LAST_DOC_ID)
+
+   // save position of word in document...
+
+   word_freq = POSTING32(ptr,word_freq);
+
+   u_put_unalignedp32(ptr+sizeof(u_posting)+(word_freq*sizeof(uint32_t)), pos);
+
+   u_put_unalignedp32(&(((u_posting*)(ptr))->word_freq), word_freq+1);
+
+   U_INTERNAL_DUMP("pos       = %u", pos)
+   U_INTERNAL_DUMP("pos[0]    = %u", POSTING_POS(0))
+   U_INTERNAL_DUMP("pos[1]    = %u", POSTING_POS(1))
+   U_INTERNAL_DUMP("word_freq = %u", POSTING32(ptr,word_freq))
+
+   posting->size_adjust_force(space);
+
+   if (tbl_words == U_NULLPTR)
+      {
+      int result = writePosting(present ? RDB_REPLACE : RDB_INSERT);
+
+      if (result != 0)
+         {
+         U_ERROR("add(): error<%d> on operation store reference for word<%.*s> on index database", result, U_STRING_TO_TRACE(*word));
+         }
+      }
+}
+
+// CHECK POSTING AND WORD
+
+U_NO_EXPORT void UPosting::checkPosting()
+{
+   U_TRACE(5, "UPosting::checkPosting()")
+
+   U_INTERNAL_ASSERT_POINTER(ptr)
+
+   U_INTERNAL_DUMP("cur_doc_id      = %llu", cur_doc_id)
+
+   U_INTERNAL_ASSERT_EQUALS(cur_doc_id, POSTING64(ptr,doc_id))
+
+   word_freq = POSTING32(ptr,word_freq);
+
+   U_INTERNAL_DUMP("word_freq       = %u", word_freq)
+   U_INTERNAL_DUMP("size_entry      = %u", POSTING_SIZE(ptr))
+   U_INTERNAL_DUMP("offset          = %u", posting->distance(ptr))
+   U_INTERNAL_DUMP("posting->size() = %u", posting->size())
+
+#if defined(U_OPTIMIZE) && defined(DEBUG)
+   if (cdb_words->ignoreCase() == false)
+      {
+      U_INTERNAL_ASSERT_DIFFERS(u_find(content->data(), content->size(), word->data(), word->size()),0)
+      }
+#endif
+
+   uint32_t end = content->size(),
+             sz =    word->size();
+
+   uint32_t* vpos = (uint32_t*)(ptr+sizeof(u_posting));
+
+   char* ptr_word = word->data();
+   char* ptr_data = content->data();
+
+   for (uint32_t i = 0; i < word_freq; ++i)
+      {
+      uint32_t start = u_get_unalignedp32(vpos+i);
+
+      U_INTERNAL_DUMP("start           = %u", start)
+
+      if (start >= end ||
+          u_equal(ptr_word, ptr_data+start, sz, cdb_words->ignoreCase()))
+         {
+         U_ERROR("checkPosting(): word<%v> reference at position<%u> for DocID<%llu %v> lost", word->rep, start, cur_doc_id, filename->rep);
+         }
+      }
+}
+
+// PROCESS WORD
+
+void UPosting::processWord(int32_t op)
+{
+   U_TRACE(5, "UPosting::processWord(%d)", op)
+
+   U_INTERNAL_ASSERT_POINTER(content)
+
+   if (word->size() < min_word_size) return;
+
+   pos = pos_start + (word->data() - content->data());
+
+   U_INTERNAL_DUMP("word = %V pos = %u", word->rep, pos)
+
+   if (op == 0 ||
+       op == 1)
+      {
+      ++doc_length;
+
+      add(); // add/sub
+      }
+   else
+      {
+      readPosting(word->rep, (op == 2)); // del
+
+      if (posting->empty() ||
+          setPosting(false) == false)
+         {
+         U_ERROR("processWord(%d): word<%v> reference at position<%u> for DocID<%llu %v> lost", op, word->rep, pos, cur_doc_id, filename->rep);
+         }
+
+      if      (op == 2) del();          // del
+      else if (op == 3) checkPosting(); // check
+      }
+}
+
+// CHECK DOCUMENT
+
+U_NO_EXPORT int UPosting::checkDocument(UStringRep* word_rep, UStringRep* value)
+{
+   U_TRACE(5, "UPosting::checkDocument(%.*S,%p)", U_STRING_TO_TRACE(*word_rep), value)
+
+   U_INTERNAL_ASSERT(*content)
+
+   if (findCurrentDocIdOnPosting(value))
+      {
+      word->_assign(word_rep);
+
+      U_INTERNAL_DUMP("cdb_words->ignoreCase() = %b", cdb_words->ignoreCase())
+
+#  ifndef U_OPTIMIZE
+      if (cdb_words->ignoreCase() == false &&
+          u_find(content->data(), content->size(), word->data(), word->size()) == U_NULLPTR)
+         {
+         U_RETURN(1);
+         }
+#  endif
+
+      checkPosting();
+      }
+
+   U_RETURN(1);
+}
+
+U_NO_EXPORT int UPosting::checkAllEntry(UStringRep* word_rep, UStringRep* value)
+{
+   U_TRACE(5, "UPosting::checkAllEntry(%.*S,%p)", U_STRING_TO_TRACE(*word_rep), value)
+
+   word->_assign(word_rep);
+
+   assignPosting(value);
+
+   callForPostingAndSetFilename(U_NULLPTR);
+
+   (void) write(1, U_CONSTANT_TO_PARAM(".")); // CHECK_2
+
+   U_RETURN(1);
+}
+
+void UPosting::checkAllEntry()
+{
+   U_TRACE(5, "UPosting::checkAllEntry()")
+
+   cdb_words->callForAllEntryWithPattern(checkAllEntry, U_NULLPTR);
+}
+
+// SUBSTITUTE DOCUMENT
+
+U_NO_EXPORT int UPosting::substitute(UStringRep* word_rep, UStringRep* value)
+{
+   U_TRACE(5, "UPosting::substitute(%.*S,%p)", U_STRING_TO_TRACE(*word_rep), value)
+
+   posting->_assign(value);
+
+#ifdef U_COMPRESS_ENTRY
+   (void) decompress();
+#endif
+
+   word->_assign(word_rep);
+
+   if (setPosting(false)) del();
+
+   U_RETURN(1);
+}
+
+// PROCESS DOCUMENT
+
+inline void UPosting::setDocID(bool from_inode)
+{
+   U_TRACE(5, "UPosting::setDocID(%b)", from_inode)
+
+   if (from_inode) cur_doc_id = - file->inode();
+
+   U_INTERNAL_DUMP("cur_doc_id = %llu", cur_doc_id)
+
+   str_cur_doc_id->setFromInode(&cur_doc_id);
+
+   ptr_cur_doc_id = str_cur_doc_id->data();
+}
+
+void UPosting::setDocID(int32_t op)
+{
+   U_TRACE(5, "UPosting::setDocID(%d)", op)
+
+   U_DUMP("filename = %.*S", U_STRING_TO_TRACE(*filename))
+
+   num_byte += content->size(); // throughput
+
+   if (dir_content_as_doc)
+      {
+      if (op != 0) // add
+         {
+         U_ERROR("setDocID(%d): sorry, not implemented", op);
+         }
+
+      if (change_dir == false) return;
+
+      change_dir = false;
+
+      *filename = UStringExt::dirname(*filename);
+
+      filename->duplicate(); // NB: need duplicate string because depends on volatile buffer of filename...
+
+      U_INTERNAL_DUMP("dirname = %V", filename->rep)
+      }
+
+   // insert/fetch/remove into table of docs name
+
+   setDocID(true);
+
+   ++num_doc;
+
+   doc_length = 0;
+
+   if (tbl_name)
+      {
+      tbl_name->insert(*str_cur_doc_id, *filename);
+
+      tbl_name_space += str_cur_doc_id->size() + filename->size();
+      }
+   else
+      {
+      int result = 0;
+
+      if (op == 0) result = ((URDB*)cdb_names)->store( *str_cur_doc_id, *filename, RDB_INSERT); // add
+      if (op == 2) result = ((URDB*)cdb_names)->remove(*str_cur_doc_id);                        // del
+
+      if (result != 0)
+         {
+         U_ERROR("setDocID(%d): error<%d> for operation<%d> on DocID database", op, result, op);
+         }
+
+      if (op == 1) // sub
+         {
+         if (((URDB*)cdb_names)->find(*str_cur_doc_id) == false)
+            {
+            U_ERROR("setDocID(%d): cannot find DocID<%llu> on names database", op, cur_doc_id);
+            }
+
+         // SUBSTITUTE: we find all reference for this document in the words database and erase it...
+
+         U_INTERNAL_ASSERT_POINTER(cdb_words)
+
+         ((URDB*)cdb_words)->callForAllEntryWithPattern(substitute, U_NULLPTR);
+         }
+      else if (op == 3) // check
+         {
+         // CHECK: we find all reference for this document in the words database and check it...
+
+         U_INTERNAL_ASSERT_POINTER(cdb_words)
+
+         cdb_words->callForAllEntryWithPattern(checkDocument, U_NULLPTR);
+         }
+      }
+}
+
+// PROCESSING MISC (QUERY)
+
+void UPosting::callForPosting(vPF function)
+{
+   U_TRACE(5, "UPosting::callForPosting(%p)", function)
+
+   U_INTERNAL_ASSERT(*posting)
+   U_INTERNAL_ASSERT_POINTER(function)
+
+   data      = posting->data();
+   ptr       = data + sizeof(uint32_t);
+   char* end = (char*) posting->pend();
+
+   do {
+      word_freq  = POSTING32(ptr,word_freq);
+      size_entry = POSTING_SIZE(ptr);
+      cur_doc_id = POSTING64(ptr,doc_id);
+
+      U_INTERNAL_DUMP("word_freq  = %u",   word_freq)
+      U_INTERNAL_DUMP("size_entry = %u",   size_entry)
+      U_INTERNAL_DUMP("cur_doc_id = %llu", cur_doc_id)
+
+      function();
+
+      ptr += size_entry;
+      }
+   while (ptr < end);
+
+   U_INTERNAL_ASSERT_EQUALS(ptr - data, (ptrdiff_t)posting->size())
+}
+
+U_NO_EXPORT void UPosting::setFilename()
+{
+   U_TRACE(5, "UPosting::setFilename()")
+
+   U_INTERNAL_ASSERT(*str_cur_doc_id)
+   U_INTERNAL_ASSERT_POINTER(cdb_names)
+
+   if (cdb_delta_names) *filename = (*cdb_delta_names)[str_cur_doc_id->rep];
+
+   if (cdb_delta_names == U_NULLPTR ||
+       filename->empty())
+      {
+      *filename = (*cdb_names)[str_cur_doc_id->rep];
+      }
+
+   if (filename->empty())
+      {
+      U_ERROR("setFilename(): cannot find document name from DocID<%llu> reference for word<%v> on index database", cur_doc_id, word->rep);
+      }
+}
+
+U_NO_EXPORT void UPosting::callForPostingAndSetFilename()
+{
+   U_TRACE(5, "UPosting::callForPostingAndSetFilename()")
+
+   str_cur_doc_id->setFromInode(&cur_doc_id);
+
+   setFilename();
+
+   if (pfunction) pfunction();
+}
+
+void UPosting::callForPostingAndSetFilename(vPF function)
+{
+   U_TRACE(5, "UPosting::callForPostingAndSetFilename(%p)", function)
+
+   pfunction = function;
+
+   callForPosting(callForPostingAndSetFilename);
+}
+
+U_NO_EXPORT bool UPosting::setVectorCompositeWord()
+{
+   U_TRACE(5, "UPosting::setVectorCompositeWord()")
+
+   U_INTERNAL_ASSERT(*word)
+   U_INTERNAL_ASSERT_POINTER(cdb_words)
+   U_INTERNAL_ASSERT_EQUALS(vec_sub_word,U_NULLPTR)
+   U_INTERNAL_ASSERT_EQUALS(vec_sub_word_posting,U_NULLPTR)
+
+   U_NEW_STRING(sub_word, UString);
+   U_NEW(UVector<UString>, vec_sub_word, UVector<UString>(*word));
+   U_NEW(UVector<UString>, vec_sub_word_posting, UVector<UString>);
+
+   vec_sub_word_size = vec_sub_word->size();
+
+   for (uint32_t i = 0; i < vec_sub_word_size; ++i)
+      {
+      *sub_word = (*vec_sub_word)[i];
+
+      U_INTERNAL_DUMP("sub_word = %V", sub_word->rep)
+
+      if (sub_word->size() < min_word_size)
+         {
+         vec_sub_word_posting->push_back(UString::getStringNull());
+
+         continue;
+         }
+
+      readBlock(sub_word->rep);
+
+      if (posting->empty())
+         {
+         resetVectorCompositeWord();
+
+         U_RETURN(false);
+         }
+
+      vec_sub_word_posting->push_back(*posting);
+      }
+
+   U_RETURN(true);
+}
+
+inline bool UPosting::setSubWord(uint32_t i)
+{
+   U_TRACE(5, "UPosting::setSubWord(%u)", i)
+
+   U_INTERNAL_ASSERT_POINTER(sub_word)
+   U_INTERNAL_ASSERT_POINTER(vec_sub_word)
+
+   *sub_word      = (*vec_sub_word)[i];
+    sub_word_size = sub_word->size();
+
+   U_INTERNAL_DUMP("sub_word = %V", sub_word->rep)
+
+   if (sub_word_size < min_word_size)
+      {
+      sub_word_pos_prev += 1 + sub_word_size;
+
+      U_RETURN(false);
+      }
+
+   U_INTERNAL_DUMP("sub_word_pos_prev = %u", sub_word_pos_prev)
+
+   *posting = (*vec_sub_word_posting)[i];
+
+   U_INTERNAL_ASSERT(*posting)
+
+   U_RETURN(true);
+}
+
+inline UString UPosting::extractDocID(uint32_t n)
+{
+   U_TRACE(5, "UPosting::extractDocID(%u)", n)
+
+   // NB: sorted vector of DocID of all the entry (meta word), the first n entry are of the index, the other of the delta segment...
+
+   u_posting_cursor c;
+   UString s(U_CAPACITY);
+
+   for (uint32_t i = 0, nentry = vec_entry->size(); i < nentry; ++i)
+      {
+      posting->_assign(vec_entry->UVector<UStringRep*>::at(i));
+
+      setBlock();
+
+      u_open_cursor(&c, posting->data());
+
+      (void) s.reserve(c.ndoc * sizeof(uint64_t));
+
+      s.size_adjust(s.size() + (u_get_doc_id(&c, (uint64_t*)s.pend()) * sizeof(uint64_t)));
+
+      if (i == (n-1) &&
+          vdelta)
+         {
+         // NB: the DocID of the delta segment are removed from the entry of the index...
+
+         u_posting_cursor d;
+
+         u_open_cursor(&d, *vdelta);
+
+         s.size_adjust(u_difference((uint64_t*)s.data(), u_sort_doc_id((uint64_t*)s.data(), s.size() / sizeof(uint64_t)), &d) * sizeof(uint64_t));
+         }
+      }
+
+   s.size_adjust(u_sort_doc_id((uint64_t*)s.data(), s.size() / sizeof(uint64_t)) * sizeof(uint64_t));
+
+   U_RETURN_STRING(s);
+}
+
+/**
+ * ------------------------------------------------
+ * findDocID() is be called from:
+ * ------------------------------------------------
+ * UQueryParser::evaluate() (loop for all doc name)
+ * ------------------------------------------------
+ */
+
+bool UPosting::findDocID(UStringRep* word_rep)
+{
+   U_TRACE(5, "UPosting::findDocID(%V)", word_rep)
+
+   U_INTERNAL_ASSERT(*str_cur_doc_id)
+   U_INTERNAL_ASSERT_POINTER(cdb_words)
+
+   // manage meta expr, composite word, etc. for all doc name... (save info with property)
+
+   uint32_t i;
+
+   word->_assign(word_rep);
+
+   if (vec_word) i = vec_word->find(*word);
+   else
+      {
+      // allocation property...
+
+      i = U_NOT_FOUND;
+
+      U_NEW(UVector<UString>, vec_word, UVector<UString>(32));
+      U_NEW(UVector<UString>, vec_entry, UVector<UString>(approximate_num_words));
+      U_NEW(UVector<UString>, vec_posting, UVector<UString>(32));
+      }
+
+   // check if exist property for this word...
+
+   if (i == U_NOT_FOUND)
+      {
+      // set property for this word...
+
+      i = vec_word->size();
+
+      vec_word->push_back(*word);
+
+      if (word_rep->isQuoted('"'))
+         {
+         property[i].is_meta   = false;
+         property[i].is_quoted = true;
+         }
+      else if (word->find_first_of("?*", 0, 2) != U_NOT_FOUND)
+         {
+         property[i].is_meta   = true;
+         property[i].is_quoted = false;
+         }
+      else
+         {
+         property[i].is_meta = property[i].is_quoted = false;
+         }
+      }
+
+   // find context with property...
+
+   if (property[i].is_quoted)
+      {
+      // context composite word...
+
+      static UStringRep* last_word_rep;
+
+      if (word_rep != last_word_rep)
+         {
+         last_word_rep = word_rep;
+
+         if (vec_sub_word) resetVectorCompositeWord();
+         }
+
+      if (callForCompositeWord(U_NULLPTR)) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   if (property[i].is_meta)
+      {
+      // context meta word...
+
+      UString entry;
+
+      if (i < vec_posting->size()) entry = (*vec_posting)[i];
+      else
+         {
+         entry = getValuesWithKeyNask();
+
+         vec_posting->push_back(entry);
+         }
+
+      if (entry &&
+          u_find(entry.data(), entry.size(), ptr_cur_doc_id, sizeof(cur_doc_id)))
+         {
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
+   // context single word...
+
+   if (setPosting(true)) U_RETURN(true);
+
+   U_RETURN(false);
+}
+
+void UPosting::callForPosting(vPF function, bool is_space)
+{
+   U_TRACE(5, "UPosting::callForPosting(%p,%b)", function, is_space)
+
+   U_INTERNAL_ASSERT(*word)
+   U_INTERNAL_ASSERT_POINTER(cdb_words)
+
+   if (is_space) // composite word
+      {
+      // check for NEAR operation (string not quoted)...
+
+      bool is_quoted = word->isQuoted();
+
+      U_INTERNAL_DUMP("is_quoted = %b", is_quoted)
+
+      if (is_quoted == false) max_distance = ((uint32_t)-1);
+
+      initRanking();
+
+      (void) callForCompositeWord(addHit);
+
+      callForHit(function);
+      }
+   else // single word
+      {
+      UVector<UString> vword(1);
+
+      vword.push_back(*word);
+
+      callForWAND(vword, function);
+      }
+}
+
+/**
+ * ------------------------------------------------
+ * CONTEXT COMPOSITE WORD...
+ * ------------------------------------------------
+ * checkCompositeWord() may be called from:
+ * ------------------------------------------------
+ * UQueryParser::evaluate() (loop for all doc name)
+ * callForPosting()         (for composite word)
+ * setCursor()              (for composite word)
+ * ------------------------------------------------
+ */
+
+U_NO_EXPORT bool UPosting::matchCompositeWord(u_posting_cursor* vcursor, uint32_t first_subword_index)
+{
+   U_TRACE(5, "UPosting::matchCompositeWord(%p,%u)", vcursor, first_subword_index)
+
+   U_INTERNAL_DUMP("cur_doc_id = %llu", cur_doc_id)
+
+   const char* ppos;
+   const char* ppos1;
+   uint32_t i, j, k, first_pos = 0, first_subword_freq, sz;
+
+   (void) setSubWord(first_subword_index);
+
+   sz    = sub_word_size;
+   ppos1 = u_get_positions(vcursor+first_subword_index, &first_subword_freq);
+
+   U_INTERNAL_DUMP("first_subword_freq  = %u", first_subword_freq)
+
+   U_INTERNAL_ASSERT_MAJOR(first_subword_freq, 0)
+
+   // loop for all the position of first sub-word util for this document...
+
+   for (i = 0; i < first_subword_freq; ++i)
+      {
+      first_pos        += (uint32_t)u_get_varint(ppos1);
+      sub_word_pos_prev = first_pos + sz;
+
+      U_INTERNAL_DUMP("pos[%3u]           = %u", i, first_pos)
+      U_INTERNAL_DUMP("sub_word_pos_prev  = %u", sub_word_pos_prev)
+
+      // check if the other sub-word match in the current doc...
+
+      for (j = first_subword_index + 1; j < vec_sub_word_size; ++j)
+         {
+         if (setSubWord(j) == false) continue;
+
+         ppos = u_get_positions(vcursor+j, &word_freq);
+
+         U_INTERNAL_DUMP("word_freq          = %u", word_freq)
+
+         U_INTERNAL_ASSERT_MAJOR(word_freq, 0)
+
+         // check for all position for this sub-word in the current doc...
+
+         for (k = 0, pos = 0; k < word_freq; ++k)
+            {
+            pos     += (uint32_t)u_get_varint(ppos);
+            distance = pos - sub_word_pos_prev;
+
+            U_INTERNAL_DUMP("pos[%3u]           = %u", k, pos)
+            U_INTERNAL_DUMP("distance           = %u", distance)
+
+            if (distance <= max_distance) break;
+            }
+
+         if (k == word_freq) goto next; // NOT match, go to another position for the first sub-word util...
+
+         sub_word_pos_prev = pos + sub_word_size;
+         }
+
+      U_RETURN(true);
+next: ;
+      }
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT bool UPosting::callForCompositeWord(vPF function)
+{
+   U_TRACE(5, "UPosting::callForCompositeWord(%p)", function)
+
+   U_INTERNAL_ASSERT_POINTER(cdb_names)
+
+   if (vec_sub_word == U_NULLPTR &&
+       setVectorCompositeWord() == false)
+      {
+      U_RETURN(false);
+      }
+
+   // open a cursor on the posting of every sub-word util, with the rarest as first for the intersection
+
+   uint32_t i, n, rarest = U_NOT_FOUND, first_subword_index = U_NOT_FOUND;
+   u_posting_cursor* vcursor = (u_posting_cursor*) UMemoryPool::cmalloc(vec_sub_word_size, sizeof(u_posting_cursor));
+
+   for (i = 0; i < vec_sub_word_size; ++i)
+      {
+      if (setSubWord(i) == false) continue;
+
+      u_open_cursor(vcursor+i, posting->data());
+
+      if (first_subword_index == U_NOT_FOUND) first_subword_index = i;
+
+      if (rarest == U_NOT_FOUND ||
+          vcursor[i].ndoc < vcursor[rarest].ndoc)
+         {
+         rarest = i;
+         }
+      }
+
+   U_INTERNAL_DUMP("first_subword_index = %u rarest = %u", first_subword_index, rarest)
+
+   bool result = false;
+
+   if (first_subword_index == U_NOT_FOUND) goto end;
+
+   if (function == U_NULLPTR) // check only the current document...
+      {
+      for (i = first_subword_index; i < vec_sub_word_size; ++i)
+         {
+         if ((*vec_sub_word)[i].size() >= min_word_size &&
+             u_seek(vcursor+i, cur_doc_id) == false)
+            {
+            goto end;
+            }
+         }
+
+      result = matchCompositeWord(vcursor, first_subword_index);
+
+      goto end;
+      }
+
+   {
+   // the candidate documents: intersection of the DocID of all the sub-word util...
+
+   UString vdoc(vcursor[rarest].ndoc * sizeof(uint64_t));
+
+   uint64_t* pdoc = (uint64_t*)vdoc.data();
+
+   n = u_get_doc_id(vcursor+rarest, pdoc);
+
+   for (i = first_subword_index; n && i < vec_sub_word_size; ++i)
+      {
+      if (i != rarest &&
+          (*vec_sub_word)[i].size() >= min_word_size)
+         {
+         n = u_intersect(pdoc, n, vcursor+i);
+         }
+      }
+
+   U_INTERNAL_DUMP("candidate = %u", n)
+
+   if (n)
+      {
+      // reset the cursor...
+
+      for (i = first_subword_index; i < vec_sub_word_size; ++i)
+         {
+         if (setSubWord(i)) u_open_cursor(vcursor+i, posting->data());
+         }
+      }
+
+   for (uint32_t k = 0; k < n; ++k)
+      {
+      cur_doc_id = pdoc[k];
+
+      for (i = first_subword_index; i < vec_sub_word_size; ++i)
+         {
+         if ((*vec_sub_word)[i].size() >= min_word_size) (void) u_seek(vcursor+i, cur_doc_id);
+         }
+
+      if (matchCompositeWord(vcursor, first_subword_index))
+         {
+         result = true;
+
+         if (function != addHit)
+            {
+            word_freq = (max_distance == ((uint32_t)-1) // check for NEAR...
+                                 ? 0
+                                 : max_distance - distance);
+            }
+         else
+            {
+            // ranking: the score is the sum of the score of the sub-word util...
 
-   if (posting->size() == (sizeof(uint32_t) + POSTING_SIZE(ptr))) U_RETURN(true);
+            uint32_t dl = u_get_doc_length(cur_doc_id);
 
-   U_RETURN(false);
+            for (i = first_subword_index, bm25_score = 0.0; i < vec_sub_word_size; ++i)
+               {
+               if ((*vec_sub_word)[i].size() >= min_word_size) bm25_score += u_bm25(u_idf(vcursor[i].ndoc), u_get_freq(vcursor+i), dl);
+               }
+            }
+
+         function();
+         }
+      }
+   }
+
+end:
+   UMemoryPool::_free(vcursor, vec_sub_word_size, sizeof(u_posting_cursor));
+
+   U_RETURN(result);
 }
 
-U_NO_EXPORT void UPosting::del()
+// BOOLEAN QUERY (set of DocID for a term of the disjunctive normal form)
+
+U_NO_EXPORT void UPosting::addDocID()
 {
-   U_TRACE(5, "UPosting::del()")
+   U_TRACE_NO_PARAM(5, "UPosting::addDocID()")
 
-   U_INTERNAL_ASSERT(*word)
-   U_INTERNAL_ASSERT(*posting)
-   U_INTERNAL_ASSERT_POINTER(ptr)
+   (void) vdoc_id->append((const char*)&cur_doc_id, sizeof(uint64_t));
+}
 
-   data = posting->data();
+U_NO_EXPORT int UPosting::addDocName(UStringRep* doc_id, UStringRep* doc_name)
+{
+   U_TRACE(5, "UPosting::addDocName(%#V,%V)", doc_id, doc_name)
 
-   U_INTERNAL_DUMP("word_freq       = %u",   POSTING32(ptr,word_freq))
-   U_INTERNAL_DUMP("size_entry      = %u",   POSTING_SIZE(ptr))
-   U_INTERNAL_DUMP("cur_doc_id      = %llu", cur_doc_id)
-   U_INTERNAL_DUMP("posting->size() = %u",   posting->size())
-   U_INTERNAL_DUMP("off_last_doc_id = %u",   POSTING_OFFSET_LAST_DOC_ID)
+   (void) vdoc_id->append(doc_id->data(), sizeof(uint64_t));
 
-   U_INTERNAL_ASSERT_MAJOR(POSTING32(ptr,word_freq), 0)
+   U_RETURN(1);
+}
 
-   // check if other reference...
+U_NO_EXPORT bool UPosting::setCursor(u_posting_cursor* c, UStringRep* word_rep, UVector<UString>& vvalue)
+{
+   U_TRACE(5, "UPosting::setCursor(%p,%V,%p)", c, word_rep, &vvalue)
 
-   int result;
+   U_INTERNAL_ASSERT_POINTER(cdb_words)
 
-   if (isOneEntry())
+   UString value;
+
+   word->_assign(word_rep);
+
+   if (word_rep->isQuoted('"')) // composite word
       {
-      result = ((URDB*)cdb_words)->remove(*word);
+      if (vec_sub_word) resetVectorCompositeWord();
 
-      if (result != 0)
+      vdoc_id->setBuffer(U_CAPACITY);
+
+      (void) callForCompositeWord(addDocID);
+
+      if (vec_sub_word) resetVectorCompositeWord();
+
+      value = UString(*vdoc_id); // NB: already sorted...
+
+      vdoc_id->clear();
+      }
+   else if (word->find_first_of("?*", 0, 2) != U_NOT_FOUND) // meta word
+      {
+      if (vec_entry == U_NULLPTR) U_NEW(UVector<UString>, vec_entry, UVector<UString>(approximate_num_words));
+
+      value = getValuesWithKeyNask();
+      }
+   else
+      {
+      readBlock(word_rep);
+
+      if (*posting)
          {
-         U_ERROR("del(): error<%d> on operation remove word<%.*s> from index database", result, U_STRING_TO_TRACE(*word));
+         vvalue.push_back(*posting);
+
+         u_open_cursor(c, posting->data());
+
+         U_RETURN(true);
          }
+      }
 
-      return;
+   if (value)
+      {
+      vvalue.push_back(value);
+
+      u_open_cursor(c, value);
+
+      U_RETURN(true);
       }
 
-#if defined(DEBUG) || defined(U_TEST)
-   uint32_t last_offset = POSTING_OFFSET_LAST_DOC_ID;
-#endif
+   U_RETURN(false);
+}
 
-   char* end = (char*) posting->pend();
+UString UPosting::getDocID(UVector<UString>* positives, UVector<UString>* negatives)
+{
+   U_TRACE(5, "UPosting::getDocID(%p,%p)", positives, negatives)
 
-   do {
-      U_INTERNAL_DUMP("doc_id          = %lu", POSTING64(ptr,doc_id))
+   U_INTERNAL_ASSERT_POINTER(cdb_names)
 
-      size_entry = POSTING_SIZE(ptr);
+   UString result;
+   UVector<UString> vvalue;
+   uint32_t i, j, n = 0, npos = positives->size(), nneg = negatives->size();
+   uint32_t* vorder = (uint32_t*) UMemoryPool::cmalloc(npos + 1, sizeof(uint32_t));
+   u_posting_cursor* vcursor = (u_posting_cursor*) UMemoryPool::cmalloc(npos + nneg, sizeof(u_posting_cursor));
 
-      if (POSTING64(ptr,doc_id) == cur_doc_id) break;
+   if (vdoc_id == U_NULLPTR) U_NEW_STRING(vdoc_id, UString);
 
-      ptr += size_entry;
+   // the cost of a word is the number of document: rarest first...
+
+   for (i = 0; i < npos; ++i)
+      {
+      if (setCursor(vcursor+i, (*positives)[i].rep, vvalue) == false) goto end;
+
+      for (j = i; j > 0 && vcursor[i].ndoc < vcursor[vorder[j-1]].ndoc; --j) vorder[j] = vorder[j-1];
+
+      vorder[j] = i;
       }
-   while (ptr < end);
 
-   if (ptr >= end) U_ERROR("del(): cannot find DocID<%llu> reference for word<%.*s> on index database", cur_doc_id, U_STRING_TO_TRACE(*word));
+   if (npos)
+      {
+      result.setBuffer(vcursor[vorder[0]].ndoc * sizeof(uint64_t));
 
-   (void) posting->replace(ptr - data, size_entry, 0, '\0');
+      n = u_get_doc_id(vcursor+vorder[0], (uint64_t*)result.data());
 
-   // reassign value
+      for (i = 1; n && i < npos; ++i) n = u_intersect((uint64_t*)result.data(), n, vcursor+vorder[i]);
+      }
+   else
+      {
+      // only negatives: all the document...
 
-   data = posting->data();
-   ptr  = data + sizeof(uint32_t);
-   end  = (char*) posting->pend();
+      vdoc_id->setBuffer(U_CAPACITY);
 
-   U_INTERNAL_DUMP("posting->size() = %u", posting->size())
+      callForAllDocName(addDocName);
 
-   U_INTERNAL_ASSERT_EQUALS(POSTING_OFFSET_LAST_DOC_ID, last_offset)
+      result = UString(*vdoc_id);
 
-   do {
-      size_entry = POSTING_SIZE(ptr);
+      vdoc_id->clear();
 
-      ptr += size_entry;
+      n = u_sort_doc_id((uint64_t*)result.data(), result.size() / sizeof(uint64_t));
       }
-   while (ptr < end);
-
-   U_INTERNAL_ASSERT_EQUALS(ptr - data, (ptrdiff_t)posting->size())
 
-   u_put_unalignedp32(data, (ptr - data) - size_entry);
+   for (i = 0; n && i < nneg; ++i)
+      {
+      if (setCursor(vcursor+npos+i, (*negatives)[i].rep, vvalue)) n = u_difference((uint64_t*)result.data(), n, vcursor+npos+i);
+      }
 
-   U_INTERNAL_DUMP("off_last_doc_id = %u", POSTING_OFFSET_LAST_DOC_ID)
+   if (n) result.size_adjust(n * sizeof(uint64_t));
+   else   result.clear();
 
-   U_INTERNAL_ASSERT_MINOR(POSTING_OFFSET_LAST_DOC_ID, last_offset)
+end:
+   UMemoryPool::_free(vorder,  npos + 1,    sizeof(uint32_t));
+   UMemoryPool::_free(vcursor, npos + nneg, sizeof(u_posting_cursor));
 
-   result = writePosting(RDB_REPLACE);
+   U_INTERNAL_DUMP("num doc = %u", result.size() / sizeof(uint64_t))
 
-   if (result != 0) U_ERROR("del(): error<%d> on operation replace reference for word<%.*s> on index database", result, U_STRING_TO_TRACE(*word));
+   U_RETURN_STRING(result);
 }
 
-// ADD WORD
-
-inline void UPosting::init()
+UString UPosting::unionDocID(const UString& x, const UString& y)
 {
-   U_TRACE(5, "UPosting::init()")
+   U_TRACE(5, "UPosting::unionDocID(%u,%u)", x.size(), y.size())
 
-   u_put_unalignedp64(&(((u_posting*)(ptr))->doc_id), cur_doc_id);
-   u_put_unalignedp32(&(((u_posting*)(ptr))->word_freq), 0);
+   if (x.empty()) return y;
+   if (y.empty()) return x;
+
+   const uint64_t* a = (const uint64_t*)x.data();
+   const uint64_t* b = (const uint64_t*)y.data();
+   uint32_t i = 0, j = 0, k = 0, na = x.size() / sizeof(uint64_t), nb = y.size() / sizeof(uint64_t);
+
+   UString result((na + nb) * sizeof(uint64_t));
+
+   uint64_t* out = (uint64_t*)result.data();
+
+   while (i < na &&
+          j < nb)
+      {
+      if      (a[i] < b[j]) out[k++] = a[i++];
+      else if (a[i] > b[j]) out[k++] = b[j++];
+      else
+         {
+         out[k++] = a[i++];
+
+         ++j;
+         }
+      }
+
+   while (i < na) out[k++] = a[i++];
+   while (j < nb) out[k++] = b[j++];
+
+   result.size_adjust(k * sizeof(uint64_t));
+
+   U_RETURN_STRING(result);
 }
 
-inline void UPosting::checkCapacity()
+// RANKING (BM25 and top-k with Block-Max WAND)
+
+U_NO_EXPORT void UPosting::initRanking()
 {
-   U_TRACE(5, "UPosting::checkCapacity()")
+   U_TRACE_NO_PARAM(5, "UPosting::initRanking()")
 
-   space = off_last_doc_id + size_entry + sizeof(off_last_doc_id);
+   U_INTERNAL_ASSERT_POINTER(cdb_names)
 
-   U_INTERNAL_DUMP("space = %u", space)
+   if (vhit == U_NULLPTR) U_NEW_STRING(vhit, UString);
 
-   if (space >= posting->capacity())
-      {
-      if (tbl_words) tbl_words_space -= posting->capacity();
+   vhit->setBuffer((top_k ? top_k : 64U) * sizeof(u_posting_hit));
 
-   // if (posting->uniq() == false) posting->duplicate();
+   nhit      =
+   num_match = 0;
 
-      posting->reserve(space * 2);
+   bm25_ndoc       = U_max(cdb_names->size(), 1U);
+   bm25_avgdl      = 1.0;
+   bm25_doc_length = false;
 
-      if (tbl_words)
-         {
-         tbl_words_space += posting->capacity();
+   if (cdb_stats &&
+       cdb_stats->isMapped())
+      {
+      UString value = (*cdb_stats)[UString((void*)u_stats_total, sizeof(uint64_t))];
 
-         tbl_words->replaceAfterFind(*posting);
+      if (value.size() == sizeof(uint64_t))
+         {
+         bm25_avgdl      = (double)u_get_unalignedp64(value.data()) / bm25_ndoc;
+         bm25_doc_length = (bm25_avgdl > 0.0);
          }
       }
 
-   data = posting->data();
-   ptr  = data + off_last_doc_id;
+   U_INTERNAL_DUMP("top_k = %u bm25_ndoc = %g bm25_avgdl = %g bm25_doc_length = %b", top_k, bm25_ndoc, bm25_avgdl, bm25_doc_length)
 }
 
-U_NO_EXPORT void UPosting::add()
+U_NO_EXPORT void UPosting::addHit()
 {
-   U_TRACE(5, "UPosting::add()")
+   U_TRACE_NO_PARAM(5, "UPosting::addHit()")
 
-   U_INTERNAL_ASSERT(*word)
+   ++num_match;
 
-   bool present = (tbl_words ?         tbl_words->find(*word)
-                             : ((URDB*)cdb_words)->find(*word));
+   u_push_hit(top_k, cur_doc_id, bm25_score);
+}
 
-   if (present == false)
+U_NO_EXPORT void UPosting::callForHit(vPF function)
+{
+   U_TRACE(5, "UPosting::callForHit(%p)", function)
+
+   U_INTERNAL_DUMP("nhit = %u num_match = %u", nhit, num_match)
+
+   u_posting_hit* h = (u_posting_hit*)vhit->data();
+
+   if (nhit > 1) qsort(h, nhit, sizeof(u_posting_hit), u_compare_hit);
+
+   pfunction = function;
+
+   for (uint32_t i = 0; i < nhit; ++i)
       {
-      // first document for this word...
+      cur_doc_id = h[i].doc_id;
+      word_freq  = U_POSTING_WEIGHT(h[i].score);
 
-      *posting = UString(U_CAPACITY);
-      data     = posting->data();
-      ptr      = data + sizeof(off_last_doc_id);
+      callForPostingAndSetFilename();
+      }
+}
 
-      // setting off_last_doc_id for first document...
+U_NO_EXPORT uint32_t UPosting::setTerm(u_posting_term* vterm, UVector<UString>& vword, UVector<UString>& vvalue)
+{
+   U_TRACE(5, "UPosting::setTerm(%p,%p,%p)", vterm, &vword, &vvalue)
 
-      size_entry      = sizeof(u_posting);
-      off_last_doc_id = sizeof(off_last_doc_id);
+   UString w;
+   uint32_t n = 0;
 
-      u_put_unalignedp32(data, sizeof(off_last_doc_id));
+   for (uint32_t i = 0, nword = vword.size(); i < nword; ++i)
+      {
+      w = vword[i];
 
-      init();
+      readBlock(w.rep);
 
-      if (tbl_words)
-         {
-         tbl_words_space += word->size() + posting->capacity();
+      if (posting->empty()) continue;
 
-         word->duplicate(); // NB: need duplicate string because depends on mmap()'s content of document...
+      vvalue.push_back(*posting);
 
-         UHashMap<void*>::lkey = word->rep;
+      u_open_cursor(&(vterm[n].c), posting->data());
 
-         tbl_words->insertAfterFind(*posting);
-         }
+      vterm[n].idf = u_idf(vterm[n].c.ndoc);
+      vterm[n].ub  = u_bm25_max(vterm[n].idf, u_get_max_freq(&(vterm[n].c)));
+
+      u_term_set(vterm + n++);
       }
-   else
-      {
-      if (tbl_words) posting->_assign(tbl_words->elem());
-      else           readPosting(U_NULLPTR, false);
 
-   // U_ASSERT_EQUALS(0,find(posting->data() + sizeof(uint32_t), posting->size() - sizeof(uint32_t)))
+   U_RETURN(n);
+}
 
-      data            = posting->data();
-      off_last_doc_id = POSTING_OFFSET_LAST_DOC_ID;
-      ptr             = data + off_last_doc_id;
-      size_entry      = POSTING_SIZE(ptr);
+/**
+ * Block-Max WAND (disjunction of words): the terms are sorted by the current DOC id and the pivot is the first term where
+ * the sum of the upper bound exceed the threshold (the min score of the best results). If also the sum of the upper bound
+ * of the blocks of the terms until the pivot exceed the threshold we evaluate the document, otherwise we skip all the
+ * documents until the end of the shortest of these blocks without decode them...
+ */
 
-      U_INTERNAL_DUMP("word_freq       = %u", POSTING32(ptr,word_freq))
-      U_INTERNAL_DUMP("size_entry      = %u", size_entry)
-      U_INTERNAL_DUMP("off_last_doc_id = %u", off_last_doc_id)
+#define U_TERM(i) (vterm+vorder[i])
 
-      U_INTERNAL_ASSERT_MAJOR(POSTING32(ptr,word_freq), 0)
+void UPosting::callForWAND(UVector<UString>& vword, vPF function)
+{
+   U_TRACE(5, "UPosting::callForWAND(%p,%p)", &vword, function)
 
-      U_ASSERT((off_last_doc_id + size_entry) <= posting->capacity())
+   U_INTERNAL_ASSERT_MAJOR(vword.size(), 0)
 
-      // check for new document...
+   initRanking();
 
-      if (POSTING64(ptr,doc_id) != cur_doc_id)
-         {
-         off_last_doc_id += size_entry;
-               size_entry = sizeof(u_posting);
+   UVector<UString> vvalue;
+   uint64_t d, last, next, ndoc = 0;
+   double theta, bound, score;
+   uint32_t i, j, p, dl, n, nword = vword.size();
+   uint32_t*       vorder = (uint32_t*)       UMemoryPool::cmalloc(nword, sizeof(uint32_t));
+   u_posting_term* vterm  = (u_posting_term*) UMemoryPool::cmalloc(nword, sizeof(u_posting_term));
 
-         u_put_unalignedp32(data, off_last_doc_id);
+   n = setTerm(vterm, vword, vvalue);
 
-         // check string capacity...
+   for (i = 0; i < n; ++i)
+      {
+      vorder[i] = i;
 
-         checkCapacity();
+      ndoc += vterm[i].c.ndoc;
+      }
 
-         init();
+   while (n)
+      {
+      // sort the terms by the current DOC id (they are few and almost sorted)
+
+      for (i = 1; i < n; ++i)
+         {
+         for (j = i; j > 0 && u_term_less(U_TERM(j), U_TERM(j-1)); --j)
+            {
+            p           = vorder[j];
+            vorder[j]   = vorder[j-1];
+            vorder[j-1] = p;
+            }
          }
-      }
 
-   U_INTERNAL_ASSERT_EQUALS(cur_doc_id,      POSTING64(ptr,doc_id))
-   U_INTERNAL_ASSERT_EQUALS(off_last_doc_id, POSTING_OFFSET_LAST_DOC_ID)
+      theta = u_get_threshold(top_k);
 
-   // check string capacity...
+      for (i = 0, p = n, bound = 0.0; i < n && U_TERM(i)->end == false; ++i)
+         {
+         bound += U_TERM(i)->ub;
 
-   checkCapacity();
+         if (bound > theta)
+            {
+            p = i;
 
-   U_INTERNAL_ASSERT_EQUALS(cur_doc_id,      POSTING64(ptr,doc_id))
-   U_INTERNAL_ASSERT_EQUALS(off_last_doc_id, POSTING_OFFSET_LAST_DOC_ID)
+            break;
+            }
+         }
 
-   // save position of word in document...
+      if (p == n) break; // NB: no other document can enter in the best results...
 
-   word_freq = POSTING32(ptr,word_freq);
+      d = U_TERM(p)->doc;
 
-   u_put_unalignedp32(ptr+sizeof(u_posting)+(word_freq*sizeof(uint32_t)), pos);
+      while ((p+1) < n              &&
+             U_TERM(p+1)->end == false &&
+             U_TERM(p+1)->doc == d)
+         {
+         ++p;
+         }
 
-   u_put_unalignedp32(&(((u_posting*)(ptr))->word_freq), word_freq+1);
+      for (i = 0, bound = 0.0, next = ~0ULL; i <= p; ++i)
+         {
+         bound += u_term_block_max(U_TERM(i), d, &last);
 
-   U_INTERNAL_DUMP("pos       = %u", pos)
-   U_INTERNAL_DUMP("pos[0]    = %u", POSTING_POS(0))
-   U_INTERNAL_DUMP("pos[1]    = %u", POSTING_POS(1))
-   U_INTERNAL_DUMP("word_freq = %u", POSTING32(ptr,word_freq))
+         if (last < next) next = last;
+         }
 
-   posting->size_adjust_force(space);
+      U_INTERNAL_DUMP("pivot = %u d = %llu theta = %g block max = %g", p, d, theta, bound)
 
-   if (tbl_words == U_NULLPTR)
-      {
-      int result = writePosting(present ? RDB_REPLACE : RDB_INSERT);
+      if (bound > theta)
+         {
+         if (U_TERM(0)->doc == d) // all the terms until the pivot are on this document: evaluation...
+            {
+            for (i = 0, bound = 0.0; i <= p; ++i) bound += u_bm25_max(U_TERM(i)->idf, u_get_freq(&(U_TERM(i)->c)));
 
-      if (result != 0)
+            if (bound > theta)
+               {
+               dl = u_get_doc_length(d);
+
+               for (i = 0, score = 0.0; i <= p; ++i) score += u_bm25(U_TERM(i)->idf, u_get_freq(&(U_TERM(i)->c)), dl);
+
+               u_push_hit(top_k, d, score);
+               }
+
+            for (i = 0; i <= p; ++i) u_term_next(U_TERM(i));
+            }
+         else
+            {
+            for (i = 0; i < p && U_TERM(i)->doc < d; ++i) u_term_seek(U_TERM(i), d);
+            }
+         }
+      else
          {
-         U_ERROR("add(): error<%d> on operation store reference for word<%.*s> on index database", result, U_STRING_TO_TRACE(*word));
+         // no document until the end of the current blocks can enter in the best results: we skip the blocks...
+
+         if ((p+1) < n              &&
+             U_TERM(p+1)->end == false &&
+             U_TERM(p+1)->doc <= next)
+            {
+            next = U_TERM(p+1)->doc - 1;
+            }
+
+         if (next == ~0ULL) break;
+
+         for (i = 0; i <= p; ++i) u_term_seek(U_TERM(i), next+1);
          }
       }
-}
 
-// CHECK POSTING AND WORD
+   // NB: the number of document that match is exact only if the results are less than top-k...
 
-U_NO_EXPORT void UPosting::checkPosting()
-{
-   U_TRACE(5, "UPosting::checkPosting()")
+   num_match = (top_k == 0 || nhit < top_k ? nhit : (uint32_t)U_min(ndoc, (uint64_t)bm25_ndoc));
 
-   U_INTERNAL_ASSERT_POINTER(ptr)
+   UMemoryPool::_free(vorder, nword, sizeof(uint32_t));
+   UMemoryPool::_free(vterm,  nword, sizeof(u_posting_term));
 
-   U_INTERNAL_DUMP("cur_doc_id      = %llu", cur_doc_id)
+   callForHit(function);
+}
 
-   U_INTERNAL_ASSERT_EQUALS(cur_doc_id, POSTING64(ptr,doc_id))
+#undef U_TERM
 
-   word_freq = POSTING32(ptr,word_freq);
+void UPosting::callForDocID(const UString& vdoc, UVector<UString>& vword, vPF function)
+{
+   U_TRACE(5, "UPosting::callForDocID(%u,%p,%p)", vdoc.size(), &vword, function)
 
-   U_INTERNAL_DUMP("word_freq       = %u", word_freq)
-   U_INTERNAL_DUMP("size_entry      = %u", POSTING_SIZE(ptr))
-   U_INTERNAL_DUMP("offset          = %u", posting->distance(ptr))
-   U_INTERNAL_DUMP("posting->size() = %u", posting->size())
+   initRanking();
 
-#if defined(U_OPTIMIZE) && defined(DEBUG)
-   if (cdb_words->ignoreCase() == false)
-      {
-      U_INTERNAL_ASSERT_DIFFERS(u_find(content->data(), content->size(), word->data(), word->size()),0)
-      }
-#endif
+   uint64_t d;
+   double theta, bound, score;
+   UVector<UString> vvalue;
+   const uint64_t* pdoc = (const uint64_t*)vdoc.data();
+   uint32_t i, k, dl, n = 0, nword = vword.size(), ndoc = vdoc.size() / sizeof(uint64_t);
+   u_posting_term* vterm = (nword ? (u_posting_term*) UMemoryPool::cmalloc(nword, sizeof(u_posting_term)) : U_NULLPTR);
 
-   uint32_t end = content->size(),
-             sz =    word->size();
+   if (nword) n = setTerm(vterm, vword, vvalue);
 
-   uint32_t* vpos = (uint32_t*)(ptr+sizeof(u_posting));
+   for (k = 0; k < ndoc; ++k)
+      {
+      d     = pdoc[k];
+      theta = u_get_threshold(top_k);
 
-   char* ptr_word = word->data();
-   char* ptr_data = content->data();
+      for (i = 0, bound = 0.0; i < n; ++i)
+         {
+         if (vterm[i].end == false &&
+             vterm[i].doc < d)
+            {
+            u_term_seek(vterm+i, d);
+            }
 
-   for (uint32_t i = 0; i < word_freq; ++i)
-      {
-      uint32_t start = u_get_unalignedp32(vpos+i);
+         if (vterm[i].end == false &&
+             vterm[i].doc == d)
+            {
+            bound += u_bm25_max(vterm[i].idf, u_get_freq(&(vterm[i].c)));
+            }
+         }
 
-      U_INTERNAL_DUMP("start           = %u", start)
+      if (top_k         &&
+          nhit == top_k &&
+          bound <= theta)
+         {
+         continue;
+         }
 
-      if (start >= end ||
-          u_equal(ptr_word, ptr_data+start, sz, cdb_words->ignoreCase()))
+      dl = (bound > 0.0 ? u_get_doc_length(d) : 0);
+
+      for (i = 0, score = 0.0; i < n; ++i)
          {
-         U_ERROR("checkPosting(): word<%v> reference at position<%u> for DocID<%llu %v> lost", word->rep, start, cur_doc_id, filename->rep);
+         if (vterm[i].end == false &&
+             vterm[i].doc == d)
+            {
+            score += u_bm25(vterm[i].idf, u_get_freq(&(vterm[i].c)), dl);
+            }
          }
+
+      u_push_hit(top_k, d, score);
       }
+
+   num_match = ndoc;
+
+   if (vterm) UMemoryPool::_free(vterm, nword, sizeof(u_posting_term));
+
+   callForHit(function);
 }
 
-// PROCESS WORD
+// DOCUMENT LENGTH (number of words of the document for the ranking)
 
-void UPosting::processWord(int32_t op)
+void UPosting::setDocLength(int32_t op)
 {
-   U_TRACE(5, "UPosting::processWord(%d)", op)
-
-   U_INTERNAL_ASSERT_POINTER(content)
+   U_TRACE(5, "UPosting::setDocLength(%d)", op)
 
-   if (word->size() < min_word_size) return;
+   U_INTERNAL_DUMP("doc_length = %u", doc_length)
 
-   pos = pos_start + (word->data() - content->data());
+   if (op == 3) return; // check
 
-   U_INTERNAL_DUMP("word = %V pos = %u", word->rep, pos)
+   UString value, key_total((void*)u_stats_total, sizeof(uint64_t));
+   uint32_t old_length = 0;
+   uint64_t total = 0;
 
-   if (op == 0 ||
-       op == 1)
-      {
-      add(); // add/sub
-      }
-   else
+   if (tbl_stats) // index
       {
-      readPosting(word->rep, (op == 2)); // del
+      if (tbl_stats->find(*str_cur_doc_id)) old_length = u_get_unalignedp32(tbl_stats->elem()->data()); // NB: directory as document...
+      else                                  tbl_stats_space += str_cur_doc_id->size() + sizeof(uint32_t);
 
-      if (posting->empty() ||
-          setPosting(false) == false)
-         {
-         U_ERROR("processWord(%d): word<%v> reference at position<%u> for DocID<%llu %v> lost", op, word->rep, pos, cur_doc_id, filename->rep);
-         }
+      tbl_stats->insert(*str_cur_doc_id, UString((void*)&doc_length, sizeof(uint32_t)));
 
-      if      (op == 2) del();          // del
-      else if (op == 3) checkPosting(); // check
+      if (tbl_stats->find(key_total)) total = u_get_unalignedp64(tbl_stats->elem()->data());
+      else                            tbl_stats_space += key_total.size() + sizeof(uint64_t);
+
+      total += doc_length - old_length;
+
+      tbl_stats->insert(key_total, UString((void*)&total, sizeof(uint64_t)));
+
+      return;
       }
-}
 
-// CHECK DOCUMENT
+   U_INTERNAL_ASSERT_POINTER(cdb_stats)
 
-U_NO_EXPORT int UPosting::checkDocument(UStringRep* word_rep, UStringRep* value)
-{
-   U_TRACE(5, "UPosting::checkDocument(%.*S,%p)", U_STRING_TO_TRACE(*word_rep), value)
+   value = (*((URDB*)cdb_stats))[str_cur_doc_id->rep];
 
-   U_INTERNAL_ASSERT(*content)
+   if (value.size() == sizeof(uint32_t)) old_length = u_get_unalignedp32(value.data());
 
-   if (findCurrentDocIdOnPosting(value))
+   int result = (op == 2 ? ((URDB*)cdb_stats)->remove(*str_cur_doc_id) // del
+                         : ((URDB*)cdb_stats)->store( *str_cur_doc_id, (const char*)&doc_length, sizeof(uint32_t), RDB_REPLACE));
+
+   if (result == 0)
       {
-      word->_assign(word_rep);
+      value = (*((URDB*)cdb_stats))[key_total];
 
-      U_INTERNAL_DUMP("cdb_words->ignoreCase() = %b", cdb_words->ignoreCase())
+      if (value.size() == sizeof(uint64_t)) total = u_get_unalignedp64(value.data());
 
-#  ifndef U_OPTIMIZE
-      if (cdb_words->ignoreCase() == false &&
-          u_find(content->data(), content->size(), word->data(), word->size()) == U_NULLPTR)
-         {
-         U_RETURN(1);
-         }
-#  endif
+      total += (op == 2 ? 0 : doc_length);
+      total -= U_min(old_length, total);
 
-      checkPosting();
+      result = ((URDB*)cdb_stats)->store(key_total, (const char*)&total, sizeof(uint64_t), RDB_REPLACE);
       }
 
-   U_RETURN(1);
+   if (result != 0 &&
+       (op != 2 || old_length)) // NB: document indexed before the statistics...
+      {
+      U_ERROR("setDocLength(%d): error<%d> on statistics database", op, result);
+      }
 }
 
-U_NO_EXPORT int UPosting::checkAllEntry(UStringRep* word_rep, UStringRep* value)
-{
-   U_TRACE(5, "UPosting::checkAllEntry(%.*S,%p)", U_STRING_TO_TRACE(*word_rep), value)
+// SEGMENT (parallel index): header, then the records (key length, data length, key, data) of the tables sorted by key
 
-   word->_assign(word_rep);
+typedef struct u_segment_header {
+   uint64_t num_byte;
+   uint32_t num_doc, nrecord[3]; // names, stats, words
+} u_segment_header;
 
-   callForPostingAndSetFilename(U_NULLPTR);
+typedef struct u_segment_record {
+   UStringRep* key;
+   UStringRep* value;
+} u_segment_record;
 
-   (void) write(1, U_CONSTANT_TO_PARAM(".")); // CHECK_2
+typedef struct u_segment_cursor {
+   const char* ptr;
+   uint32_t nrecord[3];
+} u_segment_cursor;
 
-   U_RETURN(1);
-}
+#define U_RECORD_KLEN(c) u_get_unalignedp32((c)->ptr)
+#define U_RECORD_DLEN(c) u_get_unalignedp32((c)->ptr+sizeof(uint32_t))
+#define U_RECORD_KEY(c)  ((c)->ptr+sizeof(uint32_t)+sizeof(uint32_t))
+#define U_RECORD_DATA(c) (U_RECORD_KEY(c)+U_RECORD_KLEN(c))
 
-void UPosting::checkAllEntry()
+static bool segment_ignore_case;
+static uint32_t segment_nrecord;
+static u_segment_record* vrecord;
+
+static inline int u_compare_key(const char* k1, uint32_t n1, const char* k2, uint32_t n2)
 {
-   U_TRACE(5, "UPosting::checkAllEntry()")
+   int r = (segment_ignore_case ? u__strncasecmp(k1, k2, U_min(n1, n2))
+                                :         memcmp(k1, k2, U_min(n1, n2)));
 
-   cdb_words->callForAllEntryWithPattern(checkAllEntry, U_NULLPTR);
+   if (r == 0) r = (int)n1 - (int)n2;
+
+   return r;
 }
 
-// SUBSTITUTE DOCUMENT
+static int u_compare_record(const void* r1, const void* r2)
+{
+   const UStringRep* k1 = ((const u_segment_record*)r1)->key;
+   const UStringRep* k2 = ((const u_segment_record*)r2)->key;
 
-U_NO_EXPORT int UPosting::substitute(UStringRep* word_rep, UStringRep* value)
+   return u_compare_key(k1->data(), k1->size(), k2->data(), k2->size());
+}
+
+static bool u_add_record(UStringRep* key, void* value)
 {
-   U_TRACE(5, "UPosting::substitute(%.*S,%p)", U_STRING_TO_TRACE(*word_rep), value)
+   vrecord[segment_nrecord].key   = key;
+   vrecord[segment_nrecord].value = (UStringRep*)value;
 
-   posting->_assign(value);
+   ++segment_nrecord;
 
-#ifdef U_COMPRESS_ENTRY
-   (void) decompress();
-#endif
+   return true;
+}
 
-   word->_assign(word_rep);
+static uint32_t u_write_table(UString& buffer, UHashMap<UString>* t, bool ignore_case)
+{
+   uint32_t i, len[2], n = t->size();
 
-   if (setPosting(false)) del();
+   if (n == 0) return 0;
 
-   U_RETURN(1);
-}
+   vrecord         = (u_segment_record*) UMemoryPool::cmalloc(n, sizeof(u_segment_record));
+   segment_nrecord = 0;
 
-// PROCESS DOCUMENT
+   t->callForAllEntry((bPFprpv)u_add_record);
 
-inline void UPosting::setDocID(bool from_inode)
-{
-   U_TRACE(5, "UPosting::setDocID(%b)", from_inode)
+   U_INTERNAL_ASSERT_EQUALS(segment_nrecord, n)
 
-   if (from_inode) cur_doc_id = - file->inode();
+   segment_ignore_case = ignore_case;
 
-   U_INTERNAL_DUMP("cur_doc_id = %llu", cur_doc_id)
+   qsort(vrecord, n, sizeof(u_segment_record), u_compare_record);
 
-   str_cur_doc_id->setFromInode(&cur_doc_id);
+   for (i = 0; i < n; ++i)
+      {
+      len[0] = vrecord[i].key->size();
+      len[1] = vrecord[i].value->size();
 
-   ptr_cur_doc_id = str_cur_doc_id->data();
+      (void) buffer.append((const char*)len, sizeof(len));
+      (void) buffer.append(vrecord[i].key->data(),   len[0]);
+      (void) buffer.append(vrecord[i].value->data(), len[1]);
+      }
+
+   UMemoryPool::_free(vrecord, n, sizeof(u_segment_record));
+
+   return n;
 }
 
-void UPosting::setDocID(int32_t op)
+bool UPosting::writeSegment(const UString& pathname)
 {
-   U_TRACE(5, "UPosting::setDocID(%d)", op)
+   U_TRACE(5, "UPosting::writeSegment(%V)", pathname.rep)
 
-   U_DUMP("filename = %.*S", U_STRING_TO_TRACE(*filename))
+   U_INTERNAL_ASSERT_POINTER(tbl_name)
 
-   if (dir_content_as_doc)
-      {
-      if (op != 0) // add
-         {
-         U_ERROR("setDocID(%d): sorry, not implemented", op);
-         }
+   u_segment_header h;
+   UString buffer(sizeof(u_segment_header) + tbl_name_space + tbl_stats_space + tbl_words_space +
+                  ((tbl_name->size() + tbl_stats->size() + tbl_words->size()) * sizeof(uint32_t) * 2));
 
-      if (change_dir == false) return;
+   buffer.size_adjust(sizeof(u_segment_header));
 
-      change_dir = false;
+   h.num_byte   = num_byte;
+   h.num_doc    = num_doc;
+   h.nrecord[0] = u_write_table(buffer, tbl_name,  false);
+   h.nrecord[1] = u_write_table(buffer, tbl_stats, false);
+   h.nrecord[2] = u_write_table(buffer, tbl_words, ignore_case);
 
-      *filename = UStringExt::dirname(*filename);
+   U_MEMCPY(buffer.data(), &h, sizeof(u_segment_header));
 
-      filename->duplicate(); // NB: need duplicate string because depends on volatile buffer of filename...
+   if (UFile::writeTo(pathname, buffer)) U_RETURN(true);
 
-      U_INTERNAL_DUMP("dirname = %V", filename->rep)
-      }
+   U_RETURN(false);
+}
 
-   // insert/fetch/remove into table of docs name
+bool UPosting::mergeSegment(UVector<UString>& vpathname)
+{
+   U_TRACE(5, "UPosting::mergeSegment(%p)", &vpathname)
 
-   setDocID(true);
+   U_INTERNAL_ASSERT_POINTER(tbl_name)
+   U_INTERNAL_ASSERT_EQUALS(tbl_name->size(), 0)
 
-   if (tbl_name)
+   UString key, entry;
+   UVector<UString> vdata, vvalue;
+   const u_segment_header* h;
+   uint64_t total = 0;
+   uint32_t i, k, t, n = vpathname.size();
+   u_segment_cursor* vc = (u_segment_cursor*) UMemoryPool::cmalloc(n, sizeof(u_segment_cursor));
+   bool result = false;
+
+   for (i = 0; i < n; ++i)
       {
-      tbl_name->insert(*str_cur_doc_id, *filename);
+      vdata.push_back(UFile::contentOf(vpathname[i]));
 
-      tbl_name_space += str_cur_doc_id->size() + filename->size();
+      if (vdata[i].size() < sizeof(u_segment_header)) goto end;
+
+      h = (const u_segment_header*)vdata[i].data();
+
+      num_byte  += h->num_byte;
+      num_doc   += h->num_doc;
+      vc[i].ptr  = vdata[i].data() + sizeof(u_segment_header);
+
+      U_MEMCPY(vc[i].nrecord, h->nrecord, sizeof(h->nrecord));
       }
-   else
-      {
-      int result = 0;
 
-      if (op == 0) result = ((URDB*)cdb_names)->store( *str_cur_doc_id, *filename, RDB_INSERT); // add
-      if (op == 2) result = ((URDB*)cdb_names)->remove(*str_cur_doc_id);                        // del
+   for (t = 0; t < 3; ++t)
+      {
+      segment_ignore_case = (t == 2 && ignore_case);
 
-      if (result != 0)
+      while (true)
          {
-         U_ERROR("setDocID(%d): error<%d> for operation<%d> on DocID database", op, result, op);
-         }
+         // k-way merge: the segment with the min key...
 
-      if (op == 1) // sub
-         {
-         if (((URDB*)cdb_names)->find(*str_cur_doc_id) == false)
+         for (i = 0, k = U_NOT_FOUND; i < n; ++i)
             {
-            U_ERROR("setDocID(%d): cannot find DocID<%llu> on names database", op, cur_doc_id);
+            if (vc[i].nrecord[t] &&
+                (k == U_NOT_FOUND ||
+                 u_compare_key(U_RECORD_KEY(vc+i), U_RECORD_KLEN(vc+i), U_RECORD_KEY(vc+k), U_RECORD_KLEN(vc+k)) < 0))
+               {
+               k = i;
+               }
             }
 
-         // SUBSTITUTE: we find all reference for this document in the words database and erase it...
-
-         U_INTERNAL_ASSERT_POINTER(cdb_words)
-
-         ((URDB*)cdb_words)->callForAllEntryWithPattern(substitute, U_NULLPTR);
-         }
-      else if (op == 3) // check
-         {
-         // CHECK: we find all reference for this document in the words database and check it...
+         if (k == U_NOT_FOUND) break;
 
-         U_INTERNAL_ASSERT_POINTER(cdb_words)
+         key = UString((void*)U_RECORD_KEY(vc+k), U_RECORD_KLEN(vc+k));
 
-         cdb_words->callForAllEntryWithPattern(checkDocument, U_NULLPTR);
-         }
-      }
-}
+         vvalue.clear();
 
-// PROCESSING MISC (QUERY)
+         for (i = k; i < n; ++i) // ...and all the segments with the same key
+            {
+            if (vc[i].nrecord[t] &&
+                u_compare_key(U_RECORD_KEY(vc+i), U_RECORD_KLEN(vc+i), U_STRING_TO_PARAM(key)) == 0)
+               {
+               vvalue.push_back(UString((void*)U_RECORD_DATA(vc+i), U_RECORD_DLEN(vc+i)));
 
-void UPosting::callForPosting(vPF function)
-{
-   U_TRACE(5, "UPosting::callForPosting(%p)", function)
+               vc[i].ptr += sizeof(uint32_t) + sizeof(uint32_t) + U_RECORD_KLEN(vc+i) + U_RECORD_DLEN(vc+i);
 
-   U_INTERNAL_ASSERT(*posting)
-   U_INTERNAL_ASSERT_POINTER(function)
+               --vc[i].nrecord[t];
+               }
+            }
 
-   data      = posting->data();
-   ptr       = data + sizeof(uint32_t);
-   char* end = (char*) posting->pend();
+         if (t == 0) // names
+            {
+            tbl_name->insert(key, vvalue[0]);
 
-   do {
-      word_freq  = POSTING32(ptr,word_freq);
-      size_entry = POSTING_SIZE(ptr);
-      cur_doc_id = POSTING64(ptr,doc_id);
+            tbl_name_space += key.size() + vvalue[0].size();
+            }
+         else if (t == 1) // stats
+            {
+            if (key.equal(u_stats_total, sizeof(uint64_t)) == false)
+               {
+               tbl_stats->insert(key, vvalue[0]);
 
-      U_INTERNAL_DUMP("word_freq  = %u",   word_freq)
-      U_INTERNAL_DUMP("size_entry = %u",   size_entry)
-      U_INTERNAL_DUMP("cur_doc_id = %llu", cur_doc_id)
+               tbl_stats_space += key.size() + vvalue[0].size();
+               }
+            else
+               {
+               for (i = 0; i < vvalue.size(); ++i) total += u_get_unalignedp64(vvalue[i].data());
+               }
+            }
+         else // words
+            {
+            if (vvalue.size() == 1) entry = vvalue[0];
+            else
+               {
+               // NB: the DocID of the segments are disjoint, we concatenate the entries and after we encode them (sorted by DocID)...
 
-      function();
+               entry.clear();
 
-      ptr += size_entry;
-      }
-   while (ptr < end);
+               for (i = 0; i < vvalue.size(); ++i) appendEntry(entry, vvalue[i], U_NULLPTR, 0);
 
-   U_INTERNAL_ASSERT_EQUALS(ptr - data, (ptrdiff_t)posting->size())
-}
+               setEntry(entry);
 
-U_NO_EXPORT void UPosting::setFilename()
-{
-   U_TRACE(5, "UPosting::setFilename()")
+               entry = *posting;
+               }
 
-   U_INTERNAL_ASSERT(*str_cur_doc_id)
-   U_INTERNAL_ASSERT_POINTER(cdb_names)
+            tbl_words->insert(key, entry);
 
-   *filename = (*cdb_names)[str_cur_doc_id->rep];
+            tbl_words_space += key.size() + entry.size();
+            }
+         }
+      }
 
-   if (filename->empty())
+   if (total)
       {
-      U_ERROR("setFilename(): cannot find document name from DocID<%llu> reference for word<%v> on index database", cur_doc_id, word->rep);
+      tbl_stats->insert(UString((void*)u_stats_total, sizeof(uint64_t)), UString((void*)&total, sizeof(uint64_t)));
+
+      tbl_stats_space += sizeof(uint64_t) + sizeof(uint64_t);
       }
-}
 
-U_NO_EXPORT void UPosting::callForPostingAndSetFilename()
-{
-   U_TRACE(5, "UPosting::callForPostingAndSetFilename()")
+   posting->clear();
 
-   str_cur_doc_id->setFromInode(&cur_doc_id);
+   result = true;
 
-   setFilename();
+end:
+   UMemoryPool::_free(vc, n, sizeof(u_segment_cursor));
 
-   if (pfunction) pfunction();
+   U_RETURN(result);
 }
 
-void UPosting::callForPostingAndSetFilename(vPF function)
-{
-   U_TRACE(5, "UPosting::callForPostingAndSetFilename(%p)", function)
+// DELTA SEGMENT (update): the DocID changed by update are removed from the posting of the index and the entries of the delta are added
+
+static const uint64_t* vskip;
+static uint32_t nskip;
+static uint64_t delta_total;
+static iPFprpr delta_function;
+static UHashMap<UString>* tbl_delta; // NB: the table in memory for loadDeltaEntry() and mergeEntry()...
 
-   pfunction = function;
+static inline bool u_find_doc_id(const uint64_t* v, uint32_t n, uint64_t doc_id)
+{
+   uint32_t i = u_lower_bound(v, 0, n, doc_id);
 
-   callForPosting(callForPostingAndSetFilename);
+   return (i < n && v[i] == doc_id);
 }
 
-U_NO_EXPORT bool UPosting::setVectorCompositeWord()
+U_NO_EXPORT void UPosting::appendEntry(UString& entry, const UString& value, const uint64_t* vdoc, uint32_t ndoc)
 {
-   U_TRACE(5, "UPosting::setVectorCompositeWord()")
+   U_TRACE(5, "UPosting::appendEntry(%u,%u,%p,%u)", entry.size(), value.size(), vdoc, ndoc)
 
-   U_INTERNAL_ASSERT(*word)
-   U_INTERNAL_ASSERT_POINTER(cdb_words)
-   U_INTERNAL_ASSERT_EQUALS(vec_sub_word,U_NULLPTR)
-   U_INTERNAL_ASSERT_EQUALS(vec_sub_word_posting,U_NULLPTR)
+   // NB: the entries of the posting without the DocID of vdoc (sorted vector) are added to entry (format in memory)...
 
-   U_NEW_STRING(sub_word, UString);
-   U_NEW(UVector<UString>, vec_sub_word, UVector<UString>(*word));
-   U_NEW(UVector<UString>, vec_sub_word_posting, UVector<UString>);
+   *posting = value;
 
-   vec_sub_word_size = vec_sub_word->size();
+   (void) decompress(); // NB: the entries in the format in memory...
 
-   for (uint32_t i = 0; i < vec_sub_word_size; ++i)
+   if (posting->size() <= sizeof(uint32_t)) return;
+
+   if (entry.empty())
       {
-      *sub_word = (*vec_sub_word)[i];
+      entry.setBuffer(posting->size());
 
-      U_INTERNAL_DUMP("sub_word = %V", sub_word->rep)
+      entry.size_adjust(sizeof(uint32_t));
+      }
 
-      if (sub_word->size() < min_word_size)
-         {
-         vec_sub_word_posting->push_back(UString::getStringNull());
+   uint32_t sz, off;
+   const char* p   = posting->data() + sizeof(uint32_t);
+   const char* end = posting->pend();
+
+   for (; p < end; p += sz)
+      {
+      sz = POSTING_SIZE(p);
 
+      if (ndoc &&
+          u_find_doc_id(vdoc, ndoc, POSTING64(p,doc_id)))
+         {
          continue;
          }
 
-      readPosting(sub_word->rep, false);
+      off = entry.size();
 
-      if (posting->empty())
-         {
-         resetVectorCompositeWord();
-
-         U_RETURN(false);
-         }
+      (void) entry.append(p, sz);
 
-      vec_sub_word_posting->push_back(*posting);
+      u_put_unalignedp32(entry.data(), off); // offset last DOC id
       }
+}
 
-   U_RETURN(true);
+U_NO_EXPORT void UPosting::setEntry(UString& entry)
+{
+   U_TRACE(5, "UPosting::setEntry(%u)", entry.size())
+
+   // NB: the posting in block format (empty if there is no entry)...
+
+   if (entry.size() <= sizeof(uint32_t)) posting->clear();
+   else
+      {
+      *posting = entry;
+
+      encode();
+      }
 }
 
-inline bool UPosting::setSubWord(uint32_t i)
+U_NO_EXPORT void UPosting::applyDelta(UStringRep* word_rep)
 {
-   U_TRACE(5, "UPosting::setSubWord(%u)", i)
+   U_TRACE(5, "UPosting::applyDelta(%V)", word_rep)
 
-   U_INTERNAL_ASSERT_POINTER(sub_word)
-   U_INTERNAL_ASSERT_POINTER(vec_sub_word)
+   if (vdelta == U_NULLPTR) return;
 
-   *sub_word      = (*vec_sub_word)[i];
-    sub_word_size = sub_word->size();
+   UString value;
 
-   U_INTERNAL_DUMP("sub_word = %V", sub_word->rep)
+   if (cdb_delta_words) value = (*cdb_delta_words)[word_rep];
 
-   if (sub_word_size < min_word_size)
+   setBlock();
+
+   if (value ||
+       (*posting &&
+        u_find_doc_id(posting->data(), *vdelta)))
       {
-      sub_word_pos_prev += 1 + sub_word_size;
+      UString entry, x = *posting;
 
-      U_RETURN(false);
+      appendEntry(entry, x, (const uint64_t*)vdelta->data(), vdelta->size() / sizeof(uint64_t));
+      appendEntry(entry, value, U_NULLPTR, 0);
+
+      setEntry(entry);
       }
+}
 
-   U_INTERNAL_DUMP("sub_word_pos_prev = %u", sub_word_pos_prev)
+U_NO_EXPORT UString UPosting::getValuesWithKeyNask()
+{
+   U_TRACE_NO_PARAM(5, "UPosting::getValuesWithKeyNask()")
 
-   *posting = (*vec_sub_word_posting)[i];
+   U_INTERNAL_ASSERT_POINTER(vec_entry)
 
-   U_INTERNAL_ASSERT(*posting)
+   UString result;
 
-   U_RETURN(true);
+   vec_entry->clear();
+
+   (void) cdb_words->getValuesWithKeyNask(*vec_entry, *word, &size_entry);
+
+   uint32_t n = vec_entry->size();
+
+   if (cdb_delta_words) (void) cdb_delta_words->getValuesWithKeyNask(*vec_entry, *word, &size_entry);
+
+   if (vec_entry->size()) result = extractDocID(n);
+
+   U_RETURN_STRING(result);
 }
 
-inline UString UPosting::extractDocID()
+U_NO_EXPORT int UPosting::addDeltaDocID(UStringRep* doc_id, UStringRep* doc_name)
 {
-   U_TRACE(5, "UPosting::extractDocID()")
+   U_TRACE(5, "UPosting::addDeltaDocID(%#V,%V)", doc_id, doc_name)
 
-   /**
-    * +------+--------------------+--------+-----------+-------+-----+-------+-----+--------+-----------+-------+-----+-------+
-    * | WORD | offset last DOC id | DOC id | frequency | pos 1 | ... | pos n | ... | DOC id | frequency | pos 1 | ... | pos n |
-    * +------+--------------------+--------+-----------+-------+-----+-------+-----+--------+-----------+-------+-----+-------+
-    */
+   (void) vdelta->append(doc_id->data(), sizeof(uint64_t));
 
-   UStringRep* r;
-   UString s(size_entry);
+   U_RETURN(1);
+}
 
-   char* sdata = s.data();
-   char* sptr  = sdata;
+void UPosting::initDelta()
+{
+   U_TRACE_NO_PARAM(5, "UPosting::initDelta()")
 
-   for (uint32_t i = 0, n = vec_entry->size(); i < n; ++i)
+   if (cdb_delta_names == U_NULLPTR)
       {
-      r = vec_entry->UVector<UStringRep*>::at(i);
+      if (vdelta)
+         {
+         U_DELETE(vdelta)
 
-#  ifdef U_COMPRESS_ENTRY
-      posting->_assign(r);
+         vdelta = U_NULLPTR;
+         }
 
-      if (decompress()) r = posting->rep;
-#  endif
+      return;
+      }
 
-      data      = r->data();
-      ptr       = data + sizeof(uint32_t);
-      char* end = r->pend();
+   if (vdelta == U_NULLPTR) U_NEW_STRING(vdelta, UString);
 
-      do {
-         size_entry = POSTING_SIZE(ptr);
-         cur_doc_id = POSTING64(ptr,doc_id);
+   vdelta->setBuffer(cdb_delta_names->size() * sizeof(uint64_t));
 
-         U_INTERNAL_DUMP("word_freq  = %u",   POSTING32(ptr,word_freq))
-         U_INTERNAL_DUMP("size_entry = %u",   size_entry)
-         U_INTERNAL_DUMP("cur_doc_id = %llu", cur_doc_id)
+   cdb_delta_names->callForAllEntryWithPattern(addDeltaDocID, U_NULLPTR);
 
-         U_MEMCPY((void*)sptr, &cur_doc_id, sizeof(cur_doc_id));
+   vdelta->size_adjust(u_sort_doc_id((uint64_t*)vdelta->data(), vdelta->size() / sizeof(uint64_t)) * sizeof(uint64_t));
 
-          ptr += size_entry;
-         sptr += sizeof(uint64_t);
-         }
-      while (ptr < end);
+   U_INTERNAL_DUMP("num doc delta = %u", vdelta->size() / sizeof(uint64_t))
+}
 
-      U_INTERNAL_ASSERT_EQUALS(ptr - data, (ptrdiff_t)r->size())
-      }
+U_NO_EXPORT int UPosting::callForDocName(UStringRep* doc_id, UStringRep* doc_name)
+{
+   U_TRACE(5, "UPosting::callForDocName(%#V,%V)", doc_id, doc_name)
 
-   s.size_adjust_force(sptr - sdata);
+   if (u_find_doc_id((const uint64_t*)vdelta->data(), vdelta->size() / sizeof(uint64_t), u_get_unalignedp64(doc_id->data()))) U_RETURN(1);
 
-   U_RETURN_STRING(s);
+   return delta_function(doc_id, doc_name);
 }
 
-/**
- * ------------------------------------------------
- * findDocID() is be called from:
- * ------------------------------------------------
- * UQueryParser::evaluate() (loop for all doc name)
- * ------------------------------------------------
- */
-
-bool UPosting::findDocID(UStringRep* word_rep)
+U_NO_EXPORT int UPosting::callForDeltaDocName(UStringRep* doc_id, UStringRep* doc_name)
 {
-   U_TRACE(5, "UPosting::findDocID(%V)", word_rep)
+   U_TRACE(5, "UPosting::callForDeltaDocName(%#V,%V)", doc_id, doc_name)
 
-   U_INTERNAL_ASSERT(*str_cur_doc_id)
-   U_INTERNAL_ASSERT_POINTER(cdb_words)
+   if (doc_name->size() == 0) U_RETURN(1); // NB: tombstone (document deleted)...
 
-   // manage meta expr, composite word, etc. for all doc name... (save info with property)
+   return delta_function(doc_id, doc_name);
+}
 
-   uint32_t i;
+void UPosting::callForAllDocName(iPFprpr function)
+{
+   U_TRACE(5, "UPosting::callForAllDocName(%p)", function)
 
-   word->_assign(word_rep);
+   U_INTERNAL_ASSERT_POINTER(cdb_names)
 
-   if (vec_word) i = vec_word->find(*word);
-   else
+   if (vdelta == U_NULLPTR)
       {
-      // allocation property...
-
-      i = U_NOT_FOUND;
+      cdb_names->callForAllEntryWithPattern(function, U_NULLPTR);
 
-      U_NEW(UVector<UString>, vec_word, UVector<UString>(32));
-      U_NEW(UVector<UString>, vec_entry, UVector<UString>(approximate_num_words));
-      U_NEW(UVector<UString>, vec_posting, UVector<UString>(32));
+      return;
       }
 
-   // check if exist property for this word...
+   delta_function = function;
 
-   if (i == U_NOT_FOUND)
-      {
-      // set property for this word...
+         cdb_names->callForAllEntryWithPattern(callForDocName,      U_NULLPTR);
+   cdb_delta_names->callForAllEntryWithPattern(callForDeltaDocName, U_NULLPTR);
+}
 
-      i = vec_word->size();
+U_NO_EXPORT int UPosting::callForDeltaWord(UStringRep* word_rep, UStringRep* value)
+{
+   U_TRACE(5, "UPosting::callForDeltaWord(%V,%p)", word_rep, value)
 
-      vec_word->push_back(*word);
+   if (cdb_words->find(UString(word_rep))) U_RETURN(1); // NB: already done with the words of the index...
 
-      if (word_rep->isQuoted('"'))
-         {
-         property[i].is_meta   = false;
-         property[i].is_quoted = true;
-         }
-      else if (word->find_first_of("?*", 0, 2) != U_NOT_FOUND)
-         {
-         property[i].is_meta   = true;
-         property[i].is_quoted = false;
-         }
-      else
-         {
-         property[i].is_meta = property[i].is_quoted = false;
-         }
-      }
+   return delta_function(word_rep, UString::getStringNull().rep);
+}
 
-   // find context with property...
+void UPosting::callForAllWord(iPFprpr function)
+{
+   U_TRACE(5, "UPosting::callForAllWord(%p)", function)
 
-   if (property[i].is_quoted)
-      {
-      // context composite word...
+   U_INTERNAL_ASSERT_POINTER(cdb_words)
 
-      static UStringRep* last_word_rep;
+   cdb_words->callForAllEntryWithPattern(function, U_NULLPTR);
 
-      if (word_rep != last_word_rep)
-         {
-         last_word_rep = word_rep;
+   if (cdb_delta_words)
+      {
+      delta_function = function;
 
-         if (vec_sub_word) resetVectorCompositeWord();
-         }
+      cdb_delta_words->callForAllEntryWithPattern(callForDeltaWord, U_NULLPTR);
+      }
+}
 
-      if (callForCompositeWord(U_NULLPTR)) U_RETURN(true);
+void UPosting::setDeleted()
+{
+   U_TRACE_NO_PARAM(5, "UPosting::setDeleted()")
 
-      U_RETURN(false);
-      }
+   U_INTERNAL_ASSERT(*str_cur_doc_id)
+   U_INTERNAL_ASSERT_POINTER(tbl_name)
+   U_INTERNAL_ASSERT_POINTER(cdb_names)
 
-   if (property[i].is_meta)
+   // NB: the tombstone (DocID with empty name) remove the document of the index until the merge of the delta...
+
+   if ((*cdb_names)[str_cur_doc_id->rep])
       {
-      // context meta word...
+      tbl_name->insert(*str_cur_doc_id, UString::getStringNull());
 
-      UString entry;
+      tbl_name_space += str_cur_doc_id->size();
+      }
+}
 
-      if (i < vec_posting->size()) entry = (*vec_posting)[i];
-      else
-         {
-         vec_entry->clear();
+U_NO_EXPORT int UPosting::loadDeltaEntry(UStringRep* key, UStringRep* value)
+{
+   U_TRACE(5, "UPosting::loadDeltaEntry(%V,%p)", key, value)
 
-         if (cdb_words->getValuesWithKeyNask(*vec_entry, *word, &size_entry)) entry = extractDocID();
+   if (tbl_delta == tbl_words)
+      {
+      UString entry;
 
-         vec_posting->push_back(entry);
-         }
+      appendEntry(entry, UString(value), vskip, nskip); // NB: the format in memory, update add the entries of the documents...
 
-      if (entry &&
-          u_find(entry.data(), entry.size(), ptr_cur_doc_id, sizeof(cur_doc_id)))
+      if (entry.size() > sizeof(uint32_t))
          {
-         U_RETURN(true);
-         }
+         tbl_words->insert(UString((void*)key->data(), key->size()), entry);
 
-      U_RETURN(false);
+         tbl_words_space += key->size() + entry.capacity();
+         }
       }
+   else if (key->size() == sizeof(uint64_t) &&
+            u_get_unalignedp64(key->data()) != 0 && // NB: the total number of words of the documents...
+            u_find_doc_id(vskip, nskip, u_get_unalignedp64(key->data())) == false)
+      {
+      tbl_delta->insert(UString((void*)key->data(), key->size()), UString((void*)value->data(), value->size()));
 
-   // context single word...
-
-   if (setPosting(true)) U_RETURN(true);
+      (tbl_delta == tbl_name ? tbl_name_space : tbl_stats_space) += key->size() + value->size();
+      }
 
-   U_RETURN(false);
+   U_RETURN(1);
 }
 
-void UPosting::callForPosting(vPF function, bool is_space)
+void UPosting::loadDelta(UString& vdoc)
 {
-   U_TRACE(5, "UPosting::callForPosting(%p,%b)", function, is_space)
+   U_TRACE(5, "UPosting::loadDelta(%u)", vdoc.size())
 
-   U_INTERNAL_ASSERT(*word)
-   U_INTERNAL_ASSERT_POINTER(cdb_words)
+   U_INTERNAL_ASSERT_POINTER(tbl_name)
 
-   if (is_space) // composite word
-      {
-      // check for NEAR operation (string not quoted)...
+   if (cdb_delta_names == U_NULLPTR) return;
 
-      bool is_quoted = word->isQuoted();
+   vdoc.size_adjust(u_sort_doc_id((uint64_t*)vdoc.data(), vdoc.size() / sizeof(uint64_t)) * sizeof(uint64_t));
 
-      U_INTERNAL_DUMP("is_quoted = %b", is_quoted)
+   vskip = (const uint64_t*)vdoc.data();
+   nskip = vdoc.size() / sizeof(uint64_t);
 
-      if (is_quoted == false) max_distance = ((uint32_t)-1);
+   tbl_delta = tbl_name;
+
+   cdb_delta_names->callForAllEntryWithPattern(loadDeltaEntry, U_NULLPTR);
+
+   if (cdb_delta_stats)
+      {
+      tbl_delta = tbl_stats;
 
-      (void) callForCompositeWord(function);
+      cdb_delta_stats->callForAllEntryWithPattern(loadDeltaEntry, U_NULLPTR);
       }
-   else // single word
+
+   if (cdb_delta_words)
       {
-      readPosting(word->rep, false);
+      tbl_delta = tbl_words;
 
-      if (*posting) callForPostingAndSetFilename(function);
+      cdb_delta_words->callForAllEntryWithPattern(loadDeltaEntry, U_NULLPTR);
       }
-}
 
-/**
- * ------------------------------------------------
- * CONTEXT COMPOSITE WORD...
- * ------------------------------------------------
- * checkCompositeWord() may be called from:
- * ------------------------------------------------
- * UQueryParser::evaluate() (loop for all doc name)
- * callForPosting()         (for composite word)
- * ------------------------------------------------
- */
+   posting->clear();
+}
 
-U_NO_EXPORT bool UPosting::callForCompositeWord(vPF function)
+U_NO_EXPORT int UPosting::mergeEntry(UStringRep* key, UStringRep* value)
 {
-   U_TRACE(5, "UPosting::callForCompositeWord(%p)", function)
+   U_TRACE(5, "UPosting::mergeEntry(%V,%p)", key, value)
 
-   U_INTERNAL_ASSERT_POINTER(cdb_names)
+   UString k((void*)key->data(), key->size()), data((void*)value->data(), value->size());
 
-   if (vec_sub_word == U_NULLPTR &&
-       setVectorCompositeWord() == false)
+   if (tbl_delta != tbl_words)
       {
-      U_RETURN(false);
-      }
+      if (key->size() != sizeof(uint64_t)           ||
+          u_get_unalignedp64(key->data()) == 0      || // NB: the total number of words of the documents is computed again...
+          data.empty()                              || // NB: tombstone (document deleted)...
+          (nskip &&
+           u_find_doc_id(vskip, nskip, u_get_unalignedp64(key->data()))))
+         {
+         U_RETURN(1);
+         }
 
-   // find the first sub-word util
+      if (tbl_delta == tbl_name) tbl_name_space += k.size() + data.size();
+      else
+         {
+         tbl_stats_space += k.size() + data.size();
 
-   uint32_t first_subword_index;
+         if (data.size() == sizeof(uint32_t)) delta_total += u_get_unalignedp32(data.data());
+         }
 
-   for (first_subword_index = 0; first_subword_index < vec_sub_word_size; ++first_subword_index)
-      {
-      if (setSubWord(first_subword_index) == false) continue;
+      tbl_delta->insert(k, data);
 
-      break;
+      U_RETURN(1);
       }
 
-   U_INTERNAL_DUMP("FIRST subword util  = %.*S", U_STRING_TO_TRACE(*sub_word))
-   U_INTERNAL_DUMP("first_subword_index = %u", first_subword_index)
-
-   U_INTERNAL_ASSERT(*posting)
+   if (nskip) // the words of the index...
+      {
+      *posting = data;
 
-#if defined(DEBUG) || defined(U_TEST)
-   uint32_t posting_size = posting->size();
-#endif
+      setBlock();
 
-   bool match;
-   char* ptr1;
-   char* end1 = U_NULLPTR;
-   int32_t i, first_subword_freq;
-   uint32_t j, k, sz = sub_word_size;
+      if (u_find_doc_id(posting->data(), *vdelta))
+         {
+         UString entry, x = *posting;
 
-   // loop for all posting entry of the first sub-word util
-   // ---------------------------------------------------------------------------------------------------------------
-   // immatricolazione (-261845,1,1148)(-261811,1,2024)(-261819,4,2037,2624,4075,4567)(-261832,4,2037,2624,4479,4971)
-   // ---------------------------------------------------------------------------------------------------------------
+         appendEntry(entry, x, vskip, nskip);
 
-   if (function == U_NULLPTR)
-      {
-      if (setPosting(false) == false) U_RETURN(false);
+         setEntry(entry);
 
-      ptr1 = ptr;
+         if (posting->empty()) U_RETURN(1);
+         }
 
-      goto start;
+      data = *posting;
       }
+   else if (tbl_words->find(k)) // the words of the delta segment, also in the index...
+      {
+      UString entry, x(tbl_words->elem());
 
-   data = posting->data();
-   ptr1 = data + sizeof(uint32_t);
-   end1 = (char*) posting->pend();
-
-   do {
-      ptr        = ptr1;
-      cur_doc_id = POSTING64(ptr,doc_id);
-      size_entry = POSTING_SIZE(ptr);
-
-      U_INTERNAL_DUMP("cur_doc_id          = %llu", cur_doc_id)
-      U_INTERNAL_DUMP("size_entry          = %u",   size_entry)
+      appendEntry(entry, x,    U_NULLPTR, 0);
+      appendEntry(entry, data, U_NULLPTR, 0);
 
-      setDocID(false);
+      setEntry(entry);
 
-start:
-      first_subword_freq = POSTING32(ptr,word_freq);
+      tbl_words_space += posting->size() - x.size();
 
-      U_INTERNAL_DUMP("first_subword_freq  = %u", first_subword_freq)
+      tbl_words->insert(k, *posting); // NB: the decode can use the lookup of the hash map (static) in the meantime...
 
-      U_INTERNAL_ASSERT_MAJOR(first_subword_freq, 0)
+      U_RETURN(1);
+      }
 
-      i     = -1;
-      match = false;
+   tbl_words->insert(k, data);
 
-      // loop for all the position of first sub-word util for this document...
+   tbl_words_space += k.size() + data.size();
 
-loop1:
-      while (++i < first_subword_freq)
-         {
-         ptr               = ptr1;
-         pos               = POSTING_POS(i);
-         sub_word_pos_prev = pos + sz;
+   U_RETURN(1);
+}
 
-         U_INTERNAL_DUMP("pos[%3u]           = %u", i, pos)
-         U_INTERNAL_DUMP("sub_word_pos_prev  = %u", sub_word_pos_prev)
+void UPosting::mergeDelta()
+{
+   U_TRACE_NO_PARAM(5, "UPosting::mergeDelta()")
 
-         // check if the other sub-word match in the current doc...
+   U_INTERNAL_ASSERT_POINTER(vdelta)
+   U_INTERNAL_ASSERT_POINTER(tbl_name)
+   U_INTERNAL_ASSERT_POINTER(cdb_delta_names)
 
-         for (j = first_subword_index + 1; j < vec_sub_word_size; ++j)
-            {
-            if (setSubWord(j) == false) continue;
+   // NB: the tables in memory can have the delta segment yet (UCDB::writeTo() don't erase the entries)...
 
-            if (setPosting(false) == false) goto loop1;
+   tbl_name->clear();
+   tbl_stats->clear();
+   tbl_words->clear();
 
-            U_INTERNAL_DUMP("subword            = %.*S", U_STRING_TO_TRACE(*sub_word))
+   tbl_name_space  =
+   tbl_stats_space =
+   tbl_words_space = 0;
+   delta_total     = 0;
 
-            U_INTERNAL_ASSERT_EQUALS(cur_doc_id, POSTING64(ptr,doc_id))
+   // the index without the DocID of the delta segment...
 
-            word_freq = POSTING32(ptr,word_freq);
+   vskip = (const uint64_t*)vdelta->data();
+   nskip = vdelta->size() / sizeof(uint64_t);
 
-            U_INTERNAL_DUMP("word_freq          = %u", word_freq)
+   tbl_delta = tbl_name;
 
-            U_INTERNAL_ASSERT_MAJOR(word_freq, 0)
+   cdb_names->callForAllEntryWithPattern(mergeEntry, U_NULLPTR);
 
-            // check for all position for this sub-word in the current doc...
+   if (cdb_stats->isMapped())
+      {
+      tbl_delta = tbl_stats;
 
-            for (k = 0; k < word_freq; ++k)
-               {
-               pos      = POSTING_POS(k);
-               distance = pos - sub_word_pos_prev;
+      cdb_stats->callForAllEntryWithPattern(mergeEntry, U_NULLPTR);
+      }
 
-               U_INTERNAL_DUMP("pos[%3u]           = %u", k, pos)
-               U_INTERNAL_DUMP("sub_word_pos_prev  = %u", sub_word_pos_prev)
-               U_INTERNAL_DUMP("distance           = %u", distance)
-               U_INTERNAL_DUMP("max_distance       = %u", max_distance)
+   tbl_delta = tbl_words;
 
-               if (distance <= max_distance) break;
-               }
+   cdb_words->callForAllEntryWithPattern(mergeEntry, U_NULLPTR);
 
-            if (k == word_freq) goto loop1; // NOT match, go to another position for the first sub-word util...
+   // ...and the delta segment (without the tombstone)
 
-            sub_word_pos_prev = pos + sub_word_size;
-            }
+   nskip     = 0;
+   tbl_delta = tbl_name;
 
-         match = true;
-         }
+   cdb_delta_names->callForAllEntryWithPattern(mergeEntry, U_NULLPTR);
 
-      U_INTERNAL_ASSERT_EQUALS(i, first_subword_freq)
+   if (cdb_delta_stats)
+      {
+      tbl_delta = tbl_stats;
 
-      if (function == U_NULLPTR) U_RETURN(match);
+      cdb_delta_stats->callForAllEntryWithPattern(mergeEntry, U_NULLPTR);
+      }
 
-      if (match)
-         {
-         setFilename();
+   if (cdb_delta_words)
+      {
+      tbl_delta = tbl_words;
 
-         word_freq = (max_distance == ((uint32_t)-1) // check for NEAR...
-                              ? 0
-                              : max_distance - distance);
+      cdb_delta_words->callForAllEntryWithPattern(mergeEntry, U_NULLPTR);
+      }
 
-         function();
-         }
+   if (delta_total)
+      {
+      tbl_stats->insert(UString((void*)u_stats_total, sizeof(uint64_t)), UString((void*)&delta_total, sizeof(uint64_t)));
 
-      ptr1 += size_entry;
+      tbl_stats_space += sizeof(uint64_t) + sizeof(uint64_t);
       }
-   while (ptr1 < end1);
 
-   U_INTERNAL_ASSERT_EQUALS(ptr1 - data, (ptrdiff_t)posting_size)
-
-   U_RETURN(true);
+   posting->clear();
 }
 
 // PRINT DATABASE
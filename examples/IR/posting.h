@@ -10,10 +10,29 @@
 template <class T> class UVector;
 template <class T> class UHashMap;
 
+struct u_posting_term;
+struct u_posting_cursor;
+
 /**
  * +------+--------------------+--------+-----------+-------+-----+-------+-----+--------+-----------+-------+-----+-------+
  * | WORD | offset last DOC id | DOC id | frequency | pos 1 | ... | pos n | ... | DOC id | frequency | pos 1 | ... | pos n |
  * +------+--------------------+--------+-----------+-------+-----+-------+-----+--------+-----------+-------+-----+-------+
+ *
+ * this is the format in memory (index and update), on database the posting is stored sorted by DOC id in blocks of 128 entry:
+ *
+ * +------+------------------------+-----------------------------------+---------+-----+---------+
+ * | WORD | 0x80000000 | num DOC id | skip table (last DOC id, offset)  | block 1 | ... | block n |
+ * +------+------------------------+-----------------------------------+---------+-----+---------+
+ *
+ * where every block is: delta DOC id (varint) | frequency (varint) | delta pos (varint), and the skip table
+ * (with also the max frequency of every block for Block-Max WAND) is present only with more than one block...
+ *
+ * the number of words of every document (and the total) for the ranking with BM25 is stored in tbl_stats...
+ *
+ * index1 can build the index with more worker processes: every worker index a part of the documents and write its tables
+ * in a segment (records sorted by key), then the segments are merged (k-way) in the tables of the index. update write
+ * the changes in a delta segment (the tables tbl_*.delta.cdb) that the queries consult over the index (the DocID changed
+ * by the delta are removed from the posting of the index) until it is merged in the index (update -m)...
  */
 
 class U_EXPORT UPosting {
@@ -41,8 +60,10 @@ public:
    static UString* str_cur_doc_id;
    static UHashMap<UString>* tbl_name;
    static UHashMap<UString>* tbl_words;
+   static UHashMap<UString>* tbl_stats;
+   static uint64_t num_byte;
    static bool ignore_case, dir_content_as_doc, change_dir;
-   static uint32_t word_freq, tbl_name_space, tbl_words_space, min_word_size, max_distance, pos_start;
+   static uint32_t num_doc, word_freq, tbl_name_space, tbl_words_space, tbl_stats_space, min_word_size, max_distance, pos_start, doc_length, top_k, num_match;
 
    // COSTRUTTORE
 
@@ -52,6 +73,7 @@ public:
    // SERVICES
 
    static void reset();
+   static void setIndex(uint32_t dimension); // the tables in memory of the index (index1 and the delta segment of update)
 
    static void setDocID(int32_t op);
 
@@ -71,11 +93,42 @@ public:
       }
 
    static void processWord(int32_t op);
+   static void setDocLength(int32_t op);
 
    // Call function for all/one entry
 
    static void printDB(ostream& os);
    static bool findDocID(UStringRep* word_rep);
+   static void assignPosting(UStringRep* value, UStringRep* word_rep = U_NULLPTR); // with word_rep the posting is merged with the delta segment
+
+   static void callForAllWord(   iPFprpr function); // the words     of the index and of the delta segment (value empty for a word only in the delta)
+   static void callForAllDocName(iPFprpr function); // the documents of the index and of the delta segment
+
+   static void encodeAllEntry();
+
+   // Segment (parallel index): the tables in memory sorted by key, the merge (k-way) of the segments in the tables in memory
+
+   static bool writeSegment(const UString& pathname);
+   static bool mergeSegment(UVector<UString>& vpathname);
+
+   // Delta segment: initDelta() for the queries, loadDelta() load the delta without the DocID (vector of uint64_t, sorted here) changed by update,
+   // setDeleted() register the delete of the current document, mergeDelta() merge the delta with the index in the tables in memory
+
+   static void initDelta();
+   static void loadDelta(UString& vdoc);
+   static void setDeleted();
+   static void mergeDelta();
+
+   // Set of DocID (sorted vector of uint64_t) for a term of the disjunctive normal form (AND of the positives, NOT of the negatives)
+
+   static UString getDocID(UVector<UString>* positives, UVector<UString>* negatives);
+   static UString unionDocID(const UString& x, const UString& y);
+
+   // Ranking with BM25: the function is called for the best top_k results (0 -> all) in order of score (word_freq is the weight),
+   // num_match is the number of document that match (an estimate with WAND if the results are top_k)
+
+   static void callForWAND(UVector<UString>& vword, vPF function); // disjunction of words (Block-Max WAND)
+   static void callForDocID(const UString& vdoc, UVector<UString>& vword, vPF function); // set of DocID
 
    static void checkAllEntry();
    static void callForPosting(vPF function);
@@ -104,13 +157,26 @@ protected:
 
 private:
    static inline void    init() U_NO_EXPORT;
+   static inline bool    isBlock() U_NO_EXPORT;
+   static inline void    setBlock() U_NO_EXPORT;
    static inline bool    decompress() U_NO_EXPORT;
    static inline bool    isOneEntry() U_NO_EXPORT;
-   static inline UString extractDocID() U_NO_EXPORT;
+   static inline UString extractDocID(uint32_t n) U_NO_EXPORT;
    static inline bool    setSubWord(uint32_t i) U_NO_EXPORT;
    static inline void    setDocID(bool from_inode) U_NO_EXPORT;
    static inline bool    checkEntry(char* str, char* s, uint32_t n) U_NO_EXPORT;
    static       char*    find(char* s, uint32_t n, bool boptmize) U_NO_EXPORT __pure;
+   static       void     encode() U_NO_EXPORT;
+   static       void     decode() U_NO_EXPORT;
+   static       void     addHit() U_NO_EXPORT;
+   static       void     addDocID() U_NO_EXPORT;
+   static       void     applyDelta(UStringRep* word_rep) U_NO_EXPORT;
+   static       void     appendEntry(UString& entry, const UString& value, const uint64_t* vdoc, uint32_t ndoc) U_NO_EXPORT;
+   static       void     setEntry(UString& entry) U_NO_EXPORT;
+   static       UString  getValuesWithKeyNask() U_NO_EXPORT;
+   static       void     initRanking() U_NO_EXPORT;
+   static       void     callForHit(vPF function) U_NO_EXPORT;
+   static       uint32_t setTerm(u_posting_term* vterm, UVector<UString>& vword, UVector<UString>& vvalue) U_NO_EXPORT;
    static       void     add() U_NO_EXPORT; // op 0
    static       void     del() U_NO_EXPORT; // op 2
    static       void     checkWord() U_NO_EXPORT;
@@ -124,13 +190,26 @@ private:
    static       void     resetVectorCompositeWord() U_NO_EXPORT;
    static       void     callForPostingAndSetFilename() U_NO_EXPORT;
    static       bool     callForCompositeWord(vPF function) U_NO_EXPORT;
+   static       void     readBlock(UStringRep* word_rep) U_NO_EXPORT;
    static       void     readPosting(UStringRep* word_rep, bool flag) U_NO_EXPORT;
+   static       bool     matchCompositeWord(u_posting_cursor* vcursor, uint32_t first_subword_index) U_NO_EXPORT;
+   static       bool     setCursor(u_posting_cursor* c, UStringRep* word_rep, UVector<UString>& vvalue) U_NO_EXPORT;
    static       bool     findCurrentDocIdOnPosting(UStringRep* value) U_NO_EXPORT;
    static       int      print(UStringRep* word_rep, UStringRep* value) U_NO_EXPORT;
+   static       int      addDocName(UStringRep* doc_id, UStringRep* doc_name) U_NO_EXPORT;
+   static       int      encodeEntry(UStringRep* word_rep, UStringRep* value) U_NO_EXPORT;
    static       int      substitute(UStringRep* word_rep, UStringRep* value) U_NO_EXPORT;
    static       int      checkAllEntry(UStringRep* word_rep, UStringRep* value) U_NO_EXPORT;
    static       int      checkDocument(UStringRep* word_rep, UStringRep* value) U_NO_EXPORT;
    static       int      printDocName(UStringRep* doc_id, UStringRep* doc_name) U_NO_EXPORT;
+   static       int      callForDocName(UStringRep* doc_id, UStringRep* doc_name) U_NO_EXPORT;
+   static       int      callForDeltaDocName(UStringRep* doc_id, UStringRep* doc_name) U_NO_EXPORT;
+   static       int      callForDeltaWord(UStringRep* word_rep, UStringRep* value) U_NO_EXPORT;
+   static       int      addDeltaDocID(UStringRep* doc_id, UStringRep* doc_name) U_NO_EXPORT;
+   static       int      loadDeltaEntry(UStringRep* key, UStringRep* value) U_NO_EXPORT;
+   static       int      mergeEntry(UStringRep* key, UStringRep* value) U_NO_EXPORT;
+
+   friend class Application;
 
    // Forbidden operations
 
@@ -9,7 +9,8 @@
 
 #define U_OPTIONS \
 "purpose 'search in index database of document files...'\n" \
-"option c config 1 'path of configuration file' ''\n"
+"option c config 1 'path of configuration file' ''\n" \
+"option k top    1 'number of the best results to show (0 -> all)' '0'\n"
 
 #include "cquery.h"
 
@@ -61,7 +62,7 @@ public:
 
          ptr = Query::checkQuoting(argv, len);
 
-         query->run(ptr, len, U_NULLPTR);
+         query->run(ptr, len, U_NULLPTR, (UApplication::isOptions() ? opt['k'].strtoul() : 0));
 
          WeightWord::dumpObjects();
 
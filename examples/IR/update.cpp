@@ -1,5 +1,6 @@
 // update.cpp
 
+#include <ulib/process.h>
 #include <ulib/utility/dir_walk.h>
 
 #undef  PACKAGE
@@ -12,31 +13,137 @@
 "option c config     1 'path of configuration file' ''\n" \
 "option a add        1 'list of files to add to index' ''\n" \
 "option s substitute 1 'list of files to substitute in index' ''\n" \
-"option d delete     1 'path of files to delete from index' ''\n"
-
-#define U_CDB_CLASS URDB
-#define U_RDB_OPEN_WORDS 0
-#define U_RDB_OPEN_NAMES 0
+"option d delete     1 'path of files to delete from index' ''\n" \
+"option m merge      0 'merge the delta segment in the index' ''\n"
 
 #include "IR.h"
 
+/**
+ * NB: the changes are written in the delta segment (tbl_*.delta.cdb) that the queries consult over the index, when the delta segment
+ * is greater than DELTA_MAX_SIZE it is merged in the index by a background process (with the option merge now). The updates (and the
+ * merge) are serialized by the lock on the file 'delta.lock' in the location of the index db...
+ */
+
 class Application : public IR {
 public:
 
+   Application()
+      {
+      U_TRACE(5, "Application::Application()")
+
+      bmerge = false;
+      }
+
    ~Application()
       {
       U_TRACE(5, "Application::~Application()")
       }
 
+   static bool getDocID(UString filename, UString& key)
+      {
+      U_TRACE(5, "Application::getDocID(%V,%p)", filename.rep, &key)
+
+      struct stat st;
+
+      if (UFile::stat(filename.c_str(), &st) == false) U_RETURN(false);
+
+      uint64_t doc_id = - st.st_ino; // NB: the same DocID of UPosting::setDocID()...
+
+      (void) key.replace((const char*)&doc_id, sizeof(uint64_t));
+
+      U_RETURN(true);
+      }
+
+   static void addDocID(UString& vdoc, UVector<UString>& vec)
+      {
+      U_TRACE(5, "Application::addDocID(%p,%p)", &vdoc, &vec)
+
+      UString key;
+
+      for (uint32_t i = 0, n = vec.size(); i < n; ++i)
+         {
+         if (getDocID(vec[i], key)) (void) vdoc.append(key);
+         }
+      }
+
    static void parse(void* name)
       {
       U_TRACE(5, "Application::parse(%p)", name)
 
+      UString key;
+
       UPosting::filename->_assign((UStringRep*)name);
 
+      // NB: skip the documents deleted (or already processed) in this update...
+
+      if (getDocID(*UPosting::filename, key) == false ||
+          (vdel && vdel->find(key) != U_NOT_FOUND)   ||
+          UPosting::tbl_name->find(key))
+         {
+         return;
+         }
+
       IR::parse();
       }
 
+   static void del(void* name)
+      {
+      U_TRACE(5, "Application::del(%p)", name)
+
+      UString key, filename((UStringRep*)name);
+
+      if (getDocID(filename, key) == false)
+         {
+         U_WARNING("cannot find the document %V to delete from index", filename.rep);
+
+         return;
+         }
+
+      UPosting::setDocID(key.rep);
+
+      UPosting::setDeleted();
+
+      (void) UFile::_unlink(filename.c_str());
+      }
+
+   void lockDelta()
+      {
+      U_TRACE(5, "Application::lockDelta()")
+
+      if (lock.isOpen() == false &&
+          lock.creat(cfg_db + U_STRING_FROM_CONSTANT("delta.lock"), O_RDWR) == false)
+         {
+         U_ERROR("cannot create the lock file for the delta segment");
+         }
+
+      while (lock.lock() == false) UTimeVal::nanosleep(100);
+      }
+
+   bool reopenCDB()
+      {
+      U_TRACE(5, "Application::reopenCDB()")
+
+      // NB: another update can have changed the delta segment (and the index) in the meantime...
+
+      IR::closeDelta();
+
+      if (cdb_names->isMapped()) cdb_names->munmap();
+      if (cdb_words->isMapped()) cdb_words->munmap();
+      if (cdb_stats->isMapped()) cdb_stats->munmap();
+
+      if (cdb_names->open() &&
+          cdb_words->open())
+         {
+         (void) cdb_stats->open();
+
+         IR::openDelta();
+
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
    static void buildFilenameListFrom(UVector<UString>& vec, const UString& arg)
       {
       U_TRACE(5, "Application::buildFilenameListFrom(%p,%.*S)", &vec, U_STRING_TO_TRACE(arg))
@@ -88,8 +195,14 @@ public:
          opt_file_to_add = opt['a'];
          opt_file_to_sub = opt['s'];
          opt_file_to_del = opt['d'];
+
+         bmerge = (opt['m'] == *UString::str_one);
          }
 
+      startCrono();
+
+      lockDelta();
+
       if (IR::openCDB(true))
          {
          // load all filenames in argument
@@ -98,41 +211,104 @@ public:
          if (opt_file_to_sub) buildFilenameListFrom(file_to_sub, opt_file_to_sub);
          if (opt_file_to_del) buildFilenameListFrom(file_to_del, opt_file_to_del);
 
-         // process all filenames in argument
+         // the DocID changed by this update are removed from the delta segment (and from the index by the delta segment)...
 
-         IR::setBadWords();
+         UString vdoc, key;
+
+         addDocID(vdoc, file_to_add);
+         addDocID(vdoc, file_to_sub);
 
-         if (opt_file_to_add)
+         if (opt_file_to_del)
             {
-            operation = 0; // add
+            U_NEW(UVector<UString>, vdel, UVector<UString>);
+
+            for (uint32_t i = 0, n = file_to_del.size(); i < n; ++i)
+               {
+               if (getDocID(file_to_del[i], key))
+                  {
+                  (void) vdoc.append(key);
 
-            file_to_add.callForAllEntry(parse);
+                  vdel->push_back(key);
+                  }
+               }
             }
 
-         if (opt_file_to_sub)
-            {
-            operation = 1; // sub
+         UPosting::setIndex(cfg.readLong(U_STRING_FROM_CONSTANT("DIMENSION"), 1000));
 
-            file_to_sub.callForAllEntry(parse);
-            }
+         UPosting::loadDelta(vdoc);
+
+         // process all filenames in argument
+
+         IR::setBadWords();
+
+         operation = 0; // add (NB: the substitute is an add that shadow the document of the index)
+
+         if (opt_file_to_add) file_to_add.callForAllEntry(parse);
+         if (opt_file_to_sub) file_to_sub.callForAllEntry(parse);
 
          if (opt_file_to_del)
             {
             operation = 2; // del
 
-            file_to_del.callForAllEntry(parse);
+            file_to_del.callForAllEntry(del);
+
+            U_DELETE(vdel)
+
+            vdel = U_NULLPTR;
             }
 
-         // register to database (RDB)
+         (void) UFile::chdir(U_NULLPTR, true);
+
+         // register to delta segment
 
-         IR::closeCDB(true);
-         IR::deleteDB(true);
+         UPosting::encodeAllEntry();
+
+         if (IR::writeDelta() == false) U_ERROR("cannot write the delta segment");
+
+         IR::closeDelta();
+         IR::openDelta();
+
+         printThroughput();
+
+         if (bmerge)
+            {
+            if (IR::mergeDelta() == false) U_ERROR("cannot merge the delta segment in the index");
+            }
+         else if (cdb_delta_words &&
+                  cdb_delta_words->getSize() > (uint32_t)cfg.readLong(U_STRING_FROM_CONSTANT("DELTA_MAX_SIZE"), 32 * 1024 * 1024))
+            {
+            // NB: the merge is done in background, the child wait for the lock (released by the parent at exit)...
+
+            UProcess proc;
+
+            if (proc.fork() &&
+                proc.child())
+               {
+               lockDelta();
+
+               if (reopenCDB() &&
+                   IR::mergeDelta() == false)
+                  {
+                  U_ERROR("cannot merge the delta segment in the index");
+                  }
+
+               U_EXIT(0);
+               }
+            }
+
+         IR::deleteDB();
          }
       }
 
 private:
+   UFile lock;
    UVector<UString> file_to_add, file_to_sub, file_to_del;
    UString opt_file_to_add, opt_file_to_sub, opt_file_to_del;
+   bool bmerge;
+
+   static UVector<UString>* vdel;
 };
 
+UVector<UString>* Application::vdel;
+
 U_MAIN
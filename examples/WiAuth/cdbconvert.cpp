@@ -0,0 +1,60 @@
+// cdbconvert.cpp
+
+#include <ulib/db/cdb.h>
+
+#undef  PACKAGE
+#define PACKAGE "cdbconvert"
+
+#define ARGS "<path of source cdb> <path of destination cdb>"
+
+#define U_OPTIONS \
+"purpose 'convert a constant database (cdb) between the classic and the cdb64 format'\n" \
+"option c classic     0 'write the destination in the classic format (default is cdb64)' ''\n" \
+"option i ignore-case 0 'the keys of the database are case insensitive' ''\n"
+
+#include <ulib/application.h>
+
+class Application : public UApplication {
+public:
+
+   ~Application()
+      {
+      U_TRACE(5, "Application::~Application()")
+      }
+
+   void run(int argc, char* argv[], char* env[])
+      {
+      U_TRACE(5, "Application::run(%d,%p,%p)", argc, argv, env)
+
+      UApplication::run(argc, argv, env);
+
+      const char* src = argv[optind];
+
+      if (src == U_NULLPTR) U_ERROR("missing <path of source cdb> argument");
+
+      const char* dst = argv[++optind];
+
+      if (dst == U_NULLPTR) U_ERROR("missing <path of destination cdb> argument");
+
+      bool bclassic    = (opt['c'] == *UString::str_one),
+           ignore_case = (opt['i'] == *UString::str_one);
+
+      UCDB x(UString(src, u__strlen(src, __PRETTY_FUNCTION__)), ignore_case);
+
+      if (x.open() == false ||
+          x.UFile::st_size == 0)
+         {
+         U_ERROR("cannot open the source cdb %S", src);
+         }
+
+      U_INTERNAL_DUMP("x.isCdb64() = %b", x.isCdb64())
+
+      if (x.copyTo(UString(dst, u__strlen(dst, __PRETTY_FUNCTION__)), bclassic == false) == false) U_ERROR("cannot write the destination cdb %S", dst);
+
+      u__printf(STDOUT_FILENO, U_CONSTANT_TO_PARAM("%u records converted (%s => %s)"), x.size(), x.isCdb64() ? "cdb64" : "classic", bclassic ? "classic" : "cdb64");
+      }
+
+private:
+};
+
+U_MAIN
@@ -164,9 +164,6 @@ public:
 
                p = y.data();
 
-#           ifdef U_EVASIVE_SUPPORT
-               if (memcmp(p, U_CONSTANT_TO_PARAM("Evasive")) == 0) UString::printValueToBuffer = UServer_Base::printEvasiveRecToBuffer;
-#           endif
 #           ifdef U_THROTTLING_SUPPORT
                if (memcmp(p, U_CONSTANT_TO_PARAM("BandWidthThrottling")) == 0) UString::printValueToBuffer = UServer_Base::printThrottlingRecToBuffer;
 #           endif
@@ -109,6 +109,7 @@ static inline uint32_t u_hash(const unsigned char* restrict t, uint32_t tlen) {
 U_EXPORT uint32_t u_hash_ignore_case(const unsigned char* restrict t, uint32_t tlen) __pure;
 
 U_EXPORT uint32_t u_cdb_hash(const unsigned char* restrict t, uint32_t tlen, int flags) __pure;
+U_EXPORT uint64_t u_cdb64_hash(const unsigned char* restrict t, uint32_t tlen, int flags) __pure; /* NB: unseeded (persistent on disk)... */
 
 U_EXPORT uint32_t u_random(uint32_t val) __pure; /* quick 4byte hashing function */
 U_EXPORT uint32_t u_integerHash(uint32_t val) __pure;
@@ -15,6 +15,7 @@
 #define ULIB_CACHE_H 1
 
 #include <ulib/file.h>
+#include <ulib/utility/lock.h>
 
 /**
  * @class UCache
@@ -40,6 +41,8 @@
  * Each entry contains the following information: struct cache_hash_table_entry + key + data
  */
 
+class UShardCache;
+
 #define U_MAX_TTL         365L * U_ONE_DAY_IN_SECOND // 365 gg (1 year)
 #define U_MAX_KEYLEN     1000U
 #define U_MAX_DATALEN 1000000U
@@ -60,10 +63,11 @@ public:
 
       fd = -1;
 
-      x     = U_NULLPTR;
-      ttl   = 0;
-      info  = U_NULLPTR;
-      start = 0;
+      x          = U_NULLPTR;
+      ttl        = 0;
+      info       = U_NULLPTR;
+      start      = 0;
+      pevictions = U_NULLPTR;
 
 #  ifdef DEBUG
       dir_template_mtime = 0;
@@ -183,6 +187,7 @@ protected:
    cache_info* info; // cache info pointer
    time_t start;     // time of reference
    uint32_t ttl;     // time to live (expire entry)
+   uint64_t* pevictions; // counter of the entries dropped to make room (only for the shard of UShardCache)
 #ifdef DEBUG
    UString dir_template;
    time_t  dir_template_mtime;
@@ -268,9 +273,170 @@ protected:
    char* add(const char* key, uint32_t keylen, uint32_t datalen, uint32_t ttl);
 
 private:
+   void set(char* ptr, uint32_t size, bool bexist) U_NO_EXPORT;
    void init(UFile& _x, uint32_t size, bool bexist, bool brdonly) U_NO_EXPORT;
 
    U_DISALLOW_COPY_AND_ASSIGN(UCache)
+
+   friend class UShardCache;
+};
+
+/**
+ * @class UShardCache
+ *
+ * @brief UShardCache is a fixed-size cache split in N independent UCache (shard) selected by the hash of the key.
+ *
+ * All the shards live in one mapping, so the cache is shared by the preforked processes, and every shard is protected by its
+ * own lock, so a get/add contend only with the operations on the same shard. Every shard has its own counters of hits, misses
+ * and evictions:
+ * +--------+-------+-------------------------------------+-------------------------------------+-----+
+ * | header | locks | stats0 cache_info0 p0...  entries0  | stats1 cache_info1 p0...  entries1  | ... |
+ * +--------+-------+-------------------------------------+-------------------------------------+-----+
+ * The header, the locks and every shard are aligned to a cache line to avoid false sharing between the shards.
+ *
+ * NB: the caller can give to open() the storage (in shared memory) for the semaphores of the shards (Ex: the server give
+ *     UServer_Base::ptr_shm_data->lock_shard_cache), otherwise we use the semaphores in the mapping. In both cases open()
+ *     initialize them, so it must be called before the forking of the processes that share the cache. Since the data can
+ *     be overwritten by another process as soon as we release the lock of the shard, get() return a copy of the data...
+ */
+
+#define U_CACHE_SHARD_ALIGN 64U
+#define U_CACHE_SHARD_MAX  512U
+
+class U_EXPORT UShardCache {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   typedef struct cache_shard_stats {
+      uint64_t hits;
+      uint64_t misses;
+      uint64_t evictions;
+   } cache_shard_stats;
+
+   UShardCache()
+      {
+      U_TRACE_CTOR(0, UShardCache, "")
+
+      fd       = -1;
+      map      = U_NULLPTR;
+      lock     = U_NULLPTR;
+      shard    = U_NULLPTR;
+      nshard   = shift = map_size = 0;
+      }
+
+   ~UShardCache();
+
+   // OPEN/CREAT a cache file (nshard == 0 => two shards for every cpu, psem => storage for nsem semaphores, see above...)
+
+   bool open(const UString& path, uint32_t size, uint32_t nshard = 0, const UString* environment = U_NULLPTR, bool btemp = false, sem_t* psem = U_NULLPTR, uint32_t nsem = 0);
+
+   // OPERATION
+
+   void add(       const UString& key, const UString& data,    uint32_t _ttl = 0);
+   void addContent(const UString& key, const UString& content, uint32_t _ttl = 0); // NB: +null terminator...
+
+   UString get(       const char* key, uint32_t len);
+   UString getContent(const char* key, uint32_t len); // NB: -null terminator...
+
+   UString get(       const UString& key) { return get(       U_STRING_TO_PARAM(key)); }
+   UString getContent(const UString& key) { return getContent(U_STRING_TO_PARAM(key)); }
+
+   // operator []
+
+   UString operator[](const UString& key) { return getContent(key); }
+
+   // SERVICES
+
+   uint32_t getNumShard() const
+      {
+      U_TRACE_NO_PARAM(0, "UShardCache::getNumShard()")
+
+      U_RETURN(nshard);
+      }
+
+   uint32_t getShard(const char* key, uint32_t keylen) const
+      {
+      U_TRACE(0, "UShardCache::getShard(%.*S,%u)", keylen, key, keylen)
+
+      U_INTERNAL_ASSERT_MAJOR(nshard, 0)
+
+      // NB: UCache::hash() use the low bits of the hash to select the bucket, so we select the shard with the high bits (fibonacci hashing)...
+
+      uint32_t i = (shift == 32 ? 0 : (u_cdb_hash((unsigned char*)key, keylen, -1) * 2654435769U) >> shift);
+
+      U_INTERNAL_ASSERT_MINOR(i, nshard)
+
+      U_RETURN(i);
+      }
+
+   const cache_shard_stats* getStats(uint32_t i) const
+      {
+      U_TRACE(0, "UShardCache::getStats(%u)", i)
+
+      U_INTERNAL_ASSERT_MINOR(i, nshard)
+
+      const cache_shard_stats* ptr = getShardStats(i);
+
+      U_RETURN_POINTER(ptr, const cache_shard_stats);
+      }
+
+   void getStats(cache_shard_stats& total) const; // sum of the counters of all the shards
+   void resetStats();
+
+   UString printStats() const;
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   int fd;
+   char* map;      // mapping of the cache file
+   ULock* lock;    // lock of every shard
+   UCache* shard;  // the shards (their info/x point inside the mapping)
+   uint32_t nshard, shift, map_size;
+
+   cache_shard_stats* getShardStats(uint32_t i) const
+      {
+      U_TRACE(0, "UShardCache::getShardStats(%u)", i)
+
+      U_INTERNAL_ASSERT_POINTER(shard)
+
+      cache_shard_stats* ptr = (cache_shard_stats*)((char*)shard[i].info - sizeof(cache_shard_stats));
+
+      U_RETURN_POINTER(ptr, cache_shard_stats);
+      }
+
+   void lockShard(uint32_t i)
+      {
+      U_TRACE(0, "UShardCache::lockShard(%u)", i)
+
+      U_INTERNAL_ASSERT_POINTER(lock)
+
+      lock[i].lock();
+      }
+
+   void unlockShard(uint32_t i)
+      {
+      U_TRACE(0, "UShardCache::unlockShard(%u)", i)
+
+      U_INTERNAL_ASSERT_POINTER(lock)
+
+      lock[i].unlock();
+      }
+
+private:
+   static uint32_t getHeaderSize(uint32_t n) { return U_CACHE_SHARD_ALIGN + ((n * sizeof(sem_t) + U_CACHE_SHARD_ALIGN-1) & ~(U_CACHE_SHARD_ALIGN-1)); }
+
+   U_DISALLOW_COPY_AND_ASSIGN(UShardCache)
 };
 
 #endif
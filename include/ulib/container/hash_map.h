@@ -17,6 +17,10 @@
 #include <ulib/container/vector.h>
 
 //#define U_SHERWOOD_V8 1 // don't work!
+#if !defined(U_SHERWOOD_V8) && !defined(U_ROBIN_HOOD_HASHING) && defined(__SSE2__)
+#  define U_SWISS_TABLE 1 // NB: define U_ROBIN_HOOD_HASHING to have back the previous implementation...
+#endif
+
 #ifdef U_SHERWOOD_V8
 /**
  * Chaining hash table in a flat array
@@ -32,6 +36,23 @@
 
 #  define U_MAX_LOAD_FACTOR    0.9375f 
 #  define U_NUM_JUMP_DISTANCES 126
+#elif defined(U_SWISS_TABLE)
+/**
+ * Open addressing with a control byte for slot, probed a group of 16 slots at a time with SSE2 (Swiss table)
+ *
+ * Algorithm from https://abseil.io/about/design/swisstables
+ *
+ * The control byte of a full slot keep 7 bits of the hash (H2), the low bits of the hash (H1) select the start of the probe.
+ * The first group of control bytes is cloned after the end of the array, so that an unaligned load of a group never wrap around.
+ * A lookup compare the stored hash and then the key only for the slots of the group whose tag match
+ */
+#  define U_SWISS_GROUP_SIZE 16
+#  define U_SWISS_EMPTY      0x80 // 0b10000000
+#  define U_SWISS_DELETED    0xfe // 0b11111110
+
+#  define U_SWISS_H2(hash) ((uint8_t)((hash) >> 25))
+
+#  define U_MAX_LOAD_FACTOR 0.875f // NB: the tombstones (deleted slots) count for the load factor...
 #else
 /**
  * Modified, highly optimized Robin Hood Hashtable
@@ -238,6 +259,13 @@ public:
 
    bool findElement(const void* elem);
 
+   // reentrant lookup: the probe cursor is local to the call, the static state (node, index, lkey, lhash) is not changed
+
+   UHashMapNode* findNode(const char* k, uint32_t klen) const;
+
+   UHashMapNode* findNode(const UString& k) const    { return findNode(U_STRING_TO_PARAM(k)); }
+   UHashMapNode* findNode(const UStringRep* k) const { return findNode(U_STRING_TO_PARAM(*k)); }
+
    // get methods
 
    const void* elem() const      { return node->elem; }
@@ -510,6 +538,9 @@ protected:
    uint8_t* info;
    bPFpt set_index;
    uint32_t _capacity, _length, mask, max_num_elements_allowed;
+#ifdef U_SWISS_TABLE
+   uint32_t num_deleted;
+#endif
 
    static uint8_t linfo;
    static const void* lelem;
@@ -517,6 +548,8 @@ protected:
 
    void increase_size();
 
+   UHashMapNode* findNodeWithContext(const char* k, uint32_t klen) const;
+
    // allocate and deallocate methods
 
    void _allocate(uint32_t n);
@@ -751,6 +784,10 @@ protected:
 
 #  ifdef U_SHERWOOD_V8
       (void) U_SYSCALL(memset, "%p,%d,%u", info, U_MAGIC_FOR_EMPTY, _capacity);
+#  elif defined(U_SWISS_TABLE)
+      (void) U_SYSCALL(memset, "%p,%d,%u", info, U_SWISS_EMPTY, _capacity+U_SWISS_GROUP_SIZE);
+
+      num_deleted = 0;
 #  else
       (void) U_SYSCALL(memset, "%p,%d,%u", info, 0,                 _capacity);
 #  endif
@@ -772,6 +809,8 @@ protected:
          }
 
       U_RETURN(false);
+#  elif defined(U_SWISS_TABLE)
+      U_RETURN((info[index_metadata] & U_SWISS_EMPTY) == 0);
 #  else
       U_RETURN((info[index_metadata] & U_IS_BUCKET_TAKEN_MASK) != 0);
 #  endif
@@ -783,7 +822,9 @@ protected:
 
       U_INTERNAL_DUMP("linfo = %u info[%u] = %u", linfo, index, info[index])
 
-#  ifndef U_SHERWOOD_V8
+#  ifdef U_SWISS_TABLE
+      setCtrl(index, linfo);
+#  elif !defined(U_SHERWOOD_V8)
       info[index] = linfo;
 #  elif defined(DEBUG)
       U_DUMP("isNoEmpty(%u) = %b", index, isNoEmpty(index))
@@ -797,7 +838,16 @@ protected:
       U_ASSERT(checkAt(lkey, lelem))
       }
 
-#ifndef U_SHERWOOD_V8
+#ifdef U_SWISS_TABLE
+   void setCtrl(uint32_t index_metadata, uint8_t h2)
+      {
+      U_TRACE(0, "UHashMap<void*>::setCtrl(%u,%u)", index_metadata, h2)
+
+      info[index_metadata] = h2;
+
+      info[((index_metadata - U_SWISS_GROUP_SIZE) & mask) + U_SWISS_GROUP_SIZE] = h2; // NB: the clone of the first group (or the same byte)...
+      }
+#elif !defined(U_SHERWOOD_V8)
    void swapNode();
    void swapNodeInResize();
 
@@ -42,10 +42,23 @@
  * The hash value modulo 512 is the number of a hash table.
  * The hash value divided by 512, modulo the length of that table, is a slot number.
  * Probe that slot, the next higher slot, and so on, until you find the record or run into an empty slot
+ *
+ * cdb64: to go beyond the 4 gigabytes limit we have also a versioned format with 64-bit positions and hash values:
+ * +--------+----------------+------------+-------+-------+-----+---------+
+ * | header | p0 p1 ... p511 | records... | hash0 | hash1 | ... | hash511 |
+ * +--------+----------------+------------+-------+-------+-----+---------+
+ * The header states a magic number (CDB64_MAGIC, that can't be a valid position of the first hash table), a version,
+ * the end of the records and the number of records. Pointers and slots are 16 bytes, the hash function is xxh3 (unseeded)
+ * and every hash table has two slots for record (so an unsuccessful lookup doesn't scan a full table). The record layout
+ * is the same (so key and data length are still 32-bit quantities). The format is detected automatically by open() and
+ * the lookup works always on the mmap'ed file (zero-copy), so a cdb64 is supported only where we have mmap
  */
 
 #define CDB_NUM_HASH_TABLE_POINTER 512
 
+#define CDB64_MAGIC   0x0cdb
+#define CDB64_VERSION 1
+
 class URDB;
 class UHTTP;
 
@@ -80,6 +93,25 @@ public:
       uint32_t pos;  // starting byte position of the record (0 -> slot empty)
    } cdb_hash_table_slot;
 
+   // cdb64
+
+   typedef struct cdb64_header {
+      uint32_t magic;   // CDB64_MAGIC
+      uint32_t version; // CDB64_VERSION
+      uint64_t eod;     // end of data (start of hash table slot)
+      uint64_t nrecord; // number of records
+   } cdb64_header;
+
+   typedef struct cdb64_hash_table_pointer {
+      uint64_t pos;   // starting byte position of the hash table
+      uint64_t slots; //        number of slots in the hash table
+   } cdb64_hash_table_pointer;
+
+   typedef struct cdb64_hash_table_slot {
+      uint64_t hash; // hash value of the key
+      uint64_t pos;  // starting byte position of the record (0 -> slot empty)
+   } cdb64_hash_table_slot;
+
    UCDB(int ignore_case = 0)
       {
       U_TRACE_CTOR(0, UCDB, "%d", ignore_case)
@@ -117,6 +149,11 @@ public:
 
    bool ignoreCase() const  { return ignoreCase(this); }
 
+   // cdb64: detected by open(), to be set before writeTo() to create a new database with this format
+
+   bool isCdb64() const  { return bcdb64; }
+   void setCdb64(bool b) { bcdb64 = b; }
+
    void setKey(UStringRep* _key)                 { key.dptr = (void*) _key->data(); key.dsize = _key->size(); }
    void setKey(const UString&  _key)             { key.dptr = (void*) _key.data();  key.dsize = _key.size(); }
    void setKey(const void* dptr, uint32_t dsize) { key.dptr = (void*) dptr;         key.dsize = dsize; }
@@ -207,12 +244,14 @@ public:
 
    // Save memory hash table as Constant DataBase
 
-   static uint32_t sizeFor(uint32_t _nrecord)
+   static uint64_t sizeFor(uint32_t _nrecord, bool b64 = false)
       {
-      U_TRACE(0, "UCDB::sizeFor(%u)", _nrecord)
+      U_TRACE(0, "UCDB::sizeFor(%u,%b)", _nrecord, b64)
 
-      uint32_t size = CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb_hash_table_pointer) +
-                      _nrecord * (sizeof(cdb_record_header) + sizeof(cdb_hash_table_slot));
+      uint64_t size = (b64 ? sizeof(cdb64_header) + CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb64_hash_table_pointer) +
+                             (uint64_t)_nrecord * (sizeof(cdb_record_header) + sizeof(cdb64_hash_table_slot) * 2)
+                           :                       CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb_hash_table_pointer) +
+                             (uint64_t)_nrecord * (sizeof(cdb_record_header) + sizeof(cdb_hash_table_slot)));
 
       U_RETURN(size);
       }
@@ -220,6 +259,10 @@ public:
           bool writeTo(                     UHashMap<void*>* t, uint32_t tbl_space, pvPFpvpb f = U_NULLPTR) { return UCDB::writeTo(*this, t, tbl_space, f); }
    static bool writeTo(const UString& path, UHashMap<void*>* t, uint32_t tbl_space, pvPFpvpb f = U_NULLPTR) { return UCDB(path, t->ignoreCase()).writeTo(t, tbl_space, f); }
 
+   // Rewrite the (mmap'ed) database in the classic or in the cdb64 format (the classic format fail if the output go beyond 4 gigabytes)
+
+   bool copyTo(const UString& path, bool b64);
+
    // STREAM
 
    UString print();
@@ -244,6 +287,9 @@ protected:
    cdb_hash_table_slot* slot;  // initialized in find()
    cdb_hash_table_pointer* hp; // initialized in find()
 
+   cdb64_hash_table_slot* slot64;  // initialized in find64()
+   cdb64_hash_table_pointer* hp64; // initialized in find64()
+
    // internal
 
    char* pattern;
@@ -257,14 +303,16 @@ protected:
    cdb_record_header      hr_buf;
    cdb_hash_table_slot  slot_buf;
 
-   uint32_t loop,    // number of hash slots searched under key
-            nslot,   // initialized in find()
-            khash,   // initialized in find()
-            nrecord, // initialized in makeStart()
+   uint64_t khash,  // initialized in find()
             offset,
             start_hash_table_slot;
 
+   uint32_t loop,    // number of hash slots searched under key
+            nslot,   // initialized in find()
+            nrecord; // initialized in makeStart()
+
    unsigned char flag[4];
+   bool bcdb64;
 
    bool find();
    UString at();
@@ -272,7 +320,7 @@ protected:
 
    static bool ignoreCase(const UCDB* pcdb) { return (U_cdb_ignore_case(pcdb) != 0); }
 
-   uint32_t cdb_hash(const char* t, uint32_t tlen)
+   uint64_t cdb_hash(const char* t, uint32_t tlen)
       {
       U_TRACE(0, "UCDB::cdb_hash(%.*S,%u)", tlen, t, tlen)
 
@@ -287,6 +335,13 @@ protected:
 
       U_INTERNAL_DUMP("flags = %d U_cdb_ignore_case(this) = %d", flags, U_cdb_ignore_case(this))
 
+      if (bcdb64)
+         {
+         uint64_t result = u_cdb64_hash((unsigned char*)t, tlen, flags);
+
+         U_RETURN(result);
+         }
+
       uint32_t result = u_cdb_hash((unsigned char*)t, tlen, flags);
 
       U_RETURN(result);
@@ -294,13 +349,24 @@ protected:
 
    void cdb_hash() { khash = cdb_hash((const char*)key.dptr, key.dsize); }
 
-   void setHash(uint32_t _hash)               { khash = _hash; }
    void setHash(const char* t, uint32_t tlen) { khash = cdb_hash(t, tlen); }
 
+   void setHash(uint32_t _hash) // NB: precomputed with u_cdb_hash(), for cdb64 we must compute it from the key...
+      {
+      if (bcdb64) cdb_hash();
+      else        khash = _hash;
+      }
+
    // START-END of record data
 
-   char* start() const { return (UFile::map + CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb_hash_table_pointer)); }
-   char*   end() const { return (UFile::map + start_hash_table_slot); }
+   char* start() const
+      {
+      if (bcdb64) return (UFile::map + sizeof(cdb64_header) + CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb64_hash_table_pointer));
+
+      return (UFile::map + CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb_hash_table_pointer));
+      }
+
+   char* end() const { return (UFile::map + start_hash_table_slot); }
 
    // Call function for all entry
 
@@ -327,7 +393,7 @@ protected:
       hr = (UCDB::cdb_record_header*) start();
       }
 
-   uint32_t makeFinish(bool reset);
+   uint64_t makeFinish(bool reset);
 
    void call1();
    void call1(const char*  key_ptr, uint32_t  key_size,
@@ -343,7 +409,12 @@ protected:
 #endif
 
 private:
-   inline bool match(uint32_t pos) U_NO_EXPORT;
+   inline bool match(uint64_t pos) U_NO_EXPORT;
+
+   bool     find64() U_NO_EXPORT;
+   bool findNext64() U_NO_EXPORT;
+
+   uint64_t makeFinish64(bool reset) U_NO_EXPORT;
 
    U_DISALLOW_COPY_AND_ASSIGN(UCDB)
 
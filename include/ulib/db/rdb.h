@@ -47,6 +47,7 @@ class URDBClientImage;
 // The interface is very similar to the gdbm one
 
 #  define CACHE_HASHTAB_LEN 769
+#  define RDB_JOURNAL_MAGIC U_MULTICHAR_CONSTANT32('J','N','L','2') // NB: version of the layout of the journal (see cache_struct)...
 
 #  define RDB_off(prdb)      ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->off
 #  define RDB_capacity(prdb) (uint32_t)(((URDB*)prdb)->journal.st_size - RDB_off(prdb))
@@ -56,10 +57,12 @@ class URDBClientImage;
 #  define RDB_sync(prdb)      ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->sync
 #  define RDB_nrecord(prdb)   ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->nrecord
 #  define RDB_reference(prdb) ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->reference
-#  define RDB_hashtab(prdb)  (((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->hashtab)
+#  define RDB_hashtab(prdb)   (((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->hashtab)
+#  define RDB_magic(prdb)      ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->magic
+#  define RDB_generation(prdb) ((URDB::cache_struct*)(((URDB*)prdb)->journal.map))->generation
 
 #  define RDB_ptr(prdb)      (((URDB*)prdb)->journal.map+sizeof(URDB::cache_struct))
-#  define RDB_start(prdb)    (RDB_ptr(prdb)-(CACHE_HASHTAB_LEN*sizeof(uint32_t)))
+#  define RDB_start(prdb)    ((char*)RDB_hashtab(prdb))
 #  define RDB_node(prdb)     ((URDB::cache_node*)(((URDB*)prdb)->journal.map+prdb->node))
 
 #  define RDB_node_key_pr(prdb)  u_get_unaligned32(RDB_node(prdb)->key.dptr)
@@ -142,6 +145,10 @@ public:
 
    void close(bool breference = true);
 
+   // Combines the old cdb file and the diffs in a new cdb file (online: the writers wait only for the snapshot and the swap)
+
+   bool reorganize();
+
    // Combines the old cdb file and the diffs in a new cdb file.
    // Close the database and deletes the obsolete journal file if everything worked out
 
@@ -284,6 +291,24 @@ public:
    void   lock() { if (_lock.sem) _lock.lock(); }
    void unlock() { if (_lock.sem) _lock.unlock(); }
 
+   // STATS (compaction of the journal: reorganize() and compactionJournal())
+   // NB: they are per process (like the other stats of UServer_Base::getStats()), they count only the compactions made by this process...
+
+   static long compaction_time,       // milliseconds spent on the compaction
+               compaction_lock_time;  // milliseconds of the compaction spent holding the lock of the database
+   static uint32_t ncompaction;
+   static uint64_t compaction_reclaimed; // bytes
+
+   static void resetStats()
+      {
+      U_TRACE_NO_PARAM(0, "URDB::resetStats()")
+
+      compaction_time      =
+      compaction_lock_time = 0L;
+      ncompaction          = 0;
+      compaction_reclaimed = 0ULL;
+      }
+
    // TRANSACTION
 
    bool  beginTransaction();
@@ -346,6 +371,8 @@ protected:
       uint32_t nrecord;                    // RDB_nrecord
       uint32_t reference;                  // RDB_reference
       uint32_t hashtab[CACHE_HASHTAB_LEN]; // RDB_hashtab
+      uint32_t magic;                      // RDB_magic (RDB_JOURNAL_MAGIC, a journal of the previous version is migrated by open())
+      uint32_t generation;                 // RDB_generation (incremented by every reorganize(), compactionJournal() and htRemoveAlloc())
       // -----> data storage...            // RDB_ptr
    } cache_struct;
 
@@ -354,9 +381,9 @@ protected:
    UString at();
 
    int  remove();
+   int _remove();
    bool _fetch();
    bool isDeleted();
-   bool reorganize(); // Combines the old cdb file and the diffs in a new cdb file
    int  store(int flag);
    bool compactionJournal();
    int _store(int flag, bool exist);
@@ -412,8 +439,21 @@ private:
    void print1(UCDB* pcdb, uint32_t offset) U_NO_EXPORT;
    void getKeys1(UCDB* pcdb, uint32_t offset) U_NO_EXPORT;
    void makeAdd1(UCDB* pcdb, uint32_t offset) U_NO_EXPORT;
+   void delta1(const char* snapshot, uint32_t off_snapshot, UString* pdelta, uint32_t offset) U_NO_EXPORT;
+   bool migrate1(uint32_t offset, uint32_t start, bool bfix) U_NO_EXPORT;
+
+   // online compaction
+
+   void setSnapshot(const char* snapshot, uint32_t off_snapshot) U_NO_EXPORT;
+   void getDelta(   const char* snapshot, uint32_t off_snapshot, UString& delta) U_NO_EXPORT;
+   bool getSnapshot(UString& snapshot, uint32_t& off_snapshot, uint32_t& generation) U_NO_EXPORT;
+   bool isJournalChanged(uint32_t off, uint32_t generation) U_NO_EXPORT;
+   uint32_t getDeltaWithoutLock(const char* snapshot, uint32_t off_snapshot, uint32_t generation, UString& delta) U_NO_EXPORT;
+   void applyDelta(const UString& delta) U_NO_EXPORT;
+   void setStats(long time_lock, uint64_t size_before, uint64_t size_after) U_NO_EXPORT;
 
    bool logJournal(int op) U_NO_EXPORT;
+   bool migrateJournal(uint32_t journal_sz) U_NO_EXPORT;
    bool resizeJournal(uint32_t oversize) U_NO_EXPORT;
    void call(UCDB* pcdb, vPFpvu function1, vPFpvpc function2) U_NO_EXPORT;
    void callForEntryNotInCache(UCDB* pcdb, vPFpvpc function2) U_NO_EXPORT;
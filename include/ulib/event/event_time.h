@@ -79,6 +79,7 @@ public:
 
    virtual int handlerTime() { return -1; } // return value: -1 -> normal,
                                             //                0 -> monitoring
+                                            //                1 -> monitoring (xtime already set by the handler)
 
 #ifdef USE_LIBEVENT
    UTimerEv<UEventTime>* pevent;
@@ -129,6 +130,7 @@ public:
 
 protected:
    long tolerance;
+   UTimer* ptimer; // the item of the timing wheel that hold us (UTimer wheel mode)
 
    static long diff1, diff2;
    static struct timeval  timeout1;
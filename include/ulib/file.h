@@ -61,6 +61,7 @@
 class URDB;
 class UHTTP;
 class UCache;
+class UShardCache;
 class UDirWalk;
 class UStringExt;
 class UClientImage_Base;
@@ -1365,6 +1366,7 @@ private:
    friend class URDB;
    friend class UHTTP;
    friend class UCache;
+   friend class UShardCache;
    friend class UString;
    friend class UDirWalk;
    friend class UStringRep;
@@ -255,13 +255,15 @@ enum HttpRequestType {
    HTTP_IS_ACCEPT_BROTLI       = 0x08,
    HTTP_IS_NOCACHE_FILE        = 0x10,
    HTTP_IS_REQUEST_NOSTAT      = 0x20,
-   HTTP_METHOD_NOT_IMPLEMENTED = 0x40
+   HTTP_METHOD_NOT_IMPLEMENTED = 0x40,
+   HTTP_IS_ACCEPT_ZSTD         = 0x80
 };
 
 #define U_http_keep_alive             ((U_http_flag & HTTP_IS_KEEP_ALIVE)          != 0)
 #define U_http_data_chunked           ((U_http_flag & HTTP_IS_DATA_CHUNKED)        != 0)
 #define U_http_is_accept_gzip         ((U_http_flag & HTTP_IS_ACCEPT_GZIP)         != 0)
 #define U_http_is_accept_brotli       ((U_http_flag & HTTP_IS_ACCEPT_BROTLI)       != 0)
+#define U_http_is_accept_zstd         ((U_http_flag & HTTP_IS_ACCEPT_ZSTD)         != 0)
 #define U_http_is_nocache_file        ((U_http_flag & HTTP_IS_NOCACHE_FILE)        != 0)
 #define U_http_is_request_nostat      ((U_http_flag & HTTP_IS_REQUEST_NOSTAT)      != 0)
 #define U_http_method_not_implemented ((U_http_flag & HTTP_METHOD_NOT_IMPLEMENTED) != 0)
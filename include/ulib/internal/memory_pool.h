@@ -526,6 +526,12 @@ public:
 
    static void* cmalloc(uint32_t num, uint32_t type_size = sizeof(char), bool bzero = false);
 
+#if defined(ENABLE_MEMPOOL) && defined(ENABLE_THREAD)
+   // NB: every thread have a magazine (small array of free blocks) for every 'type' stack, pop()/push() go to the global stacks only in batch...
+
+   static uint64_t magazine_refill, magazine_drain, magazine_excess_free; // counters (see printInfo()), excess_free: blocks freed by a thread beyond the ones it allocated
+#endif
+
 #ifdef DEBUG
    static const char* obj_class;
    static const char* func_call;
@@ -65,6 +65,80 @@
 class UTokenizer;
 class UValueIter;
 
+/**
+ * \brief Arena for the trees of UValue.
+ *
+ * When an arena is set (see UValue::setArena()) the nodes and the strings of the trees built by parse() or by toJSON()
+ * are bump-allocated from big blocks of memory, and they are released all together by reset() without to walk the trees.
+ * A tree of the arena must not be used after the reset, the strings that go out of the tree (getString(), fromJSON(), ...)
+ * are copied. Every node of the tree (and the root) remember its arena, so the tree can be destroyed also after the reset
+ * or while another arena is set. NB: like the state of the parser (sd, o, ...) the current arena is per process, the trees
+ * must be built by one thread at a time
+ */
+
+class U_EXPORT UValueArena {
+public:
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   explicit UValueArena(uint32_t sz = 64U * 1024U)
+      {
+      U_TRACE_CTOR(0, UValueArena, "%u", sz)
+
+      head       = U_NULLPTR;
+      ptr        =
+      end        = U_NULLPTR;
+      block_size = sz;
+      num_block  = 0;
+      }
+
+   ~UValueArena();
+
+   void* allocate(uint32_t sz)
+      {
+      U_TRACE(0, "UValueArena::allocate(%u)", sz)
+
+      sz = (sz + 7) & ~7U; // NB: 8 bytes alignment...
+
+      if ((uint32_t)(end - ptr) < sz) grow(sz);
+
+      void* p = ptr;
+                ptr += sz;
+
+      U_RETURN_POINTER(p, void);
+      }
+
+   void reset(); // NB: all the memory is released in one call (the last block is keeped for the next use)...
+
+   bool owns(const void* p) const __pure;
+
+   uint32_t getNumBlock() const { return num_block; }
+
+#ifdef DEBUG
+   const char* dump(bool _reset) const;
+#endif
+
+protected:
+   typedef struct block {
+      struct block* next;
+      uint32_t size;
+   } block;
+
+   block* head;
+   char* ptr;
+   char* end;
+   uint32_t block_size, num_block;
+
+   void grow(uint32_t sz);
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UValueArena)
+};
+
 class U_EXPORT UValue {
 public:
    // Check for memory error
@@ -81,12 +155,54 @@ public:
 
    static int jsonParseFlags;
 
+   // ARENA (the trees are built in the arena, if set, and released with it)
+
+   static UValueArena* arena;
+   static UValueArena* request_arena;
+
+   static UValueArena* setArena(UValueArena* a)
+      {
+      U_TRACE(0, "UValue::setArena(%p)", a)
+
+      UValueArena* prev = arena;
+                          arena = a;
+
+      U_RETURN_POINTER(prev, UValueArena);
+      }
+
+   bool isArena() const { return (parena != U_NULLPTR); } // NB: the value is a node (or the root) of a tree of the arena...
+
+   // NB: the arena of the request is set by the USP page (see USP_JSON_ARENA) and released by the server after the page...
+
+   static void startRequestArena()
+      {
+      U_TRACE_NO_PARAM(0, "UValue::startRequestArena()")
+
+      if (request_arena == U_NULLPTR) U_NEW(UValueArena, request_arena, UValueArena);
+
+      arena = request_arena;
+      }
+
+   static void endRequestArena()
+      {
+      U_TRACE_NO_PARAM(0, "UValue::endRequestArena()")
+
+      if (arena)
+         {
+         if (arena == request_arena) arena->reset();
+
+         arena = U_NULLPTR;
+         }
+      }
+
    // Constructors
 
    explicit UValue(double fval = 0.0)
       {
       U_TRACE_CTOR(0, UValue, "%g", fval)
 
+      parena = U_NULLPTR;
+
       // coverity[uninit_ctor]
 #  ifdef U_COVERITY_FALSE_POSITIVE
       next = 0;
@@ -102,6 +218,8 @@ public:
       {
       U_TRACE_CTOR(0, UValue, "%d,%p", tag, payload)
 
+      parena = U_NULLPTR;
+
       // coverity[uninit_ctor]
 #  ifdef U_COVERITY_FALSE_POSITIVE
       next = 0;
@@ -117,6 +235,8 @@ public:
       {
       U_TRACE_CTOR(0, UValue, "%V,%V", key.rep, val.rep)
 
+      parena = U_NULLPTR;
+
       // coverity[uninit_ctor]
 #  ifdef U_COVERITY_FALSE_POSITIVE
       next = 0;
@@ -137,6 +257,7 @@ public:
       U_TRACE(0, "UValue::set(%p)", &v)
 
             next = v.next;
+          parena = v.parena;
        pkey.ival = v.pkey.ival;
       value.ival = v.value.ival;
       }
@@ -167,12 +288,16 @@ public:
       U_TRACE_NO_PARAM(0, "UValue::operator=(move)")
 
       UValue*  tmpn = next;
+      UValueArena* tmpa = parena;
       uint64_t tmpk = pkey.ival,
                tmpv = value.ival;
 
       next  = v.next;
               v.next = tmpn;
 
+      parena = v.parena;
+               v.parena = tmpa;
+
       pkey.ival = v.pkey.ival;
                   v.pkey.ival = tmpk;
 
@@ -189,6 +314,7 @@ public:
 
       set(v);
 
+      v.parena     = U_NULLPTR;
       v.value.ival = 0ULL;
       }
 # endif
@@ -304,7 +430,7 @@ public:
 
    int64_t getInt64() const { return -getUInt64(); }
 
-   UString getString() { return getString(value.ival); }
+   UString getString();
 
    bool   getBool() const   { return (getTag() == U_TRUE_VALUE); }
    double getDouble() const { return value.real; }
@@ -475,6 +601,7 @@ public:
       fromFlatBufferToJSON(fb);
 
       value.ival = o.ival;
+      parena     = arena;
       }
 
    // =======================================================================================================================
@@ -615,6 +742,7 @@ public:
 
 protected:
    UValue* next;    // only if binded to an object or array
+   UValueArena* parena; // only if the value is part of a tree of the arena
    union jval pkey, // only if binded to an object
               value;
 
@@ -708,6 +836,8 @@ protected:
       {
       U_TRACE_CTOR(0, UValue, "%#llx", val)
 
+      parena = U_NULLPTR;
+
       next = this;
 
       // coverity[uninit_ctor]
@@ -724,6 +854,8 @@ protected:
       {
       U_TRACE_CTOR(0, UValue, "%p", node)
 
+      parena = U_NULLPTR;
+
       next = node;
 
       // coverity[uninit_ctor]
@@ -740,6 +872,8 @@ protected:
       {
       U_TRACE_CTOR(0, UValue, "%#llx,%p", val, node)
 
+      parena = U_NULLPTR;
+
       next = node;
 
       // coverity[uninit_ctor]
@@ -924,12 +1058,15 @@ protected:
 
       if (tail)
          {
-         U_NEW(UValue, node, UValue(value, tail->next));
-                                           tail->next = node;
+         if (arena) node = newNode(value, tail->next);
+         else U_NEW(UValue, node, UValue(value, tail->next));
+
+         tail->next = node;
          }
       else
          {
-         U_NEW(UValue, node, UValue(value));
+         if (arena) node = newNode(value, U_NULLPTR);
+         else U_NEW(UValue, node, UValue(value));
          }
 
       U_RETURN_POINTER(node, UValue);
@@ -1051,13 +1188,14 @@ protected:
          {
          UStringRep* rep;
 
-         U_NEW(UStringRep, rep, UStringRep(ptr, sz));
+         if (arena) rep = newStringRep(ptr, sz);
+         else U_NEW(UStringRep, rep, UStringRep(ptr, sz));
 
          setValue(U_STRING_VALUE, rep);
          }
       else
          {
-         UStringRep::string_rep_null->hold();
+         if (arena == U_NULLPTR) UStringRep::string_rep_null->hold();
 
          setValue(U_STRING_VALUE, UStringRep::string_rep_null);
          }
@@ -1068,9 +1206,12 @@ protected:
    static void addString(      const UString& x) { addString(      U_STRING_TO_PARAM(x)); }
    static void addStringParser(const UString& x) { addStringParser(U_STRING_TO_PARAM(x)); }
 
-   static UString getString(uint64_t value);
+   static UString getString(uint64_t value); // NB: the string of a tree of the arena is shared, see getString() to get a copy...
 
 private:
+   static UValue*     newNode(uint64_t value, UValue* node);
+   static UStringRep* newStringRep(const char* ptr, uint32_t sz);
+
    static int jread_skip(UTokenizer& tok) U_NO_EXPORT;
    static int jreadFindToken(UTokenizer& tok) U_NO_EXPORT;
    static int jreadAdvanceAndFindToken(UTokenizer& tok) U_NO_EXPORT;
@@ -1118,6 +1259,122 @@ inline UValueIter end(  const union UValue::jval)   { return UValueIter(U_NULLPT
 inline UValueIter begin(const union UValue::jval v) { return UValueIter(UValue::toNode(v.ival)); }
 #endif
 
+/**
+ * \brief On-demand JSON: navigation without the tree of UValue.
+ *
+ * The parsing is done in two stages:
+ *
+ * 1) a pass on the document (64 bytes for time with SSE2/AVX2, if available) find the string boundaries
+ *    and build an index of the positions of the structural characters ({}[]:,), of the quotes and of the
+ *    start of the scalar values (number, true, false, null). The brackets are matched on the index, so a
+ *    container is skipped in constant time
+ *
+ * 2) the navigation (findKey(), at(), jfind(), jread()) move on the index: the values that are not requested
+ *    are skipped without to look at their bytes and the results are substring of the document (no copy)
+ *
+ * The values are referenced by their position in the index (0 is the root, U_NOT_FOUND if missing).
+ * The elements of an object are referenced by the position of their key (see getMemberValue())
+ */
+
+class U_EXPORT UJsonOnDemand {
+public:
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UJsonOnDemand()
+      {
+      U_TRACE_CTOR(0, UJsonOnDemand, "")
+
+      vpos     =
+      vmatch   = U_NULLPTR;
+      num      =
+      capacity = 0;
+      }
+
+   explicit UJsonOnDemand(const UString& json)
+      {
+      U_TRACE_CTOR(0, UJsonOnDemand, "%V", json.rep)
+
+      vpos     =
+      vmatch   = U_NULLPTR;
+      num      =
+      capacity = 0;
+
+      (void) parse(json);
+      }
+
+   ~UJsonOnDemand();
+
+   // STAGE 1
+
+   bool parse(const UString& json);
+
+   void clear()
+      {
+      U_TRACE_NO_PARAM(0, "UJsonOnDemand::clear()")
+
+      num = 0;
+
+      document.clear();
+      }
+
+   uint32_t size() const   { return num; }
+   bool     empty() const  { return (num == 0); }
+
+   UString getDocument() const { return document; }
+
+   // STAGE 2
+
+   int      getType(uint32_t i) const __pure; // U_OBJECT_VALUE, U_ARRAY_VALUE, U_STRING_VALUE, U_REAL_VALUE, U_TRUE_VALUE, U_FALSE_VALUE, U_NULL_VALUE (-1 if invalid)
+   uint32_t skip(uint32_t i) const __pure;    // the position that follow the value
+
+   uint32_t getFirst(uint32_t i) const __pure; // the first element of the container (U_NOT_FOUND if empty)
+   uint32_t getNext( uint32_t j) const __pure; // the element that follow in the container (U_NOT_FOUND at the end)
+
+   static uint32_t getMemberValue(uint32_t j) { return j+3; } // key '"' '"' ':' value
+
+   uint32_t getNumElement(uint32_t i) const __pure;
+
+   uint32_t at(uint32_t i, uint32_t index) const __pure;
+   uint32_t findKey(uint32_t i, const char* key, uint32_t key_len) const __pure; // NB: the key is compared without to decode the escapes...
+
+   uint32_t findKey(uint32_t i, const UString& key) const { return findKey(i, U_STRING_TO_PARAM(key)); }
+
+   UString getValue( uint32_t i) const; // string (without quotes and escapes not decoded), container (with the brackets) or scalar
+   UString getString(uint32_t i) const; // string with the escapes decoded
+
+   // same semantic of UValue::jfind() (the query must be quoted) but only the keys of the objects are considered
+
+   bool jfind(const char* query, uint32_t query_len, UString& result) const;
+
+   bool jfind(const UString& query, UString& result) const { return jfind(U_STRING_TO_PARAM(query), result); }
+
+   // same query syntax of UValue::jread() ("{'key'", "{N", "{*", "[N", "[*"), return the type of the result (-1 if not found)
+
+   int jread(const UString& query, UString& result, uint32_t* queryParams = U_NULLPTR) const;
+
+#ifdef DEBUG
+   const char* dump(bool _reset) const;
+#endif
+
+protected:
+   UString document;
+   uint32_t* vpos;
+   uint32_t* vmatch; // for every container the position of its closing bracket
+   uint32_t num, capacity;
+
+   char getChar(uint32_t i) const { return document.c_char(vpos[i]); }
+
+   bool isMember(uint32_t j) const { return (getChar(j) == '"' && (j+3) < num && getChar(j+2) == ':'); }
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UJsonOnDemand)
+};
+
 class U_EXPORT UJsonTypeHandler_Base {
 public:
    // Check for memory error
@@ -1293,6 +1550,7 @@ template <class T> void JSON_stringify(UString& str, UValue& json, T& obj)
    UJsonTypeHandler<T>(obj).toJSON();
 
    json.value.ival = UValue::o.ival;
+   json.parena     = UValue::arena;
 
    UValue::stringify(str, json);
 }
@@ -1959,7 +2217,8 @@ public:
 
       U_INTERNAL_DUMP("pval(%p) = %p rep(%p) = %V", pval, ((UString*)pval)->rep, rep, rep)
 
-      ((UString*)pval)->_assign(rep);
+      if (json.isArena()) (void) ((UString*)pval)->assign(U_STRING_TO_PARAM(*rep));
+      else                       ((UString*)pval)->_assign(rep);
 
       U_INTERNAL_ASSERT(((UString*)pval)->invariant())
       }
@@ -2467,7 +2726,8 @@ public:
                                                                                                                                \
             UJsonTypeHandler<type>(accessQualifier pitem).fromJSON(*pelement);                                                 \
                                                                                                                                \
-            UString key = UString((UStringRep*)u_getPayload(pelement->pkey.ival));                                             \
+            UStringRep* rep = (UStringRep*)u_getPayload(pelement->pkey.ival);                                                  \
+            UString key = (pelement->isArena() ? UString(U_STRING_TO_PARAM(*rep)) : UString(rep));                             \
                                                                                                                                \
             U_INTERNAL_DUMP("pelement->pkey(%p) = %V", key, key.rep)                                                           \
                                                                                                                                \
@@ -54,6 +54,15 @@ public:
       // --------------> maybe unnamed array of char for gzip compression...
    } log_data;
 
+   typedef struct log_ring { // single producer (a preforked process or a thread) - single consumer (the flusher)
+      uint32_t head;    // written only by the producer (free running)
+      uint32_t tail;    // written only by the flusher  (free running)
+      uint32_t dropped; // lines lost because the ring was full
+      pid_t    owner;   // tid of the producer (0 => free)
+      uint64_t stamp;   // time (ns) of the oldest line not yet flushed
+      // --------------> array of char of size ring_size...
+   } log_ring;
+
    static log_date date;
    static const char* prefix;
    static uint32_t prefix_len;
@@ -74,6 +83,8 @@ public:
 #  endif
 
       if (UFile::isMapped()) UFile::munmap();
+
+      if (ring_area) UFile::munmap(ring_area, ring_map_size);
       }
 
    void reopen()
@@ -173,6 +184,15 @@ public:
       U_RETURN_STRING(result);
       }
 
+   // RING (every process or thread write on its own ring without lock, a background thread flush them on the log file)
+
+   bool isRing() const { return (ring_area != U_NULLPTR); }
+
+   void setRing(uint32_t nring, uint32_t size);
+
+   void flush(); // NB: must be called only by the flusher (and at close)...
+   void logRingStats(ULog* dest); // write on dest the number of flush, the flush latency and the lines dropped
+
    // LOCK
 
    void   lock() { if (_lock.sem) _lock.lock(); }
@@ -223,6 +243,9 @@ protected:
    uint32_t log_file_sz,
             log_gzip_sz;
    unsigned char flag[4];
+   char* ring_area;
+   uint64_t ring_latency_sum, ring_latency_max, ring_check; // ns
+   uint32_t ring_num, ring_size, ring_map_size, ring_nflush, ring_dropped;
 
 #ifdef DEBUG
    ULog* next;
@@ -232,6 +255,7 @@ protected:
    void startup();
    void closeLogInternal();
    void write(const struct iovec* iov, int n);
+   void writeMapped(const struct iovec* iov, int n);
    void logResponse(const UString& data,  const char* format, uint32_t fmt_size, ...);
    void log(const struct iovec* iov, const char* type, int ncount, const char* msg, uint32_t msg_len, const char* format, uint32_t fmt_size, ...);
 
@@ -250,6 +274,9 @@ protected:
 private:
    static int decode(const char* name, uint32_t len, bool bfacility) __pure U_NO_EXPORT;
 
+   log_ring* getRing() U_NO_EXPORT;
+   bool writeRing(const struct iovec* iov, int n) U_NO_EXPORT;
+
    U_DISALLOW_COPY_AND_ASSIGN(ULog)
 
    friend class ULib;
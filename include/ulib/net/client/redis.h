@@ -54,6 +54,10 @@
 #define U_RC_ERR_DATA_FORMAT          -106
 #define U_RC_ERR_DATA_BUFFER_OVERFLOW -107
 
+#ifndef U_RC_ASYNC_QUEUE_SZ
+#define U_RC_ASYNC_QUEUE_SZ 1024 // NB: must be a power of 2...
+#endif
+
 /**
  * @class UREDISClient
  *
@@ -63,12 +67,15 @@
 typedef void (*vPFcs)  (const UString&);
 typedef void (*vPFcscs)(const UString&,const UString&);
 
+class UREDISClient_Base;
 class UREDISClusterMaster;
 
+typedef void (*vPFrcpv)(UREDISClient_Base*,void*);
+
 class U_EXPORT UREDISClient_Base : public UClient_Base {
 public:
 
-   ~UREDISClient_Base() { U_TRACE_DTOR(0, UREDISClient_Base); }
+   ~UREDISClient_Base();
 
    // RESPONSE
 
@@ -733,6 +740,31 @@ public:
 
    bool processMultiRequest(const char* format, uint32_t fmt_size, ...);
 
+   // ASYNC (pipelined with multiplexed replies)
+
+   /**
+    * The commands issued in the same iteration of the event loop are appended to a single buffer and written to the socket
+    * with one syscall when the notifier report the socket writable (EPOLLOUT), so many commands are in flight on the same
+    * connection. The replies of RESP come back in the same order of the commands, so they are demultiplexed with a FIFO of
+    * (callback, arg): for every complete reply the callback is called with vitem and getError() set as for the synchronous API.
+    * Without the event loop (setAsync() not called) the commands are sent by asyncFlush() and the replies are drained by
+    * asyncWait(). A synchronous command first drain the pending replies...
+    *
+    * NB: inside a callback use only the async API (the response buffer is shared)...
+    */
+
+   bool setAsync(); // register the connection with UNotifier
+
+   bool asyncCommand(vPFrcpv callback, void* arg, const char* cmd, uint32_t len); // NB: the command must be terminated by CRLF...
+   bool asyncRequest(vPFrcpv callback, void* arg, const char* format, uint32_t fmt_size, ...);
+
+   int getError() const { return err; } // U_RC_OK, U_RC_ERROR (the reply is "-ERR ...") or U_RC_ERR_CONECTION_CLOSE
+
+   uint32_t asyncPending() const { return async_num; }
+
+   bool asyncFlush();
+   bool asyncWait();
+
    // REDI-SEARCH (@see https://oss.redislabs.com/redisearch/)
 
    bool suggest(const char* key, uint32_t keyLength, const char* prefix, uint32_t prefixLength, bool fuzzy, bool withPayloads)
@@ -753,7 +785,45 @@ public:
 #endif
 
 protected:
+   class U_NO_EXPORT UAsyncHandler : public UEventFd {
+   public:
+
+      // Check for memory error
+      U_MEMORY_TEST
+
+      // Allocator e Deallocator
+      U_MEMORY_ALLOCATOR
+      U_MEMORY_DEALLOCATOR
+
+      UREDISClient_Base* pclient;
+
+      explicit UAsyncHandler(UREDISClient_Base* p) : pclient(p) {}
+
+      // define method VIRTUAL
+
+      virtual int handlerRead() U_DECL_FINAL  { return pclient->asyncHandlerRead(); }
+      virtual int handlerWrite() U_DECL_FINAL { return pclient->asyncHandlerWrite(); }
+
+      virtual void handlerDelete() U_DECL_FINAL // NB: the handler is owned by the client, not by the notifier...
+         {
+         U_TRACE_NO_PARAM(0, "UAsyncHandler::handlerDelete()")
+
+         fd = -1;
+
+         pclient->asyncReset();
+         }
+   };
+
+   typedef struct async_info {
+      vPFrcpv callback;
+      void* arg;
+   } async_info;
+
    int err;
+   UString async_buffer;     // the commands queued but not yet written
+   async_info* async_queue;  // ring of the callbacks of the commands in flight
+   UAsyncHandler* pasync;
+   uint32_t async_first, async_num, async_consumed;
 
    static uint32_t start;
    static ptrdiff_t diff;
@@ -764,7 +834,10 @@ protected:
       {
       U_TRACE_CTOR(0, UREDISClient_Base, "")
 
-      err = 0;
+      err         = 0;
+      async_queue = U_NULLPTR;
+      pasync      = U_NULLPTR;
+      async_first = async_num = async_consumed = 0;
       }
 
    void init();
@@ -914,6 +987,12 @@ protected:
 private:
    bool getResponseItem() U_NO_EXPORT;
 
+   int  asyncHandlerRead() U_NO_EXPORT;
+   int  asyncHandlerWrite() U_NO_EXPORT;
+   void asyncReset() U_NO_EXPORT;
+   void asyncDispatch() U_NO_EXPORT;
+   bool asyncConnect() U_NO_EXPORT;
+
    friend class UREDISClusterMaster;
 
    U_DISALLOW_COPY_AND_ASSIGN(UREDISClient_Base)
@@ -695,6 +695,7 @@ public:
    static bPFpc callerIsValidMethod;
    static iPF callerHandlerRead;
    static vPF callerHandlerRequest;
+   static vPFpv callerHandlerDelete; // NB: to know when a connection with a request pending (f.e. proxy) is closed...
    static bPFpcu callerIsValidRequest, callerIsValidRequestExt;
 
    // NB: these are for ULib Servlet Page (USP) - USP_PRINTF...
@@ -720,9 +721,8 @@ public:
 protected:
    USocket* socket;
 #ifdef U_THROTTLING_SUPPORT
-   UString uri;
    uint64_t bytes_sent;
-   uint32_t min_limit, max_limit, started_at;
+   uint32_t throttling_rule, throttling_sending, min_limit, started_at; // NB: mask of the rules matching the uri requested...
 #endif
    UString* data_pending;
    off_t offset, count;
@@ -885,6 +885,7 @@ private:
                       friend class UNoCatPlugIn;
                       friend class UServer_Base;
                       friend class UStreamPlugIn;
+                      friend class UTimeoutClient;
                       friend class UBandWidthThrottling;
 
    template <class T> friend class UServer;
@@ -14,10 +14,346 @@
 #ifndef U_MOD_PROXY_H
 #define U_MOD_PROXY_H 1
 
+#include <ulib/timer.h>
 #include <ulib/net/tcpsocket.h>
 #include <ulib/net/client/http.h>
 #include <ulib/net/server/server_plugin.h>
 
+#ifndef U_PROXY_MAX_IDLE
+#define U_PROXY_MAX_IDLE 16 // max number of idle keep-alive connections for upstream (for worker)
+#endif
+
+class UProxyPlugIn;
+class UProxyConnection;
+class UModProxyService;
+class UClientImage_Base;
+class UModProxyUpstream;
+
+/**
+ * The keep-alive connections of the worker to an upstream (server:port). The address is resolved only once: for the upstream
+ * of the configuration before the fork of the workers (handlerRun), for a server that depend on the request only when it is
+ * an address (the resolution of a name would block the event loop, such request are managed in a child process)...
+ */
+
+class U_NO_EXPORT UProxyPool {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UIPAddress addr;
+   UString server;
+   UProxyPool* next;
+   UProxyConnection* idle; // NB: list of the idle connections (the last used first)...
+   unsigned int port, nidle;
+   bool bresolved;
+
+   UProxyPool(const UString& _server, unsigned int _port) : server(_server)
+      {
+      U_TRACE_CTOR(0, UProxyPool, "%V,%u", _server.rep, _port)
+
+      next  = U_NULLPTR;
+      idle  = U_NULLPTR;
+      port  = _port;
+      nidle = 0;
+
+      bresolved = addr.setHostName(server);
+      }
+
+   static bool isAddress(const UString& name)
+      {
+      U_TRACE(0, "UProxyPool::isAddress(%V)", name.rep)
+
+      if (u_isIPv4Addr(U_STRING_TO_PARAM(name)) ||
+          u_isIPv6Addr(U_STRING_TO_PARAM(name)) ||
+          name.equal(U_CONSTANT_TO_PARAM("localhost")))
+         {
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
+   ~UProxyPool()
+      {
+      U_TRACE_DTOR(0, UProxyPool)
+      }
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UProxyPool)
+};
+
+/**
+ * The client side of a request in progress: while the response is streamed we take the place of the client image in the
+ * event loop (without EPOLLIN, so the client cannot send another request before the end of the response) and we ask for
+ * EPOLLOUT when the client is slower than the upstream. For a WebSocket it is the (detached) client side of the tunnel...
+ */
+
+class U_NO_EXPORT UProxyClient : public UEventFd {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   UProxyConnection* pconn;
+
+   explicit UProxyClient(UProxyConnection* p) : pconn(p) {}
+
+   // define method VIRTUAL of class UEventFd
+
+   virtual int  handlerRead() U_DECL_FINAL;
+   virtual int  handlerWrite() U_DECL_FINAL;
+   virtual void handlerDelete() U_DECL_FINAL;
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UProxyClient)
+};
+
+/**
+ * A non-blocking connection to an upstream. The request is sent as is, the response is forwarded to the client as it arrives
+ * (without buffering it all, chunked encoding included) and we only track the framing to know where it ends, so that the
+ * connection can come back to the pool. If the client doesn't keep up we stop reading from the upstream (backpressure)...
+ */
+
+class U_NO_EXPORT UProxyConnection : public UEventFd {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   enum State {
+      IDLE       =  0,
+      CONNECT    =  1, // connection in progress
+      HEADER     =  2, // waiting for the header of the response
+      LENGTH     =  3, // body with Content-Length
+      CHUNK_SIZE =  4,
+      CHUNK_EXT  =  5,
+      CHUNK_DATA =  6,
+      CHUNK_CRLF =  7,
+      TRAILER    =  8,
+      UNTIL_EOF  =  9, // body delimited by the close of the connection
+      DONE       = 10,
+      TUNNEL     = 11  // WebSocket
+   };
+
+    UProxyConnection();
+   ~UProxyConnection();
+
+   // define method VIRTUAL of class UEventFd
+
+   virtual int  handlerRead() U_DECL_FINAL;
+   virtual int  handlerWrite() U_DECL_FINAL;
+   virtual void handlerDelete() U_DECL_FINAL;
+
+   static bool isAsync(const UString& server);
+   static bool start(UClientImage_Base* pclient, const UString& server);
+   static void clear();
+   static void checkTimeout();
+   static void handlerDeleteClient(void* pclient);
+
+   static UProxyPool* getPool(const UString& server, unsigned int port);
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   UProxyClient client;
+   UString wbuffer, rbuffer; // request for the upstream (or data for the upstream in a tunnel) and response not yet forwarded
+   UString pending;          // data of the client after the Upgrade request (the first frames of the WebSocket), for the upstream after the 101
+   UTCPSocket* socket;
+   UProxyPool* pool;
+   UClientImage_Base* pclient;
+   UModProxyService* service;
+   UModProxyUpstream* upstream; // NB: U_NULLPTR if the server of the service depend on the request...
+   uint64_t remain;
+   time_t last_event; // NB: for the timeout (CONNECT_TIMEOUT, READ_TIMEOUT, IDLE_TIMEOUT of the service)...
+   uint32_t woffset, roffset, nparsed, line, ntry;
+   UProxyConnection** plist; // NB: the list where we are (idle of the pool, busy or free)...
+   UProxyConnection* prev;
+   UProxyConnection* next;
+   int state;
+   bool bhead, bclose, bkeepalive, breused, bwebsocket, bsent, bidempotent;
+
+   static UProxyPool* pools;
+   static UProxyConnection* busy; // request in progress (or tunnel)
+   static UProxyConnection* free_list;
+
+   void link(UProxyConnection** phead);
+   void unlink();
+
+   void reset();
+   void close();
+   bool connect();
+   void finish();
+   void abort(bool bgateway);
+   void detach();
+   void retry();
+   void sendRequest();
+   void readResponse();
+   bool writeResponse();
+   void processResponse();
+   void setMask(uint32_t mask);
+   void setBackPressure(bool bflag);
+   bool parseHeader(const char* ptr, uint32_t sz);
+
+   uint32_t scanBody(const char* ptr, uint32_t sz);
+
+   void startTunnel();
+   void closeTunnel();
+   void handlerTunnel(bool bupstream);
+
+   void clientHandlerRead();
+   void clientHandlerWrite();
+   void clientHandlerDelete();
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UProxyConnection)
+
+   friend class UProxyClient;
+};
+
+/**
+ * The active health check of an upstream: every HEALTH_INTERVAL seconds we send (non-blocking) a request for the uri HEALTH_CHECK,
+ * a 2xx/3xx response put the upstream up, any other response (or no response before the next check) put it down...
+ */
+
+class U_NO_EXPORT UProxyProbe : public UEventFd {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UProxyProbe(UModProxyService* service, UModProxyUpstream* upstream);
+   ~UProxyProbe();
+
+   // define method VIRTUAL of class UEventFd
+
+   virtual int  handlerRead() U_DECL_FINAL;
+   virtual int  handlerWrite() U_DECL_FINAL;
+   virtual void handlerDelete() U_DECL_FINAL;
+
+   void start();
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   UString request;
+   UTCPSocket* socket;
+   UProxyProbe* next;
+   UModProxyUpstream* upstream;
+   uint32_t woffset, rlen;
+   char rbuffer[16]; // NB: we need only the status line...
+
+   void close();
+   void setResult(bool bup);
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UProxyProbe)
+
+   friend class UProxyHealthCheck;
+};
+
+class U_NO_EXPORT UProxyHealthCheck : public UEventTime {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UProxyHealthCheck* next;
+
+   explicit UProxyHealthCheck(UModProxyService* service);
+           ~UProxyHealthCheck();
+
+   // define method VIRTUAL of class UEventTime
+
+   virtual int handlerTime() U_DECL_FINAL;
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
+#endif
+
+protected:
+   UProxyProbe* probes;
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UProxyHealthCheck)
+};
+
+/**
+ * The client fd of a request in progress is not a client image for the timeout of the server, so every second we check the
+ * connections in progress: no connection (CONNECT_TIMEOUT), no progress of the response (READ_TIMEOUT), no data in the tunnel (IDLE_TIMEOUT)...
+ */
+
+class U_NO_EXPORT UProxyTimeout : public UEventTime {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UProxyTimeout() : UEventTime(1L, 0L)
+      {
+      U_TRACE_CTOR(0, UProxyTimeout, "")
+      }
+
+   ~UProxyTimeout()
+      {
+      U_TRACE_DTOR(0, UProxyTimeout)
+      }
+
+   // define method VIRTUAL of class UEventTime
+
+   virtual int handlerTime() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(0, "UProxyTimeout::handlerTime()")
+
+      UProxyConnection::checkTimeout();
+
+      U_RETURN(0); // monitoring
+      }
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
+#endif
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UProxyTimeout)
+};
+
 class U_EXPORT UProxyPlugIn : public UServerPlugIn {
 public:
 
@@ -32,6 +368,8 @@ public:
    // Server-wide hooks
 
    virtual int handlerInit() U_DECL_FINAL;
+   virtual int handlerRun() U_DECL_FINAL;
+   virtual int handlerFork() U_DECL_FINAL;
 
    // Connection-wide hooks
 
@@ -44,6 +382,8 @@ public:
 #endif
 
 protected:
+   static UProxyTimeout* timeout;
+   static UProxyHealthCheck* health;
    static UHttpClient<UTCPSocket>* client_http;
 
 private:
@@ -22,7 +22,70 @@
 
 class UHTTP;
 class UCommand;
+class UProxyPool;
 class UFileConfig;
+class UModProxyTrie;
+class UModProxyService;
+
+template <class T> class UHashMap;
+
+/**
+ * An upstream (server:port) of a service. The health (passive: the errors of the requests, active: the probes of the plugin)
+ * is tracked by every worker...
+ */
+
+class U_EXPORT UModProxyUpstream {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UString server;
+   UProxyPool* pool; // NB: the keep-alive connections of the worker to the upstream (see mod_proxy)...
+   time_t fail_time;
+   uint32_t nconn, nfail;
+   int port;
+   bool bdown;
+
+   UModProxyUpstream(const UString& _server, int _port) : server(_server)
+      {
+      U_TRACE_CTOR(0, UModProxyUpstream, "%V,%d", _server.rep, _port)
+
+      pool      = U_NULLPTR;
+      fail_time = 0;
+      nconn     = nfail = 0;
+      port      = _port;
+      bdown     = false;
+      }
+
+   ~UModProxyUpstream()
+      {
+      U_TRACE_DTOR(0, UModProxyUpstream)
+      }
+
+   void setSuccess()
+      {
+      U_TRACE_NO_PARAM(0, "UModProxyUpstream::setSuccess()")
+
+      nfail = 0;
+      bdown = false;
+      }
+
+   void setFailure(uint32_t max_fails);
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+private:
+   U_DISALLOW_ASSIGN(UModProxyUpstream)
+};
 
 class U_EXPORT UModProxyService {
 public:
@@ -34,6 +97,12 @@ public:
    U_MEMORY_ALLOCATOR
    U_MEMORY_DEALLOCATOR
 
+   enum Balance {
+      ROUND_ROBIN = 0,
+      LEAST_CONN  = 1,
+      HASH        = 2  // consistent hash of the client address (or of the uri)
+   };
+
    enum Error {
       INTERNAL_ERROR            = 1, // NB: we need to start from 1 because we use a vector...
       BAD_REQUEST               = 2,
@@ -56,6 +125,8 @@ public:
    UString getPassword() const       { return password; }
 
    bool isWebSocket() const          { return websocket; }
+   bool isHealthCheck() const        { return (health_uri.empty() == false); }
+   bool isDynamicServer() const      { return vupstream.empty(); } // NB: the server depend on the request (SERVER $<... or SERVER ~...)
    bool isReplaceResponse() const    { return (vreplace_response.empty() == false); }
    bool isFollowRedirects() const    { return follow_redirects; }
    bool isResponseForClient() const  { return response_client; }
@@ -76,6 +147,21 @@ public:
 
    UString replaceResponse(const UString& msg);
 
+   // UPSTREAM
+
+   uint32_t getUpstreamNum() const   { return vupstream.size(); }
+   UString  getHealthCheck() const   { return health_uri; }
+   uint32_t getHealthInterval() const { return health_interval; }
+   uint32_t getMaxFails() const      { return max_fails; }
+
+   uint32_t getReadTimeout() const    { return read_timeout; }
+   uint32_t getIdleTimeout() const    { return idle_timeout; }
+   uint32_t getConnectTimeout() const { return connect_timeout; }
+
+   UModProxyUpstream* getUpstream(uint32_t i) { return vupstream[i]; }
+
+   UModProxyUpstream* selectUpstream(UModProxyUpstream* exclude = U_NULLPTR);
+
    // SERVICES
 
    UCommand* command;
@@ -90,6 +176,8 @@ public:
 
    static UModProxyService* findService(const UString& host, const UString& uri) { return findService(U_STRING_TO_PARAM(host), U_STRING_TO_PARAM(uri)); }
 
+   static void clear();
+
    // DEBUG
 
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
@@ -98,20 +186,37 @@ public:
 
 protected:
    UVector<UString> vreplace_response;
+   UVector<UModProxyUpstream*> vupstream;
    UVector<UIPAllow*>* vremote_address;
-   UString host_mask, server, user, password;
+   UString host_mask, server, user, password, health_uri;
 #ifdef USE_LIBPCRE
    UPCRE   uri_mask;
 #else
    UString uri_mask;
 #endif
-   int port, method_mask;
-   bool request_cert, follow_redirects, response_client, websocket;
+   uint64_t* ring; // NB: the points of the consistent hash (hash << 32 | index of the upstream) in order...
+   uint32_t index, nring, ring_size, rr, max_fails, fail_timeout, health_interval, connect_timeout, read_timeout, idle_timeout;
+   int port, method_mask, balance;
+   bool request_cert, follow_redirects, response_client, websocket, bhash_uri;
+
+   // NB: the table of the services is compiled in a map keyed by host and, for every host, in a prefix trie of the uri...
+
+   static UModProxyTrie* tany;
+   static UHashMap<UModProxyTrie*>* thost;
+
+   static void compile();
+   static UString getUriPrefix(const UString& mask);
+
+   bool isMatch(const char* host, uint32_t host_len, const char* uri, uint32_t uri_len);
+   bool isAvailable(UModProxyUpstream* up, UModProxyUpstream* exclude) const __pure;
+
+   void setUpstream(const UString& x);
 
 private:
    U_DISALLOW_ASSIGN(UModProxyService)
 
    friend class UHTTP;
+   friend class UModProxyTrie;
 };
 
 #endif
@@ -43,6 +43,21 @@
 #define U_DB_BUSY_ARRAY_SIZE 256
 #endif
 
+#ifdef U_THROTTLING_SUPPORT
+#define U_THROTTLING_RULE_MAX 32 // NB: the rules matching an uri are kept as a bit mask...
+#endif
+
+#ifdef U_EVASIVE_SUPPORT
+#define U_EVASIVE_NUM_SLOT  (32*1024) // NB: must be a power of 2...
+#define U_EVASIVE_MAX_PROBE 8         // NB: the slots where a key can be (neighbourhood of the CLOCK sweep)...
+#define U_EVASIVE_CMS_DEPTH 4
+#define U_EVASIVE_CMS_WIDTH (8*1024)  // NB: must be a power of 2...
+#endif
+
+#ifdef USE_LIBSSL
+#define U_SSL_TICKET_KEY_NUM 3 // NB: the key next to the current is the one that is overwritten by the rotation...
+#endif
+
 /**
  * @class UServer
  *
@@ -134,6 +149,7 @@ class USSEThread;
 class Application;
 class UTimeThread;
 class UFileConfig;
+class UShardCache;
 class UHttpPlugIn;
 class UFCGIPlugIn;
 class USCGIPlugIn;
@@ -151,6 +167,7 @@ class UClientThread;
 class UHttpClient_Base;
 class UWebSocketPlugIn;
 class UModProxyService;
+class UTimeoutClient;
 class UTimeoutConnection;
 
 template <class T> class URDBObjectHandler;
@@ -198,6 +215,9 @@ public:
    // LOG_FILE_SZ   memory size for file log
    // LOG_MSG_SIZE  limit length of print network message to LOG_MSG_SIZE chars (default 128)
    //
+   // LOG_RING_SIZE      size (KB) of the ring where every worker buffer its lines for the memory mapped file log (default 64, 0 => disable)
+   // LOG_FLUSH_INTERVAL time (ms) between the write of the rings on the file log by the flusher thread (default 20)
+   //
    // PLUGIN        list of plugins to load, a flexible way to add specific functionality to the server
    // PLUGIN_DIR    directory where there are plugins to load
    //
@@ -205,6 +225,7 @@ public:
    // ORM_DRIVER_DIR directory where there are ORM drivers to load
    //
    // REQ_TIMEOUT    timeout for request from client
+   // TIMER_WHEEL    flag to keep the timers in a hierarchical timing wheel with one timer for connection to check REQ_TIMEOUT
    // MAX_KEEP_ALIVE Specifies the maximum number of requests that can be served through a Keep-Alive (Persistent) session.
    //                (Value <= 0 will disable Keep-Alive)
    //
@@ -250,7 +271,7 @@ public:
 #endif
 
    static UFileConfig* pcfg;
-   static bool bssl, bipc, budp, brng, flag_loop;
+   static bool bssl, bktls, bipc, budp, brng, flag_loop;
    static unsigned int port; // the port number to bind to
 
    static int          getReqTimeout()  { return (ptime ? ptime->UTimeVal::tv_sec : 0); }
@@ -331,6 +352,15 @@ public:
    //                                                                    >1 - pool of serialized processes plus monitoring process
    // ----------------------------------------------------------------------------------------------------------------------------
 
+#ifdef U_THROTTLING_SUPPORT
+   typedef struct uthrottling_bucket { // NB: token bucket of a rule of bandwidth throttling, updated only with atomic operation...
+      int64_t  tokens;    // bytes that can be sent (negative => debt)
+      uint64_t refill_ms; // time of the last refill
+      uint64_t bytes;     // STATS: bytes sent
+      uint32_t min_limit, max_limit, num_sending, nrequest, nrefused;
+   } uthrottling_bucket;
+#endif
+
    typedef struct shared_data {
    // ---------------------------------
       uint32_t cnt_usr1;
@@ -361,7 +391,6 @@ public:
    // ---------------------------------
       sem_t lock_user1;
       sem_t lock_user2;
-      sem_t lock_throttling;
       sem_t lock_rdb_server;
       sem_t lock_data_session;
 #  ifndef U_HTTP3_DISABLE
@@ -370,6 +399,10 @@ public:
 #  ifdef USE_LIBSSL
       sem_t lock_ssl_session;
    // ------------------------------------------------------------------------------
+      long     ssl_ticket_key_time;  // time of the last rotation of the key
+      uint32_t ssl_ticket_key_index; // key for the new tickets (the previous one is accepted too)
+      unsigned char ssl_ticket_key[U_SSL_TICKET_KEY_NUM][80]; // name(16) + aes key(32) + hmac key(32)
+   // ------------------------------------------------------------------------------
 #    if defined(ENABLE_THREAD) && !defined(OPENSSL_NO_OCSP) && defined(SSL_CTRL_SET_TLSEXT_STATUS_REQ_CB)
       uint32_t   len_ocsp_staple;
       uint32_t valid_ocsp_staple;
@@ -378,6 +411,10 @@ public:
    // ------------------------------------------------------------------------------
 #  endif
    // ------------------------------------------------------------------------------
+#  ifdef U_THROTTLING_SUPPORT
+      uthrottling_bucket throttling_bucket[U_THROTTLING_RULE_MAX];
+#  endif
+   // ------------------------------------------------------------------------------
 #  ifdef U_SSE_ENABLE // SERVER SENT EVENTS (SSE)
       sem_t lock_sse;
 #   ifdef USE_LIBSSL
@@ -439,10 +476,13 @@ public:
 #define U_SRV_LOCK_SSE            &(UServer_Base::ptr_shared_data->lock_sse)
 #define U_SRV_LOCK_SSE_SSL        &(UServer_Base::ptr_shared_data->lock_sse_ssl)
 #define U_SRV_LOCK_DB_HTTP3       &(UServer_Base::ptr_shared_data->lock_db_http3)
-#define U_SRV_LOCK_THROTTLING     &(UServer_Base::ptr_shared_data->lock_throttling)
 #define U_SRV_LOCK_RDB_SERVER     &(UServer_Base::ptr_shared_data->lock_rdb_server)
 #define U_SRV_LOCK_SSL_SESSION    &(UServer_Base::ptr_shared_data->lock_ssl_session)
+#define U_SRV_SSL_TICKET_KEY        UServer_Base::ptr_shared_data->ssl_ticket_key
+#define U_SRV_SSL_TICKET_KEY_TIME   UServer_Base::ptr_shared_data->ssl_ticket_key_time
+#define U_SRV_SSL_TICKET_KEY_INDEX  UServer_Base::ptr_shared_data->ssl_ticket_key_index
 #define U_SRV_LOCK_DATA_SESSION   &(UServer_Base::ptr_shared_data->lock_data_session)
+#define U_SRV_THROTTLING_BUCKET     UServer_Base::ptr_shared_data->throttling_bucket
 
    static ULock* lock_user1;
    static ULock* lock_user2;
@@ -452,6 +492,25 @@ public:
    static bool update_date, update_date1, update_date2, update_date3;
 
 #define U_SHM_LOCK_NENTRY 512
+#define U_SHM_LOCK_SHARD_NENTRY 64 // NB: must be a power of 2...
+
+#ifdef U_EVASIVE_SUPPORT
+   typedef struct uevasive_slot { // NB: sliding window counter of a key, updated only with atomic operation...
+      uint64_t key;    // hash of the key (0 => free slot)
+      uint64_t window; // start of the current window (ms)
+      uint32_t count;  // hits in the current window
+      uint32_t prev;   // hits in the previous window
+      uint32_t hold;   // for the address of a client: blacklisted until this time (sec)
+      uint32_t ref;    // CLOCK reference bit
+   } uevasive_slot;
+
+   typedef struct uevasive_table {
+      uint32_t cms_epoch; // start of the period counted by the count-min sketch (sec)
+      uint32_t nblacklist, nevicted, nrefused; // STATS
+      uint32_t cms[U_EVASIVE_CMS_DEPTH][U_EVASIVE_CMS_WIDTH];
+      uevasive_slot slot[U_EVASIVE_NUM_SLOT];
+   } uevasive_table;
+#endif
 
    typedef struct shm_data {
    // ---------------------------------
@@ -459,27 +518,39 @@ public:
    // ---------------------------------
       sem_t lock_user1;
       sem_t lock_user2;
-      sem_t lock_evasive;
       sem_t lock_websock;
       sem_t lock_db_not_found;
    // ---------------------------------
       sem_t lock_base[U_SHM_LOCK_NENTRY];
+   // ---------------------------------
+      sem_t lock_shard_cache[U_SHM_LOCK_SHARD_NENTRY];
    // ---------------------------------
       ULog::log_data log_data_shared;
    // ---------------------------------
+#  ifdef U_EVASIVE_SUPPORT
+      uevasive_table evasive_table;
+#  endif
+   // ---------------------------------
    // -> maybe unnamed array of char for gzip compression (apache log like rotate)
    } shm_data;
 
    static shm_data* ptr_shm_data;
    static uint32_t shm_data_add, shm_size;
 
+   // NB: cache shared by the preforked processes for the plugins and the USP pages (see SHARD_CACHE), U_NULLPTR if not configured...
+
+   static UShardCache* shard_cache;
+   static UString* shard_cache_path;
+   static uint32_t shard_cache_size;
+
 #define U_SHM_LOCK_USER1          &(UServer_Base::ptr_shm_data->lock_user1)
 #define U_SHM_LOCK_USER2          &(UServer_Base::ptr_shm_data->lock_user2)
-#define U_SHM_LOCK_EVASIVE        &(UServer_Base::ptr_shm_data->lock_evasive)
 #define U_SHM_LOCK_WEBSOCK        &(UServer_Base::ptr_shm_data->lock_websock)
 #define U_SHM_LOCK_DB_NOT_FOUND   &(UServer_Base::ptr_shm_data->lock_db_not_found)
 #define U_SHM_LOCK_BASE           &(UServer_Base::ptr_shm_data->lock_base)
+#define U_SHM_LOCK_SHARD_CACHE      (UServer_Base::ptr_shm_data->lock_shard_cache)
 #define U_SHM_LAST_TIME_EMAIL_DOS   UServer_Base::ptr_shm_data->last_time_email_dos
+#define U_SHM_EVASIVE_TABLE       &(UServer_Base::ptr_shm_data->evasive_table)
 
 #ifdef USE_LOAD_BALANCE
    static UString* ifname;
@@ -558,6 +629,19 @@ public:
    static UClientImage_Base* pClientImage;
    static UClientImage_Base* eClientImage;
 
+   static bool isClientImage(const void* item) // NB: the notifier can have also handler of plugin (f.e. the upstream of proxy)...
+      {
+      U_TRACE(0, "UServer_Base::isClientImage(%p)", item)
+
+      if (item >= (const void*)vClientImage &&
+          item <  (const void*)eClientImage)
+         {
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
    static bool isPreForked()
       {
       U_TRACE_NO_PARAM(0, "UServer_Base::isPreForked()")
@@ -656,6 +740,10 @@ public:
    static ULog* log;
    static ULog* apache_like_log;
    static UVector<file_LOG*>* vlog;
+   static uint32_t log_ring_size, log_flush_interval;
+#if defined(U_LINUX) && defined(ENABLE_THREAD)
+   static UThread* pthread_log; // flusher of the log rings
+#endif
 
    static void  closeLog();
    static void reopenLog()
@@ -898,7 +986,7 @@ protected:
    static USmtpClient* emailClient;
    static long last_time_email_crash;
    static UString* crashEmailAddress;
-   static bool monitoring_process, set_realtime_priority, public_address, binsert, baffinity, set_tcp_keep_alive, called_from_handlerTime;
+   static bool monitoring_process, set_realtime_priority, public_address, binsert, baffinity, set_tcp_keep_alive, called_from_handlerTime, timer_wheel;
 
    static uint32_t                 vplugin_size;
    static UVector<UString>*        vplugin_name;
@@ -911,6 +999,13 @@ protected:
    static void runLoop(const char* user);
    static bool handlerTimeoutConnection(void* cimg);
 
+   // NB: with TIMER_WHEEL every connection has its own timer to check REQ_TIMEOUT (instead of a scan of all the connections)...
+
+   static UTimeoutClient* vClientTimeout;
+
+   static void insertTimeoutClient(UClientImage_Base* cimg);
+   static void  eraseTimeoutClient(UClientImage_Base* cimg);
+
    static bool isReqTimeout(void* cimg)
       {
       U_TRACE(0, "UServer_Base::isReqTimeout(%p)", cimg)
@@ -1015,60 +1110,39 @@ protected:
                                  throttling_rec->krate, throttling_rec->min_limit, throttling_rec->max_limit, throttling_rec->num_sending);
       }
 
-   static bool         throttling_chk;
-   static UString*     throttling_mask;
-   static uthrottling* throttling_rec;
-   static URDBObjectHandler<UDataStorage*>* db_throttling;
+   typedef struct uthrottling_glob { // NB: pattern with wildcard of a rule (point in throttling_mask)...
+      const char* pattern;
+      uint32_t len, mask;
+      char type; // 'p' => prefix*, 's' => *suffix, 'g' => generic (u_dosmatch)
+   } uthrottling_glob;
+
+   static UString*            throttling_mask;
+   static uthrottling*        throttling_rec;
+   static uthrottling_glob*   throttling_glob;
+   static UHashMap<void*>*    throttling_exact; // pattern without wildcard => mask of the rules
+   static uthrottling_bucket* throttling_bucket;
+   static uint32_t            throttling_num_rule, throttling_num_glob;
 
-   static void clearThrottling();
+   static void clearThrottling(uint32_t mask);
    static bool checkThrottling();
-   static bool checkThrottlingBeforeSend(bool bwrite);
+   static bool checkThrottlingBeforeSend(bool bwrite, off_t& chunk);
+   static void chargeThrottling(uint32_t mask, uint32_t bytes);
 
    static void initThrottlingClient();
    static void initThrottlingServer();
+
+   static uint64_t getThrottlingTime() U_NO_EXPORT;
+   static uint32_t getThrottlingRule(const char* uri, uint32_t len);
+   static void     refillThrottling(uthrottling_bucket* pbucket, uint64_t now);
 #endif
 
 #ifdef U_EVASIVE_SUPPORT // provide evasive action in the event of an HTTP DoS or DDoS attack or brute force attack
-   typedef struct uevasive {
-      uint32_t timestamp, count;
-   } uevasive;
-
-   static void getEvasiveRecFromBuffer(const char* data, uint32_t datalen)
-      {
-      U_TRACE(0, "UServer_Base::getEvasiveRecFromBuffer(%.*S,%u)", datalen, data, datalen)
-
-      evasive_rec = (uevasive*)u_buffer;
-
-      u_buffer_len = sizeof(uevasive);
-
-      const char* ptr = data;
-
-      evasive_rec->timestamp = u_strtoulp(&ptr);
-      evasive_rec->count     = u_strtoulp(&ptr);
-
-      U_INTERNAL_DUMP("evasive_rec->timestamp = %u evasive_rec->count = %u", evasive_rec->timestamp, evasive_rec->count)
-
-      U_INTERNAL_ASSERT_EQUALS(ptr, data+datalen+1)
-      }
-
-   static void printEvasiveRecToBuffer(const char* data, uint32_t datalen)
-      {
-      U_TRACE(0, "UServer_Base::printEvasiveRecToBuffer(%.*S,%u)", datalen, data, datalen)
-
-      U_INTERNAL_ASSERT_EQUALS(datalen, sizeof(uevasive))
-
-      evasive_rec = (uevasive*)data;
-
-      u_buffer_len = u__snprintf(u_buffer, U_BUFFER_SIZE, U_CONSTANT_TO_PARAM("%u %u"), evasive_rec->timestamp, evasive_rec->count);
-      }
-
    static UFile* dos_LOG;
    static bool bwhitelist;
-   static uevasive* evasive_rec;
    static UString* systemCommand;
    static UString* dosEmailAddress;
    static UVector<UIPAllow*>* vwhitelist_IP;
-   static URDBObjectHandler<UDataStorage*>* db_evasive;
+   static uevasive_table* evasive_table;
    static uint32_t blocking_period, page_interval, page_count, site_interval, site_count;
 
    static void initEvasive();
@@ -1076,6 +1150,12 @@ protected:
    static bool checkHitSiteStats();
    static bool checkHold(in_addr_t client);
    static bool checkHitStats(const char* key, uint32_t key_len, uint32_t interval, uint32_t count);
+
+   static uint64_t getEvasiveTime() U_NO_EXPORT;
+   static uint64_t getEvasiveKey(const char* key, uint32_t key_len) U_NO_EXPORT;
+   static uint32_t hitEvasiveSketch(uint64_t key, uint64_t now);
+   static uint32_t hitEvasiveSlot(uevasive_slot* pslot, uint64_t now, uint32_t interval);
+   static uevasive_slot* findEvasiveSlot(uint64_t key, bool binsert, uint64_t now);
 #endif
 
 #ifdef U_SSE_ENABLE // SERVER SENT EVENTS (SSE)
@@ -1491,6 +1571,7 @@ private:
    friend class UWebSocketPlugIn;
    friend class UModProxyService;
    friend class UClientImage_Base;
+   friend class UTimeoutClient;
    friend class UTimeoutConnection;
    friend class UBandWidthThrottling;
 };
@@ -26,6 +26,7 @@
 #define USP_PRINTF(fmt,args...)     (UClientImage_Base::usp_buffer->snprintf(U_CONSTANT_TO_PARAM(fmt) , ##args),USP_PUTS_STRING(*UClientImage_Base::usp_buffer))
 #define USP_PRINTF_ADD(fmt,args...)  UClientImage_Base::wbuffer->snprintf_add(U_CONSTANT_TO_PARAM(fmt) , ##args)
 
+#define USP_JSON_ARENA              UValue::startRequestArena()
 #define USP_JSON_REQUEST_PARSE(obj) JSON_parse(*UHTTP::body,(obj))
 #define USP_JFIND_REQUEST(type,str) UValue::jfind(*UHTTP::body,#type,U_CONSTANT_SIZE(#type),(str))
 
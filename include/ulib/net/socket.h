@@ -107,7 +107,8 @@ public:
       SK_RAW        = 0x002,
       SK_UNIX       = 0x004,
       SK_SSL        = 0x008,
-      SK_SSL_ACTIVE = 0x010
+      SK_SSL_ACTIVE = 0x010,
+      SK_KTLS       = 0x020
    };
 
    USocket(bool bSocketIsIPv6 = false, int fd = -1);
@@ -231,6 +232,35 @@ public:
 #  endif
       }
 
+   // NB: with kTLS the kernel encrypt the records written on the socket, so sendfile() can be used also with SSL...
+
+   bool isKTLS() const
+      {
+      U_TRACE_NO_PARAM(0, "USocket::isKTLS()")
+
+      U_INTERNAL_DUMP("U_socket_Type = %d %B", U_socket_Type(this), U_socket_Type(this))
+
+#  ifdef USE_LIBSSL
+      if ((U_socket_Type(this) & SK_KTLS) != 0) U_RETURN(true);
+#  endif
+
+      U_RETURN(false);
+      }
+
+   void setKTLS(bool _flag)
+      {
+      U_TRACE(0, "USocket::setKTLS(%b)", _flag)
+
+#  ifdef USE_LIBSSL
+      U_ASSERT(isSSL())
+
+      if (_flag) U_socket_Type(this) |=  SK_KTLS;
+      else       U_socket_Type(this) &= ~SK_KTLS;
+
+      U_INTERNAL_DUMP("U_socket_Type = %d %B", U_socket_Type(this), U_socket_Type(this))
+#  endif
+      }
+
    /**
     * The getsockopt() function is called with the provided parameters to obtain the desired value
     */
@@ -819,6 +849,7 @@ protected:
 #  define SO_ATTACH_REUSEPORT_CBPF 51
 #  endif
    bool enable_bpf();
+   bool enable_bpf_quic(uint32_t n);
 #endif
 
    bool listen()
@@ -921,6 +952,8 @@ private:
                       friend class UClient_Base;
                       friend class UServer_Base;
                       friend class UStreamPlugIn;
+                      friend class UProxyProbe;
+                      friend class UProxyConnection;
                       friend class URDBClientImage;
                       friend class UHttpClient_Base;
                       friend class UClientImage_Base;
@@ -0,0 +1,107 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    udpbatch.h - batched UDP I/O (recvmmsg/sendmmsg, GRO/GSO)
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#ifndef ULIB_UDPBATCH_H
+#define ULIB_UDPBATCH_H 1
+
+#include <ulib/net/socket.h>
+
+#define U_UDP_BATCH          16 // number of datagrams read with one recvmmsg()
+#define U_UDP_BATCH_SIZE  65535 // size of a buffer of the batch (with GRO the kernel can coalesce up to 64k of datagrams of the same flow)
+#define U_UDP_MAX_SEGMENT    64 // UDP_MAX_SEGMENTS: number of datagrams sent with one sendmsg() with UDP_SEGMENT (GSO)
+#define U_UDP_MAX_GSO_SIZE 65507 // max size of the payload of a GSO super datagram
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+typedef struct mmsghdr u_mmsghdr;
+#else
+typedef struct u_mmsghdr { // NB: the same layout of struct mmsghdr...
+   struct msghdr msg_hdr;
+   unsigned int  msg_len;
+} u_mmsghdr;
+#endif
+
+/**
+ * Batched UDP I/O
+ *
+ * The datagrams are read U_UDP_BATCH at a time with recvmmsg(). With UDP_GRO the kernel can coalesce in one buffer of the batch more datagrams
+ * of the same flow, all of the same size (the segment size, returned by cmsg) except the last one, that are then returned one at a time by next().
+ *
+ * On send the packets (contiguous in memory) are sent with the minimum number of syscall: every run of packets of the same size (the last one
+ * can be shorter) is sent as one GSO super datagram with sendmsg() and UDP_SEGMENT. If GSO is not available (old kernel or no checksum offload
+ * on the device) we fall back to sendmmsg() with one message for each packet.
+ *
+ * NB: without recvmmsg() or sendmmsg() (see configure) the batch is of one datagram read with recvmsg() and the packets are sent one at a time...
+ */
+
+class U_EXPORT UUDPBatch {
+public:
+
+   static bool bgso, bgro;
+   static char rcontrol[CMSG_SPACE(sizeof(int))]; // NB: for the segment size of the datagrams coalesced by GRO read with recvmsg() (io_uring)...
+
+   static void init(int fd, bool bgro_enable);
+
+   static int      read(int fd, bool bwait_for_data);
+   static uint32_t next(char* buffer, uint32_t size, struct sockaddr_storage* peer, uint32_t* peer_len);
+   static uint32_t split(struct msghdr* msg, const char* data, uint32_t len); // NB: for the datagram read with recvmsg() (io_uring)...
+   static bool     send(int fd, const struct sockaddr* peer, uint32_t peer_len, const uint8_t* ptr, const uint32_t* vsize, uint32_t n);
+
+   static uint32_t getSegmentSize(struct msghdr* msg, uint32_t len)
+      {
+      U_TRACE(0, "UUDPBatch::getSegmentSize(%p,%u)", msg, len)
+
+      int segment;
+
+      for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg))
+         {
+         if (cmsg->cmsg_level == SOL_UDP &&
+             cmsg->cmsg_type  == UDP_GRO)
+            {
+            U_MEMCPY(&segment, CMSG_DATA(cmsg), sizeof(int));
+
+            if (segment > 0 &&
+                (uint32_t)segment < len)
+               {
+               U_RETURN(segment);
+               }
+            }
+         }
+
+      U_RETURN(len);
+      }
+
+protected:
+   static struct iovec viov[U_UDP_BATCH];
+   static u_mmsghdr vmsg[U_UDP_BATCH];
+   static struct sockaddr_storage vpeer[U_UDP_BATCH];
+   static char vcontrol[U_UDP_BATCH][CMSG_SPACE(sizeof(int))];
+   static char batch_buffer[U_UDP_BATCH][U_UDP_BATCH_SIZE];
+   static uint32_t batch_count, batch_index, batch_offset, vsegment[U_UDP_BATCH];
+
+   static bool sendSegments(int fd, const struct sockaddr* peer, uint32_t peer_len, const uint8_t* ptr, uint32_t len, uint32_t segment);
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UUDPBatch)
+};
+
+#endif
@@ -110,6 +110,8 @@ public:
    static void suspend(UEventFd* item);
    static void  resume(UEventFd* item, uint32_t flags = EPOLLOUT);
 
+   static void setReadOnce(); // NB: for an handler level triggered, it must not be called again in the same loop (EPOLLET postpone strategy)...
+
    static void waitForEvent1(                                                 UEventTime* ptimeout);
    static int  waitForEvent4(int fd_max, fd_set* read_set, fd_set* write_set, UEventTime* ptimeout);
 
@@ -145,6 +147,8 @@ public:
       // TODO: implement resume() for libevent
       }
 
+   static void setReadOnce() {}
+
    static int waitForEvent4(int fd_max, fd_set* read_set, fd_set* write_set, UEventTime* ptimeout)
       {
       U_TRACE(0, "UNotifier::waitForEvent4(%d,%p,%p,%p)", fd_max, read_set, write_set, ptimeout)
@@ -265,6 +269,9 @@ private:
    friend class UHttpPlugIn;
    friend class UApplication;
    friend class UServer_Base;
+   friend class UREDISClient_Base;
+   friend class UProxyProbe;
+   friend class UProxyConnection;
    friend class UClientImage_Base;
    friend class UClientThrottling;
 };
@@ -388,6 +388,7 @@ public:
    virtual void handlerError() U_DECL_FINAL;
    virtual void handlerDisConnect() U_DECL_FINAL;
    virtual void execute(USqlStatement* pstmt) U_DECL_FINAL;
+   virtual bool executeMany(USqlStatement* pstmt, uint32_t n, vPFu function, vPFu result) U_DECL_FINAL;
    virtual bool nextRow(USqlStatement* pstmt) U_DECL_FINAL;
    virtual void handlerStatementReset(USqlStatement* pstmt) U_DECL_FINAL;
    virtual void handlerStatementRemove(USqlStatement* pstmt) U_DECL_FINAL;
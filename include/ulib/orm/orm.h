@@ -223,6 +223,11 @@ public:
 
    void execute();
 
+   // Execute the statement n times: function(i) set the variables binded with use() for the row i, result(i) read the variables binded with into()
+   // (the drivers wrap a statement that NOT produces a result set in one transaction), return false on error
+
+   bool executeMany(uint32_t n, vPFu function, vPFu result = U_NULLPTR);
+
    // ASYNC with PIPELINE
 
    bool asyncPipelineProcessQueue(uint32_t n);
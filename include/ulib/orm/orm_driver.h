@@ -183,6 +183,8 @@ public:
       num_row_result  = current_row = 0;
 
       asyncPipelineHandlerResult = U_NULLPTR;
+
+      bcache = bused = false;
       }
 
    virtual ~USqlStatement()
@@ -235,6 +237,8 @@ public:
    UVector<USqlStatementBindParam*> vparam;
    UVector<USqlStatementBindResult*> vresult;
    uint32_t num_bind_param, num_bind_result, num_row_result, current_row;
+   UString sql;        // NB: the text of the statement (key for the cache of the prepared statement)...
+   bool bcache, bused; // NB: in the cache of the driver and used by a UOrmStatement...
 
    friend class UOrmDriver;
 };
@@ -257,6 +261,10 @@ public:
       errcode    = 0;
       SQLSTATE   = U_NULLPTR;
       connection = U_NULLPTR;
+
+      vstmt          = U_NULLPTR;
+      vstmt_size     =
+      vstmt_capacity = 0;
       }
 
    UOrmDriver(const UString& name_drv) : name(name_drv)
@@ -267,6 +275,10 @@ public:
       errcode    = 0;
       SQLSTATE   = U_NULLPTR;
       connection = U_NULLPTR;
+
+      vstmt          = U_NULLPTR;
+      vstmt_size     =
+      vstmt_capacity = 0;
       }
 
    virtual ~UOrmDriver();
@@ -338,6 +350,16 @@ public:
       handlerStatementRemove(pstmt);
       }
 
+   // CACHE of PREPARED STATEMENT (LRU keyed by the text of the statement, 0 -> disabled)
+
+   void setStatementCache(uint32_t n);
+   void clearStatementCache();
+
+   USqlStatement* getStatement(const char* stmt, uint32_t len); // NB: a statement of the cache is not prepared again...
+   void       releaseStatement(USqlStatement* pstmt);           // NB: a statement of the cache is only reset...
+
+   uint32_t getStatementCacheSize() const { return vstmt_size; }
+
    // ASYNC with PIPELINE
 
    static bool isAsyncPipelineModeAvaliable()
@@ -464,6 +486,14 @@ public:
       U_TRACE(0, "UOrmDriver::execute(%p)", pstmt)
       }
 
+   /**
+    * Executes the statement n times: before every execution function(i) set the values of the variables binded as param
+    * for the row i, after the execution (if not NULL) result(i) can read the variables binded as result. The drivers can
+    * wrap the executions of a statement that NOT produces a result set (write) in one transaction...
+    */
+
+   virtual bool executeMany(USqlStatement* pstmt, uint32_t n, vPFu function, vPFu result);
+
    virtual bool nextRow(USqlStatement* pstmt)
       {
       U_TRACE(0, "UOrmDriver::nextRow(%p)", pstmt)
@@ -560,6 +590,8 @@ public:
 protected:
    UString name, opt;
    UVector<UString> vopt; // NB: must be here to avoid DEAD OF SOURCE STRING WITH CHILD ALIVE...
+   USqlStatement** vstmt; // NB: the cache of prepared statement, the most recently used first...
+   uint32_t vstmt_size, vstmt_capacity;
 public:
    UString dbname;
    void* connection; // will be typecast into conn-specific type
@@ -16,6 +16,7 @@
 
 #include <ulib/tokenizer.h>
 #include <ulib/container/vector.h>
+#include <ulib/container/hash_map.h>
 
 class UQueryParser;
 
@@ -157,14 +158,77 @@ private:
 // override the default...
 template <> inline void u_destroy(const UQueryNode** ptr, uint32_t n) { U_TRACE(0,"u_destroy<UQueryNode*>(%p,%u)", ptr, n) }
 
+typedef bool     (*bPFpr)(UStringRep*);
+typedef uint32_t (*uPFpr)(UStringRep*);
+
+/**
+ * The compiled form of a boolean expression: the disjunctive normal form as a flat program. The distinct words are numbered
+ * and every term of the DNF is a sequence of instructions (the number of the word, with the bit U_QUERY_NOT for a negative)
+ * preceded by its length. With a cost function (ex. the number of documents of a word) the literals of a term are ordered
+ * to make the term false with the least evaluations (the rarest positive first, the commonest negative first) and the terms
+ * are ordered to make the expression true as soon as possible. The evaluation is short-circuit and the value of every word
+ * is computed only once. The program don't depend on the tree and can be shared (see UQueryParser::compile())...
+ */
+
+#define U_QUERY_NOT 0x80000000
+
+class U_EXPORT UQueryProgram {
+public:
+   // Check Memory
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+    UQueryProgram(UQueryNode* tree, uPFpr cost = U_NULLPTR);
+   ~UQueryProgram();
+
+   // SERVICES
+
+   bool evaluate(bPFpr function) const;
+
+   uint32_t getNumTerm() const { return nterm; }
+   uint32_t getNumWord() const { return vword.size(); }
+
+   UString getWord(uint32_t i) const { return vword[i]; }
+
+   // the words of the terms (for the evaluation with a set of document)
+
+   UVector<UString>* getPositives(uint32_t i) const { U_INTERNAL_ASSERT_MINOR(i, nterm) return positives[i]; }
+   UVector<UString>* getNegatives(uint32_t i) const { U_INTERNAL_ASSERT_MINOR(i, nterm) return negatives[i]; }
+
+   // STREAMS
+
+#ifdef U_STDCPP_ENABLE
+   friend U_EXPORT ostream& operator<<(ostream& os, const UQueryProgram& p);
+
+   // DEBUG
+
+# ifdef DEBUG
+   const char* dump(bool reset) const;
+# endif
+#endif
+
+protected:
+   UVector<UString> vword;          // the distinct words
+   UVector<UString>** positives;
+   UVector<UString>** negatives;
+   uint32_t* code;                  // for every term: the number of instructions, then the instructions
+   uint32_t nterm, ncode;
+
+private:
+   uint32_t addWord(const UString& w) U_NO_EXPORT;
+
+   U_DISALLOW_ASSIGN(UQueryProgram)
+};
+
 /**
  * Parser for a language of boolean expressions.
  * The parse() method dynamically allocates a binary tree of nodes that
  * represents the syntactic structure of a textual boolean expression
  */
 
-typedef bool (*bPFpr)(UStringRep*);
-
 class U_EXPORT UQueryParser {
 public:
 
@@ -181,7 +245,9 @@ public:
 
       U_INTERNAL_ASSERT_POINTER(UString::str_not);
 
-      tree = U_NULLPTR;
+      tree    = U_NULLPTR;
+      program = U_NULLPTR;
+      bcache  = false;
       }
 
    ~UQueryParser()
@@ -195,7 +261,7 @@ public:
 
    void clear();
 
-   UQueryNode* getTree() const { return tree; }
+   UQueryNode* getTree() const { return tree; } // NB: NULL after compile() with a hit on the cache...
 
    /**
     * Parses a textual boolean expression and creates a binary syntax tree.
@@ -213,9 +279,42 @@ public:
     * the AND a multiplicative operation, then the DNF is a sum of products
     */
 
-   bool evaluate() const;
+   bool evaluate() const
+      {
+      U_TRACE_NO_PARAM(0, "UQueryParser::evaluate()")
+
+      U_INTERNAL_ASSERT_POINTER(program)
+
+      if (program->evaluate(function)) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   void startEvaluate(bPFpr function, uPFpr cost = U_NULLPTR);
+
+   /**
+    * Compiles a textual boolean expression (as parse() and startEvaluate() without the tree) with the cache of the programs
+    * keyed by the normalized query (see setCache()), on a hit the query is not parsed...
+    *
+    * @param query text of the boolean expression to compile
+    * @param cost  the cost function of a word for the order of the evaluation (may be NULL)
+    */
+
+   bool compile(const UString& query, uPFpr cost = U_NULLPTR);
 
-   void startEvaluate(bPFpr function);
+   static void setCache(uint32_t max_program); // 0 -> disabled (default)
+   static void clearCache();
+
+   void setFunction(bPFpr func) { function = func; }
+
+   UQueryProgram* getProgram() const { return program; }
+
+   // the terms of the disjunctive normal form (after startEvaluate() or compile())
+
+   uint32_t getNumTerm() const { return (program ? program->getNumTerm() : 0); }
+
+   UVector<UString>* getPositives(uint32_t i) const { return program->getPositives(i); }
+   UVector<UString>* getNegatives(uint32_t i) const { return program->getNegatives(i); }
 
    // STREAMS
 
@@ -231,14 +330,14 @@ public:
 
 protected:
    UQueryNode* tree;
+   UQueryProgram* program;
    UString word;
    UTokenizer t;
+   bool bcache;
 
    static bPFpr function;
-   static uint32_t partial;
-   static UVector<UString>** positives;
-   static UVector<UString>** negatives;
-   static UVector<UQueryNode*>* termRoots;
+   static uint32_t cache_max;
+   static UHashMap<UQueryProgram*>* cache;
 
 private:
    // Implementation methods
@@ -293,11 +392,6 @@ private:
       U_RETURN(result);
       }
 
-   static inline bool pos_evaluate(void* word) U_NO_EXPORT;
-   static inline bool neg_evaluate(void* word) U_NO_EXPORT;
-
-   static void evaluate(UStringRep* word, bool positive) U_NO_EXPORT;
-
    U_DISALLOW_COPY_AND_ASSIGN(UQueryParser)
 };
 
@@ -46,6 +46,13 @@ public:
 
    // SERVICES
 
+   // SESSION TICKET (stateless resumption, TLS 1.3 PSK included): the keys are in the shared data of UServer so every child
+   // can decrypt the tickets of the others, and the rotation of the key is seen by all the children at once...
+
+   static long ticket_key_rotate; // period (seconds) for the rotation of the key (0 => session cache on db ../db/session.ssl)
+
+   static void initTicketKey();
+
 #if defined(DEBUG) && defined(U_STDCPP_ENABLE)
    const char* dump(bool reset) const { return UDataStorage::dump(reset); }
 #endif
@@ -58,10 +65,20 @@ private:
 
    static SSL_SESSION* getSession(SSL* ssl, unsigned char* id, int len, int* copy);
 
+   static void generateTicketKey(uint32_t idx) U_NO_EXPORT;
+   static void   rotateTicketKey() U_NO_EXPORT;
+
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+   static int ticketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* ectx, HMAC_CTX*    hctx, int enc);
+#else
+   static int ticketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* ectx, EVP_MAC_CTX* hctx, int enc);
+#endif
+
    U_DISALLOW_COPY_AND_ASSIGN(USSLSession)
 
    friend class UHTTP;
    friend class UHttpPlugIn;
+   friend class Application;
 };
 
 #endif
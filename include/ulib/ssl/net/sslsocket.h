@@ -264,6 +264,11 @@ public:
    static int OCSP_resp_callback(SSL* _ssl, void* data);
 #endif
 
+   // STATS (for process: full and resumed handshake, kTLS connection, CPU time spent in the handshake, the failed ones apart)
+
+   static uint32_t stats_handshake, stats_resumed, stats_ktls, stats_handshake_failed;
+   static uint64_t stats_handshake_time, stats_handshake_failed_time; // microseconds
+
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
    const char* dump(bool reset) const;
 #endif
@@ -344,6 +349,7 @@ private:
                       friend class UHTTP;
                       friend class USocket;
                       friend class UHttpPlugIn;
+                      friend class USSLSession;
                       friend class UClient_Base;
                       friend class UServer_Base;
                       friend class UClientImage_Base;
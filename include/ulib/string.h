@@ -100,6 +100,7 @@ class UHTTP;
 class UHTTP2;
 class UValue;
 class UCache;
+class UShardCache;
 class UValue;
 class UString;
 class UBase64;
@@ -1139,6 +1140,7 @@ private:
    friend class UHTTP;
    friend class UHTTP2;
    friend class UCache;
+   friend class UShardCache;
    friend class UValue;
    friend class UString;
    friend class UBase64;
@@ -465,10 +465,18 @@ private:
    friend class UServer_Base;
 };
 
-// UThreadPool class manages all the UThreadPool related activities. This includes keeping track of idle threads and snchronizations between all threads.
-// Using UThreadPool is advantageous only when the work to be done is really time consuming. (at least 1 or 2 seconds)
-
-class U_EXPORT UThreadPool : public UThread {
+/**
+ * UThreadPool is a pool of worker threads with work stealing. Every worker owns a bounded deque (Chase-Lev): the owner push and pop the
+ * tasks at the bottom without locking, a worker without work steal from the top of the deque of another worker (half of the tasks at once).
+ * The tasks submitted from outside the pool go in a shared queue from which the workers take them in batch. An idle worker spin for a while
+ * and then it park on a futex (a condition variable where the futex is not available), so the pool is efficient also for tasks of some microseconds.
+ *
+ * A task is a function with its argument (no allocation for task), the old interface with UThread objects is still available...
+ */
+
+#define U_THREAD_POOL_DEQUE_SIZE 1024 // must be a power of two
+
+class U_EXPORT UThreadPool {
 public:
    // Check for memory error
    U_MEMORY_TEST
@@ -482,38 +490,26 @@ public:
 
    // SERVICES
 
-   void addTask(UThread* task)
-      {
-      U_TRACE(0, "UThreadPool::addTask(%p)", task)
-
-      U_INTERNAL_ASSERT(active)
+   uint32_t size() const { return num_worker; }
 
-      lock(&tasks_mutex);
+   void addTask(vPFpv func, void* arg);
 
-      queue.push_back(task);
-
-      unlock(&tasks_mutex);
+   void addTask(UThread* th) // NB: the task object is deleted after its run()...
+      {
+      U_TRACE(0, "UThreadPool::addTask(%p)", th)
 
-      signal(&condition); // Waking up the threads so they will know there is a job to do
+      addTask((vPFpv)runThreadTask, th);
       }
 
    // This function gives the user the ability to send 10 tasks to the thread pool then to wait till
    // all the tasks completed, and give the next 10 which are dependand on the result of the previous ones
+   // (the caller help the workers to execute the pending tasks)
 
-   void waitForWorkToBeFinished()
-      {
-      U_TRACE_NO_PARAM(0, "UThreadPool::waitForWorkToBeFinished()")
-
-      lock(&tasks_mutex);
-
-      while (queue._length != 0) wait(&tasks_mutex, &condition_task_finished);
-
-      unlock(&tasks_mutex);
-      }
+   void waitForWorkToBeFinished();
 
-   // define method VIRTUAL of class UThread
+   // call func(arg, i) for i in [0,n) splitting the range in chunks of grain index (0 -> automatic), it return when all the calls are done
 
-   virtual void run() U_DECL_OVERRIDE;
+   void parallelFor(uint32_t n, vPFpvu func, void* arg, uint32_t grain = 0);
 
    // DEBUG
 
@@ -522,8 +518,34 @@ public:
 #endif
 
 protected:
-   UVector<UThread*> pool;  // Thread pool storage
-   UVector<UThread*> queue; // Queue to keep track of incoming tasks
+   typedef struct task {
+      vPFpv func;
+      void* arg;
+   } task;
+
+   typedef struct worker {
+      UThreadPool* pool;
+#  ifdef _MSWINDOWS_
+      HANDLE tid;
+#  else
+      pthread_t tid;
+#  endif
+      uint32_t rnd, index;
+      long top;
+      char pad[64]; // NB: the thieves write top, the owner write bottom (different cache line)...
+      long bottom;
+      task buffer[U_THREAD_POOL_DEQUE_SIZE];
+   } worker;
+
+   typedef struct loop { // the context of a parallelFor()
+      vPFpvu func;
+      void* arg;
+      uint32_t n, grain, next, ntask, nfinished;
+   } loop;
+
+   worker* vworker;
+   task* inject;     // queue for the tasks submitted from outside the pool (circular buffer)
+   uint32_t inject_head, inject_len, inject_size, num_worker, max_worker, num_running, pending, sleepers, searching, wake_seq, done_seq, num_waiter, max_spin;
    bool active;
 
 #ifdef _MSWINDOWS_
@@ -534,6 +556,57 @@ protected:
    pthread_cond_t condition, condition_task_finished; // Condition variable
 #endif
 
+   static worker* getWorker() __pure; // the worker of the current thread, if it is one of ours...
+
+   bool isToWakeUp() // NB: the caller must have published the tasks with a full barrier...
+      {
+      U_TRACE_NO_PARAM(0, "UThreadPool::isToWakeUp()")
+
+      if (__atomic_load_n(&sleepers,  __ATOMIC_RELAXED) &&
+          __atomic_load_n(&searching, __ATOMIC_RELAXED) == 0)
+         {
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
+   void run(worker* w);
+   bool getTask(worker* w, task& t);
+   void runTask(const task& t);
+   void wakeUp(uint32_t n);
+   bool stealTask(worker* w, task& t);
+   bool popInject(worker* w, task& t);
+   void pushInject(const task* vt, uint32_t n);
+
+   static bool push(worker* w, const task& t);
+   static bool take(worker* w,       task& t);
+   static int steal(worker* w,       task& t);
+
+   static void runParallelFor(void* ctx);
+
+   static void deleteTask(const task& t)
+      {
+      U_TRACE(0, "UThreadPool::deleteTask(%p)", &t)
+
+      if (t.func == (vPFpv)runThreadTask) U_DELETE((UThread*)t.arg) // NB: a task submitted as UThread* is owned by the pool...
+      }
+
+   static void runThreadTask(UThread* task)
+      {
+      U_TRACE(0, "UThreadPool::runThreadTask(%p)", task)
+
+      task->run(); // execute the task
+
+      U_DELETE(task)
+      }
+
+#ifdef _MSWINDOWS_
+   static unsigned __stdcall execHandler(void* w);
+#else
+   static void* execHandler(void* w);
+#endif
+
 private:
    U_DISALLOW_COPY_AND_ASSIGN(UThreadPool)
 };
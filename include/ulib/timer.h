@@ -20,6 +20,21 @@
 class UNotifier;
 class UServer_Base;
 
+/**
+ * The pending alarms can be kept in two ways:
+ *
+ * 1) a singly linked list ordered by expire time (default): insert, erase and updateTimeToExpire() are O(n)
+ * 2) a hierarchical timing wheel (UTimer::init(mode, true)): U_TIMER_WHEEL_LEVEL levels of U_TIMER_WHEEL_SIZE slots
+ *    with a resolution (tick) of 1 ms. Insert and erase are O(1), the alarms of a slot are expired in batch and an
+ *    alarm far in time is moved (cascade) to the lower levels only when its slot is reached. The non empty slots of
+ *    a level are tracked with a bitmap, so the next tick with something to do is found without scanning the slots
+ */
+
+#define U_TIMER_WHEEL_BITS  6
+#define U_TIMER_WHEEL_SIZE  (1U << U_TIMER_WHEEL_BITS)
+#define U_TIMER_WHEEL_MASK  (U_TIMER_WHEEL_SIZE - 1)
+#define U_TIMER_WHEEL_LEVEL 6 // 2^36 ms (~795 days)
+
 // UNotifier use this class to notify a timeout from select()
 
 class U_EXPORT UTimer {
@@ -39,6 +54,7 @@ public:
       U_TRACE_CTOR(0, UTimer, "")
 
       next  = U_NULLPTR;
+      pprev = U_NULLPTR;
       alarm = U_NULLPTR;
       }
 
@@ -53,11 +69,17 @@ public:
       {
       U_TRACE_NO_PARAM(0, "UTimer::empty()")
 
-      if (first == U_NULLPTR) U_RETURN(true);
+      if (first       == U_NULLPTR &&
+          wheel_count == 0)
+         {
+         U_RETURN(true);
+         }
 
       U_RETURN(false);
       }
 
+   static bool isWheel() { return bwheel; }
+
    static bool isAlarm()
       {
       U_TRACE_NO_PARAM(0, "UTimer::isAlarm()")
@@ -74,9 +96,17 @@ public:
       U_RETURN(false);
       }
 
-   static void init(Type _mode) // initialize the timer
+   static void init(Type _mode, bool _bwheel = false) // initialize the timer
       {
-      U_TRACE(0, "UTimer::init(%d)", _mode)
+      U_TRACE(0, "UTimer::init(%d,%b)", _mode, _bwheel)
+
+      U_ASSERT(empty())
+
+      if ((bwheel = _bwheel) &&
+          wheel_alarm == U_NULLPTR)
+         {
+         U_NEW(UEventTime, wheel_alarm, UEventTime(0L, 0L));
+         }
 
       if ((mode = _mode) != NOSIGNAL)
          {
@@ -94,7 +124,7 @@ public:
       {
       U_TRACE(0, "UTimer::erase(%p)", item)
 
-      U_INTERNAL_ASSERT_POINTER(first)
+      U_INTERNAL_ASSERT(first || bwheel)
 
       if (mode != NOSIGNAL) U_DELETE(item)
       else
@@ -117,6 +147,19 @@ public:
       {
       U_TRACE_NO_PARAM(0, "UTimer::getTimeout()")
 
+      if (bwheel)
+         {
+         if (        wheel_count &&
+             (run(), wheel_count))
+            {
+            UEventTime* a = getWheelTimeout();
+
+            U_RETURN_POINTER(a, UEventTime);
+            }
+
+         U_RETURN_POINTER(U_NULLPTR, UEventTime);
+         }
+
       if (        first &&
           (run(), first))
          {
@@ -134,6 +177,13 @@ public:
       {
       U_TRACE(0, "UTimer::isHandler(%p)", palarm)
 
+      if (bwheel)
+         {
+         if (palarm->ptimer) U_RETURN(true);
+
+         U_RETURN(false);
+         }
+
       for (UTimer* item = first; item; item = item->next)
          {
          if (item->alarm == palarm)
@@ -173,15 +223,44 @@ public:
 
 protected:
    UTimer* next;
+   UTimer** pprev; // wheel: address of the pointer that points to us (head of the slot or next of the previous item)
    UEventTime* alarm;
 
    static int mode;
    static UTimer* pool;  //   free list 
    static UTimer* first; // active list 
 
+   static bool bwheel;
+   static UTimer* wheel_fired;      // the item whose handler is running (it is not linked in the wheel)
+   static uint64_t wheel_now;       // last tick (ms) processed
+   static uint32_t wheel_count;     // number of items linked in the wheel
+   static UEventTime* wheel_alarm;  // returned by getTimeout(): it expire at the next tick with something to do
+   static uint64_t wheel_bitmap[U_TIMER_WHEEL_LEVEL];
+   static UTimer*  wheel[U_TIMER_WHEEL_LEVEL][U_TIMER_WHEEL_SIZE];
+
    static void callHandlerTimeout();
    static void updateTimeToExpire(UEventTime* ptime);
 
+   static uint64_t getTick(const struct timeval& tv) // NB: rounded up, an alarm never expire before its time...
+      {
+      U_TRACE(0, "UTimer::getTick(%p)", &tv)
+
+      uint64_t tick = (uint64_t)tv.tv_sec * 1000ULL + (uint64_t)((tv.tv_usec + 999L) / 1000L);
+
+      U_RETURN(tick);
+      }
+
+   static uint64_t getTickNow()
+      {
+      U_TRACE_NO_PARAM(0, "UTimer::getTickNow()")
+
+      uint64_t tick = (uint64_t)UEventTime::timeout1.tv_sec * 1000ULL + (uint64_t)(UEventTime::timeout1.tv_usec / 1000L);
+
+      U_RETURN(tick);
+      }
+
+   static UEventTime* getWheelTimeout();
+
 #ifdef DEBUG
    static bool invariant();
 #endif
@@ -189,6 +268,14 @@ protected:
 private:
    void insertEntry() U_NO_EXPORT;
 
+   void  linkWheel(uint64_t min_tick) U_NO_EXPORT;
+   void unlinkWheel() U_NO_EXPORT;
+
+   static void     runWheel() U_NO_EXPORT;
+   static void    fireWheel(uint32_t slot) U_NO_EXPORT;
+   static void cascadeWheel(uint32_t level, uint32_t slot) U_NO_EXPORT;
+   static uint64_t nextWheelTick() __pure U_NO_EXPORT;
+
    bool operator< (const UTimer& t) const { return (*alarm < *t.alarm); }
    bool operator> (const UTimer& t) const { return  t.operator<(*this); }
    bool operator<=(const UTimer& t) const { return !t.operator<(*this); }
@@ -28,6 +28,9 @@
 #define HTTP2_MAX_CONCURRENT_STREAMS        128
 #define HTTP2_HEADER_TABLE_ENTRY_SIZE_OFFSET 32
 
+#define U_HPACK_INDEX_SIZE  256 // NB: must be a power of 2 (a dynamic table of 4096 bytes can have at most 128 entries, each one is indexed by name and name+value)
+#define U_HPACK_INDEX_PROBE   8 // max number of slot inspected by a lookup in the index of the output dynamic table
+
 #define HTTP2_CONNECTION_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n" // (24 bytes)
 
 class UHTTP;
@@ -83,6 +86,9 @@ public:
                hpack_capacity,        // the value set by SETTINGS_HEADER_TABLE_SIZE _and_ dynamic table size update
                hpack_max_capacity;    // the value set by SETTINGS_HEADER_TABLE_SIZE
       HpackHeaderTableEntry* entries; // ring buffer
+      // encoder only (response): the index of the entries by hash of name and name+value (see hpackEncodeHeader())
+      uint32_t insert_count;          // number of entries added, the position of an entry in the table is (insert_count - order of insertion)
+      uint32_t* hindex;               // open addressing [hash, order of insertion] pairs (U_HPACK_INDEX_SIZE slots)
    };
 
    struct Stream {
@@ -299,7 +305,7 @@ protected:
    static void writeData(struct iovec* iov, bool bdata, bool flag);
    static void handlerDelete(UClientImage_Base* pclient, bool& bsocket_open);
 
-   static unsigned char* setHpackHeaders(unsigned char* dst, const UString& headers);
+   static unsigned char* setHpackHeaders(unsigned char* dst, const UString& headers, HpackDynamicTable* dyntbl = U_NULLPTR);
 
    static void startRequest()
       {
@@ -604,6 +610,15 @@ protected:
          }
       }
 
+   static void setHpackOutputDynTblMaxCapacity(uint32_t value)
+      {
+      U_TRACE(0, "UHTTP2::setHpackOutputDynTblMaxCapacity(%u)", value)
+
+      // NB: the SETTINGS_HEADER_TABLE_SIZE of the peer limits the table of our encoder, the change is signaled at the start of the next header block...
+
+      pConnection->odyntbl.hpack_max_capacity = U_min(value, settings.header_table_size);
+      }
+
    static unsigned char* setHpackOutputDynTblCapacity(unsigned char* dst, uint32_t& value)
       {
       U_TRACE(0, "UHTTP2::setHpackOutputDynTblCapacity(%p,%u)", dst, value)
@@ -685,7 +700,22 @@ protected:
    static void   addHpackDynTblEntry(HpackDynamicTable* dyntbl, const UString& name, const UString& value);
    static void evictHpackDynTblEntry(HpackDynamicTable* dyntbl, HpackHeaderTableEntry* entry, uint32_t index);
 
-   static void addHpackOutputDynTblEntry(const UString& name, const UString& value) { addHpackDynTblEntry(&(pConnection->odyntbl), name, value); }
+   static void addHpackOutputDynTblEntry(const UString& name, const UString& value) { addHpackOutputDynTblEntry(&(pConnection->odyntbl), name, value, name.hashIgnoreCase()); }
+
+   // HPACK encoder
+
+   static void     addHpackOutputDynTblEntry(HpackDynamicTable* dyntbl, const UString& name, const UString& value, uint32_t hname);
+   static uint32_t findHpackOutputDynTblEntry(HpackDynamicTable* dyntbl, uint32_t hash, const UString& name, const char* value, uint32_t len);
+   static uint32_t findHpackStaticTblEntry(const UString& name, uint32_t hname, const char* value, uint32_t len, bool& bvalue);
+
+   static uint32_t getHpackValueHash(uint32_t hname, const char* value, uint32_t len)
+      {
+      U_TRACE(0, "UHTTP2::getHpackValueHash(%u,%.*S,%u)", hname, len, value, len)
+
+      uint32_t hash = (len ? u_hash((const unsigned char*)value, len) : 0);
+
+      U_RETURN(hname ^ (hash * 0x9e3779b1) ^ len);
+      }
 
    static unsigned char* hpackDecodeInt(   unsigned char* src, unsigned char* src_end, int32_t& value, uint8_t prefix_max);
    static unsigned char* hpackDecodeString(unsigned char* src, unsigned char* src_end, UString& value);
@@ -744,13 +774,29 @@ protected:
    static bool isHeaderValue(const UString& s) { return isHeaderValue(U_STRING_TO_PARAM(s)); } 
 
    static    const char* getFrameErrorCodeDescription(uint32_t error);
-   static unsigned char* hpackEncodeHeader(unsigned char* dst, const UString& key, const UString& value);
+   static unsigned char* hpackEncodeHeader(unsigned char* dst, HpackDynamicTable* dyntbl, const UString& name, const char* value, uint32_t len);
+
+   static unsigned char* hpackEncodeHeader(unsigned char* dst, HpackDynamicTable* dyntbl, const UString& name, const UString& value) { return hpackEncodeHeader(dst, dyntbl,    name, U_STRING_TO_PARAM(value)); }
+   static unsigned char* hpackEncodeHeader(unsigned char* dst,                             const UString& name, const UString& value) { return hpackEncodeHeader(dst, U_NULLPTR, name, U_STRING_TO_PARAM(value)); }
 
    static void decodeHeaders(UHashMap<UString>* itable, HpackDynamicTable* dyntbl, unsigned char* ptr, unsigned char* endptr);
 
    static unsigned char* hpackEncodeString(unsigned char* dst, const char* src, uint32_t len, bool bhuffman);
    static unsigned char* hpackEncodeString(unsigned char* dst, const UString& value,          bool bhuffman) { return hpackEncodeString(dst, U_STRING_TO_PARAM(value), bhuffman); }
 
+   // NB: the Huffman encoding is used only if it is shorter than the literal...
+
+   static uint32_t hpackHuffmanLen(const char* src, uint32_t len) __pure;
+
+   static unsigned char* hpackEncodeString(unsigned char* dst, const char* src, uint32_t len)
+      {
+      U_TRACE(0, "UHTTP2::hpackEncodeString(%p,%.*S,%u)", dst, len, src, len)
+
+      return hpackEncodeString(dst, src, len, (hpackHuffmanLen(src, len) < len));
+      }
+
+   static unsigned char* hpackEncodeString(unsigned char* dst, const UString& value) { return hpackEncodeString(dst, U_STRING_TO_PARAM(value)); }
+
 #ifdef DEBUG
    typedef struct { const char* str; int value; const char* desc; } HpackError;
 
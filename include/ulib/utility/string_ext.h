@@ -23,6 +23,9 @@
 #  include <brotli/encode.h>
 #  include <brotli/decode.h>
 #endif
+#ifdef USE_LIBZSTD
+#  include <zstd.h>
+#endif
 
 class U_EXPORT UStringExt {
 public:
@@ -41,7 +44,11 @@ public:
 #endif
 
 #ifndef U_LOG_DISABLE
+# ifdef ENABLE_THREAD
+   static __thread const char* deflate_agent; // NB: a thread can compress in background (see UHTTP::addCompressJob())...
+# else
    static const char* deflate_agent;
+# endif
 #endif
 
    static bool isDelimited(const UString& s, const char* delimiter = "()")
@@ -71,7 +78,12 @@ public:
    static UString   compress(const UString& s) { return   compress(U_STRING_TO_PARAM(s)); }
    static UString decompress(const UString& s) { return decompress(U_STRING_TO_PARAM(s)); }
 
-   static uint32_t ratio, ratio_threshold;
+#ifdef ENABLE_THREAD
+   static __thread uint32_t ratio; // NB: per thread, as deflate_agent...
+#else
+   static uint32_t ratio;
+#endif
+   static uint32_t ratio_threshold;
 
    static bool isGzip(const char* s)    { return (u_get_unalignedp16(s) == U_MULTICHAR_CONSTANT16('\x1F','\x8B')); }
    static bool isGzip(const UString& s) { return isGzip(s.data()); }
@@ -96,6 +108,17 @@ public:
       { return brotli(U_STRING_TO_PARAM(s), quality, mode, lgwin); }
 #endif
 
+   static bool isZstd(const char* s)    { return (u_get_unalignedp32(s) == U_MULTICHAR_CONSTANT32('\x28','\xB5','\x2F','\xFD')); } // 0xFD2FB528 (little endian)
+   static bool isZstd(const UString& s) { return isZstd(s.data()); }
+
+   static UString unzstd(const char* s, uint32_t n);
+   static UString unzstd(const UString& s) { return unzstd(U_STRING_TO_PARAM(s)); }
+
+#ifdef USE_LIBZSTD
+   static UString zstd(const char* s, uint32_t n, int level = 19); // .zst compress (19 => max level without the ultra mode)
+   static UString zstd(const UString& s,          int level = 19) { return zstd(U_STRING_TO_PARAM(s), level); }
+#endif
+
    // Convert numeric to string
 
    static UString printSize(off_t n)
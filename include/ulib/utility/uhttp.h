@@ -39,6 +39,8 @@ class ULock;
 class UHTTP2;
 class UEventFd;
 class UCommand;
+class UThreadPool;
+class UCompressJob;
 class UPageSpeed;
 class USSIPlugIn;
 class UHttpPlugIn;
@@ -208,6 +210,10 @@ public:
 
    static UString getPathComponent(uint32_t index); // Returns the path element at the specified index
 
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+   static uint8_t getAcceptEncoding(const char* ptr, uint32_t len) __pure; // Returns the mask HTTP_IS_ACCEPT_* of the value of Accept-Encoding
+#endif
+
    static bool isValidRequest(const char* ptr, uint32_t sz)
       {
       U_TRACE(0, "UHTTP::isValidRequest(%.*S,%u)", 30, ptr, sz)
@@ -309,7 +315,7 @@ public:
       {
       if (sz >= UServer_Base::min_size_for_sendfile)
          {
-         U_INTERNAL_ASSERT_EQUALS(UServer_Base::bssl, false) // NB: we can't use sendfile with SSL...
+         U_INTERNAL_ASSERT(UServer_Base::bssl == false || UServer_Base::bktls) // NB: we can't use sendfile with SSL (without kTLS)...
 
          U_RETURN(true);
          }
@@ -1247,9 +1253,9 @@ private:
    U_MEMORY_DEALLOCATOR
 
    void* ptr;               // data
-   UVector<UString>* array; // content, header, gzip(content, header), brotli(content, header)
+   UVector<UString>* array; // content, header, gzip(content, header), brotli(content, header), zstd(content, header)
 #ifndef U_HTTP2_DISABLE
-   UVector<UString>* http2; //          header, gzip(         header), brotli(         header)
+   UVector<UString>* http2; //          header, gzip(         header), brotli(         header), zstd(         header)
 #endif
    time_t mtime;            // time of last modification
    time_t expire;           // expire time of the entry
@@ -1376,7 +1382,7 @@ private:
       {
       U_TRACE(0, "UHTTP::getDataFromCache(%p,%u)", array, idx)
 
-      U_INTERNAL_ASSERT_MINOR(idx, 6)
+      U_INTERNAL_ASSERT_MINOR(idx, 8)
 
       U_INTERNAL_DUMP("U_http_version = %C", U_http_version)
 
@@ -1403,6 +1409,8 @@ private:
    static UString getHeaderCompressFromCache()       { return getHeaderFromCache(3); }
    static UString getBodyCompressBrotliFromCache()   { return getDataFromCache(file_data->array, 4); }
    static UString getHeaderCompressBrotliFromCache() { return getHeaderFromCache(5); }
+   static UString getBodyCompressZstdFromCache()     { return getDataFromCache(file_data->array, 6); }
+   static UString getHeaderCompressZstdFromCache()   { return getHeaderFromCache(7); }
 
    static UString contentOfFromCache(const char* path, uint32_t len)
       {
@@ -1534,26 +1542,56 @@ private:
    static UString*        inotify_pathname;
    static UStringRep*     inotify_dir;
    static UFileCacheData* inotify_file_data;
+   static UVector<UString>* inotify_renew;
+   static UEventTime* inotify_renew_timer;
 
    static void in_READ();
    static void initInotify();
+   static bool renewInotifyPending();
+   static void addInotifyPending(const UString& pathname) U_NO_EXPORT;
+
+# if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+   static bool inotify_compress_fast; // NB: a file renewed by inotify is compressed with the levels for the dynamic content...
+#  ifdef ENABLE_THREAD
+   static UThreadPool*  compress_pool; // ...and recompressed with the max levels by the threads of a pool (a codec for thread)
+   static UCompressJob* compress_jobs; // the pending jobs (list)
+   static UCompressJob* compress_job;  // the finished job whose results are installed by putDataInCache()
+
+   static void checkCompressJob() U_NO_EXPORT;
+   static void addCompressJob(const UString& path, const UString& content) U_NO_EXPORT;
+#  endif
+# endif
+
+   static bool isInotifyCompressPending()
+      {
+      U_TRACE_NO_PARAM(0, "UHTTP::isInotifyCompressPending()")
+
+#  if (defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)) && defined(ENABLE_THREAD)
+      if (compress_jobs) U_RETURN(true);
+#  endif
+
+      U_RETURN(false);
+      }
    static void setInotifyPathname() U_NO_EXPORT;
    static bool getInotifyPathDirectory(UStringRep* key, void* value) U_NO_EXPORT;
    static bool checkForInotifyDirectory(UStringRep* key, void* value) U_NO_EXPORT;
 #endif
 
-#if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
    static bool checkForCompression(uint32_t size)
       {
       U_TRACE(0, "UHTTP::checkForCompression(%u)", size)
 
-      U_INTERNAL_DUMP("U_http_is_accept_gzip = %b U_http_is_accept_brotli = %b", U_http_is_accept_gzip, U_http_is_accept_brotli)
+      U_INTERNAL_DUMP("U_http_is_accept_gzip = %b U_http_is_accept_brotli = %b U_http_is_accept_zstd = %b", U_http_is_accept_gzip, U_http_is_accept_brotli, U_http_is_accept_zstd)
 
       if (size > U_MIN_SIZE_FOR_DEFLATE)
          {
 #     ifdef USE_LIBBROTLI
          if (U_http_is_accept_brotli) U_RETURN(true);
 #     endif
+#     ifdef USE_LIBZSTD
+         if (U_http_is_accept_zstd) U_RETURN(true);
+#     endif
 #     ifdef USE_LIBZ
       if (U_http_is_accept_gzip) U_RETURN(true);
 #     endif
@@ -1562,8 +1600,14 @@ private:
       U_RETURN(false);
       }
 
-# ifdef USE_LIBBROTLI
-   static void checkArrayCompressData(UFileCacheData* ptr) U_NO_EXPORT;
+# if defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+   static void checkArrayCompressData(UFileCacheData* ptr, uint32_t idx) U_NO_EXPORT;
+# endif
+
+   static UString getCompressedSibling(const char* suffix, uint32_t len) U_NO_EXPORT;
+
+# ifdef U_STDCPP_ENABLE
+   static bool compressDataFromStore(UStringRep* key, void* value) U_NO_EXPORT;
 # endif
 
    static inline bool compress(UString& header, const UString& lbody) U_NO_EXPORT;
@@ -1637,6 +1681,8 @@ private:
    friend class UHttpPlugIn;
    friend class UProxyPlugIn;
    friend class UClientImage_Base;
+   friend class UInotifyRenew;
+   friend class UCompressJob;
 
    friend void runDynamicPage_dirlist(int);
 
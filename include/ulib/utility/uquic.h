@@ -15,6 +15,7 @@
 #define U_QUIC_H 1
 
 #include <ulib/db/rdb.h>
+#include <ulib/net/udpbatch.h>
 #include <ulib/net/server/server.h>
 
 #define U_MAX_TOKEN_LEN \
@@ -57,6 +58,11 @@ protected:
    static size_t conn_id_len, scid_len, token_len;
    static uint8_t token[U_MAX_TOKEN_LEN], scid[QUICHE_MAX_CONN_ID_LEN], conn_id[QUICHE_MAX_CONN_ID_LEN];
 
+   // the packets produced by quiche in one pass of the send loop (see flush() and UUDPBatch::send())
+
+   static uint32_t max_payload_size, vsize[U_UDP_MAX_SEGMENT];
+   static uint8_t out[U_UDP_MAX_SEGMENT * U_MAX_DATAGRAM_SIZE];
+
    // SERVICES
 
    static void ctor()
@@ -77,11 +83,35 @@ protected:
       if (qconfig) U_SYSCALL_VOID(quiche_config_free, "%p", qconfig);
       }
 
+   static void initSocket();
    static bool parseHeader();
    static bool handlerNewConnection();
    static void handlerRequest(quiche_conn* lconn, quiche_h3_conn* lh3);
    static bool handlerRead(quiche_conn* lconn = U_NULLPTR, bool bwait_for_data = false);
 
+   static uint32_t nextDatagram();
+   static bool     flush(quiche_conn* lconn);
+
+   static uint32_t splitCoalesced(uint32_t len) // NB: for the datagram read with the recvmsg() of io_uring...
+      {
+      U_TRACE(0, "UQuic::splitCoalesced(%u)", len)
+
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::rmsg.msg_name, &USocket::peer_addr)
+
+      uint32_t segment = UUDPBatch::split(&UServer_Base::rmsg, UServer_Base::rbuffer->data(), len);
+
+      U_RETURN(segment);
+      }
+
+   static bool sendPackets(uint32_t n)
+      {
+      U_TRACE(0, "UQuic::sendPackets(%u)", n)
+
+      if (UUDPBatch::send(UServer_Base::fds[0], (const struct sockaddr*)&USocket::peer_addr, USocket::peer_addr_len, out, vsize, n)) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
    // Lookup a connection based on the packet's connection ID
 
    static bool lookup()
@@ -161,6 +161,59 @@ AC_DEFUN([AC_CHECK_PACKAGE],[
 	fi
 	], [AC_MSG_RESULT(no)])
 
+	AC_MSG_CHECKING(if zstd library is wanted)
+	wanted=1;
+	if test -z "$with_libzstd" ; then
+		wanted=0;
+		if test -n "$CROSS_ENVIRONMENT" -o "$USP_FLAGS" = "-DAS_cpoll_cppsp_DO" -o "$enable_shared" = "no"; then
+			with_libzstd="no";
+		else
+			with_libzstd="${CROSS_ENVIRONMENT}/usr";
+		fi
+	fi
+	AC_ARG_WITH(libzstd, [  --with-libzstd          use system     zstd library - [[will check /usr /usr/local]] [[default=use if present]]], [
+	if test "$withval" = "no"; then
+		AC_MSG_RESULT(no)
+	else
+		AC_MSG_RESULT(yes)
+		for dir in $withval ${CROSS_ENVIRONMENT}/ ${CROSS_ENVIRONMENT}/usr ${CROSS_ENVIRONMENT}/usr/local; do
+			libzstddir="$dir"
+			if test -f "$dir/include/zstd.h"; then
+				found_libzstd="yes";
+				break;
+			fi
+		done
+		if test x_$found_libzstd != x_yes; then
+			msg="Cannot find libzstd library";
+			if test $wanted = 1; then
+				AC_MSG_ERROR($msg)
+			else
+				AC_MSG_RESULT($msg)
+			fi
+		else
+			echo "${T_MD}libzstd found in $libzstddir${T_ME}"
+			USE_LIBZSTD=yes
+			AC_DEFINE(USE_LIBZSTD, 1, [Define if enable libzstd support])
+
+			if test -z "$CROSS_ENVIRONMENT" -a x_$PKG_CONFIG != x_no; then
+				libzstd_version=$(pkg-config --modversion libzstd 2>/dev/null)
+			fi
+			if test -z "${libzstd_version}"; then
+				libzstd_version=$(ls $libzstddir/lib*/libzstd*.so.*.* 2>/dev/null | head -n 1 | awk -F'.so.' '{n=2; print $n}' 2>/dev/null)
+			fi
+			if test -z "${libzstd_version}"; then
+				libzstd_version="unknown"
+			fi
+         ULIB_LIBS="$ULIB_LIBS -lzstd";
+			if test $libzstddir != "${CROSS_ENVIRONMENT}/" -a $libzstddir != "${CROSS_ENVIRONMENT}/usr" -a $libzstddir != "${CROSS_ENVIRONMENT}/usr/local"; then
+				CPPFLAGS="$CPPFLAGS -I$libzstddir/include"
+				LDFLAGS="$LDFLAGS -L$libzstddir/lib -Wl,-R$libzstddir/lib";
+				PRG_LDFLAGS="$PRG_LDFLAGS -L$libzstddir/lib";
+			fi
+		fi
+	fi
+	], [AC_MSG_RESULT(no)])
+
 	AC_MSG_CHECKING(if quiche library is wanted)
 	wanted=1;
 	if test -z "$with_libquiche" ; then
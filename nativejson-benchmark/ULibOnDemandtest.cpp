@@ -0,0 +1,141 @@
+#include "../test.h"
+
+/**
+ * NB: the on-demand parser of ULib (UJsonOnDemand): the parse build only the index of the structural characters,
+ *     the values are read (without to build the tree) when the document is navigated (see Statistics)
+ *
+ * if ULib is configured and compiled (./configure --disable-shared && make) use this way:
+ *
+ * #define HAVE_CONFIG_H
+ * #include <ulib/json/value.h>
+ * #undef HAVE_CONFIG_H
+ *
+ * otherwise:
+ *
+ * #include <ULib/src/ulib/all_cpp.cpp>
+ */
+
+#define HAVE_CONFIG_H
+#include <ulib/json/value.h>
+#undef HAVE_CONFIG_H
+
+static ULib ulib(U_NULLPTR, "167193,0,0,0,-30,-31,-30,-31,0");
+
+static void GenStat(Stat& stat, const UJsonOnDemand& doc, uint32_t i)
+{
+	U_TRACE(5, "::GenStat(%p,%p,%u)", &stat, &doc, i)
+
+	switch (doc.getType(i))
+		{
+		case U_REAL_VALUE:  stat.numberCount++; break;
+		case U_TRUE_VALUE:  stat.trueCount++;   break;
+		case U_FALSE_VALUE: stat.falseCount++;  break;
+		case U_NULL_VALUE:  stat.nullCount++;   break;
+
+		case U_STRING_VALUE:
+			{
+			stat.stringCount++;
+
+			stat.stringLength += doc.getString(i).size();
+			}
+		break;
+
+		case U_ARRAY_VALUE:
+			{
+			stat.arrayCount++;
+
+			for (uint32_t j = doc.getFirst(i); j != U_NOT_FOUND; j = doc.getNext(j))
+				{
+				stat.elementCount++;
+
+				GenStat(stat, doc, j);
+				}
+			}
+		break;
+
+		case U_OBJECT_VALUE:
+			{
+			stat.objectCount++;
+
+			for (uint32_t j = doc.getFirst(i); j != U_NOT_FOUND; j = doc.getNext(j))
+				{
+				stat.memberCount++;
+				stat.stringCount++; // Key
+				stat.stringLength += doc.getString(j).size();
+
+				GenStat(stat, doc, UJsonOnDemand::getMemberValue(j));
+				}
+			}
+		break;
+		}
+}
+
+class ULibOnDemandParseResult : public ParseResultBase {
+public:
+	UString s;
+	UJsonOnDemand doc;
+};
+
+class ULibOnDemandTest : public TestBase {
+public:
+#if TEST_INFO
+	virtual const char* GetName() const { return "ULib on-demand (C++)"; }
+	virtual const char* GetFilename() const { return __FILE__; }
+#endif
+
+#if TEST_PARSE
+	virtual ParseResultBase* Parse(const char* json, size_t length) const
+		{
+		ULibOnDemandParseResult* pr = new ULibOnDemandParseResult;
+
+		return (pr->doc.parse((pr->s = UString(json, length))) ? pr : (delete pr, (ULibOnDemandParseResult*)0));
+		}
+#endif
+
+#if TEST_STATISTICS
+	virtual bool Statistics(const ParseResultBase* parseResult, Stat* stat) const
+		{
+		(void) memset(stat, 0, sizeof(Stat));
+
+		const ULibOnDemandParseResult* pr = static_cast<const ULibOnDemandParseResult*>(parseResult);
+
+		GenStat(*stat, pr->doc, 0);
+
+		return true;
+		}
+#endif
+
+#if TEST_CONFORMANCE
+	virtual bool ParseDouble(const char* json, double* d) const
+		{
+		UJsonOnDemand doc;
+
+		if (doc.parse(UString(json)))
+			{
+			*d = doc.getValue(doc.at(0, 0)).strtod();
+
+			return true;
+			}
+
+		return false;
+		}
+
+	virtual bool ParseString(const char* json, std::string& s) const
+		{
+		UJsonOnDemand doc;
+
+		if (doc.parse(UString(json)))
+			{
+			UString result = doc.getString(doc.at(0, 0));
+
+			(void) s.assign(U_STRING_TO_PARAM(result));
+
+			return true;
+			}
+
+		return false;
+		}
+#endif
+};
+
+REGISTER_TEST(ULibOnDemandTest);
@@ -61,6 +61,7 @@
 #  include "internal/objectIO.cpp"
 #endif
 #ifndef _MSWINDOWS_
+#  include "net/udpbatch.cpp"
 #  include "net/unixsocket.cpp"
 #endif
 #ifdef DEBUG
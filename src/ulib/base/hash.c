@@ -15,8 +15,17 @@
 #define DEBUG_DEBUG
 */
 
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsuggest-attribute=pure" /* for the helpers of xxh3 instantiated by u_cdb64_hash() */
+#endif
+
 #include <ulib/base/hash.h>
 
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
 /**
  * Quick 4byte hashing function
  *
@@ -121,6 +130,42 @@ __pure uint32_t u_cdb_hash(const unsigned char* restrict t, uint32_t tlen, int f
    return h;
 }
 
+/* cdb64: the hash value is stored on disk so we can't use the random seed of u_xxhash64() */
+
+__pure uint64_t u_cdb64_hash(const unsigned char* restrict t, uint32_t tlen, int flags)
+{
+   XXH3_state_t state;
+   unsigned char buf[256];
+   uint32_t i, n;
+
+   U_INTERNAL_TRACE("u_cdb64_hash(%.*s,%u,%d)", U_min(tlen,128), t, tlen, flags)
+
+   if (flags <= 0) return XXH3_64bits(t, tlen);
+
+   if (tlen <= sizeof(buf))
+      {
+      for (i = 0; i < tlen; ++i) buf[i] = u__tolower(t[i]);
+
+      return XXH3_64bits(buf, tlen);
+      }
+
+   (void) XXH3_64bits_reset(&state);
+
+   while (tlen)
+      {
+      n = U_min(tlen, sizeof(buf));
+
+      for (i = 0; i < n; ++i) buf[i] = u__tolower(t[i]);
+
+      (void) XXH3_64bits_update(&state, buf, n);
+
+      t    += n;
+      tlen -= n;
+      }
+
+   return XXH3_64bits_digest(&state);
+}
+
 __pure uint32_t u_hash_ignore_case(const unsigned char* restrict data, uint32_t len)
 {
    union uucflag u;
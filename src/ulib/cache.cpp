@@ -39,13 +39,25 @@ U_NO_EXPORT void UCache::init(UFile& _x, uint32_t size, bool bexist, bool brdonl
 
    (void) _x.memmap(PROT_READ | (brdonly ? 0 : PROT_WRITE));
 
-   char* ptr = _x.resetMap();
+   set(_x.resetMap(), size, bexist);
+
+   if (bexist) start = (_x.fstat(), _x.st_mtime);
+   else
+      {
+      U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
+
+      start = u_now->tv_sec;
+      }
+}
+
+U_NO_EXPORT void UCache::set(char* ptr, uint32_t size, bool bexist)
+{
+   U_TRACE(0, "UCache::set(%p,%u,%b)", ptr, size, bexist)
 
    info = (cache_info*)ptr;
       x =              ptr + sizeof(UCache::cache_info);
 
-   if (bexist) start = (_x.fstat(), _x.st_mtime);
-   else
+   if (bexist == false)
       {
       // 100 <= size <= 1000000000
 
@@ -56,10 +68,6 @@ U_NO_EXPORT void UCache::init(UFile& _x, uint32_t size, bool bexist, bool brdonl
       info->hsize = info->writer = getHSize((info->oldest = info->unused = info->size = (size - sizeof(UCache::cache_info))));
 
       U_INTERNAL_DUMP("hsize = %u writer = %u oldest = %u unused = %u size = %u", info->hsize, info->writer, info->oldest, info->unused, info->size)
-
-      U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
-
-      start = u_now->tv_sec;
       }
 }
 
@@ -211,6 +219,8 @@ char* UCache::add(const char* key, uint32_t keylen, uint32_t datalen, uint32_t _
 
       replace(pos, info->oldest);
 
+      if (pevictions) ++(*pevictions);
+
       info->oldest += sizeof(UCache::cache_hash_table_entry) + u_get_unaligned32(e->keylen) + u_get_unaligned32(e->datalen);
 
       U_INTERNAL_ASSERT(info->oldest <= info->unused)
@@ -407,6 +417,285 @@ void UCache::loadContentOf(const UString& dir, const char* filter, uint32_t filt
       }
 }
 
+// SHARDED CACHE
+
+UShardCache::~UShardCache()
+{
+   U_TRACE_DTOR(0, UShardCache)
+
+   if (shard) delete[] shard; // NB: the shards don't own the mapping (fd == -1)...
+   if (lock)  delete[] lock;
+
+   if (fd != -1)
+      {
+      UFile::close(fd);
+
+      UFile::munmap(map, map_size);
+      }
+}
+
+bool UShardCache::open(const UString& path, uint32_t size, uint32_t n, const UString* environment, bool btemp, sem_t* psem, uint32_t nsem)
+{
+   U_TRACE(0, "UShardCache::open(%V,%u,%u,%p,%b,%p,%u)", path.rep, size, n, environment, btemp, psem, nsem)
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_EQUALS(fd, -1)
+   U_INTERNAL_ASSERT(psem == U_NULLPTR || nsem > 0)
+
+   UFile _x(path, environment);
+
+   if (_x.creat(O_RDWR) == false) U_RETURN(false);
+
+   uint32_t i, shard_size, header_size;
+   bool bexist = (_x.size() != 0);
+
+   if (bexist == false)
+      {
+      if (n == 0) n = u_get_num_cpu() * 2;
+
+      if (n > 1) n = u_nextPowerOfTwo(n);
+
+      if (n > U_CACHE_SHARD_MAX) n = U_CACHE_SHARD_MAX;
+
+      if (psem) // NB: we can't have more shards than the semaphores given by the caller...
+         {
+         while (n > nsem) n >>= 1;
+         }
+
+      header_size = getHeaderSize(n);
+      shard_size  = (size > header_size ? ((size - header_size) / n) & ~(U_CACHE_SHARD_ALIGN-1) : 0);
+
+      U_INTERNAL_DUMP("n = %u header_size = %u shard_size = %u", n, header_size, shard_size)
+
+      // NB: every shard is a UCache with at least 100 bytes (see UCache::set())...
+
+      if (shard_size < (sizeof(UShardCache::cache_shard_stats) + 100U))
+         {
+         U_WARNING("Sharded cache %V too small: size(%u) shards(%u)", path.rep, size, n);
+
+         _x.close();
+
+         U_RETURN(false);
+         }
+
+      if (_x.ftruncate(header_size + n * shard_size) == false)
+         {
+         _x.close();
+
+         U_RETURN(false);
+         }
+      }
+
+   if (_x.memmap(PROT_READ | PROT_WRITE) == false)
+      {
+      _x.close();
+
+      U_RETURN(false);
+      }
+
+   map_size = _x.getSize();
+   map      = _x.resetMap();
+
+   uint32_t* header = (uint32_t*)map;
+
+   if (bexist == false)
+      {
+      header[0] = n;
+      header[1] = shard_size;
+      }
+   else
+      {
+      n          = header[0];
+      shard_size = header[1];
+
+      U_INTERNAL_DUMP("n = %u shard_size = %u", n, shard_size)
+
+      if (n == 0                 ||
+          (n & (n-1)) != 0       ||
+          n > U_CACHE_SHARD_MAX  ||
+          (psem && n > nsem)     || // NB: the file has been created with more shards than the semaphores given by the caller...
+          (getHeaderSize(n) + n * shard_size) != map_size)
+         {
+         U_WARNING("Sharded cache %V with an invalid header: shards(%u) shard size(%u) size(%u) semaphores(%u)", path.rep, n, shard_size, map_size, nsem);
+
+         UFile::munmap(map, map_size);
+
+         map = U_NULLPTR;
+
+         _x.close();
+
+         U_RETURN(false);
+         }
+      }
+
+   fd     = _x.getFd();
+   nshard = n;
+
+   for (shift = 32; (1U << (32 - shift)) < n; --shift) {}
+
+   U_INTERNAL_DUMP("nshard = %u shift = %u", nshard, shift)
+
+   time_t start;
+
+   if (bexist) start = (_x.fstat(), _x.st_mtime);
+   else
+      {
+      U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
+
+      start = u_now->tv_sec;
+      }
+
+   shard = new UCache[n];
+
+   char* ptr = map + getHeaderSize(n);
+
+   for (i = 0; i < n; ++i, ptr += shard_size)
+      {
+      cache_shard_stats* stats = (cache_shard_stats*)ptr;
+
+      if (bexist == false) (void) U_SYSCALL(memset, "%p,%d,%u", stats, 0, sizeof(UShardCache::cache_shard_stats));
+
+      shard[i].set(ptr + sizeof(UShardCache::cache_shard_stats), shard_size - sizeof(UShardCache::cache_shard_stats), bexist);
+
+      shard[i].start      = start;
+      shard[i].pevictions = &(stats->evictions);
+      }
+
+   // NB: the semaphores are given by the caller or they are in the mapping after the header...
+
+   if (psem == U_NULLPTR) psem = (sem_t*)(map + U_CACHE_SHARD_ALIGN);
+
+   lock = new ULock[n];
+
+   for (i = 0; i < n; ++i) lock[i].init(psem + i);
+
+   if (btemp) (void) _x._unlink();
+
+   U_RETURN(true);
+}
+
+void UShardCache::add(const UString& key, const UString& data, uint32_t _ttl)
+{
+   U_TRACE(0, "UShardCache::add(%V,%V,%u)", key.rep, data.rep, _ttl)
+
+   U_CHECK_MEMORY
+
+   uint32_t i = getShard(U_STRING_TO_PARAM(key));
+
+   lockShard(i);
+
+   shard[i].add(key, data, _ttl);
+
+   unlockShard(i);
+}
+
+void UShardCache::addContent(const UString& key, const UString& content, uint32_t _ttl)
+{
+   U_TRACE(0, "UShardCache::addContent(%V,%V,%u)", key.rep, content.rep, _ttl)
+
+   U_CHECK_MEMORY
+
+   uint32_t i = getShard(U_STRING_TO_PARAM(key));
+
+   lockShard(i);
+
+   shard[i].addContent(key, content, _ttl);
+
+   unlockShard(i);
+}
+
+UString UShardCache::get(const char* key, uint32_t keylen)
+{
+   U_TRACE(0, "UShardCache::get(%.*S,%u)", keylen, key, keylen)
+
+   U_CHECK_MEMORY
+
+   UString data;
+   uint32_t i = getShard(key, keylen);
+   cache_shard_stats* stats = getShardStats(i);
+
+   lockShard(i);
+
+   UString str = shard[i].get(key, keylen);
+
+   if (str.empty()) ++(stats->misses);
+   else
+      {
+      ++(stats->hits);
+
+      data = str.copy(); // NB: after the unlock the entry can be overwritten by another process...
+      }
+
+   unlockShard(i);
+
+   U_RETURN_STRING(data);
+}
+
+UString UShardCache::getContent(const char* key, uint32_t keylen)
+{
+   U_TRACE(0, "UShardCache::getContent(%.*S,%u)", keylen, key, keylen)
+
+   UString content = get(key, keylen);
+
+   if (content &&
+       content.last_char() == '\0')
+      {
+      content.rep->_length -= 1; // NB: 1 => (-null-terminator)...
+
+      U_INTERNAL_ASSERT(content.isNullTerminated())
+      }
+
+   U_RETURN_STRING(content);
+}
+
+void UShardCache::getStats(cache_shard_stats& total) const
+{
+   U_TRACE(0, "UShardCache::getStats(%p)", &total)
+
+   total.hits = total.misses = total.evictions = 0;
+
+   for (uint32_t i = 0; i < nshard; ++i)
+      {
+      cache_shard_stats* stats = getShardStats(i);
+
+      total.hits      += stats->hits;
+      total.misses    += stats->misses;
+      total.evictions += stats->evictions;
+      }
+}
+
+void UShardCache::resetStats()
+{
+   U_TRACE_NO_PARAM(0, "UShardCache::resetStats()")
+
+   for (uint32_t i = 0; i < nshard; ++i)
+      {
+      lockShard(i);
+
+      (void) U_SYSCALL(memset, "%p,%d,%u", getShardStats(i), 0, sizeof(UShardCache::cache_shard_stats));
+
+      unlockShard(i);
+      }
+}
+
+UString UShardCache::printStats() const
+{
+   U_TRACE_NO_PARAM(0, "UShardCache::printStats()")
+
+   cache_shard_stats* stats;
+   UString buffer(U_CAPACITY + nshard * 100U);
+
+   for (uint32_t i = 0; i < nshard; ++i)
+      {
+      stats = getShardStats(i);
+
+      buffer.snprintf_add(U_CONSTANT_TO_PARAM("shard %u: hits %llu misses %llu evictions %llu\n"), i, stats->hits, stats->misses, stats->evictions);
+      }
+
+   U_RETURN_STRING(buffer);
+}
+
 // STREAM
 
 #ifdef U_STDCPP_ENABLE
@@ -539,5 +828,25 @@ const char* UCache::dump(bool _reset) const
 
    return U_NULLPTR;
 }
+
+const char* UShardCache::dump(bool _reset) const
+{
+   *UObjectIO::os << "fd                    " << fd              << '\n'
+                  << "map                   " << (void*)map      << '\n'
+                  << "lock                  " << (void*)lock     << '\n'
+                  << "shard                 " << (void*)shard    << '\n'
+                  << "shift                 " << shift           << '\n'
+                  << "nshard                " << nshard          << '\n'
+                  << "map_size              " << map_size;
+
+   if (_reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
 #  endif
 #endif
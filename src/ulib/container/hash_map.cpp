@@ -13,6 +13,20 @@
 
 #include <ulib/container/hash_map.h>
 
+#ifdef U_SWISS_TABLE
+#  include <emmintrin.h>
+
+static inline uint32_t u_group_match(const uint8_t* ctrl, uint8_t h2) // bitmask of the slots of the group with control byte equal to h2
+{
+   return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8((char)h2), _mm_loadu_si128((const __m128i*)ctrl)));
+}
+
+static inline uint32_t u_group_match_empty_or_deleted(const uint8_t* ctrl) // NB: only the special control bytes have the high bit set...
+{
+   return (uint32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+}
+#endif
+
 bool              UHashMap<void*>::istream_loading;
 uint8_t           UHashMap<void*>::linfo;
 uint32_t          UHashMap<void*>::lhash;
@@ -61,8 +75,15 @@ void UHashMap<void*>::_allocate(uint32_t n)
 
    U_INTERNAL_ASSERT_EQUALS(n & (n-1), 0)
 
+#ifdef U_SWISS_TABLE
+   if (n < U_SWISS_GROUP_SIZE) n = U_SWISS_GROUP_SIZE;
+
+   info  = (uint8_t*) U_SYSCALL_MALLOC(U_SWISS_GROUP_SIZE+n*(1+UHashMapNode::size())); // NB: the first group of control bytes is cloned after the end...
+   table = (char*) (info + n + U_SWISS_GROUP_SIZE);
+#else
    info  = (uint8_t*) U_SYSCALL_MALLOC(n*(1+UHashMapNode::size())); // UMemoryPool::cmalloc(n, 1+UHashMapNode::size(), false);
    table = (char*) (info + n);
+#endif
 
    U_INTERNAL_ASSERT_POINTER_MSG(info, "cannot allocate memory, exiting...")
 
@@ -117,6 +138,59 @@ bool UHashMap<void*>::lookup()
 
       index = ((uint64_t)index + jump_distances[to_next_index]) & (uint64_t)mask;
       }
+#elif defined(U_SWISS_TABLE)
+   /**
+    * We compare with SSE2 the tag (H2) with a group of 16 control bytes at a time, and only for the slots that match we check the stored hash
+    * and then the key. A group with an empty slot terminate the search. The groups are visited with triangular probing, that with a capacity
+    * power of 2 visit all the groups. While probing we remember the first empty or deleted slot, that is where insertAfterFind() put the new node
+    */
+
+   const uint8_t* ctrl;
+   uint32_t bits, pos = index, stride = 0, free_slot = U_NOT_FOUND;
+
+   linfo = U_SWISS_H2(lhash);
+
+   for (;;)
+      {
+      ctrl = info + pos;
+
+      for (bits = u_group_match(ctrl, linfo); bits; bits &= bits-1)
+         {
+         index = (pos + __builtin_ctz(bits)) & mask;
+
+         setNodePointer();
+
+         if (node->hash == lhash &&
+             comparesEqual(ignore_case, bIntHash))
+            {
+            U_RETURN(true);
+            }
+         }
+
+      if (free_slot == U_NOT_FOUND &&
+          (bits = u_group_match_empty_or_deleted(ctrl)))
+         {
+         free_slot = (pos + __builtin_ctz(bits)) & mask;
+         }
+
+      if (u_group_match(ctrl, U_SWISS_EMPTY)) break;
+
+      stride += U_SWISS_GROUP_SIZE;
+
+      U_INTERNAL_ASSERT_MINOR(stride, _capacity + U_SWISS_GROUP_SIZE)
+
+      pos = (pos + stride) & mask;
+      }
+
+   U_INTERNAL_ASSERT_DIFFERS(free_slot, U_NOT_FOUND)
+
+   index = free_slot;
+
+   U_INTERNAL_DUMP("info[%u] = %u linfo = %u", index, info[index], linfo)
+
+   // nothing found!
+
+   U_RETURN(false);
 #else
    /**
     * Robin Hood Hashing uses the hash value to calculate the position to place it, than does linear probing until it finds an empty spot to place it.
@@ -179,6 +253,23 @@ void UHashMap<void*>::insertAfterFind()
 
    U_CHECK_MEMORY
 
+#ifdef U_SWISS_TABLE
+   U_INTERNAL_DUMP("_length = %u num_deleted = %u max_num_elements_allowed = %u", _length, num_deleted, max_num_elements_allowed)
+
+   U_INTERNAL_ASSERT_MINOR(_length + num_deleted, max_num_elements_allowed)
+
+   U_INTERNAL_DUMP("info[%u] = %u", index, info[index])
+
+   U_INTERNAL_ASSERT_EQUALS(info[index] & U_SWISS_EMPTY, U_SWISS_EMPTY) // empty or deleted
+
+   if (info[index] == U_SWISS_DELETED) --num_deleted;
+
+   linfo = U_SWISS_H2(lhash);
+
+   putNode();
+
+   if ((++_length + num_deleted) >= max_num_elements_allowed) increase_size();
+#else
 #ifdef U_SHERWOOD_V8
    bool bfirst = true;
    int8_t to_next_index, jump_index;
@@ -351,6 +442,7 @@ end:
 #endif
 
    if (++_length == max_num_elements_allowed) increase_size();
+#endif
 }
 
 #define U_HASHMAP_SAVE_CONTEXT \
@@ -399,7 +491,103 @@ bool UHashMap<void*>::invariant()
 }
 #endif
 
-#ifndef U_SHERWOOD_V8
+UHashMapNode* UHashMap<void*>::findNodeWithContext(const char* k, uint32_t klen) const
+{
+   U_TRACE(0, "UHashMap<void*>::findNodeWithContext(%.*S,%u)", klen, k, klen)
+
+   // NB: with a custom index function we can only make the lookup with the static state, so we save and restore it...
+
+   U_HASHMAP_SAVE_CONTEXT;
+
+   UHashMapNode* _tmp6 = node;
+   const char*   _tmp7 = UString::pkey->str;
+   uint32_t      _tmp8 = UString::pkey->_length;
+
+   setKey(k, klen);
+
+   UHashMapNode* pnode = (((UHashMap<void*>*)this)->lookup() ? node : U_NULLPTR);
+
+   UString::pkey->str     = _tmp7;
+   UString::pkey->_length = _tmp8;
+
+   node = _tmp6;
+
+   U_HASHMAP_RESTORE_CONTEXT;
+
+   U_RETURN_POINTER(pnode, UHashMapNode);
+}
+
+UHashMapNode* UHashMap<void*>::findNode(const char* k, uint32_t klen) const
+{
+   U_TRACE(0, "UHashMap<void*>::findNode(%.*S,%u)", klen, k, klen)
+
+   U_INTERNAL_ASSERT_POINTER(k)
+   U_INTERNAL_ASSERT_MAJOR(klen, 0)
+   U_INTERNAL_ASSERT_MAJOR(_capacity, 0)
+
+#ifndef U_SWISS_TABLE
+   return findNodeWithContext(k, klen);
+#else
+   uint32_t hash;
+   bool ignore_case = false, bIntHash = false;
+
+   if      (set_index == setIndex) hash = u_hash((unsigned char*)k, klen);
+   else if (set_index == setIndexIgnoreCase)
+      {
+      hash = u_hash_ignore_case((unsigned char*)k, klen);
+
+      ignore_case = true;
+      }
+   else if (set_index == setIndexIntHash)
+      {
+      U_INTERNAL_ASSERT_EQUALS(klen, sizeof(uint32_t))
+
+#  ifdef USE_HARDWARE_CRC32
+      hash = __builtin_ia32_crc32si(0xABAD1DEA, *(uint32_t*)k);
+#  else
+      hash = u_integerHash(*(uint32_t*)k);
+#  endif
+
+      bIntHash = true;
+      }
+   else
+      {
+      return findNodeWithContext(k, klen);
+      }
+
+   const uint8_t* ctrl;
+   UHashMapNode* pnode;
+   uint8_t h2 = U_SWISS_H2(hash);
+   uint32_t bits, pos = hash & mask, stride = 0;
+
+   for (;;)
+      {
+      ctrl = info + pos;
+
+      for (bits = u_group_match(ctrl, h2); bits; bits &= bits-1)
+         {
+         pnode = (UHashMapNode*)(table + (((pos + __builtin_ctz(bits)) & mask) * UHashMapNode::size()));
+
+         if (pnode->hash == hash &&
+             (bIntHash ? *(uint32_t*)pnode->key->data() == *(uint32_t*)k
+                       : UStringRep::equal_lookup((UStringRep*)pnode->key, k, klen, ignore_case)))
+            {
+            U_RETURN_POINTER(pnode, UHashMapNode);
+            }
+         }
+
+      if (u_group_match(ctrl, U_SWISS_EMPTY)) break;
+
+      stride += U_SWISS_GROUP_SIZE;
+
+      pos = (pos + stride) & mask;
+      }
+
+   U_RETURN_POINTER(U_NULLPTR, UHashMapNode);
+#endif
+}
+
+#if !defined(U_SHERWOOD_V8) && !defined(U_SWISS_TABLE)
 #  define U_HASHMAP_SWAP_NODE(e,k,h) \
  const void* _tmp1 = node->elem; \
  node->elem = e; \
@@ -458,7 +646,15 @@ void UHashMap<void*>::increase_size()
 
    U_INTERNAL_ASSERT_MAJOR(_capacity, 1)
 
+#ifdef U_SWISS_TABLE
+   U_INTERNAL_DUMP("_length = %u num_deleted = %u", _length, num_deleted)
+
+   // NB: if the load come mostly from the tombstones (deleted slots) we rehash at the same size...
+
+   _allocate(_length <= ((old_capacity / 32) * 25) ? old_capacity : old_capacity << 1);
+#else
    _allocate(_capacity << 1); // x 2...
+#endif
 
    // we insert the old elements
 
@@ -484,6 +680,31 @@ void UHashMap<void*>::increase_size()
 
          U_INTERNAL_DUMP("info[%u] = %u", index, info[index])
 
+         putNode();
+         }
+#  elif defined(U_SWISS_TABLE)
+      if ((old_info[idx] & U_SWISS_EMPTY) == 0)
+         {
+         setNodePointer(old_table, idx);
+
+         lelem = node->elem;
+         lkey  = node->key;
+         lhash = node->hash;
+         linfo = U_SWISS_H2(lhash);
+
+         // the new table has no tombstones and the element is not there: we take the first empty slot of the probe sequence
+
+         uint32_t bits, pos = lhash & mask, stride = 0;
+
+         while ((bits = u_group_match_empty_or_deleted(info + pos)) == 0)
+            {
+            stride += U_SWISS_GROUP_SIZE;
+
+            pos = (pos + stride) & mask;
+            }
+
+         index = (pos + __builtin_ctz(bits)) & mask;
+
          putNode();
          }
 #  else
@@ -574,6 +795,33 @@ void UHashMap<void*>::eraseAfterFind()
 
       U_INTERNAL_DUMP("info[%u] = %u", index, info[index])
       }
+#elif defined(U_SWISS_TABLE)
+   index = ((char*)node - table) / UHashMapNode::size(); // NB: erase() with iterator set only the node pointer...
+
+   U_INTERNAL_ASSERT(isNoEmpty(index))
+
+   /**
+    * If the run of full slots around the erased one is shorter than a group, any group that contain this slot has also an empty slot,
+    * so no probe sequence has ever continued past it and we can mark it empty, otherwise we must leave a tombstone (deleted slot)
+    */
+
+   uint32_t empty_before = u_group_match(info + ((index - U_SWISS_GROUP_SIZE) & mask), U_SWISS_EMPTY),
+            empty_after  = u_group_match(info +   index,                            U_SWISS_EMPTY);
+
+   if (empty_before &&
+       empty_after  &&
+       (__builtin_ctz(empty_after) + __builtin_clz(empty_before) - (32 - U_SWISS_GROUP_SIZE)) < U_SWISS_GROUP_SIZE)
+      {
+      setCtrl(index, U_SWISS_EMPTY);
+      }
+   else
+      {
+      setCtrl(index, U_SWISS_DELETED);
+
+      ++num_deleted;
+      }
+
+   U_INTERNAL_DUMP("info[%u] = %u num_deleted = %u", index, info[index], num_deleted)
 #else
    // perform backward shift deletion: shift elements to the left until we find one that is either empty or has zero offset
    //
@@ -931,6 +1179,9 @@ const char* UHashMap<void*>::dump(bool reset) const
                   << "index                    " << index        << '\n'
                   << "_length                  " << _length      << "\n"
                   << "_capacity                " << _capacity    << '\n'
+#    ifdef U_SWISS_TABLE
+                  << "num_deleted              " << num_deleted  << '\n'
+#    endif
                   << "max_num_elements_allowed " << max_num_elements_allowed;
 
    if (reset)
@@ -21,9 +21,11 @@ void UCDB::init_internal(int ignore_case)
    (void) U_SYSCALL(memset, "%p,%d,%d",  &key, 0, sizeof(datum));
    (void) U_SYSCALL(memset, "%p,%d,%d", &data, 0, sizeof(datum));
 
-   hr   = U_NULLPTR;
-   slot = U_NULLPTR;
-   hp   = U_NULLPTR;
+   hr     = U_NULLPTR;
+   slot   = U_NULLPTR;
+   hp     = U_NULLPTR;
+   slot64 = U_NULLPTR;
+   hp64   = U_NULLPTR;
 
    pattern                 = U_NULLPTR;
    pbuffer                 = U_NULLPTR;
@@ -53,6 +55,8 @@ void UCDB::init_internal(int ignore_case)
    flag[1] =
    flag[2] =
    flag[3] = 0;
+
+   bcdb64 = false;
 }
 
 bool UCDB::open(bool brdonly)
@@ -72,24 +76,58 @@ bool UCDB::open(bool brdonly)
 
          if (UFile::map == MAP_FAILED)
             {
+            uint32_t pos = 0;
+
             data.dptr = U_NULLPTR;
 
             hp   =   &hp_buf;
             hr   =   &hr_buf;
             slot = &slot_buf;
 
-            (void) UFile::pread(&start_hash_table_slot, sizeof(uint32_t), 0);
+            (void) UFile::pread(&pos, sizeof(uint32_t), 0);
+
+            if (pos == CDB64_MAGIC)
+               {
+               U_WARNING("UCDB::open() - the cdb64 format need mmap - db(%.*S)", U_FILE_TO_TRACE(*this));
+
+               UFile::close();
+
+               U_RETURN(false);
+               }
+
+            bcdb64                = false;
+            start_hash_table_slot = pos;
             }
          else
             {
             UFile::close();
 
-            start_hash_table_slot = *(uint32_t*)UFile::map;
+            bcdb64 = (*(uint32_t*)UFile::map == CDB64_MAGIC);
+
+            if (bcdb64 == false) start_hash_table_slot = *(uint32_t*)UFile::map;
+            else
+               {
+               cdb64_header* ph = (cdb64_header*)UFile::map;
+
+               if (ph->version > CDB64_VERSION)
+                  {
+                  U_WARNING("UCDB::open() - cdb64 version not supported (%u > %u) - db(%.*S)", ph->version, CDB64_VERSION, U_FILE_TO_TRACE(*this));
+
+                  UFile::munmap();
+
+                  U_RETURN(false);
+                  }
+
+               nrecord               = ph->nrecord;
+               start_hash_table_slot = ph->eod;
+               }
             }
 
-         nrecord = (UFile::st_size - start_hash_table_slot) / sizeof(cdb_hash_table_slot);
+         if (bcdb64 == false) nrecord = (UFile::st_size - start_hash_table_slot) / sizeof(cdb_hash_table_slot);
          }
 
+      U_INTERNAL_DUMP("bcdb64 = %b", bcdb64)
+
       U_INTERNAL_DUMP("nrecord = %u", nrecord)
 
 #  ifdef DEBUG
@@ -108,6 +146,8 @@ bool UCDB::find()
 
    U_INTERNAL_ASSERT_MAJOR(UFile::st_size, 0)
 
+   if (bcdb64) return find64();
+
    // A record is located as follows. Compute the hash value of the key in the record.
    // The hash value modulo CDB_NUM_HASH_TABLE_POINTER is the number of a hash table
 
@@ -116,7 +156,7 @@ bool UCDB::find()
    if (UFile::map == MAP_FAILED) (void) UFile::pread(&hp_buf, sizeof(cdb_hash_table_pointer), offset);
    else                          hp = (cdb_hash_table_pointer*) (UFile::map + offset);
 
-   U_INTERNAL_DUMP("hp[%d] = { %u, %u }", offset / sizeof(cdb_hash_table_pointer), hp->pos, hp->slots)
+   U_INTERNAL_DUMP("hp[%u] = { %u, %u }", (uint32_t)(offset / sizeof(cdb_hash_table_pointer)), hp->pos, hp->slots)
 
    if (hp->slots)
       {
@@ -145,9 +185,9 @@ bool UCDB::find()
    U_RETURN(false);
 }
 
-U_NO_EXPORT inline bool UCDB::match(uint32_t pos)
+U_NO_EXPORT inline bool UCDB::match(uint64_t pos)
 {
-   U_TRACE(0, "UCDB::match(%u)", pos)
+   U_TRACE(0, "UCDB::match(%llu)", pos)
 
    U_CHECK_MEMORY
 
@@ -202,6 +242,8 @@ bool UCDB::findNext()
 {
    U_TRACE_NO_PARAM(0, "UCDB::findNext()")
 
+   if (bcdb64) return findNext64();
+
    uint32_t pos;
 
    // Probe that slot, the next higher slot, and so on, until you find the record or run into an empty slot
@@ -260,6 +302,79 @@ bool UCDB::findNext()
    U_RETURN(false);
 }
 
+// cdb64: the same of find()/findNext() on the mmap'ed file with 64-bit positions and hash values
+
+U_NO_EXPORT bool UCDB::find64()
+{
+   U_TRACE_NO_PARAM(0, "UCDB::find64()")
+
+   U_INTERNAL_ASSERT_DIFFERS(UFile::map, MAP_FAILED)
+
+   offset = sizeof(cdb64_header) + (khash % CDB_NUM_HASH_TABLE_POINTER) * sizeof(cdb64_hash_table_pointer);
+   hp64   = (cdb64_hash_table_pointer*) (UFile::map + offset);
+
+   U_INTERNAL_DUMP("hp64[%u] = { %llu, %llu }", (uint32_t)(khash % CDB_NUM_HASH_TABLE_POINTER), hp64->pos, hp64->slots)
+
+   if (hp64->slots)
+      {
+      nslot  = (khash / CDB_NUM_HASH_TABLE_POINTER) % hp64->slots;
+      offset = hp64->pos + (nslot * sizeof(cdb64_hash_table_slot));
+      slot64 = (cdb64_hash_table_slot*) (UFile::map + offset);
+
+      U_INTERNAL_DUMP("slot64[%u] = { %llu, %llu }", nslot, u_get_unaligned64(slot64->hash), u_get_unaligned64(slot64->pos))
+
+      if (u_get_unaligned64(slot64->pos))
+         {
+         loop = 0;
+
+         return findNext64();
+         }
+      }
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT bool UCDB::findNext64()
+{
+   U_TRACE_NO_PARAM(0, "UCDB::findNext64()")
+
+   uint64_t pos;
+
+   while (++loop <= hp64->slots)
+      {
+      U_INTERNAL_DUMP("loop = %u", loop)
+
+      if (loop > 1)
+         {
+         // handles repeated keys...
+
+         if (++nslot != hp64->slots) ++slot64;
+         else
+            {
+            nslot  = 0;
+            slot64 = (cdb64_hash_table_slot*) (UFile::map + hp64->pos);
+            }
+         }
+
+      pos = u_get_unaligned64(slot64->pos);
+
+      U_INTERNAL_DUMP("slot64[%u] = { %llu, %llu }", nslot, u_get_unaligned64(slot64->hash), pos)
+
+      if (pos == 0) break;
+
+      if (u_get_unaligned64(slot64->hash) == khash)
+         {
+         hr = (cdb_record_header*)(UFile::map + pos);
+
+         U_INTERNAL_DUMP("hr = { %u, %u }", u_get_unaligned32(hr->klen), u_get_unaligned32(hr->dlen))
+
+         if (u_get_unaligned32(hr->klen) == key.dsize && match(pos)) U_RETURN(true);
+         }
+      }
+
+   U_RETURN(false);
+}
+
 UString UCDB::at()
 {
    U_TRACE_NO_PARAM(0, "UCDB::at()")
@@ -273,12 +388,14 @@ UString UCDB::at()
 
 // FOR RDB
 
-uint32_t UCDB::makeFinish(bool _reset)
+uint64_t UCDB::makeFinish(bool _reset)
 {
    U_TRACE(1+256, "UCDB::makeFinish(%b)", _reset)
 
    U_INTERNAL_ASSERT_DIFFERS(UFile::map, MAP_FAILED)
 
+   if (bcdb64) return makeFinish64(_reset);
+
    // Each of the CDB_NUM_HASH_TABLE_POINTER initial pointers states a position and a length.
    // The position is the starting byte position of the hash table.
    // The length is the number of slots in the hash table
@@ -390,6 +507,101 @@ uint32_t UCDB::makeFinish(bool _reset)
    U_RETURN(pos);
 }
 
+U_NO_EXPORT uint64_t UCDB::makeFinish64(bool _reset)
+{
+   U_TRACE(1+256, "UCDB::makeFinish64(%b)", _reset)
+
+   char* eod = (char*)hr; // END OF DATA (eod) -> start of hash table slot...
+
+   start_hash_table_slot = eod - UFile::map;
+
+   uint64_t pos = start_hash_table_slot;
+
+   cdb64_header* ph = (cdb64_header*) UFile::map;
+
+   ph->magic   = CDB64_MAGIC;
+   ph->version = CDB64_VERSION;
+   ph->eod     = start_hash_table_slot;
+   ph->nrecord = nrecord;
+
+   hp64 = (cdb64_hash_table_pointer*) (UFile::map + sizeof(cdb64_header));
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", hp64, 0, CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb64_hash_table_pointer));
+
+   U_INTERNAL_DUMP("nrecord = %u", nrecord)
+
+   if (nrecord > 0)
+      {
+      uint32_t i;
+
+      struct cdb64_tmp {
+         uint64_t hash;
+         uint64_t pos;
+         uint32_t index;
+      };
+
+      cdb64_tmp*  tmp = (cdb64_tmp*) UMemoryPool::cmalloc(nrecord, sizeof(cdb64_tmp));
+      cdb64_tmp* ptmp = tmp;
+
+      cdb64_hash_table_slot* pslot;
+
+      for (char* ptr = start(); ptr < eod; ++ptmp)
+         {
+         ptmp->pos = (ptr - UFile::map);
+
+         hr = (cdb_record_header*)ptr;
+
+         ptr += sizeof(UCDB::cdb_record_header);
+
+         uint32_t klen = u_get_unaligned32(hr->klen);
+         ptmp->hash    = cdb_hash(ptr, klen);
+         ptmp->index   = ptmp->hash % CDB_NUM_HASH_TABLE_POINTER;
+
+         hp64[ptmp->index].slots += 2;
+
+         ptr += klen + u_get_unaligned32(hr->dlen);
+         }
+
+      for (i = 0; i < CDB_NUM_HASH_TABLE_POINTER; ++i)
+         {
+         hp64[i].pos = pos;
+
+         pos += hp64[i].slots * sizeof(cdb64_hash_table_slot);
+
+         U_INTERNAL_ASSERT(pos <= (uint64_t)st_size)
+         }
+
+      U_INTERNAL_DUMP("nrecord = %u num_hash_slot = %llu", nrecord, (pos - start_hash_table_slot) / sizeof(cdb64_hash_table_slot))
+
+      if (_reset) (void) U_SYSCALL(memset, "%p,%d,%u", eod, 0, pos - start_hash_table_slot);
+
+      for (i = 0; i < nrecord; ++i)
+         {
+         slot64 = (cdb64_hash_table_slot*)(UFile::map + hp64[tmp[i].index].pos);
+
+         nslot = (tmp[i].hash / CDB_NUM_HASH_TABLE_POINTER) % hp64[tmp[i].index].slots;
+
+         // handles repeated keys...
+
+         while (true)
+            {
+            pslot = slot64 + nslot;
+
+            if (u_get_unaligned64(pslot->pos) == 0) break;
+
+            if (++nslot == hp64[tmp[i].index].slots) nslot = 0;
+            }
+
+         u_put_unaligned64(pslot->hash, tmp[i].hash);
+         u_put_unaligned64(pslot->pos,  tmp[i].pos);
+         }
+
+      UMemoryPool::_free(tmp, nrecord, sizeof(cdb64_tmp));
+      }
+
+   U_RETURN(pos);
+}
+
 // Call function for all entry
 
 void UCDB::callForAllEntry(vPFpvpc function)
@@ -810,7 +1022,7 @@ bool UCDB::writeTo(UCDB& cdb, UHashMap<void*>* table, uint32_t tbl_space, pvPFpv
                        : table->size());
 
    bool result = cdb.creat(O_RDWR) &&
-                 cdb.ftruncate(sizeFor(cdb.nrecord) + tbl_space);
+                 cdb.ftruncate(sizeFor(cdb.nrecord, cdb.bcdb64) + tbl_space);
 
    if (result)
       {
@@ -823,11 +1035,64 @@ bool UCDB::writeTo(UCDB& cdb, UHashMap<void*>* table, uint32_t tbl_space, pvPFpv
 
       cdb.hr = (UCDB::cdb_record_header*) writeTo_ptr; // end of DATA
 
-      uint32_t pos = cdb.makeFinish(true);
+      uint64_t pos = cdb.makeFinish(true);
 
-      U_INTERNAL_ASSERT(pos <= (uint32_t)cdb.st_size)
+      U_INTERNAL_ASSERT(pos <= (uint64_t)cdb.st_size)
 
-      if (pos < (uint32_t)cdb.st_size)
+      if (pos < (uint64_t)cdb.st_size)
+         {
+                  cdb.munmap();
+         result = cdb.ftruncate(pos);
+         }
+
+      cdb.UFile::close();
+      }
+
+   U_RETURN(result);
+}
+
+bool UCDB::copyTo(const UString& path, bool b64)
+{
+   U_TRACE(1, "UCDB::copyTo(%V,%b)", path.rep, b64)
+
+   U_INTERNAL_ASSERT_MAJOR(UFile::st_size, 0)
+   U_INTERNAL_ASSERT_DIFFERS(UFile::map, MAP_FAILED)
+
+   // NB: the records have the same layout in both format, we copy them in a single block and after we build the hash tables...
+
+   uint64_t len = end() - start();
+
+   if (b64 == false &&
+       (CDB_NUM_HASH_TABLE_POINTER * sizeof(cdb_hash_table_pointer) + len + (uint64_t)nrecord * sizeof(cdb_hash_table_slot)) > 0xFFFFFFFFULL) // NB: the positions of the classic format are 32-bit...
+      {
+      U_WARNING("UCDB::copyTo() - the classic format can't go beyond 4 gigabytes, use the cdb64 format - db(%.*S)", U_FILE_TO_TRACE(*this));
+
+      U_RETURN(false);
+      }
+
+   UCDB cdb(path, U_cdb_ignore_case(this));
+
+   cdb.bcdb64 = b64;
+
+   bool result = cdb.creat(O_RDWR) &&
+                 cdb.ftruncate(sizeFor(nrecord, b64) + len);
+
+   if (result)
+      {
+      if (cdb.memmap(PROT_READ | PROT_WRITE) == false) U_RETURN(false);
+
+      cdb.makeStart();
+
+      U_MEMCPY(cdb.hr, start(), len);
+
+      cdb.hr      = (cdb_record_header*)((char*)cdb.hr + len);
+      cdb.nrecord = nrecord;
+
+      uint64_t pos = cdb.makeFinish(true);
+
+      U_INTERNAL_ASSERT(pos <= (uint64_t)cdb.st_size)
+
+      if (pos < (uint64_t)cdb.st_size)
          {
                   cdb.munmap();
          result = cdb.ftruncate(pos);
@@ -851,7 +1116,32 @@ U_NO_EXPORT void UCDB::checkForAllEntry()
 
    char* ptr;
    char* _eof = UFile::map + (ptrdiff_t)UFile::st_size;
-   slot       = (cdb_hash_table_slot*) end();
+
+   if (bcdb64)
+      {
+      for (slot64 = (cdb64_hash_table_slot*) end(); (char*)slot64 < _eof; ++slot64)
+         {
+         uint64_t pos = u_get_unaligned64(slot64->pos);
+
+         if (pos)
+            {
+            ptr = UFile::map + pos;
+             hr = (cdb_record_header*)ptr;
+
+            khash     = u_get_unaligned64(slot64->hash);
+            key.dsize = u_get_unaligned32(hr->klen);
+            key.dptr  = ptr + sizeof(cdb_record_header);
+
+            U_INTERNAL_DUMP("key = %.*S khash = %llu", key.dsize, key.dptr, khash)
+
+            if (key.dsize == 0) U_ERROR("UCDB::checkForAllEntry() - null key size - db(%.*S)", U_FILE_TO_TRACE(*this));
+            }
+         }
+
+      return;
+      }
+
+   slot = (cdb_hash_table_slot*) end();
 
    while ((char*)slot < _eof)
       {
@@ -868,7 +1158,7 @@ U_NO_EXPORT void UCDB::checkForAllEntry()
          key.dsize = u_get_unaligned32(hr->klen);
          key.dptr  = ptr + sizeof(cdb_record_header);
 
-         U_INTERNAL_DUMP("key = %.*S khash = %u", key.dsize, key.dptr, khash)
+         U_INTERNAL_DUMP("key = %.*S khash = %llu", key.dsize, key.dptr, khash)
 
          if (key.dsize == 0) U_ERROR("UCDB::checkForAllEntry() - null key size - db(%.*S)", U_FILE_TO_TRACE(*this));
          }
@@ -973,7 +1263,7 @@ U_EXPORT istream& operator>>(istream& is, UCDB& cdb)
 
    cdb.hr = (UCDB::cdb_record_header*) ptr; // end of DATA
 
-   uint32_t pos = cdb.makeFinish(true);
+   uint64_t pos = cdb.makeFinish(true);
 
           cdb.munmap();
    (void) cdb.ftruncate(pos);
@@ -1011,6 +1301,9 @@ const char* UCDB::dump(bool _reset) const
                                                   << ' '            << data.dsize
                                                                     << " }\n"
                   << "slot                      " << (void*)slot    << '\n'
+                  << "hp64                      " << (void*)hp64    << '\n'
+                  << "slot64                    " << (void*)slot64  << '\n'
+                  << "bcdb64                    " << bcdb64         << '\n'
                   << "loop                      " << loop           << '\n'
                   << "nslot                     " << nslot          << '\n'
                   << "khash                     " << khash          << '\n'
@@ -38,6 +38,10 @@
 sem_t    URDB::nolock;
 ULock*   URDB::preclock;
 uint32_t URDB::nerror;
+uint32_t URDB::ncompaction;
+uint64_t URDB::compaction_reclaimed;
+long     URDB::compaction_time;
+long     URDB::compaction_lock_time;
 
 #define U_FOR_EACH_ENTRY1(pcdb,function1)                      \
                                                                \
@@ -115,7 +119,7 @@ U_NO_EXPORT bool URDB::htLookup(URDB* prdb)
 
    prdb->pnode = RDB_hashtab(prdb) + (prdb->UCDB::khash % CACHE_HASHTAB_LEN);
 
-   U_INTERNAL_DUMP("pnode = %p slot = %u", prdb->pnode, prdb->UCDB::khash % CACHE_HASHTAB_LEN)
+   U_INTERNAL_DUMP("pnode = %p slot = %u", prdb->pnode, (uint32_t)(prdb->UCDB::khash % CACHE_HASHTAB_LEN))
 
    uint32_t len;
 
@@ -214,11 +218,15 @@ U_NO_EXPORT void URDB::htAlloc(URDB* prdb)
 
    prdb->node = RDB_off(prdb);
 
-   u_put_unalignedp32(prdb->pnode, prdb->node);
-
    RDB_off(prdb) += sizeof(URDB::cache_node);
 
    (void) U_SYSCALL(memset, "%p,%d,%d", prdb->journal.map + prdb->node, 0, sizeof(URDB::cache_node));
+
+   // NB: a reader without the lock (see ONLINE COMPACTION) must see the offset moved before the pointer to the new node...
+
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+
+   u_put_unalignedp32(prdb->pnode, prdb->node);
 }
 
 // remove one node allocated for the hash tree
@@ -237,13 +245,23 @@ U_NO_EXPORT void URDB::htRemoveAlloc(URDB* prdb)
       }
 #endif
 
-   RDB_off(prdb) -= sizeof(URDB::cache_node);
+   U_INTERNAL_ASSERT_EQUALS(prdb->node, u_get_unalignedp32(prdb->pnode))
 
-   U_INTERNAL_ASSERT_EQUALS(RDB_off(prdb), u_get_unalignedp32(prdb->pnode))
+   u_put_unalignedp32(prdb->pnode, 0);
 
    (void) U_SYSCALL(memset, "%p,%d,%d", prdb->journal.map + prdb->node, 0, sizeof(URDB::cache_node));
 
-   u_put_unalignedp32(prdb->pnode, 0);
+   U_INTERNAL_DUMP("node = %u RDB_off = %u", prdb->node, RDB_off(prdb))
+
+   if ((prdb->node + sizeof(URDB::cache_node)) == RDB_off(prdb)) // NB: the node is the last allocation (the write on the journal is failed)...
+      {
+      // NB: a reader without the lock (see ONLINE COMPACTION) can have taken a copy of the journal with the node, so before we give back
+      //     the space we change the generation: with the same offset the next allocation would be seen as the same journal...
+
+      (void) __atomic_add_fetch(&RDB_generation(prdb), 1, __ATOMIC_SEQ_CST);
+
+      RDB_off(prdb) = prdb->node;
+      }
 }
 
 // Insert one key/data pair in the cache
@@ -272,6 +290,8 @@ U_NO_EXPORT void URDB::htInsert(URDB* prdb)
    uint32_t offset1 =                           (char*)prdb->UCDB::key.dptr  - prdb->journal.map,
             offset2 = (prdb->UCDB::data.dptr ? ((char*)prdb->UCDB::data.dptr - prdb->journal.map) : 0);
 
+   __atomic_thread_fence(__ATOMIC_RELEASE); // NB: the record is appended (the offset is moved) before we change the node (see ONLINE COMPACTION)...
+
    u_put_unaligned32(RDB_node(prdb)->key.dptr,   offset1);
    u_put_unaligned32(RDB_node(prdb)->key.dsize,  prdb->UCDB::key.dsize);
    u_put_unaligned32(RDB_node(prdb)->data.dptr,  offset2);
@@ -323,15 +343,18 @@ U_NO_EXPORT bool URDB::resizeJournal(uint32_t oversize)
 
       key1              = UCDB::key;
       UCDB::datum data1 = UCDB::data;
-      uint32_t save     = UCDB::khash;
+      uint64_t save     = UCDB::khash;
+      bool save64       = UCDB::bcdb64;
 
       if (reorganize())
          {
          // set old entry
 
-         UCDB::key   = key1;
-         UCDB::data  = data1;
-         UCDB::khash = save;
+         UCDB::key  = key1;
+         UCDB::data = data1;
+
+         if (save64 == UCDB::bcdb64) UCDB::khash = save;
+         else                        UCDB::cdb_hash(); // NB: reorganize() have upgraded the database to the cdb64 format...
 
          (void) htLookup(this);
 
@@ -571,6 +594,213 @@ void URDB::lockRecord()
    (plock = (preclock+(UCDB::khash & (U_SHM_LOCK_NENTRY-1))))->lock();
 }
 
+// ----------------------------------------------------------------------------------------------------------------------
+// ONLINE COMPACTION: reorganize() and compactionJournal() don't hold the lock of the database while they rebuild it.
+// ----------------------------------------------------------------------------------------------------------------------
+// 1) we copy the used part of the journal in a private snapshot. From now the writers (the other preforked processes)
+//    continue to append to the journal after the offset of the snapshot...
+// 2) without the lock we build the new image (the cdb or the journal) from the snapshot...
+// 3) we replay on the new image only the entries changed after the snapshot (the delta) and with the lock held we swap
+//    the files. Every store()/remove() append a new record to the journal and the node of the entry point to it, so
+//    a node with the key beyond the offset of the snapshot is changed, the only exception are the data updated in
+//    place by URDBObjectHandler that we find comparing the data with the snapshot...
+// ----------------------------------------------------------------------------------------------------------------------
+// NB: the copies of the journal (the snapshot and the one for the delta) are done without the lock, like a seqlock: a
+//     store()/remove() move the offset of the journal before to change a pointer of the tree, and reorganize() increment
+//     the generation before to reset the journal (like a store()/remove() failed on the journal before to give back the
+//     node, see htRemoveAlloc()), so the copy is good if the offset and the generation are the same before and after it. Otherwise we retry, and at the end we copy with the lock held. With the lock held we check
+//     only that the journal is not changed after the copy for the delta, if it is we compute the delta again...
+// ----------------------------------------------------------------------------------------------------------------------
+// NB: the data updated in place by URDBObjectHandler don't take the lock of the journal, an update after the copy for
+//     the delta is lost like an update on the journal of a process that have not yet reopened it after the swap...
+// ----------------------------------------------------------------------------------------------------------------------
+// NB: if the caller already hold the lock (resizeJournal(), beginTransaction()) we do all the steps with the lock held...
+// ----------------------------------------------------------------------------------------------------------------------
+// NB: the compactions of different processes can run meanwhile, before the swap we check the generation of the journal
+//     (reorganize() reset the journal in place, so its inode don't change) and the inode of the file that we substitute...
+// ----------------------------------------------------------------------------------------------------------------------
+
+#define U_RDB_SNAPSHOT_RETRY 3
+
+static ino_t getInode(const char* path)
+{
+   U_TRACE(1, "getInode(%S)", path)
+
+   struct stat st;
+
+   if (U_SYSCALL(stat, "%S,%p", path, &st) == 0) U_RETURN(st.st_ino);
+
+   U_RETURN(0);
+}
+
+U_NO_EXPORT void URDB::setSnapshot(const char* snapshot, uint32_t off_snapshot)
+{
+   U_TRACE(0, "URDB::setSnapshot(%p,%u)", snapshot, off_snapshot)
+
+   // NB: the snapshot is a copy of the journal until the offset of the snapshot, so we can read it like the journal...
+
+   journal.map     = (char*)snapshot;
+   journal.st_size = off_snapshot;
+
+   U_INTERNAL_ASSERT_EQUALS(RDB_off(this), off_snapshot)
+}
+
+U_NO_EXPORT bool URDB::isJournalChanged(uint32_t off, uint32_t generation)
+{
+   U_TRACE(0, "URDB::isJournalChanged(%u,%u)", off, generation)
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST); // NB: the loads of the copy must not be reordered after the check...
+
+   if (__atomic_load_n(&RDB_off(this),        __ATOMIC_RELAXED) != off ||
+       __atomic_load_n(&RDB_generation(this), __ATOMIC_RELAXED) != generation)
+      {
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT bool URDB::getSnapshot(UString& snapshot, uint32_t& off_snapshot, uint32_t& generation)
+{
+   U_TRACE(0, "URDB::getSnapshot(%V,%u,%u)", snapshot.rep, off_snapshot, generation)
+
+   for (uint32_t i = 0; i < U_RDB_SNAPSHOT_RETRY; ++i)
+      {
+      lock(); // NB: so there is no store()/remove() in progress when we read the offset...
+
+      off_snapshot = RDB_off(this);
+      generation   = RDB_generation(this);
+
+      unlock();
+
+      snapshot = UString((const void*)journal.map, off_snapshot);
+
+      if (isJournalChanged(off_snapshot, generation) == false) U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT uint32_t URDB::getDeltaWithoutLock(const char* snapshot, uint32_t off_snapshot, uint32_t generation, UString& delta)
+{
+   U_TRACE(0, "URDB::getDeltaWithoutLock(%p,%u,%u,%V)", snapshot, off_snapshot, generation, delta.rep)
+
+   // NB: we compute the delta on a copy of the journal, return the offset of the copy (0 if we don't have a good copy)...
+
+   UString current;
+   uint32_t off_current, generation_current;
+
+   if (getSnapshot(current, off_current, generation_current) == false ||
+       generation_current != generation)
+      {
+      U_RETURN(0);
+      }
+
+   char* journal_map  = journal.map;
+   off_t journal_size = journal.st_size;
+
+   setSnapshot(current.data(), off_current);
+
+   getDelta(snapshot, off_snapshot, delta);
+
+   journal.map     = journal_map;
+   journal.st_size = journal_size;
+
+   U_RETURN(off_current);
+}
+
+U_NO_EXPORT void URDB::delta1(const char* snapshot, uint32_t off_snapshot, UString* pdelta, uint32_t _offset)
+{
+   U_TRACE(0, "URDB::delta1(%p,%u,%p,%u)", snapshot, off_snapshot, pdelta, _offset)
+
+   URDB::cache_node* n = RDB_ptr_node(this, _offset);
+
+   if (RDB_cache_node(n,left))  delta1(snapshot, off_snapshot, pdelta, RDB_cache_node(n,left));
+   if (RDB_cache_node(n,right)) delta1(snapshot, off_snapshot, pdelta, RDB_cache_node(n,right));
+
+   uint32_t offset_key  = RDB_cache_node(n, key.dptr),
+            offset_data = RDB_cache_node(n,data.dptr),
+            size_key    = RDB_cache_node(n, key.dsize),
+            size_data   = RDB_cache_node(n,data.dsize);
+
+   U_INTERNAL_DUMP("offset_key = %u offset_data = %u", offset_key, offset_data)
+
+   if (offset_key >= off_snapshot ||
+       (offset_data &&
+        memcmp(journal.map + offset_data, snapshot + offset_data, size_data)))
+      {
+      UCDB::cdb_record_header hrec = { size_key, (offset_data ? size_data : U_NOT_FOUND) }; // NB: U_NOT_FOUND => entry deleted...
+
+      pdelta->append((const char*)&hrec, sizeof(UCDB::cdb_record_header));
+      pdelta->append(journal.map + offset_key, size_key);
+
+      if (offset_data) pdelta->append(journal.map + offset_data, size_data);
+      }
+}
+
+U_NO_EXPORT void URDB::getDelta(const char* snapshot, uint32_t off_snapshot, UString& delta)
+{
+   U_TRACE(0, "URDB::getDelta(%p,%u,%V)", snapshot, off_snapshot, delta.rep)
+
+   U_INTERNAL_DUMP("RDB_off = %u", RDB_off(this))
+
+   U_INTERNAL_ASSERT(RDB_off(this) >= off_snapshot)
+
+   for (uint32_t _offset, i = 0; i < CACHE_HASHTAB_LEN; ++i)
+      {
+      if ((_offset = RDB_hashtab(this)[i])) delta1(snapshot, off_snapshot, &delta, _offset);
+      }
+
+   U_INTERNAL_DUMP("delta(%u) = %V", delta.size(), delta.rep)
+}
+
+U_NO_EXPORT void URDB::applyDelta(const UString& delta)
+{
+   U_TRACE(0, "URDB::applyDelta(%V)", delta.rep)
+
+   uint32_t klen, dlen;
+   const char* ptr = delta.data();
+   const char* end = delta.pend();
+
+   while (ptr < end)
+      {
+      klen = u_get_unalignedp32(ptr);
+      dlen = u_get_unalignedp32(ptr+4);
+
+      ptr += sizeof(UCDB::cdb_record_header);
+
+      UCDB::setKey(ptr, klen);
+
+      ptr += klen;
+
+      if (dlen == U_NOT_FOUND) (void) _remove();
+      else
+         {
+         UCDB::setData(ptr, dlen);
+
+         ptr += dlen;
+
+         UCDB::cdb_hash();
+
+         (void) _store(RDB_REPLACE, htLookup(this));
+         }
+      }
+}
+
+U_NO_EXPORT void URDB::setStats(long time_lock, uint64_t size_before, uint64_t size_after)
+{
+   U_TRACE(0, "URDB::setStats(%ld,%llu,%llu)", time_lock, size_before, size_after)
+
+   ++ncompaction;
+
+   compaction_lock_time += time_lock;
+
+   if (size_before > size_after) compaction_reclaimed += (size_before - size_after);
+
+   U_INTERNAL_DUMP("ncompaction = %u compaction_time = %ld compaction_lock_time = %ld compaction_reclaimed = %llu",
+                    ncompaction,     compaction_time,      compaction_lock_time,      compaction_reclaimed)
+}
+
 bool URDB::compactionJournal()
 {
    U_TRACE_NO_PARAM(0, "URDB::compactionJournal()")
@@ -581,64 +811,172 @@ bool URDB::compactionJournal()
 
    U_INTERNAL_DUMP("RDB_off = %u RDB_reference = %u", RDB_off(this), RDB_reference(this))
 
-   bool result = true;
+   bool result    = false,
+        blocked   = (_lock.sem && _lock.isLocked()), // NB: the caller already hold the lock...
+        bsnapshot = (_lock.sem && blocked == false); // NB: without a semaphore there are no other writers...
+   UTimeVal chronometer;
    URDB rdb(UCDB::ignoreCase());
-   char rdb_buffer_path[MAX_FILENAME_LEN];
+   char suffix[32], rdb_buffer_path[MAX_FILENAME_LEN];
+
+   chronometer.start();
+
+   // NB: the name of the new journal is unique for process, the compaction of another process can run meanwhile...
 
-   rdb.journal.setPath(*(const UFile*)this, rdb_buffer_path, U_CONSTANT_TO_PARAM(".tmp"));
+   rdb.journal.setPath(*(const UFile*)this, rdb_buffer_path, suffix, u__snprintf(suffix, sizeof(suffix), U_CONSTANT_TO_PARAM(".%u.tmp"), u_pid));
 
    if (rdb.journal.creat(O_RDWR) &&
        rdb.journal.ftruncate(journal.st_size))
       {
-      if (rdb.journal.memmap(PROT_READ | PROT_WRITE) == false) U_RETURN(false);
+      if (rdb.journal.memmap(PROT_READ | PROT_WRITE, U_NULLPTR, 0, journal.map_size) == false) // NB: oversize mmap like the journal...
+         {
+         (void) rdb.journal._unlink();
+
+         U_RETURN(false);
+         }
 
       rdb.UCDB::nrecord   = 0;
 
       RDB_off(&rdb)       = sizeof(URDB::cache_struct);
+      RDB_magic(&rdb)     = RDB_JOURNAL_MAGIC;
       RDB_reference(&rdb) = 1;
 
       U_INTERNAL_DUMP("RDB_off = %u RDB_sync = %u capacity = %u nrecord = %u RDB_reference = %u",
                        RDB_off(&rdb), RDB_sync(&rdb), RDB_capacity(&rdb), RDB_nrecord(&rdb), RDB_reference(&rdb))
 
-      lock();
+      UString snapshot;
+      UTimeVal chronometer_lock;
+      char* journal_map = journal.map;
+      off_t journal_size = journal.st_size;
+
+      // 1) snapshot
+
+      ino_t inode;
+      long time_lock = 0L;
+      uint32_t off_snapshot, generation;
+
+      if (bsnapshot &&
+          getSnapshot(snapshot, off_snapshot, generation))
+         {
+         inode = getInode(journal.UFile::path_relativ);
+
+         setSnapshot(snapshot.data(), off_snapshot);
+         }
+      else
+         {
+         lock();
+
+         chronometer_lock.start();
+
+         off_snapshot = RDB_off(this);
+         generation   = RDB_generation(this);
+         inode        = getInode(journal.UFile::path_relativ);
+
+         if (bsnapshot) // NB: the journal is changed at every try without the lock...
+            {
+            snapshot = UString((const void*)journal.map, off_snapshot);
+
+            time_lock = chronometer_lock.stop();
+
+            unlock();
+
+            setSnapshot(snapshot.data(), off_snapshot);
+            }
+         }
 
 #  ifdef DEBUG
       nerror = 0;
 #  endif
 
+      // 2) copy of the live entries in the new journal
+
       U_FOR_EACH_ENTRY1(&rdb, copy1)
 
-#  if defined(_MSWINDOWS_) || defined(__CYGWIN__)
-      journal.UFile::munmap(); // for rename()...
-#    ifdef   _MSWINDOWS_
-      rdb.journal.UFile::close();
-#    endif
-#  endif
+      journal.map     = journal_map;
+      journal.st_size = journal_size;
 
-      if (rdb.journal._rename(journal.UFile::path_relativ) == false) U_RETURN(false);
+      // 3) delta and swap
 
-#  if defined(_MSWINDOWS_) || defined(__CYGWIN__)
-#    ifdef   _MSWINDOWS_
-      result = rdb.journal.UFile::open(journal.UFile::path_relativ);
-#    endif
-      result = rdb.journal.memmap(PROT_READ | PROT_WRITE);
-#  endif
+      uint32_t off_delta = 0;
+      UString delta(U_CAPACITY);
 
-#  ifdef DEBUG
-      uint32_t sz1 =     getCapacity(),
-               sz2 = rdb.getCapacity();
+      if (bsnapshot)
+         {
+         off_delta = getDeltaWithoutLock(snapshot.data(), off_snapshot, generation, delta);
 
-      U_DEBUG("URDB::compactionJournal() - nrecords (%u => %u) capacity (%.2fM (%u bytes) => %.2fM (%u bytes)) nerror=%u",
-                        size(), rdb.size(),
-                        (double)sz1 / (1024.0 * 1024.0), sz1,
-                        (double)sz2 / (1024.0 * 1024.0), sz2, nerror)
+         lock();
 
-      nerror = 0;
-#  endif
+         chronometer_lock.start();
+         }
 
-      journal.UFile::substitute(rdb.journal);
+      if (generation == RDB_generation(this) &&
+          inode      == getInode(journal.UFile::path_relativ)) // NB: check if another process have compacted the journal meanwhile...
+         {
+         if (bsnapshot)
+            {
+            if (off_delta != RDB_off(this)) // NB: the journal is changed after the copy for the delta...
+               {
+               delta.setEmpty();
 
-      unlock();
+               getDelta(snapshot.data(), off_snapshot, delta);
+               }
+
+            rdb.applyDelta(delta);
+            }
+
+         RDB_generation(&rdb) = ++RDB_generation(this); // NB: the processes that have still mapped the old journal see the change...
+
+#     if defined(_MSWINDOWS_) || defined(__CYGWIN__)
+         journal.UFile::munmap(); // for rename()...
+#       ifdef   _MSWINDOWS_
+         rdb.journal.UFile::close();
+#       endif
+#     endif
+
+         result = rdb.journal._rename(journal.UFile::path_relativ);
+         }
+      else
+         {
+         U_WARNING("URDB::compactionJournal() - the journal %.*S was compacted (or rolled back) meanwhile by another process", U_FILE_TO_TRACE(journal));
+         }
+
+      if (result == false)
+         {
+         rdb.journal.munmap();
+
+         (void) rdb.journal._unlink();
+         }
+      else
+         {
+#     if defined(_MSWINDOWS_) || defined(__CYGWIN__)
+#       ifdef   _MSWINDOWS_
+         result = rdb.journal.UFile::open(journal.UFile::path_relativ);
+#       endif
+         result = rdb.journal.memmap(PROT_READ | PROT_WRITE);
+#     endif
+
+#     ifdef DEBUG
+         uint32_t sz1 =     getCapacity(),
+                  sz2 = rdb.getCapacity();
+
+         U_DEBUG("URDB::compactionJournal() - nrecords (%u => %u) capacity (%.2fM (%u bytes) => %.2fM (%u bytes)) nerror=%u",
+                           size(), rdb.size(),
+                           (double)sz1 / (1024.0 * 1024.0), sz1,
+                           (double)sz2 / (1024.0 * 1024.0), sz2, nerror)
+
+         nerror = 0;
+#     endif
+
+         uint64_t size_before = RDB_off(this),
+                  size_after  = RDB_off(&rdb);
+
+         journal.UFile::substitute(rdb.journal);
+
+         compaction_time += chronometer.stop();
+
+         setStats(time_lock + chronometer_lock.stop(), size_before, size_after);
+         }
+
+      if (blocked == false) unlock();
 
       U_INTERNAL_DUMP("RDB_off = %u RDB_sync = %u capacity = %u nrecord = %u RDB_reference = %u",
                        RDB_off(this), RDB_sync(this), RDB_capacity(this), RDB_nrecord(this), RDB_reference(this))
@@ -651,11 +989,100 @@ bool URDB::compactionJournal()
          U_WARNING("URDB::compactionJournal() - capacity(%u) < size node(%u)", RDB_capacity(this), sizeof(URDB::cache_node));
          }
 #  endif
+      }
 
-      U_RETURN(result);
+   U_RETURN(result);
+}
+
+// The journal of the previous version has the data storage just after the hash table (without the magic and the generation),
+// so we move it after the new header and we add the shift to all the offsets of the nodes of the hash tree. The first pass
+// only check that all the offsets are inside the journal, so we don't change a journal that we don't recognize...
+
+U_NO_EXPORT bool URDB::migrate1(uint32_t _offset, uint32_t start, bool bfix)
+{
+   U_TRACE(0, "URDB::migrate1(%u,%u,%b)", _offset, start, bfix)
+
+   uint32_t shift = sizeof(URDB::cache_struct) - start;
+
+   URDB::cache_node* n = RDB_ptr_node(this, _offset);
+
+   uint32_t left        = RDB_cache_node(n,left),
+            right       = RDB_cache_node(n,right),
+            offset_key  = RDB_cache_node(n, key.dptr),
+            offset_data = RDB_cache_node(n,data.dptr);
+
+   if (bfix == false)
+      {
+      // NB: the node of a child is always allocated after the node of the parent...
+
+      if ((_offset     < start || (_offset + sizeof(URDB::cache_node))          > RDB_off(this))                      ||
+          (offset_key  < start || (offset_key + RDB_cache_node(n, key.dsize))   > RDB_off(this))                      ||
+          (offset_data &&
+           (offset_data < start || (offset_data + RDB_cache_node(n,data.dsize)) > RDB_off(this)))                     ||
+          (left  && (left  <= _offset || migrate1(left,  start, false) == false)) ||
+          (right && (right <= _offset || migrate1(right, start, false) == false)))
+         {
+         U_RETURN(false);
+         }
+
+      U_RETURN(true);
       }
 
-   U_RETURN(false);
+   if (left)  (void) migrate1(left,  start, true);
+   if (right) (void) migrate1(right, start, true);
+
+   if (left)        u_put_unaligned32(n->left,      left        + shift);
+   if (right)       u_put_unaligned32(n->right,     right       + shift);
+                    u_put_unaligned32(n->key.dptr,  offset_key  + shift);
+   if (offset_data) u_put_unaligned32(n->data.dptr, offset_data + shift);
+
+   U_RETURN(true);
+}
+
+U_NO_EXPORT bool URDB::migrateJournal(uint32_t journal_sz)
+{
+   U_TRACE(0, "URDB::migrateJournal(%u)", journal_sz)
+
+   uint32_t i, _offset,
+            shift = sizeof(uint32_t) * 2, // magic + generation
+            start = sizeof(URDB::cache_struct) - shift;
+
+   U_INTERNAL_DUMP("RDB_off = %u RDB_magic = %x start = %u", RDB_off(this), RDB_magic(this), start)
+
+   if (RDB_off(this) < start ||
+       (RDB_off(this) + shift) > journal_sz)
+      {
+      U_RETURN(false);
+      }
+
+   for (i = 0; i < CACHE_HASHTAB_LEN; ++i)
+      {
+      if ((_offset = RDB_hashtab(this)[i]) &&
+          migrate1(_offset, start, false) == false)
+         {
+         U_RETURN(false);
+         }
+      }
+
+   for (i = 0; i < CACHE_HASHTAB_LEN; ++i)
+      {
+      if ((_offset = RDB_hashtab(this)[i]))
+         {
+         (void) migrate1(_offset, start, true);
+
+         RDB_hashtab(this)[i] = _offset + shift;
+         }
+      }
+
+   (void) U_SYSCALL(memmove, "%p,%p,%u", journal.map + sizeof(URDB::cache_struct), journal.map + start, RDB_off(this) - start);
+
+   RDB_off(this)       += shift;
+   RDB_magic(this)      = RDB_JOURNAL_MAGIC;
+   RDB_generation(this) = 0;
+
+   U_SRV_LOG("URDB: the journal %.*S of the previous version is migrated (%u bytes)", U_FILE_TO_TRACE(journal), RDB_off(this));
+
+   U_RETURN(true);
 }
 
 // Open a Reliable DataBase
@@ -691,7 +1118,22 @@ bool URDB::open(uint32_t log_size, bool btruncate, bool cdb_brdonly, bool brefer
 
          if (journal.memmap(PROT_READ | PROT_WRITE, U_NULLPTR, 0, journal_sz_new))
             {
-            if (RDB_off(this) == 0) RDB_off(this) = sizeof(URDB::cache_struct);
+            if (RDB_off(this) == 0)
+               {
+               RDB_off(this)   = sizeof(URDB::cache_struct);
+               RDB_magic(this) = RDB_JOURNAL_MAGIC;
+               }
+            else if (RDB_magic(this) != RDB_JOURNAL_MAGIC &&
+                     migrateJournal(journal_sz) == false)
+               {
+               U_WARNING("URDB::open(%u,%b,%b,%b,%p) - the journal %.*S has an unknown format (magic %x)",
+                         log_size, btruncate, cdb_brdonly, breference, psem, U_FILE_TO_TRACE(journal), RDB_magic(this));
+
+               journal.munmap();
+               journal.close();
+
+               U_RETURN(false);
+               }
 
             U_INTERNAL_DUMP("RDB_off = %u RDB_sync = %u capacity = %u nrecord = %u RDB_reference = %u",
                              RDB_off(this), RDB_sync(this), RDB_capacity(this), RDB_nrecord(this), RDB_reference(this))
@@ -884,10 +1326,40 @@ U_NO_EXPORT void URDB::callForEntryNotInCache(UCDB* pcdb, vPFpvpc function2)
 
    char* ptr;
    char* _eof = UFile::map + (ptrdiff_t)UFile::st_size;
-   UCDB::slot = (UCDB::cdb_hash_table_slot*) UCDB::end();
 
    U_cdb_result_call(pcdb) = 1;
 
+   if (UCDB::bcdb64)
+      {
+      for (UCDB::slot64 = (UCDB::cdb64_hash_table_slot*) UCDB::end(); (char*)slot64 < _eof; ++UCDB::slot64)
+         {
+         uint64_t pos = u_get_unaligned64(slot64->pos);
+
+         if (pos)
+            {
+            ptr      = UFile::map + pos;
+            UCDB::hr = (UCDB::cdb_record_header*) ptr;
+
+            UCDB::khash     = u_get_unaligned64(slot64->hash);
+            UCDB::key.dsize = u_get_unaligned32(UCDB::hr->klen);
+            UCDB::key.dptr  = ptr + sizeof(UCDB::cdb_record_header);
+
+            U_INTERNAL_DUMP("key = %.*S khash = %llu", UCDB::key.dsize, UCDB::key.dptr, khash)
+
+            if (htLookup(this) == false) // NB: entry NOT present in the cache...
+               {
+               function2(pcdb, ptr);
+
+               if (U_cdb_result_call(pcdb) == 0) break;
+               }
+            }
+         }
+
+      return;
+      }
+
+   UCDB::slot = (UCDB::cdb_hash_table_slot*) UCDB::end();
+
    while ((char*)slot < _eof)
       {
       uint32_t pos = u_get_unaligned32(slot->pos);
@@ -903,7 +1375,7 @@ U_NO_EXPORT void URDB::callForEntryNotInCache(UCDB* pcdb, vPFpvpc function2)
          UCDB::key.dsize = u_get_unaligned32(UCDB::hr->klen);
          UCDB::key.dptr  = ptr + sizeof(UCDB::cdb_record_header);
 
-         U_INTERNAL_DUMP("key = %.*S khash = %u", UCDB::key.dsize, UCDB::key.dptr, khash)
+         U_INTERNAL_DUMP("key = %.*S khash = %llu", UCDB::key.dsize, UCDB::key.dptr, khash)
 
          if (htLookup(this) == false) // NB: entry NOT present in the cache...
             {
@@ -1084,7 +1556,7 @@ U_NO_EXPORT void URDB::getKeys1(UCDB* pcdb, uint32_t _offset) // entry present i
       }
 }
 
-// Combines the old cdb file and the diffs in a new cdb file
+// Combines the old cdb file and the diffs in a new cdb file (see ONLINE COMPACTION)
 
 bool URDB::reorganize()
 {
@@ -1092,10 +1564,17 @@ bool URDB::reorganize()
 
    U_CHECK_MEMORY
 
-   bool result = true;
+   bool result    = true,
+        blocked   = (_lock.sem && _lock.isLocked()), // NB: the caller (resizeJournal(), beginTransaction()) already hold the lock...
+        bsnapshot = (_lock.sem && blocked == false); // NB: without a semaphore there are no other writers...
+   UTimeVal chronometer, chronometer_lock;
+
+   chronometer.start();
 
    lock();
 
+   chronometer_lock.start();
+
    U_INTERNAL_DUMP("RDB_off = %u", RDB_off(this))
 
    if (RDB_off(this) > sizeof(URDB::cache_struct))
@@ -1104,23 +1583,74 @@ bool URDB::reorganize()
 
       U_INTERNAL_ASSERT_EQUALS(RDB_reference(this), 1)
 
+      UString snapshot;
       UCDB cdb(UCDB::ignoreCase());
-      char cdb_buffer_path[MAX_FILENAME_LEN];
+      char* journal_map = journal.map;
+      off_t journal_size = journal.st_size;
+      char suffix[32], cdb_buffer_path[MAX_FILENAME_LEN];
+
+      // NB: the name of the new database is unique for process, the reorganize() of another process can run meanwhile...
+
+      cdb.setPath(*(const UFile*)this, cdb_buffer_path, suffix, u__snprintf(suffix, sizeof(suffix), U_CONSTANT_TO_PARAM(".%u.tmp"), u_pid));
+
+      // NB: if the new database can go beyond the 4 gigabytes limit we switch to the cdb64 format...
+
+      uint64_t sz = UFile::st_size + journal.st_size + UCDB::sizeFor(4096);
+
+      cdb.bcdb64 = (UCDB::bcdb64 || sz > UINT32_MAX);
+
+      if (cdb.bcdb64) sz = UFile::st_size + journal.st_size + UCDB::sizeFor(UCDB::nrecord + RDB_nrecord(this) + 4096, true);
+
+      U_INTERNAL_DUMP("sz = %llu cdb.bcdb64 = %b", sz, cdb.bcdb64)
 
-      cdb.setPath(*(const UFile*)this, cdb_buffer_path, U_CONSTANT_TO_PARAM(".tmp"));
+      // 1) snapshot
+
+      uint32_t off_snapshot = RDB_off(this),
+               generation   = RDB_generation(this);
+      ino_t inode           = getInode(UFile::path_relativ);
+      long time_lock        = 0L;
+
+      if (bsnapshot)
+         {
+         time_lock = chronometer_lock.stop();
+
+         unlock();
+
+         uint32_t generation_snapshot;
+
+         if (getSnapshot(snapshot, off_snapshot, generation_snapshot) == false ||
+             generation_snapshot != generation) // NB: if another process have reorganized the database meanwhile we fail at the swap...
+            {
+            lock(); // NB: the journal is changed at every try without the lock...
+
+            chronometer_lock.start();
+
+            off_snapshot = RDB_off(this);
+            snapshot     = UString((const void*)journal.map, off_snapshot);
+
+            time_lock += chronometer_lock.stop();
+
+            unlock();
+            }
+
+         setSnapshot(snapshot.data(), off_snapshot);
+         }
+
+      // 2) the new cdb from the snapshot
+
+      uint64_t pos = 0;
 
       result = cdb.creat(O_RDWR) &&
-               cdb.ftruncate(UFile::st_size + journal.st_size + UCDB::sizeFor(4096));
+               cdb.ftruncate(sz)  &&
+               cdb.memmap(PROT_READ | PROT_WRITE);
 
       if (result)
          {
-         if (cdb.memmap(PROT_READ | PROT_WRITE) == false) U_RETURN(false);
-
          cdb.makeStart();
 
          U_FOR_EACH_ENTRY(&cdb, makeAdd1, UCDB::makeAdd2)
 
-         uint32_t pos = cdb.makeFinish(false);
+         pos = cdb.makeFinish(false);
 
          U_INTERNAL_ASSERT(pos <= cdb.st_size)
 
@@ -1128,7 +1658,44 @@ bool URDB::reorganize()
          cdb.munmap(); // for ftruncate()...
 #     endif
 
-         if (cdb.ftruncate(pos) == false) U_RETURN(false);
+         result = cdb.ftruncate(pos);
+         }
+
+      journal.map     = journal_map;
+      journal.st_size = journal_size;
+
+      // 3) delta and swap
+
+      uint32_t off_delta = 0;
+      UString delta(U_CAPACITY);
+
+      if (bsnapshot)
+         {
+         if (result) off_delta = getDeltaWithoutLock(snapshot.data(), off_snapshot, generation, delta);
+
+         lock();
+
+         chronometer_lock.start();
+         }
+
+      if (result &&
+          (generation != RDB_generation(this) ||
+           inode      != getInode(UFile::path_relativ))) // NB: check if another process have reorganized the database meanwhile...
+         {
+         result = false;
+
+         U_WARNING("URDB::reorganize() - the database %.*S was reorganized (or the journal rolled back) meanwhile by another process", U_FILE_TO_TRACE(*this));
+         }
+
+      if (result)
+         {
+         if (bsnapshot &&
+             off_delta != RDB_off(this)) // NB: the journal is changed after the copy for the delta...
+            {
+            delta.setEmpty();
+
+            getDelta(snapshot.data(), off_snapshot, delta);
+            }
 
 #     if defined(_MSWINDOWS_) || defined(__CYGWIN__)
          UFile::munmap(); // for rename()...
@@ -1137,30 +1704,60 @@ bool URDB::reorganize()
 #       endif
 #     endif
 
-         if (cdb._rename(UFile::path_relativ) == false) U_RETURN(false);
+         result = cdb._rename(UFile::path_relativ);
 
-         reset();
+         if (result)
+            {
+            uint64_t size_before = UFile::st_size + RDB_off(this);
 
-#     if defined(_MSWINDOWS_) || defined(__CYGWIN__)
-#       ifdef   _MSWINDOWS_
-         result = cdb.UFile::open(UFile::path_relativ);
-                  cdb.st_size = pos;
-#       endif
-         result = cdb.memmap(); // read only...
-#     endif
+            // NB: the generation change before the reset, so a copy of the journal without the lock see it (see ONLINE COMPACTION)...
 
-         cdb.UFile::close();
+            (void) __atomic_add_fetch(&RDB_generation(this), 1, __ATOMIC_SEQ_CST);
 
-         UFile::substitute(cdb);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-         UCDB::nrecord               = cdb.nrecord;
-         UCDB::start_hash_table_slot = cdb.start_hash_table_slot;
+            reset();
 
-         U_INTERNAL_DUMP("UCDB::nrecord = %u RDB_nrecord = %u", UCDB::nrecord, RDB_nrecord(this))
+#        if defined(_MSWINDOWS_) || defined(__CYGWIN__)
+#          ifdef   _MSWINDOWS_
+            result = cdb.UFile::open(UFile::path_relativ);
+                     cdb.st_size = pos;
+#          endif
+            result = cdb.memmap(); // read only...
+#        endif
+
+            cdb.UFile::close();
+
+            UFile::substitute(cdb);
+
+            UCDB::bcdb64                = cdb.bcdb64;
+            UCDB::nrecord               = cdb.nrecord;
+            UCDB::start_hash_table_slot = cdb.start_hash_table_slot;
+
+            // NB: the entries changed after the snapshot go in the journal of the new database...
+
+            applyDelta(delta);
+
+            U_INTERNAL_DUMP("UCDB::nrecord = %u RDB_nrecord = %u", UCDB::nrecord, RDB_nrecord(this))
+
+            compaction_time += chronometer.stop();
+
+            setStats(time_lock + chronometer_lock.stop(), size_before, UFile::st_size + RDB_off(this));
+            }
+         }
+
+      if (result == false &&
+          cdb.isOpen())
+         {
+         if (cdb.isMapped()) cdb.munmap();
+
+         cdb.UFile::close();
+
+         (void) cdb._unlink();
          }
       }
 
-   unlock();
+   if (blocked == false) unlock();
 
    U_RETURN(result);
 }
@@ -1605,27 +2202,19 @@ int URDB::store(int _flag)
 // -3: there is not enough (virtual) memory available on writing journal
 // ----------------------------------------------------------------------
 
-int URDB::remove()
+int URDB::_remove()
 {
-   U_TRACE_NO_PARAM(0, "URDB::remove()")
+   U_TRACE_NO_PARAM(0, "URDB::_remove()")
 
-   int result = 0;
    bool record_cache_deleted = false;
 
-   lock();
-
    UCDB::cdb_hash();
 
    // NB: Because the insertion routine has to know where to insert the cache_node, we need to call anyway htLookup()...  
 
    if (htLookup(this)) // Search one key/data pair in the cache
       {
-      if (isDeleted())
-         {
-         result = -2; // -2: The entry was already marked deleted in the cache
-
-         goto end;
-         }
+      if (isDeleted()) U_RETURN(-2); // -2: The entry was already marked deleted in the cache
 
       record_cache_deleted = true;
       }
@@ -1633,24 +2222,16 @@ int URDB::remove()
       {
       // Search one key/data pair in the cdb
 
-      if (cdbLookup()) htAlloc(this);
-      else
-         {
-         result = -1; // -1: The entry was not in the database
+      if (cdbLookup() == false) U_RETURN(-1); // -1: The entry was not in the database
 
-         goto end;
-         }
+      htAlloc(this);
       }
 
-   U_INTERNAL_ASSERT_EQUALS(result, 0)
-
    if (logJournal(0) == false)
       {
-      result = -3; // -3: there is not enough (virtual) memory available on writing journal
-
       htRemoveAlloc(this);
 
-      goto end;
+      U_RETURN(-3); // -3: there is not enough (virtual) memory available on writing journal
       }
 
    // NB: the reference at memory in the cache data must point to memory mapped...
@@ -1664,7 +2245,17 @@ int URDB::remove()
 
    U_INTERNAL_DUMP("nrecord = %u", RDB_nrecord(this))
 
-end:
+   U_RETURN(0);
+}
+
+int URDB::remove()
+{
+   U_TRACE_NO_PARAM(0, "URDB::remove()")
+
+   lock();
+
+   int result = _remove();
+
    unlock();
 
    U_RETURN(result);
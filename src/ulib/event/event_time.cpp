@@ -28,6 +28,8 @@ UEventTime::UEventTime(long sec, long micro_sec) : UTimeVal(sec, micro_sec)
 
    setTolerance();
 
+   ptimer = U_NULLPTR;
+
    xtime.tv_sec =
    xtime.tv_usec = 0L;
 
@@ -266,6 +266,130 @@ private:
    U_DISALLOW_COPY_AND_ASSIGN(UStackMemoryPool)
 };
 
+#if defined(ENABLE_MEMPOOL) && defined(ENABLE_THREAD)
+// ---------------------------------------------------------------------------------------------------------------------------
+// PER-THREAD MAGAZINES: every thread keep for every 'type' stack a small array of free blocks (the magazine) and pop()/push()
+// work on it without any lock. Only when the magazine is empty (pop) or full (push) we take the lock of the global stacks and
+// we move U_MAGAZINE_BATCH blocks at once (refill/drain). When a thread exit we drain all its magazines, and from now the thread
+// (Ex: the destructors of the other thread specific data) use directly the global stacks...
+// ---------------------------------------------------------------------------------------------------------------------------
+// NB: the stack 0 is not managed by the magazines, its blocks are never freed (see UMemoryPool::push())...
+// ---------------------------------------------------------------------------------------------------------------------------
+
+#include <pthread.h>
+
+#define U_MAGAZINE_SIZE  32
+#define U_MAGAZINE_BATCH (U_MAGAZINE_SIZE / 2)
+
+typedef struct umagazine {
+   void* block[U_MAGAZINE_SIZE];
+   uint32_t len;
+} umagazine;
+
+uint64_t UMemoryPool::magazine_drain;
+uint64_t UMemoryPool::magazine_refill;
+uint64_t UMemoryPool::magazine_excess_free;
+
+static pthread_key_t   magazine_key;
+static pthread_once_t  magazine_once  = PTHREAD_ONCE_INIT;
+static pthread_mutex_t magazine_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread umagazine magazine[U_NUM_STACK_TYPE];
+static __thread bool      magazine_init, magazine_locked, magazine_flushed; // NB: magazine_locked avoid the recursion on the lock (allocateMemoryBlocks() can call pop() of another stack)...
+static __thread int64_t   magazine_balance, magazine_excess; // NB: free - alloc of the thread, and its max value already counted in magazine_excess_free...
+
+static void lockMagazine()
+{
+   U_INTERNAL_ASSERT_EQUALS(magazine_locked, false)
+
+   (void) pthread_mutex_lock(&magazine_mutex);
+
+   magazine_locked = true;
+}
+
+static void unlockMagazine()
+{
+   U_INTERNAL_ASSERT(magazine_locked)
+
+   magazine_locked = false;
+
+   (void) pthread_mutex_unlock(&magazine_mutex);
+}
+
+static void drainMagazine(umagazine* pmagazine, int stack_index, uint32_t n) // NB: it must be called with the lock held...
+{
+   U_INTERNAL_ASSERT(magazine_locked)
+   U_INTERNAL_ASSERT(n <= pmagazine->len)
+
+   UStackMemoryPool* pstack = (UStackMemoryPool*)(UStackMemoryPool::mem_stack+stack_index);
+
+   while (n--) pstack->push(pmagazine->block[--pmagazine->len]);
+
+   ++UMemoryPool::magazine_drain;
+
+   // NB: a block doesn't record the thread that allocated it, so we cannot count the frees of another thread. We count only the blocks that a thread
+   //     free beyond the ones it allocated: they come from the other threads (producer/consumer), but a block freed by another thread and balanced by
+   //     an allocation of the thread is not counted...
+
+   if (magazine_balance > magazine_excess)
+      {
+      UMemoryPool::magazine_excess_free += (magazine_balance - magazine_excess);
+
+      magazine_excess = magazine_balance;
+      }
+}
+
+static void flushMagazine(void* ptr) // NB: called at thread exit...
+{
+   umagazine* pmagazine = (umagazine*)ptr;
+
+   lockMagazine();
+
+   for (int stack_index = 1; stack_index < U_NUM_STACK_TYPE; ++stack_index)
+      {
+      if (pmagazine[stack_index].len) drainMagazine(pmagazine+stack_index, stack_index, pmagazine[stack_index].len);
+      }
+
+   magazine_flushed = true; // NB: a block that go in the magazine after this point would be leaked...
+
+   unlockMagazine();
+}
+
+// NB: fork() must not happen while another thread hold the lock of the global stacks, so we take it before the fork()
+//     and we release it after in the parent. In the child only the thread that called fork() exist, so we reinit it...
+
+static void prepareForkMagazine() { lockMagazine(); }
+static void  parentForkMagazine() { unlockMagazine(); }
+
+static void childForkMagazine()
+{
+   (void) pthread_mutex_init(&magazine_mutex, U_NULLPTR);
+
+   magazine_locked = false;
+}
+
+static void initMagazine()
+{
+   (void) pthread_key_create(&magazine_key, flushMagazine);
+   (void) pthread_atfork(prepareForkMagazine, parentForkMagazine, childForkMagazine);
+}
+
+static umagazine* getMagazine(int stack_index) // NB: U_NULLPTR after the thread exit (see flushMagazine())...
+{
+   if (magazine_flushed) return U_NULLPTR;
+
+   if (magazine_init == false)
+      {
+      magazine_init = true;
+
+      (void) pthread_once(&magazine_once, initMagazine);
+      (void) pthread_setspecific(magazine_key, magazine);
+      }
+
+   return magazine+stack_index;
+}
+#endif
+
 #ifdef ENABLE_MEMPOOL
 void UMemoryPool::allocateMemoryBlocks(int stack_index, uint32_t n)
 {
@@ -282,7 +406,17 @@ void UMemoryPool::allocateMemoryBlocks(int stack_index, uint32_t n)
                         pstack->pop_cnt, pstack->push_cnt,
                         pstack->num_call_allocateMemoryBlocks);
 
+#ifdef ENABLE_THREAD
+   bool block = (magazine_locked == false);
+
+   if (block) lockMagazine();
+#endif
+
    if (n > pstack->len) pstack->allocateMemoryBlocks(n);
+
+#ifdef ENABLE_THREAD
+   if (block) unlockMagazine();
+#endif
 }
 
 void UMemoryPool::allocateMemoryBlocks(const char* ptr)
@@ -369,7 +503,53 @@ void UMemoryPool::push(void* ptr, int stack_index)
    U_INTERNAL_ASSERT_POINTER(ptr)
    U_INTERNAL_ASSERT_MINOR(stack_index, U_NUM_STACK_TYPE) // 10
 
-   if (stack_index) ((UStackMemoryPool*)(UStackMemoryPool::mem_stack+stack_index))->push(ptr);
+   if (stack_index == 0) return;
+
+#ifndef ENABLE_THREAD
+   ((UStackMemoryPool*)(UStackMemoryPool::mem_stack+stack_index))->push(ptr);
+#else
+   umagazine* pmagazine;
+
+   if (magazine_locked ||
+       (pmagazine = getMagazine(stack_index)) == U_NULLPTR)
+      {
+      bool block = (magazine_locked == false);
+
+      if (block) lockMagazine();
+
+      ((UStackMemoryPool*)(UStackMemoryPool::mem_stack+stack_index))->push(ptr);
+
+      if (block) unlockMagazine();
+
+      return;
+      }
+
+#ifdef DEBUG
+   if (ptr < &UStackMemoryPool::mem_block[0] ||
+       ptr > &UStackMemoryPool::mem_block[U_SIZE_MEM_BLOCK])
+      {
+      (void) memset(ptr, 0, U_STACK_INDEX_TO_SIZE[stack_index]); // NB: in debug mode the memory area is zeroed to enhance showing bugs...
+      }
+
+   for (uint32_t i = 0; i < pmagazine->len; ++i)
+      {
+      if (ptr == pmagazine->block[i]) U_ERROR("Duplicate entry on magazine of UMemoryPool::push(%p): index = %u len = %u i = %u", ptr, stack_index, pmagazine->len, i);
+      }
+#endif
+
+   if (pmagazine->len == U_MAGAZINE_SIZE)
+      {
+      lockMagazine();
+
+      drainMagazine(pmagazine, stack_index, U_MAGAZINE_BATCH);
+
+      unlockMagazine();
+      }
+
+   pmagazine->block[pmagazine->len++] = ptr;
+
+   ++magazine_balance;
+#endif
 }
 
 void UMemoryPool::_free(void* ptr, uint32_t num, uint32_t type_size)
@@ -396,6 +576,25 @@ void* UMemoryPool::pop(int stack_index)
 
    UStackMemoryPool* pstack = (UStackMemoryPool*)(UStackMemoryPool::mem_stack+stack_index);
 
+#ifdef ENABLE_THREAD
+   umagazine* pmagazine = U_NULLPTR;
+   bool block = (magazine_locked == false);
+
+   if (block)
+      {
+      if (stack_index &&
+          (pmagazine = getMagazine(stack_index)) &&
+          pmagazine->len)
+         {
+         --magazine_balance;
+
+         return pmagazine->block[--pmagazine->len];
+         }
+
+      lockMagazine();
+      }
+#endif
+
 #ifdef DEBUG
    if (pstack->index &&
        pstack->len == 0)
@@ -405,13 +604,26 @@ void* UMemoryPool::pop(int stack_index)
                   obj_class, func_call, pstack->index, pstack->type, pstack->len, pstack->space, pstack->depth,
                   pstack->max_depth, pstack->num_call_allocateMemoryBlocks, pstack->pop_cnt, pstack->push_cnt);
       }
+#endif
 
    void* ptr = pstack->pop();
 
-   U_RETURN(ptr);
-#else
-   return pstack->pop();
+#ifdef ENABLE_THREAD
+   if (pmagazine) // refill
+      {
+      U_INTERNAL_ASSERT_EQUALS(pmagazine->len, 0)
+
+      while (pmagazine->len < U_MAGAZINE_BATCH) pmagazine->block[pmagazine->len++] = pstack->pop();
+
+      ++magazine_refill;
+
+      --magazine_balance;
+      }
+
+   if (block) unlockMagazine();
 #endif
+
+   U_RETURN(ptr);
 }
 
 #  ifdef DEBUG
@@ -681,6 +893,15 @@ void UMemoryPool::printInfo(ostream& os)
    U_TRACE(0+256, "UMemoryPool::printInfo(%p)", &os)
 
    UStackMemoryPool::paint(os);
+
+#if defined(ENABLE_MEMPOOL) && defined(ENABLE_THREAD)
+   char buffer[256];
+
+   (void) snprintf(buffer, U_CONSTANT_SIZE(buffer), "magazine: size = %u batch = %u refill = %llu drain = %llu excess_free = %llu\n",
+                   U_MAGAZINE_SIZE, U_MAGAZINE_BATCH, (unsigned long long)magazine_refill, (unsigned long long)magazine_drain, (unsigned long long)magazine_excess_free);
+
+   os << buffer;
+#endif
 }
 
 void UMemoryPool::writeInfoTo(const char* format, uint32_t fmt_size, ...)
@@ -15,6 +15,14 @@
 #include <ulib/json/value.h>
 #include <ulib/utility/escape.h>
 
+#include <new>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
 int                       UValue::pos;
 int                       UValue::jsonParseFlags;
 char*                     UValue::pstringify;
@@ -22,6 +30,8 @@ uint32_t                  UValue::size_output;
 UValue::jval              UValue::o;
 UFlatBuffer*              UValue::pfb;
 UValue::parser_stack_data UValue::sd[U_JSON_PARSE_STACK_SIZE];
+UValueArena*              UValue::arena;
+UValueArena*              UValue::request_arena;
 
 #ifdef DEBUG
 uint32_t UValue::cnt_real;
@@ -34,10 +44,116 @@ enum jsonParseFlagsType {
    FULL_PRECISION = 0x0004
 };
 
+UValueArena::~UValueArena()
+{
+   U_TRACE_DTOR(0, UValueArena)
+
+   while (head)
+      {
+      block* b = head;
+                 head = b->next;
+
+      UMemoryPool::_free(b, b->size, 1);
+      }
+}
+
+void UValueArena::grow(uint32_t sz)
+{
+   U_TRACE(0, "UValueArena::grow(%u)", sz)
+
+   // NB: the size of the blocks grows geometrically, so a big document need few blocks...
+
+   uint32_t n = U_max(block_size << U_min(num_block, 8U), sz + (uint32_t)sizeof(block));
+
+   block* b = (block*) UMemoryPool::cmalloc(n, 1, false);
+
+   b->next = head;
+   b->size = n;
+             head = b;
+
+   ++num_block;
+
+   ptr = (char*)b + sizeof(block);
+   end = (char*)b + n;
+
+   U_INTERNAL_DUMP("num_block = %u n = %u", num_block, n)
+}
+
+void UValueArena::reset()
+{
+   U_TRACE_NO_PARAM(0, "UValueArena::reset()")
+
+   if (head)
+      {
+      block* b = head->next;
+
+      while (b)
+         {
+         block* bnext = b->next;
+
+         UMemoryPool::_free(b, b->size, 1);
+
+         b = bnext;
+         }
+
+      head->next = U_NULLPTR;
+      num_block  = 1;
+
+      ptr = (char*)head + sizeof(block);
+      end = (char*)head + head->size;
+      }
+}
+
+__pure bool UValueArena::owns(const void* p) const
+{
+   U_TRACE(0, "UValueArena::owns(%p)", p)
+
+   for (block* b = head; b; b = b->next)
+      {
+      if ((const char*)p >= (const char*)b &&
+          (const char*)p <  (const char*)b + b->size)
+         {
+         U_RETURN(true);
+         }
+      }
+
+   U_RETURN(false);
+}
+
+UValue* UValue::newNode(uint64_t value, UValue* node)
+{
+   U_TRACE(0, "UValue::newNode(%#llx,%p)", value, node)
+
+   U_INTERNAL_ASSERT_POINTER(arena)
+
+   void* p = arena->allocate(sizeof(UValue));
+
+   UValue* element = (node ? ::new(p) UValue(value, node) : ::new(p) UValue(value));
+
+   element->parena = arena;
+
+   U_RETURN_POINTER(element, UValue);
+}
+
+UStringRep* UValue::newStringRep(const char* ptr, uint32_t sz)
+{
+   U_TRACE(0, "UValue::newStringRep(%.*S,%u)", sz, ptr, sz)
+
+   U_INTERNAL_ASSERT_POINTER(arena)
+
+   UStringRep* rep = ::new(arena->allocate(sizeof(UStringRep))) UStringRep(ptr, sz);
+
+   U_RETURN_POINTER(rep, UStringRep);
+}
+
 UValue::~UValue()
 {
    U_TRACE_DTOR(0, UValue)
 
+   U_INTERNAL_DUMP("parena = %p", parena)
+
+   if (parena) return; // NB: the nodes and the strings of the arena are released with the arena...
+
    switch (getTag())
       {
       case U_STRING_VALUE:
@@ -116,6 +232,15 @@ void UValue::clear()
 
    U_DUMP("dispatch_table[(%u,%S)] = %d", type, getDataTypeDescription(type), dispatch_table[type])
 
+   U_INTERNAL_DUMP("parena = %p", parena)
+
+   if (parena) // NB: the nodes and the strings of the arena are released with the arena...
+      {
+      parena = U_NULLPTR;
+
+      goto case_double;
+      }
+
    goto *((char*)&&case_double + dispatch_table[type]);
 
 case_double:
@@ -250,7 +375,8 @@ uint32_t UValue::getMemberNames(UVector<UString>& members) const
 
          U_INTERNAL_DUMP("element->pkey(%p) = %V", rep, rep)
 
-         members.push_back(rep);
+         if (parena) members.push_back(UString(U_STRING_TO_PARAM(*rep))); // NB: the key go out of the tree, so we need a copy...
+         else              members.push_back(rep);
 
          element = element->next;
          }
@@ -263,6 +389,23 @@ uint32_t UValue::getMemberNames(UVector<UString>& members) const
    U_RETURN(0);
 }
 
+UString UValue::getString()
+{
+   U_TRACE_NO_PARAM(0, "UValue::getString()")
+
+   if (parena &&
+       getTag() == U_STRING_VALUE) // NB: the string go out of the tree, so we need a copy...
+      {
+      UStringRep* rep = (UStringRep*)getPayload();
+
+      UString str(U_STRING_TO_PARAM(*rep));
+
+      U_RETURN_STRING(str);
+      }
+
+   return getString(value.ival);
+}
+
 UString UValue::getString(uint64_t value)
 {
    U_TRACE(0, "UValue::getString(%#llx)", value)
@@ -1259,7 +1402,20 @@ dquote_assign:
          {
          U_DUMP("type = (%u,%S)", type, getDataTypeDescription(type))
 
-         if ((jsonParseFlags & STRING_COPY) == 0)
+         if (arena)
+            {
+            if (jsonParseFlags & STRING_COPY)
+               {
+               char* ptr = (char*) arena->allocate(sz);
+
+               U_MEMCPY(ptr, start, sz);
+
+               start = ptr;
+               }
+
+            setValue(type, newStringRep(start, sz));
+            }
+         else if ((jsonParseFlags & STRING_COPY) == 0)
             {
             U_NEW(UStringRep, rep, UStringRep(start, sz));
 
@@ -1276,7 +1432,7 @@ dquote_assign:
          }
       else
          {
-         UStringRep::string_rep_null->hold();
+         if (arena == U_NULLPTR) UStringRep::string_rep_null->hold();
 
          setValue(U_STRING_VALUE, UStringRep::string_rep_null);
          }
@@ -1736,6 +1892,7 @@ next: U_INTERNAL_DUMP("next: comma = %b pos = %d colon = %b separator = %b s = %
       if (pos == -1)
          {
          value.ival = o.ival;
+         parena     = arena;
 
          while (u__isspace(*s)) ++s;
 
@@ -1783,13 +1940,16 @@ cdefault:
 
    if (pos >= 0)
       {
+      parena = arena; // NB: the partial tree is released as the tree of the document...
+
       if (sd[0].obj == false) value.ival = (sd[0].tails ? listToValue(U_ARRAY_VALUE, sd[0].tails) : o.ival);
       else
          {
          if (sd[0].tails) value.ival = listToValue(U_OBJECT_VALUE, sd[0].tails);
          else
             {
-            if (sd[0].keys &&
+            if (arena == U_NULLPTR &&
+                sd[0].keys &&
                 isStringOrUTF(sd[0].keys))
                {
                rep = (UStringRep*)u_getPayload(sd[0].keys);
@@ -2731,7 +2891,538 @@ void UValue::consumeFieldsAndValues(const UString& json, std::function<void(cons
       }
 }
 #endif
-   
+
+// On-demand JSON
+
+UJsonOnDemand::~UJsonOnDemand()
+{
+   U_TRACE_DTOR(0, UJsonOnDemand)
+
+   if (vpos) UMemoryPool::_free(vpos, capacity * 2, sizeof(uint32_t));
+}
+
+// STAGE 1: classify a block of 64 bytes (bitmask of the quotes, of the backslashes, of the structural characters and of the whitespaces)
+
+static inline void u_json_classify(const char* p, uint64_t& quote, uint64_t& bslash, uint64_t& op, uint64_t& ws)
+{
+   quote = bslash = op = ws = 0ULL;
+
+#if defined(__AVX2__)
+   for (uint32_t k = 0; k < 64; k += 32)
+      {
+      __m256i v   = _mm256_loadu_si256((const __m256i*)(p+k)),
+              v20 = _mm256_or_si256(v, _mm256_set1_epi8(0x20)); // NB: '[' | 0x20 == '{' and ']' | 0x20 == '}'...
+
+      quote  |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')))  << k;
+      bslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << k;
+
+      op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v20, _mm256_set1_epi8('{')),
+                                                                                     _mm256_cmpeq_epi8(v20, _mm256_set1_epi8('}'))),
+                                                                     _mm256_or_si256(_mm256_cmpeq_epi8(v,   _mm256_set1_epi8(':')),
+                                                                                     _mm256_cmpeq_epi8(v,   _mm256_set1_epi8(','))))) << k;
+
+      ws |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                                                                     _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                                                                                     _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))))) << k;
+      }
+#elif defined(__SSE2__)
+   for (uint32_t k = 0; k < 64; k += 16)
+      {
+      __m128i v   = _mm_loadu_si128((const __m128i*)(p+k)),
+              v20 = _mm_or_si128(v, _mm_set1_epi8(0x20)); // NB: '[' | 0x20 == '{' and ']' | 0x20 == '}'...
+
+      quote  |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')))  << k;
+      bslash |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << k;
+
+      op |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v20, _mm_set1_epi8('{')),
+                                                                            _mm_cmpeq_epi8(v20, _mm_set1_epi8('}'))),
+                                                               _mm_or_si128(_mm_cmpeq_epi8(v,   _mm_set1_epi8(':')),
+                                                                            _mm_cmpeq_epi8(v,   _mm_set1_epi8(','))))) << k;
+
+      ws |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                                                            _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                                               _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                                                                            _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))))) << k;
+      }
+#else
+   for (uint32_t k = 0; k < 64; ++k)
+      {
+      switch (p[k])
+         {
+         case '"':  quote  |= 1ULL << k; break;
+         case '\\': bslash |= 1ULL << k; break;
+
+         case '{': case '}': case '[': case ']': case ':': case ',': op |= 1ULL << k; break;
+
+         case ' ': case '\t': case '\n': case '\r': ws |= 1ULL << k; break;
+         }
+      }
+#endif
+}
+
+bool UJsonOnDemand::parse(const UString& json)
+{
+   U_TRACE(0, "UJsonOnDemand::parse(%V)", json.rep)
+
+   clear();
+
+   uint32_t len = json.size();
+
+   if (len == 0) U_RETURN(false);
+
+   // NB: every byte of the document can be at most one entry of the index...
+
+   if (capacity <= len)
+      {
+      if (vpos) UMemoryPool::_free(vpos, capacity * 2, sizeof(uint32_t));
+
+      capacity = len + 1;
+
+      vpos   = (uint32_t*) UMemoryPool::cmalloc(capacity * 2, sizeof(uint32_t));
+      vmatch = vpos + capacity;
+      }
+
+   char block[64];
+   const char* p;
+   const char* ptr = json.data();
+   uint32_t i = 0, n = 0, bit;
+   uint64_t quote, bslash, op, ws, escaped, in_string, scalar, mask, prev_escaped = 0ULL, prev_in_string = 0ULL, prev_scalar = 0ULL;
+
+   while (i < len)
+      {
+      p = ptr + i;
+
+      if ((len - i) < 64)
+         {
+         // NB: the last block is padded with whitespaces...
+
+         (void) U_SYSCALL(memset, "%p,%d,%u", block, ' ', 64);
+
+         U_MEMCPY(block, p, len - i);
+
+         p = block;
+         }
+
+      u_json_classify(p, quote, bslash, op, ws);
+
+      // the characters escaped by a backslash (they are rare, so we resolve them one by one)
+
+      escaped      = prev_escaped;
+      prev_escaped = 0ULL;
+
+      for (mask = bslash & ~escaped; mask; mask &= ~(3ULL << bit))
+         {
+         bit = __builtin_ctzll(mask);
+
+         if (bit == 63)
+            {
+            prev_escaped = 1ULL;
+
+            break;
+            }
+
+         escaped |= 2ULL << bit;
+         }
+
+      quote &= ~escaped;
+
+      // the prefix xor of the quotes mark the bytes inside the strings (the opening quote included)
+
+      in_string  = quote;
+      in_string ^= in_string <<  1;
+      in_string ^= in_string <<  2;
+      in_string ^= in_string <<  4;
+      in_string ^= in_string <<  8;
+      in_string ^= in_string << 16;
+      in_string ^= in_string << 32;
+      in_string ^= prev_in_string;
+
+      prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+
+      // the pseudo-structural characters: the first byte of the scalar values (number, true, false, null)
+
+      op    &= ~in_string;
+      scalar = ~(op | quote | ws | in_string);
+
+      mask        = op | quote | (scalar & ~((scalar << 1) | prev_scalar));
+      prev_scalar = scalar >> 63;
+
+      for (; mask; mask &= mask-1) vpos[n++] = i + __builtin_ctzll(mask);
+
+      i += 64;
+      }
+
+   U_INTERNAL_DUMP("n = %u prev_in_string = %llu", n, prev_in_string)
+
+   if (n == 0 ||
+       prev_in_string) // NB: the last string is not terminated...
+      {
+      U_RETURN(false);
+      }
+
+   // for every container the position in the index of its closing bracket (NB: vmatch is used also as stack of the open containers)
+
+   char c;
+   uint32_t next, top = U_NOT_FOUND;
+
+   for (i = 0; i < n; ++i)
+      {
+      c = ptr[vpos[i]];
+
+      if (c == '{' ||
+          c == '[')
+         {
+         vmatch[i] = top;
+                top = i;
+         }
+      else if (c == '}' ||
+               c == ']')
+         {
+         if (top == U_NOT_FOUND ||
+             ptr[vpos[top]] != (c - 2)) // NB: '{' + 2 == '}' and '[' + 2 == ']'...
+            {
+            U_RETURN(false);
+            }
+
+         next        = vmatch[top];
+         vmatch[top] = i;
+                 top = next;
+         }
+      }
+
+   if (top != U_NOT_FOUND) U_RETURN(false);
+
+   num      = n;
+   document = json;
+
+   U_RETURN(true);
+}
+
+// STAGE 2
+
+int UJsonOnDemand::getType(uint32_t i) const
+{
+   U_TRACE(0, "UJsonOnDemand::getType(%u)", i)
+
+   if (i < num)
+      {
+      switch (getChar(i))
+         {
+         case '{': U_RETURN(U_OBJECT_VALUE);
+         case '[': U_RETURN(U_ARRAY_VALUE);
+         case '"': U_RETURN(U_STRING_VALUE);
+         case 't': U_RETURN(U_TRUE_VALUE);
+         case 'f': U_RETURN(U_FALSE_VALUE);
+         case 'n': U_RETURN(U_NULL_VALUE);
+
+         case '-': case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9': U_RETURN(U_REAL_VALUE);
+         }
+      }
+
+   U_RETURN(-1);
+}
+
+uint32_t UJsonOnDemand::skip(uint32_t i) const
+{
+   U_TRACE(0, "UJsonOnDemand::skip(%u)", i)
+
+   U_INTERNAL_ASSERT_MINOR(i, num)
+
+   const char* ptr = document.data();
+
+   char c = ptr[vpos[i]];
+
+   if (c == '"') U_RETURN(i+2); // the closing quote
+
+   if (c != '{' &&
+       c != '[')
+      {
+      U_RETURN(i+1);
+      }
+
+   // NB: the content of the container is skipped without to look at the bytes of the values...
+
+   U_RETURN(vmatch[i]+1);
+}
+
+uint32_t UJsonOnDemand::getFirst(uint32_t i) const
+{
+   U_TRACE(0, "UJsonOnDemand::getFirst(%u)", i)
+
+   if ((i+1) < num)
+      {
+      char c = getChar(i);
+
+      if (c == '{' ||
+          c == '[')
+         {
+         c = getChar(++i);
+
+         if (c != '}' &&
+             c != ']')
+            {
+            U_RETURN(i);
+            }
+         }
+      }
+
+   U_RETURN(U_NOT_FOUND);
+}
+
+uint32_t UJsonOnDemand::getNext(uint32_t j) const
+{
+   U_TRACE(0, "UJsonOnDemand::getNext(%u)", j)
+
+   U_INTERNAL_ASSERT_MINOR(j, num)
+
+   uint32_t k = skip(isMember(j) ? getMemberValue(j) : j);
+
+   if ((k+1) < num &&
+       getChar(k) == ',')
+      {
+      U_RETURN(k+1);
+      }
+
+   U_RETURN(U_NOT_FOUND);
+}
+
+uint32_t UJsonOnDemand::getNumElement(uint32_t i) const
+{
+   U_TRACE(0, "UJsonOnDemand::getNumElement(%u)", i)
+
+   int type = getType(i);
+
+   if (type != U_OBJECT_VALUE &&
+       type != U_ARRAY_VALUE)
+      {
+      U_RETURN(type == -1 ? 0 : 1);
+      }
+
+   uint32_t n = 0;
+
+   for (uint32_t j = getFirst(i); j != U_NOT_FOUND; j = getNext(j)) ++n;
+
+   U_RETURN(n);
+}
+
+uint32_t UJsonOnDemand::at(uint32_t i, uint32_t index) const
+{
+   U_TRACE(0, "UJsonOnDemand::at(%u,%u)", i, index)
+
+   uint32_t j = getFirst(i);
+
+   while (j != U_NOT_FOUND &&
+          index--)
+      {
+      j = getNext(j);
+      }
+
+   U_RETURN(j);
+}
+
+uint32_t UJsonOnDemand::findKey(uint32_t i, const char* key, uint32_t key_len) const
+{
+   U_TRACE(0, "UJsonOnDemand::findKey(%u,%.*S,%u)", i, key_len, key, key_len)
+
+   if (getType(i) == U_OBJECT_VALUE)
+      {
+      const char* ptr = document.data();
+
+      for (uint32_t j = getFirst(i); j != U_NOT_FOUND && isMember(j); j = getNext(j))
+         {
+         if ((vpos[j+1] - vpos[j] - 1) == key_len &&
+             memcmp(ptr + vpos[j] + 1, key, key_len) == 0)
+            {
+            U_RETURN(getMemberValue(j));
+            }
+         }
+      }
+
+   U_RETURN(U_NOT_FOUND);
+}
+
+UString UJsonOnDemand::getValue(uint32_t i) const
+{
+   U_TRACE(0, "UJsonOnDemand::getValue(%u)", i)
+
+   if (i >= num) return UString::getStringNull(); // NB: it can be U_NOT_FOUND...
+
+   const char* ptr = document.data();
+
+   uint32_t end, start = vpos[i];
+
+   char c = ptr[start];
+
+   if (c == '"')
+      {
+      ++start;
+
+      end = vpos[i+1];
+      }
+   else if (c == '{' ||
+            c == '[')
+      {
+      end = vpos[vmatch[i]] + 1;
+      }
+   else
+      {
+      end = ((i+1) < num ? vpos[i+1] : document.size());
+
+      while (end > start &&
+             u__isspace(ptr[end-1]))
+         {
+         --end;
+         }
+      }
+
+   UString result = document.substr(start, end - start);
+
+   U_RETURN_STRING(result);
+}
+
+UString UJsonOnDemand::getString(uint32_t i) const
+{
+   U_TRACE(0, "UJsonOnDemand::getString(%u)", i)
+
+   UString value = getValue(i);
+
+   uint32_t len = value.size();
+
+   if (len &&
+       getChar(i) == '"' &&
+       memchr(value.data(), '\\', len))
+      {
+      UString str(len);
+
+      UEscape::decode(value.data(), len, str);
+
+      U_RETURN_STRING(str);
+      }
+
+   U_RETURN_STRING(value);
+}
+
+bool UJsonOnDemand::jfind(const char* query, uint32_t query_len, UString& result) const
+{
+   U_TRACE(0, "UJsonOnDemand::jfind(%.*S,%u,%p)", query_len, query, query_len, &result)
+
+   U_ASSERT(result.empty())
+   U_INTERNAL_ASSERT(u_is_quoted(query, query_len))
+
+   const char* ptr = document.data();
+
+   const char* key = query + 1;
+   uint32_t key_len = query_len - 2;
+
+   // NB: we look only at the strings followed by ':' (the keys), and their bytes are compared only if the size is the same...
+
+   for (uint32_t i = 0; (i+3) < num; ++i)
+      {
+      if (ptr[vpos[i]] == '"')
+         {
+         if (ptr[vpos[i+2]] == ':' &&
+             (vpos[i+1] - vpos[i] - 1) == key_len &&
+             memcmp(ptr + vpos[i] + 1, key, key_len) == 0)
+            {
+            result = getValue(getMemberValue(i));
+
+            U_RETURN(true);
+            }
+
+         ++i; // the closing quote
+         }
+      }
+
+   U_RETURN(false);
+}
+
+int UJsonOnDemand::jread(const UString& query, UString& result, uint32_t* queryParams) const
+{
+   U_TRACE(0, "UJsonOnDemand::jread(%V,%p,%p)", query.rep, &result, queryParams)
+
+   U_ASSERT(result.empty())
+
+   if (num == 0) U_RETURN(-1);
+
+   int type;
+   char c, quote;
+   const char* key;
+   uint32_t i = 0, index;
+   const char* ptr = query.data();
+   const char* end = ptr + query.size();
+
+   while (true)
+      {
+      while (ptr < end && u__isspace(*ptr)) ++ptr;
+
+      if (ptr >= end) break;
+
+      c = *ptr++;
+
+      if ((c == '{' && getType(i) != U_OBJECT_VALUE) ||
+          (c == '[' && getType(i) != U_ARRAY_VALUE)  ||
+          (c != '{' && c != '['))
+         {
+         U_RETURN(-1); // JSON does not match Query
+         }
+
+      while (ptr < end && u__isspace(*ptr)) ++ptr;
+
+      if (ptr >= end) U_RETURN(-1);
+
+      if (c == '{' &&
+          (*ptr == '\'' || *ptr == '"'))
+         {
+         quote = *ptr;
+         key   = ++ptr;
+
+         while (ptr < end && *ptr != quote) ++ptr;
+
+         if (ptr >= end) U_RETURN(-1);
+
+         i = findKey(i, key, ptr++ - key);
+         }
+      else
+         {
+         if (*ptr == '*')
+            {
+            if (queryParams == U_NULLPTR) U_RETURN(-1);
+
+            ++ptr;
+
+            index = *queryParams++;
+            }
+         else
+            {
+            if (u__isdigit(*ptr) == false) U_RETURN(-1);
+
+            for (index = 0; ptr < end && u__isdigit(*ptr); ++ptr) index = index * 10 + (*ptr - '0');
+            }
+
+         i = at(i, index);
+
+         if (c == '{')
+            {
+            // NB: "{N" return the key of the N-th member...
+
+            if (i == U_NOT_FOUND) U_RETURN(-1);
+
+            result = getValue(i);
+
+            U_RETURN(U_STRING_VALUE);
+            }
+         }
+
+      if (i == U_NOT_FOUND) U_RETURN(-1);
+      }
+
+   type   = getType(i);
+   result = getValue(i);
+
+   U_RETURN(type);
+}
+
 // DEBUG
 
 #ifdef DEBUG
@@ -2800,6 +3491,7 @@ const char* UValue::dump(bool _reset) const
 {
 #ifdef U_STDCPP_ENABLE
    *UObjectIO::os << "next       " << next      << '\n'
+                  << "parena     " << parena    << '\n'
                   << "pkey.ival  " << pkey.ival << '\n'
                   << "value.ival " << value.ival;
 
@@ -2829,4 +3521,24 @@ const char* UJsonTypeHandler_Base::dump(bool _reset) const
 
    return U_NULLPTR;
 }
+
+const char* UJsonOnDemand::dump(bool _reset) const
+{
+#ifdef U_STDCPP_ENABLE
+   *UObjectIO::os << "num                " << num              << '\n'
+                  << "vpos               " << (void*)vpos      << '\n'
+                  << "vmatch             " << (void*)vmatch    << '\n'
+                  << "capacity           " << capacity         << '\n'
+                  << "document  (UString " << (void*)&document << ')';
+
+   if (_reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+#endif
+
+   return U_NULLPTR;
+}
 #endif
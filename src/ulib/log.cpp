@@ -29,6 +29,7 @@
 #  include <ulib/utility/interrupt.h>
 #endif
 
+#define U_LOG_RING_HEADER 64 // NB: sizeof(log_ring) rounded to the cache line...
 #define U_MARK_END "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n" // 24
 #define U_FMT_START_STOP "*** %s %N (%ubit, pid %P) [%U@%H] ***"
 
@@ -44,6 +45,25 @@ ULog::log_date*   ULog::ptr_shared_date;
 pthread_rwlock_t* ULog::prwlock;
 #endif
 
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+typedef struct log_ring_cache {
+   ULog* log;
+   ULog::log_ring* ring;
+   pid_t pid;
+} log_ring_cache;
+
+static __thread log_ring_cache ring_cache[2]; // NB: the server log and the apache like log...
+#endif
+
+static inline uint64_t u_log_nanotime()
+{
+   struct timespec ts;
+
+   (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return (ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
 ULog::ULog(const UString& path, uint32_t _size) : UFile(path, U_NULLPTR)
 {
    U_TRACE_CTOR(0, ULog, "%V,%u", path.rep, _size)
@@ -63,6 +83,16 @@ ULog::ULog(const UString& path, uint32_t _size) : UFile(path, U_NULLPTR)
    log_gzip_sz  = 0;
    ptr_log_data = U_NULLPTR;
 
+   ring_area        = U_NULLPTR;
+   ring_latency_sum =
+   ring_latency_max =
+   ring_check       = 0;
+   ring_num         =
+   ring_size        =
+   ring_map_size    =
+   ring_nflush      =
+   ring_dropped     = 0;
+
    U_Log_syslog(this)         =
    U_Log_start_stop_msg(this) = false;
 
@@ -436,61 +466,82 @@ void ULog::write(const struct iovec* iov, int n)
       return;
       }
 
-   int len;
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   if (ring_area &&
+       writeRing(iov, n))
+      {
+      return;
+      }
+#endif
+
+   lock();
+
+   writeMapped(iov, n);
+
+   unlock();
+}
+
+void ULog::writeMapped(const struct iovec* iov, int n)
+{
+   U_TRACE(0+256, "ULog::writeMapped(%p,%d)", iov, n)
+
+   U_INTERNAL_ASSERT_MAJOR(log_file_sz, 0)
+
+   int i, len;
    const char* ptr;
-   uint32_t file_ptr;
+   uint32_t file_ptr = ptr_log_data->file_ptr, total = 0;
 
-   U_INTERNAL_DUMP("UFile::map = %p ptr_log_data->file_ptr = %u log_file_sz = %u", UFile::map, ptr_log_data->file_ptr, log_file_sz)
+   U_INTERNAL_DUMP("UFile::map = %p ptr_log_data->file_ptr = %u log_file_sz = %u", UFile::map, file_ptr, log_file_sz)
 
-   lock();
+   for (i = 0; i < n; ++i) total += iov[i].iov_len;
 
-   file_ptr = ptr_log_data->file_ptr;
+   U_INTERNAL_ASSERT(total <= log_file_sz)
 
-   for (int i = 0; i < n; ++i)
+   if ((file_ptr+total) > log_file_sz) // if overwrite log file we compress it as gzip (NB: before the first piece, so we don't split the line...)
       {
-      if ((len = iov[i].iov_len))
-         {
-         ptr = (const char*)iov[i].iov_base;
+#  ifdef USE_LIBZ
+      U_INTERNAL_DUMP("UFile::st_size = %u log_gzip_sz = %u", UFile::st_size, log_gzip_sz)
 
-      // U_INTERNAL_DUMP("iov[%d](%u) -> %.*S", i, len, len, ptr)
+      U_INTERNAL_ASSERT_MAJOR(file_ptr, 0)
+      U_INTERNAL_ASSERT(file_ptr <= UFile::st_size)
 
-         if ((file_ptr+len) > log_file_sz) // if overwrite log file we compress it as gzip...
-            {
-#        ifdef USE_LIBZ
-            U_INTERNAL_DUMP("UFile::st_size = %u log_gzip_sz = %u", UFile::st_size, log_gzip_sz)
+      // NB: the shared area to compress log data may be not available at this time... (Ex: startup plugin u_server)
 
-            U_INTERNAL_ASSERT_MAJOR(file_ptr, 0)
-            U_INTERNAL_ASSERT(file_ptr <= UFile::st_size)
+      if (file_ptr <= log_gzip_sz)
+         {
+#     ifndef U_COVERITY_FALSE_POSITIVE // FORWARD_NULL
+         checkForLogRotateDataToWrite(); // check if there are previous data to write
+#     endif
 
-            // NB: the shared area to compress log data may be not available at this time... (Ex: startup plugin u_server)
+         ptr_log_data->gzip_len = u_gz_deflate(UFile::map, file_ptr, (char*)ptr_log_data+sizeof(log_data), Z_DEFAULT_COMPRESSION);
 
-            if (file_ptr <= log_gzip_sz)
-               {
-#           ifndef U_COVERITY_FALSE_POSITIVE // FORWARD_NULL
-               checkForLogRotateDataToWrite(); // check if there are previous data to write
-#           endif
+         U_INTERNAL_DUMP("u_gz_deflate(%u) = %u", file_ptr, ptr_log_data->gzip_len)
+         }
+      else if (buf_path_compress)
+         {
+         U_INTERNAL_ASSERT_EQUALS(ptr_log_data->gzip_len, 0)
 
-               ptr_log_data->gzip_len = u_gz_deflate(UFile::map, file_ptr, (char*)ptr_log_data+sizeof(log_data), Z_DEFAULT_COMPRESSION);
+         UString data_to_write = UStringExt::deflate(UFile::map, file_ptr, 0);
 
-               U_INTERNAL_DUMP("u_gz_deflate(%u) = %u", file_ptr, ptr_log_data->gzip_len)
-               }
-            else if (buf_path_compress)
-               {
-               U_INTERNAL_ASSERT_EQUALS(ptr_log_data->gzip_len, 0)
+         char* ptr1 = buf_path_compress->c_pointer(index_path_compress);
 
-               UString data_to_write = UStringExt::deflate(UFile::map, file_ptr, 0);
+         ptr1[u__snprintf(ptr1, 17, U_CONSTANT_TO_PARAM("%4D"))] = '.';
 
-               char* ptr1 = buf_path_compress->c_pointer(index_path_compress);
+         (void) UFile::writeTo(*buf_path_compress, data_to_write, O_RDWR | O_EXCL, false);
+         }
+#  endif
 
-               ptr1[u__snprintf(ptr1, 17, U_CONSTANT_TO_PARAM("%4D"))] = '.';
+                    file_ptr  =
+      ptr_log_data->file_page = 0;
+      }
 
-               (void) UFile::writeTo(*buf_path_compress, data_to_write, O_RDWR | O_EXCL, false);
-               }
-#        endif
+   for (i = 0; i < n; ++i)
+      {
+      if ((len = iov[i].iov_len))
+         {
+         ptr = (const char*)iov[i].iov_base;
 
-                          file_ptr  =
-            ptr_log_data->file_page = 0;
-            }
+      // U_INTERNAL_DUMP("iov[%d](%u) -> %.*S", i, len, len, ptr)
 
          if (len == 1) UFile::map[file_ptr++] = *ptr;
          else
@@ -516,8 +567,243 @@ void ULog::write(const struct iovec* iov, int n)
       }
 
    ptr_log_data->file_ptr = file_ptr;
+}
+
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+U_NO_EXPORT ULog::log_ring* ULog::getRing()
+{
+   U_TRACE_NO_PARAM(0, "ULog::getRing()")
+
+   log_ring* r;
+   log_ring_cache* item;
+   log_ring_cache* slot = U_NULLPTR;
+
+   for (item = ring_cache; item < (ring_cache + U_NUM_ELEMENTS(ring_cache)); ++item)
+      {
+      if (item->log == this)
+         {
+         if (item->pid == u_pid) U_RETURN_POINTER(item->ring, log_ring);
+
+         slot = item; // NB: after fork() the child must take its own ring...
+
+         break;
+         }
+
+      if (item->log == U_NULLPTR &&
+          slot      == U_NULLPTR)
+         {
+         slot = item;
+         }
+      }
+
+   if (slot)
+      {
+      pid_t tid = u_gettid();
+
+      for (uint32_t i = 0; i < ring_num; ++i)
+         {
+         r = (log_ring*)(ring_area + i * (U_LOG_RING_HEADER + ring_size));
+
+         if (r->owner == 0 &&
+             __sync_bool_compare_and_swap(&(r->owner), 0, tid))
+            {
+            slot->log  = this;
+            slot->ring = r;
+            slot->pid  = u_pid;
+
+            U_RETURN_POINTER(r, log_ring);
+            }
+         }
+      }
+
+   U_RETURN_POINTER(U_NULLPTR, log_ring); // NB: no ring available, we write directly on the log file...
+}
+
+U_NO_EXPORT bool ULog::writeRing(const struct iovec* iov, int n)
+{
+   U_TRACE(0, "ULog::writeRing(%p,%d)", iov, n)
+
+   log_ring* r = getRing();
+
+   if (r == U_NULLPTR) U_RETURN(false);
+
+   int i;
+   char* data = (char*)r + U_LOG_RING_HEADER;
+   uint32_t len = 0, off, sz, head = r->head, tail = __atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE);
+
+   for (i = 0; i < n; ++i) len += iov[i].iov_len;
+
+   U_INTERNAL_DUMP("head = %u tail = %u len = %u ring_size = %u", head, tail, len, ring_size)
+
+   if ((ring_size - (head - tail)) < len) // the flusher is behind, we drop the line (without wait)...
+      {
+      (void) __atomic_add_fetch(&(r->dropped), 1, __ATOMIC_RELAXED);
+
+      U_RETURN(true);
+      }
+
+   if (head == tail) __atomic_store_n(&(r->stamp), u_log_nanotime(), __ATOMIC_RELAXED);
+
+   for (i = 0; i < n; ++i)
+      {
+      if ((len = iov[i].iov_len))
+         {
+         off = (head & (ring_size - 1));
+         sz  = ring_size - off;
+
+         if (len <= sz)
+            {
+            U_MEMCPY(data + off, iov[i].iov_base, len);
+            }
+         else
+            {
+            U_MEMCPY(data + off,                          iov[i].iov_base,       sz);
+            U_MEMCPY(data, (const char*)iov[i].iov_base + sz,              len - sz);
+            }
+
+         head += len;
+         }
+      }
+
+   __atomic_store_n(&(r->head), head, __ATOMIC_RELEASE);
+
+   U_RETURN(true);
+}
+#endif
+
+void ULog::setRing(uint32_t nring, uint32_t size)
+{
+   U_TRACE(0, "ULog::setRing(%u,%u)", nring, size)
+
+   U_ASSERT(isMemoryMapped())
+   U_INTERNAL_ASSERT_MAJOR(nring, 0)
+   U_INTERNAL_ASSERT_EQUALS(ring_area, U_NULLPTR)
+   U_INTERNAL_ASSERT_EQUALS(U_Log_syslog(this), false)
+
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   // NB: the size of the ring must be a power of 2 and the content of a ring must fit in the log file...
+
+   if (size > (log_file_sz / 4)) size = log_file_sz / 4;
+
+   if (size >= 4096)
+      {
+      ring_size = u_nextPowerOfTwo(size);
+
+      if (ring_size > size) ring_size >>= 1;
+
+      ring_map_size = nring * (U_LOG_RING_HEADER + ring_size);
+
+      char* ptr = UFile::mmap(&ring_map_size, -1, PROT_READ | PROT_WRITE, MAP_SHARED | U_MAP_ANON, 0); // NB: must be shared because the fork() of the workers...
+
+      if (ptr != (char*)MAP_FAILED)
+         {
+         ring_num  = nring;
+         ring_area = ptr; // NB: anonymous memory is zero filled, so all the ring are free...
+         }
+      }
+
+   U_INTERNAL_DUMP("ring_area = %p ring_num = %u ring_size = %u ring_map_size = %u", ring_area, ring_num, ring_size, ring_map_size)
+#endif
+}
+
+void ULog::flush()
+{
+   U_TRACE_NO_PARAM(0, "ULog::flush()")
+
+   lock();
+
+   if (ring_area)
+      {
+      log_ring* r;
+      struct iovec iov[2];
+      uint64_t latency, now = u_log_nanotime();
+      uint32_t head, tail, len, off, mask = ring_size - 1;
+      bool bcheck = ((now - ring_check) >= 1000000000ULL); // NB: once a second we look for the ring of a died process...
+
+      if (bcheck) ring_check = now;
+
+      for (uint32_t i = 0; i < ring_num; ++i)
+         {
+         r = (log_ring*)(ring_area + i * (U_LOG_RING_HEADER + ring_size));
+
+         if (r->owner == 0) continue;
+
+         head = __atomic_load_n(&(r->head), __ATOMIC_ACQUIRE);
+         tail = r->tail;
+
+         if (head != tail)
+            {
+            len = head - tail;
+            off = tail & mask;
+
+            iov[0].iov_base = (caddr_t)r + U_LOG_RING_HEADER + off;
+            iov[0].iov_len  = U_min(len, ring_size - off);
+            iov[1].iov_base = (caddr_t)r + U_LOG_RING_HEADER;
+            iov[1].iov_len  = len - iov[0].iov_len;
+
+            latency = now - __atomic_load_n(&(r->stamp), __ATOMIC_RELAXED);
+
+            writeMapped(iov, 2);
+
+            __atomic_store_n(&(r->tail), head, __ATOMIC_RELEASE);
+
+            ++ring_nflush;
+
+            ring_latency_sum += latency;
+
+            if (ring_latency_max < latency) ring_latency_max = latency;
+            }
+
+         if (r->dropped) ring_dropped += __atomic_exchange_n(&(r->dropped), 0, __ATOMIC_RELAXED);
+
+         if (bcheck                                                &&
+             U_SYSCALL(kill, "%d,%d", r->owner, 0) == -1           &&
+             errno == ESRCH                                        &&
+             __atomic_load_n(&(r->head), __ATOMIC_ACQUIRE) == head)
+            {
+            U_INTERNAL_DUMP("ring[%u] owner = %d is died", i, r->owner)
+
+            __atomic_store_n(&(r->owner), 0, __ATOMIC_RELEASE);
+            }
+         }
+
+#  ifdef USE_LIBZ
+      checkForLogRotateDataToWrite(); // NB: the rotation is done here (not in the request path) so we write also the compressed data...
+#  endif
+      }
+
+   unlock();
+}
+
+void ULog::logRingStats(ULog* dest)
+{
+   U_TRACE(0, "ULog::logRingStats(%p)", dest)
+
+   U_INTERNAL_ASSERT_POINTER(dest)
+   U_INTERNAL_ASSERT_POINTER(ring_area)
+
+   lock();
+
+   uint64_t latency_sum = ring_latency_sum,
+            latency_max = ring_latency_max;
+   uint32_t nflush      = ring_nflush,
+            dropped     = ring_dropped;
+
+   ring_latency_sum =
+   ring_latency_max = 0;
+   ring_nflush      =
+   ring_dropped     = 0;
 
    unlock();
+
+   if (nflush ||
+       dropped)
+      {
+      UString name = UFile::getName();
+
+      dest->log(U_CONSTANT_TO_PARAM("Log ring (%v): %u flush, latency avg %u us max %u us, %u lines dropped"), name.rep,
+                nflush, (uint32_t)(nflush ? latency_sum / nflush / 1000 : 0), (uint32_t)(latency_max / 1000), dropped);
+      }
 }
 
 void ULog::write(const char* msg, uint32_t len)
@@ -842,6 +1128,13 @@ void ULog::closeLogInternal()
 {
    U_TRACE_NO_PARAM(1, "ULog::closeLogInternal()")
 
+   if (ring_area)
+      {
+      flush(); // NB: the lines of the workers must go before the shutdown message...
+
+      if (U_Log_start_stop_msg(this)) logRingStats(this);
+      }
+
    if (U_Log_start_stop_msg(this)) log(U_CONSTANT_TO_PARAM(U_FMT_START_STOP), "SHUTDOWN", sizeof(void*) * 8);
 
    if (U_Log_syslog(this))
@@ -858,6 +1151,17 @@ void ULog::closeLogInternal()
 
       if (log_file_sz)
          {
+         if (ring_area)
+            {
+            flush(); // NB: we write what remain on the rings...
+
+            lock();
+
+            ring_area = U_NULLPTR; // NB: we don't unmap it, there can be some thread that is still writing on its ring...
+
+            unlock();
+            }
+
          U_INTERNAL_ASSERT_MINOR(ptr_log_data->file_ptr, UFile::st_size)
 
       // msync();
@@ -1047,6 +1351,9 @@ const char* ULog::dump(bool _reset) const
                   << "prefix_len                " << prefix_len    << '\n'
                   << "log_file_sz               " << log_file_sz   << '\n'
                   << "log_gzip_sz               " << log_gzip_sz   << '\n'
+                  << "ring_num                  " << ring_num      << '\n'
+                  << "ring_size                 " << ring_size     << '\n'
+                  << "ring_area                 " << (void*)ring_area << '\n'
                   << "_lock     (ULock          " << (void*)&_lock << ')';
 
    if (_reset)
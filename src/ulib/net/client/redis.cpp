@@ -19,6 +19,20 @@ ptrdiff_t          UREDISClient_Base::diff;
 UVector<UString>*  UREDISClient_Base::pvec;
 UREDISClient_Base* UREDISClient_Base::pthis;
 
+UREDISClient_Base::~UREDISClient_Base()
+{
+   U_TRACE_DTOR(0, UREDISClient_Base)
+
+   if (pasync)
+      {
+      if (pasync->fd != -1) UNotifier::handlerDelete(pasync->fd, pasync->op_mask);
+
+      U_DELETE(pasync)
+      }
+
+   if (async_queue) UMemoryPool::_free(async_queue, U_RC_ASYNC_QUEUE_SZ, sizeof(async_info));
+}
+
 // Connect to REDIS server
 
 void UREDISClient_Base::init()
@@ -343,6 +357,10 @@ bool UREDISClient_Base::processRequest(char recvtype)
 {
    U_TRACE(0, "UREDISClient_Base::processRequest(%C)", recvtype)
 
+   U_INTERNAL_DUMP("async_num = %u", async_num)
+
+   if (async_num) (void) asyncWait(); // NB: the replies of the pending async commands come first...
+
    if (UClient_Base::sendRequest(false) &&
        (clear(), UClient_Base::response.setEmpty(), UClient_Base::readResponse(U_SINGLE_READ)))
       {
@@ -468,6 +486,325 @@ bool UREDISClient_Base::processMultiRequest(const char* format, uint32_t fmt_siz
    U_RETURN(false);
 }
 
+// ASYNC
+
+/**
+ * Return the size of the first complete reply in the buffer (0 if we need more data). We don't build anything here,
+ * the reply is then parsed by getResponseItem() like the synchronous API...
+ */
+
+static uint32_t getReplyLength(const char* ptr, const char* pend)
+{
+   U_TRACE(0, "::getReplyLength(%.*S,%u)", U_min(pend-ptr, 20), ptr, pend-ptr)
+
+   char prefix;
+   const char* eol;
+   uint32_t len, n = 1; // number of items still to skip
+   const char* pstart = ptr;
+
+   while (n)
+      {
+      if (ptr >= pend ||
+          (eol = (const char*)memchr(ptr, '\n', pend-ptr)) == U_NULLPTR)
+         {
+         U_RETURN(0);
+         }
+
+      --n;
+
+      prefix = *ptr++;
+
+      if (*ptr != '-') // "$-1\r\n" or "*-1\r\n" (Null)
+         {
+         if (prefix == U_RC_MULTIBULK) n += u_strtoul(ptr, eol-1);
+         else if (prefix == U_RC_BULK)
+            {
+            len = u_strtoul(ptr, eol-1) + U_CONSTANT_SIZE(U_CRLF);
+
+            if ((uint32_t)(pend-eol-1) < len) U_RETURN(0);
+
+            eol += len;
+            }
+         }
+
+      ptr = eol+1;
+      }
+
+   U_RETURN(ptr-pstart);
+}
+
+bool UREDISClient_Base::setAsync()
+{
+   U_TRACE_NO_PARAM(0, "UREDISClient_Base::setAsync()")
+
+   if (pasync == U_NULLPTR) U_NEW(UAsyncHandler, pasync, UAsyncHandler(this));
+
+   return asyncConnect();
+}
+
+U_NO_EXPORT bool UREDISClient_Base::asyncConnect()
+{
+   U_TRACE_NO_PARAM(0, "UREDISClient_Base::asyncConnect()")
+
+   if (UClient_Base::isConnected() == false &&
+       UClient_Base::connect() == false)
+      {
+      U_RETURN(false);
+      }
+
+   if (async_queue == U_NULLPTR) async_queue = (async_info*) UMemoryPool::cmalloc(U_RC_ASYNC_QUEUE_SZ, sizeof(async_info), true);
+
+   if (pasync &&
+       pasync->fd != UClient_Base::socket->getFd()) // NB: the first time or after a reconnection...
+      {
+      pasync->fd      = UClient_Base::socket->getFd();
+      pasync->op_mask = EPOLLIN | EPOLLRDHUP;
+
+      if (async_buffer) pasync->op_mask |= EPOLLOUT;
+
+      UNotifier::insert(pasync);
+      }
+
+   U_RETURN(true);
+}
+
+bool UREDISClient_Base::asyncCommand(vPFrcpv callback, void* arg, const char* cmd, uint32_t len)
+{
+   U_TRACE(0, "UREDISClient_Base::asyncCommand(%p,%p,%.*S,%u)", callback, arg, len, cmd, len)
+
+   U_INTERNAL_ASSERT_POINTER(cmd)
+   U_INTERNAL_ASSERT(u_endsWith(cmd, len, U_CONSTANT_TO_PARAM(U_CRLF)))
+
+   U_INTERNAL_DUMP("async_first = %u async_num = %u", async_first, async_num)
+
+   if (async_num == U_RC_ASYNC_QUEUE_SZ && // NB: the queue is full, we wait for the replies...
+       asyncWait() == false)
+      {
+      U_RETURN(false);
+      }
+
+   if (asyncConnect() == false) U_RETURN(false);
+
+   if (async_num == 0) // NB: the buffer can contain the reply of a previous synchronous command...
+      {
+      async_consumed = 0;
+
+      UClient_Base::response.setEmpty();
+      }
+
+   async_info* pinfo = async_queue + ((async_first + async_num++) & (U_RC_ASYNC_QUEUE_SZ-1));
+
+   pinfo->callback = callback;
+   pinfo->arg      = arg;
+
+   if (async_buffer.empty() &&
+       pasync)
+      {
+      // NB: the first command of this iteration of the event loop, the others are batched with it until the socket is writable...
+
+      pasync->op_mask |= EPOLLOUT;
+
+      (void) UNotifier::modify(pasync);
+      }
+
+   (void) async_buffer.append(cmd, len);
+
+   U_RETURN(true);
+}
+
+bool UREDISClient_Base::asyncRequest(vPFrcpv callback, void* arg, const char* format, uint32_t fmt_size, ...)
+{
+   U_TRACE(0, "UREDISClient_Base::asyncRequest(%p,%p,%.*S,%u)", callback, arg, fmt_size, format, fmt_size)
+
+   U_INTERNAL_ASSERT_POINTER(format)
+   U_INTERNAL_ASSERT_MAJOR(fmt_size, 0)
+
+   char buf[U_BUFFER_SIZE];
+
+   va_list argp;
+   va_start(argp, fmt_size);
+
+   uint32_t len = u__vsnprintf(buf, sizeof(buf)-U_CONSTANT_SIZE(U_CRLF), format, fmt_size, argp);
+
+   va_end(argp);
+
+   u_put_unalignedp16(buf+len, U_MULTICHAR_CONSTANT16('\r','\n'));
+
+   return asyncCommand(callback, arg, buf, len+U_CONSTANT_SIZE(U_CRLF));
+}
+
+bool UREDISClient_Base::asyncFlush()
+{
+   U_TRACE_NO_PARAM(0, "UREDISClient_Base::asyncFlush()")
+
+   uint32_t sz = async_buffer.size();
+
+   if (sz)
+      {
+      if (USocketExt::write(UClient_Base::socket, async_buffer, UClient_Base::timeoutMS) != sz)
+         {
+         asyncReset();
+
+         U_RETURN(false);
+         }
+
+      async_buffer.setEmpty();
+
+      if (pasync &&
+          (pasync->op_mask & EPOLLOUT) != 0)
+         {
+         pasync->op_mask &= ~EPOLLOUT;
+
+         (void) UNotifier::modify(pasync);
+         }
+      }
+
+   U_RETURN(true);
+}
+
+bool UREDISClient_Base::asyncWait()
+{
+   U_TRACE_NO_PARAM(0, "UREDISClient_Base::asyncWait()")
+
+   while (async_num)
+      {
+      if (asyncFlush() == false) U_RETURN(false); // NB: a callback can have queued new commands...
+
+      if (USocketExt::read(UClient_Base::socket, UClient_Base::response, U_SINGLE_READ, UClient_Base::timeoutMS) == false)
+         {
+         if (UClient_Base::isConnected()) UClient_Base::close(); // timeout: the replies that will arrive are out of sync...
+
+         asyncReset();
+
+         U_RETURN(false);
+         }
+
+      asyncDispatch();
+      }
+
+   U_RETURN(true);
+}
+
+U_NO_EXPORT void UREDISClient_Base::asyncDispatch()
+{
+   U_TRACE_NO_PARAM(0, "UREDISClient_Base::asyncDispatch()")
+
+   uint32_t len;
+   async_info* pinfo;
+
+   // NB: a callback can issue new commands and, if the queue is full, come back here (asyncWait()), so the position is a member...
+
+   while (async_num &&
+          (len = getReplyLength(UClient_Base::response.c_pointer(async_consumed), UClient_Base::response.pend())))
+      {
+      clear();
+
+      pthis = this;
+      start = async_consumed;
+      pvec  = &vitem;
+
+      err = (UClient_Base::response.c_char(async_consumed) == U_RC_ERROR ? U_RC_ERROR : U_RC_OK);
+
+      (void) getResponseItem();
+
+      U_INTERNAL_ASSERT_EQUALS(start, async_consumed+len)
+
+      async_consumed += len;
+
+      pinfo = async_queue + async_first;
+
+      async_first = (async_first + 1) & (U_RC_ASYNC_QUEUE_SZ-1);
+      --async_num;
+
+      if (pinfo->callback) pinfo->callback(this, pinfo->arg);
+      }
+
+   clear();
+
+   U_INTERNAL_DUMP("async_consumed = %u response.size() = %u", async_consumed, UClient_Base::response.size())
+
+   if (async_consumed)
+      {
+      if (async_consumed == UClient_Base::response.size()) UClient_Base::response.setEmpty();
+      else                                                 UClient_Base::response.moveToBeginDataInBuffer(async_consumed);
+
+      async_consumed = 0;
+      }
+}
+
+U_NO_EXPORT void UREDISClient_Base::asyncReset()
+{
+   U_TRACE_NO_PARAM(0, "UREDISClient_Base::asyncReset()")
+
+   U_INTERNAL_DUMP("async_num = %u", async_num)
+
+   if (pasync &&
+       pasync->fd != -1)
+      {
+      UNotifier::handlerDelete(pasync->fd, pasync->op_mask);
+
+      pasync->fd = -1;
+      }
+
+   if (UClient_Base::isConnected()) UClient_Base::close();
+
+   async_consumed = 0;
+
+   async_buffer.setEmpty();
+   UClient_Base::response.setEmpty();
+
+   // NB: the commands in flight are lost, we notify it to the callbacks...
+
+   async_info* pinfo;
+
+   while (async_num)
+      {
+      pinfo = async_queue + async_first;
+
+      async_first = (async_first + 1) & (U_RC_ASYNC_QUEUE_SZ-1);
+      --async_num;
+
+      clear();
+
+      err = U_RC_ERR_CONECTION_CLOSE;
+
+      if (pinfo->callback) pinfo->callback(this, pinfo->arg);
+      }
+
+   err = U_RC_OK;
+}
+
+U_NO_EXPORT int UREDISClient_Base::asyncHandlerRead()
+{
+   U_TRACE_NO_PARAM(0, "UREDISClient_Base::asyncHandlerRead()")
+
+   // NB: with EPOLLIN and EPOLLOUT together the notifier call only handlerRead()...
+
+   if (asyncFlush() == false) U_RETURN(U_NOTIFIER_OK); // NB: asyncReset() has already removed us from the notifier...
+
+   UNotifier::setReadOnce(); // NB: we are level triggered, the notifier must not call us again in the same loop...
+
+   if (USocketExt::read(UClient_Base::socket, UClient_Base::response, U_SINGLE_READ, 0) == false)
+      {
+      if (UClient_Base::isConnected()) U_RETURN(U_NOTIFIER_OK); // EAGAIN
+
+      U_RETURN(U_NOTIFIER_DELETE);
+      }
+
+   asyncDispatch();
+
+   U_RETURN(U_NOTIFIER_OK);
+}
+
+U_NO_EXPORT int UREDISClient_Base::asyncHandlerWrite()
+{
+   U_TRACE_NO_PARAM(0, "UREDISClient_Base::asyncHandlerWrite()")
+
+   (void) asyncFlush(); // NB: on error asyncReset() has already removed us from the notifier...
+
+   U_RETURN(U_NOTIFIER_OK);
+}
+
 bool UREDISClient_Base::scan(vPFcs function, const char* pattern, uint32_t len) // Returns all keys matching pattern (scan 0 MATCH *11*)
 {
    U_TRACE(0, "UREDISClient_Base::scan(%p,%.*S,%u)", function, len, pattern, len)
@@ -718,8 +1055,12 @@ const char* UREDISClient_Base::dump(bool _reset) const
    UClient_Base::dump(false);
 
    *UObjectIO::os << '\n'
-                  << "err                                 " << err           << '\n'
-                  << "vitem          (UVector             " << (void*)&vitem << ')';
+                  << "err                                 " << err                   << '\n'
+                  << "async_num                           " << async_num             << '\n'
+                  << "async_first                         " << async_first           << '\n'
+                  << "async_consumed                      " << async_consumed        << '\n'
+                  << "async_buffer   (UString             " << (void*)&async_buffer  << ")\n"
+                  << "vitem          (UVector             " << (void*)&vitem         << ')';
 
    if (_reset)
       {
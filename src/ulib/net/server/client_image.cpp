@@ -47,6 +47,7 @@ struct iovec UClientImage_Base::iov_vec[4];
 
 iPF    UClientImage_Base::callerHandlerRead       = UServer_Base::pluginsHandlerREAD;
 vPF    UClientImage_Base::callerHandlerRequest    = UServer_Base::pluginsHandlerRequest;
+vPFpv  UClientImage_Base::callerHandlerDelete;
 bPF    UClientImage_Base::callerHandlerCache      = handlerCache; 
 bPFpc  UClientImage_Base::callerIsValidMethod     = isValidMethod;
 bPFpcu UClientImage_Base::callerIsValidRequest    = isValidRequest;
@@ -124,10 +125,11 @@ UClientImage_Base::UClientImage_Base()
    socket = U_NULLPTR;
 
 #ifdef U_THROTTLING_SUPPORT
-   bytes_sent = 0;
-   min_limit  =
-   max_limit  =
-   started_at = 0;
+   bytes_sent         = 0;
+   throttling_rule    =
+   throttling_sending =
+   min_limit          =
+   started_at         = 0;
 #endif
 
    if (UServer_Base::isLog()) U_NEW_STRING(logbuf, UString(200U));
@@ -524,6 +526,8 @@ void UClientImage_Base::handlerDelete()
 
    U_INTERNAL_ASSERT_DIFFERS(U_ClientImage_parallelization, U_PARALLELIZATION_CHILD)
 
+   if (callerHandlerDelete) callerHandlerDelete(this);
+
    bool bdelete = (U_ClientImage_state == U_NOTIFY_DELETE);
 
    U_INTERNAL_DUMP("U_ClientImage_state = %d %B bdelete = %b", U_ClientImage_state, U_ClientImage_state, bdelete)
@@ -602,6 +606,17 @@ void UClientImage_Base::handlerDelete()
 
    --UNotifier::num_connection;
 
+#ifdef U_THROTTLING_SUPPORT
+   if (throttling_sending)
+      {
+      UServer_Base::clearThrottling(throttling_sending);
+
+      throttling_sending = 0;
+      }
+#endif
+
+   if (UServer_Base::vClientTimeout) UServer_Base::eraseTimeoutClient(this);
+
 #ifndef U_LOG_DISABLE
    if (UServer_Base::isLog())
       {
@@ -1093,7 +1108,7 @@ void UClientImage_Base::prepareForRead()
       U_INTERNAL_DUMP("UServer_Base::client_address = %.*S", U_CLIENT_ADDRESS_TO_TRACE)
 
 #  ifdef U_EVASIVE_SUPPORT
-      if (UServer_Base::db_evasive && 
+      if (UServer_Base::evasive_table &&
           UServer_Base::checkHold(socket->getClientAddress()))
          {
          abortive_close();
@@ -1116,7 +1131,7 @@ void UClientImage_Base::prepareForRead()
       }
 
 #ifdef U_EVASIVE_SUPPORT
-   if (UServer_Base::db_evasive &&
+   if (UServer_Base::evasive_table &&
        UServer_Base::checkHitSiteStats())
       {
       if (UHTTP::file_gzip_bomb &&
@@ -1765,7 +1780,13 @@ error:
       }
 
 #ifdef U_THROTTLING_SUPPORT
-   if (uri) UServer_Base::clearThrottling();
+   if (throttling_sending &&
+       count == 0) // NB: with a pending sendfile() we are still sending...
+      {
+      UServer_Base::clearThrottling(throttling_sending);
+
+      throttling_sending = 0;
+      }
 #endif
 
    endRequest();
@@ -1990,7 +2011,12 @@ copy: U_MEMCPY(ptr, iov, sz);
    U_INTERNAL_ASSERT_EQUALS(nrequest, 0)
 
 #ifdef U_THROTTLING_SUPPORT
-   if (iBytesWrite > 0) bytes_sent += iBytesWrite;
+   if (iBytesWrite > 0)
+      {
+      bytes_sent += iBytesWrite;
+
+      if (throttling_rule) UServer_Base::chargeThrottling(throttling_rule, iBytesWrite);
+      }
 #endif
 #ifdef DEBUG
    if (iBytesWrite > 0) UServer_Base::stats_bytes += iBytesWrite;
@@ -2152,17 +2178,26 @@ int UClientImage_Base::handlerWrite()
 
    U_INTERNAL_DUMP("bwrite = %b", bwrite)
 
+   off_t chunk = count;
+
 #ifdef U_THROTTLING_SUPPORT
-   if (UServer_Base::checkThrottlingBeforeSend(bwrite) == false) U_RETURN(U_NOTIFIER_OK);
+   UServer_Base::pClientImage = this; // NB: we can be called directly from UNotifier...
+
+   if (UServer_Base::checkThrottlingBeforeSend(bwrite, chunk) == false) U_RETURN(U_NOTIFIER_OK);
 #endif
 
    uint32_t iBytesWrite;
 
 write:
-   iBytesWrite = USocketExt::sendfile(socket, sfd, &offset, count, 0);
+   iBytesWrite = USocketExt::sendfile(socket, sfd, &offset, U_min(chunk, count), 0);
 
 #ifdef U_THROTTLING_SUPPORT
-   if (iBytesWrite > 0) bytes_sent += iBytesWrite;
+   if (iBytesWrite > 0)
+      {
+      bytes_sent += iBytesWrite;
+
+      if (throttling_rule) UServer_Base::chargeThrottling(throttling_rule, iBytesWrite);
+      }
 #endif
 #ifdef DEBUG
    if (iBytesWrite > 0) UServer_Base::stats_bytes += iBytesWrite;
@@ -2172,6 +2207,15 @@ write:
       {
       U_SRV_LOG_WITH_ADDR("sending sendfile response completed (%u bytes of %I) to", iBytesWrite, count);
 
+#  ifdef U_THROTTLING_SUPPORT
+      if (throttling_sending)
+         {
+         UServer_Base::clearThrottling(throttling_sending);
+
+         throttling_sending = 0;
+         }
+#  endif
+
       if (bwrite)
          {
          UEventFd::op_mask = EPOLLIN | EPOLLRDHUP | EPOLLET;
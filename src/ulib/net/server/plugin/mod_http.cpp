@@ -18,6 +18,10 @@
 #include <ulib/utility/string_ext.h>
 #include <ulib/net/server/plugin/mod_http.h>
 
+#ifdef USE_LIBSSL
+#  include <ulib/ssl/net/ssl_session.h>
+#endif
+
 #ifndef U_HTTP2_DISABLE
 #  include <ulib/utility/http2.h>
 #endif
@@ -98,7 +102,8 @@ int UHttpPlugIn::handlerConfig(UFileConfig& cfg)
    // URI_OVERLOAD_AUTHENTICATION enable use of usp services as alternative to .ht[digest|passwd] for URI_PROTECTED_MASK
    //
    // URI_REQUEST_CERT_MASK                      mask (DOS regexp) of URI where client must comunicate a certificate in the SSL connection
-   // BANDWIDTH_THROTTLING_MASK                  lets you set maximum byte rates on URLs or URL groups (*.jpg|*.gif 50)
+   // SSL_TICKET_KEY_ROTATE                      period (seconds) for the rotation of the key of the SSL session tickets (0 => SSL session cache on db)
+   // BANDWIDTH_THROTTLING_MASK                  lets you set maximum byte rates on URLs or URL groups (*.jpg|*.gif 50, min-max 20-50, max 32 rules)
    // URI_REQUEST_STRICT_TRANSPORT_SECURITY_MASK mask (DOS regexp) of URI where use HTTP Strict Transport Security to force client to use only SSL
    //
    // SESSION_COOKIE_OPTION eventual params for session cookie (lifetime, path, domain, secure, HttpOnly)  
@@ -395,6 +400,8 @@ int UHttpPlugIn::handlerConfig(UFileConfig& cfg)
       UHTTP::uri_overload_authentication = x.strtob();
       }
 
+   USSLSession::ticket_key_rotate = cfg.readLong(U_CONSTANT_TO_PARAM("SSL_TICKET_KEY_ROTATE"), U_ONE_HOUR_IN_SECOND);
+
    x = cfg.at(U_CONSTANT_TO_PARAM("URI_REQUEST_CERT_MASK"));
 
    if (x)
@@ -740,6 +747,7 @@ int UHttpPlugIn::handlerSigHUP()
 
 #ifdef USE_LIBSSL
    if (UServer_Base::bssl &&
+       UHTTP::db_session_ssl &&
        UHTTP::db_session_ssl->compactionJournal() == false)
       {
       U_WARNING("SSL: compaction of db SSL session failed");
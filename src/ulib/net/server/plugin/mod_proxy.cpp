@@ -26,9 +26,1516 @@
 #endif
 */
 
-UHttpClient<UTCPSocket>* UProxyPlugIn::client_http;
+#ifndef U_PROXY_READ_SIZE
+#define U_PROXY_READ_SIZE (64U * 1024U)
+#endif
+
+UProxyTimeout*              UProxyPlugIn::timeout;
+UProxyHealthCheck*          UProxyPlugIn::health;
+UHttpClient<UTCPSocket>*    UProxyPlugIn::client_http;
+UProxyPool*                 UProxyConnection::pools;
+UProxyConnection*           UProxyConnection::busy;
+UProxyConnection*           UProxyConnection::free_list;
+
+U_CREAT_FUNC(server_plugin_proxy, UProxyPlugIn)
+
+// NB: the response for a failure of the upstream when nothing was sent to the client...
+
+static const char bad_gateway[] = "HTTP/1.1 502 Bad Gateway\r\n"
+                                  "Content-Length: 0\r\n"
+                                  "Connection: close\r\n\r\n";
+
+UProxyConnection::UProxyConnection() : client(this)
+{
+   U_TRACE_CTOR(0, UProxyConnection, "")
+
+   U_NEW(UTCPSocket, socket, UTCPSocket(false));
+
+   pool     = U_NULLPTR;
+   plist    = U_NULLPTR;
+   prev     =
+   next     = U_NULLPTR;
+   upstream = U_NULLPTR;
+
+   reset();
+}
+
+UProxyConnection::~UProxyConnection()
+{
+   U_TRACE_DTOR(0, UProxyConnection)
+
+   if (state == TUNNEL &&
+       client.fd != -1)
+      {
+      UNotifier::handlerDelete(client.fd, client.op_mask);
+
+      (void) U_SYSCALL(close, "%d", client.fd);
+      }
+
+   if (UEventFd::fd != -1) UNotifier::handlerDelete(UEventFd::fd, UEventFd::op_mask);
+
+   if (socket->isOpen()) socket->close();
+
+   U_DELETE(socket)
+}
+
+void UProxyConnection::reset()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::reset()")
+
+   if (upstream)
+      {
+      --(upstream->nconn);
+
+      upstream = U_NULLPTR;
+      }
+
+   pclient = U_NULLPTR;
+   service = U_NULLPTR;
+   remain  = 0;
+   last_event = 0;
+   woffset = roffset = nparsed = line = ntry = 0;
+   state   = IDLE;
+
+   bhead = bclose = bkeepalive = breused = bwebsocket = bsent = bidempotent = false;
+
+   client.fd = -1;
+
+   wbuffer.setEmpty();
+   rbuffer.setEmpty();
+   pending.setEmpty();
+}
+
+void UProxyConnection::clear()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::clear()")
+
+   UProxyPool* ppool;
+   UProxyConnection* pconn;
+
+   while ((pconn = busy))      { pconn->unlink(); U_DELETE(pconn) }
+   while ((pconn = free_list)) { pconn->unlink(); U_DELETE(pconn) }
+
+   while ((ppool = pools))
+      {
+      while ((pconn = ppool->idle)) { pconn->unlink(); U_DELETE(pconn) }
+
+      pools = ppool->next;
+
+      U_DELETE(ppool)
+      }
+}
+
+void UProxyConnection::link(UProxyConnection** phead)
+{
+   U_TRACE(0, "UProxyConnection::link(%p)", phead)
+
+   U_INTERNAL_ASSERT_EQUALS(plist, U_NULLPTR)
+
+   prev  = U_NULLPTR;
+   next  = *phead;
+   plist =  phead;
+
+   if (next) next->prev = this;
+
+   *phead = this;
+
+   if (pool &&
+       phead == &(pool->idle))
+      {
+      ++(pool->nidle);
+      }
+}
+
+void UProxyConnection::unlink()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::unlink()")
+
+   if (plist)
+      {
+      if (prev) prev->next = next;
+      else      *plist     = next;
+
+      if (next) next->prev = prev;
+
+      if (pool &&
+          plist == &(pool->idle))
+         {
+         --(pool->nidle);
+         }
+
+      plist = U_NULLPTR;
+      prev  =
+      next  = U_NULLPTR;
+      }
+}
+
+bool UProxyConnection::isAsync(const UString& server)
+{
+   U_TRACE(0, "UProxyConnection::isAsync(%V)", server.rep)
+
+   U_INTERNAL_ASSERT_POINTER(UHTTP::service)
+
+   // NB: the services that need to process the response (or to do more request) are still managed in a child process,
+   //     and so the request for a server that depend on the request and that we need to resolve...
+
+   if (UHTTP::service->command == U_NULLPTR      &&
+       (UHTTP::service->isDynamicServer() == false || UProxyPool::isAddress(server)) &&
+       UHTTP::service->isAuthorization()   == false &&
+       UHTTP::service->isFollowRedirects() == false &&
+       UHTTP::service->isReplaceResponse() == false &&
+       U_http_version != '2'                     &&
+       (U_ClientImage_pipeline == false ||
+        (U_http_websocket_len && UHTTP::service->isWebSocket())) && // NB: after an Upgrade request there are the frames of the WebSocket, not other requests...
+       U_ClientImage_parallelization == 0        &&
+#    ifdef USE_LIBURING
+       UServer_Base::brng == false               &&
+#    endif
+       (UHTTP::service->isWebSocket() == false || UServer_Base::bssl == false)) // NB: for the tunnel we need the plain file descriptor of the client...
+      {
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+UProxyPool* UProxyConnection::getPool(const UString& server, unsigned int port)
+{
+   U_TRACE(0, "UProxyConnection::getPool(%V,%u)", server.rep, port)
+
+   UProxyPool* ppool;
+
+   for (ppool = pools; ppool; ppool = ppool->next)
+      {
+      if (ppool->port == port &&
+          ppool->server.equal(server))
+         {
+         U_RETURN_POINTER(ppool, UProxyPool);
+         }
+      }
+
+   U_NEW(UProxyPool, ppool, UProxyPool(server, port));
+
+   ppool->next = pools;
+                 pools = ppool;
+
+   U_RETURN_POINTER(ppool, UProxyPool);
+}
+
+bool UProxyConnection::start(UClientImage_Base* _pclient, const UString& server)
+{
+   U_TRACE(0, "UProxyConnection::start(%p,%V)", _pclient, server.rep)
+
+   U_INTERNAL_ASSERT_POINTER(_pclient)
+   U_INTERNAL_ASSERT_POINTER(UHTTP::service)
+
+   UProxyPool* ppool;
+   UProxyConnection* pconn;
+   UModProxyUpstream* up = U_NULLPTR;
+   uint32_t n = UHTTP::service->getUpstreamNum();
+
+   if (UHTTP::service->isDynamicServer()) ppool = getPool(server, UHTTP::service->getPort()); // NB: server is an address (see isAsync())...
+   else
+      {
+loop: up = UHTTP::service->selectUpstream(up);
+
+      U_INTERNAL_ASSERT_POINTER(up->pool) // NB: the pool of the upstream is created (and resolved) before the fork (see handlerRun())...
+
+      ppool = up->pool;
+      }
+
+   if (ppool->bresolved == false)
+      {
+      if (up)
+         {
+         up->setFailure(UHTTP::service->getMaxFails());
+
+         if (--n) goto loop; // NB: we try with another upstream...
+         }
+
+      U_RETURN(false);
+      }
+
+   if ((pconn = ppool->idle))
+      {
+      pconn->unlink();
+
+      U_INTERNAL_ASSERT_EQUALS(pconn->state, IDLE)
+
+      pconn->state   = HEADER;
+      pconn->breused = true;
+
+      pconn->setMask(EPOLLOUT); // NB: we send the request when we are back in the event loop...
+      }
+   else
+      {
+      if ((pconn = free_list)) pconn->unlink();
+      else
+         {
+         U_NEW(UProxyConnection, pconn, UProxyConnection);
+         }
+
+      pconn->pool = ppool;
+
+      if (pconn->connect() == false)
+         {
+         pconn->pool = U_NULLPTR;
+
+         pconn->link(&free_list);
+
+         if (up)
+            {
+            up->setFailure(UHTTP::service->getMaxFails());
+
+            if (--n) goto loop;
+            }
+
+         U_RETURN(false);
+         }
+      }
+
+   (void) pconn->wbuffer.replace(U_STRING_TO_PARAM(*UClientImage_Base::request)); // NB: we need a copy, the read buffer of the client is reused...
+
+   if (U_ClientImage_pipeline) // NB: the first frames of a WebSocket sent with the Upgrade request, we send them to the upstream after the 101 (see startTunnel())...
+      {
+      U_INTERNAL_ASSERT_MAJOR(U_http_websocket_len, 0)
+
+      (void) pconn->pending.replace(UClientImage_Base::request->pend(), (uint32_t)UClientImage_Base::rbuffer->remain(UClientImage_Base::request->pend()));
+
+      U_ClientImage_pipeline = false;
+      }
+
+   if ((pconn->upstream = up)) ++(up->nconn);
+
+   pconn->service     = UHTTP::service;
+   pconn->pclient     = _pclient;
+   pconn->bhead       = UHTTP::isHEAD();
+   pconn->bclose      = U_ClientImage_close;
+   pconn->bwebsocket  = UHTTP::service->isWebSocket();
+   pconn->bidempotent = ((U_http_method_type & (HTTP_GET | HTTP_HEAD | HTTP_PUT | HTTP_DELETE | HTTP_OPTIONS | HTTP_TRACE)) != 0);
+
+   pconn->last_event = u_now->tv_sec;
+
+   pconn->link(&busy);
+
+   // NB: we take the place of the client image in the event loop until the end of the response...
+
+   pconn->client.fd      = _pclient->UEventFd::fd;
+   pconn->client.op_mask = EPOLLRDHUP;
+
+   (void) UNotifier::modify(&(pconn->client));
+
+   U_ClientImage_close = false;
+
+   UClientImage_Base::setRequestProcessed();
+
+   U_RETURN(true);
+}
+
+bool UProxyConnection::connect()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::connect()")
+
+   U_INTERNAL_ASSERT_POINTER(pool)
+   U_INTERNAL_ASSERT(socket->isClosed())
+
+   socket->_socket();
+
+   if (socket->isClosed()) U_RETURN(false);
+
+   socket->setNonBlocking();
+
+   socket->iRemotePort    = pool->port;
+   socket->cRemoteAddress = pool->addr;
+
+   if (socket->connect() == false &&
+       errno != EINPROGRESS)
+      {
+      socket->close();
+
+      U_RETURN(false);
+      }
+
+   state = CONNECT;
+
+   UEventFd::fd      = socket->getFd();
+   UEventFd::op_mask = EPOLLOUT; // NB: we are notified when the connection is established (or failed)...
+
+   UNotifier::insert(this);
+
+   U_RETURN(true);
+}
+
+void UProxyConnection::setMask(uint32_t mask)
+{
+   U_TRACE(0, "UProxyConnection::setMask(%B)", mask)
+
+   if (UEventFd::op_mask != mask)
+      {
+      UEventFd::op_mask = mask;
+
+      (void) UNotifier::modify(this);
+      }
+}
+
+void UProxyConnection::close()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::close()")
+
+   if (UEventFd::fd != -1)
+      {
+      UNotifier::handlerDelete(UEventFd::fd, UEventFd::op_mask);
+
+      UEventFd::fd = -1;
+      }
+
+   if (socket->isOpen()) socket->close();
+
+   unlink();
+   reset();
+
+   pool = U_NULLPTR;
+
+   link(&free_list);
+}
+
+void UProxyConnection::detach()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::detach()")
+
+   unlink();
+
+   pclient   = U_NULLPTR;
+   client.fd = -1;
+}
+
+void UProxyConnection::handlerDeleteClient(void* _pclient)
+{
+   U_TRACE(0, "UProxyConnection::handlerDeleteClient(%p)", _pclient)
+
+   for (UProxyConnection* pconn = busy; pconn; pconn = pconn->next)
+      {
+      if (pconn->pclient == _pclient) // NB: the client is gone (f.e. timeout) with a response in progress...
+         {
+         pconn->detach();
+         pconn->close();
+
+         return;
+         }
+      }
+}
+
+void UProxyConnection::checkTimeout()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::checkTimeout()")
+
+   uint32_t sec;
+   UProxyConnection* pconn;
+   UProxyConnection* pnext;
+
+   for (pconn = busy; pconn; pconn = pnext)
+      {
+      pnext = pconn->next; // NB: retry() leave the connection in the list, abort() and closeTunnel() move it to the free list...
+
+      U_INTERNAL_ASSERT_POINTER(pconn->service)
+
+      sec = (pconn->state == CONNECT ? pconn->service->getConnectTimeout() :
+             pconn->state == TUNNEL  ? pconn->service->getIdleTimeout()    :
+                                       pconn->service->getReadTimeout());
+
+      if (sec &&
+          (u_now->tv_sec - pconn->last_event) >= (time_t)sec)
+         {
+         U_SRV_LOG("WARNING: proxy timeout (%u sec) in state %d - fd %d", sec, pconn->state, pconn->UEventFd::fd);
+
+              if (pconn->state == CONNECT) pconn->retry(); // NB: we try with another upstream...
+         else if (pconn->state == TUNNEL)  pconn->closeTunnel();
+         else
+            {
+            if (pconn->upstream &&
+                pconn->bsent == false)
+               {
+               pconn->upstream->setFailure(pconn->service->getMaxFails()); // NB: the upstream doesn't answer...
+               }
+
+            pconn->abort(true);
+            }
+         }
+      }
+}
+
+void UProxyConnection::abort(bool bgateway)
+{
+   U_TRACE(0, "UProxyConnection::abort(%b)", bgateway)
+
+   if (pclient)
+      {
+      UClientImage_Base* p = pclient;
+
+      if (bgateway &&
+          bsent == false &&
+          p->isOpen())
+         {
+         struct iovec iov = { (caddr_t)bad_gateway, U_CONSTANT_SIZE(bad_gateway) };
+
+         (void) p->writev(&iov, 1, U_CONSTANT_SIZE(bad_gateway), 0);
+         }
+
+      detach();
+
+      UNotifier::handlerDelete(p);
+      }
+
+   close();
+}
+
+void UProxyConnection::retry()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::retry()")
+
+   U_INTERNAL_DUMP("state = %d breused = %b bidempotent = %b ntry = %u", state, breused, bidempotent, ntry)
+
+   // NB: we can try again only if nothing of the response is arrived (and so nothing was sent to the client)...
+
+   if (bsent == false  &&
+       rbuffer.empty() &&
+       (state == CONNECT || state == HEADER) &&
+       UServer_Base::flag_loop)
+      {
+      // NB: if something of the request was sent (the upstream can have processed it) we try again only if the method is idempotent...
+
+      if (bidempotent == false &&
+          woffset)
+         {
+         if (breused == false &&
+             upstream)
+            {
+            upstream->setFailure(service->getMaxFails());
+            }
+
+         goto end;
+         }
+
+      if (breused) breused = false; // NB: a connection of the pool can have been closed by the upstream while idle, we try once with a new connection...
+      else
+         {
+         if (upstream == U_NULLPTR) goto end;
+
+         upstream->setFailure(service->getMaxFails());
+
+         if (++ntry >= service->getUpstreamNum()) goto end;
+
+         UModProxyUpstream* up = service->selectUpstream(upstream);
+
+         U_INTERNAL_ASSERT_POINTER(up->pool)
+
+         if (up->pool->bresolved == false) goto end;
+
+         --(upstream->nconn);
+           (upstream = up)->nconn++;
+
+         pool = up->pool;
+         }
+
+      if (UEventFd::fd != -1)
+         {
+         UNotifier::handlerDelete(UEventFd::fd, UEventFd::op_mask);
+
+         UEventFd::fd = -1;
+         }
+
+      socket->close();
+
+      woffset    = 0;
+      last_event = u_now->tv_sec;
+
+      if (connect()) return;
+      }
+
+end:
+   abort(true);
+}
+
+void UProxyConnection::finish()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::finish()")
+
+   U_INTERNAL_ASSERT_EQUALS(state, DONE)
+
+   UClientImage_Base* p = pclient;
+
+   detach();
+
+   if (bclose ||
+       bkeepalive == false)
+      {
+      UNotifier::handlerDelete(p); // NB: the client or the upstream asked for close (or the end of the response was the close of the upstream)...
+      }
+   else
+      {
+      (void) UNotifier::modify(p); // NB: the client image is back in the event loop...
+      }
+
+   if (bkeepalive == false ||
+       pool->nidle >= U_PROXY_MAX_IDLE)
+      {
+      close();
+
+      return;
+      }
+
+   reset();
+
+   // NB: while idle we are notified only if the upstream close the connection...
+
+   setMask(EPOLLIN | EPOLLRDHUP);
+
+   link(&(pool->idle));
+}
+
+// The upstream
+
+int UProxyConnection::handlerRead()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::handlerRead()")
+
+   U_INTERNAL_DUMP("state = %d", state)
+
+   last_event = u_now->tv_sec;
+
+   switch (state)
+      {
+      case IDLE: // NB: the upstream closed an idle connection...
+         close();
+      break;
+
+      case CONNECT: (void) handlerWrite(); break;
+      case TUNNEL:  handlerTunnel(true); break;
+
+      default: readResponse(); break;
+      }
+
+#ifdef U_EPOLLET_POSTPONE_STRATEGY
+   U_ClientImage_state = U_PLUGIN_HANDLER_AGAIN; // NB: we are level triggered, the notifier must not call us again in the same loop...
+#endif
+
+   U_RETURN(U_NOTIFIER_OK);
+}
+
+int UProxyConnection::handlerWrite()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::handlerWrite()")
+
+   U_INTERNAL_DUMP("state = %d", state)
+
+   last_event = u_now->tv_sec;
+
+   if (state == TUNNEL)
+      {
+      handlerTunnel(true);
+
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
+   if (state == CONNECT)
+      {
+      int err = 0;
+      uint32_t len = sizeof(int);
+
+      if (socket->getSockOpt(SOL_SOCKET, SO_ERROR, &err, len) == false ||
+          err)
+         {
+         retry();
+
+         U_RETURN(U_NOTIFIER_OK);
+         }
+
+      socket->iState = USocket::CONNECT;
+
+      state = HEADER;
+      }
+
+   sendRequest();
+
+   U_RETURN(U_NOTIFIER_OK);
+}
+
+void UProxyConnection::handlerDelete()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::handlerDelete()")
+
+   U_INTERNAL_DUMP("state = %d", state)
+
+   // NB: the connection is owned by the pool, not by the notifier...
+
+   UEventFd::fd = -1;
+
+   if (state == DONE) // NB: the response is complete, the client is only slower than the upstream...
+      {
+      socket->close();
+
+      bkeepalive = false;
+
+      return;
+      }
+
+   if      (state == TUNNEL) closeTunnel();
+   else if (state != IDLE)   retry();
+   else                      close();
+}
+
+void UProxyConnection::sendRequest()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::sendRequest()")
+
+   int n;
+   uint32_t sz = wbuffer.size();
+
+   while (woffset < sz)
+      {
+      n = socket->send(wbuffer.c_pointer(woffset), sz - woffset);
+
+      if (n <= 0)
+         {
+         if (n == -1 &&
+             errno == EAGAIN)
+            {
+            setMask(EPOLLOUT);
+
+            return;
+            }
+
+         retry();
+
+         return;
+         }
+
+      woffset += n;
+      }
+
+   // NB: the request is sent, now we wait for the response...
+
+   setMask(EPOLLIN | EPOLLRDHUP);
+}
+
+void UProxyConnection::readResponse()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::readResponse()")
+
+   uint32_t sz = rbuffer.size();
+
+   if (rbuffer.space() < U_CAPACITY) UString::_reserve(rbuffer, rbuffer.getReserveNeed(U_PROXY_READ_SIZE));
+
+   int n = socket->recv(rbuffer.c_pointer(sz), rbuffer.space());
+
+   if (n > 0)
+      {
+      rbuffer.size_adjust_force(sz + n);
+
+      processResponse();
+
+      return;
+      }
+
+   if (n == -1 &&
+       errno == EAGAIN)
+      {
+      return;
+      }
+
+   if (state == UNTIL_EOF) // NB: the end of the body is the close of the connection...
+      {
+      state = DONE;
+
+      processResponse();
+
+      return;
+      }
+
+   retry();
+}
+
+void UProxyConnection::processResponse()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::processResponse()")
+
+   uint32_t sz;
+   const char* ptr;
+   const char* eoh;
+
+   while (state != DONE   &&
+          state != TUNNEL &&
+          (sz = rbuffer.size() - nparsed) > 0)
+      {
+      ptr = rbuffer.c_pointer(nparsed);
+
+      if (state != HEADER)
+         {
+         if ((sz = scanBody(ptr, sz)) == U_NOT_FOUND) // NB: bad framing of the body...
+            {
+            abort(true);
+
+            return;
+            }
+
+         nparsed += sz;
+         }
+      else
+         {
+         // NB: u_findEndHeader1() don't include the U_CRLF2 when it is at the end of the data...
+
+         if (sz < U_CONSTANT_SIZE(U_CRLF2) ||
+             (eoh = (const char*)u_find(ptr, sz, U_CONSTANT_TO_PARAM(U_CRLF2))) == U_NULLPTR)
+            {
+            if (sz > U_PROXY_READ_SIZE) // NB: header too large...
+               {
+               abort(true);
+
+               return;
+               }
+
+            break;
+            }
+
+         sz = eoh - ptr + U_CONSTANT_SIZE(U_CRLF2);
+
+         if (parseHeader(ptr, sz) == false)
+            {
+            abort(true);
+
+            return;
+            }
+
+         if (upstream) upstream->setSuccess();
+
+         nparsed += sz;
+         }
+      }
+
+   if (state == TUNNEL)
+      {
+      startTunnel();
+
+      return;
+      }
+
+   if (state == DONE &&
+       nparsed < rbuffer.size()) // NB: data after the end of the response, we don't reuse the connection...
+      {
+      bkeepalive = false;
+
+      rbuffer.size_adjust_force(nparsed);
+      }
+
+   if (writeResponse() == false) return;
+
+   if (roffset < nparsed) setBackPressure(true);
+   else if (state == DONE) finish();
+}
+
+bool UProxyConnection::writeResponse()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::writeResponse()")
+
+   U_INTERNAL_ASSERT_POINTER(pclient)
+
+   if (roffset < nparsed)
+      {
+      struct iovec iov = { (caddr_t)rbuffer.c_pointer(roffset), nparsed - roffset };
+
+      uint32_t n = pclient->writev(&iov, 1, nparsed - roffset, 0);
+
+      if (pclient->isOpen() == false)
+         {
+         abort(false);
+
+         U_RETURN(false);
+         }
+
+      if (n) bsent = true;
+
+      if ((roffset += n) == nparsed)
+         {
+         if (nparsed == rbuffer.size()) rbuffer.setEmpty();
+         else                           rbuffer.moveToBeginDataInBuffer(nparsed); // NB: the rest of the header...
+
+         roffset = nparsed = 0;
+         }
+      }
+
+   U_RETURN(true);
+}
+
+void UProxyConnection::setBackPressure(bool bflag)
+{
+   U_TRACE(0, "UProxyConnection::setBackPressure(%b)", bflag)
+
+   // NB: when the client is slower than the upstream we stop to read from the upstream until the client can get more data...
+
+   setMask(bflag ? 0U : (uint32_t)(EPOLLIN | EPOLLRDHUP));
+
+   client.op_mask = (bflag ? EPOLLOUT | EPOLLRDHUP : EPOLLRDHUP);
+
+   (void) UNotifier::modify(&client);
+}
+
+bool UProxyConnection::parseHeader(const char* ptr, uint32_t sz)
+{
+   U_TRACE(0, "UProxyConnection::parseHeader(%.*S,%u)", sz, ptr, sz)
+
+   // HTTP/1.1 200 OK\r\n
+
+   if (sz < U_CONSTANT_SIZE("HTTP/1.1 200\r\n") ||
+       u_get_unalignedp32(ptr) != U_MULTICHAR_CONSTANT32('H','T','T','P'))
+      {
+      U_RETURN(false);
+      }
+
+   const char* eol;
+   const char* value;
+   const char* end = ptr + sz;
+   bool bchunked = false, blength = false;
+   uint32_t status = u__strtoul(ptr+9, 3);
+
+   U_INTERNAL_DUMP("status = %u", status)
+
+   bkeepalive = (ptr[7] == '1'); // NB: HTTP/1.0 is not persistent by default...
+
+   for (ptr = (const char*)memchr(ptr, '\n', sz) + 1; ptr < end; ptr = eol + 1)
+      {
+      if ((eol = (const char*)memchr(ptr, '\n', end - ptr)) == U_NULLPTR) break;
+
+      if (u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("Content-Length:")) == 0)
+         {
+         const char* digit;
+
+         for (value = ptr + U_CONSTANT_SIZE("Content-Length:"); u__isblank(*value); ++value) {}
+         for (digit = value;                                    u__isdigit(*digit); ++digit) {}
+
+         blength = true;
+         remain  = u__strtoull(value, digit - value);
+         }
+      else if (u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("Transfer-Encoding:")) == 0)
+         {
+         // NB: chunked must be the last encoding...
+
+         value = eol;
+
+         while (u__isspace(value[-1])) --value;
+
+         bchunked = (value - ptr > (ptrdiff_t)U_CONSTANT_SIZE("chunked") &&
+                     u__strncasecmp(value - U_CONSTANT_SIZE("chunked"), U_CONSTANT_TO_PARAM("chunked")) == 0);
+         }
+      else if (u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("Connection:")) == 0)
+         {
+         for (value = ptr + U_CONSTANT_SIZE("Connection:"); u__isblank(*value); ++value) {}
+
+              if (u__strncasecmp(value, U_CONSTANT_TO_PARAM("close"))      == 0) bkeepalive = false;
+         else if (u__strncasecmp(value, U_CONSTANT_TO_PARAM("keep-alive")) == 0) bkeepalive = true;
+         }
+      }
+
+   U_INTERNAL_DUMP("bkeepalive = %b bchunked = %b blength = %b remain = %llu", bkeepalive, bchunked, blength, remain)
+
+   if (status < 200)
+      {
+      if (status != 101) U_RETURN(true); // NB: an interim response (100 Continue), the final response follow...
+
+      if (bwebsocket == false) U_RETURN(false);
+
+      state = TUNNEL;
+
+      U_RETURN(true);
+      }
+
+   if (bhead         ||
+       status == 204 ||
+       status == 304)
+      {
+      state = DONE;
+      }
+   else if (bchunked)
+      {
+      state  = CHUNK_SIZE;
+      remain = 0;
+      }
+   else if (blength)
+      {
+      state = (remain ? LENGTH : DONE);
+      }
+   else
+      {
+      state      = UNTIL_EOF;
+      bkeepalive = false;
+      }
+
+   U_RETURN(true);
+}
+
+uint32_t UProxyConnection::scanBody(const char* ptr, uint32_t sz)
+{
+   U_TRACE(0, "UProxyConnection::scanBody(%.*S,%u)", U_min(sz,128), ptr, sz)
+
+   // NB: we don't touch the data, we only follow the framing to know where the response end...
+
+   unsigned char c;
+   uint32_t n;
+   const char* p   = ptr;
+   const char* end = ptr + sz;
+
+   while (p < end)
+      {
+      switch (state)
+         {
+         case LENGTH:
+         case CHUNK_DATA:
+            {
+            n = U_min(remain, (uint64_t)(end - p));
+
+            p      += n;
+            remain -= n;
+
+            if (remain == 0) state = (state == LENGTH ? DONE : CHUNK_CRLF);
+            }
+         break;
+
+         case UNTIL_EOF: p = end; break;
+
+         case CHUNK_SIZE:
+            {
+            c = *p++;
+
+            if (u__isxdigit(c))
+               {
+               if (remain >> 60) U_RETURN(U_NOT_FOUND); // NB: the size of the chunk overflow 64 bit...
+
+               remain = (remain << 4) | u__hexc2int(c);
+               }
+            else if (c == '\n')
+               {
+               line  = 0;
+               state = (remain ? CHUNK_DATA : TRAILER);
+               }
+            else if (c != '\r') state = CHUNK_EXT;
+            }
+         break;
+
+         case CHUNK_EXT:
+            {
+            if (*p++ == '\n')
+               {
+               line  = 0;
+               state = (remain ? CHUNK_DATA : TRAILER);
+               }
+            }
+         break;
+
+         case CHUNK_CRLF:
+            {
+            if (*p++ == '\n') state = CHUNK_SIZE;
+            }
+         break;
+
+         case TRAILER: // NB: after the last chunk we can have some trailer header, the end is an empty line...
+            {
+            c = *p++;
+
+            if (c == '\n')
+               {
+               if (line == 0) state = DONE;
+               else           line  = 0;
+               }
+            else if (c != '\r') ++line;
+            }
+         break;
+         }
+
+      if (state == DONE) break;
+      }
+
+   U_RETURN(p - ptr);
+}
+
+// The client
+
+int UProxyClient::handlerRead()
+{
+   U_TRACE_NO_PARAM(0, "UProxyClient::handlerRead()")
+
+   pconn->clientHandlerRead();
+
+#ifdef U_EPOLLET_POSTPONE_STRATEGY
+   U_ClientImage_state = U_PLUGIN_HANDLER_AGAIN;
+#endif
+
+   U_RETURN(U_NOTIFIER_OK);
+}
+
+int UProxyClient::handlerWrite()
+{
+   U_TRACE_NO_PARAM(0, "UProxyClient::handlerWrite()")
+
+   pconn->clientHandlerWrite();
+
+   U_RETURN(U_NOTIFIER_OK);
+}
+
+void UProxyClient::handlerDelete()
+{
+   U_TRACE_NO_PARAM(0, "UProxyClient::handlerDelete()")
+
+   pconn->clientHandlerDelete();
+}
+
+void UProxyConnection::clientHandlerRead()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::clientHandlerRead()")
+
+   last_event = u_now->tv_sec;
+
+   if (state == TUNNEL) handlerTunnel(false);
+   else                 abort(false); // NB: without EPOLLIN we are here only if the client closed the connection...
+}
+
+void UProxyConnection::clientHandlerWrite()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::clientHandlerWrite()")
+
+   last_event = u_now->tv_sec;
+
+   if (state == TUNNEL)
+      {
+      handlerTunnel(false);
+
+      return;
+      }
+
+   if (writeResponse() == false ||
+       roffset < nparsed)
+      {
+      return;
+      }
+
+   if (state == DONE)
+      {
+      finish();
+
+      return;
+      }
+
+   setBackPressure(false);
+
+   if (rbuffer) processResponse();
+}
+
+void UProxyConnection::clientHandlerDelete()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::clientHandlerDelete()")
+
+   if (state == TUNNEL) closeTunnel();
+   else                 abort(false);
+}
+
+// WebSocket: after the 101 response we splice the two sockets in the event loop...
+
+void UProxyConnection::startTunnel()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::startTunnel()")
+
+   U_INTERNAL_ASSERT_POINTER(pclient)
+   U_INTERNAL_ASSERT_EQUALS(state, TUNNEL)
+
+   int cfd = U_SYSCALL(dup, "%d", client.fd); // NB: the client image is reused for other connections, we keep only the file descriptor...
+
+   if (cfd == -1)
+      {
+      abort(false);
+
+      return;
+      }
+
+   UClientImage_Base* p = pclient;
+
+   UNotifier::suspend(&client); // NB: with a duplicate file descriptor the close of the client image doesn't remove it from epoll...
+
+   detach();
+
+   link(&busy); // NB: so that we can close the tunnel at the end...
+
+   UNotifier::handlerDelete(p);
+
+   client.fd      = cfd;
+   client.op_mask = EPOLLIN | EPOLLRDHUP;
+
+   UNotifier::insert(&client);
+
+   (void) wbuffer.replace(U_STRING_TO_PARAM(pending)); // NB: the first frames of the client sent with the Upgrade request (maybe none)...
+
+   pending.setEmpty();
+
+   woffset = 0;
+   nparsed = rbuffer.size(); // NB: the 101 response and maybe the first frames from the upstream...
+
+   handlerTunnel(true);
+}
+
+static bool relay(int from, int to, UString& buffer, uint32_t& offset, bool bread)
+{
+   U_TRACE(0, "::relay(%d,%d,%V,%u,%b)", from, to, buffer.rep, offset, bread)
+
+   int n;
+   uint32_t sz;
+
+   // NB: we read from the source only when the destination has taken all the previous data...
+
+   while (true)
+      {
+      while (offset < (sz = buffer.size()))
+         {
+         n = U_SYSCALL(send, "%d,%p,%u,%d", to, buffer.c_pointer(offset), sz - offset, MSG_NOSIGNAL);
+
+         if (n <= 0)
+            {
+            if (n == -1 &&
+                errno == EAGAIN)
+               {
+               U_RETURN(true);
+               }
+
+            U_RETURN(false);
+            }
+
+         offset += n;
+         }
+
+      buffer.setEmpty();
+
+      offset = 0;
+
+      if (bread == false) U_RETURN(true);
+
+      bread = false;
+
+      if (buffer.space() < U_CAPACITY) UString::_reserve(buffer, buffer.getReserveNeed(U_PROXY_READ_SIZE));
+
+      n = U_SYSCALL(recv, "%d,%p,%u,%d", from, buffer.c_pointer(0), buffer.space(), 0);
+
+      if (n <= 0)
+         {
+         if (n == -1 &&
+             errno == EAGAIN)
+            {
+            U_RETURN(true);
+            }
+
+         U_RETURN(false);
+         }
 
-U_CREAT_FUNC(server_plugin_proxy, UProxyPlugIn)
+      buffer.size_adjust_force(n);
+      }
+}
+
+void UProxyConnection::closeTunnel()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::closeTunnel()")
+
+   // NB: we are here also for the hang up (or an error) of one side (EPOLLHUP and EPOLLERR are reported by epoll even with a mask of zero,
+   //     see handlerTunnel()), so before to close we write without blocking to the other side what we have already read from it...
+
+   if (client.fd != -1 &&
+       rbuffer.size() > roffset)
+      {
+      (void) relay(-1, client.fd, rbuffer, roffset, false);
+      }
+
+   if (socket->isOpen() &&
+       wbuffer.size() > woffset)
+      {
+      (void) relay(-1, socket->getFd(), wbuffer, woffset, false);
+      }
+
+   if (client.fd != -1)
+      {
+      UNotifier::handlerDelete(client.fd, client.op_mask);
+
+      (void) U_SYSCALL(close, "%d", client.fd);
+      }
+
+   detach();
+   close();
+}
+
+void UProxyConnection::handlerTunnel(bool bupstream)
+{
+   U_TRACE(0, "UProxyConnection::handlerTunnel(%b)", bupstream)
+
+   bool result;
+
+   // NB: rbuffer is the data for the client, wbuffer the data for the upstream...
+
+   if (bupstream) result = relay(UEventFd::fd, client.fd, rbuffer, roffset, true) && relay(client.fd, UEventFd::fd, wbuffer, woffset, false);
+   else           result = relay(client.fd, UEventFd::fd, wbuffer, woffset, true) && relay(UEventFd::fd, client.fd, rbuffer, roffset, false);
+
+   if (result == false)
+      {
+      closeTunnel();
+
+      return;
+      }
+
+   // NB: a side with a mask of zero (the other one is slower) still get EPOLLHUP and EPOLLERR, for them the notifier
+   //     call handlerDelete() and closeTunnel() flush the data already read before to tear down the tunnel...
+
+   uint32_t mask = (rbuffer.empty() ? (uint32_t)(EPOLLIN | EPOLLRDHUP) : 0U) | (wbuffer.empty() ? 0U : (uint32_t)EPOLLOUT);
+
+   setMask(mask);
+
+   mask = (wbuffer.empty() ? (uint32_t)(EPOLLIN | EPOLLRDHUP) : 0U) | (rbuffer.empty() ? 0U : (uint32_t)EPOLLOUT);
+
+   if (client.op_mask != mask)
+      {
+      client.op_mask = mask;
+
+      (void) UNotifier::modify(&client);
+      }
+}
+
+// The active health check
+
+UProxyProbe::UProxyProbe(UModProxyService* service, UModProxyUpstream* _upstream)
+{
+   U_TRACE_CTOR(0, UProxyProbe, "%p,%p", service, _upstream)
+
+   U_NEW(UTCPSocket, socket, UTCPSocket(false));
+
+   next     = U_NULLPTR;
+   upstream = _upstream;
+   woffset  = rlen = 0;
+
+   request.setBuffer(200U + service->getHealthCheck().size() + upstream->server.size());
+
+   request.snprintf(U_CONSTANT_TO_PARAM("GET %v HTTP/1.0\r\n"
+                                        "Host: %v:%d\r\n"
+                                        "User-Agent: ULib/proxy-health-check\r\n"
+                                        "\r\n"), service->getHealthCheck().rep, upstream->server.rep, upstream->port);
+}
+
+UProxyProbe::~UProxyProbe()
+{
+   U_TRACE_DTOR(0, UProxyProbe)
+
+   if (UEventFd::fd != -1) UNotifier::handlerDelete(UEventFd::fd, UEventFd::op_mask);
+
+   if (socket->isOpen()) socket->close();
+
+   U_DELETE(socket)
+}
+
+void UProxyProbe::close()
+{
+   U_TRACE_NO_PARAM(0, "UProxyProbe::close()")
+
+   if (UEventFd::fd != -1)
+      {
+      UNotifier::handlerDelete(UEventFd::fd, UEventFd::op_mask);
+
+      UEventFd::fd = -1;
+      }
+
+   if (socket->isOpen()) socket->close();
+
+   woffset = rlen = 0;
+}
+
+void UProxyProbe::setResult(bool bup)
+{
+   U_TRACE(0, "UProxyProbe::setResult(%b)", bup)
+
+   close();
+
+   if (bup) upstream->setSuccess();
+   else
+      {
+      upstream->bdown     = true;
+      upstream->fail_time = u_now->tv_sec;
+      }
+}
+
+void UProxyProbe::start()
+{
+   U_TRACE_NO_PARAM(0, "UProxyProbe::start()")
+
+   if (UEventFd::fd != -1) // NB: no response since the previous check...
+      {
+      setResult(false);
+      }
+
+   U_INTERNAL_ASSERT_POINTER(upstream->pool) // NB: see UProxyPlugIn::handlerRun()...
+
+   if (upstream->pool->bresolved == false)
+      {
+      setResult(false);
+
+      return;
+      }
+
+   socket->_socket();
+
+   if (socket->isClosed()) return;
+
+   socket->setNonBlocking();
+
+   socket->iRemotePort    = upstream->pool->port;
+   socket->cRemoteAddress = upstream->pool->addr;
+
+   if (socket->connect() == false &&
+       errno != EINPROGRESS)
+      {
+      setResult(false);
+
+      return;
+      }
+
+   UEventFd::fd      = socket->getFd();
+   UEventFd::op_mask = EPOLLOUT;
+
+   UNotifier::insert(this);
+}
+
+int UProxyProbe::handlerWrite()
+{
+   U_TRACE_NO_PARAM(0, "UProxyProbe::handlerWrite()")
+
+   if (woffset == 0)
+      {
+      int err = 0;
+      uint32_t len = sizeof(int);
+
+      if (socket->getSockOpt(SOL_SOCKET, SO_ERROR, &err, len) == false ||
+          err)
+         {
+         setResult(false);
+
+         U_RETURN(U_NOTIFIER_OK);
+         }
+
+      socket->iState = USocket::CONNECT;
+      }
+
+   int n = socket->send(request.c_pointer(woffset), request.size() - woffset);
+
+   if (n <= 0)
+      {
+      if (n == -1 &&
+          errno == EAGAIN)
+         {
+         U_RETURN(U_NOTIFIER_OK);
+         }
+
+      setResult(false);
+
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
+   if ((woffset += n) == request.size())
+      {
+      UEventFd::op_mask = EPOLLIN | EPOLLRDHUP;
+
+      (void) UNotifier::modify(this);
+      }
+
+   U_RETURN(U_NOTIFIER_OK);
+}
+
+int UProxyProbe::handlerRead()
+{
+   U_TRACE_NO_PARAM(0, "UProxyProbe::handlerRead()")
+
+#ifdef U_EPOLLET_POSTPONE_STRATEGY
+   U_ClientImage_state = U_PLUGIN_HANDLER_AGAIN; // NB: we are level triggered, the notifier must not call us again in the same loop...
+#endif
+
+   int n = socket->recv(rbuffer + rlen, sizeof(rbuffer) - rlen);
+
+   if (n > 0)
+      {
+      // HTTP/1.1 200 OK\r\n
+
+      if ((rlen += n) < U_CONSTANT_SIZE("HTTP/1.1 200")) U_RETURN(U_NOTIFIER_OK);
+
+      uint32_t status = u__strtoul(rbuffer+9, 3);
+
+      U_INTERNAL_DUMP("status = %u", status)
+
+      setResult(u_get_unalignedp32(rbuffer) == U_MULTICHAR_CONSTANT32('H','T','T','P') &&
+                status >= 200                                                          &&
+                status  < 400);
+
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
+   if (n == -1 &&
+       errno == EAGAIN)
+      {
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
+   setResult(false);
+
+   U_RETURN(U_NOTIFIER_OK);
+}
+
+void UProxyProbe::handlerDelete()
+{
+   U_TRACE_NO_PARAM(0, "UProxyProbe::handlerDelete()")
+
+   // NB: the probe is owned by the health check, not by the notifier...
+
+   UEventFd::fd = -1;
+
+   setResult(false);
+}
+
+UProxyHealthCheck::UProxyHealthCheck(UModProxyService* service) : UEventTime(service->getHealthInterval(), 0L)
+{
+   U_TRACE_CTOR(0, UProxyHealthCheck, "%p", service)
+
+   UProxyProbe* probe;
+
+   next   = U_NULLPTR;
+   probes = U_NULLPTR;
+
+   for (uint32_t i = 0, n = service->getUpstreamNum(); i < n; ++i)
+      {
+      U_NEW(UProxyProbe, probe, UProxyProbe(service, service->getUpstream(i)));
+
+      probe->next = probes;
+                    probes = probe;
+      }
+}
+
+UProxyHealthCheck::~UProxyHealthCheck()
+{
+   U_TRACE_DTOR(0, UProxyHealthCheck)
+
+   UProxyProbe* probe;
+
+   while ((probe = probes))
+      {
+      probes = probe->next;
+
+      U_DELETE(probe)
+      }
+}
+
+int UProxyHealthCheck::handlerTime()
+{
+   U_TRACE_NO_PARAM(0, "UProxyHealthCheck::handlerTime()")
+
+   for (UProxyProbe* probe = probes; probe; probe = probe->next) probe->start();
+
+   U_RETURN(0); // monitoring
+}
 
 UProxyPlugIn::UProxyPlugIn()
 {
@@ -39,7 +1546,27 @@ UProxyPlugIn::~UProxyPlugIn()
 {
    U_TRACE_DTOR(0, UProxyPlugIn)
 
+   UProxyHealthCheck* phealth;
+
+   while ((phealth = health))
+      {
+      health = phealth->next;
+
+      UTimer::erase(phealth);
+
+      U_DELETE(phealth)
+      }
+
+   if (timeout)
+      {
+      UTimer::erase(timeout);
+
+      U_DELETE(timeout)
+      }
+
    if (client_http) U_DELETE(client_http)
+
+   UProxyConnection::clear();
 }
 
 // Server-wide hooks
@@ -60,6 +1587,73 @@ int UProxyPlugIn::handlerInit()
 
    U_NEW(UHttpClient<UTCPSocket>, client_http, UHttpClient<UTCPSocket>((UFileConfig*)U_NULLPTR));
 
+   UClientImage_Base::callerHandlerDelete = UProxyConnection::handlerDeleteClient;
+
+   U_RETURN(U_PLUGIN_HANDLER_PROCESSED);
+}
+
+int UProxyPlugIn::handlerRun()
+{
+   U_TRACE_NO_PARAM(0, "UProxyPlugIn::handlerRun()")
+
+   // NB: we resolve the address of the upstream before the fork, the resolution of a name in the event loop of the worker would block it...
+
+   if (UHTTP::vservice)
+      {
+      UModProxyUpstream* up;
+
+      for (uint32_t i = 0, n = UHTTP::vservice->size(); i < n; ++i)
+         {
+         UModProxyService* service = (*UHTTP::vservice)[i];
+
+         for (uint32_t j = 0, k = service->getUpstreamNum(); j < k; ++j)
+            {
+            up = service->getUpstream(j);
+
+            if (up->pool == U_NULLPTR)
+               {
+               up->pool = UProxyConnection::getPool(up->server, up->port);
+
+               if (up->pool->bresolved == false) U_WARNING("proxy: unable to resolve the address of the upstream %V", up->server.rep);
+               }
+            }
+         }
+      }
+
+   U_RETURN(U_PLUGIN_HANDLER_PROCESSED);
+}
+
+int UProxyPlugIn::handlerFork()
+{
+   U_TRACE_NO_PARAM(0, "UProxyPlugIn::handlerFork()")
+
+   // NB: the health of the upstream is tracked by every worker, so every worker do its active health check...
+
+   if (UHTTP::vservice)
+      {
+      U_NEW(UProxyTimeout, timeout, UProxyTimeout);
+
+      UTimer::insert(timeout);
+
+      UProxyHealthCheck* phealth;
+
+      for (uint32_t i = 0, n = UHTTP::vservice->size(); i < n; ++i)
+         {
+         UModProxyService* service = (*UHTTP::vservice)[i];
+
+         if (service->isHealthCheck() &&
+             service->isDynamicServer() == false)
+            {
+            U_NEW(UProxyHealthCheck, phealth, UProxyHealthCheck(service));
+
+            phealth->next = health;
+                            health = phealth;
+
+            UTimer::insert(phealth);
+            }
+         }
+      }
+
    U_RETURN(U_PLUGIN_HANDLER_PROCESSED);
 }
 
@@ -71,6 +1665,28 @@ int UProxyPlugIn::handlerRequest()
 
    if (UHTTP::isProxyRequest() == false) U_RETURN(U_PLUGIN_HANDLER_OK);
 
+   UString server = UHTTP::service->getServer();
+   unsigned int port = UHTTP::service->getPort();
+
+   if (UProxyConnection::isAsync(server))
+      {
+      // NB: the response is streamed by the event loop of the worker, we don't wait for the upstream...
+
+      if (UProxyConnection::start(UServer_Base::pClientImage, server) == false) UHTTP::setServiceUnavailable();
+
+      U_RETURN(U_PLUGIN_HANDLER_PROCESSED);
+      }
+
+   // NB: we choose the upstream before the fork, so the balance of the service is done by the parent...
+
+   if (UHTTP::service->isDynamicServer() == false)
+      {
+      UModProxyUpstream* up = UHTTP::service->selectUpstream();
+
+      server = up->server;
+      port   = up->port;
+      }
+
    // NB: process the HTTP PROXY request with fork....
 
    if (UServer_Base::startParallelization()) U_RETURN(U_PLUGIN_HANDLER_PROCESSED); // parent
@@ -130,7 +1746,7 @@ int UProxyPlugIn::handlerRequest()
       {
       // before connect to server check if server and/or port to connect has changed...
 
-      if (client_http->setHostPort(UHTTP::service->getServer(), UHTTP::service->getPort()) &&
+      if (client_http->setHostPort(server, port) &&
           client_http->UClient_Base::isConnected())
          {
          client_http->UClient_Base::close();
@@ -231,4 +1847,77 @@ const char* UProxyPlugIn::dump(bool reset) const
 
    return U_NULLPTR;
 }
+
+const char* UProxyPool::dump(bool reset) const
+{
+   *UObjectIO::os << "port                               " << port          << '\n'
+                  << "nidle                              " << nidle         << '\n'
+                  << "bresolved                          " << bresolved     << '\n'
+                  << "next        (UProxyPool            " << (void*)next   << ")\n"
+                  << "idle        (UProxyConnection      " << (void*)idle   << ")\n"
+                  << "addr        (UIPAddress            " << (void*)&addr  << ")\n"
+                  << "server      (UString               " << (void*)&server << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+
+const char* UProxyProbe::dump(bool reset) const
+{
+   *UObjectIO::os << "rlen                               " << rlen                 << '\n'
+                  << "woffset                            " << woffset              << '\n'
+                  << "next        (UProxyProbe           " << (void*)next          << ")\n"
+                  << "socket      (UTCPSocket            " << (void*)socket        << ")\n"
+                  << "request     (UString               " << (void*)&request      << ")\n"
+                  << "upstream    (UModProxyUpstream     " << (void*)upstream      << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+
+const char* UProxyConnection::dump(bool reset) const
+{
+   *UObjectIO::os << "state                              " << state                << '\n'
+                  << "ntry                               " << ntry                 << '\n'
+                  << "remain                             " << remain               << '\n'
+                  << "last_event                         " << last_event           << '\n'
+                  << "woffset                            " << woffset              << '\n'
+                  << "roffset                            " << roffset              << '\n'
+                  << "nparsed                            " << nparsed              << '\n'
+                  << "bhead                              " << bhead                << '\n'
+                  << "bclose                             " << bclose               << '\n'
+                  << "breused                            " << breused              << '\n'
+                  << "bkeepalive                         " << bkeepalive           << '\n'
+                  << "bwebsocket                         " << bwebsocket           << '\n'
+                  << "bidempotent                        " << bidempotent          << '\n'
+                  << "pool        (UProxyPool            " << (void*)pool          << ")\n"
+                  << "service     (UModProxyService      " << (void*)service       << ")\n"
+                  << "upstream    (UModProxyUpstream     " << (void*)upstream      << ")\n"
+                  << "socket      (UTCPSocket            " << (void*)socket        << ")\n"
+                  << "pclient     (UClientImage_Base     " << (void*)pclient       << ")\n"
+                  << "wbuffer     (UString               " << (void*)&wbuffer      << ")\n"
+                  << "pending     (UString               " << (void*)&pending      << ")\n"
+                  << "rbuffer     (UString               " << (void*)&rbuffer      << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
 #endif
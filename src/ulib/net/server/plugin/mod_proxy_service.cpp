@@ -18,25 +18,271 @@
 #include <ulib/utility/services.h>
 #include <ulib/net/server/server.h>
 #include <ulib/utility/string_ext.h>
+#include <ulib/container/hash_map.h>
 #include <ulib/net/server/plugin/mod_proxy_service.h>
 
+#define U_PROXY_RING_POINTS 160 // NB: the points on the ring of the consistent hash for every upstream...
+
+/**
+ * A node of the prefix trie of the uri. Every node keep the services whose uri mask start with the prefix
+ * that lead to the node, so to find the service we walk the trie with the uri of the request and we check
+ * only the services found on the path...
+ */
+
+class U_NO_EXPORT UModProxyTrie {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UVector<void*> vservice; // NB: in order of configuration...
+   UModProxyTrie* child;
+   UModProxyTrie* sibling;
+   unsigned char c;
+
+   UModProxyTrie(unsigned char _c = 0) : vservice(4U)
+      {
+      U_TRACE_CTOR(0, UModProxyTrie, "%C", _c)
+
+      child   =
+      sibling = U_NULLPTR;
+      c       = _c;
+      }
+
+   ~UModProxyTrie()
+      {
+      U_TRACE_DTOR(0, UModProxyTrie)
+
+      if (child)   U_DELETE(child)
+      if (sibling) U_DELETE(sibling)
+      }
+
+   void insert(const UString& prefix, UModProxyService* service)
+      {
+      U_TRACE(0, "UModProxyTrie::insert(%V,%p)", prefix.rep, service)
+
+      UModProxyTrie* node = this;
+
+      for (const unsigned char* ptr = (const unsigned char*)prefix.data(), *end = ptr + prefix.size(); ptr < end; ++ptr)
+         {
+         UModProxyTrie* next = node->child;
+
+         while (next &&
+                next->c != *ptr)
+            {
+            next = next->sibling;
+            }
+
+         if (next == U_NULLPTR)
+            {
+            U_NEW(UModProxyTrie, next, UModProxyTrie(*ptr));
+
+            next->sibling = node->child;
+            node->child   = next;
+            }
+
+         node = next;
+         }
+
+      node->vservice.push_back(service);
+      }
+
+   UModProxyService* find(const char* host, uint32_t host_len, const char* uri, uint32_t uri_len, UModProxyService* best)
+      {
+      U_TRACE(0, "UModProxyTrie::find(%.*S,%u,%.*S,%u,%p)", host_len, host, host_len, uri_len, uri, uri_len, best)
+
+      UModProxyTrie* node = this;
+      const unsigned char* ptr = (const unsigned char*)uri;
+      const unsigned char* end = ptr + uri_len;
+
+      while (true)
+         {
+         for (uint32_t i = 0, n = node->vservice.size(); i < n; ++i)
+            {
+            UModProxyService* elem = (UModProxyService*) node->vservice.at(i);
+
+            if (best &&
+                best->index <= elem->index)
+               {
+               break;
+               }
+
+            if (elem->isMatch(host, host_len, uri, uri_len))
+               {
+               best = elem;
+
+               break;
+               }
+            }
+
+         if (ptr >= end) break;
+
+         node = node->child;
+
+         while (node &&
+                node->c != *ptr)
+            {
+            node = node->sibling;
+            }
+
+         if (node == U_NULLPTR) break;
+
+         ++ptr;
+         }
+
+      U_RETURN_POINTER(best, UModProxyService);
+      }
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool _reset) const { return vservice.dump(_reset); }
+#endif
+
+private:
+   U_DISALLOW_ASSIGN(UModProxyTrie)
+};
+
+UModProxyTrie*             UModProxyService::tany;
+UHashMap<UModProxyTrie*>*  UModProxyService::thost;
+
+void UModProxyUpstream::setFailure(uint32_t max_fails)
+{
+   U_TRACE(0, "UModProxyUpstream::setFailure(%u)", max_fails)
+
+   // NB: with MAX_FAILS 0 the passive health check is disabled...
+
+   if (++nfail >= max_fails &&
+       max_fails)
+      {
+      bdown     = true;
+      fail_time = u_now->tv_sec;
+      }
+}
+
 UModProxyService::UModProxyService()
 {
    U_TRACE_CTOR(0, UModProxyService, "")
 
+   ring = U_NULLPTR;
    command = U_NULLPTR;
    vremote_address = U_NULLPTR;
    port = method_mask = 0;
-   request_cert = follow_redirects = response_client = websocket = false;
+   balance = ROUND_ROBIN;
+   index = nring = ring_size = rr = 0;
+   max_fails = 3;
+   fail_timeout = 10;
+   health_interval = 5;
+   connect_timeout = 5;
+   read_timeout = 60;
+   idle_timeout = 300;
+   request_cert = follow_redirects = response_client = websocket = bhash_uri = false;
 }
 
 UModProxyService::~UModProxyService()
 {
    U_TRACE_DTOR(0, UModProxyService)
 
+   if (ring) UMemoryPool::_free(ring, ring_size, sizeof(uint64_t));
+
    if (vremote_address) U_DELETE(vremote_address)
 }
 
+void UModProxyService::clear()
+{
+   U_TRACE_NO_PARAM(0, "UModProxyService::clear()")
+
+   if (tany)
+      {
+      U_DELETE(tany)
+
+      tany = U_NULLPTR;
+      }
+
+   if (thost)
+      {
+      U_DELETE(thost)
+
+      thost = U_NULLPTR;
+      }
+}
+
+static int cmp_point(const void* a, const void* b)
+{
+   U_TRACE(0, "cmp_point(%p,%p)", a, b)
+
+   uint64_t x = *(const uint64_t*)a,
+            y = *(const uint64_t*)b;
+
+   return (x < y ? -1 : (x > y));
+}
+
+void UModProxyService::setUpstream(const UString& x)
+{
+   U_TRACE(0, "UModProxyService::setUpstream(%V)", x.rep)
+
+   // SERVER "10.0.0.1:8080 10.0.0.2:8080 backend" (the port of the upstream without it is PORT)
+
+   UString name;
+   uint32_t pos, n;
+   UModProxyUpstream* up;
+   UVector<UString> vec(x, ", \t\r\n");
+
+   for (uint32_t i = 0; i < vec.size(); ++i)
+      {
+      name = vec[i];
+      pos  = name.find(':');
+
+      if (pos == U_NOT_FOUND ||
+          name.find(':', pos+1) != U_NOT_FOUND) // NB: IPv6 address without port...
+         {
+         U_NEW(UModProxyUpstream, up, UModProxyUpstream(name.copy(), port)); // NB: the vector use substr() of the configuration...
+         }
+      else
+         {
+         U_NEW(UModProxyUpstream, up, UModProxyUpstream(name.substr(0U, pos).copy(), name.substr(pos+1).strtoul()));
+         }
+
+      vupstream.push_back(up);
+      }
+
+   n = vupstream.size();
+
+   if (n)
+      {
+      // NB: getServer() and getPort() return the first upstream...
+
+      server = vupstream[0]->server;
+      port   = vupstream[0]->port;
+
+      if (balance == HASH)
+         {
+         char buffer[512];
+         uint32_t k = 0, len;
+
+         nring = ring_size = n * U_PROXY_RING_POINTS;
+
+         ring = (uint64_t*) UMemoryPool::pmalloc(&ring_size, sizeof(uint64_t));
+
+         for (uint32_t i = 0; i < n; ++i)
+            {
+            up = vupstream[i];
+
+            for (uint32_t j = 0; j < U_PROXY_RING_POINTS; ++j)
+               {
+               len = u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("%v:%d#%u"), up->server.rep, up->port, j);
+
+               ring[k++] = ((uint64_t)u_hash((unsigned char*)buffer, len) << 32) | i;
+               }
+            }
+
+         U_SYSCALL_VOID(qsort, "%p,%u,%d,%p", ring, nring, sizeof(uint64_t), cmp_point);
+         }
+      }
+}
+
 bool UModProxyService::loadConfig(UFileConfig& cfg)
 {
    U_TRACE(0, "UModProxyService::loadConfig(%p)", &cfg)
@@ -58,7 +304,18 @@ bool UModProxyService::loadConfig(UFileConfig& cfg)
    // RESPONSE_TYPE        output type of the command (yes = response for client, no = request to server)
    //
    // PORT                 port of server for connection
-   // SERVER               name of server for connection
+   // SERVER               name of server for connection (or list of upstream name[:port] separated by space or comma)
+   //
+   // BALANCE              policy to choose the upstream of the list (round-robin|least-conn|hash)
+   // HASH_KEY             key of the consistent hash (ip|uri)
+   // MAX_FAILS            number of consecutive errors that put down the upstream (0 => disable passive health check)
+   // FAIL_TIMEOUT         seconds after which we try again a down upstream (without active health check)
+   // HEALTH_CHECK         uri for the active health check of the upstream (a 2xx/3xx response means up)
+   // HEALTH_INTERVAL      seconds between the active health check
+   //
+   // CONNECT_TIMEOUT      seconds to establish the connection with the upstream (0 => disable)
+   // READ_TIMEOUT         seconds without progress of the response (from the upstream or to the client) before we give up (0 => disable)
+   // IDLE_TIMEOUT         seconds without data in both directions after which we close a WebSocket tunnel (0 => disable)
    //
    // FOLLOW_REDIRECTS     yes if     manage to automatically follow redirects from server
    // USER                     if     manage to follow redirects, in response to a HTTP_UNAUTHORISED response from the HTTP server: user
@@ -103,7 +360,7 @@ bool UModProxyService::loadConfig(UFileConfig& cfg)
       if (cfg.loadTable())
          {
          service->user      = cfg.at(U_CONSTANT_TO_PARAM("USER"));
-         service->server    = cfg.at(U_CONSTANT_TO_PARAM("SERVER"));;
+         service->server    = cfg.at(U_CONSTANT_TO_PARAM("SERVER"));
          service->password  = cfg.at(U_CONSTANT_TO_PARAM("PASSWORD"));
          service->host_mask = cfg.at(U_CONSTANT_TO_PARAM("HOST"));
 
@@ -113,6 +370,38 @@ bool UModProxyService::loadConfig(UFileConfig& cfg)
          service->response_client  = cfg.readBoolean(U_CONSTANT_TO_PARAM("RESPONSE_TYPE"));
          service->follow_redirects = cfg.readBoolean(U_CONSTANT_TO_PARAM("FOLLOW_REDIRECTS"));
 
+         service->max_fails        = cfg.readLong(U_CONSTANT_TO_PARAM("MAX_FAILS"), 3);
+         service->fail_timeout     = cfg.readLong(U_CONSTANT_TO_PARAM("FAIL_TIMEOUT"), 10);
+         service->health_uri       = cfg.at(U_CONSTANT_TO_PARAM("HEALTH_CHECK"));
+         service->health_interval  = cfg.readLong(U_CONSTANT_TO_PARAM("HEALTH_INTERVAL"), 5);
+
+         if (service->health_interval == 0) service->health_interval = 1;
+
+         service->connect_timeout  = cfg.readLong(U_CONSTANT_TO_PARAM("CONNECT_TIMEOUT"), 5);
+         service->read_timeout     = cfg.readLong(U_CONSTANT_TO_PARAM("READ_TIMEOUT"), 60);
+         service->idle_timeout     = cfg.readLong(U_CONSTANT_TO_PARAM("IDLE_TIMEOUT"), 300);
+
+         x = cfg.at(U_CONSTANT_TO_PARAM("BALANCE"));
+
+         if (x)
+            {
+                 if (x.equal(U_CONSTANT_TO_PARAM("least-conn"))) service->balance = LEAST_CONN;
+            else if (x.equal(U_CONSTANT_TO_PARAM("hash")))       service->balance = HASH;
+            }
+
+         x = cfg.at(U_CONSTANT_TO_PARAM("HASH_KEY"));
+
+         if (x) service->bhash_uri = x.equal(U_CONSTANT_TO_PARAM("uri"));
+
+         // NB: SERVER $<... and SERVER ~... depend on the request, so we don't have upstream...
+
+         if (service->server &&
+             service->server.first_char() != '~' &&
+             u_get_unalignedp16(service->server.data()) != U_MULTICHAR_CONSTANT16('$','<'))
+            {
+            service->setUpstream(service->server);
+            }
+
          x = cfg.at(U_CONSTANT_TO_PARAM("URI"));
 
          if (x)
@@ -188,15 +477,23 @@ loop:       switch (u_get_unalignedp32(msk))
                }
             }
 
+         service->index = UHTTP::vservice->size();
+
          UHTTP::vservice->push_back(service);
 
-         cfg.clear();
+         cfg.table.clear(); // NB: cfg.clear() deallocate the table and we need it for the next service...
+         }
+      else
+         {
+         U_DELETE(service)
          }
-
-      U_RETURN(true);
       }
 
-   U_RETURN(false);
+   if (UHTTP::vservice->empty()) U_RETURN(false);
+
+   compile();
+
+   U_RETURN(true);
 }
 
 __pure UModProxyService* UModProxyService::findService()
@@ -214,6 +511,27 @@ __pure UModProxyService* UModProxyService::findService()
    return findService(U_HTTP_HOST_TO_PARAM, ptr, sz);
 }
 
+bool UModProxyService::isMatch(const char* host, uint32_t host_len, const char* uri, uint32_t uri_len)
+{
+   U_TRACE(0, "UModProxyService::isMatch(%.*S,%u,%.*S,%u)", host_len, host, host_len, uri_len, uri, uri_len)
+
+   U_INTERNAL_DUMP("host_mask = %V method_mask = %B", host_mask.rep, method_mask)
+
+   if ((method_mask     == 0         || (U_http_method_type & method_mask) != 0)                                              &&
+       (vremote_address == U_NULLPTR || UClientImage_Base::isAllowed(*vremote_address))                                       &&
+       (host_mask.empty()            || (host_len && UServices::dosMatchWithOR(host, host_len, U_STRING_TO_PARAM(host_mask), 0))) &&
+#  ifdef USE_LIBPCRE
+       (uri_mask.getPcre() == U_NULLPTR || uri_mask.search(uri, uri_len)))
+#  else
+       (uri_mask.empty()                || UServices::dosMatchWithOR(uri, uri_len, U_STRING_TO_PARAM(uri_mask), 0)))
+#  endif
+      {
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
 __pure UModProxyService* UModProxyService::findService(const char* host, uint32_t host_len, const char* uri, uint32_t uri_len)
 {
    U_TRACE(0, "UModProxyService::findService(%.*S,%u,%.*S,%u)", host_len, host, host_len, uri_len, uri, uri_len)
@@ -221,29 +539,285 @@ __pure UModProxyService* UModProxyService::findService(const char* host, uint32_
    if (UHTTP::vservice &&
        host_len <= 255)
       {
-      for (uint32_t i = 0, n = UHTTP::vservice->size(); i < n; ++i)
+      if (tany == U_NULLPTR)
          {
-         UModProxyService* elem = (*UHTTP::vservice)[i];
-
-         U_INTERNAL_DUMP("host_mask = %V method_mask = %B", elem->host_mask.rep, elem->method_mask)
-
-         if ((elem->method_mask     == 0         || (U_http_method_type & elem->method_mask) != 0)                                                   &&
-             (elem->vremote_address == U_NULLPTR || UClientImage_Base::isAllowed(*(elem->vremote_address)))                                          &&
-             (elem->host_mask.empty()            || (host_len && UServices::dosMatchWithOR(host, host_len, U_STRING_TO_PARAM(elem->host_mask),  0))) &&
-#           ifdef USE_LIBPCRE
-             (elem->uri_mask.getPcre() == U_NULLPTR || elem->uri_mask.search(uri, uri_len)))
-#           else
-             (elem->uri_mask.empty()                || UServices::dosMatchWithOR(uri, uri_len, U_STRING_TO_PARAM(elem->uri_mask), 0)))
-#           endif
+         for (uint32_t i = 0, n = UHTTP::vservice->size(); i < n; ++i)
             {
-            U_RETURN_POINTER(elem, UModProxyService);
+            UModProxyService* elem = (*UHTTP::vservice)[i];
+
+            if (elem->isMatch(host, host_len, uri, uri_len)) U_RETURN_POINTER(elem, UModProxyService);
             }
+
+         U_RETURN_POINTER(U_NULLPTR, UModProxyService);
          }
+
+      // NB: the first service (in order of configuration) that match between the one for the host and the one for any host...
+
+      UModProxyTrie* trie;
+      UModProxyService* elem = U_NULLPTR;
+
+      if (host_len &&
+          (trie = thost->at(host, host_len)))
+         {
+         elem = trie->find(host, host_len, uri, uri_len, U_NULLPTR);
+         }
+
+      elem = tany->find(host, host_len, uri, uri_len, elem);
+
+      U_RETURN_POINTER(elem, UModProxyService);
       }
 
    U_RETURN_POINTER(U_NULLPTR, UModProxyService);
 }
 
+UString UModProxyService::getUriPrefix(const UString& mask)
+{
+   U_TRACE(0, "UModProxyService::getUriPrefix(%V)", mask.rep)
+
+   // NB: we need a prefix that every uri matched by the mask must have (the empty prefix is always valid)...
+
+   UString prefix;
+   const char* ptr = mask.data();
+   const char* end = mask.pend();
+
+#ifdef USE_LIBPCRE
+   // ^/webmail/src/login\.php$ => /webmail/src/login.php
+
+   if (ptr == end ||
+       *ptr != '^')
+      {
+      U_RETURN_STRING(prefix);
+      }
+
+   int depth = 0;
+
+   for (const char* p = ptr; p < end; ++p) // NB: an alternative at the top level invalidate the prefix...
+      {
+      switch (*p)
+         {
+         case '\\': ++p;    break;
+         case '(':  ++depth; break;
+         case ')':  --depth; break;
+
+         case '|': if (depth <= 0) U_RETURN_STRING(prefix); break;
+
+         case '[':
+            {
+            if (p+1 < end && p[1] == '^') ++p;
+            if (p+1 < end && p[1] == ']') ++p;
+
+            while (++p < end && *p != ']') {}
+            }
+         break;
+         }
+      }
+
+   for (++ptr; ptr < end; ++ptr)
+      {
+      char c = *ptr;
+
+      if (c == '\\')
+         {
+         if (++ptr >= end ||
+             u__isalnum(*ptr)) // \d, \w, \s, ...
+            {
+            break;
+            }
+
+         prefix.push_back(*ptr);
+
+         continue;
+         }
+
+      if (strchr(".[]()|*+?{}^$", c))
+         {
+         if (prefix &&
+             (c == '?' || c == '*' || c == '{')) // NB: the quantifier is about the previous char...
+            {
+            prefix.size_adjust(prefix.size()-1);
+            }
+
+         break;
+         }
+
+      prefix.push_back(c);
+      }
+#else
+   // /webmail/* => /webmail/
+
+   if (memchr(ptr, '|', mask.size()) == U_NULLPTR)
+      {
+      while (ptr < end && *ptr != '*' && *ptr != '?') ++ptr;
+
+      if (ptr > mask.data()) prefix = mask.substr(0U, ptr - mask.data());
+      }
+#endif
+
+   U_RETURN_STRING(prefix);
+}
+
+void UModProxyService::compile()
+{
+   U_TRACE_NO_PARAM(0, "UModProxyService::compile()")
+
+   U_INTERNAL_ASSERT_POINTER(UHTTP::vservice)
+
+   clear();
+
+   U_NEW(UModProxyTrie, tany, UModProxyTrie);
+   U_NEW(UHashMap<UModProxyTrie*>, thost, UHashMap<UModProxyTrie*>);
+
+   UString prefix;
+   UModProxyTrie* trie;
+
+   for (uint32_t i = 0, n = UHTTP::vservice->size(); i < n; ++i)
+      {
+      UModProxyService* elem = (*UHTTP::vservice)[i];
+
+#  ifdef USE_LIBPCRE
+      prefix = (elem->uri_mask.getPcre() ? getUriPrefix(elem->uri_mask.getMask()) : UString::getStringNull());
+#  else
+      prefix = (elem->uri_mask           ? getUriPrefix(elem->uri_mask)           : UString::getStringNull());
+#  endif
+
+      // NB: a host mask without wildcard is a list of host separated by '|'...
+
+      if (elem->host_mask.empty() ||
+          elem->host_mask.find_first_of("*?", 0, 2) != U_NOT_FOUND)
+         {
+         tany->insert(prefix, elem);
+
+         continue;
+         }
+
+      const char* ptr = elem->host_mask.data();
+      const char* end = elem->host_mask.pend();
+
+      while (ptr < end)
+         {
+         const char* p = (const char*) memchr(ptr, '|', end - ptr);
+
+         if (p == U_NULLPTR) p = end;
+
+         if (p > ptr)
+            {
+            trie = thost->at(ptr, p - ptr);
+
+            if (trie == U_NULLPTR)
+               {
+               U_NEW(UModProxyTrie, trie, UModProxyTrie);
+
+               thost->insert(ptr, p - ptr, trie);
+               }
+
+            trie->insert(prefix, elem);
+            }
+
+         ptr = p + 1;
+         }
+      }
+}
+
+__pure bool UModProxyService::isAvailable(UModProxyUpstream* up, UModProxyUpstream* exclude) const
+{
+   U_TRACE(0, "UModProxyService::isAvailable(%p,%p)", up, exclude)
+
+   if (up != exclude &&
+       (up->bdown == false ||
+        (isHealthCheck() == false && (u_now->tv_sec - up->fail_time) >= (time_t)fail_timeout))) // NB: without active health check we try again after FAIL_TIMEOUT...
+      {
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+UModProxyUpstream* UModProxyService::selectUpstream(UModProxyUpstream* exclude)
+{
+   U_TRACE(0, "UModProxyService::selectUpstream(%p)", exclude)
+
+   uint32_t k, n = vupstream.size();
+   UModProxyUpstream* up;
+   UModProxyUpstream* result = U_NULLPTR;
+
+   if (n == 0) U_RETURN_POINTER(U_NULLPTR, UModProxyUpstream);
+
+   if (balance == HASH)
+      {
+      uint32_t h, sz;
+      const char* ptr;
+
+      if (bhash_uri) ptr = UClientImage_Base::getRequestUri(sz);
+      else
+         {
+         ptr = UServer_Base::client_address;
+         sz  = UServer_Base::client_address_len;
+         }
+
+      h = u_hash((unsigned char*)ptr, sz);
+
+      // NB: the first point of the ring after the hash of the key...
+
+      uint64_t key = (uint64_t)h << 32;
+      uint32_t lo = 0, hi = nring, mid;
+
+      while (lo < hi)
+         {
+         mid = (lo + hi) / 2;
+
+         if (ring[mid] < key) lo = mid + 1;
+         else                 hi = mid;
+         }
+
+      for (k = 0; k < nring; ++k)
+         {
+         up = vupstream[(uint32_t)ring[(lo + k) % nring]];
+
+         if (isAvailable(up, exclude))
+            {
+            result = up;
+
+            break;
+            }
+         }
+      }
+   else
+      {
+      for (k = 0; k < n; ++k)
+         {
+         up = vupstream[(rr + k) % n];
+
+         if (isAvailable(up, exclude) &&
+             (result == U_NULLPTR ||
+              (balance == LEAST_CONN && up->nconn < result->nconn)))
+            {
+            result = up;
+
+            if (balance == ROUND_ROBIN) break;
+            }
+         }
+
+      ++rr;
+      }
+
+   if (result == U_NULLPTR) // NB: all the upstream are down, we try anyway another one...
+      {
+      for (k = 0; k < n; ++k)
+         {
+         up = vupstream[(rr + k) % n];
+
+         if (up != exclude)
+            {
+            result = up;
+
+            break;
+            }
+         }
+      }
+
+   U_RETURN_POINTER(result, UModProxyUpstream);
+}
+
 #define U_SRV_ADDR_FMT "%v/%.*s:%u.srv"
 
 bool UModProxyService::setServerAddress(const UString& dir, const char* address, uint32_t address_len)
@@ -347,11 +921,45 @@ void UModProxyService::setMsgError(int err)
 }
 
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
-const char* UModProxyService::dump(bool reset) const
+const char* UModProxyUpstream::dump(bool reset) const
 {
    U_CHECK_MEMORY
 
    *UObjectIO::os << "port                                 " << port                      << '\n'
+                  << "pool                                 " << (void*)pool               << '\n'
+                  << "bdown                                " << bdown                     << '\n'
+                  << "nconn                                " << nconn                     << '\n'
+                  << "nfail                                " << nfail                     << '\n'
+                  << "fail_time                            " << fail_time                 << '\n'
+                  << "server            (UString           " << (void*)&server            << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+
+const char* UModProxyService::dump(bool reset) const
+{
+   U_CHECK_MEMORY
+
+   *UObjectIO::os << "rr                                   " << rr                        << '\n'
+                  << "ring                                 " << (void*)ring               << '\n'
+                  << "port                                 " << port                      << '\n'
+                  << "index                                " << index                     << '\n'
+                  << "nring                                " << nring                     << '\n'
+                  << "balance                              " << balance                   << '\n'
+                  << "bhash_uri                            " << bhash_uri                 << '\n'
+                  << "max_fails                            " << max_fails                 << '\n'
+                  << "fail_timeout                         " << fail_timeout              << '\n'
+                  << "health_interval                      " << health_interval           << '\n'
+                  << "read_timeout                         " << read_timeout              << '\n'
+                  << "idle_timeout                         " << idle_timeout              << '\n'
+                  << "connect_timeout                      " << connect_timeout           << '\n'
                   << "websocket                            " << websocket                 << '\n'
                   << "method_mask                          " << method_mask               << '\n'
                   << "request_cert                         " << request_cert              << '\n'
@@ -366,7 +974,9 @@ const char* UModProxyService::dump(bool reset) const
                   << "server            (UString           " << (void*)&server            << ")\n"
                   << "host_mask         (UString           " << (void*)&host_mask         << ")\n"
                   << "password          (UString           " << (void*)&password          << ")\n"
+                  << "health_uri        (UString           " << (void*)&health_uri        << ")\n"
                   << "environment       (UString           " << (void*)&environment       << ")\n"
+                  << "vupstream         (UVector<UModProxyUpstream*> " << (void*)&vupstream << ")\n"
                   << "vremote_address   (UVector<UIPAllow> " << (void*)vremote_address    << ")\n"
                   << "vreplace_response (UVector<UString>  " << (void*)&vreplace_response << ')';
 
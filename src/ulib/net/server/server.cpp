@@ -12,6 +12,7 @@
 // ============================================================================
 
 #include <ulib/url.h>
+#include <ulib/cache.h>
 #include <ulib/db/rdb.h>
 #include <ulib/net/udpsocket.h>
 #include <ulib/utility/escape.h>
@@ -108,6 +109,7 @@ int           UServer_Base::iAddressType;
 int           UServer_Base::tcp_linger_set = -2;
 int           UServer_Base::preforked_num_kids;
 bool          UServer_Base::bssl;
+bool          UServer_Base::bktls;
 bool          UServer_Base::bipc;
 bool          UServer_Base::budp;
 bool          UServer_Base::brng;
@@ -117,6 +119,7 @@ bool          UServer_Base::flag_loop;
 bool          UServer_Base::public_address;
 bool          UServer_Base::monitoring_process;
 bool          UServer_Base::set_tcp_keep_alive;
+bool          UServer_Base::timer_wheel;
 bool          UServer_Base::set_realtime_priority;
 bool          UServer_Base::update_date;
 bool          UServer_Base::update_date1;
@@ -127,6 +130,8 @@ long          UServer_Base::last_time_email_crash;
 char          UServer_Base::mod_name[2][32];
 ULog*         UServer_Base::log;
 ULog*         UServer_Base::apache_like_log;
+uint32_t      UServer_Base::log_ring_size;
+uint32_t      UServer_Base::log_flush_interval;
 char*         UServer_Base::client_address;
 ULock*        UServer_Base::lock_user1;
 ULock*        UServer_Base::lock_user2;
@@ -176,12 +181,16 @@ UServer_Base::shared_data* UServer_Base::ptr_shared_data;
 uint32_t                   UServer_Base::shm_size;
 uint32_t                   UServer_Base::shm_data_add;
 UServer_Base::shm_data*    UServer_Base::ptr_shm_data;
+UShardCache*               UServer_Base::shard_cache;
+UString*                   UServer_Base::shard_cache_path;
+uint32_t                   UServer_Base::shard_cache_size;
 
 UVector<UString>*                 UServer_Base::vplugin_name;
 UVector<UString>*                 UServer_Base::vplugin_name_static;
 UClientImage_Base*                UServer_Base::vClientImage;
 UClientImage_Base*                UServer_Base::pClientImage;
 UClientImage_Base*                UServer_Base::eClientImage;
+UTimeoutClient*                   UServer_Base::vClientTimeout;
 UVector<UEventFd*>*               UServer_Base::handler_other;
 UVector<UServerPlugIn*>*          UServer_Base::vplugin;
 UVector<UServerPlugIn*>*          UServer_Base::vplugin_static;
@@ -271,6 +280,59 @@ UString UServer_Base::getStats()
                (float) UServer_Base::stats_connections / U_ONE_HOUR_IN_SECOND, UServer_Base::stats_simultaneous, UNotifier::nwatches, U_WHICH,
                (float) UNotifier::nwatches / U_ONE_HOUR_IN_SECOND, UStringExt::printSize(UServer_Base::stats_bytes).rep);
 
+   if (URDB::ncompaction)
+      {
+      x.snprintf_add(U_CONSTANT_TO_PARAM(", %u db compaction by this process (%ld ms, %ld ms with lock) - %v reclaimed"),
+                     URDB::ncompaction, URDB::compaction_time, URDB::compaction_lock_time, UStringExt::printSize(URDB::compaction_reclaimed).rep);
+      }
+
+   if (UServer_Base::shard_cache)
+      {
+      UShardCache::cache_shard_stats total;
+
+      UServer_Base::shard_cache->getStats(total);
+
+      x.snprintf_add(U_CONSTANT_TO_PARAM(", shared cache: %llu hits %llu misses %llu evictions"), total.hits, total.misses, total.evictions);
+      }
+
+#ifdef USE_LIBSSL
+   if (USSLSocket::stats_handshake)
+      {
+      x.snprintf_add(U_CONSTANT_TO_PARAM(", %u SSL handshake (%u resumed, %5.2f%%) - %llu us/handshake of CPU"), USSLSocket::stats_handshake, USSLSocket::stats_resumed,
+                     (float) USSLSocket::stats_resumed * 100 / USSLSocket::stats_handshake, USSLSocket::stats_handshake_time / USSLSocket::stats_handshake);
+
+      if (bktls) x.snprintf_add(U_CONSTANT_TO_PARAM(", %u with kTLS"), USSLSocket::stats_ktls);
+      }
+
+   if (USSLSocket::stats_handshake_failed)
+      {
+      x.snprintf_add(U_CONSTANT_TO_PARAM(", %u SSL handshake failed - %llu us of CPU"), USSLSocket::stats_handshake_failed, USSLSocket::stats_handshake_failed_time);
+      }
+#endif
+
+#ifdef U_THROTTLING_SUPPORT
+   for (uint32_t i = 0; i < throttling_num_rule; ++i)
+      {
+      uthrottling_bucket* pbucket = throttling_bucket+i;
+
+      if (pbucket->nrequest ||
+          pbucket->nrefused)
+         {
+         x.snprintf_add(U_CONSTANT_TO_PARAM(", throttle %u: %u request (%u refused) %u sending - %v sent (limit %u kB/s)"), i, pbucket->nrequest, pbucket->nrefused,
+                        pbucket->num_sending, UStringExt::printSize(pbucket->bytes).rep, pbucket->max_limit);
+         }
+      }
+#endif
+
+#ifdef U_EVASIVE_SUPPORT
+   if (evasive_table &&
+       (evasive_table->nblacklist || evasive_table->nevicted))
+      {
+      x.snprintf_add(U_CONSTANT_TO_PARAM(", %u blacklisting (evasive table: %u slot replaced, %u key not tracked)"),
+                     evasive_table->nblacklist, evasive_table->nevicted, evasive_table->nrefused);
+      }
+#endif
+
    U_RETURN_STRING(x);
 }
 
@@ -293,13 +355,25 @@ public:
       {
       U_TRACE_NO_PARAM(0, "UTimeStat::handlerTime()")
 
-      if (UServer_Base::stats_bytes)
+      if (UServer_Base::stats_bytes ||
+          URDB::ncompaction)
          {
          U_DEBUG("%v", UServer_Base::getStats().rep)
 
          UServer_Base::stats_bytes = 0;
+
+         URDB::resetStats();
          }
 
+#  ifdef USE_LIBSSL
+      USSLSocket::stats_ktls                  =
+      USSLSocket::stats_resumed               =
+      USSLSocket::stats_handshake             =
+      USSLSocket::stats_handshake_failed      = 0;
+      USSLSocket::stats_handshake_time        =
+      USSLSocket::stats_handshake_failed_time = 0;
+#  endif
+
       UNotifier::nwatches              =
       UServer_Base::stats_connections  =
       UServer_Base::stats_simultaneous = 0;
@@ -362,7 +436,8 @@ public:
 
       U_INTERNAL_DUMP("UNotifier::num_connection = %u UNotifier::min_connection = %u", UNotifier::num_connection, UNotifier::min_connection)
 
-      if (UNotifier::num_connection > UNotifier::min_connection)
+      if (UNotifier::num_connection > UNotifier::min_connection &&
+          UServer_Base::vClientTimeout == U_NULLPTR) // NB: with TIMER_WHEEL every connection has its own timer...
          {
 #     ifdef USERVER_RNG
          if (UServer_Base::brng)
@@ -405,6 +480,67 @@ private:
    U_DISALLOW_COPY_AND_ASSIGN(UTimeoutConnection)
 };
 
+class U_NO_EXPORT UTimeoutClient : public UEventTime {
+public:
+
+   UTimeoutClient() : UEventTime((UServer_Base::timeoutMS + 999L) / 1000L, 0L) // NB: a timeout under one second must not become 0...
+      {
+      U_TRACE_CTOR(0, UTimeoutClient, "")
+
+      cimg = U_NULLPTR;
+      }
+
+   virtual ~UTimeoutClient() U_DECL_FINAL
+      {
+      U_TRACE_DTOR(0, UTimeoutClient)
+      }
+
+   UClientImage_Base* cimg;
+
+   // define method VIRTUAL of class UEventTime
+
+   virtual int handlerTime() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(0, "UTimeoutClient::handlerTime()")
+
+      U_INTERNAL_ASSERT_POINTER(cimg)
+
+      if (cimg->UEventFd::fd == -1) U_RETURN(-1); // NB: the connection is already closed...
+
+      U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
+
+      if (UServer_Base::isReqTimeout(cimg))
+         {
+#     if !defined(U_LOG_DISABLE) || (!defined(USE_LIBEVENT) && defined(HAVE_EPOLL_WAIT) && defined(DEBUG))
+         UServer_Base::called_from_handlerTime = true;
+#     endif
+
+         if (UServer_Base::handlerTimeoutConnection(cimg))
+            {
+            UNotifier::handlerDelete((UEventFd*)cimg); // NB: it erase also this timer...
+
+            U_RETURN(-1); // normal
+            }
+
+         U_RETURN(0); // monitoring
+         }
+
+      // NB: the connection was active after the insertion of the timer, we check it again at the right time...
+
+      xtime.tv_sec  = cimg->last_event + UTimeVal::tv_sec;
+      xtime.tv_usec = 0L;
+
+      U_RETURN(1); // monitoring (xtime already set)
+      }
+
+#if defined(DEBUG) && defined(U_STDCPP_ENABLE)
+   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
+#endif
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UTimeoutClient)
+};
+
 /**
  * The throttle data lets you set maximum byte rates on URLs or URL groups. You can optionally set a minimum rate too.
  * The format of the throttle data is very simple, should consist of a pattern, whitespace, and a number. The pattern
@@ -417,452 +553,462 @@ private:
  * b) *.jpg|*.gif     50  => limit images to 1/3 of our bandwith
  * c) *.mpg           20  => and movies to even less
  *
- * Throttling is implemented by checking each incoming URL filename against all of the patterns in the throttle data.
- * The server accumulates statistics on how much bandwidth each pattern has accounted for recently (via a rolling average).
- * If a URL matches a pattern that has been exceeding its specified limit, then the data returned is actually slowed down,
- * with pauses between each block. If that's not possible or if the bandwidth has gotten way larger than the limit, then
- * the server returns a special code
+ * Throttling is implemented by checking each incoming URL filename against the patterns in the throttle data. The patterns are
+ * compiled at startup: the ones without wildcard go in a hash table (exact match), the ones as 'prefix*' or '*suffix' are checked
+ * with a memcmp() and only the others are matched with u_dosmatch(), so for each request we get the mask of the matching rules.
+ * Every rule has a token bucket in memory shared by the process (refilled at the max rate with a burst of U_THROTTLE_TIME seconds)
+ * that is charged with the bytes sent and updated only with atomic operation, so no lock is needed. If a URL matches a rule that
+ * is in debt, then the data returned is actually slowed down, with pauses between each block (but never below the minimum rate
+ * of the connection). If the debt has gotten way larger than the burst, then the server returns a special code
  */
 
 #ifdef U_THROTTLING_SUPPORT
-bool                              UServer_Base::throttling_chk;
-UString*                          UServer_Base::throttling_mask;
-UServer_Base::uthrottling*        UServer_Base::throttling_rec;
-URDBObjectHandler<UDataStorage*>* UServer_Base::db_throttling;
+UString*                                UServer_Base::throttling_mask;
+uint32_t                                UServer_Base::throttling_num_rule;
+uint32_t                                UServer_Base::throttling_num_glob;
+UHashMap<void*>*                        UServer_Base::throttling_exact;
+UServer_Base::uthrottling*              UServer_Base::throttling_rec;
+UServer_Base::uthrottling_glob*         UServer_Base::throttling_glob;
+UServer_Base::uthrottling_bucket*       UServer_Base::throttling_bucket;
 
-#define U_THROTTLE_TIME 2 // Time between updates of the throttle table's rolling averages
+#define U_THROTTLE_TIME 2 // Burst (in seconds of max rate) of the token bucket of the rules
 
-class U_NO_EXPORT UBandWidthThrottling : public UEventTime {
+class U_NO_EXPORT UClientThrottling : public UEventTime {
 public:
 
-   UBandWidthThrottling() : UEventTime(U_THROTTLE_TIME, 0L)
+   UClientThrottling(UClientImage_Base* _pClientImage, long sec, long micro_sec) : UEventTime(sec, micro_sec)
       {
-      U_TRACE_CTOR(0, UBandWidthThrottling, "")
+      U_TRACE_CTOR(0, UClientThrottling, "%p,%ld,%ld", _pClientImage, sec, micro_sec)
+
+      UNotifier::suspend(pClientImage = _pClientImage);
       }
 
-   virtual ~UBandWidthThrottling() U_DECL_FINAL
+   virtual ~UClientThrottling() U_DECL_FINAL
       {
-      U_TRACE_DTOR(0, UBandWidthThrottling)
+      U_TRACE_DTOR(0, UClientThrottling)
       }
 
-   // SERVICES
+   // define method VIRTUAL of class UEventTime
 
-   static int clearThrottling(UStringRep* key, UStringRep* data)
+   virtual int handlerTime() U_DECL_FINAL
       {
-      U_TRACE(0, "UBandWidthThrottling::clearThrottling(%p,%p)", key, data)
-
-      if (key)
-         {
-         if (UServices::dosMatchWithOR(U_STRING_TO_PARAM(UServer_Base::pClientImage->uri), U_STRING_TO_PARAM(*key))) U_RETURN(4); // NB: call us later (after set record value from db)
+      U_TRACE_NO_PARAM(0, "UClientThrottling::handlerTime()")
 
-         U_RETURN(1);
-         }
+      UNotifier::resume(pClientImage);
 
-      U_INTERNAL_DUMP("krate = %u min_limit = %u max_limit = %u num_sending = %u bytes_since_avg = %llu", UServer_Base::throttling_rec->krate, UServer_Base::throttling_rec->min_limit,
-                        UServer_Base::throttling_rec->max_limit, UServer_Base::throttling_rec->num_sending, UServer_Base::throttling_rec->bytes_since_avg)
+      U_RETURN(-1); // normal
+      }
 
-      U_INTERNAL_ASSERT_MAJOR(UServer_Base::throttling_rec->num_sending, 0)
+#if defined(DEBUG) && defined(U_STDCPP_ENABLE)
+   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
+#endif
 
-      UServer_Base::throttling_rec->num_sending--;
+protected:
+   UClientImage_Base* pClientImage;
 
-      // NB: db can have different pattern matching the same url...
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UClientThrottling)
+};
 
-      U_RETURN(1);
-      }
+U_NO_EXPORT uint64_t UServer_Base::getThrottlingTime()
+{
+   U_TRACE_NO_PARAM(1, "UServer_Base::getThrottlingTime()")
 
-   static int checkThrottling(UStringRep* key, UStringRep* data)
-      {
-      U_TRACE(0, "UBandWidthThrottling::checkThrottling(%p,%p)", key, data)
+   struct timespec ts;
 
-      if (key)
-         {
-         if (UServices::dosMatchWithOR(U_HTTP_URI_TO_PARAM, U_STRING_TO_PARAM(*key))) U_RETURN(4); // NB: call us later (after set record value from db)...
+   (void) U_SYSCALL(clock_gettime, "%d,%p", CLOCK_MONOTONIC_COARSE, &ts);
 
-         U_RETURN(1);
-         }
+   uint64_t ms = ts.tv_sec * 1000ULL + (ts.tv_nsec / 1000000L);
 
-      U_INTERNAL_DUMP("krate = %u min_limit = %u max_limit = %u num_sending = %u bytes_since_avg = %llu", UServer_Base::throttling_rec->krate, UServer_Base::throttling_rec->min_limit,
-                        UServer_Base::throttling_rec->max_limit, UServer_Base::throttling_rec->num_sending, UServer_Base::throttling_rec->bytes_since_avg)
+   U_RETURN(ms);
+}
 
-      if ( UServer_Base::throttling_rec->krate &&
-          (UServer_Base::throttling_rec->krate > (UServer_Base::throttling_rec->max_limit * 2) || // if we're way over the limit, don't even start...
-           UServer_Base::throttling_rec->krate <  UServer_Base::throttling_rec->min_limit))       // ...also don't start if we're under the minimum
-         {
-         UServer_Base::throttling_chk = false;
+void UServer_Base::refillThrottling(uthrottling_bucket* pbucket, uint64_t now)
+{
+   U_TRACE(0, "UServer_Base::refillThrottling(%p,%llu)", pbucket, now)
 
-         U_RETURN(0); // stop
-         }
-      
-      UServer_Base::throttling_rec->num_sending++;
+   uint64_t last = pbucket->refill_ms;
 
-      uint32_t l = UServer_Base::throttling_rec->max_limit / UServer_Base::throttling_rec->num_sending;
+   U_INTERNAL_DUMP("tokens = %lld last = %llu max_limit = %u", pbucket->tokens, last, pbucket->max_limit)
 
-      UServer_Base::pClientImage->max_limit = (UServer_Base::pClientImage->max_limit == U_NOT_FOUND ?       l
-                                                                                                    : U_min(l, UServer_Base::pClientImage->max_limit));
-      l = UServer_Base::throttling_rec->min_limit;
+   // NB: only the process that win the CAS on the time of the last refill add the tokens of the elapsed period...
 
-      UServer_Base::pClientImage->min_limit = (UServer_Base::pClientImage->min_limit == U_NOT_FOUND ?       l
-                                                                                                    : U_max(l, UServer_Base::pClientImage->min_limit));
+   if (now > last &&
+       __sync_bool_compare_and_swap(&(pbucket->refill_ms), last, now))
+      {
+      int64_t old, tokens,
+              rate  = pbucket->max_limit * 1024LL, // bytes for second
+              burst = rate * U_THROTTLE_TIME;
 
-      U_INTERNAL_DUMP("UServer_Base::pClientImage->min_limit = %u UServer_Base::pClientImage->max_limit = %u",
-                       UServer_Base::pClientImage->min_limit,     UServer_Base::pClientImage->max_limit)
+      // NB: the other processes can charge the bucket meanwhile, so the add and the clamp to the burst must be a single CAS...
 
-      // NB: db can have different pattern matching the same url...
+      do {
+         old    = pbucket->tokens;
+         tokens = old + (int64_t)((now - last) * rate / 1000);
 
-      U_RETURN(1);
+         if (tokens > burst) tokens = burst;
+         }
+      while (__sync_bool_compare_and_swap(&(pbucket->tokens), old, tokens) == false);
       }
+}
 
-   static int updateThrottling(UStringRep* key, UStringRep* data)
-      {
-      U_TRACE(0, "UBandWidthThrottling::updateThrottling(%p,%p)", key, data)
+uint32_t UServer_Base::getThrottlingRule(const char* uri, uint32_t len)
+{
+   U_TRACE(0, "UServer_Base::getThrottlingRule(%.*S,%u)", len, uri, len)
 
-      if (key) U_RETURN(4); // NB: call us later (after set record value from db)...
+   uint32_t mask = 0;
+   UHashMapNode* node = throttling_exact->findNode(uri, len);
 
-      U_INTERNAL_DUMP("krate = %u min_limit = %u max_limit = %u num_sending = %u bytes_since_avg = %llu", UServer_Base::throttling_rec->krate, UServer_Base::throttling_rec->min_limit,
-                        UServer_Base::throttling_rec->max_limit, UServer_Base::throttling_rec->num_sending, UServer_Base::throttling_rec->bytes_since_avg)
+   if (node) mask = (uint32_t)(long)node->elem;
 
-      UServer_Base::throttling_rec->krate = ( 2 * UServer_Base::throttling_rec->krate + UServer_Base::throttling_rec->bytes_since_avg / (U_THROTTLE_TIME * 1024ULL)) / 3;
-                                                                                        UServer_Base::throttling_rec->bytes_since_avg = 0;
+   for (uint32_t i = 0; i < throttling_num_glob; ++i)
+      {
+      uthrottling_glob* pglob = throttling_glob+i;
 
-      U_INTERNAL_DUMP("krate = %u", UServer_Base::throttling_rec->krate)
+      if ((mask & pglob->mask) == pglob->mask) continue; // NB: the rule already match...
 
-#  ifndef U_LOG_DISABLE
-      if (UServer_Base::isLog())
+      if (pglob->type == 'p')
          {
-         if (UServer_Base::throttling_rec->num_sending)
+         if (len >= pglob->len &&
+             memcmp(uri, pglob->pattern, pglob->len) == 0)
             {
-            if (UServer_Base::throttling_rec->krate > UServer_Base::throttling_rec->max_limit)
-               {
-               UServer_Base::log->log(U_CONSTANT_TO_PARAM("throttle %V: krate %u %sexceeding limit %u; %u sending"), UServer_Base::db_throttling->getKeyID().rep,
-                                      UServer_Base::throttling_rec->krate,
-                                     (UServer_Base::throttling_rec->krate > UServer_Base::throttling_rec->max_limit * 2  ? "greatly " : ""),
-                                      UServer_Base::throttling_rec->max_limit, UServer_Base::throttling_rec->num_sending);
-               }
-
-            if (UServer_Base::throttling_rec->krate < UServer_Base::throttling_rec->min_limit)
-               {
-               UServer_Base::log->log(U_CONSTANT_TO_PARAM("throttle %V: krate %u lower than minimum %u; %u sending"), UServer_Base::db_throttling->getKeyID().rep,
-                                      UServer_Base::throttling_rec->krate,
-                                      UServer_Base::throttling_rec->min_limit, UServer_Base::throttling_rec->num_sending);
-               }
+            mask |= pglob->mask;
             }
          }
-#  endif
-
-      U_RETURN(1);
-      }
-
-   static int updateSending(UStringRep* key, UStringRep* data)
-      {
-      U_TRACE(0, "UBandWidthThrottling::updateSending(%p,%p)", key, data)
-
-      if (key)
+      else if (pglob->type == 's')
          {
-         if (UServices::dosMatchWithOR(U_HTTP_URI_TO_PARAM, U_STRING_TO_PARAM(*key))) U_RETURN(4); // NB: call us later (after set record value from db)...
-
-         U_RETURN(1);
+         if (len >= pglob->len &&
+             memcmp(uri + len - pglob->len, pglob->pattern, pglob->len) == 0)
+            {
+            mask |= pglob->mask;
+            }
+         }
+      else if (UServices::dosMatch(uri, len, pglob->pattern, pglob->len))
+         {
+         mask |= pglob->mask;
          }
-
-      U_INTERNAL_DUMP("krate = %u min_limit = %u max_limit = %u num_sending = %u bytes_since_avg = %llu", UServer_Base::throttling_rec->krate, UServer_Base::throttling_rec->min_limit,
-                        UServer_Base::throttling_rec->max_limit, UServer_Base::throttling_rec->num_sending, UServer_Base::throttling_rec->bytes_since_avg)
-
-      UServer_Base::throttling_rec->bytes_since_avg += UServer_Base::pClientImage->bytes_sent;
-
-      // NB: db can have different pattern matching the same url...
-
-      U_RETURN(1);
       }
 
-   static int updateSendingRate(UStringRep* key, UStringRep* data)
-      {
-      U_TRACE(0, "UBandWidthThrottling::updateSendingRate(%p,%p)", key, data)
+   U_RETURN(mask);
+}
 
-      if (key)
-         {
-         if (UServices::dosMatchWithOR(UServer_Base::pClientImage->uri, U_STRING_TO_PARAM(*key))) U_RETURN(4); // NB: call us later (after set record value from db)...
+void UServer_Base::initThrottlingClient()
+{
+   U_TRACE_NO_PARAM(0, "UServer_Base::initThrottlingClient()")
 
-         U_RETURN(1);
-         }
+   if (throttling_bucket)
+      {
+      U_INTERNAL_ASSERT_EQUALS(brng, false)
 
-      U_INTERNAL_DUMP("krate = %u min_limit = %u max_limit = %u num_sending = %u bytes_since_avg = %llu", UServer_Base::throttling_rec->krate, UServer_Base::throttling_rec->min_limit,
-                        UServer_Base::throttling_rec->max_limit, UServer_Base::throttling_rec->num_sending, UServer_Base::throttling_rec->bytes_since_avg)
+      pClientImage->throttling_rule    =
+      pClientImage->throttling_sending =
+      pClientImage->min_limit          = 0;
+      pClientImage->bytes_sent         =
+      pClientImage->started_at         = 0;
+      }
+}
 
-      U_INTERNAL_ASSERT_MAJOR(UServer_Base::throttling_rec->num_sending, 0)
+void UServer_Base::initThrottlingServer()
+{
+   U_TRACE_NO_PARAM(0, "UServer_Base::initThrottlingServer()")
 
-      uint32_t l = UServer_Base::throttling_rec->max_limit / UServer_Base::throttling_rec->num_sending;
+   U_INTERNAL_ASSERT(*throttling_mask)
+   U_INTERNAL_ASSERT_EQUALS(brng, false)
+   U_INTERNAL_ASSERT_EQUALS(throttling_bucket, U_NULLPTR)
 
-      UServer_Base::pClientImage->max_limit = (UServer_Base::pClientImage->max_limit == U_NOT_FOUND
-                                                   ?       l
-                                                   : U_min(l, UServer_Base::pClientImage->max_limit));
+   if (bssl &&
+       bktls == false)
+      {
+      U_WARNING("Sorry, we can't use bandwidth throttling with SSL (without kTLS)"); // NB: we need to use sendfile()...
 
-      U_RETURN(1);
+      return;
       }
 
-   static bool updateSendingRate(void* cimg)
-      {
-      U_TRACE(0, "UBandWidthThrottling::updateSendingRate(%p)", cimg)
+   char* ptr;
+   const char* p;
+   const char* end;
+   const char* pattern;
+   uint32_t len, min_limit, max_limit;
+   UVector<UString> vec(*throttling_mask);
+   int32_t n = U_min(vec.size() / 2, U_THROTTLING_RULE_MAX);
 
-      U_INTERNAL_ASSERT_POINTER(cimg)
+   if ((vec.size() / 2) > U_THROTTLING_RULE_MAX) U_SRV_LOG("WARNING: BANDWIDTH_THROTTLING_MASK has more than %u rules, the others are ignored", U_THROTTLING_RULE_MAX);
 
-      U_INTERNAL_DUMP("pthis = %p handler_other = %p handler_inotify = %p handler_db1 = %p handler_db2 = %p",
-         UServer_Base::pthis, UServer_Base::handler_other, UServer_Base::handler_inotify, UServer_Base::handler_db1, UServer_Base::handler_db2)
+   if (n == 0) return;
 
-      if (cimg == UServer_Base::pthis           ||
-          cimg == UServer_Base::handler_db1     ||
-          cimg == UServer_Base::handler_db2     ||
-          cimg == UServer_Base::handler_inotify ||
-          (UServer_Base::handler_other && UServer_Base::handler_other->isContained(cimg)))
-         {
-         U_RETURN(false);
-         }
+   // NB: the buckets are in memory shared by the process (we are called before the fork of the preforked children)...
 
-      U_INTERNAL_ASSERT(((UClientImage_Base*)cimg)->socket->isOpen())
+   U_INTERNAL_ASSERT_POINTER(ptr_shared_data)
 
-      UServer_Base::pClientImage = ((UClientImage_Base*)cimg);
+   throttling_bucket = U_SRV_THROTTLING_BUCKET;
 
-      U_INTERNAL_DUMP("UServer_Base::pClientImage->min_limit = %u UServer_Base::pClientImage->max_limit = %u",
-                       UServer_Base::pClientImage->min_limit,     UServer_Base::pClientImage->max_limit)
+   U_NEW(UHashMap<void*>, throttling_exact, UHashMap<void*>(64));
 
-      UServer_Base::pClientImage->max_limit = U_NOT_FOUND;
+   throttling_glob = (uthrottling_glob*) UMemoryPool::cmalloc(n * 4, sizeof(uthrottling_glob)); // NB: we assume max 4 alternative patterns for rule...
 
-      UServer_Base::db_throttling->callForAllEntry(updateSendingRate);
+   uint64_t now = getThrottlingTime();
+   UString glob_pattern(throttling_mask->size()); // NB: the capacity is enough to never reallocate, so the glob patterns can point to it...
 
-      U_RETURN(false);
-      }
+   for (int32_t i = 0; i < n; ++i)
+      {
+      UString x = vec[i*2];
 
-   // define method VIRTUAL of class UEventTime
+      max_limit = ::strtol(vec[i*2+1].data(), &ptr, 10);
+      min_limit = 0;
 
-   virtual int handlerTime() U_DECL_FINAL
-      {
-      U_TRACE_NO_PARAM(0, "UBandWidthThrottling::handlerTime()")
+      if (ptr[0] == '-') min_limit = max_limit, max_limit = ::strtol(ptr+1, U_NULLPTR, 10);
 
-      if (UServer_Base::db_throttling)
+      if (max_limit == 0)
          {
-         // Update the average sending rate for each throttle. This is only used when new connections start up
+         U_SRV_LOG("WARNING: throttle %V: max rate must be major of zero, the rule is ignored", x.rep);
 
-         UServer_Base::db_throttling->callForAllEntry(updateThrottling);
+         continue;
+         }
 
-         // Now update the sending rate on all the currently-sending connections, redistributing it evenly
+      uthrottling_bucket* pbucket = throttling_bucket + i;
 
-         U_INTERNAL_DUMP("UNotifier::num_connection = %u UNotifier::min_connection = %u", UNotifier::num_connection, UNotifier::min_connection)
+      pbucket->tokens    = max_limit * 1024LL * U_THROTTLE_TIME;
+      pbucket->refill_ms = now;
+      pbucket->min_limit = min_limit;
+      pbucket->max_limit = max_limit;
 
-         if (UNotifier::num_connection > UNotifier::min_connection) UNotifier::callForAllEntryDynamic(updateSendingRate);
-         }
+      // compile the alternative patterns (separated by '|') of the rule
 
-      U_RETURN(0); // monitoring
-      }
+      end = (p = x.data()) + x.size();
 
-#if defined(DEBUG) && defined(U_STDCPP_ENABLE)
-   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
-#endif
+      while (p < end)
+         {
+         pattern = p;
 
-private:
-   U_DISALLOW_COPY_AND_ASSIGN(UBandWidthThrottling)
-};
+         p = (const char*) memchr(pattern, '|', end - pattern);
 
-class U_NO_EXPORT UClientThrottling : public UEventTime {
-public:
+         if (p == U_NULLPTR) p = end;
 
-   UClientThrottling(UClientImage_Base* _pClientImage, long sec, long micro_sec) : UEventTime(sec, micro_sec)
-      {
-      U_TRACE_CTOR(0, UClientThrottling, "%p,%ld,%ld", _pClientImage, sec, micro_sec)
+         len = p++ - pattern;
 
-      UNotifier::suspend(pClientImage = _pClientImage);
-      }
+         if (len == 0) continue;
 
-   virtual ~UClientThrottling() U_DECL_FINAL
-      {
-      U_TRACE_DTOR(0, UClientThrottling)
-      }
+         if (memchr(pattern, '*', len) == U_NULLPTR &&
+             memchr(pattern, '?', len) == U_NULLPTR)
+            {
+            UHashMapNode* node = throttling_exact->findNode(pattern, len);
 
-   // define method VIRTUAL of class UEventTime
+            if (node) node->elem = (const void*)((long)node->elem | (1L << i));
+            else      throttling_exact->insert(pattern, len, (const void*)(1L << i));
 
-   virtual int handlerTime() U_DECL_FINAL
-      {
-      U_TRACE_NO_PARAM(0, "UClientThrottling::handlerTime()")
+            continue;
+            }
 
-      UNotifier::resume(pClientImage);
+         if (throttling_num_glob == (uint32_t)n * 4)
+            {
+            U_SRV_LOG("WARNING: throttle %V: too many alternative patterns, %.*S is ignored", x.rep, len, pattern);
 
-      U_RETURN(-1); // normal
-      }
+            continue;
+            }
 
-#if defined(DEBUG) && defined(U_STDCPP_ENABLE)
-   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
-#endif
+         uthrottling_glob* pglob = throttling_glob + throttling_num_glob++;
 
-protected:
-   UClientImage_Base* pClientImage;
+         pglob->mask    = 1U << i;
+         pglob->type    = 'g';
+         pglob->len     = len;
+         pglob->pattern = glob_pattern.data() + glob_pattern.size();
 
-private:
-   U_DISALLOW_COPY_AND_ASSIGN(UClientThrottling)
-};
+         (void) glob_pattern.append(pattern, len);
 
-void UServer_Base::initThrottlingClient()
-{
-   U_TRACE_NO_PARAM(0, "UServer_Base::initThrottlingClient()")
+         if (memchr(pattern, '?', len) == U_NULLPTR)
+            {
+                 if (memchr(pattern,   '*', len-1) == U_NULLPTR) { pglob->type = 'p'; pglob->len = len-1; }                   // prefix*
+            else if (memchr(pattern+1, '*', len-1) == U_NULLPTR) { pglob->type = 's'; pglob->len = len-1; pglob->pattern += 1; } // *suffix
+            }
+         }
+      }
 
-   if (db_throttling)
-      {
-      U_INTERNAL_ASSERT_EQUALS(brng, false)
+   throttling_num_rule = n;
 
-      pClientImage->uri.clear();
+   *throttling_mask = glob_pattern; // NB: we keep alive the glob patterns until the shutdown...
 
-      pClientImage->min_limit  =
-      pClientImage->max_limit  = U_NOT_FOUND;
-      pClientImage->bytes_sent =
-      pClientImage->started_at = 0;
-      }
+   U_SRV_LOG("Bandwidth throttling initialization success: %u rules (%u exact pattern, %u with wildcard)", n, throttling_exact->size(), throttling_num_glob);
+
+   min_size_for_sendfile = 4096; // 4k
 }
 
-void UServer_Base::initThrottlingServer()
+void UServer_Base::clearThrottling(uint32_t mask)
 {
-   U_TRACE_NO_PARAM(0, "UServer_Base::initThrottlingServer()")
+   U_TRACE(0, "UServer_Base::clearThrottling(%B)", mask)
 
-   U_INTERNAL_ASSERT(*throttling_mask)
    U_INTERNAL_ASSERT_EQUALS(brng, false)
-   U_INTERNAL_ASSERT_EQUALS(db_throttling, U_NULLPTR)
+   U_INTERNAL_ASSERT_POINTER(throttling_bucket)
 
-   if (bssl)
+   for (uint32_t i = 0; mask; ++i, mask >>= 1)
       {
-      U_WARNING("Sorry, we can't use bandwidth throttling with SSL"); // NB: we need to use sendfile()...
+      if (mask & 1) (void) __sync_fetch_and_sub(&(throttling_bucket[i].num_sending), 1);
       }
-   else
-      {
-      U_NEW(URDBObjectHandler<UDataStorage*>, db_throttling, URDBObjectHandler<UDataStorage*>(U_STRING_FROM_CONSTANT("../db/BandWidthThrottling"), -1, &throttling_rec, true));
+}
 
-      if (db_throttling->open(32 * 1024, false, true, true, U_SRV_LOCK_THROTTLING)) // NB: we don't want truncate (we have only the journal)...
-         {
-         char* ptr;
-         UString pattern, number;
-         UVector<UString> vec(*throttling_mask);
+void UServer_Base::chargeThrottling(uint32_t mask, uint32_t bytes)
+{
+   U_TRACE(0, "UServer_Base::chargeThrottling(%B,%u)", mask, bytes)
 
-         U_SRV_LOG("db BandWidthThrottling initialization success: size(%u)", db_throttling->size());
+   U_INTERNAL_ASSERT_POINTER(throttling_bucket)
 
-         db_throttling->reset(); // Initialize the db to contain no entries
+   for (uint32_t i = 0; mask; ++i, mask >>= 1)
+      {
+      if (mask & 1)
+         {
+         (void) __sync_fetch_and_sub(&(throttling_bucket[i].tokens), (int64_t)bytes);
+         (void) __sync_fetch_and_add(&(throttling_bucket[i].bytes),  (uint64_t)bytes);
+         }
+      }
+}
 
-         UServer_Base::uthrottling rec = { 0, 0, 0, 0, 0 };
+bool UServer_Base::checkThrottling()
+{
+   U_TRACE_NO_PARAM(0, "UServer_Base::checkThrottling()")
 
-         for (int32_t i = 0, n = vec.size(); i < n; i += 2)
-            {
-            pattern = vec[i];
-             number = vec[i+1];
+   if (throttling_bucket)
+      {
+      U_INTERNAL_ASSERT_EQUALS(brng, false)
 
-                                                              rec.max_limit = ::strtol(number.data(),      &ptr, 10);
-            if (ptr[0] == '-') rec.min_limit = rec.max_limit, rec.max_limit = ::strtol(        ptr+1, U_NULLPTR, 10);
+      uint32_t i, mask = getThrottlingRule(U_HTTP_URI_TO_PARAM);
 
-            (void) db_throttling->insertDataStorage(&rec, sizeof(uthrottling), U_STRING_TO_PARAM(pattern), RDB_INSERT);
-            }
+      pClientImage->throttling_rule =
+      pClientImage->min_limit       = 0;
 
-         min_size_for_sendfile = 4096; // 4k
-         }
-      else
+      if (mask)
          {
-         U_SRV_LOG("WARNING: db BandWidthThrottling initialization failed");
-
-         U_DELETE(db_throttling)
+         uint64_t now = getThrottlingTime();
+         uthrottling_bucket* pbucket;
 
-         db_throttling = U_NULLPTR;
-         }
-      }
-}
+         for (i = 0; i < throttling_num_rule; ++i)
+            {
+            if ((mask & (1U << i)) == 0) continue;
 
-void UServer_Base::clearThrottling()
-{
-   U_TRACE_NO_PARAM(0, "UServer_Base::clearThrottling()")
+            refillThrottling((pbucket = throttling_bucket+i), now);
 
-   U_INTERNAL_ASSERT(pClientImage)
-   U_INTERNAL_ASSERT(pClientImage->uri)
-   U_INTERNAL_ASSERT_EQUALS(brng, false)
-   U_INTERNAL_ASSERT_POINTER(db_throttling)
+            if (pbucket->tokens < -(pbucket->max_limit * 1024LL * U_THROTTLE_TIME)) // if we're way over the limit, don't even start...
+               {
+               (void) __sync_fetch_and_add(&(pbucket->nrefused), 1);
 
-   U_INTERNAL_DUMP("pClientImage->uri = %V", pClientImage->uri.rep)
+               U_SRV_LOG("throttle %u: refused request for %.*S, the rule is %lld bytes over the limit %u kB/s; %u sending", i, U_HTTP_URI_TO_TRACE,
+                         -pbucket->tokens, pbucket->max_limit, pbucket->num_sending);
 
-   db_throttling->callForAllEntry(UBandWidthThrottling::clearThrottling);
-}
+               U_RETURN(false);
+               }
+            }
 
-bool UServer_Base::checkThrottling()
-{
-   U_TRACE_NO_PARAM(0, "UServer_Base::checkThrottling()")
+         for (i = 0; i < throttling_num_rule; ++i)
+            {
+            if ((mask & (1U << i)) == 0) continue;
 
-   if (db_throttling)
-      {
-      U_INTERNAL_ASSERT_EQUALS(brng, false)
+            pbucket = throttling_bucket+i;
 
-      throttling_chk = true;
+            (void) __sync_fetch_and_add(&(pbucket->nrequest),    1);
+            (void) __sync_fetch_and_add(&(pbucket->num_sending), 1);
 
-      pClientImage->max_limit =
-      pClientImage->min_limit = U_NOT_FOUND;
+            if (pClientImage->min_limit < pbucket->min_limit) pClientImage->min_limit = pbucket->min_limit;
+            }
 
-      db_throttling->callForAllEntry(UBandWidthThrottling::checkThrottling);
+         if (pClientImage->throttling_sending) clearThrottling(pClientImage->throttling_sending);
 
-      if (throttling_chk == false) U_RETURN(false);
+         pClientImage->throttling_rule    =
+         pClientImage->throttling_sending = mask;
+         pClientImage->bytes_sent         =
+         pClientImage->started_at         = 0;
+         }
 
-      (void) pClientImage->uri.replace(U_HTTP_URI_TO_PARAM);
+      U_INTERNAL_DUMP("pClientImage->throttling_rule = %B pClientImage->min_limit = %u", pClientImage->throttling_rule, pClientImage->min_limit)
       }
 
    U_RETURN(true);
 }
 
-bool UServer_Base::checkThrottlingBeforeSend(bool bwrite)
+bool UServer_Base::checkThrottlingBeforeSend(bool bwrite, off_t& chunk)
 {
-   U_TRACE(0, "UServer_Base::checkThrottlingBeforeSend(%b)", bwrite)
+   U_TRACE(0, "UServer_Base::checkThrottlingBeforeSend(%b,%I)", bwrite, chunk)
 
-   if (db_throttling)
+   if (throttling_bucket)
       {
       U_INTERNAL_ASSERT_EQUALS(brng, false)
-      U_ASSERT(pClientImage->uri.equal(U_HTTP_URI_TO_PARAM))
 
-      U_INTERNAL_DUMP("pClientImage->max_limit = %u pClientImage->bytes_sent = %llu",
-                       pClientImage->max_limit,     pClientImage->bytes_sent)
+      U_INTERNAL_DUMP("pClientImage->throttling_rule = %B pClientImage->bytes_sent = %llu", pClientImage->throttling_rule, pClientImage->bytes_sent)
 
-      if (pClientImage->max_limit != U_NOT_FOUND)
+      if (pClientImage->throttling_rule)
          {
          U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
 
          if (bwrite == false)
             {
             U_INTERNAL_ASSERT_EQUALS(pClientImage->started_at, 0)
-            U_ASSERT(pClientImage->uri.equal(U_HTTP_URI_TO_PARAM))
-
-            U_INTERNAL_DUMP("pClientImage->bytes_sent = %llu", pClientImage->bytes_sent)
 
             pClientImage->started_at = u_now->tv_sec;
 
             pClientImage->setPendingSendfile();
 
-            db_throttling->callForAllEntry(UBandWidthThrottling::updateSending);
-
             U_RETURN(false);
             }
 
-         // check if we're sending too fast
+         // check if the connection is under its minimum rate (in this case we don't slow down, but we send at most one second of it)...
 
          uint32_t elapsed     = u_now->tv_sec - pClientImage->started_at,
                   kbytes_sent = pClientImage->bytes_sent / 1024ULL,
                   krate       = (elapsed > 1 ? kbytes_sent / elapsed : kbytes_sent);
 
-         U_INTERNAL_DUMP("krate = %u elapsed = %u", krate, elapsed)
+         U_INTERNAL_DUMP("krate = %u elapsed = %u min_limit = %u", krate, elapsed, pClientImage->min_limit)
+
+         if (krate < pClientImage->min_limit)
+            {
+            if (chunk > pClientImage->min_limit * 1024LL) chunk = pClientImage->min_limit * 1024LL;
+
+            U_RETURN(true);
+            }
+
+         // check if some rule matching the uri is in debt: how long should we wait to get back on schedule? (at least 1/10 second)
+         // otherwise we send at most the bytes available in the buckets (so a single sendfile() cannot drain them all at once)
+
+         int64_t tokens, avail = chunk;
+         uint32_t wait_ms = 0;
+         uint64_t ms, now = getThrottlingTime();
 
-         if (krate > pClientImage->max_limit)
+         for (uint32_t i = 0, mask = pClientImage->throttling_rule; mask; ++i, mask >>= 1)
             {
-            // how long should we wait to get back on schedule? If less than a second (integer math rounding), use 1/2 second
+            if ((mask & 1) == 0) continue;
+
+            uthrottling_bucket* pbucket = throttling_bucket+i;
+
+            refillThrottling(pbucket, now);
+
+            if ((tokens = pbucket->tokens) < 0)
+               {
+               ms = (-tokens * 1000) / (pbucket->max_limit * 1024LL);
 
-            uint32_t div = pClientImage->max_limit - elapsed;
+               if (wait_ms < ms) wait_ms = (ms > 60000U ? 60000U : ms);
+               }
+            else if (avail > tokens)
+               {
+               avail = tokens;
+               }
+            }
 
-            if (div == 0) div = 1;
+         U_INTERNAL_DUMP("wait_ms = %u", wait_ms)
 
-            time_t coast = kbytes_sent / div;
+         if (wait_ms)
+            {
+            if (wait_ms < 100) wait_ms = 100;
 
             // set up the wakeup timer
 
             UClientThrottling* pc;
 
-            U_NEW(UClientThrottling, pc, UClientThrottling(pClientImage, coast, coast ? 0 : U_SECOND / 2L));
+            U_NEW(UClientThrottling, pc, UClientThrottling(pClientImage, wait_ms / 1000, (wait_ms % 1000) * 1000L));
 
             UTimer::insert(pc);
 
             U_RETURN(false);
             }
+
+         if (avail < chunk) chunk = U_max(avail, 4096); // NB: at least 4k...
+
+         U_INTERNAL_DUMP("chunk = %I", chunk)
          }
       }
 
@@ -912,141 +1058,287 @@ bool UServer_Base::checkThrottlingBeforeSend(bool bwrite)
  */
 
 #ifdef U_EVASIVE_SUPPORT
-bool                              UServer_Base::bwhitelist;
-UFile*                            UServer_Base::dos_LOG;
-uint32_t                          UServer_Base::page_count;
-uint32_t                          UServer_Base::site_count;
-uint32_t                          UServer_Base::site_interval;
-uint32_t                          UServer_Base::page_interval;
-uint32_t                          UServer_Base::blocking_period;
-UString*                          UServer_Base::dosEmailAddress;
-UString*                          UServer_Base::systemCommand;
-UVector<UIPAllow*>*               UServer_Base::vwhitelist_IP;
-UServer_Base::uevasive*           UServer_Base::evasive_rec;
-URDBObjectHandler<UDataStorage*>* UServer_Base::db_evasive;
+bool                          UServer_Base::bwhitelist;
+UFile*                        UServer_Base::dos_LOG;
+uint32_t                      UServer_Base::page_count;
+uint32_t                      UServer_Base::site_count;
+uint32_t                      UServer_Base::site_interval;
+uint32_t                      UServer_Base::page_interval;
+uint32_t                      UServer_Base::blocking_period;
+UString*                      UServer_Base::dosEmailAddress;
+UString*                      UServer_Base::systemCommand;
+UVector<UIPAllow*>*           UServer_Base::vwhitelist_IP;
+UServer_Base::uevasive_table* UServer_Base::evasive_table;
 
-void UServer_Base::initEvasive()
+/**
+ * The hit counters are kept in a table of fixed size in the POSIX shared memory, so the memory used is bounded under any attack:
+ *
+ * - a key (the address of the client, or the address plus the URI) is hashed to 64 bit and can stay only in U_EVASIVE_MAX_PROBE
+ *   consecutive slots (open addressing). A slot is never freed, it is reused with the CLOCK algorithm (second chance) between the
+ *   slots where the key can stay; the addresses on the blocking list are never replaced
+ * - every slot is a sliding window counter (the count of the previous window is weighted with the part of it still inside the window)
+ *   updated only with atomic operation, so there is no lock
+ * - a key gets a slot only after that a count-min sketch (cleared every max interval) has seen it more than half of the threshold,
+ *   so a flood of unique keys (each seen once) cannot evict the real offenders
+ */
+
+U_NO_EXPORT uint64_t UServer_Base::getEvasiveTime()
 {
-   U_TRACE_NO_PARAM(0, "UServer_Base::initEvasive()")
+   U_TRACE_NO_PARAM(1, "UServer_Base::getEvasiveTime()")
 
-   U_INTERNAL_ASSERT_EQUALS(db_evasive, U_NULLPTR)
+   struct timespec ts;
 
-   U_NEW(URDBObjectHandler<UDataStorage*>, db_evasive, URDBObjectHandler<UDataStorage*>(U_STRING_FROM_CONSTANT("../db/Evasive"), -1, &evasive_rec, true));
+   (void) U_SYSCALL(clock_gettime, "%d,%p", CLOCK_MONOTONIC_COARSE, &ts);
 
-   // POSIX shared memory object: interprocess - can be used by unrelated processes (userver_tcp and userver_ssl)
+   uint64_t ms = ts.tv_sec * 1000ULL + (ts.tv_nsec / 1000000L);
+
+   U_RETURN(ms);
+}
 
-   if (db_evasive->open(128 * U_1M, false, true, true, U_SHM_LOCK_EVASIVE)) // NB: we don't want truncate (we have only the journal)...
+U_NO_EXPORT uint64_t UServer_Base::getEvasiveKey(const char* key, uint32_t key_len)
+{
+   U_TRACE(0, "UServer_Base::getEvasiveKey(%.*S,%u)", key_len, key, key_len)
+
+   uint64_t h = XXH3_64bits(key, key_len); // NB: without seed, the table is shared by unrelated processes (userver_tcp and userver_ssl)...
+
+   if (h == 0) h = 1; // NB: 0 => free slot...
+
+   U_RETURN(h);
+}
+
+uint32_t UServer_Base::hitEvasiveSketch(uint64_t key, uint64_t now)
+{
+   U_TRACE(0, "UServer_Base::hitEvasiveSketch(%llu,%llu)", key, now)
+
+   U_INTERNAL_ASSERT_POINTER(evasive_table)
+
+   uint32_t epoch  = evasive_table->cms_epoch,
+            sec    = now / 1000,
+            period = U_max(page_interval, site_interval);
+
+   // NB: only the process that win the CAS on the start of the period clear the sketch...
+
+   if ((sec - epoch) >= period &&
+       __sync_bool_compare_and_swap(&(evasive_table->cms_epoch), epoch, sec))
       {
-      U_SRV_LOG("db Evasive initialization success: size(%u)", db_evasive->size());
+      (void) U_SYSCALL(memset, "%p,%d,%u", evasive_table->cms, 0, sizeof(evasive_table->cms));
+      }
 
-      URDB::initRecordLock();
+   uint32_t count, estimate = U_NOT_FOUND,
+            h1 = (uint32_t)key,
+            h2 = (uint32_t)(key >> 32) | 1; // NB: the index of the rows is obtained with double hashing...
 
-      db_evasive->reset(); // Initialize the db to contain no entries
+   for (uint32_t i = 0; i < U_EVASIVE_CMS_DEPTH; ++i)
+      {
+      count = __sync_add_and_fetch(&(evasive_table->cms[i][(h1 + i * h2) & (U_EVASIVE_CMS_WIDTH-1)]), 1);
 
-      if (dos_LOG) (void) UServer_Base::addLog(dos_LOG);
+      if (estimate > count) estimate = count;
       }
-   else
+
+   U_RETURN(estimate);
+}
+
+uint32_t UServer_Base::hitEvasiveSlot(uevasive_slot* pslot, uint64_t now, uint32_t interval)
+{
+   U_TRACE(0, "UServer_Base::hitEvasiveSlot(%p,%llu,%u)", pslot, now, interval)
+
+   uint64_t window  = pslot->window,
+            elapsed = (now > window ? now - window : 0),
+            interval_ms = interval * 1000ULL;
+
+   U_INTERNAL_DUMP("window = %llu count = %u prev = %u elapsed = %llu", window, pslot->count, pslot->prev, elapsed)
+
+   if (elapsed >= interval_ms)
       {
-      U_SRV_LOG("WARNING: db Evasive initialization failed");
+      // NB: only the process that win the CAS on the start of the window move the count to the previous window...
+
+      if (__sync_bool_compare_and_swap(&(pslot->window), window, now - (elapsed % interval_ms)))
+         {
+         uint32_t count = __sync_lock_test_and_set(&(pslot->count), 0);
 
-      U_DELETE(db_evasive)
+         pslot->prev = (elapsed < interval_ms * 2 ? count : 0);
+         }
 
-      db_evasive = U_NULLPTR;
+      window  = pslot->window;
+      elapsed = (now > window ? U_min(now - window, interval_ms) : 0);
       }
+
+   pslot->ref = 1;
+
+   uint32_t estimate = __sync_add_and_fetch(&(pslot->count), 1) + (uint32_t)((pslot->prev * (interval_ms - elapsed)) / interval_ms);
+
+   U_RETURN(estimate);
 }
 
-bool UServer_Base::checkHold(in_addr_t client)
+UServer_Base::uevasive_slot* UServer_Base::findEvasiveSlot(uint64_t key, bool binsert, uint64_t now)
 {
-   U_TRACE(0, "UServer_Base::checkHold(%u)", client)
+   U_TRACE(0, "UServer_Base::findEvasiveSlot(%llu,%b,%llu)", key, binsert, now)
 
-   U_INTERNAL_ASSERT_POINTER(db_evasive)
+   U_INTERNAL_ASSERT_POINTER(evasive_table)
 
-   bool result = false;
+   uint64_t old;
+   uint32_t n, idx = (uint32_t)key;
+   uevasive_slot* pslot = U_NULLPTR;
 
-   if ((bwhitelist = (vwhitelist_IP && UIPAllow::isAllowed(client, *vwhitelist_IP))) == false) // Check whitelist
+   for (n = 0; n < U_EVASIVE_MAX_PROBE; ++n)
       {
-      U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
+      pslot = evasive_table->slot + ((idx + n) & (U_EVASIVE_NUM_SLOT-1));
 
-      // First see if the IP itself is on "hold"
+      if ((old = pslot->key) == key) U_RETURN_POINTER(pslot, uevasive_slot);
 
-      if (db_evasive->getDataStorage(client))
+      if (old == 0)
          {
-         db_evasive->lockRecord();
-
-         if ((u_now->tv_sec - evasive_rec->timestamp) < blocking_period)
-            {
-            result = true;
+         if (binsert == false) U_RETURN_POINTER(U_NULLPTR, uevasive_slot); // NB: a slot is never freed, so the key cannot be after a free slot...
 
-            evasive_rec->timestamp = u_now->tv_sec; // Make it wait longer in blacklist land
-            }
+         if (__sync_bool_compare_and_swap(&(pslot->key), 0, key)) goto init;
 
-         db_evasive->unlockRecord();
+         if (pslot->key == key) U_RETURN_POINTER(pslot, uevasive_slot);
          }
       }
 
-   U_RETURN(result);
+   if (binsert == false) U_RETURN_POINTER(U_NULLPTR, uevasive_slot);
+
+   // CLOCK: a slot referenced since the last sweep gets a second chance (so at most two sweeps); a stale one is taken immediately
+
+   {
+   uint32_t sec = now / 1000;
+   uint64_t stale = now - U_max(page_interval, site_interval) * 2000ULL;
+
+   for (n = 0; n < U_EVASIVE_MAX_PROBE * 2; ++n)
+      {
+      pslot = evasive_table->slot + ((idx + (n % U_EVASIVE_MAX_PROBE)) & (U_EVASIVE_NUM_SLOT-1));
+
+      if (pslot->hold > sec) continue; // NB: the address of a client on the blocking list...
+
+      if (pslot->window < stale) break;
+
+      if (pslot->ref == 0) break;
+
+      pslot->ref = 0;
+      }
+
+   if (n == U_EVASIVE_MAX_PROBE * 2 ||
+       __sync_bool_compare_and_swap(&(pslot->key), (old = pslot->key), key) == false)
+      {
+      (void) __sync_fetch_and_add(&(evasive_table->nrefused), 1);
+
+      U_RETURN_POINTER(U_NULLPTR, uevasive_slot);
+      }
+
+   (void) __sync_fetch_and_add(&(evasive_table->nevicted), 1);
+   }
+
+init:
+   pslot->window = now;
+   pslot->count  =
+   pslot->prev   =
+   pslot->hold   = 0;
+   pslot->ref    = 1;
+
+   U_RETURN_POINTER(pslot, uevasive_slot);
 }
 
-bool UServer_Base::checkHitStats(const char* key, uint32_t key_len, uint32_t interval, uint32_t count)
+void UServer_Base::initEvasive()
 {
-   U_TRACE(0, "UServer_Base::checkHitStats(%.*S,%u,%u,%u)", key_len, key, key_len, interval, count)
+   U_TRACE_NO_PARAM(0, "UServer_Base::initEvasive()")
 
-   U_INTERNAL_ASSERT_POINTER(db_evasive)
-   U_INTERNAL_ASSERT_EQUALS(bwhitelist, false)
+   U_INTERNAL_ASSERT_EQUALS(evasive_table, U_NULLPTR)
 
-   bool binterval;
+   // POSIX shared memory object: interprocess - can be used by unrelated processes (userver_tcp and userver_ssl)
 
-   if (db_evasive->getDataStorage(key, key_len) == false)
+   if (ptr_shm_data == U_NULLPTR)
       {
-      UServer_Base::uevasive rec = { (uint32_t)u_now->tv_sec, 0 };
-
-      (void) db_evasive->insertDataStorage(&rec, sizeof(uevasive), key, key_len, RDB_INSERT);
+      U_SRV_LOG("WARNING: evasive table initialization failed");
 
-      U_RETURN(false);
+      return;
       }
 
-   db_evasive->lockRecord();
+   evasive_table = U_SHM_EVASIVE_TABLE;
 
-   binterval = ((u_now->tv_sec - evasive_rec->timestamp) >= interval);
+   (void) U_SYSCALL(memset, "%p,%d,%u", evasive_table, 0, sizeof(uevasive_table)); // Initialize the table to contain no entries
 
-   // If site/URI is being hit too much, add to "hold" list
+   evasive_table->cms_epoch = getEvasiveTime() / 1000;
+
+   U_SRV_LOG("Evasive table initialization success: %u slots, count-min sketch %ux%u - size(%u)",
+             U_EVASIVE_NUM_SLOT, U_EVASIVE_CMS_DEPTH, U_EVASIVE_CMS_WIDTH, sizeof(uevasive_table));
+
+   if (dos_LOG) (void) UServer_Base::addLog(dos_LOG);
+}
+
+bool UServer_Base::checkHold(in_addr_t client)
+{
+   U_TRACE(0, "UServer_Base::checkHold(%u)", client)
 
-   if (binterval ||
-       evasive_rec->count < count)
+   U_INTERNAL_ASSERT_POINTER(evasive_table)
+
+   bool result = false;
+
+   if ((bwhitelist = (vwhitelist_IP && UIPAllow::isAllowed(client, *vwhitelist_IP))) == false) // Check whitelist
       {
-      if (binterval) evasive_rec->count = 0; // Reset our hit count list as necessary
+      // First see if the IP itself is on "hold"
 
-      evasive_rec->count++;
-      evasive_rec->timestamp = u_now->tv_sec;
+      uint64_t now = getEvasiveTime();
+      uevasive_slot* pslot = findEvasiveSlot(getEvasiveKey((const char*)&client, sizeof(in_addr_t)), false, now);
 
-      db_evasive->unlockRecord();
+      if (pslot &&
+          pslot->hold > (now / 1000))
+         {
+         result = true;
 
-      U_RETURN(false);
+         pslot->ref  = 1;
+         pslot->hold = (now / 1000) + blocking_period; // Make it wait longer in blacklist land
+         }
       }
 
-   U_INTERNAL_ASSERT_EQUALS(binterval, false)
-   U_INTERNAL_ASSERT(evasive_rec->count >= count)
+   U_RETURN(result);
+}
+
+bool UServer_Base::checkHitStats(const char* key, uint32_t key_len, uint32_t interval, uint32_t count)
+{
+   U_TRACE(0, "UServer_Base::checkHitStats(%.*S,%u,%u,%u)", key_len, key, key_len, interval, count)
+
+   U_INTERNAL_ASSERT_POINTER(evasive_table)
+   U_INTERNAL_ASSERT_EQUALS(bwhitelist, false)
+
+   uint64_t now = getEvasiveTime(),
+            h   = getEvasiveKey(key, key_len);
+   uevasive_slot* pslot = findEvasiveSlot(h, false, now);
+
+   if (pslot == U_NULLPTR)
+      {
+      // first-level filter: the key gets a slot only when the sketch has seen it more than half of the threshold
+
+      uint32_t estimate = hitEvasiveSketch(h, now);
+
+      if (estimate <= (count > 1 ? count / 2 : 1) ||
+          (pslot = findEvasiveSlot(h, true, now)) == U_NULLPTR)
+         {
+         U_RETURN(false);
+         }
+
+      pslot->count = U_min(estimate, count+1) - 1; // NB: the hits already seen by the sketch (the current one is added below)...
+      }
 
-   evasive_rec->count     = 0;
-   evasive_rec->timestamp = u_now->tv_sec;
+   // If site/URI is being hit too much, add to "hold" list
 
-   db_evasive->unlockRecord();
+   if (hitEvasiveSlot(pslot, now, interval) <= count) U_RETURN(false);
 
    in_addr_t client = UServer_Base::getClientAddress();
+   uevasive_slot* phold = findEvasiveSlot(getEvasiveKey((const char*)&client, sizeof(in_addr_t)), true, now);
 
-   if (db_evasive->getDataStorage(client)) evasive_rec->timestamp = u_now->tv_sec; // Make it wait longer in blacklist land
-   else
+   if (phold == U_NULLPTR) // NB: all the slots where the address can stay are in use by the blocking list (the failure is counted in nrefused)...
       {
-      UServer_Base::uevasive rec = { (uint32_t)u_now->tv_sec, 0 };
+      U_DEBUG("evasive table: cannot blacklist address %.*S, no slot available", U_CLIENT_ADDRESS_TO_TRACE);
 
-      (void) db_evasive->insertDataStorage(&rec, sizeof(uevasive), client, RDB_INSERT);
+      U_RETURN(false);
       }
 
-   /*
-   U_INTERNAL_DUMP("u_now->tv_sec = %ld evasive_rec->timestamp = %u evasive_rec->count = %u", u_now->tv_sec, evasive_rec->timestamp, evasive_rec->count)
+   phold->hold = (now / 1000) + blocking_period;
 
-   U_INTERNAL_ASSERT_EQUALS(evasive_rec->timestamp, (uint32_t)u_now->tv_sec)
-   */
+   pslot->count =
+   pslot->prev  = 0;
+
+   (void) __sync_fetch_and_add(&(evasive_table->nblacklist), 1);
 
    char lmsg[4096];
    uint32_t msg_len;
@@ -1116,7 +1408,7 @@ bool UServer_Base::checkHitSiteStats()
 {
    U_TRACE_NO_PARAM(0+256, "UServer_Base::checkHitSiteStats()")
 
-   U_INTERNAL_ASSERT_POINTER(db_evasive)
+   U_INTERNAL_ASSERT_POINTER(evasive_table)
 
    if (bwhitelist == false)
       {
@@ -1136,7 +1428,7 @@ bool UServer_Base::checkHitUriStats()
 {
    U_TRACE_NO_PARAM(0+256, "UServer_Base::checkHitUriStats()")
 
-   U_INTERNAL_ASSERT_POINTER(db_evasive)
+   U_INTERNAL_ASSERT_POINTER(evasive_table)
 
    if (bwhitelist == false)
       {
@@ -1274,8 +1566,8 @@ public:
             }
 
 #       if !defined(U_LOG_DISABLE) && defined(USE_LIBZ)
-         if (UServer_Base::log)                         UServer_Base::log->checkForLogRotateDataToWrite();
-         if (UServer_Base::apache_like_log) UServer_Base::apache_like_log->checkForLogRotateDataToWrite();
+         if (UServer_Base::log             && UServer_Base::log->isRing()             == false)             UServer_Base::log->checkForLogRotateDataToWrite();
+         if (UServer_Base::apache_like_log && UServer_Base::apache_like_log->isRing() == false) UServer_Base::apache_like_log->checkForLogRotateDataToWrite(); // NB: with ring it is done by the flusher...
 #       endif
 
 #       if defined(USE_LOAD_BALANCE) && !defined(U_DISABLE_WATCH_THREAD)
@@ -1377,6 +1669,46 @@ public:
 private:
    U_DISALLOW_COPY_AND_ASSIGN(UTimeThread)
 };
+
+#  ifndef U_LOG_DISABLE
+class ULogFlusher : public UThread {
+public:
+
+   ULogFlusher() : UThread(PTHREAD_CREATE_DETACHED) {}
+
+   virtual void run() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(0, "ULogFlusher::run()")
+
+      U_SRV_LOG("Log flusher thread activated (tid %u): flush interval = %u ms, ring size = %u KB", u_gettid(), UServer_Base::log_flush_interval, UServer_Base::log_ring_size / 1024);
+
+      uint32_t nloop = 0, nloop_stats = (U_ONE_HOUR_IN_SECOND * 1000) / UServer_Base::log_flush_interval;
+      struct timespec ts = { (long)(UServer_Base::log_flush_interval / 1000), (long)(UServer_Base::log_flush_interval % 1000) * 1000000L };
+
+      while (UServer_Base::flag_loop)
+         {
+         if (U_SYSCALL(nanosleep, "%p,%p", &ts, U_NULLPTR) == -1 || UThread::bpause) continue;
+
+         if (UServer_Base::log             && UServer_Base::log->isRing())                         UServer_Base::log->flush();
+         if (UServer_Base::apache_like_log && UServer_Base::apache_like_log->isRing()) UServer_Base::apache_like_log->flush();
+
+         if (++nloop >= nloop_stats && // NB: every hour we report the flush latency and the lines dropped...
+             UServer_Base::log)
+            {
+            nloop = 0;
+
+            if (UServer_Base::log->isRing())                                                 UServer_Base::log->logRingStats(UServer_Base::log);
+            if (UServer_Base::apache_like_log && UServer_Base::apache_like_log->isRing()) UServer_Base::apache_like_log->logRingStats(UServer_Base::log);
+            }
+         }
+      }
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(ULogFlusher)
+};
+#  endif
+
+UThread* UServer_Base::pthread_log;
 #  endif
 
 #  if defined(USE_LIBSSL) && !defined(OPENSSL_NO_OCSP) && defined(SSL_CTRL_SET_TLSEXT_STATUS_REQ_CB) && !defined(_MSWINDOWS_)
@@ -1890,6 +2222,10 @@ UServer_Base::~UServer_Base()
       (void) pthread_rwlock_destroy(ULog::prwlock);
       }
 
+#  ifndef U_LOG_DISABLE
+   if (pthread_log) U_DELETE(pthread_log)
+#  endif
+
 #  if defined(USE_LIBSSL)
    if (tls_pin) U_DELETE(tls_pin)
 #  if !defined(OPENSSL_NO_OCSP) && defined(SSL_CTRL_SET_TLSEXT_STATUS_REQ_CB)
@@ -1982,6 +2318,8 @@ UServer_Base::~UServer_Base()
    if (host)              U_DELETE(host)
    if (emailClient)       U_DELETE(emailClient)
    if (crashEmailAddress) U_DELETE(crashEmailAddress)
+   if (shard_cache)       U_DELETE(shard_cache)
+   if (shard_cache_path)  U_DELETE(shard_cache_path)
 
 #ifdef USE_LOAD_BALANCE
    if (ifname)         U_DELETE(ifname)
@@ -1989,24 +2327,17 @@ UServer_Base::~UServer_Base()
 #endif
 
 #ifdef U_THROTTLING_SUPPORT
-   if (db_throttling)
+   if (throttling_bucket)
       {
-      db_throttling->close();
+      UMemoryPool::_free(throttling_glob, throttling_num_rule * 4, sizeof(uthrottling_glob));
 
-      U_DELETE(db_throttling)
+      U_DELETE(throttling_exact)
       }
 
    if (throttling_mask) U_DELETE(throttling_mask)
 #endif
 
 #ifdef U_EVASIVE_SUPPORT
-   if (db_evasive)
-      {
-      db_evasive->close();
-
-      U_DELETE(db_evasive)
-      }
-
    if (vwhitelist_IP)   U_DELETE(vwhitelist_IP)
    if (dosEmailAddress) U_DELETE(dosEmailAddress)
 #endif
@@ -2024,6 +2355,8 @@ UServer_Base::~UServer_Base()
 #endif
 #ifndef USE_LIBEVENT
    if (ptime) U_DELETE(ptime)
+
+   if (vClientTimeout) delete[] vClientTimeout;
 #endif
 #ifdef DEBUG
    if (pstat) U_DELETE(pstat)
@@ -2098,6 +2431,13 @@ void UServer_Base::closeLog()
    if (log &&
        log->isOpen())
       {
+      if (apache_like_log &&
+          apache_like_log->isRing())
+         {
+         apache_like_log->flush();
+         apache_like_log->logRingStats(log);
+         }
+
       log->closeLog();
       }
 
@@ -2256,6 +2596,12 @@ void UServer_Base::loadConfigParam()
    // LOG_FILE_SZ   memory size for file log
    // LOG_MSG_SIZE  limit length of print network message to LOG_MSG_SIZE chars (default 128)
    //
+   // LOG_RING_SIZE      size (KB) of the ring where every worker buffer its lines for the memory mapped file log (default 64, 0 => disable)
+   // LOG_FLUSH_INTERVAL time (ms) between the write of the rings on the file log by the flusher thread (default 20)
+   //
+   // SHARD_CACHE      file name of the cache shared by the preforked processes for the plugins and the USP pages (UServer_Base::shard_cache)
+   // SHARD_CACHE_SIZE size (KB) of the cache shared by the preforked processes (default 1024)
+   //
    // PLUGIN        list of plugins to load, a flexible way to add specific functionality to the server
    // PLUGIN_DIR    directory where there are plugins to load
    //
@@ -2263,6 +2609,7 @@ void UServer_Base::loadConfigParam()
    // ORM_DRIVER_DIR directory where there are ORM drivers to load
    //
    // REQ_TIMEOUT    timeout for request from client
+   // TIMER_WHEEL    flag to keep the timers in a hierarchical timing wheel with one timer for connection to check REQ_TIMEOUT
    // TCP_KEEP_ALIVE Specifies to active the TCP keepalive implementation in the linux kernel
    // TCP_LINGER_SET Specifies how the TCP initiated the close
    // MAX_KEEP_ALIVE Specifies the maximum number of requests that can be served through a Keep-Alive (Persistent) session. (Value <= 0 will disable Keep-Alive)
@@ -2275,6 +2622,7 @@ void UServer_Base::loadConfigParam()
    // CA_PATH       locations of trusted CA certificates used in the verification
    // VERIFY_MODE   mode of verification (SSL_VERIFY_NONE=0, SSL_VERIFY_PEER=1, SSL_VERIFY_FAIL_IF_NO_PEER_CERT=2, SSL_VERIFY_CLIENT_ONCE=4)
    // CIPHER_SUITE  cipher suite model (Intermediate=0, Modern=1, Old=2)
+   // KTLS          flag to hand the TLS record layer to the kernel after the handshake (kTLS) so that sendfile() can be used with SSL
    //
    // PREFORK_CHILD number of child server processes created at startup: -1 - thread approach (experimental)
    //                                                                     0 - serialize, no forking
@@ -2341,6 +2689,7 @@ void UServer_Base::loadConfigParam()
    U_INTERNAL_DUMP("SOMAXCONN = %d FD_SETSIZE = %d timeoutMS = %d", SOMAXCONN, FD_SETSIZE, timeoutMS)
 
    set_tcp_keep_alive    = pcfg->readBoolean(U_CONSTANT_TO_PARAM("TCP_KEEP_ALIVE"));
+   timer_wheel           = pcfg->readBoolean(U_CONSTANT_TO_PARAM("TIMER_WHEEL"));
    set_realtime_priority = pcfg->readBoolean(U_CONSTANT_TO_PARAM("SET_REALTIME_PRIORITY"), false);
 
    crash_count                = pcfg->readLong(U_CONSTANT_TO_PARAM("CRASH_COUNT"), 5);
@@ -2351,10 +2700,26 @@ void UServer_Base::loadConfigParam()
    UNotifier::max_connection  = pcfg->readLong(U_CONSTANT_TO_PARAM("MAX_KEEP_ALIVE"), USocket::iBackLog);
    u_printf_string_max_length = pcfg->readLong(U_CONSTANT_TO_PARAM("LOG_MSG_SIZE"));
 
+#ifndef U_LOG_DISABLE
+   log_ring_size              = pcfg->readLong(U_CONSTANT_TO_PARAM("LOG_RING_SIZE"), 64) * 1024;
+   log_flush_interval         = pcfg->readLong(U_CONSTANT_TO_PARAM("LOG_FLUSH_INTERVAL"), 20);
+
+   if (log_flush_interval == 0) log_flush_interval = 1;
+#endif
+
 #ifdef USERVER_RNG
    rbuffer_size = pcfg->readLong(U_CONSTANT_TO_PARAM("READ_BUFFER_SIZE"), 65535);
 #endif
 
+   x = pcfg->at(U_CONSTANT_TO_PARAM("SHARD_CACHE"));
+
+   if (x)
+      {
+      U_NEW_STRING(shard_cache_path, UString(x));
+
+      shard_cache_size = pcfg->readLong(U_CONSTANT_TO_PARAM("SHARD_CACHE_SIZE"), 1024) * 1024;
+      }
+
    U_INTERNAL_DUMP("UNotifier::max_connection = %u USocket::iBackLog = %u", UNotifier::max_connection, USocket::iBackLog)
 
    * key_file = pcfg->at(U_CONSTANT_TO_PARAM( "KEY_FILE"));
@@ -2448,7 +2813,9 @@ void UServer_Base::loadConfigParam()
       *ca_file   = pcfg->at(U_CONSTANT_TO_PARAM("CA_FILE"));
       *ca_path   = pcfg->at(U_CONSTANT_TO_PARAM("CA_PATH"));
 
-      min_size_for_sendfile = U_NOT_FOUND; // NB: we can't use sendfile with SSL...
+      bktls = pcfg->readBoolean(U_CONSTANT_TO_PARAM("KTLS"));
+
+      if (bktls == false) min_size_for_sendfile = U_NOT_FOUND; // NB: we can't use sendfile with SSL (without kTLS)...
       }
 #endif
 
@@ -3202,6 +3569,10 @@ void UServer_Base::suspendThread()
 #if defined(U_LINUX) && defined(ENABLE_THREAD)
    if (u_pthread_time) ((UThread*)u_pthread_time)->bpause = true;
 
+# ifndef U_LOG_DISABLE
+   if (pthread_log) pthread_log->bpause = true;
+# endif
+
 # if defined(USE_LIBSSL) && !defined(OPENSSL_NO_OCSP) && defined(SSL_CTRL_SET_TLSEXT_STATUS_REQ_CB)
    if (pthread_ocsp) pthread_ocsp->bpause = true;
 # endif
@@ -3251,6 +3622,18 @@ void UServer_Base::init()
          {
          U_ERROR("SSL: server setContext() failed");
          }
+
+      if (bktls)
+         {
+#     ifdef SSL_OP_ENABLE_KTLS
+         (void) U_SYSCALL(SSL_CTX_set_options, "%p,%d", ((USSLSocket*)socket)->ctx, SSL_OP_ENABLE_KTLS);
+#     else
+         U_WARNING("SSL: the OpenSSL library don't support kTLS, we can't use sendfile with SSL");
+
+         bktls                 = false;
+         min_size_for_sendfile = U_NOT_FOUND;
+#     endif
+         }
       }
 #endif
 
@@ -3419,7 +3802,7 @@ next:
    }
 #endif
 
-   UTimer::init(UTimer::NOSIGNAL);
+   UTimer::init(UTimer::NOSIGNAL, timer_wheel);
 
 #ifdef USERVER_RNG
    if (brng ||
@@ -3479,6 +3862,30 @@ next:
    U_INTERNAL_ASSERT_POINTER(ptr_shm_data)
 #endif
 
+   if (shard_cache_path)
+      {
+      // NB: two shards for every preforked child, with the locks from the shared memory (they must be initialized before the forking)...
+
+      uint32_t nshard = (preforked_num_kids > 1 ? preforked_num_kids * 2 : 2);
+
+      if (nshard > U_SHM_LOCK_SHARD_NENTRY) nshard = U_SHM_LOCK_SHARD_NENTRY;
+
+      U_NEW(UShardCache, shard_cache, UShardCache);
+
+      if (shard_cache->open(*shard_cache_path, shard_cache_size, nshard, U_NULLPTR, false, (ptr_shm_data ? U_SHM_LOCK_SHARD_CACHE : U_NULLPTR), U_SHM_LOCK_SHARD_NENTRY))
+         {
+         U_SRV_LOG("Shared cache %V initialization success: size = %u KB, shards = %u", shard_cache_path->rep, shard_cache_size / 1024, shard_cache->getNumShard());
+         }
+      else
+         {
+         U_WARNING("Shared cache %V initialization failed", shard_cache_path->rep);
+
+         U_DELETE(shard_cache)
+
+         shard_cache = U_NULLPTR;
+         }
+      }
+
 #ifndef U_LOG_DISABLE
    if (isLog() == false)
 #endif
@@ -3560,6 +3967,28 @@ next:
 
       U_SRV_LOG("Mapped %u bytes (%u KB) of shared memory for apache like log", apache_like_log->getSizeLogRotateData(), apache_like_log->getSizeLogRotateData() / 1024);
       }
+
+#  if defined(U_LINUX) && defined(ENABLE_THREAD)
+   if (log_ring_size)
+      {
+      // NB: a ring for every worker (process or thread) plus some for the parent and the other threads (the ring of a died process is recycled by the flusher)...
+
+      uint32_t nring = (preforked_num_kids > 0 ? preforked_num_kids : u_num_cpu) + 4;
+
+      if (isLog()         &&         log->isMemoryMapped())         log->setRing(nring, log_ring_size);
+      if (apache_like_log && apache_like_log->isMemoryMapped()) apache_like_log->setRing(nring, log_ring_size);
+
+      if ((isLog()         &&         log->isRing()) ||
+          (apache_like_log && apache_like_log->isRing()))
+         {
+         U_INTERNAL_ASSERT_EQUALS(pthread_log, U_NULLPTR)
+
+         U_NEW(ULogFlusher, pthread_log, ULogFlusher);
+
+         pthread_log->start(0);
+         }
+      }
+#  endif
 #endif
 
 #if defined(USERVER_UDP)
@@ -3575,18 +4004,6 @@ next:
 
    (void) UFile::_mkdir("../db");
 
-#if defined(U_THROTTLING_SUPPORT) && !defined(U_DISABLE_WATCH_THREAD)
-   if (db_throttling)
-      {
-      // set up the throttles timer
-
-      UEventTime* throttling_time;
-
-      U_NEW(UBandWidthThrottling, throttling_time, UBandWidthThrottling);
-
-      UTimer::insert(throttling_time);
-      }
-#endif
 
    socket_flags |= O_RDWR | O_CLOEXEC;
 
@@ -3804,6 +4221,10 @@ void UServer_Base::sendSignalToAllChildren(int signo, sighandler_t handler)
 #if defined(U_LINUX) && defined(ENABLE_THREAD)
    if (u_pthread_time) ((UThread*)u_pthread_time)->bpause = false;
 
+# ifndef U_LOG_DISABLE
+   if (pthread_log) pthread_log->bpause = false;
+# endif
+
 # if defined(USE_LIBSSL) && !defined(OPENSSL_NO_OCSP) && defined(SSL_CTRL_SET_TLSEXT_STATUS_REQ_CB)
    if (pthread_ocsp) pthread_ocsp->bpause = false;
 # endif
@@ -4008,7 +4429,7 @@ bool UServer_Base::handlerAccept(int newfd) // turn false if we should close the
    U_TRACE(0, "UServer_Base::handlerAccept(%d)", newfd)
 
 #ifdef U_EVASIVE_SUPPORT
-   if (db_evasive &&
+   if (evasive_table &&
        checkHold(csocket->getClientAddress()))
       {
       U_RETURN(false);
@@ -4422,6 +4843,8 @@ retry:   pid = UProcess::waitpid(-1, &status, WNOHANG); // NB: to avoid too much
    UNotifier::insert((UEventFd*)CLIENT_IMAGE);
 #endif
 
+   if (vClientTimeout) insertTimeoutClient(CLIENT_IMAGE);
+
    if (++CLIENT_IMAGE >= eClientImage) CLIENT_IMAGE = vClientImage;
 
 next:
@@ -4558,6 +4981,7 @@ bool UServer_Base::handlerTimeoutConnection(void* cimg)
 #endif
 
    if (cimg == pthis                         ||
+       isClientImage(cimg) == false          ||
        cimg == UServer_Base::handler_db1     ||
        cimg == UServer_Base::handler_db2     ||
        cimg == UServer_Base::handler_inotify ||
@@ -4576,6 +5000,32 @@ bool UServer_Base::handlerTimeoutConnection(void* cimg)
    U_RETURN(false);
 }
 
+void UServer_Base::insertTimeoutClient(UClientImage_Base* cimg)
+{
+   U_TRACE(0, "UServer_Base::insertTimeoutClient(%p)", cimg)
+
+   U_INTERNAL_ASSERT_POINTER(vClientTimeout)
+
+   UTimeoutClient* pclient = vClientTimeout + (cimg - vClientImage);
+
+   U_INTERNAL_ASSERT_MINOR((uint32_t)(cimg - vClientImage), UNotifier::max_connection)
+
+   pclient->cimg = cimg;
+
+   if (UTimer::isHandler(pclient)) UTimer::updateTimeToExpire(pclient);
+   else                            UTimer::insert(pclient);
+}
+
+void UServer_Base::eraseTimeoutClient(UClientImage_Base* cimg)
+{
+   U_TRACE(0, "UServer_Base::eraseTimeoutClient(%p)", cimg)
+
+   U_INTERNAL_ASSERT_POINTER(vClientTimeout)
+   U_INTERNAL_ASSERT_MINOR((uint32_t)(cimg - vClientImage), UNotifier::max_connection)
+
+   UTimer::erase(vClientTimeout + (cimg - vClientImage));
+}
+
 #ifdef USE_LIBURING
 void UServer_Base::epoll_ctl_batch(uint32_t ctl_cmd_cnt)
 {
@@ -4638,6 +5088,8 @@ accept:
 
       rmsg.msg_namelen = USocket::peer_addr_len;
 
+      if (rmsg.msg_control) rmsg.msg_controllen = CMSG_SPACE(sizeof(int)); // NB: the kernel overwrite it with the size of the control data received (UDP_GRO)...
+
       U_INTERNAL_ASSERT_EQUALS(rmsg.msg_flags, 0)
       U_INTERNAL_ASSERT_EQUALS(rmsg.msg_name, &USocket::peer_addr)
 
@@ -5038,7 +5490,8 @@ void UServer_Base::runLoop(const char* user)
                            socket->setTcpNoDelay();
                            socket->setTcpFastOpen();
                            socket->setTcpDeferAccept();
-   if (bssl == false)      socket->setBufferSND(500 * 1024); // 500k: for major size we assume is better to use sendfile()
+   if (bssl == false ||
+       bktls)              socket->setBufferSND(500 * 1024); // 500k: for major size we assume is better to use sendfile()
    if (set_tcp_keep_alive) socket->setTcpKeepAlive();
 # endif
    }
@@ -5075,6 +5528,12 @@ void UServer_Base::runLoop(const char* user)
    // rmsg.msg_control    = cmbuf;
    // rmsg.msg_controllen = sizeof(cmbuf);
 
+#  ifndef U_HTTP3_DISABLE
+      UQuic::initSocket(); // batched UDP I/O (GRO/GSO) and connection ID steering
+
+      if (UUDPBatch::bgro) rmsg.msg_control = UUDPBatch::rcontrol; // NB: for the segment size of the datagrams coalesced by GRO...
+#  endif
+
       if (UServices::isSetuidRoot())
          {
          params.flags          = IORING_SETUP_SQPOLL;
@@ -5357,6 +5816,17 @@ void UServer_Base::runLoop(const char* user)
       {
       UTimer::insert(ptime);
 
+      if (UTimer::isWheel()
+#     ifdef USERVER_RNG
+          && brng == false
+#     endif
+         )
+         {
+         U_INTERNAL_ASSERT_EQUALS(vClientTimeout, U_NULLPTR)
+
+         vClientTimeout = new UTimeoutClient[UNotifier::max_connection];
+         }
+
 #  if !defined(U_LOG_DISABLE) && defined(DEBUG)
       last_event = u_now->tv_sec;
 #  endif
@@ -5445,7 +5915,7 @@ void UServer_Base::runLoop(const char* user)
                   }
                else
                   {
-                  bool blookup = false;
+                  bool blookup;
                   char* ptr = rbuffer->data();
 
                   U_INTERNAL_DUMP("BytesRead(%u) = %#.*S", result, result, ptr)
@@ -5454,7 +5924,9 @@ void UServer_Base::runLoop(const char* user)
                   U_INTERNAL_ASSERT(UClientImage_Base::rbuffer->same(rbuffer))
                   U_ASSERT_EQUALS(UClientImage_Base::rbuffer->capacity(), rbuffer_size)
 
-                  rbuffer->size_adjust_force(result);
+                  rbuffer->size_adjust_force(UUDPBatch::bgro ? UQuic::splitCoalesced(result) : result);
+
+loop:             blookup = false;
 
                   if (UQuic::parseHeader() == false) goto next;
 
@@ -5483,9 +5955,18 @@ void UServer_Base::runLoop(const char* user)
                   U_DUMP("result = %d csocket->isClosed() = %b U_ClientImage_close = %b", result, csocket->isClosed(), U_ClientImage_close)
 
                // if (blookup == false) UQuic::insert();
+
+next:             // NB: we serve all the datagrams of the last batch (and the ones coalesced by GRO) before waiting for the next recvmsg()...
+
+                  if (UQuic::nextDatagram())
+                     {
+                     U_MEMCPY(&USocket::peer_addr, &UQuic::peer_addr, (rmsg.msg_namelen = UQuic::peer_addr_len));
+
+                     goto loop;
+                     }
                   }
 
-next:          prepareOperation(UClientImage_Base::_RECVMSG);
+               prepareOperation(UClientImage_Base::_RECVMSG);
                }
 #        endif
             else if (op == UClientImage_Base::_POLL)
@@ -527,6 +527,57 @@ bool USocket::enable_bpf()
 
    U_RETURN(false);
 }
+
+bool USocket::enable_bpf_quic(uint32_t n)
+{
+   U_TRACE(0, "USocket::enable_bpf_quic(%u)", n)
+
+   U_INTERNAL_ASSERT_MAJOR(n, 1)
+
+   /**
+    * QUIC connection ID steering: the filter distributes the ingress datagrams among the n SO_REUSEPORT sockets of the children
+    * on the first byte of the destination connection ID, so that all the packets of a connection are read by the same child.
+    * Long header packets carry the length of the destination connection ID at offset 5 and the connection ID at offset 6, short
+    * header packets carry the destination connection ID (of our fixed length) at offset 1. The datagrams without a connection ID
+    * are distributed on the flow hash.
+    *
+    * NB: the socket with index 0 in the group is the listener of the parent process (it is never read), the sockets of the children
+    * follow in order of bind. If a child restarts the kernel moves the last socket of the group in the slot of the dead one, so the
+    * connections steered to these two sockets are broken...
+    */
+
+   struct sock_filter code[] = {
+      /* A = first byte of the packet (header form) */
+      { BPF_LD  | BPF_B | BPF_ABS, 0, 0, 0 },
+      /* if (A & 0x80) == 0 (short header) goto 8 */
+      { BPF_JMP | BPF_JSET | BPF_K, 0, 6, 0x80 },
+      /* A = destination connection ID length */
+      { BPF_LD  | BPF_B | BPF_ABS, 0, 0, 5 },
+      /* if A != 0 goto 6 */
+      { BPF_JMP | BPF_JEQ | BPF_K, 0, 2, 0 },
+      /* A = skb->hash */
+      { BPF_LD  | BPF_W | BPF_ABS, 0, 0, (unsigned int)(SKF_AD_OFF + SKF_AD_RXHASH) },
+      /* goto 9 */
+      { BPF_JMP | BPF_JA, 0, 0, 3 },
+      /* A = first byte of the destination connection ID (long header) */
+      { BPF_LD  | BPF_B | BPF_ABS, 0, 0, 6 },
+      /* goto 9 */
+      { BPF_JMP | BPF_JA, 0, 0, 1 },
+      /* A = first byte of the destination connection ID (short header) */
+      { BPF_LD  | BPF_B | BPF_ABS, 0, 0, 1 },
+      /* A = A % n + 1 */
+      { BPF_ALU | BPF_MOD | BPF_K, 0, 0, n },
+      { BPF_ALU | BPF_ADD | BPF_K, 0, 0, 1 },
+      /* return A */
+      { BPF_RET | BPF_A, 0, 0, 0 }
+   };
+
+   struct sock_fprog p = { U_NUM_ELEMENTS(code), code };
+
+   if (setSockOpt(SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (void*)&p, sizeof(p))) U_RETURN(true);
+
+   U_RETURN(false);
+}
 #endif
 
 void USocket::reusePort(int _flags)
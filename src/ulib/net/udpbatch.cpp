@@ -0,0 +1,303 @@
+// ============================================================================
+//
+// = LIBRARY
+//    ULib - c++ library
+//
+// = FILENAME
+//    udpbatch.cpp - batched UDP I/O (recvmmsg/sendmmsg, GRO/GSO)
+//
+// = AUTHOR
+//    Stefano Casazza
+//
+// ============================================================================
+
+#include <ulib/net/udpbatch.h>
+
+bool                    UUDPBatch::bgso;
+bool                    UUDPBatch::bgro;
+char                    UUDPBatch::rcontrol[CMSG_SPACE(sizeof(int))];
+char                    UUDPBatch::vcontrol[U_UDP_BATCH][CMSG_SPACE(sizeof(int))];
+char                    UUDPBatch::batch_buffer[U_UDP_BATCH][U_UDP_BATCH_SIZE];
+uint32_t                UUDPBatch::batch_count;
+uint32_t                UUDPBatch::batch_index;
+uint32_t                UUDPBatch::batch_offset;
+uint32_t                UUDPBatch::vsegment[U_UDP_BATCH];
+u_mmsghdr               UUDPBatch::vmsg[U_UDP_BATCH];
+struct iovec            UUDPBatch::viov[U_UDP_BATCH];
+struct sockaddr_storage UUDPBatch::vpeer[U_UDP_BATCH];
+
+void UUDPBatch::init(int fd, bool bgro_enable)
+{
+   U_TRACE(0, "UUDPBatch::init(%d,%b)", fd, bgro_enable)
+
+   int val = 1;
+   socklen_t len = sizeof(val);
+
+   for (uint32_t i = 0; i < U_UDP_BATCH; ++i)
+      {
+      viov[i].iov_base = batch_buffer[i];
+      viov[i].iov_len  = U_UDP_BATCH_SIZE;
+
+      vmsg[i].msg_hdr.msg_name   = &vpeer[i];
+      vmsg[i].msg_hdr.msg_iov    = &viov[i];
+      vmsg[i].msg_hdr.msg_iovlen = 1;
+      }
+
+   batch_count  =
+   batch_index  =
+   batch_offset = 0;
+
+   // NB: with GRO the buffer of the read must be able to contain a super datagram of 64k, otherwise the data is truncated...
+
+   bgro = (bgro_enable && USocket::setSockOpt(fd, SOL_UDP, UDP_GRO, &val));
+   bgso = (U_SYSCALL(getsockopt, "%d,%d,%d,%p,%p", fd, SOL_UDP, UDP_SEGMENT, &val, &len) == 0);
+
+   U_INTERNAL_DUMP("bgro = %b bgso = %b", bgro, bgso)
+}
+
+int UUDPBatch::read(int fd, bool bwait_for_data)
+{
+   U_TRACE(0, "UUDPBatch::read(%d,%b)", fd, bwait_for_data)
+
+   U_INTERNAL_ASSERT_EQUALS(batch_index, batch_count)
+
+   int n;
+   uint32_t i;
+
+   for (i = 0; i < U_UDP_BATCH; ++i)
+      {
+      vmsg[i].msg_hdr.msg_flags      = 0;
+      vmsg[i].msg_hdr.msg_namelen    = sizeof(struct sockaddr_storage);
+      vmsg[i].msg_hdr.msg_control    = (bgro ? vcontrol[i] : U_NULLPTR);
+      vmsg[i].msg_hdr.msg_controllen = (bgro ? sizeof(vcontrol[i]) : 0);
+      }
+
+#ifdef HAVE_RECVMMSG
+   // NB: MSG_WAITFORONE turns on MSG_DONTWAIT after the first datagram has been received...
+
+   n = U_SYSCALL(recvmmsg, "%d,%p,%u,%d,%p", fd, vmsg, U_UDP_BATCH, (bwait_for_data ? MSG_WAITFORONE : MSG_DONTWAIT), U_NULLPTR);
+#else
+   ssize_t value = U_SYSCALL(recvmsg, "%d,%p,%d", fd, &vmsg[0].msg_hdr, (bwait_for_data ? 0 : MSG_DONTWAIT));
+
+   if (value < 0) n = -1;
+   else
+      {
+      n = 1;
+
+      vmsg[0].msg_len = value;
+      }
+#endif
+
+   if (n > 0)
+      {
+      for (i = 0; i < (uint32_t)n; ++i) vsegment[i] = getSegmentSize(&vmsg[i].msg_hdr, vmsg[i].msg_len);
+
+      batch_count  = n;
+      batch_index  =
+      batch_offset = 0;
+      }
+
+   U_RETURN(n);
+}
+
+uint32_t UUDPBatch::next(char* buffer, uint32_t size, struct sockaddr_storage* peer, uint32_t* peer_len)
+{
+   U_TRACE(0, "UUDPBatch::next(%p,%u,%p,%p)", buffer, size, peer, peer_len)
+
+   uint32_t len, sz;
+
+   while (batch_index < batch_count)
+      {
+      len = vmsg[batch_index].msg_len;
+
+      if (batch_offset < len)
+         {
+         sz = U_min(vsegment[batch_index], len - batch_offset);
+
+         U_INTERNAL_DUMP("batch_index = %u batch_offset = %u len = %u sz = %u", batch_index, batch_offset, len, sz)
+
+         if (sz > size) sz = size; // NB: the datagram is truncated...
+
+         U_MEMCPY(buffer, batch_buffer[batch_index] + batch_offset, sz);
+         U_MEMCPY(peer, &vpeer[batch_index], (*peer_len = vmsg[batch_index].msg_hdr.msg_namelen));
+
+         batch_offset += vsegment[batch_index];
+
+         U_RETURN(sz);
+         }
+
+      ++batch_index;
+
+      batch_offset = 0;
+      }
+
+   U_RETURN(0);
+}
+
+uint32_t UUDPBatch::split(struct msghdr* msg, const char* data, uint32_t len)
+{
+   U_TRACE(0, "UUDPBatch::split(%p,%p,%u)", msg, data, len)
+
+   U_INTERNAL_ASSERT(bgro)
+   U_INTERNAL_ASSERT_EQUALS(batch_index, batch_count)
+
+   uint32_t segment = getSegmentSize(msg, len);
+
+   if (segment < len)
+      {
+      // NB: GRO coalesces only datagrams of the same flow, we keep the others to return them with next()...
+
+      U_MEMCPY(batch_buffer[0], data + segment, len - segment);
+      U_MEMCPY(&vpeer[0], msg->msg_name, (vmsg[0].msg_hdr.msg_namelen = msg->msg_namelen));
+
+      vmsg[0].msg_len = len - segment;
+      vsegment[0]     = segment;
+
+      batch_count  = 1;
+      batch_index  =
+      batch_offset = 0;
+      }
+
+   U_RETURN(segment);
+}
+
+bool UUDPBatch::sendSegments(int fd, const struct sockaddr* peer, uint32_t peer_len, const uint8_t* ptr, uint32_t len, uint32_t segment)
+{
+   U_TRACE(0, "UUDPBatch::sendSegments(%d,%p,%u,%p,%u,%u)", fd, peer, peer_len, ptr, len, segment)
+
+   ssize_t sent;
+   struct msghdr msg;
+   struct iovec iov = { (void*)ptr, len };
+   char control[CMSG_SPACE(sizeof(uint16_t))];
+
+   (void) U_SYSCALL(memset, "%p,%u,%u", &msg, 0, sizeof(msg));
+
+   msg.msg_name    = (void*)peer;
+   msg.msg_namelen = peer_len;
+   msg.msg_iov     = &iov;
+   msg.msg_iovlen  = 1;
+
+   if (segment)
+      {
+      struct cmsghdr* cmsg;
+
+      (void) U_SYSCALL(memset, "%p,%u,%u", control, 0, sizeof(control));
+
+      msg.msg_control    = control;
+      msg.msg_controllen = sizeof(control);
+
+      cmsg = CMSG_FIRSTHDR(&msg);
+
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type  = UDP_SEGMENT;
+      cmsg->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+
+      *(uint16_t*)CMSG_DATA(cmsg) = segment;
+      }
+
+   sent = U_SYSCALL(sendmsg, "%d,%p,%d", fd, &msg, 0);
+
+   if (sent == (ssize_t)len)
+      {
+      U_DEBUG("UUDPBatch: sent %u bytes (%u datagrams)", len, segment ? (len + segment - 1) / segment : 1)
+
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+bool UUDPBatch::send(int fd, const struct sockaddr* peer, uint32_t peer_len, const uint8_t* ptr, const uint32_t* vsize, uint32_t n)
+{
+   U_TRACE(0, "UUDPBatch::send(%d,%p,%u,%p,%p,%u)", fd, peer, peer_len, ptr, vsize, n)
+
+   U_INTERNAL_ASSERT_RANGE(1, n, U_UDP_MAX_SEGMENT)
+
+   int sent;
+   uint32_t i = 0, j, k, len, segment;
+
+   while (bgso &&
+          i < n)
+      {
+      // a run of packets of the same size (the last one can be shorter) is a GSO super datagram
+
+      for (len = segment = vsize[i], j = i+1; j < n; ++j)
+         {
+         if (vsize[j] > segment ||
+             (len + vsize[j]) > U_UDP_MAX_GSO_SIZE)
+            {
+            break;
+            }
+
+         len += vsize[j];
+
+         if (vsize[j] < segment)
+            {
+            ++j;
+
+            break;
+            }
+         }
+
+      if (sendSegments(fd, peer, peer_len, ptr, len, (j - i) > 1 ? segment : 0) == false)
+         {
+         if ((j - i) == 1 ||
+             (errno != EIO && errno != EINVAL))
+            {
+            U_DEBUG("UUDPBatch::send(): failed to send")
+
+            U_RETURN(false);
+            }
+
+         bgso = false;
+
+         U_WARNING("UDP GSO not available on fd %d%R, fall back to sendmmsg()", fd, 0); // NB: the last argument (0) is necessary...
+
+         break;
+         }
+
+      ptr += len;
+      i    = j;
+      }
+
+   if (i < n)
+      {
+      struct iovec iov[U_UDP_MAX_SEGMENT];
+      u_mmsghdr msg[U_UDP_MAX_SEGMENT];
+
+      (void) U_SYSCALL(memset, "%p,%u,%u", msg, 0, sizeof(msg));
+
+      for (k = 0; i < n; ++i, ++k)
+         {
+         iov[k].iov_base = (void*)ptr;
+         iov[k].iov_len  = vsize[i];
+
+         ptr += vsize[i];
+
+         msg[k].msg_hdr.msg_name    = (void*)peer;
+         msg[k].msg_hdr.msg_namelen = peer_len;
+         msg[k].msg_hdr.msg_iov     = &iov[k];
+         msg[k].msg_hdr.msg_iovlen  = 1;
+         }
+
+      for (j = 0; j < k; j += sent)
+         {
+#     ifdef HAVE_SENDMMSG
+         sent = U_SYSCALL(sendmmsg, "%d,%p,%u,%d", fd, msg + j, k - j, 0);
+#     else
+         sent = (U_SYSCALL(sendmsg, "%d,%p,%d", fd, &msg[j].msg_hdr, 0) < 0 ? -1 : 1);
+#     endif
+
+         if (sent <= 0)
+            {
+            U_DEBUG("UUDPBatch::send(): failed to send")
+
+            U_RETURN(false);
+            }
+
+         U_DEBUG("UUDPBatch: sent %u datagrams", sent)
+         }
+      }
+
+   U_RETURN(true);
+}
@@ -345,6 +345,15 @@ void UNotifier::suspend(UEventFd* item)
 #endif
 }
 
+void UNotifier::setReadOnce()
+{
+   U_TRACE_NO_PARAM(0, "UNotifier::setReadOnce()")
+
+#ifdef U_EPOLLET_POSTPONE_STRATEGY
+   U_ClientImage_state = U_PLUGIN_HANDLER_AGAIN; // NB: the loop of the postpone strategy check it after the call of handlerRead()...
+#endif
+}
+
 int UNotifier::waitForEvent4(int fd_max, fd_set* read_set, fd_set* write_set, UEventTime* ptimeout)
 {
    U_TRACE(1, "UNotifier::waitForEvent4(%d,%p,%p,%p)", fd_max, read_set, write_set, ptimeout)
@@ -668,6 +677,10 @@ loop:
    if (nfd_ready == 0 &&
        ptimeout  != U_NULLPTR)
       {
+      // NB: with the timing wheel the expired alarms are processed in batch by UTimer::getTimeout()...
+
+      if (UTimer::bwheel) goto loop;
+
       U_INTERNAL_ASSERT_EQUALS(UTimer::first->alarm, ptimeout)
 
       U_gettimeofday // NB: optimization if it is enough a time resolution of one second...
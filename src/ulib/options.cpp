@@ -62,6 +62,11 @@
 #else
 #  define LIBBROTLI_ENABLE   "no"
 #endif
+#ifdef USE_LIBZSTD
+#  define LIBZSTD_ENABLE     "yes ( " _LIBZSTD_VERSION " )"
+#else
+#  define LIBZSTD_ENABLE     "no"
+#endif
 #ifdef USE_LIBQUICHE
 #  define LIBQUICHE_ENABLE   "yes ( " _LIBQUICHE_VERSION " )"
 #else
@@ -741,6 +746,7 @@ PYTHON language support: yes ( 2.7 )
       "LIBZ support...........:%W " LIBZ_ENABLE "%W\n" \
       "LIBZOPFLI support......:%W " LIBZOPFLI_ENABLE "%W\n" \
       "LIBBROTLI support......:%W " LIBBROTLI_ENABLE "%W\n" \
+      "LIBZSTD support........:%W " LIBZSTD_ENABLE "%W\n" \
       "LIBQUICHE support......:%W " LIBQUICHE_ENABLE "%W\n" \
       "LIBURING support.......:%W " LIBURING_ENABLE "%W\n" \
       "LIBARGON2 support......:%W " LIBARGON2_ENABLE "%W\n" \
@@ -798,6 +804,7 @@ PYTHON language support: yes ( 2.7 )
                BRIGHTGREEN, RESET,
                BRIGHTGREEN, RESET,
                BRIGHTGREEN, RESET,
+               BRIGHTGREEN, RESET,
                // wrapping
                BRIGHTYELLOW, RESET,
                BRIGHTYELLOW, RESET,
@@ -228,6 +228,12 @@ UOrmDriver* UOrmDriverMySql::handlerConnect(const UString& option)
       (void) U_SYSCALL(mysql_set_character_set, "%p,%S", (MYSQL*)pdrv->connection, ptr);
       }
 
+   // number of prepared statement in the cache of the connection (0 -> disabled)
+
+   UString stmt_cache = pdrv->getOptionValue(U_CONSTANT_TO_PARAM("stmt_cache"));
+
+   pdrv->setStatementCache(stmt_cache ? stmt_cache.strtoul() : 16);
+
    U_RETURN_POINTER(pdrv, UOrmDriver);
 }
 
@@ -596,6 +602,69 @@ void UOrmDriverMySql::execute(USqlStatement* pstmt)
       }
 }
 
+bool UOrmDriverMySql::executeMany(USqlStatement* pstmt, uint32_t n, vPFu function, vPFu result)
+{
+   U_TRACE(0, "UOrmDriverMySql::executeMany(%p,%u,%p,%p)", pstmt, n, function, result)
+
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+   U_INTERNAL_ASSERT_POINTER(function)
+   U_INTERNAL_ASSERT_POINTER(UOrmDriver::connection)
+
+   /**
+    * A statement that NOT produces a result set (write) is wrapped in one transaction (autocommit disabled) if we are not
+    * already in one, so the server commit only one time for all the rows. NB: the MySQL client API has no array binding
+    * for the prepared statement (STMT_ATTR_ARRAY_SIZE is only of MariaDB) so the rows are executed one at a time...
+    */
+
+   bool btransaction = (pstmt->num_bind_result == 0 &&
+                        (((MYSQL*)UOrmDriver::connection)->server_status & SERVER_STATUS_IN_TRANS) == 0);
+
+   if (btransaction &&
+       U_SYSCALL(mysql_autocommit, "%p,%b", (MYSQL*)UOrmDriver::connection, false))
+      {
+      UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+      U_RETURN(false);
+      }
+
+   for (uint32_t i = 0; i < n; ++i)
+      {
+      function(i);
+
+      execute(pstmt);
+
+      if (UOrmDriver::errcode &&
+          UOrmDriver::errcode != MYSQL_NO_DATA)
+         {
+         if (btransaction)
+            {
+            (void) U_SYSCALL(mysql_rollback,   "%p",    (MYSQL*)UOrmDriver::connection);
+            (void) U_SYSCALL(mysql_autocommit, "%p,%b", (MYSQL*)UOrmDriver::connection, true);
+            }
+
+         U_RETURN(false);
+         }
+
+      if (result) result(i);
+      }
+
+   if (btransaction)
+      {
+      UOrmDriver::errcode = U_SYSCALL(mysql_commit, "%p", (MYSQL*)UOrmDriver::connection);
+
+      (void) U_SYSCALL(mysql_autocommit, "%p,%b", (MYSQL*)UOrmDriver::connection, true);
+
+      if (UOrmDriver::errcode)
+         {
+         UOrmDriver::printError(__PRETTY_FUNCTION__);
+
+         U_RETURN(false);
+         }
+      }
+
+   U_RETURN(true);
+}
+
 bool UOrmDriverMySql::nextRow(USqlStatement* pstmt)
 {
    U_TRACE(0, "UOrmDriverMySql::nextRow(%p)", pstmt)
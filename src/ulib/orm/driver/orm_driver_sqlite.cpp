@@ -197,6 +197,12 @@ UOrmDriver* UOrmDriverSqlite::handlerConnect(const UString& option)
    (void) U_SYSCALL(sqlite3_exec, "%p,%S,%p,%p,%p", (sqlite3*)pdrv->connection, "PRAGMA mmap_size=44040192", U_NULLPTR, U_NULLPTR, U_NULLPTR);
    (void) U_SYSCALL(sqlite3_exec, "%p,%S,%p,%p,%p", (sqlite3*)pdrv->connection, "PRAGMA locking_mode=EXCLUSIVE", U_NULLPTR, U_NULLPTR, U_NULLPTR);
 
+   // number of prepared statement in the cache of the connection (0 -> disabled)
+
+   x = pdrv->getOptionValue(U_CONSTANT_TO_PARAM("stmt_cache"));
+
+   pdrv->setStatementCache(x ? x.strtoul() : 16);
+
    U_RETURN_POINTER(pdrv, UOrmDriver);
 }
 
@@ -575,6 +581,54 @@ retry:
       }
 }
 
+bool UOrmDriverSqlite::executeMany(USqlStatement* pstmt, uint32_t n, vPFu function, vPFu result)
+{
+   U_TRACE(0, "UOrmDriverSqlite::executeMany(%p,%u,%p,%p)", pstmt, n, function, result)
+
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+   U_INTERNAL_ASSERT_POINTER(function)
+   U_INTERNAL_ASSERT_POINTER(UOrmDriver::connection)
+
+   /**
+    * In autocommit mode every statement is a transaction (with the cost of the lock and the journal of the database),
+    * so a statement that NOT produces a result set (write) is wrapped in one transaction if we are not already in one
+    */
+
+   bool btransaction = (pstmt->num_bind_result == 0 &&
+                        U_SYSCALL(sqlite3_get_autocommit, "%p", (sqlite3*)UOrmDriver::connection) != 0);
+
+   if (btransaction &&
+       handlerQuery(U_CONSTANT_TO_PARAM("BEGIN")) == false)
+      {
+      U_RETURN(false);
+      }
+
+   for (uint32_t i = 0; i < n; ++i)
+      {
+      function(i);
+
+      execute(pstmt);
+
+      if (UOrmDriver::errcode != SQLITE_ROW && // (100) sqlite3_step() has another row ready
+          UOrmDriver::errcode != SQLITE_DONE)  // (101) sqlite3_step() has finished executing
+         {
+         if (btransaction) (void) handlerQuery(U_CONSTANT_TO_PARAM("ROLLBACK"));
+
+         U_RETURN(false);
+         }
+
+      if (result) result(i);
+      }
+
+   if (btransaction &&
+       handlerQuery(U_CONSTANT_TO_PARAM("COMMIT")) == false)
+      {
+      U_RETURN(false);
+      }
+
+   U_RETURN(true);
+}
+
 bool UOrmDriverSqlite::nextRow(USqlStatement* pstmt)
 {
    U_TRACE(0, "UOrmDriverSqlite::nextRow(%p)", pstmt)
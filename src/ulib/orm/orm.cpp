@@ -114,6 +114,7 @@ UOrmSession::~UOrmSession()
 
    if (pdrv)
       {
+      pdrv->clearStatementCache();
       pdrv->handlerDisConnect();
 
       if (UOrmDriver::vdriver->find(pdrv) != U_NOT_FOUND) pdrv->vopt.clear();
@@ -203,7 +204,7 @@ UOrmStatement::UOrmStatement(UOrmSession& session, const char* stmt, uint32_t le
    if (session.pdrv)
       {
       pdrv  = (psession = &session)->pdrv;
-      pstmt = pdrv->handlerStatementCreation(stmt, len);
+      pstmt = pdrv->getStatement(stmt, len);
 
       U_INTERNAL_DUMP("psession = %p pdrv = %p pstmt = %p", psession, pdrv, pstmt)
 
@@ -232,7 +233,7 @@ UOrmStatement::~UOrmStatement()
          {
          U_INTERNAL_ASSERT_EQUALS(pdrv, psession->pdrv)
 
-         pdrv->remove(pstmt);
+         pdrv->releaseStatement(pstmt);
          }
       }
 #endif
@@ -251,6 +252,21 @@ void UOrmStatement::execute()
 #endif
 }
 
+bool UOrmStatement::executeMany(uint32_t n, vPFu function, vPFu result)
+{
+   U_TRACE(0, "UOrmStatement::executeMany(%u,%p,%p)", n, function, result)
+
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+   U_INTERNAL_ASSERT_POINTER(psession->pdrv)
+   U_INTERNAL_ASSERT_EQUALS(pdrv, psession->pdrv)
+
+#if defined(USE_SQLITE) || defined(USE_MYSQL) || defined(USE_PGSQL)
+   if (pdrv->executeMany(pstmt, n, function, result)) U_RETURN(true);
+#endif
+
+   U_RETURN(false);
+}
+
 // statement that should only be executed once and immediately
 
 bool UOrmSession::query(const char* stmt, uint32_t len)
@@ -38,6 +38,8 @@ UVector<UOrmDriver*>* UOrmDriver::vdriver;
 UOrmDriver::~UOrmDriver()
 {
    U_TRACE_DTOR(0, UOrmDriver)
+
+   if (vstmt) UMemoryPool::_free(vstmt, vstmt_capacity, sizeof(void*));
 }
 
 void UOrmDriver::clear()
@@ -365,6 +367,156 @@ USqlStatementBindParam* UOrmDriver::creatSqlStatementBindParam(USqlStatement* ps
    U_RETURN_POINTER(param, USqlStatementBindParam);
 }
 
+// CACHE of PREPARED STATEMENT
+
+void UOrmDriver::setStatementCache(uint32_t n)
+{
+   U_TRACE(0, "UOrmDriver::setStatementCache(%u)", n)
+
+   clearStatementCache();
+
+   if (vstmt)
+      {
+      UMemoryPool::_free(vstmt, vstmt_capacity, sizeof(void*));
+
+      vstmt = U_NULLPTR;
+      }
+
+   if ((vstmt_capacity = n)) vstmt = (USqlStatement**) UMemoryPool::cmalloc(n, sizeof(void*));
+}
+
+void UOrmDriver::clearStatementCache()
+{
+   U_TRACE_NO_PARAM(0, "UOrmDriver::clearStatementCache()")
+
+   U_INTERNAL_DUMP("vstmt_size = %u", vstmt_size)
+
+   for (uint32_t i = 0; i < vstmt_size; ++i)
+      {
+      USqlStatement* pstmt = vstmt[i];
+
+      pstmt->bcache = false;
+
+      // NB: a statement in use is removed by the destructor of the UOrmStatement...
+
+      if (pstmt->bused == false) handlerStatementRemove(pstmt);
+      }
+
+   vstmt_size = 0;
+}
+
+USqlStatement* UOrmDriver::getStatement(const char* stmt, uint32_t len)
+{
+   U_TRACE(0, "UOrmDriver::getStatement(%.*S,%u)", len, stmt, len)
+
+   USqlStatement* pstmt;
+
+   if (vstmt_capacity == 0)
+      {
+      pstmt = handlerStatementCreation(stmt, len);
+
+      U_RETURN_POINTER(pstmt, USqlStatement);
+      }
+
+   uint32_t i;
+
+   for (i = 0; i < vstmt_size; ++i)
+      {
+      pstmt = vstmt[i];
+
+      if (pstmt->bused == false &&
+          pstmt->sql.equal(stmt, len))
+         {
+         // NB: the most recently used is the first...
+
+         if (i)
+            {
+            (void) U_SYSCALL(memmove, "%p,%p,%u", vstmt+1, vstmt, i * sizeof(void*));
+
+            vstmt[0] = pstmt;
+            }
+
+         pstmt->bused = true;
+
+         U_RETURN_POINTER(pstmt, USqlStatement);
+         }
+      }
+
+   pstmt = handlerStatementCreation(stmt, len);
+
+   if (pstmt == U_NULLPTR) U_RETURN_POINTER(U_NULLPTR, USqlStatement);
+
+   if (vstmt_size == vstmt_capacity)
+      {
+      // NB: we drop the least recently used statement that is not in use...
+
+      for (i = vstmt_size; i > 0; --i)
+         {
+         if (vstmt[i-1]->bused == false) break;
+         }
+
+      if (i-- == 0) U_RETURN_POINTER(pstmt, USqlStatement); // NB: all the statement of the cache are in use...
+
+      vstmt[i]->bcache = false;
+
+      handlerStatementRemove(vstmt[i]);
+
+      (void) U_SYSCALL(memmove, "%p,%p,%u", vstmt+i, vstmt+i+1, (--vstmt_size - i) * sizeof(void*));
+      }
+
+   (void) U_SYSCALL(memmove, "%p,%p,%u", vstmt+1, vstmt, vstmt_size++ * sizeof(void*));
+
+   vstmt[0] = pstmt;
+
+   (void) pstmt->sql.replace(stmt, len);
+
+   pstmt->bcache =
+   pstmt->bused  = true;
+
+   U_INTERNAL_DUMP("vstmt_size = %u", vstmt_size)
+
+   U_RETURN_POINTER(pstmt, USqlStatement);
+}
+
+void UOrmDriver::releaseStatement(USqlStatement* pstmt)
+{
+   U_TRACE(0, "UOrmDriver::releaseStatement(%p)", pstmt)
+
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+
+   if (pstmt->bcache == false) handlerStatementRemove(pstmt);
+   else
+      {
+      U_INTERNAL_ASSERT(pstmt->bused)
+
+      // NB: the bindings refer to the variables of the UOrmStatement...
+
+      reset(pstmt);
+
+      pstmt->bused                      = false;
+      pstmt->asyncPipelineHandlerResult = U_NULLPTR;
+      }
+}
+
+bool UOrmDriver::executeMany(USqlStatement* pstmt, uint32_t n, vPFu function, vPFu result)
+{
+   U_TRACE(0, "UOrmDriver::executeMany(%p,%u,%p,%p)", pstmt, n, function, result)
+
+   U_INTERNAL_ASSERT_POINTER(pstmt)
+   U_INTERNAL_ASSERT_POINTER(function)
+
+   for (uint32_t i = 0; i < n; ++i)
+      {
+      function(i);
+
+      execute(pstmt);
+
+      if (result) result(i);
+      }
+
+   U_RETURN(true);
+}
+
 // BIND PARAM
 
 template <> void UOrmDriver::bindParam<int>(USqlStatement* pstmt, int& v)
@@ -675,6 +827,8 @@ const char* USqlStatement::dump(bool _reset) const
                   << "num_row_result                             " << num_row_result                    << '\n'
                   << "num_bind_param                             " << num_bind_param                    << '\n'
                   << "num_bind_result                            " << num_bind_result                   << '\n'
+                  << "bcache                                     " << bcache                            << '\n'
+                  << "bused                                      " << bused                             << '\n'
                   << "asyncPipelineHandlerResult                 " << (void*)asyncPipelineHandlerResult << '\n'
                   << "vparam  (UVector<USqlStatementBindParam*>  " << (void*)&vparam                    << ")\n"
                   << "vresult (UVector<USqlStatementBindResult*> " << (void*)&vresult                   << ')';
@@ -697,6 +851,9 @@ const char* UOrmDriver::dump(bool _reset) const
                   << "opt    (UString          " << (void*)&opt       << ")\n"
                   << "name   (UString          " << (void*)&name      << ")\n"
                   << "dbname (UString          " << (void*)&dbname    << ")\n"
+                  << "vstmt                    " << (void*)vstmt      << '\n'
+                  << "vstmt_size               " << vstmt_size        << '\n'
+                  << "vstmt_capacity           " << vstmt_capacity    << '\n'
                   << "vopt   (UVector<UString> " << (void*)&vopt      << ')';
 
    if (_reset)
@@ -12,12 +12,11 @@
 // =================================================================================
 
 #include <ulib/query/parser.h>
+#include <ulib/utility/string_ext.h>
 
-bPFpr                 UQueryParser::function;
-uint32_t              UQueryParser::partial;
-UVector<UString>**    UQueryParser::positives;
-UVector<UString>**    UQueryParser::negatives;
-UVector<UQueryNode*>* UQueryParser::termRoots;
+bPFpr                     UQueryParser::function;
+uint32_t                  UQueryParser::cache_max;
+UHashMap<UQueryProgram*>* UQueryParser::cache;
 
 UQueryNode::UQueryNode(Type t, UQueryNode* l, UQueryNode* r) : left(l), right(r), type(t)
 {
@@ -46,33 +45,18 @@ void UQueryParser::clear()
       U_DELETE(tree)
 
       tree = U_NULLPTR;
+      }
 
-      U_INTERNAL_DUMP("termRoots = %p", termRoots)
-
-      if (termRoots)
-         {
-         UVector<UString>* pvec1;
-         UVector<UString>* pvec2;
-         uint32_t sz = termRoots->size();
-
-         for (uint32_t i = 0; i < sz; ++i)
-            {
-            pvec1 = negatives[i];
-            pvec2 = positives[i];
-
-            U_INTERNAL_DUMP("pvec1 = %p pvec2 = %p", pvec1, pvec2)
-
-            U_DELETE(pvec1)
-            U_DELETE(pvec2)
-            }
+   U_INTERNAL_DUMP("program = %p bcache = %b", program, bcache)
 
-         UMemoryPool::_free(negatives, sz, sizeof(void*));
-         UMemoryPool::_free(positives, sz, sizeof(void*));
+   if (program)
+      {
+      // NB: the program in the cache is shared...
 
-         U_DELETE(termRoots)
+      if (bcache == false) U_DELETE(program)
 
-         termRoots = U_NULLPTR;
-         }
+      program = U_NULLPTR;
+      bcache  = false;
       }
 
    t.str.clear();
@@ -895,159 +879,350 @@ UQueryNode* UQueryNode::getDisjunctiveNormalForm(UQueryNode* root)
  * the AND a multiplicative operation, then the DNF is a sum of products
  */
 
-void UQueryParser::startEvaluate(bPFpr func)
+void UQueryParser::startEvaluate(bPFpr func, uPFpr cost)
 {
-   U_TRACE(0, "UQueryParser::startEvaluate(%p)", func)
+   U_TRACE(0, "UQueryParser::startEvaluate(%p,%p)", func, cost)
 
    U_INTERNAL_ASSERT_POINTER(tree)
    U_INTERNAL_ASSERT_POINTER(func)
-   U_INTERNAL_ASSERT_EQUALS(termRoots,U_NULLPTR)
+   U_INTERNAL_ASSERT_EQUALS(program, U_NULLPTR)
 
    function = func;
 
-   U_NEW(UVector<UQueryNode*>, termRoots, UVector<UQueryNode*>);
+   U_NEW(UQueryProgram, program, UQueryProgram(tree, cost));
+}
 
-   tree->getDNFTermRoots(termRoots);
+void UQueryParser::setCache(uint32_t max_program)
+{
+   U_TRACE(0, "UQueryParser::setCache(%u)", max_program)
 
-   uint32_t sz = termRoots->size();
+   clearCache();
 
-   negatives = (UVector<UString>**) UMemoryPool::cmalloc(sz, sizeof(void*));
-   positives = (UVector<UString>**) UMemoryPool::cmalloc(sz, sizeof(void*));
+   cache_max = max_program;
 
-   for (uint32_t i = 0; i < sz; ++i)
+   if (cache_max &&
+       cache == U_NULLPTR)
       {
-      U_NEW(UVector<UString>, negatives[i], UVector<UString>);
-      U_NEW(UVector<UString>, positives[i], UVector<UString>);
+      U_NEW(UHashMap<UQueryProgram*>, cache, UHashMap<UQueryProgram*>);
+      }
+}
 
-      UQueryNode* term = termRoots->at(i);
+void UQueryParser::clearCache()
+{
+   U_TRACE_NO_PARAM(0, "UQueryParser::clearCache()")
 
-      U_INTERNAL_ASSERT_POINTER(term)
+   // NB: the program of a parser in use must not be in the cache...
 
-      term->getTreeVariables(positives[i], negatives[i]);
+   if (cache &&
+       cache->empty() == false)
+      {
+      cache->clear();
       }
 }
 
-void UQueryParser::evaluate(UStringRep* _word, bool positive)
+bool UQueryParser::compile(const UString& query, uPFpr cost)
 {
-   U_TRACE(0, "UQueryParser::evaluate(%V,%b)", _word, positive)
+   U_TRACE(0, "UQueryParser::compile(%V,%p)", query.rep, cost)
 
-   U_INTERNAL_ASSERT_EQUALS(partial, 1)
+   U_INTERNAL_ASSERT_EQUALS(tree, U_NULLPTR)
+   U_INTERNAL_ASSERT_EQUALS(program, U_NULLPTR)
 
-   U_INTERNAL_DUMP("u_buffer_len = %u", u_buffer_len)
+   if (cache_max == 0)
+      {
+      if (parse(query))
+         {
+         U_NEW(UQueryProgram, program, UQueryProgram(tree, cost));
 
-   /**
-    * EXAMPLE
-    * --------------------------------------------------------------------------------------
-    * Original expression     : (a OR b) AND NOT (c AND d)
-    * Disjunctive normal form : a AND  NOT c OR a AND  NOT d OR b AND  NOT c OR b AND  NOT d
-    * --------------------------------------------------------------------------------------
-    *  Term       : a AND  NOT c
-    *  Positives: ( a )
-    *  Negatives: ( c )
-    * --------------------------------------------------------------------------------------
-    *  Term       : a AND  NOT d
-    *  Positives: ( a )
-    *  Negatives: ( d )
-    * --------------------------------------------------------------------------------------
-    *  Term       : b AND  NOT c
-    *  Positives: ( b )
-    *  Negatives: ( c )
-    * --------------------------------------------------------------------------------------
-    *  Term       : b AND  NOT d
-    *  Positives: ( b )
-    *  Negatives: ( d )
-    * --------------------------------------------------------------------------------------
-    */
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
+   U_INTERNAL_ASSERT_POINTER(cache)
 
-   char* p = (u_buffer_len ? (char*) u_find(u_buffer, u_buffer_len, (const char*)&_word, sizeof(void*)) : U_NULLPTR);
+   // NB: the key is the normalized query (the spaces don't change the expression)...
 
-   bool result = (p ? (p[sizeof(void*)] == '1') : function(_word));
+   UString key = UStringExt::simplifyWhiteSpace(query);
 
-   if (!p)
+   program = cache->at(key);
+
+   if (program)
       {
-      union _uustringrep {
-         UStringRep* p2;
-         long*       p3;
-      };
+      bcache = true;
 
-      _uustringrep pword;
+      U_RETURN(true);
+      }
 
-      p = u_buffer + u_buffer_len;
+   if (parse(query) == false) U_RETURN(false);
 
-      pword.p2 = _word;
+   U_NEW(UQueryProgram, program, UQueryProgram(tree, cost));
 
-#  if SIZEOF_LONG == 8
-      u_put_unalignedp64(p, *pword.p3);
-#  else
-      u_put_unalignedp32(p, *pword.p3);
-#  endif
+   // NB: when the cache is full we drop all the programs (the queries of a workload are often the same few...)
+
+   if (cache->size() >= cache_max) cache->clear();
+
+   cache->insert(key, program);
+
+   bcache = true;
+
+   U_RETURN(true);
+}
 
-      u_buffer_len += sizeof(long);
+/**
+ * EXAMPLE
+ * --------------------------------------------------------------------------------------
+ * Original expression     : (a OR b) AND NOT (c AND d)
+ * Disjunctive normal form : a AND  NOT c OR a AND  NOT d OR b AND  NOT c OR b AND  NOT d
+ * --------------------------------------------------------------------------------------
+ * words: 0 -> a, 1 -> c, 2 -> d, 3 -> b
+ *
+ * code: [ 2, 0, 1|NOT, 2, 0, 2|NOT, 2, 3, 1|NOT, 2, 3, 2|NOT ]
+ * --------------------------------------------------------------------------------------
+ */
+
+UQueryProgram::UQueryProgram(UQueryNode* tree, uPFpr cost)
+{
+   U_TRACE_CTOR(0, UQueryProgram, "%p,%p", tree, cost)
+
+   code      = U_NULLPTR;
+   positives =
+   negatives = U_NULLPTR;
+   nterm     =
+   ncode     = 0;
+
+   if (tree == U_NULLPTR) return;
+
+   UVector<UQueryNode*> termRoots;
+
+   tree->getDNFTermRoots(&termRoots);
+
+   nterm = termRoots.size();
+
+   negatives = (UVector<UString>**) UMemoryPool::cmalloc(nterm, sizeof(void*));
+   positives = (UVector<UString>**) UMemoryPool::cmalloc(nterm, sizeof(void*));
 
-      u_buffer[u_buffer_len++] = (result ? '1' : '0');
+   uint32_t i, j, n, k = 0;
 
-      U_INTERNAL_ASSERT_MINOR(u_buffer_len, U_BUFFER_SIZE)
+   for (i = 0; i < nterm; ++i)
+      {
+      U_NEW(UVector<UString>, negatives[i], UVector<UString>);
+      U_NEW(UVector<UString>, positives[i], UVector<UString>);
+
+      termRoots[i]->getTreeVariables(positives[i], negatives[i]);
+
+      ncode += 1 + positives[i]->size() + negatives[i]->size();
       }
 
-   if (( positive && !result) ||
-       (!positive &&  result))
+   U_INTERNAL_DUMP("nterm = %u ncode = %u", nterm, ncode)
+
+   code = (uint32_t*) UMemoryPool::cmalloc(ncode, sizeof(uint32_t));
+
+   uint32_t* off = (uint32_t*) UMemoryPool::cmalloc(nterm, sizeof(uint32_t)); // the start of the terms
+
+   for (i = 0; i < nterm; ++i)
       {
-      partial = 0;
+      off[i] = k;
+
+      code[k++] = positives[i]->size() + negatives[i]->size();
+
+      for (j = 0, n = positives[i]->size(); j < n; ++j) code[k++] = addWord(positives[i]->at(j));
+      for (j = 0, n = negatives[i]->size(); j < n; ++j) code[k++] = addWord(negatives[i]->at(j)) | U_QUERY_NOT;
+      }
+
+   U_INTERNAL_ASSERT_EQUALS(k, ncode)
+
+   if (cost)
+      {
+      uint32_t w, lit, c, nword = vword.size();
+      uint32_t* vcost = (uint32_t*) UMemoryPool::cmalloc(nword, sizeof(uint32_t));
+      uint32_t* tkey  = (uint32_t*) UMemoryPool::cmalloc(nterm, sizeof(uint32_t));
+
+      for (w = 0; w < nword; ++w) vcost[w] = cost(vword[w].rep);
+
+      // NB: in a term first the positives by increasing cost (the rarest word make the term false as soon as possible),
+      //     after the negatives by decreasing cost (the commonest word make the term false as soon as possible)...
+
+      for (i = 0; i < nterm; ++i)
+         {
+         uint32_t* p = code + off[i] + 1;
+
+         for (n = p[-1], j = 1; j < n; ++j)
+            {
+            lit = p[j];
+            c   = vcost[lit & ~U_QUERY_NOT];
+
+            for (k = j; k > 0; --k)
+               {
+               uint32_t prev  = p[k-1],
+                        cprev = vcost[prev & ~U_QUERY_NOT];
+
+               if ((prev & U_QUERY_NOT) == (lit & U_QUERY_NOT) ? ((lit & U_QUERY_NOT) ? (c <= cprev) : (c >= cprev))
+                                                               : ((lit & U_QUERY_NOT) != 0))
+                  {
+                  break;
+                  }
+
+               p[k] = prev;
+               }
+
+            p[k] = lit;
+            }
+
+         // NB: the key of the term is the cost of the rarest positive (a term without positives is probably true)...
+
+         tkey[i] = (n && (p[0] & U_QUERY_NOT) == 0 ? vcost[p[0]] : U_NOT_FOUND);
+
+         U_INTERNAL_DUMP("term[%u] = %u key = %u", i, n, tkey[i])
+         }
+
+      // NB: the terms by decreasing key (the term with more probability to be true first), with the same key the shorter first...
+
+      uint32_t* perm = (uint32_t*) UMemoryPool::cmalloc(nterm, sizeof(uint32_t));
+
+      for (i = 0; i < nterm; ++i)
+         {
+         for (k = i; k > 0; --k)
+            {
+            j = perm[k-1];
+
+            if (tkey[j] >  tkey[i] ||
+               (tkey[j] == tkey[i] && code[off[j]] <= code[off[i]]))
+               {
+               break;
+               }
+
+            perm[k] = j;
+            }
+
+         perm[k] = i;
+         }
+
+      uint32_t* _code = (uint32_t*) UMemoryPool::cmalloc(ncode, sizeof(uint32_t));
+      UVector<UString>** _positives = (UVector<UString>**) UMemoryPool::cmalloc(nterm, sizeof(void*));
+      UVector<UString>** _negatives = (UVector<UString>**) UMemoryPool::cmalloc(nterm, sizeof(void*));
+
+      for (i = k = 0; i < nterm; ++i)
+         {
+         j = perm[i];
+         n = code[off[j]] + 1;
+
+         U_MEMCPY(_code + k, code + off[j], n * sizeof(uint32_t));
+
+         // NB: the words of the term in the order of the program...
+
+         _positives[i] = positives[j];
+         _negatives[i] = negatives[j];
+
+         _positives[i]->clear();
+         _negatives[i]->clear();
+
+         for (w = 1; w < n; ++w)
+            {
+            lit = _code[k+w];
+
+            if ((lit & U_QUERY_NOT) == 0) _positives[i]->push_back(vword[lit]);
+            else                          _negatives[i]->push_back(vword[lit & ~U_QUERY_NOT]);
+            }
+
+         k += n;
+         }
+
+      UMemoryPool::_free(code,      ncode, sizeof(uint32_t));
+      UMemoryPool::_free(positives, nterm, sizeof(void*));
+      UMemoryPool::_free(negatives, nterm, sizeof(void*));
+
+      code      = _code;
+      positives = _positives;
+      negatives = _negatives;
+
+      UMemoryPool::_free(perm,  nterm, sizeof(uint32_t));
+      UMemoryPool::_free(tkey,  nterm, sizeof(uint32_t));
+      UMemoryPool::_free(vcost, nword, sizeof(uint32_t));
       }
 
-   U_INTERNAL_DUMP("partial = %u result = %b", partial, result)
+   UMemoryPool::_free(off, nterm, sizeof(uint32_t));
 }
 
-inline bool UQueryParser::pos_evaluate(void* _word)
+UQueryProgram::~UQueryProgram()
 {
-   U_TRACE(0, "UQueryParser::pos_evaluate(%p)", _word)
+   U_TRACE_DTOR(0, UQueryProgram)
 
-   evaluate((UStringRep*)_word, true);
-
-   if (partial == 1) U_RETURN(true);
+   if (nterm)
+      {
+      for (uint32_t i = 0; i < nterm; ++i)
+         {
+         U_DELETE(negatives[i])
+         U_DELETE(positives[i])
+         }
 
-   U_RETURN(false);
+      UMemoryPool::_free(negatives, nterm, sizeof(void*));
+      UMemoryPool::_free(positives, nterm, sizeof(void*));
+      UMemoryPool::_free(code,      ncode, sizeof(uint32_t));
+      }
 }
 
-inline bool UQueryParser::neg_evaluate(void* _word)
+U_NO_EXPORT uint32_t UQueryProgram::addWord(const UString& w)
 {
-   U_TRACE(0, "UQueryParser::neg_evaluate(%p)", _word)
+   U_TRACE(0, "UQueryProgram::addWord(%V)", w.rep)
 
-   if (partial) evaluate((UStringRep*)_word, false);
+   uint32_t i = vword.find(w);
 
-   if (partial == 1) U_RETURN(true);
+   if (i == U_NOT_FOUND)
+      {
+      i = vword.size();
 
-   U_RETURN(false);
+      vword.push_back(w);
+      }
+
+   U_RETURN(i);
 }
 
-bool UQueryParser::evaluate() const
+bool UQueryProgram::evaluate(bPFpr function) const
 {
-   U_TRACE_NO_PARAM(0, "UQueryParser::evaluate()")
+   U_TRACE(0, "UQueryProgram::evaluate(%p)", function)
+
+   U_INTERNAL_ASSERT_POINTER(function)
+
+   // NB: the value of the words: 0 -> not evaluated, 1 -> false, 2 -> true...
 
-   U_INTERNAL_ASSERT_POINTER(termRoots)
+   char buffer[256];
+   uint32_t nword = vword.size();
+   char* value = (nword <= sizeof(buffer) ? buffer : (char*)UMemoryPool::cmalloc(nword));
 
-   U_INTERNAL_ASSERT_EQUALS(u_buffer_len, 0)
+   (void) U_SYSCALL(memset, "%p,%d,%u", value, 0, nword);
 
-   for (uint32_t i = 0, sz = termRoots->size(); i < sz; ++i)
+   bool result = false;
+   const uint32_t* p   = code;
+   const uint32_t* end = code + ncode;
+
+   while (p < end)
       {
-      partial = 1;
+      const uint32_t* next = p + 1 + p[0];
+
+      for (++p; p < next; ++p)
+         {
+         uint32_t lit = *p,
+                    w = (lit & ~U_QUERY_NOT);
 
-      if (positives[i]->empty() == false) positives[i]->callForAllEntry(pos_evaluate);
-      if (negatives[i]->empty() == false) negatives[i]->callForAllEntry(neg_evaluate);
+         if (value[w] == 0) value[w] = (function(vword[w].rep) ? 2 : 1);
 
-      U_INTERNAL_DUMP("partial = %u", partial)
+         if ((value[w] == 2) == ((lit & U_QUERY_NOT) != 0)) break; // NB: the term is false...
+         }
 
-      if (partial)
+      if (p == next)
          {
-         u_buffer_len = 0;
+         result = true;
 
-         U_RETURN(true);
+         break;
          }
+
+      p = next;
       }
 
-   u_buffer_len = 0;
+   if (value != buffer) UMemoryPool::_free(value, nword);
 
-   U_RETURN(false);
+   U_RETURN(result);
 }
 
 // STREAMS
@@ -1112,6 +1287,29 @@ U_EXPORT ostream& operator<<(ostream& os, const UQueryNode& e)
    return os;
 }
 
+U_EXPORT ostream& operator<<(ostream& os, const UQueryProgram& p)
+{
+   uint32_t i, j, n, lit, k = 0;
+
+   for (i = 0; i < p.nterm; ++i)
+      {
+      if (i) os << ' ' << *UString::str_or << ' ';
+
+      for (j = 0, n = p.code[k++]; j < n; ++j)
+         {
+         lit = p.code[k++];
+
+         if (j) os << ' ' << *UString::str_and << ' ';
+
+         if (lit & U_QUERY_NOT) os << ' ' << *UString::str_not << ' ';
+
+         os << p.vword[lit & ~U_QUERY_NOT];
+         }
+      }
+
+   return os;
+}
+
 // DEBUG
 
 #  ifdef DEBUG
@@ -1132,9 +1330,30 @@ const char* UQueryNode::dump(bool reset) const
    return U_NULLPTR;
 }
 
+const char* UQueryProgram::dump(bool reset) const
+{
+   *UObjectIO::os << "code               " << (void*)code      << '\n'
+                  << "nterm              " << nterm            << '\n'
+                  << "ncode              " << ncode            << '\n'
+                  << "positives          " << (void*)positives << '\n'
+                  << "negatives          " << (void*)negatives << '\n'
+                  << "vword (UVector     " << (void*)&vword    << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return U_NULLPTR;
+}
+
 const char* UQueryParser::dump(bool reset) const
 {
    *UObjectIO::os << "tree              " << (void*)tree    << '\n'
+                  << "bcache            " << bcache         << '\n'
+                  << "program           " << (void*)program << '\n'
                   << "word  (UString    " << (void*)&word   << ")\n"
                   << "t     (UTokenizer " << (void*)&t      << ')';
 
@@ -15,6 +15,12 @@
 #include <ulib/utility/uhttp.h>
 #include <ulib/ssl/net/ssl_session.h>
 
+#include <openssl/rand.h>
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#  include <openssl/core_names.h>
+#endif
+
 /**
  * Forward secrecy
  *
@@ -33,6 +39,7 @@
  */
 
 SSL_SESSION* USSLSession::sess;
+long         USSLSession::ticket_key_rotate = U_ONE_HOUR_IN_SECOND;
 
 // define method VIRTUAL of class UDataStorage
 
@@ -148,3 +155,125 @@ void USSLSession::removeSession(SSL_CTX* ctx, SSL_SESSION* _sess)
       U_WARNING("Remove of SSL session on db failed with error %d", result);
       }
 }
+
+/**
+ * Session Ticket (RFC 5077, and the PSK of TLS 1.3 that with OpenSSL are stateless tickets too)
+ *
+ * The state of the session is encrypted with a key of the server and sent to the client, so there is nothing to write on resumption.
+ * The keys are in the shared data of UServer, so a ticket issued by a child is accepted by all the others. The key of the new tickets
+ * is rotated every ticket_key_rotate seconds by the first child that see the expiration (without lock, with a compare and swap on the
+ * time of the rotation). The tickets of the previous key are accepted too (and renewed), the key before that is the one overwritten by
+ * the rotation. This bound how long a stolen key can decrypt the past connections (see the Forward secrecy note above)...
+ */
+
+void USSLSession::generateTicketKey(uint32_t idx)
+{
+   U_TRACE(0, "USSLSession::generateTicketKey(%u)", idx)
+
+   unsigned char* key = U_SRV_SSL_TICKET_KEY[idx % U_SSL_TICKET_KEY_NUM];
+
+   if (U_SYSCALL(RAND_bytes, "%p,%d", key, sizeof(U_SRV_SSL_TICKET_KEY[0])) != 1) U_ERROR("SSL: generation of the session ticket key failed");
+}
+
+void USSLSession::rotateTicketKey()
+{
+   U_TRACE_NO_PARAM(0, "USSLSession::rotateTicketKey()")
+
+   long t = U_SRV_SSL_TICKET_KEY_TIME;
+
+   U_INTERNAL_DUMP("t = %ld u_now->tv_sec = %ld ticket_key_rotate = %ld", t, u_now->tv_sec, ticket_key_rotate)
+
+   if ((u_now->tv_sec - t) >= ticket_key_rotate &&
+       __sync_bool_compare_and_swap(&U_SRV_SSL_TICKET_KEY_TIME, t, u_now->tv_sec)) // NB: only one child win the race...
+      {
+      uint32_t idx = U_SRV_SSL_TICKET_KEY_INDEX + 1;
+
+      generateTicketKey(idx);
+
+      __atomic_store_n(&U_SRV_SSL_TICKET_KEY_INDEX, idx, __ATOMIC_RELEASE); // NB: the new key is seen by all the children at once...
+
+      U_SRV_LOG("SSL: session ticket key rotated (index %u)", idx);
+      }
+}
+
+void USSLSession::initTicketKey()
+{
+   U_TRACE_NO_PARAM(0, "USSLSession::initTicketKey()")
+
+   U_INTERNAL_ASSERT_POINTER(USSLSocket::sctx)
+   U_INTERNAL_ASSERT_POINTER(UServer_Base::ptr_shared_data)
+   U_INTERNAL_ASSERT_MAJOR(ticket_key_rotate, 0)
+
+   // NB: all the slots must have a random name, a slot left to zero would accept a forged ticket with a zero name and zero keys...
+
+   for (uint32_t i = 0; i < U_SSL_TICKET_KEY_NUM; ++i) generateTicketKey(i);
+
+   U_SRV_SSL_TICKET_KEY_TIME  = u_now->tv_sec;
+   U_SRV_SSL_TICKET_KEY_INDEX = 0;
+
+   // NB: with the tickets there is no need of the session cache (neither in memory nor on db)...
+
+   (void) U_SYSCALL(SSL_CTX_set_session_cache_mode, "%p,%d", USSLSocket::sctx, SSL_SESS_CACHE_OFF);
+
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+   (void) U_SYSCALL(SSL_CTX_set_tlsext_ticket_key_cb,     "%p,%p", USSLSocket::sctx, USSLSession::ticketKey);
+#else
+   (void) U_SYSCALL(SSL_CTX_set_tlsext_ticket_key_evp_cb, "%p,%p", USSLSocket::sctx, USSLSession::ticketKey);
+#endif
+
+   U_SRV_LOG("SSL session ticket initialization success: key rotation every %ld seconds", ticket_key_rotate);
+}
+
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+int USSLSession::ticketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* ectx, HMAC_CTX*    hctx, int enc)
+#else
+int USSLSession::ticketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* ectx, EVP_MAC_CTX* hctx, int enc)
+#endif
+{
+   U_TRACE(0, "USSLSession::ticketKey(%p,%p,%p,%p,%p,%d)", ssl, name, iv, ectx, hctx, enc)
+
+   rotateTicketKey();
+
+   unsigned char* key;
+   uint32_t i, idx = __atomic_load_n(&U_SRV_SSL_TICKET_KEY_INDEX, __ATOMIC_ACQUIRE);
+
+   if (enc) // new ticket
+      {
+      key = U_SRV_SSL_TICKET_KEY[idx % U_SSL_TICKET_KEY_NUM];
+
+      if (U_SYSCALL(RAND_bytes, "%p,%d", iv, 16) != 1) U_RETURN(-1);
+
+      U_MEMCPY(name, key, 16);
+
+      i = 0;
+
+      goto init;
+      }
+
+   for (i = 0; i < 2 && i <= idx; ++i) // NB: we accept the current key and the previous one (if there was a rotation)...
+      {
+      key = U_SRV_SSL_TICKET_KEY[(idx + U_SSL_TICKET_KEY_NUM - i) % U_SSL_TICKET_KEY_NUM];
+
+      if (memcmp(name, key, 16) == 0) goto init;
+      }
+
+   U_RETURN(0); // unknown key (or expired): full handshake
+
+init:
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+   (void) U_SYSCALL(HMAC_Init_ex, "%p,%p,%d,%p,%p", hctx, key+48, 32, EVP_sha256(), U_NULLPTR);
+#else
+   OSSL_PARAM params[3];
+
+   params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key+48, 32);
+   params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char*)"SHA256", 0);
+   params[2] = OSSL_PARAM_construct_end();
+
+   (void) U_SYSCALL(EVP_MAC_CTX_set_params, "%p,%p", hctx, params);
+#endif
+
+   if (enc) (void) U_SYSCALL(EVP_EncryptInit_ex, "%p,%p,%p,%p,%p", ectx, EVP_aes_256_cbc(), U_NULLPTR, key+16, iv);
+   else     (void) U_SYSCALL(EVP_DecryptInit_ex, "%p,%p,%p,%p,%p", ectx, EVP_aes_256_cbc(), U_NULLPTR, key+16, iv);
+
+   U_RETURN(i == 0 ? 1 : 2); // 2 => the ticket of the previous key is renewed
+}
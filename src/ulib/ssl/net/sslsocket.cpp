@@ -36,6 +36,12 @@
 int      USSLSocket::session_cache_index;
 SSL_CTX* USSLSocket::cctx; // client
 SSL_CTX* USSLSocket::sctx; // server
+uint32_t USSLSocket::stats_ktls;
+uint32_t USSLSocket::stats_resumed;
+uint32_t USSLSocket::stats_handshake;
+uint32_t USSLSocket::stats_handshake_failed;
+uint64_t USSLSocket::stats_handshake_time;
+uint64_t USSLSocket::stats_handshake_failed_time;
 
 #if defined(ENABLE_THREAD) && !defined(OPENSSL_NO_OCSP) && defined(SSL_CTRL_SET_TLSEXT_STATUS_REQ_CB)
 bool                 USSLSocket::ocsp_nonce;
@@ -1196,6 +1202,8 @@ bool USSLSocket::acceptSSL(USSLSocket* pcNewConnection)
 
    int fd         = pcNewConnection->iSockDesc;
    uint32_t count = 0;
+   uint64_t cpu_time = 0;
+   struct timespec start, end;
 
    U_DUMP("fd = %d isBlocking() = %b", fd, pcNewConnection->isBlocking())
 
@@ -1218,10 +1226,30 @@ bool USSLSocket::acceptSSL(USSLSocket* pcNewConnection)
 loop:
    errno = 0;
 
+   (void) clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start); // NB: we measure only the CPU time of the handshake (not the wait for the client)...
+
    ret   = U_SYSCALL(SSL_accept, "%p", ssl); // get SSL handshake with client
 
+   (void) clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+
+   cpu_time += (end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_nsec - start.tv_nsec) / 1000L;
+
    if (ret == 1)
       {
+      ++stats_handshake;
+
+      stats_handshake_time += cpu_time;
+
+      if (SSL_session_reused(ssl)) ++stats_resumed;
+
+#  ifdef SSL_OP_ENABLE_KTLS
+      // NB: OpenSSL install the keys in the kernel (setsockopt(TLS_TX/TLS_RX)) only if the cipher negotiated and the kernel support it...
+
+      pcNewConnection->setKTLS(BIO_get_ktls_send(SSL_get_wbio(ssl)));
+
+      if (pcNewConnection->isKTLS()) ++stats_ktls;
+#  endif
+
       SSL_set_app_data(ssl, pcNewConnection);
       pcNewConnection->ssl            = ssl;
       pcNewConnection->ret            = SSL_ERROR_NONE;
@@ -1243,6 +1271,10 @@ loop:
 
    errno = -pcNewConnection->iState;
 
+   ++stats_handshake_failed;
+
+   stats_handshake_failed_time += cpu_time; // NB: the failed handshake are not in the average...
+
    U_SYSCALL_VOID(SSL_free, "%p", ssl);
                                   ssl = U_NULLPTR;
    pcNewConnection->USocket::_close_socket();
@@ -573,15 +573,59 @@ void UThread::sleep(time_t timeoutMS)
 
 // THREAD POOL
 
-UThreadPool::UThreadPool(uint32_t size) : UThread(PTHREAD_CREATE_DETACHED), pool(size)
+#if defined(__i386__) || defined(__x86_64__)
+#  define U_CPU_RELAX() __builtin_ia32_pause()
+#else
+#  define U_CPU_RELAX() __asm__ __volatile__("" : : : "memory")
+#endif
+
+#define U_THREAD_POOL_SPIN  512 // number of attempts to find a task before to park the worker (cpu relax between them)
+#define U_THREAD_POOL_YIELD   8 // the same with only one cpu (sched_yield() between them, to spin is only a waste)
+
+#ifdef U_LINUX
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#endif
+
+static __thread void* current_worker; // NB: void* because the type UThreadPool::worker is protected...
+
+void UThreadPool::runParallelFor(void* arg) // NB: the tasks of a parallelFor() grab chunk of index till they are finished...
+{
+   U_TRACE(0, "UThreadPool::runParallelFor(%p)", arg)
+
+   uint32_t i, end;
+   loop* ctx = (loop*)arg;
+
+   while ((i = __atomic_fetch_add(&ctx->next, ctx->grain, __ATOMIC_RELAXED)) < ctx->n)
+      {
+      end = U_min(i + ctx->grain, ctx->n);
+
+      do { ctx->func(ctx->arg, i); } while (++i < end);
+      }
+
+   (void) __atomic_add_fetch(&ctx->nfinished, 1, __ATOMIC_RELEASE);
+}
+
+UThreadPool::UThreadPool(uint32_t size)
 {
    U_TRACE_CTOR(0, UThreadPool, "%u", size)
 
-   UThread* th;
+   U_INTERNAL_ASSERT_MAJOR(size, 0)
+
+   worker* w;
+
+   active      = true;
+   inject_size = 256;
+   num_worker  = size;
+   inject      = (task*) U_SYSCALL_MALLOC(inject_size * sizeof(task)); // NB: the workers can grow it, so we don't use UMemoryPool...
+   vworker     = (worker*) UMemoryPool::pmalloc(&size, sizeof(worker), true);
+   max_worker  = size; // NB: pmalloc() can round up the number of the elements allocated...
 
-   active = true;
+   max_spin    = (u_get_num_cpu() > 1 ? U_THREAD_POOL_SPIN : U_THREAD_POOL_YIELD);
 
-#if defined(_MSWINDOWS_)
+   inject_head = inject_len = num_running = pending = sleepers = searching = wake_seq = done_seq = num_waiter = 0;
+
+#ifdef _MSWINDOWS_
    // Task queue mutex
    InitializeCriticalSection(&tasks_mutex);
 # if _WIN32_WINNT >= 0x0600
@@ -589,133 +633,599 @@ UThreadPool::UThreadPool(uint32_t size) : UThread(PTHREAD_CREATE_DETACHED), pool
    InitializeConditionVariable(&condition);
    InitializeConditionVariable(&condition_task_finished);
 # endif
-   // This starts a free standing procedure as a thread.
-   // That thread instantiates the class and calls its main method
-   void* NO_SECURITY_ATTRIBUTES = NULL;
-   const unsigned CREATE_IN_RUN_STATE    = 0;
-   const unsigned USE_DEFAULT_STACK_SIZE = 0;
+#else
+   pthread_attr_t attr;
+
+   // Task queue mutex
+   tasks_mutex = PTHREAD_MUTEX_INITIALIZER;
+   // Condition variable
+   condition               =
+   condition_task_finished = PTHREAD_COND_INITIALIZER;
+
+   (void) pthread_attr_init(&attr);
+   (void) pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+#endif
 
-   for (uint32_t i = 0; i < size; ++i)
+   for (uint32_t i = 0; i < num_worker; ++i)
       {
-      U_NEW(UThread, th, UThread(UThread::detachstate));
+      w = vworker+i;
+
+      w->pool  = this;
+      w->index = i;
+      w->rnd   = u_get_num_random_range1(0x7fffffff) | 1;
 
-      if (_beginthreadex(NO_SECURITY_ATTRIBUTES, USE_DEFAULT_STACK_SIZE, execHandler, this, CREATE_IN_RUN_STATE, (unsigned int*)&id) == 0)
+#  ifdef _MSWINDOWS_
+      if ((w->tid = (HANDLE)_beginthreadex(U_NULLPTR, 0, execHandler, w, 0, U_NULLPTR)) == 0)
+#  else
+      if (pthread_create(&(w->tid), &attr, execHandler, w))
+#  endif
          {
-         int m_thread_start_error;
-         errno_t m_return_value = _get_errno(&m_thread_start_error);
+         U_WARNING("UThreadPool: create thread fail, we have only %u workers", i);
 
-         if (m_return_value == 0)
-            {
-            U_WARNING("Create Thread Fail, error %d", m_thread_start_error);
-            }
+         num_worker = i;
+
+         break;
+         }
+      }
+
+#ifndef _MSWINDOWS_
+   (void) pthread_attr_destroy(&attr);
+#endif
+
+   U_INTERNAL_ASSERT_MAJOR(num_worker, 0)
+}
+
+UThreadPool::~UThreadPool()
+{
+   U_TRACE_DTOR(0, UThreadPool)
+
+   // NB: the workers stop after the current task, the tasks not yet started are discarded (and the UThread* deleted)...
+
+   __atomic_store_n(&active, false, __ATOMIC_SEQ_CST);
+
+   wakeUp(num_worker);
+
+   for (uint32_t i = 0; i < num_worker; ++i)
+      {
+#  ifdef _MSWINDOWS_
+      (void) WaitForSingleObject(vworker[i].tid, INFINITE);
+
+      (void) CloseHandle(vworker[i].tid);
+#  else
+      (void) U_SYSCALL(pthread_join, "%p,%p", vworker[i].tid, U_NULLPTR);
+#  endif
+      }
+
+   for (uint32_t i = 0; i < inject_len; ++i) deleteTask(inject[(inject_head + i) % inject_size]);
+
+   for (uint32_t i = 0; i < num_worker; ++i)
+      {
+      worker* w = vworker+i;
+
+      for (long j = w->top; j < w->bottom; ++j) deleteTask(w->buffer[j & (U_THREAD_POOL_DEQUE_SIZE-1)]);
+      }
+
+   U_SYSCALL_FREE(inject);
+
+   UMemoryPool::_free(vworker, max_worker, sizeof(worker));
+
+#ifdef _MSWINDOWS_
+   DeleteCriticalSection(&tasks_mutex);
+#endif
+}
+
+#ifdef _MSWINDOWS_
+unsigned __stdcall UThreadPool::execHandler(void* w)
+#else
+void* UThreadPool::execHandler(void* w)
+#endif
+{
+   U_TRACE(0, "UThreadPool::execHandler(%p)", w)
+
+   U_INTERNAL_ASSERT_POINTER(w)
+
+#ifndef _MSWINDOWS_
+   sigset_t mask; // NB: the signals are for the main thread...
+
+   (void) sigfillset(&mask);
+
+   (void) U_SYSCALL(pthread_sigmask, "%d,%p,%p", SIG_BLOCK, &mask, U_NULLPTR);
+#endif
+
+   current_worker = w;
+
+   ((worker*)w)->pool->run((worker*)w);
+
+   current_worker = U_NULLPTR;
+
+   return 0;
+}
+
+UThreadPool::worker* UThreadPool::getWorker()
+{
+   U_TRACE_NO_PARAM(0, "UThreadPool::getWorker()")
+
+   return (worker*)current_worker;
+}
+
+/**
+ * The deque of the worker (Chase-Lev, "Correct and Efficient Work-Stealing for Weak Memory Models", Le et al. 2013)
+ *
+ * push() and take() are called only by the owner of the deque, steal() by all the other threads
+ */
+
+bool UThreadPool::push(worker* w, const task& t)
+{
+   U_TRACE(0, "UThreadPool::push(%p,%p)", w, &t)
+
+   long b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED),
+        _t = __atomic_load_n(&w->top,    __ATOMIC_ACQUIRE);
+
+   if ((b - _t) >= U_THREAD_POOL_DEQUE_SIZE) U_RETURN(false); // full
+
+   w->buffer[b & (U_THREAD_POOL_DEQUE_SIZE-1)] = t;
+
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+
+   __atomic_store_n(&w->bottom, b+1, __ATOMIC_RELAXED);
+
+   U_RETURN(true);
+}
+
+bool UThreadPool::take(worker* w, task& t)
+{
+   U_TRACE(0, "UThreadPool::take(%p,%p)", w, &t)
+
+   long b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED) - 1;
+
+   __atomic_store_n(&w->bottom, b, __ATOMIC_RELAXED);
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   long _t = __atomic_load_n(&w->top, __ATOMIC_RELAXED);
+
+   if (_t > b) // empty
+      {
+      __atomic_store_n(&w->bottom, b+1, __ATOMIC_RELAXED);
+
+      U_RETURN(false);
+      }
+
+   t = w->buffer[b & (U_THREAD_POOL_DEQUE_SIZE-1)];
+
+   if (_t == b) // last element: we race with the thieves
+      {
+      bool result = __atomic_compare_exchange_n(&w->top, &_t, _t+1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+
+      __atomic_store_n(&w->bottom, b+1, __ATOMIC_RELAXED);
+
+      U_RETURN(result);
+      }
+
+   U_RETURN(true);
+}
+
+int UThreadPool::steal(worker* w, task& t) // return value: 1 -> ok, 0 -> empty, -1 -> lost the race
+{
+   U_TRACE(0, "UThreadPool::steal(%p,%p)", w, &t)
+
+   long _t = __atomic_load_n(&w->top, __ATOMIC_ACQUIRE);
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   long b = __atomic_load_n(&w->bottom, __ATOMIC_ACQUIRE);
+
+   if (_t >= b) U_RETURN(0);
+
+   t.func = __atomic_load_n(&w->buffer[_t & (U_THREAD_POOL_DEQUE_SIZE-1)].func, __ATOMIC_RELAXED);
+   t.arg  = __atomic_load_n(&w->buffer[_t & (U_THREAD_POOL_DEQUE_SIZE-1)].arg,  __ATOMIC_RELAXED);
+
+   if (__atomic_compare_exchange_n(&w->top, &_t, _t+1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) U_RETURN(1);
+
+   U_RETURN(-1);
+}
+
+bool UThreadPool::stealTask(worker* w, task& t)
+{
+   U_TRACE(0, "UThreadPool::stealTask(%p,%p)", w, &t)
+
+   if (num_worker == 1) U_RETURN(false);
+
+   task x;
+   worker* victim;
+   long avail, half, got;
+
+   w->rnd ^= w->rnd << 13; // xorshift
+   w->rnd ^= w->rnd >> 17;
+   w->rnd ^= w->rnd <<  5;
+
+   for (uint32_t i = 0, start = w->rnd % num_worker; i < num_worker; ++i)
+      {
+      victim = vworker + ((start + i) % num_worker);
+
+      if (victim == w) continue;
+
+      avail = __atomic_load_n(&victim->bottom, __ATOMIC_ACQUIRE) -
+              __atomic_load_n(&victim->top,    __ATOMIC_ACQUIRE);
+
+      if (avail <= 0) continue;
+
+      // we steal half of the tasks of the victim: the first we run it, the others go in our deque (that is empty now)
+
+      half = (avail + 1) / 2;
+
+      for (got = 0; got < half && steal(victim, x) == 1; ++got)
+         {
+         if (got == 0) t = x;
          else
             {
-            U_WARNING("Create Thread Fail, get_errno fail, returned %d", m_return_value);
+            if (push(w, x) == false) pushInject(&x, 1);
             }
+         }
 
-         U_DELETE(th)
+      if (got)
+         {
+         __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-         continue;
+         if (got > 1 &&
+             isToWakeUp())
+            {
+            wakeUp(1); // there is something to steal now also from us...
+            }
+
+         U_RETURN(true);
          }
+      }
+
+   U_RETURN(false);
+}
 
-      pool.push_back(th);
+void UThreadPool::pushInject(const task* vt, uint32_t n)
+{
+   U_TRACE(0, "UThreadPool::pushInject(%p,%u)", vt, n)
+
+   UThread::lock(&tasks_mutex);
+
+   if ((inject_len + n) > inject_size)
+      {
+      uint32_t sz = inject_size;
+
+      while ((inject_len + n) > sz) sz <<= 1;
+
+      task* ptr = (task*) U_SYSCALL_MALLOC(sz * sizeof(task));
+
+      for (uint32_t i = 0; i < inject_len; ++i) ptr[i] = inject[(inject_head + i) % inject_size];
+
+      U_SYSCALL_FREE(inject);
+
+      inject      = ptr;
+      inject_size = sz;
+      inject_head = 0;
       }
-#else
-   pthread_attr_t attr;
 
-   // Task queue mutex
-   tasks_mutex = PTHREAD_MUTEX_INITIALIZER;
-   // Condition variable
-   condition               =
-   condition_task_finished = PTHREAD_COND_INITIALIZER;
+   for (uint32_t i = 0; i < n; ++i) inject[(inject_head + inject_len + i) % inject_size] = vt[i];
 
-   (void) pthread_attr_init(&attr);
-   (void) pthread_attr_setdetachstate(&attr, UThread::detachstate);
+   __atomic_store_n(&inject_len, inject_len + n, __ATOMIC_RELEASE);
+
+   UThread::unlock(&tasks_mutex);
+}
+
+bool UThreadPool::popInject(worker* w, task& t)
+{
+   U_TRACE(0, "UThreadPool::popInject(%p,%p)", w, &t)
+
+   if (__atomic_load_n(&inject_len, __ATOMIC_ACQUIRE) == 0) U_RETURN(false);
+
+   UThread::lock(&tasks_mutex);
+
+   uint32_t n = inject_len;
+
+   if (n == 0)
+      {
+      UThread::unlock(&tasks_mutex);
+
+      U_RETURN(false);
+      }
+
+   // a worker take in batch its share of the queue (an external caller only one task)
 
-   for (uint32_t i = 0; i < size; ++i)
+   if (w == U_NULLPTR) n = 1;
+   else
       {
-      U_NEW(UThread, th, UThread(UThread::detachstate));
+      n = U_min(U_max(n / num_worker, 1), U_THREAD_POOL_DEQUE_SIZE / 2);
+      }
+
+   t = inject[inject_head];
 
-      if (pthread_create(&(th->tid), &attr, (pvPFpv)execHandler, this))
+   for (uint32_t i = 1; i < n; ++i)
+      {
+      if (push(w, inject[(inject_head + i) % inject_size]) == false)
          {
-         U_DELETE(th)
+         n = i;
 
-         continue;
+         break;
+         }
+      }
+
+   inject_head = (inject_head + n) % inject_size;
+
+   __atomic_store_n(&inject_len, inject_len - n, __ATOMIC_RELEASE);
+
+   UThread::unlock(&tasks_mutex);
+
+   U_RETURN(true);
+}
+
+bool UThreadPool::getTask(worker* w, task& t)
+{
+   U_TRACE(0, "UThreadPool::getTask(%p,%p)", w, &t)
+
+   if (w)
+      {
+      if (take(w, t)        ||
+          popInject(w, t)   ||
+          stealTask(w, t))
+         {
+         U_RETURN(true);
          }
 
-      pool.push_back(th);
+      U_RETURN(false);
       }
 
-   (void) pthread_attr_destroy(&attr);
-#endif
+   if (popInject(U_NULLPTR, t)) U_RETURN(true);
 
-   UTimeVal::nanosleep(200); // wait for UThreadPool init completion
+   U_RETURN(false);
 }
 
-UThreadPool::~UThreadPool()
+void UThreadPool::runTask(const task& t)
 {
-   U_TRACE_DTOR(0, UThread)
+   U_TRACE(0, "UThreadPool::runTask(%p)", &t)
 
-   active = false;
+   t.func(t.arg);
 
-   lock(&tasks_mutex);
+   if (__atomic_sub_fetch(&pending, 1, __ATOMIC_SEQ_CST) == 0 &&
+       __atomic_load_n(&num_waiter,    __ATOMIC_SEQ_CST))
+      {
+      (void) __atomic_add_fetch(&done_seq, 1, __ATOMIC_SEQ_CST);
 
-   signalAll(&condition);
+#  ifdef U_LINUX
+      (void) syscall(SYS_futex, &done_seq, FUTEX_WAKE_PRIVATE, INT_MAX, U_NULLPTR, U_NULLPTR, 0);
+#  else
+      UThread::lock(&tasks_mutex);
+      UThread::signalAll(&condition_task_finished);
+      UThread::unlock(&tasks_mutex);
+#  endif
+      }
+}
 
-   queue.clear();
+void UThreadPool::wakeUp(uint32_t n)
+{
+   U_TRACE(0, "UThreadPool::wakeUp(%u)", n)
 
-   unlock(&tasks_mutex);
+   (void) __atomic_add_fetch(&wake_seq, 1, __ATOMIC_SEQ_CST);
 
-#ifdef _MSWINDOWS_
-   DeleteCriticalSection(&tasks_mutex);
+#ifdef U_LINUX
+   (void) syscall(SYS_futex, &wake_seq, FUTEX_WAKE_PRIVATE, n, U_NULLPTR, U_NULLPTR, 0);
+#else
+   UThread::lock(&tasks_mutex);
+
+   if (n == 1) UThread::signal(   &condition);
+   else        UThread::signalAll(&condition);
+
+   UThread::unlock(&tasks_mutex);
 #endif
 }
 
-// define method VIRTUAL of class UThread
+void UThreadPool::run(worker* w)
+{
+   U_TRACE(0, "UThreadPool::run(%p)", w)
+
+   task t;
+   uint32_t spin, seq;
+
+   (void) __atomic_add_fetch(&num_running, 1, __ATOMIC_RELAXED);
+
+   while (__atomic_load_n(&active, __ATOMIC_RELAXED))
+      {
+      if (getTask(w, t))
+         {
+         runTask(t);
+
+         continue;
+         }
+
+      // NB: a searching worker find the new tasks without to be woken up, so the submitter don't need to call futex()...
+
+      (void) __atomic_add_fetch(&searching, 1, __ATOMIC_SEQ_CST);
+
+      for (spin = 0; spin < max_spin; ++spin)
+         {
+         if (max_spin == U_THREAD_POOL_SPIN) U_CPU_RELAX();
+         else                       (void) sched_yield();
+
+         if (getTask(w, t)) break;
+         }
 
-void UThreadPool::run()
+      (void) __atomic_sub_fetch(&searching, 1, __ATOMIC_SEQ_CST);
+
+      if (spin < max_spin)
+         {
+         runTask(t);
+
+         continue;
+         }
+
+      // NB: before to park we must check again for work after to be registered as sleeper, the submitter first push the task and then check for sleepers...
+
+      seq = __atomic_load_n(&wake_seq, __ATOMIC_SEQ_CST);
+
+      (void) __atomic_add_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+
+      if (getTask(w, t))
+         {
+         (void) __atomic_sub_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+
+         runTask(t);
+
+         continue;
+         }
+
+      if (__atomic_load_n(&active, __ATOMIC_SEQ_CST))
+         {
+#     ifdef U_LINUX
+         (void) syscall(SYS_futex, &wake_seq, FUTEX_WAIT_PRIVATE, seq, U_NULLPTR, U_NULLPTR, 0);
+#     else
+         UThread::lock(&tasks_mutex);
+
+         while (__atomic_load_n(&wake_seq, __ATOMIC_SEQ_CST) == seq) UThread::wait(&tasks_mutex, &condition);
+
+         UThread::unlock(&tasks_mutex);
+#     endif
+         }
+
+      (void) __atomic_sub_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+      }
+
+   (void) __atomic_sub_fetch(&num_running, 1, __ATOMIC_RELAXED);
+}
+
+void UThreadPool::addTask(vPFpv func, void* arg)
 {
-   U_TRACE_NO_PARAM(0, "UThreadPool::run()")
+   U_TRACE(0, "UThreadPool::addTask(%p,%p)", func, arg)
+
+   U_INTERNAL_ASSERT(active)
+
+   task t = { func, arg };
+   worker* w = getWorker();
+
+   (void) __atomic_add_fetch(&pending, 1, __ATOMIC_SEQ_CST);
+
+   // NB: a task submitted from one of our workers go in its deque without locking...
+
+   if (w == U_NULLPTR   ||
+       w->pool != this  ||
+       push(w, t) == false)
+      {
+      pushInject(&t, 1);
+      }
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-   UThread* current_task;
+   if (isToWakeUp()) wakeUp(1);
+}
+
+void UThreadPool::waitForWorkToBeFinished()
+{
+   U_TRACE_NO_PARAM(0, "UThreadPool::waitForWorkToBeFinished()")
 
-   do {
-      // We need to put pthread_cond_wait in a loop for two reasons:
-      //
-      // 1. There can be spurious wakeups (due to signal/ENITR)
-      //
-      // 2. When tasks_mutex is released for waiting, another thread can be waken up from a signal/broadcast and that
-      //    thread can miss up the condition. So when the current thread wakes up the condition may no longer be actually true!
+   U_INTERNAL_ASSERT_EQUALS(getWorker(), U_NULLPTR) // NB: from a worker it is a deadlock (its task is pending), use parallelFor()...
 
-      lock(&tasks_mutex);
+   task t;
+   uint32_t seq;
 
-      while (queue._length == 0 && active)
+   while (__atomic_load_n(&pending, __ATOMIC_SEQ_CST))
+      {
+      if (popInject(U_NULLPTR, t)) // we help the workers...
          {
-         // Wait until there is a task in the queue
+         runTask(t);
 
-         wait(&tasks_mutex, &condition); // Unlock tasks_mutex while wait, then lock it back when signaled
+         continue;
          }
 
-      if (active == false) // Destructor ordered on abort
+      seq = __atomic_load_n(&done_seq, __ATOMIC_SEQ_CST);
+
+      (void) __atomic_add_fetch(&num_waiter, 1, __ATOMIC_SEQ_CST);
+
+      if (__atomic_load_n(&pending, __ATOMIC_SEQ_CST))
          {
-         unlock(&tasks_mutex);
+#     ifdef U_LINUX
+         (void) syscall(SYS_futex, &done_seq, FUTEX_WAIT_PRIVATE, seq, U_NULLPTR, U_NULLPTR, 0);
+#     else
+         UThread::lock(&tasks_mutex);
 
-         return;
+         while (__atomic_load_n(&done_seq, __ATOMIC_SEQ_CST) == seq) UThread::wait(&tasks_mutex, &condition_task_finished);
+
+         UThread::unlock(&tasks_mutex);
+#     endif
          }
 
-      // If we got here, we successfully acquired the lock and the queue<Task> is not empty
+      (void) __atomic_sub_fetch(&num_waiter, 1, __ATOMIC_SEQ_CST);
+      }
+}
+
+void UThreadPool::parallelFor(uint32_t n, vPFpvu func, void* arg, uint32_t grain)
+{
+   U_TRACE(0, "UThreadPool::parallelFor(%u,%p,%p,%u)", n, func, arg, grain)
+
+   U_INTERNAL_ASSERT(active)
+
+   if (n == 0) return;
+
+   if (grain == 0) grain = U_max(n / (num_worker * 8), 1); // some chunks for worker for the load balancing...
+
+   loop ctx = { func, arg, n, grain, 0, 0, 0 };
 
-      current_task = queue.pop();
+   task t = { runParallelFor, &ctx }, vt[64];
+   uint32_t i, k = U_min((n + grain - 1) / grain - 1, U_min(num_worker, 64)); // NB: the caller run also one of the tasks...
 
-      unlock(&tasks_mutex);
+   ctx.ntask = k + 1;
 
-      current_task->run(); // execute the task
+   if (k)
+      {
+      worker* w = getWorker();
+
+      (void) __atomic_add_fetch(&pending, k, __ATOMIC_SEQ_CST);
+
+      if (w &&
+          w->pool == this)
+         {
+         for (i = 0; i < k; ++i)
+            {
+            if (push(w, t) == false) pushInject(&t, 1);
+            }
+         }
+      else
+         {
+         for (i = 0; i < k; ++i) vt[i] = t;
 
-      U_DELETE(current_task)
+         pushInject(vt, k);
+         }
 
-      signal(&condition_task_finished);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+      if (isToWakeUp()) wakeUp(k);
+      }
+
+   runParallelFor(&ctx);
+
+   // NB: ctx is on our stack, we must wait also for the tasks that don't have found work (meanwhile we help the pool)...
+
+   worker* w = getWorker();
+
+   if (w &&
+       w->pool != this)
+      {
+      w = U_NULLPTR;
+      }
+
+   for (i = 0; __atomic_load_n(&ctx.nfinished, __ATOMIC_ACQUIRE) < ctx.ntask; ++i)
+      {
+      if (getTask(w, t)) runTask(t);
+      else
+         {
+         if (i < max_spin &&
+             max_spin == U_THREAD_POOL_SPIN)
+            {
+            U_CPU_RELAX();
+            }
+         else
+            {
+            i = 0;
+
+            (void) sched_yield();
+            }
+         }
       }
-   while (active);
 }
 
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
@@ -740,9 +1250,14 @@ const char* UThread::dump(bool reset) const
 
 const char* UThreadPool::dump(bool reset) const
 {
-   *UObjectIO::os << "active         " << active        << '\n'
-                  << "pool  (UVector " << (void*)&pool  << ")\n"
-                  << "queue (UVector " << (void*)&queue << ')';
+   *UObjectIO::os << "active         " << active      << '\n'
+                  << "pending        " << pending     << '\n'
+                  << "sleepers       " << sleepers    << '\n'
+                  << "searching      " << searching   << '\n'
+                  << "num_worker     " << num_worker  << '\n'
+                  << "inject_len     " << inject_len  << '\n'
+                  << "inject_size    " << inject_size << '\n'
+                  << "num_running    " << num_running;
 
    if (reset)
       {
@@ -13,9 +13,16 @@
 
 #include <ulib/timer.h>
 
-int     UTimer::mode;
-UTimer* UTimer::pool;
-UTimer* UTimer::first;
+int         UTimer::mode;
+bool        UTimer::bwheel;
+UTimer*     UTimer::pool;
+UTimer*     UTimer::first;
+UTimer*     UTimer::wheel_fired;
+uint64_t    UTimer::wheel_now;
+uint32_t    UTimer::wheel_count;
+UEventTime* UTimer::wheel_alarm;
+uint64_t    UTimer::wheel_bitmap[U_TIMER_WHEEL_LEVEL];
+UTimer*     UTimer::wheel[U_TIMER_WHEEL_LEVEL][U_TIMER_WHEEL_SIZE];
 
 U_NO_EXPORT void UTimer::insertEntry()
 {
@@ -77,6 +84,27 @@ void UTimer::insert(UEventTime* a)
 
    (item->alarm = a)->setTimeToExpire();
 
+   if (bwheel)
+      {
+      U_INTERNAL_ASSERT_EQUALS(a->ptimer, U_NULLPTR)
+
+      if (wheel_count == 0 &&
+          wheel_fired == U_NULLPTR)
+         {
+         // NB: the wheel is empty, we can move it directly to the current time...
+
+         u_gettimeofday(&UEventTime::timeout1);
+
+         wheel_now = getTickNow();
+         }
+
+      a->ptimer = item;
+
+      item->linkWheel(wheel_now+1);
+
+      return;
+      }
+
    item->insertEntry();
 
 #ifdef DEBUG
@@ -98,6 +126,10 @@ void UTimer::callHandlerTimeout()
    int result = item->alarm->handlerTime();
 
         if (result == -1) erase(item); // -1 => normal
+   else if (result ==  1)              //  1 => monitoring (xtime already set by the handler)
+      {
+      item->insertEntry();
+      }
    else if (result ==  0)              //  0 => monitoring
       {
       U_INTERNAL_DUMP("UEventTime::timeout1 = %#19D (next alarm expire) = %#19D", UEventTime::timeout1.tv_sec, item->next ? item->next->alarm->expire() : 0L)
@@ -118,10 +150,28 @@ void UTimer::updateTimeToExpire(UEventTime* ptime)
 {
    U_TRACE(0, "UTimer::updateTimeToExpire(%p)", ptime)
 
-   U_INTERNAL_ASSERT_POINTER(first)
-
    UTimer* item;
 
+   if (bwheel)
+      {
+      item = ptime->ptimer;
+
+      U_INTERNAL_ASSERT_POINTER(item)
+      U_INTERNAL_ASSERT_DIFFERS(item, wheel_fired)
+
+      item->unlinkWheel();
+
+      u_gettimeofday(&UEventTime::timeout1);
+
+      ptime->updateTimeToExpire();
+
+      item->linkWheel(wheel_now+1);
+
+      return;
+      }
+
+   U_INTERNAL_ASSERT_POINTER(first)
+
    for (UTimer** ptr = &first; (item = *ptr); ptr = &(*ptr)->next)
       {
       if (item->alarm == ptime)
@@ -160,6 +210,15 @@ void UTimer::run()
 
    U_INTERNAL_DUMP("UEventTime::timeout1 = { %ld %6ld } first = %p", UEventTime::timeout1.tv_sec, UEventTime::timeout1.tv_usec, first)
 
+   if (bwheel)
+      {
+      runWheel();
+
+      if (UInterrupt::event_signal_pending) UInterrupt::callHandlerSignal();
+
+      return;
+      }
+
    UTimer* item = first;
    bool bnosignal = (mode == NOSIGNAL);
 
@@ -195,7 +254,16 @@ void UTimer::setTimer()
 
    run();
 
-   if (first) first->alarm->setTimeVal(&(UInterrupt::timerval.it_value));
+   if (bwheel)
+      {
+      if (wheel_count) getWheelTimeout()->setTimeVal(&(UInterrupt::timerval.it_value));
+      else
+         {
+         UInterrupt::timerval.it_value.tv_sec  =
+         UInterrupt::timerval.it_value.tv_usec = 0L;
+         }
+      }
+   else if (first) first->alarm->setTimeVal(&(UInterrupt::timerval.it_value));
    else
       {
       UInterrupt::timerval.it_value.tv_sec  =
@@ -216,10 +284,27 @@ void UTimer::erase(UEventTime* palarm)
 {
    U_TRACE(0, "UTimer::erase(%p)", palarm)
 
-   U_INTERNAL_ASSERT_POINTER(first)
-
    UTimer* item;
 
+   if (bwheel)
+      {
+      if ((item = palarm->ptimer))
+         {
+         palarm->ptimer = U_NULLPTR;
+
+         // NB: if the alarm is erased by its own handler the item is already out of the wheel...
+
+         if (item == wheel_fired) wheel_fired = U_NULLPTR;
+         else                     item->unlinkWheel();
+
+         erase(item);
+         }
+
+      return;
+      }
+
+   U_INTERNAL_ASSERT_POINTER(first)
+
    for (UTimer** ptr = &first; (item = *ptr); ptr = &(*ptr)->next)
       {
       if (item->alarm == palarm)
@@ -254,6 +339,35 @@ void UTimer::clear()
       (void) U_SYSCALL(setitimer, "%d,%p,%p", ITIMER_REAL, &UInterrupt::timerval, U_NULLPTR);
       }
 
+   if (wheel_count)
+      {
+      for (uint32_t i = 0; i < U_TIMER_WHEEL_LEVEL; ++i)
+         {
+         for (uint32_t j = 0; j < U_TIMER_WHEEL_SIZE; ++j)
+            {
+            while ((item = wheel[i][j]))
+               {
+               item->unlinkWheel();
+
+               U_INTERNAL_DUMP("item->alarm = %p", item->alarm)
+
+               item->alarm->ptimer = U_NULLPTR;
+
+               U_DELETE(item)
+               }
+            }
+         }
+
+      U_INTERNAL_ASSERT_EQUALS(wheel_count, 0)
+      }
+
+   if (wheel_alarm)
+      {
+      U_DELETE(wheel_alarm)
+
+      wheel_alarm = U_NULLPTR;
+      }
+
    if (first)
       {
       next = first;
@@ -289,11 +403,265 @@ void UTimer::clear()
       }
 }
 
+// ---------------------------------------------------------------------------------------------------------------
+// hierarchical timing wheel
+// ---------------------------------------------------------------------------------------------------------------
+// An item of level L with expire tick t satisfies (t >> (L * U_TIMER_WHEEL_BITS)) - (wheel_now >> (L * U_TIMER_WHEEL_BITS))
+// in [1, U_TIMER_WHEEL_SIZE] and sit in the slot ((t >> (L * U_TIMER_WHEEL_BITS)) & U_TIMER_WHEEL_MASK), so it is moved
+// (cascade) to the lower levels exactly when wheel_now reach the start of its slot. The items of level 0 are expired
+// when wheel_now reach their tick...
+// ---------------------------------------------------------------------------------------------------------------
+
+U_NO_EXPORT void UTimer::linkWheel(uint64_t min_tick)
+{
+   U_TRACE(0, "UTimer::linkWheel(%llu)", min_tick)
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_POINTER(alarm)
+   U_INTERNAL_ASSERT_EQUALS(pprev, U_NULLPTR)
+
+   uint64_t delta, tick = getTick(alarm->xtime);
+
+   if (tick < min_tick) tick = min_tick; // NB: it is already expired...
+
+   uint32_t level = 0;
+
+   delta = tick - wheel_now;
+
+   while (delta >= (1ULL << ((level+1) * U_TIMER_WHEEL_BITS)))
+      {
+      if (++level == (U_TIMER_WHEEL_LEVEL-1))
+         {
+         // NB: too far in time, it is put at the max distance and it is reinserted when its slot is expired...
+
+         if (delta >= (1ULL << (U_TIMER_WHEEL_LEVEL * U_TIMER_WHEEL_BITS))) tick = wheel_now + (1ULL << (U_TIMER_WHEEL_LEVEL * U_TIMER_WHEEL_BITS)) - 1;
+
+         break;
+         }
+      }
+
+   uint32_t slot = (tick >> (level * U_TIMER_WHEEL_BITS)) & U_TIMER_WHEEL_MASK;
+
+   U_INTERNAL_DUMP("tick = %llu wheel_now = %llu level = %u slot = %u", tick, wheel_now, level, slot)
+
+   UTimer** phead = &wheel[level][slot];
+
+   if ((next = *phead)) next->pprev = &next;
+
+   *phead = this;
+    pprev = phead;
+
+   wheel_bitmap[level] |= (1ULL << slot);
+
+   ++wheel_count;
+}
+
+U_NO_EXPORT void UTimer::unlinkWheel()
+{
+   U_TRACE_NO_PARAM(0, "UTimer::unlinkWheel()")
+
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_POINTER(pprev)
+   U_INTERNAL_ASSERT_MAJOR(wheel_count, 0)
+
+   if ((*pprev = next)) next->pprev = pprev;
+   else
+      {
+      // NB: if we were the last item of the slot we must clear the bit of the slot in the bitmap...
+
+      if (pprev >= &wheel[0][0] &&
+          pprev <  &wheel[0][0] + (U_TIMER_WHEEL_LEVEL * U_TIMER_WHEEL_SIZE))
+         {
+         uint32_t pos = pprev - &wheel[0][0];
+
+         U_INTERNAL_DUMP("level = %u slot = %u", pos / U_TIMER_WHEEL_SIZE, pos & U_TIMER_WHEEL_MASK)
+
+         wheel_bitmap[pos / U_TIMER_WHEEL_SIZE] &= ~(1ULL << (pos & U_TIMER_WHEEL_MASK));
+         }
+      }
+
+   next  = U_NULLPTR;
+   pprev = U_NULLPTR;
+
+   --wheel_count;
+}
+
+U_NO_EXPORT __pure uint64_t UTimer::nextWheelTick()
+{
+   U_TRACE_NO_PARAM(0, "UTimer::nextWheelTick()")
+
+   U_INTERNAL_ASSERT_MAJOR(wheel_count, 0)
+
+   uint64_t bits, tick, result = ~0ULL;
+
+   for (uint32_t level = 0, shift = 0; level < U_TIMER_WHEEL_LEVEL; ++level, shift += U_TIMER_WHEEL_BITS)
+      {
+      if ((bits = wheel_bitmap[level]))
+         {
+         // NB: rotate the bitmap so that the bit 0 is the slot next to the current one...
+
+         uint32_t rot = (((wheel_now >> shift) + 1) & U_TIMER_WHEEL_MASK);
+
+         if (rot) bits = (bits >> rot) | (bits << (U_TIMER_WHEEL_SIZE - rot));
+
+         tick = ((wheel_now >> shift) + __builtin_ctzll(bits) + 1) << shift;
+
+         U_INTERNAL_DUMP("level = %u tick = %llu", level, tick)
+
+         if (tick < result) result = tick;
+         }
+      }
+
+   U_INTERNAL_ASSERT_MAJOR(result, wheel_now)
+
+   U_RETURN(result);
+}
+
+U_NO_EXPORT void UTimer::cascadeWheel(uint32_t level, uint32_t slot)
+{
+   U_TRACE(0, "UTimer::cascadeWheel(%u,%u)", level, slot)
+
+   UTimer* item;
+
+   while ((item = wheel[level][slot]))
+      {
+      item->unlinkWheel();
+      item->linkWheel(wheel_now); // NB: the items with tick == wheel_now go in the slot that we are going to expire...
+      }
+}
+
+U_NO_EXPORT void UTimer::fireWheel(uint32_t slot)
+{
+   U_TRACE(0, "UTimer::fireWheel(%u)", slot)
+
+   int result;
+   UTimer* item;
+
+   while ((item = wheel[0][slot]))
+      {
+      item->unlinkWheel();
+
+      if (getTick(item->alarm->xtime) > wheel_now) // NB: it was too far in time...
+         {
+         item->linkWheel(wheel_now+1);
+
+         continue;
+         }
+
+      wheel_fired = item;
+
+      result = item->alarm->handlerTime();
+
+      if (wheel_fired == U_NULLPTR) continue; // NB: the alarm was erased by its own handler...
+
+      wheel_fired = U_NULLPTR;
+
+      if (result == -1) // -1 => normal
+         {
+         item->alarm->ptimer = U_NULLPTR;
+
+         erase(item);
+
+         continue;
+         }
+
+      if (result == 0) //  0 => monitoring
+         {
+         u_gettimeofday(&UEventTime::timeout1);
+
+         item->alarm->updateTimeToExpire();
+         }
+
+      item->linkWheel(wheel_now+1); // 1 => monitoring (xtime already set by the handler)
+      }
+}
+
+U_NO_EXPORT void UTimer::runWheel()
+{
+   U_TRACE_NO_PARAM(0, "UTimer::runWheel()")
+
+   uint64_t tick, target = getTickNow();
+
+   U_INTERNAL_DUMP("wheel_now = %llu target = %llu wheel_count = %u", wheel_now, target, wheel_count)
+
+   while (wheel_count &&
+          wheel_now < target)
+      {
+      // NB: we jump directly to the next tick with something to do (expire a slot of level 0 or cascade a slot of upper level)
+
+      if ((tick = nextWheelTick()) > target) break;
+
+      wheel_now = tick;
+
+      for (uint32_t level = 1; level < U_TIMER_WHEEL_LEVEL; ++level)
+         {
+         if ((tick & ((1ULL << (level * U_TIMER_WHEEL_BITS)) - 1)) != 0) break;
+
+         if (wheel_bitmap[level]) cascadeWheel(level, (tick >> (level * U_TIMER_WHEEL_BITS)) & U_TIMER_WHEEL_MASK);
+         }
+
+      fireWheel(tick & U_TIMER_WHEEL_MASK);
+      }
+
+   if (wheel_now < target) wheel_now = target;
+
+   U_ASSERT(invariant())
+}
+
+UEventTime* UTimer::getWheelTimeout()
+{
+   U_TRACE_NO_PARAM(0, "UTimer::getWheelTimeout()")
+
+   U_INTERNAL_ASSERT(bwheel)
+   U_INTERNAL_ASSERT_POINTER(wheel_alarm)
+   U_INTERNAL_ASSERT_MAJOR(wheel_count, 0)
+
+   // NB: we add 1 ms so that the wakeup (ms resolution) is not before the tick...
+
+   uint64_t tick = nextWheelTick() + 1;
+
+   long ms = (long)(tick - getTickNow());
+
+   wheel_alarm->UTimeVal::setMilliSecond(ms);
+   wheel_alarm->setTolerance();
+
+   wheel_alarm->xtime.tv_sec  =  tick / 1000ULL;
+   wheel_alarm->xtime.tv_usec = (tick % 1000ULL) * 1000L;
+
+   U_INTERNAL_DUMP("wheel_alarm->xtime = { %ld %6ld } ms = %ld", wheel_alarm->xtime.tv_sec, wheel_alarm->xtime.tv_usec, ms)
+
+   U_RETURN_POINTER(wheel_alarm, UEventTime);
+}
+
 #ifdef DEBUG
 bool UTimer::invariant()
 {
    U_TRACE_NO_PARAM(0, "UTimer::invariant()")
 
+   if (bwheel)
+      {
+      uint32_t n = 0;
+
+      for (uint32_t i = 0; i < U_TIMER_WHEEL_LEVEL; ++i)
+         {
+         for (uint32_t j = 0; j < U_TIMER_WHEEL_SIZE; ++j)
+            {
+            if (((wheel_bitmap[i] >> j) & 1ULL) != (wheel[i][j] != U_NULLPTR))
+               {
+               U_ERROR("UTimer::invariant() failed: wheel_bitmap[%u] = %llx wheel[%u][%u] = %p", i, wheel_bitmap[i], i, j, wheel[i][j]);
+               }
+
+            for (UTimer* item = wheel[i][j]; item; item = item->next) ++n;
+            }
+         }
+
+      if (n != wheel_count) U_ERROR("UTimer::invariant() failed: wheel_count = %u items = %u", wheel_count, n);
+
+      U_RETURN(true);
+      }
+
    if (first)
       {
       for (UTimer* item = first; item->next; item = item->next)
@@ -344,6 +712,28 @@ void UTimer::printInfo(ostream& os)
 {
    U_TRACE(0+256, "UTimer::printInfo(%p)", &os)
 
+   if (bwheel)
+      {
+      os << "wheel = { now " << wheel_now << " count " << wheel_count << " }";
+
+      for (uint32_t i = 0; i < U_TIMER_WHEEL_LEVEL; ++i)
+         {
+         for (uint32_t j = 0; j < U_TIMER_WHEEL_SIZE; ++j)
+            {
+            if (wheel[i][j]) os << "\nwheel[" << i << "][" << j << "] = " << *wheel[i][j];
+            }
+         }
+
+      os << "\npool  = ";
+
+      if (pool) os << *pool;
+      else      os << (void*)pool;
+
+      os << "\n";
+
+      return;
+      }
+
    os << "first = ";
 
    if (first) os << *first;
@@ -366,7 +756,11 @@ const char* UTimer::dump(bool reset) const
                                                                  << " } }\n"
                   << "pool         (UTimer     " << (void*)pool  << ")\n"
                   << "first        (UTimer     " << (void*)first << ")\n"
+                  << "bwheel                   " << bwheel       << '\n'
+                  << "wheel_now                " << wheel_now    << '\n'
+                  << "wheel_count              " << wheel_count  << '\n'
                   << "next         (UTimer     " << (void*)next  << ")\n"
+                  << "pprev        (UTimer     " << (void*)pprev << ")\n"
                   << "alarm        (UEventTime " << (void*)alarm << ")";
 
    if (reset)
@@ -399,7 +399,7 @@ void UHTTP2::updateSetting(unsigned char* ptr, uint32_t len)
 
          case MAX_CONCURRENT_STREAMS:                        pConnection->peer_settings.max_concurrent_streams = value;  break;
          case MAX_HEADER_LIST_SIZE:                          pConnection->peer_settings.max_header_list_size   = value;  break;
-         case HEADER_TABLE_SIZE: setHpackInputDynTblCapacity(pConnection->peer_settings.header_table_size      = value); break;
+         case HEADER_TABLE_SIZE: setHpackOutputDynTblMaxCapacity(pConnection->peer_settings.header_table_size  = value); break;
 
          default: break; // ignore unknown (5.5)
          }
@@ -486,7 +486,7 @@ unsigned char* UHTTP2::hpackDecodeString(unsigned char* src, unsigned char* src_
 
    if (len <= 0)
       {
-      hpack_errno = -2;
+      if (len < 0) hpack_errno = -2; // NB: a zero length is a valid empty string (ex: a header with an empty value)...
 
 err:  value.clear();
 
@@ -571,7 +571,12 @@ unsigned char* UHTTP2::hpackEncodeString(unsigned char* dst, const char* src, ui
 {
    U_TRACE(0+256, "UHTTP2::hpackEncodeString(%p,%.*S,%u,%b)", dst, len, src, len, bhuffman)
 
-   U_INTERNAL_ASSERT_MAJOR(len, 0)
+   if (len == 0) // NB: an empty string (ex: a header with an empty value) is only the length, without the Huffman flag...
+      {
+      *dst++ = 0x00;
+
+      U_RETURN_POINTER(dst, unsigned char);
+      }
 
 #ifdef DEBUG
    if (isHeaderValue(src, len) == false)
@@ -683,6 +688,17 @@ unsigned char* UHTTP2::hpackEncodeString(unsigned char* dst, const char* src, ui
    U_RETURN_POINTER(dst, unsigned char);
 }
 
+__pure uint32_t UHTTP2::hpackHuffmanLen(const char* src, uint32_t len)
+{
+   U_TRACE(0, "UHTTP2::hpackHuffmanLen(%.*S,%u)", len, src, len)
+
+   uint32_t nbits = 0;
+
+   for (const char* end = src + len; src < end; ++src) nbits += huff_sym_table[*(unsigned char*)src].nbits;
+
+   U_RETURN((nbits + 7) >> 3);
+}
+
 void UHTTP2::evictHpackDynTblEntry(HpackDynamicTable* dyntbl, HpackHeaderTableEntry* entry, uint32_t index)
 {
    U_TRACE(0, "UHTTP2::evictHpackDynTblEntry(%p,%p,%u)", dyntbl, entry, index)
@@ -801,6 +817,8 @@ void UHTTP2::addHpackDynTblEntry(HpackDynamicTable* dyntbl, const UString& name,
    (entry->name  =  name.rep)->hold();
    (entry->value = value.rep)->hold();
 
+   dyntbl->insert_count++;
+
    U_INTERNAL_DUMP("num_entries = %u entry_capacity = %u entry_start_index = %u hpack_size = %u hpack_capacity = %u hpack_max_capacity = %u",
                      dyntbl->num_entries, dyntbl->entry_capacity, dyntbl->entry_start_index, dyntbl->hpack_size, dyntbl->hpack_capacity, dyntbl->hpack_max_capacity)
 }
@@ -1092,38 +1110,35 @@ check2:
 
          if (index < (int32_t)dyntbl->num_entries)
             {
-            bvalue_is_indexed = false;
-
             entry = getHpackDynTblEntry(dyntbl, index);
 
             name._assign(entry->name);
 
             UHashMap<void*>::lhash = entry->name->hashIgnoreCase();
 
-            if (binsert_dynamic_table == false)
+            if (bvalue_is_indexed)
                {
+               bvalue_is_indexed = false;
+
                value._assign(entry->value);
 
                goto insert_table;
                }
 
-            if ((table->lookup(name.rep), table->node))
-               {
-               ptr = hpackDecodeString(ptr, endptr, value);
-
-               if (isHpackError()) return;
+            // NB: only the name is indexed, the value follows as literal (with or without incremental indexing)...
 
-               /**
-                * A new entry can reference the name of an entry in the dynamic table that will be evicted when adding this new entry into the dynamic table.
-                * Implementations are cautioned to avoid deleting the referenced name if the referenced entry is evicted from the dynamic table prior to inserting the new entry
-                */
+            ptr = hpackDecodeString(ptr, endptr, value);
 
-               evictHpackDynTblEntry(dyntbl, entry, index);
+            if (isHpackError()) return;
 
-               goto insertd;
-               }
+            /**
+             * A new entry can reference the name of an entry in the dynamic table that will be evicted when adding this new entry into the dynamic table.
+             * Implementations are cautioned to avoid deleting the referenced name if the referenced entry is evicted from the dynamic table prior to inserting the new entry
+             *
+             * NB: name holds a reference to the name of the entry, so the eviction made by addHpackDynTblEntry() can't release it...
+             */
 
-            binsert_dynamic_table = false;
+            if (binsert_dynamic_table) goto insertd;
 
             goto insert_table;
             }
@@ -1751,7 +1766,6 @@ case_58: // user-agent
 
 insert:
       U_INTERNAL_ASSERT(name)
-      U_INTERNAL_ASSERT(value)
       U_INTERNAL_ASSERT(UHashMap<void*>::lhash)
 
       U_INTERNAL_DUMP("dyntbl->num_entries = %u binsert_dynamic_table = %b", dyntbl->num_entries, binsert_dynamic_table)
@@ -2483,92 +2497,203 @@ ret:
       }
 }
 
-unsigned char* UHTTP2::hpackEncodeHeader(unsigned char* dst, const UString& name, const UString& value)
+uint32_t UHTTP2::findHpackStaticTblEntry(const UString& name, uint32_t hname, const char* value, uint32_t len, bool& bvalue)
 {
-   U_TRACE(0, "UHTTP2::hpackEncodeHeader(%p,%V,%V)", dst, name.rep, value.rep)
+   U_TRACE(0, "UHTTP2::findHpackStaticTblEntry(%V,%u,%.*S,%u,%p)", name.rep, hname, len, value, len, &bvalue)
 
-   int32_t index = 0;
-   const char* keyp = name.data();
+   // NB: hash_static_table[] is set only for the first entry of every name, the entries with the same name follow it...
 
-   switch (u_get_unalignedp32(keyp))
+   for (uint32_t i = 0; i < U_NUM_ELEMENTS(hash_static_table); ++i)
       {
-      case U_MULTICHAR_CONSTANT32('C','o','n','t'):
+      if (hash_static_table[i] == hname &&
+          name.equalnocase(hpack_static_table[i].name))
          {
-         keyp += 7;
+         UStringRep* rep = hpack_static_table[i].name;
 
-         switch (u_get_unalignedp32(keyp))
+         for (uint32_t j = i; j < U_NUM_ELEMENTS(hpack_static_table) && hpack_static_table[j].name == rep; ++j)
             {
-            case U_MULTICHAR_CONSTANT32('-','D','i','s'): index = 25; break; // content-disposition
-            case U_MULTICHAR_CONSTANT32('-','E','n','c'): index = 26; break; // content-encoding
-            case U_MULTICHAR_CONSTANT32('-','L','a','n'): index = 27; break; // content-language
-            case U_MULTICHAR_CONSTANT32('-','L','e','n'): index = 28; break; // content-length
-            case U_MULTICHAR_CONSTANT32('-','L','o','c'): index = 29; break; // content-location
-            case U_MULTICHAR_CONSTANT32('-','R','a','n'): index = 30; break; // content-range
-            case U_MULTICHAR_CONSTANT32('-','T','y','p'): index = 31; break; // content-type 
-
-#        ifdef DEBUG
-            default:
+            if (hpack_static_table[j].value &&
+                hpack_static_table[j].value->equal(value, len))
                {
-               U_ASSERT(name == U_STRING_FROM_CONSTANT("Content-Style-Type") ||
-                        name == U_STRING_FROM_CONSTANT("Content-Script-Type"))
+               bvalue = true;
 
-               U_WARNING("Content-Style-Type and Content-Script-Type are not supported");
+               U_RETURN(j+1);
                }
-#        endif
             }
+
+         U_RETURN(i+1);
          }
-      break;
+      }
+
+   U_RETURN(0);
+}
+
+uint32_t UHTTP2::findHpackOutputDynTblEntry(HpackDynamicTable* dyntbl, uint32_t hash, const UString& name, const char* value, uint32_t len)
+{
+   U_TRACE(0, "UHTTP2::findHpackOutputDynTblEntry(%p,%u,%V,%.*S,%u)", dyntbl, hash, name.rep, len, value, len)
+
+   // NB: with value null we look for the name only...
+
+   if (dyntbl->hindex &&
+       dyntbl->num_entries)
+      {
+      uint32_t* slot;
+      uint32_t index;
+      HpackHeaderTableEntry* entry;
 
-      case U_MULTICHAR_CONSTANT32('A','c','c','e'):
+      for (uint32_t i = 0; i < U_HPACK_INDEX_PROBE; ++i)
          {
-         keyp += 6;
+         slot = dyntbl->hindex + (((hash + i) & (U_HPACK_INDEX_SIZE-1)) * 2);
 
-         if (u_get_unalignedp32(keyp) == U_MULTICHAR_CONSTANT32('-','R','a','n')) index = 18; // accept-ranges
-         else
+         if (slot[1] == 0) break; // empty
+
+         if (slot[0] == hash)
             {
-            U_INTERNAL_ASSERT_EQUALS(name, U_STRING_FROM_CONSTANT("Access-Control-Allow-Origin"))
+            index = dyntbl->insert_count - slot[1];
+
+            if (index < dyntbl->num_entries) // NB: otherwise the entry is already evicted...
+               {
+               entry = getHpackDynTblEntry(dyntbl, index);
 
-            index = 20; // access-control-allow-origin
+               if (name.equalnocase(entry->name) &&
+                   (value == U_NULLPTR || entry->value->equal(value, len)))
+                  {
+                  U_RETURN(index+HTTP2_HEADER_TABLE_OFFSET);
+                  }
+               }
             }
          }
-      break;
+      }
 
-      case U_MULTICHAR_CONSTANT32('C','a','c','h'): index = 24; break; // cache-control
-      case U_MULTICHAR_CONSTANT32('E','t','a','g'): index = 34; break; // etag
-      case U_MULTICHAR_CONSTANT32('E','x','p','i'): index = 36; break; // expires
-      case U_MULTICHAR_CONSTANT32('L','a','s','t'): index = 44; break; // last-modified
-      case U_MULTICHAR_CONSTANT32('L','i','n','k'): index = 45; break; // link
-      case U_MULTICHAR_CONSTANT32('L','o','c','a'): index = 46; break; // location
-      case U_MULTICHAR_CONSTANT32('P','r','o','x'): index = 48; break; // proxy-authenticate
-      case U_MULTICHAR_CONSTANT32('R','e','f','r'): index = 52; break; // refresh
-      case U_MULTICHAR_CONSTANT32('R','e','t','r'): index = 53; break; // retry-after
-      case U_MULTICHAR_CONSTANT32('S','t','r','i'): index = 56; break; // strict-transport-security
-      case U_MULTICHAR_CONSTANT32('V','a','r','y'): index = 59; break; // vary
-      case U_MULTICHAR_CONSTANT32('W','W','W','-'): index = 61; break; // www-authenticate 
+   U_RETURN(0);
+}
 
-      default:
+void UHTTP2::addHpackOutputDynTblEntry(HpackDynamicTable* dyntbl, const UString& name, const UString& value, uint32_t hname)
+{
+   U_TRACE(0, "UHTTP2::addHpackOutputDynTblEntry(%p,%V,%V,%u)", dyntbl, name.rep, value.rep, hname)
+
+   uint32_t count = dyntbl->insert_count;
+
+   addHpackDynTblEntry(dyntbl, name, value);
+
+   if (count == dyntbl->insert_count) return; // NB: the entry is larger than the table...
+
+   if (dyntbl->hindex == U_NULLPTR)
+      {
+      uint32_t sz = U_HPACK_INDEX_SIZE * 2;
+
+      dyntbl->hindex = (uint32_t*) UMemoryPool::pmalloc(&sz, sizeof(uint32_t), true);
+      }
+
+   // we index the entry by name and by name+value: if all the probed slots are in use we overwrite the oldest entry
+
+   uint32_t* slot;
+   uint32_t* victim;
+   uint32_t hash = hname;
+
+   for (int k = 0; k < 2; ++k, hash = getHpackValueHash(hname, U_STRING_TO_PARAM(value)))
+      {
+      victim = U_NULLPTR;
+
+      for (uint32_t i = 0; i < U_HPACK_INDEX_PROBE; ++i)
          {
-              if (name.equalnocase(U_CONSTANT_TO_PARAM("Via"))) index = 60; // via
-         else if (name.equalnocase(U_CONSTANT_TO_PARAM("Age"))) index = 21; // age
+         slot = dyntbl->hindex + (((hash + i) & (U_HPACK_INDEX_SIZE-1)) * 2);
+
+         if (slot[1] == 0                                               || // empty
+             slot[0] == hash                                            || // the same key (the new entry shadows the old one)
+             (dyntbl->insert_count - slot[1]) >= dyntbl->num_entries)     // evicted
+            {
+            victim = slot;
+
+            break;
+            }
+
+         if (victim == U_NULLPTR ||
+             victim[1] > slot[1])
+            {
+            victim = slot;
+            }
          }
-      break;
+
+      victim[0] = hash;
+      victim[1] = dyntbl->insert_count;
       }
+}
 
-   if (index) dst = hpackEncodeInt(dst, index, (1<<4)-1, 0x00); // literal
-   else
+unsigned char* UHTTP2::hpackEncodeHeader(unsigned char* dst, HpackDynamicTable* dyntbl, const UString& name, const char* value, uint32_t len)
+{
+   U_TRACE(0, "UHTTP2::hpackEncodeHeader(%p,%p,%V,%.*S,%u)", dst, dyntbl, name.rep, len, value, len)
+
+   /**
+    * With the output dynamic table (dyntbl) the representation is chosen in this order:
+    *
+    * 1) indexed header field (static or dynamic table)
+    * 2) literal header field never indexed for the sensitive headers (authorization, cookie, set-cookie, ...)
+    * 3) literal header field without indexing for the headers that change with every response (content-length, etag, ...)
+    * 4) literal header field with incremental indexing otherwise
+    *
+    * Without dyntbl the result don't depend from the state of the connection (ex: the headers saved in the file cache) so only 1) with
+    * the static table and 3) are possible. The name of the literal is indexed when possible and the strings use Huffman only if shorter
+    */
+
+   bool bvalue = false;
+   uint32_t hname = name.hashIgnoreCase(),
+            index = findHpackStaticTblEntry(name, hname, value, len, bvalue);
+
+   if (bvalue)
+      {
+      dst = hpackEncodeInt(dst, index, (1<<7)-1, 0x80); // indexed header field (static table)
+
+      U_RETURN_POINTER(dst, unsigned char);
+      }
+
+   uint8_t pattern = 0x00; // literal header field without indexing
+
+   switch (index)
       {
-      char* ptr = name.data();
+      case 23: // authorization
+      case 32: // cookie
+      case 49: // proxy-authorization
+      case 55: // set-cookie
+         pattern = 0x10; // literal header field never indexed
+      break;
+
+      case 21: // age
+      case 28: // content-length
+      case 30: // content-range
+      case 34: // etag
+      case 36: // expires
+      case 44: // last-modified
+      case 46: // location
+      break;
 
-      if (u__isupper(*ptr))
+      default:
          {
-         for (char* end = ptr + name.size(); ptr < end; ++ptr)
+         if (dyntbl &&
+             (name.size() + len + HTTP2_HEADER_TABLE_ENTRY_SIZE_OFFSET) <= (dyntbl->hpack_capacity / 4)) // NB: a large entry would evict too many others...
             {
-            char c = *ptr;
+            uint32_t hash = getHpackValueHash(hname, value, len),
+                     i    = findHpackOutputDynTblEntry(dyntbl, hash, name, value, len);
+
+            if (i)
+               {
+               dst = hpackEncodeInt(dst, i, (1<<7)-1, 0x80); // indexed header field (dynamic table)
+
+               U_RETURN_POINTER(dst, unsigned char);
+               }
+
+            pattern = 0x40; // literal header field with incremental indexing
 
-            if (u__isupper(c)) *ptr = u__tolower(c);
+            if (index == 0) index = findHpackOutputDynTblEntry(dyntbl, hname, name, U_NULLPTR, 0);
             }
          }
+      }
 
+   UString lname;
+
+   if (index) dst = hpackEncodeInt(dst, index, (pattern == 0x40 ? (1<<6)-1 : (1<<4)-1), pattern);
+   else
+      {
 #  ifdef DEBUG
       if (isHeaderName(name) == false)
          {
@@ -2578,18 +2703,34 @@ unsigned char* UHTTP2::hpackEncodeHeader(unsigned char* dst, const UString& name
          }
 #  endif
 
-      *dst++ = 0;
-       dst   = hpackEncodeString(dst, name, true); // not-existing name
+      // NB: the name of a literal must be lowercase, we make a private copy to not change the headers of the caller...
+
+      (void) lname.replace(name);
+
+      for (char* ptr = lname.data(), *end = ptr + lname.size(); ptr < end; ++ptr) *ptr = u__tolower(*ptr);
+
+      *dst++ = pattern;
+       dst   = hpackEncodeString(dst, lname); // not-existing name
       }
 
-   dst = hpackEncodeString(dst, value, true);
+   dst = hpackEncodeString(dst, value, len);
+
+   if (pattern == 0x40)
+      {
+      U_INTERNAL_ASSERT_POINTER(dyntbl)
+
+           if (index >= HTTP2_HEADER_TABLE_OFFSET) lname._assign(getHpackDynTblEntry(dyntbl, index-HTTP2_HEADER_TABLE_OFFSET)->name);
+      else if (index)                             lname._assign(hpack_static_table[index-1].name);
+
+      addHpackOutputDynTblEntry(dyntbl, lname, UString((void*)value, len), hname);
+      }
 
    U_RETURN_POINTER(dst, unsigned char);
 }
 
-unsigned char* UHTTP2::setHpackHeaders(unsigned char* dst, const UString& headers)
+unsigned char* UHTTP2::setHpackHeaders(unsigned char* dst, const UString& headers, HpackDynamicTable* dyntbl)
 {
-   U_TRACE(0, "UHTTP2::setHpackHeaders(%p,%V)", dst, headers.rep)
+   U_TRACE(0, "UHTTP2::setHpackHeaders(%p,%V,%p)", dst, headers.rep, dyntbl)
 
    UString row, key;
    UVector<UString> vext(20);
@@ -2600,7 +2741,7 @@ unsigned char* UHTTP2::setHpackHeaders(unsigned char* dst, const UString& header
 
       uint32_t pos = row.find_first_of(':');
 
-      dst = hpackEncodeHeader(dst, row.substr(0U, pos), row.substr(pos+2)); 
+      dst = hpackEncodeHeader(dst, dyntbl, row.substr(0U, pos), row.substr(pos+2));
       }
 
    U_RETURN_POINTER(dst, unsigned char);
@@ -2621,6 +2762,13 @@ void UHTTP2::handlerResponse()
 
    unsigned char* dst = (unsigned char*)UClientImage_Base::wbuffer->data();
 
+   HpackDynamicTable* dyntbl = &(pConnection->odyntbl);
+
+   U_INTERNAL_DUMP("num_entries = %u entry_capacity = %u entry_start_index = %u hpack_size = %u hpack_capacity = %u hpack_max_capacity = %u",
+                     dyntbl->num_entries, dyntbl->entry_capacity, dyntbl->entry_start_index, dyntbl->hpack_size, dyntbl->hpack_capacity, dyntbl->hpack_max_capacity)
+
+   if (dyntbl->hpack_capacity != dyntbl->hpack_max_capacity) dst = setHpackOutputDynTblCapacity(dst, dyntbl->hpack_max_capacity); // dynamic table size update
+
    if (U_http_info.nResponseCode == HTTP_NOT_IMPLEMENTED ||
        U_http_info.nResponseCode == HTTP_OPTIONS_RESPONSE)
       {
@@ -2688,81 +2836,20 @@ void UHTTP2::handlerResponse()
    /**
     * server: ULib
     * date: Wed, 20 Jun 2012 11:43:17 GMT
+    *
+    * NB: they go in the output dynamic table, so after the first response they cost one byte each (the date until it changes)...
     */
 
-   HpackDynamicTable* dyntbl = &(pConnection->odyntbl);
-
-   U_INTERNAL_DUMP("num_entries = %u entry_capacity = %u entry_start_index = %u hpack_size = %u hpack_capacity = %u hpack_max_capacity = %u",
-                     dyntbl->num_entries, dyntbl->entry_capacity, dyntbl->entry_start_index, dyntbl->hpack_size, dyntbl->hpack_capacity, dyntbl->hpack_max_capacity)
-
-   if (dyntbl->num_entries == 0)
-      {
-#  if !defined(U_LINUX) || !defined(ENABLE_THREAD)
-      ULog::updateDate3(U_NULLPTR);
-#  endif
-
-      UString date((void*)(((char*)UClientImage_Base::iov_vec[1].iov_base)+6), 29);
-
-      /**
-       * dst = hpackEncodeInt(dst, 54, (1<<6)-1, 0x40);
-       * dst = hpackEncodeString(dst, U_CONSTANT_TO_PARAM("ULib"), false);
-       * dst = hpackEncodeInt(dst, 33, (1<<6)-1, 0x40);
-       */
-
-      u_put_unalignedp64(dst, U_MULTICHAR_CONSTANT64(0x76,0x04,0x55,0x4C,0x69,0x62,0x61,'\0'));
-
-      dst = hpackEncodeString(dst+7, date.data(), 29, true); // Date: Wed, 20 Jun 2012 11:43:17 GMT\r\nServer: ULib\r\nConnection: close\r\n
-
-      addHpackDynTblEntry(dyntbl, *UString::str_server, *UString::str_ULib);
-      addHpackDynTblEntry(dyntbl, *UString::str_date, date);
-      }
-   else
-      {
-      HpackHeaderTableEntry* entry = getHpackDynTblEntry(dyntbl, 0); // last entry
-
-      char* ptr_date = entry->value->data();
-
-#  if !defined(U_LINUX) || !defined(ENABLE_THREAD)
-      ULog::updateDate3(ptr_date);
-#  endif
-
-      U_ASSERT(UString::str_date->equal(entry->name))
-
-      /**
-       * dst = hpackEncodeInt(dst, 1+HTTP2_HEADER_TABLE_OFFSET, (1<<7)-1, 0x80);
-       */
-
-      *dst++ = 0xbf;
-
-      if (ULog::tv_sec_old_3 == u_now->tv_sec)
-         {
-         /**
-          * dst = hpackEncodeInt(dst, 0+HTTP2_HEADER_TABLE_OFFSET, (1<<7)-1, 0x80);
-          */
-
-         *dst++ = 0xbe;
-         }
-      else
-         {
-         /**
-          * dst = hpackEncodeInt(dst, 0+HTTP2_HEADER_TABLE_OFFSET, (1<<6)-1, 0x40);
-          */
+#if !defined(U_LINUX) || !defined(ENABLE_THREAD)
+   ULog::updateDate3(U_NULLPTR);
+#endif
 
-         *dst++ = 0x7e;
-          dst   = hpackEncodeString(dst, ptr_date, 29, true); // Date: Wed, 20 Jun 2012 11:43:17 GMT\r\nServer: ULib\r\nConnection: close\r\n
-         }
-      }
+   dst = hpackEncodeHeader(dst, dyntbl, *UString::str_server, *UString::str_ULib);
+   dst = hpackEncodeHeader(dst, dyntbl, *UString::str_date, ((const char*)UClientImage_Base::iov_vec[1].iov_base)+6, 29);
 
    if (sz1)
       {
-      /**
-       * dst = hpackEncodeInt(dst, 55, (1<<4)-1, 0x00);
-       */
-
-      u_put_unalignedp16(dst, U_MULTICHAR_CONSTANT16(0x0f,0x28));
-                         dst += 2;
-
-      dst = hpackEncodeString(dst, UHTTP::set_cookie->data(), sz1, true);
+      dst = setHpackHeaders(dst, *UHTTP::set_cookie, dyntbl); // NB: set-cookie is never indexed...
 
       UHTTP::set_cookie->setEmpty();
       }
@@ -2781,7 +2868,7 @@ void UHTTP2::handlerResponse()
          {
          U_ASSERT(UHTTP::ext->isPrintable(0, true))
 
-         dst = setHpackHeaders(dst, *UHTTP::ext);
+         dst = setHpackHeaders(dst, *UHTTP::ext, dyntbl);
          }
       }
    else
@@ -3903,6 +3990,15 @@ void UHTTP2::clearHpackDynTbl(HpackDynamicTable* dyntbl)
       U_INTERNAL_DUMP("num_entries = %u entry_capacity = %u entry_start_index = %u hpack_size = %u hpack_capacity = %u hpack_max_capacity = %u",
                         dyntbl->num_entries, dyntbl->entry_capacity, dyntbl->entry_start_index, dyntbl->hpack_size, dyntbl->hpack_capacity, dyntbl->hpack_max_capacity)
       }
+
+   if (dyntbl->hindex)
+      {
+      UMemoryPool::_free(dyntbl->hindex, U_HPACK_INDEX_SIZE * 2, sizeof(uint32_t));
+
+      dyntbl->hindex = U_NULLPTR;
+      }
+
+   dyntbl->insert_count = 0;
 }
 
 #ifdef DEBUG
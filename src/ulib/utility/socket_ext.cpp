@@ -413,7 +413,7 @@ uint32_t USocketExt::sendfile(USocket* sk, int in_fd, off_t* poffset, off_t coun
 
    U_DUMP("bssl = %b blocking = %b", sk->isSSLActive(), sk->isBlocking())
 
-   U_INTERNAL_ASSERT_EQUALS(sk->isSSLActive(), false)
+   U_INTERNAL_ASSERT(sk->isSSLActive() == false || sk->isKTLS()) // NB: with kTLS the kernel encrypt what sendfile() write on the socket...
 
 #if defined(HAVE_MACOSX_SENDFILE) || defined(HAVE_BSD_SENDFILE)
    off_t len;
@@ -37,7 +37,11 @@
 #endif
 
 #ifndef U_LOG_DISABLE
+#  ifdef ENABLE_THREAD
+__thread const char* UStringExt::deflate_agent = "gzip";
+#  else
 const char* UStringExt::deflate_agent = "gzip";
+#  endif
 #endif
 
 #ifdef USE_LIBSSL
@@ -1630,7 +1634,11 @@ UString UStringExt::decompress(const char* s, uint32_t n)
    U_RETURN_STRING(out);
 }
 
+#ifdef ENABLE_THREAD
+__thread uint32_t UStringExt::ratio;
+#else
 uint32_t UStringExt::ratio;
+#endif
 uint32_t UStringExt::ratio_threshold = 90; // NB: we accept compressed data only if ratio compression is better than 10%...
 
 #ifdef USE_LIBBROTLI
@@ -1705,6 +1713,108 @@ UString UStringExt::unbrotli(const char* ptr, uint32_t sz) // .br uncompress
 #endif
 }
 
+#ifdef USE_LIBZSTD
+UString UStringExt::zstd(const char* s, uint32_t len, int level) // .zst compress
+{
+   U_TRACE(1, "UStringExt::zstd(%.*S,%u,%d)", len, s, len, level)
+
+   size_t sz = U_SYSCALL(ZSTD_compressBound, "%u", len); /* Get an estimation about the output buffer... */
+
+   if (sz == 0) return UString::getStringNull();
+
+   UString result;
+
+   result.setConstant(sz);
+
+   sz = U_SYSCALL(ZSTD_compress, "%p,%u,%p,%u,%d", result.data(), sz, s, len, level);
+
+   if (ZSTD_isError(sz))
+      {
+      U_WARNING("zstd encoder fail, error %S", ZSTD_getErrorName(sz));
+
+      return UString::getStringNull();
+      }
+
+   ratio = (sz * 100U) / len;
+
+   U_INTERNAL_DUMP("ZSTD_compress() = %u ratio = %u (%u%%)", sz, ratio, 100-ratio)
+
+   if (ratio > ratio_threshold) return UString::getStringNull();
+
+   result.checkConstant(sz);
+
+   U_INTERNAL_ASSERT(isZstd(result)) // check magic number
+
+   U_RETURN_STRING(result);
+}
+#endif
+
+UString UStringExt::unzstd(const char* ptr, uint32_t sz) // .zst uncompress
+{
+   U_TRACE(0, "UStringExt::unzstd(%.*S,%u)", sz, ptr, sz)
+
+#ifdef USE_LIBZSTD
+   size_t rc;
+   unsigned long long sz_orig = ZSTD_getFrameContentSize(ptr, sz);
+
+   U_INTERNAL_DUMP("sz_orig = %llu", sz_orig)
+
+   if (sz_orig != ZSTD_CONTENTSIZE_UNKNOWN &&
+       sz_orig != ZSTD_CONTENTSIZE_ERROR)
+      {
+      // NB: the frame declare the size of the content (it is always the case with ZSTD_compress())...
+
+      UString r((uint32_t)sz_orig);
+
+      rc = U_SYSCALL(ZSTD_decompress, "%p,%u,%p,%u", r.data(), (size_t)sz_orig, ptr, sz);
+
+      if (ZSTD_isError(rc))
+         {
+         U_WARNING("zstd decoder fail, error %S", ZSTD_getErrorName(rc));
+
+         return UString::getStringNull();
+         }
+
+      r.size_adjust(rc);
+
+      U_RETURN_STRING(r);
+      }
+
+   UString r(sz * 4);
+   ZSTD_inBuffer input = { ptr, sz, 0 };
+   size_t buffer_size = ZSTD_DStreamOutSize();
+   ZSTD_DStream* dstream = (ZSTD_DStream*) U_SYSCALL_NO_PARAM(ZSTD_createDStream);
+
+   (void) U_SYSCALL(ZSTD_initDStream, "%p", dstream);
+
+   while (input.pos < input.size)
+      {
+      (void) r.reserve(buffer_size);
+
+      ZSTD_outBuffer output = { r.pend(), buffer_size, 0 };
+
+      rc = U_SYSCALL(ZSTD_decompressStream, "%p,%p,%p", dstream, &output, &input);
+
+      if (ZSTD_isError(rc))
+         {
+         U_WARNING("zstd decoder fail, error %S", ZSTD_getErrorName(rc));
+
+         r.clear();
+
+         break;
+         }
+
+      r.size_adjust(r.size() + output.pos);
+      }
+
+   (void) U_SYSCALL(ZSTD_freeDStream, "%p", dstream);
+
+   U_RETURN_STRING(r);
+#else
+   return UString::getStringNull();
+#endif
+}
+
 #ifdef USE_LIBZ
 UString UStringExt::deflate(const char* s, uint32_t len, uint32_t quality) // .gz compress
 {
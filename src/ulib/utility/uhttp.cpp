@@ -17,6 +17,7 @@
 #include <ulib/date.h>
 #include <ulib/db/rdb.h>
 #include <ulib/tokenizer.h>
+#include <ulib/json/value.h>
 #include <ulib/mime/entity.h>
 #include <ulib/utility/uhttp.h>
 #include <ulib/mime/multipart.h>
@@ -47,6 +48,9 @@
 #ifdef USE_LIBSSL
 #  include <ulib/ssl/net/ssl_session.h>
 #endif
+#ifdef ENABLE_THREAD
+#  include <ulib/thread.h>
+#endif
 #ifdef USE_LIBMAGIC
 #  include <ulib/magic/magic.h>
 #endif
@@ -412,6 +416,263 @@ uint32_t               UHTTP::inotify_len;
 UString*               UHTTP::inotify_pathname;
 UStringRep*            UHTTP::inotify_dir;
 UHTTP::UFileCacheData* UHTTP::inotify_file_data;
+UVector<UString>*      UHTTP::inotify_renew;
+UEventTime*            UHTTP::inotify_renew_timer;
+# if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+bool                   UHTTP::inotify_compress_fast;
+#  ifdef ENABLE_THREAD
+UThreadPool*           UHTTP::compress_pool;
+UCompressJob*          UHTTP::compress_job;
+UCompressJob*          UHTTP::compress_jobs;
+
+class U_NO_EXPORT UCompressJob {
+public:
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   UCompressJob* next;
+   UString path, content, gzip, brotli, zstd;
+   uint32_t done;
+   bool stale;
+
+   // NB: we make a copy of the strings, so the thread of the pool and the event loop don't share any reference counter...
+
+   UCompressJob(const UString& _path, const UString& _content) : path((const void*)U_STRING_TO_PARAM(_path)), content((const void*)U_STRING_TO_PARAM(_content))
+      {
+      U_TRACE_CTOR(0, UCompressJob, "%V,%V", _path.rep, _content.rep)
+
+      next  = U_NULLPTR;
+      done  = 0;
+      stale = false;
+      }
+
+   ~UCompressJob()
+      {
+      U_TRACE_DTOR(0, UCompressJob)
+      }
+
+   static void runCodec(void* arg, uint32_t i) // NB: it run on a thread of the pool, a codec for index...
+      {
+      U_TRACE(0, "UCompressJob::runCodec(%p,%u)", arg, i)
+
+      UCompressJob* job = (UCompressJob*)arg;
+
+      switch (i)
+         {
+#     ifdef USE_LIBZ
+         case 0: job->gzip = UStringExt::deflate(job->content); break; // zopfli...
+#     endif
+#     ifdef USE_LIBBROTLI
+         case 1: job->brotli = UStringExt::brotli(job->content); break;
+#     endif
+#     ifdef USE_LIBZSTD
+         case 2: job->zstd = UStringExt::zstd(job->content); break;
+#     endif
+         default: break;
+         }
+      }
+
+   static void run(void* arg) // NB: it run on the thread of the pool...
+      {
+      U_TRACE(0, "UCompressJob::run(%p)", arg)
+
+      // NB: the codecs with the max levels are independent, parallelFor() push them on the deque of this worker and the idle workers steal them...
+
+      UHTTP::compress_pool->parallelFor(3, runCodec, arg, 1);
+
+      __atomic_store_n(&(((UCompressJob*)arg)->done), 1, __ATOMIC_RELEASE);
+      }
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UCompressJob)
+};
+#  endif
+# endif
+
+#define U_INOTIFY_RENEW_BATCH 4 // max number of files renewed for each tick of the timer...
+
+class U_NO_EXPORT UInotifyRenew : public UEventTime {
+public:
+
+   // NB: we wait a second before the renew so that the editor have finished to write the file (we receive many IN_MODIFY)...
+
+   UInotifyRenew() : UEventTime(1L, 0L)
+      {
+      U_TRACE_CTOR(0, UInotifyRenew, "")
+      }
+
+   virtual ~UInotifyRenew() U_DECL_FINAL
+      {
+      U_TRACE_DTOR(0, UInotifyRenew)
+      }
+
+   // define method VIRTUAL of class UEventTime
+
+   virtual int handlerTime() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(0, "UInotifyRenew::handlerTime()")
+
+      if (UHTTP::renewInotifyPending()) U_RETURN(0); // monitoring (there are other files to renew...)
+
+      U_RETURN(-1); // normal
+      }
+
+#if defined(DEBUG) && defined(U_STDCPP_ENABLE)
+   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
+#endif
+
+private:
+   U_DISALLOW_COPY_AND_ASSIGN(UInotifyRenew)
+};
+
+U_NO_EXPORT void UHTTP::addInotifyPending(const UString& pathname)
+{
+   U_TRACE(0, "UHTTP::addInotifyPending(%V)", pathname.rep)
+
+   /**
+    * NB: the content of the file in cache (with the compressed versions) is renewed by a timer and not at the next request
+    * for the file. Meanwhile the old content is served. The renew compress with the fast levels, the max levels (zopfli,
+    * brotli, zstd) are computed by the threads of a pool and installed by the timer when they are ready...
+    */
+
+   if (inotify_renew == U_NULLPTR)
+      {
+      U_NEW(UVector<UString>, inotify_renew, UVector<UString>);
+      U_NEW(UInotifyRenew, inotify_renew_timer, UInotifyRenew);
+      }
+
+   if (inotify_renew->find(pathname) != U_NOT_FOUND) return; // NB: it is already pending...
+
+   bool binsert = (inotify_renew->empty() && isInotifyCompressPending() == false);
+
+   inotify_renew->push_back(UString((const void*)U_STRING_TO_PARAM(pathname))); // NB: inotify_pathname is overwritten by the next event...
+
+   if (binsert) UTimer::insert(inotify_renew_timer);
+}
+
+bool UHTTP::renewInotifyPending()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::renewInotifyPending()")
+
+   U_INTERNAL_ASSERT_POINTER(inotify_renew)
+
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+   inotify_compress_fast = true;
+
+# ifdef ENABLE_THREAD
+   if (compress_jobs) checkCompressJob();
+# endif
+#endif
+
+   uint32_t n = inotify_renew->size();
+
+   if (n > U_INOTIFY_RENEW_BATCH) n = U_INOTIFY_RENEW_BATCH;
+
+   for (uint32_t i = 0; i < n; ++i)
+      {
+      // NB: the file can be deleted meanwhile...
+
+      if ((file_data = getFileCachePointer((*inotify_renew)[i]))) renewFileDataInCache();
+      }
+
+   inotify_renew->erase(0, n);
+
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+   inotify_compress_fast = false;
+#endif
+
+   file_data         =
+   inotify_file_data = U_NULLPTR; // NB: the entry can be changed by renewFileDataInCache()...
+
+   if (inotify_renew->empty() &&
+       isInotifyCompressPending() == false)
+      {
+      U_RETURN(false);
+      }
+
+   U_RETURN(true);
+}
+
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+# ifdef ENABLE_THREAD
+U_NO_EXPORT void UHTTP::addCompressJob(const UString& path, const UString& content)
+{
+   U_TRACE(0, "UHTTP::addCompressJob(%V,%V)", path.rep, content.rep)
+
+   UCompressJob* job;
+
+   for (job = compress_jobs; job; job = job->next)
+      {
+      if (job->path == path) job->stale = true; // NB: the content is changed again, the result of this job is useless...
+      }
+
+   if (inotify_renew == U_NULLPTR)
+      {
+      U_NEW(UVector<UString>, inotify_renew, UVector<UString>);
+      U_NEW(UInotifyRenew, inotify_renew_timer, UInotifyRenew);
+      }
+
+   // NB: the timer is armed while there are files to renew or jobs not installed...
+
+   bool binsert = (inotify_renew->empty() && compress_jobs == U_NULLPTR);
+
+   if (compress_pool == U_NULLPTR) U_NEW(UThreadPool, compress_pool, UThreadPool(u_num_cpu > 1 ? U_min(u_num_cpu, 3) : 1)); // NB: a worker for codec at most (see UCompressJob::run())...
+
+   U_NEW(UCompressJob, job, UCompressJob(path, content));
+
+   job->next     = compress_jobs;
+   compress_jobs = job;
+
+   compress_pool->addTask(UCompressJob::run, job);
+
+   if (binsert) UTimer::insert(inotify_renew_timer);
+}
+
+U_NO_EXPORT void UHTTP::checkCompressJob()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::checkCompressJob()")
+
+   UCompressJob* job;
+   UCompressJob** ptr = &compress_jobs;
+
+   while ((job = *ptr))
+      {
+      if (__atomic_load_n(&(job->done), __ATOMIC_ACQUIRE) == 0)
+         {
+         ptr = &(job->next);
+
+         continue;
+         }
+
+      // NB: we renew the entry, if the content is not changed putDataInCache() install the result of the job...
+
+      if (job->stale == false &&
+          (file_data = getFileCachePointer(job->path)))
+         {
+         compress_job = job;
+
+         renewFileDataInCache();
+
+         compress_job = U_NULLPTR;
+
+         // NB: the renew can have added other jobs at the head of the list...
+
+         for (ptr = &compress_jobs; *ptr != job; ptr = &((*ptr)->next)) {}
+         }
+
+      *ptr = job->next;
+
+      U_DELETE(job)
+      }
+
+   file_data = U_NULLPTR;
+}
+# endif
+#endif
 
 U_NO_EXPORT void UHTTP::setInotifyPathname()
 {
@@ -609,7 +870,18 @@ void UHTTP::in_READ()
 
                if ((mask & IN_CREATE) != 0)
                   {
-                  if (inotify_file_data == U_NULLPTR) checkFileForCache(*inotify_pathname);
+                  if (inotify_file_data == U_NULLPTR)
+                     {
+#                 if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+                     inotify_compress_fast = true;
+#                 endif
+
+                     checkFileForCache(*inotify_pathname);
+
+#                 if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+                     inotify_compress_fast = false;
+#                 endif
+                     }
                   }
                else
                   {
@@ -635,7 +907,7 @@ void UHTTP::in_READ()
                         {
                         // NB: check if we have the content of file in cache...
 
-                        if (inotify_file_data->array) inotify_file_data->expire = 0; // NB: we delay the renew...
+                        if (inotify_file_data->array) addInotifyPending(*inotify_pathname); // NB: we delay the renew...
                         else
                            {
                            if (file_data == U_NULLPTR) file_data = getFileCachePointer(*inotify_pathname);
@@ -1322,6 +1594,10 @@ void UHTTP::init()
 # endif
 #endif
 
+#if defined(U_STDCPP_ENABLE) && (defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD))
+   cache_file->callForAllEntry(compressDataFromStore); // NB: the entries loaded from the cache file store and the internal stores...
+#endif
+
    sz = cache_file->size();
 
    U_INTERNAL_DUMP("cache size = %u", sz)
@@ -1430,11 +1706,43 @@ void UHTTP::dtor()
 
       U_DELETE(inotify_pathname)
 
+      if (inotify_renew)
+         {
+         if ((inotify_renew->empty() == false ||
+              isInotifyCompressPending())      &&
+             UTimer::empty() == false)
+            {
+            UTimer::erase(inotify_renew_timer);
+            }
+
+         U_DELETE(inotify_renew)
+         U_DELETE(inotify_renew_timer)
+         }
+
+#  if (defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)) && defined(ENABLE_THREAD)
+      if (compress_pool) U_DELETE(compress_pool) // NB: it wait the end of the current job...
+
+      while (compress_jobs)
+         {
+         UCompressJob* job = compress_jobs;
+
+         compress_jobs = job->next;
+
+         U_DELETE(job)
+         }
+#  endif
+
       UServer_Base::handler_inotify = U_NULLPTR;
       }
 #endif
 
-   if (vservice)              U_DELETE(vservice)
+   if (vservice)
+      {
+      UModProxyService::clear();
+
+      U_DELETE(vservice)
+      }
+
    if (vmsg_error)            U_DELETE(vmsg_error)
    if (fcgi_uri_mask)         U_DELETE(fcgi_uri_mask)
    if (scgi_uri_mask)         U_DELETE(scgi_uri_mask)
@@ -2638,37 +2946,126 @@ U_NO_EXPORT inline void UHTTP::setContentLength(const char* p1, const char* p2)
    U_http_info.clength = u_strtoul(ptr, endptr);
 }
 
-#if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
-U_NO_EXPORT inline void UHTTP::setAcceptEncoding(const char* ptr, uint32_t len)
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+static int getQualityValue(const char* ptr, const char* end) // "0.8" => 800 (thousandths)
 {
-   U_TRACE(0, "UHTTP::setAcceptEncoding(%.*S,%u)", len, ptr, len)
+   U_TRACE(0, "getQualityValue(%.*S,%p)", (int)(end-ptr), ptr, end)
 
-   const char* p1;
+   if (ptr >= end ||
+       *ptr == '1') // NB: "1", "1.0", "1.000"...
+      {
+      U_RETURN(1000);
+      }
 
-#ifdef USE_LIBBROTLI
-   p1 = (u_get_unalignedp16(ptr)       == U_MULTICHAR_CONSTANT16('b','r') ? ptr       :
-         u_get_unalignedp16(ptr+len-2) == U_MULTICHAR_CONSTANT16('b','r') ? ptr+len-2 : (const char*)u_find(ptr, len, U_CONSTANT_TO_PARAM("br")));
+   int q = 0;
 
-   if (                   p1 &&
-       u_get_unalignedp32(p1) != U_MULTICHAR_CONSTANT32(';','q','=','0'))
+   if (   *ptr == '0' &&
+        ++ptr  <  end &&
+          *ptr == '.')
       {
-      U_http_flag |= HTTP_IS_ACCEPT_BROTLI;
-
-      U_INTERNAL_DUMP("U_http_is_accept_brotli = %b", U_http_is_accept_brotli)
+      for (int i = 0, m = 100; i < 3 && ++ptr < end && u__isdigit(*ptr); ++i, m /= 10) q += (*ptr - '0') * m;
       }
-#endif
 
-#ifdef USE_LIBZ
-   p1 = (u_get_unalignedp32(ptr) == U_MULTICHAR_CONSTANT32('g','z','i','p') ? ptr : (const char*)u_find(ptr, len, U_CONSTANT_TO_PARAM("gzip")));
+   U_RETURN(q);
+}
 
-   if (                   p1 &&
-       u_get_unalignedp32(p1) != U_MULTICHAR_CONSTANT32(';','q','=','0'))
+uint8_t UHTTP::getAcceptEncoding(const char* ptr, uint32_t len)
+{
+   U_TRACE(0, "UHTTP::getAcceptEncoding(%.*S,%u)", len, ptr, len)
+
+   /**
+    * Accept-Encoding: br;q=1.0, gzip;q=0.8, *;q=0.1
+    *
+    * Every coding can have a quality value (RFC 7231 5.3.4), a coding with q=0 is not acceptable and "*" match the codings
+    * not listed in the field. Between the codings that we have we enable only the ones with the highest quality value, so
+    * with a tie the choice is ours (brotli, zstd and then gzip, see processDataFromCache())...
+    */
+
+   char c;
+   uint32_t n;
+   const char* p;
+   uint8_t mask = 0;
+   const char* end = ptr + len;
+   int q, qbest = 0, qstar = -1, qgzip = -1, qbrotli = -1, qzstd = -1;
+
+   while (ptr < end)
       {
-      U_http_flag |= HTTP_IS_ACCEPT_GZIP;
+      while (ptr < end && ((c = *ptr) == ',' || u__isspace(c))) ++ptr;
+
+      for (p = ptr; ptr < end && (c = *ptr) != ',' && c != ';' && u__isspace(c) == false; ++ptr) {}
+
+      n = ptr - p;
+      q = 1000;
+
+      while (ptr < end && *ptr != ',') // parameters (;q=0.8)
+         {
+         if (*ptr++ == ';')
+            {
+            while (ptr < end && u__isspace(*ptr)) ++ptr;
+
+            if ((end - ptr) > 2          &&
+                (ptr[0] | 0x20) == 'q'   &&
+                 ptr[1]         == '=')
+               {
+               q = getQualityValue(ptr+2, end);
+               }
+            }
+         }
+
+      U_INTERNAL_DUMP("coding = %.*S q = %d", n, p, q)
 
-      U_INTERNAL_DUMP("U_http_is_accept_gzip = %b", U_http_is_accept_gzip)
+           if (n == 1 && *p == '*')                      qstar   = q;
+      else if (n == 2 && strncasecmp(p,   "br", 2) == 0) qbrotli = q;
+      else if (n == 4 && strncasecmp(p, "zstd", 4) == 0) qzstd   = q;
+      else if ((n == 4 && strncasecmp(p,   "gzip", 4) == 0) ||
+               (n == 6 && strncasecmp(p, "x-gzip", 6) == 0))
+         {
+         qgzip = q;
+         }
+      }
+
+   if (qstar != -1)
+      {
+      if (qgzip   == -1) qgzip   = qstar;
+      if (qbrotli == -1) qbrotli = qstar;
+      if (qzstd   == -1) qzstd   = qstar;
       }
+
+#ifdef USE_LIBBROTLI
+   if (qbrotli > qbest) qbest = qbrotli;
 #endif
+#ifdef USE_LIBZSTD
+   if (qzstd > qbest) qbest = qzstd;
+#endif
+#ifdef USE_LIBZ
+   if (qgzip > qbest) qbest = qgzip;
+#endif
+
+   U_INTERNAL_DUMP("qbest = %d qbrotli = %d qzstd = %d qgzip = %d qstar = %d", qbest, qbrotli, qzstd, qgzip, qstar)
+
+   if (qbest) // NB: otherwise only identity...
+      {
+#  ifdef USE_LIBBROTLI
+      if (qbrotli == qbest) mask |= HTTP_IS_ACCEPT_BROTLI;
+#  endif
+#  ifdef USE_LIBZSTD
+      if (qzstd   == qbest) mask |= HTTP_IS_ACCEPT_ZSTD;
+#  endif
+#  ifdef USE_LIBZ
+      if (qgzip   == qbest) mask |= HTTP_IS_ACCEPT_GZIP;
+#  endif
+      }
+
+   U_RETURN(mask);
+}
+
+U_NO_EXPORT inline void UHTTP::setAcceptEncoding(const char* ptr, uint32_t len)
+{
+   U_TRACE(0, "UHTTP::setAcceptEncoding(%.*S,%u)", len, ptr, len)
+
+   U_http_flag |= getAcceptEncoding(ptr, len);
+
+   U_INTERNAL_DUMP("U_http_is_accept_gzip = %b U_http_is_accept_brotli = %b U_http_is_accept_zstd = %b", U_http_is_accept_gzip, U_http_is_accept_brotli, U_http_is_accept_zstd)
 }
 #endif
 
@@ -3029,7 +3426,7 @@ U_NO_EXPORT bool UHTTP::checkRequestForHeader()
             {
             p1 = p+6;
 
-#        if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+#        if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
             if (u_get_unalignedp32(p1) == U_MULTICHAR_CONSTANT32('-','E','n','c'))
                {
                SET_POINTER_CHECK_REQUEST_FOR_HEADER
@@ -3153,7 +3550,7 @@ U_NO_EXPORT bool UHTTP::checkRequestForHeader()
                   p1 = p+7;
                   c  = u__toupper(*(p1-1));
 
-#              if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+#              if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
                   if (c == 'E' &&
                       memcmp(p1, U_CONSTANT_TO_PARAM("ncoding")) == 0)
                      {
@@ -3693,7 +4090,7 @@ bool UHTTP::handlerCache()
 
    U_INTERNAL_DUMP("is_response_compressed = %u", is_response_compressed)
 
-# if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+# if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
    if (is_response_compressed)
       {
       U_INTERNAL_DUMP("U_http_uri_offset = %u", U_http_uri_offset)
@@ -3712,7 +4109,7 @@ bool UHTTP::handlerCache()
          setAcceptEncoding(p, p1-p);
          }
 
-      U_INTERNAL_DUMP("U_http_is_accept_gzip = %b U_http_is_accept_brotli = %b", U_http_is_accept_gzip, U_http_is_accept_brotli)
+      U_INTERNAL_DUMP("U_http_is_accept_gzip = %b U_http_is_accept_brotli = %b U_http_is_accept_zstd = %b", U_http_is_accept_gzip, U_http_is_accept_brotli, U_http_is_accept_zstd)
 
 #   ifdef USE_LIBBROTLI
       if (is_response_compressed == 2 &&
@@ -3722,6 +4119,14 @@ bool UHTTP::handlerCache()
          }
 #   endif
 
+#   ifdef USE_LIBZSTD
+      if (is_response_compressed == 3 &&
+          U_http_is_accept_zstd == false)
+         {
+         U_RETURN(false);
+         }
+#   endif
+
 #   ifdef USE_LIBZ
       if (is_response_compressed == 1 &&
           U_http_is_accept_gzip == false)
@@ -3823,6 +4228,29 @@ U_NO_EXPORT inline bool UHTTP::setSendfile(int fd, off_t start, off_t count)
 {
    U_TRACE(0, "UHTTP::setSendfile(%d,%I,%I)", fd, start, count)
 
+   U_INTERNAL_DUMP("U_http_version = %C", U_http_version)
+
+   // NB: with HTTP/2 the body must go in DATA frames, so the raw bytes of the file cannot be spliced on the connection (neither with kTLS).
+   //     The same with SSL when the kernel has not the keys of this connection (cipher or kernel without kTLS support): we fall back on the mapped file...
+
+   if (U_http_version == '2'
+#ifdef USE_LIBSSL
+       || (UServer_Base::bssl &&
+           UServer_Base::csocket->isKTLS() == false)
+#endif
+      )
+      {
+      uint32_t resto = start & U_PAGEMASK,
+               len   = count + resto;
+
+      char* ptr = UFile::mmap(&len, fd, PROT_READ, MAP_SHARED, start - resto);
+
+      if (ptr == (char*)MAP_FAILED) setServiceUnavailable();
+      else                          UClientImage_Base::body->mmap(ptr + resto, count);
+
+      U_RETURN(false);
+      }
+
    UClientImage_Base::setSendfile(fd, start, count);
 
    if ((count - start) > (6 * U_1M)) return UServer_Base::startParallelization();
@@ -4718,7 +5146,7 @@ file_in_cache:
       U_DUMP("U_http_info.nResponseCode = %u", U_http_info.nResponseCode)
 
 #  ifdef U_EVASIVE_SUPPORT
-      if (UServer_Base::db_evasive &&
+      if (UServer_Base::evasive_table &&
           UServer_Base::checkHitUriStats())
          {
          U_RETURN(U_PLUGIN_HANDLER_ERROR);
@@ -4767,6 +5195,8 @@ file_in_cache:
          U_INTERNAL_DUMP("U_http_info.nResponseCode = %u", U_http_info.nResponseCode)
 
          usp->runDynamicPage();
+
+         UValue::endRequestArena(); // NB: the JSON trees of the page (see USP_JSON_ARENA) are released all together...
 #     endif
 
          U_DUMP("U_http_info.nResponseCode = %u U_ClientImage_parallelization = %d UClientImage_Base::bnoheader = %b",
@@ -4871,7 +5301,7 @@ from_cache:
 #ifdef U_EVASIVE_SUPPORT
    if (UClientImage_Base::isRequestNotFound()         == false && // => 3)
        UClientImage_Base::isRequestAlreadyProcessed() == false && // => 4)
-       UServer_Base::db_evasive                                &&
+       UServer_Base::evasive_table                             &&
        UServer_Base::checkHitUriStats())
       {
       U_RETURN(U_PLUGIN_HANDLER_ERROR);
@@ -4916,6 +5346,18 @@ from_cache:
       {
       U_INTERNAL_DUMP("UWebSocket::rbuffer = %p", UWebSocket::rbuffer)
 
+      if (vservice &&
+          UClientImage_Base::isRequestNotFound())
+         {
+         UModProxyService* elem = UModProxyService::findService();
+
+         if (elem &&
+             elem->isWebSocket())
+            {
+            U_RETURN(U_PLUGIN_HANDLER_OK); // NB: the handshake is forwarded to the upstream by the proxy (see mod_proxy)...
+            }
+         }
+
       if (UWebSocket::rbuffer == U_NULLPTR ||
           UWebSocket::sendAccept(UServer_Base::csocket) == false)
          {
@@ -5101,7 +5543,7 @@ U_NO_EXPORT inline void UHTTP::resetFileCache()
    file_data->fd = -1;
 }
 
-#if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
 U_NO_EXPORT inline bool UHTTP::compress(UString& header, const UString& lbody)
 {
    U_TRACE(0, "UHTTP::compress(%V,%V)", header.rep, lbody.rep)
@@ -5129,6 +5571,26 @@ U_NO_EXPORT inline bool UHTTP::compress(UString& header, const UString& lbody)
       }
 #endif
 
+#ifdef USE_LIBZSTD
+   if (U_http_is_accept_zstd &&
+       (*UClientImage_Base::body = UStringExt::zstd(lbody, (U_PARALLELIZATION_CHILD ? 19 : 3))))
+      {
+#  ifndef U_CACHE_REQUEST_DISABLE
+      is_response_compressed = 3; // zstd
+#  endif
+
+      u_put_unalignedp64(ptr,    U_MULTICHAR_CONSTANT64('C','o','n','t','e','n','t','-'));
+      u_put_unalignedp64(ptr+8,  U_MULTICHAR_CONSTANT64('E','n','c','o','d','i','n','g'));
+      u_put_unalignedp64(ptr+16, U_MULTICHAR_CONSTANT64(':',' ','z','s','t','d','\r','\n'));
+
+      header.rep->_length = U_CONSTANT_SIZE("Content-Encoding: zstd\r\n");
+
+      U_SRV_LOG("dynamic response: %u bytes - (%u%%) zstd compression ratio", UClientImage_Base::body->size(), 100-UStringExt::ratio);
+
+      U_RETURN(true);
+      }
+#endif
+
 #ifdef USE_LIBZ
    if (U_http_is_accept_gzip &&
        (*UClientImage_Base::body = UStringExt::deflate(lbody, (U_PARALLELIZATION_CHILD ? 0 : gzip_level_for_dynamic_content))))
@@ -5159,7 +5621,7 @@ void UHTTP::setDynamicResponse(const UString& lbody, const UString& header, cons
 
    ext->setBuffer(U_CAPACITY);
 
-#if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
    if (checkForCompression(lbody.size()) == false ||
        compress(*ext, lbody) == false)
 #endif
@@ -5877,6 +6339,13 @@ void UHTTP::initSessionSSL()
    U_INTERNAL_ASSERT_EQUALS(db_session_ssl, U_NULLPTR)
    U_INTERNAL_ASSERT_EQUALS(data_session_ssl, U_NULLPTR)
 
+   if (USSLSession::ticket_key_rotate) // NB: stateless resumption with the session tickets, nothing to write on db for every full handshake...
+      {
+      USSLSession::initTicketKey();
+
+      return;
+      }
+
    U_NEW(USSLSession, data_session_ssl, USSLSession);
    U_NEW(URDBObjectHandler<UDataStorage*>, db_session_ssl, URDBObjectHandler<UDataStorage*>(U_STRING_FROM_CONSTANT("../db/session.ssl"), -1, data_session_ssl));
 
@@ -7172,6 +7641,27 @@ void UHTTP::setResponse(const UString& content_type, UString* pbody)
          }
 #  endif
 
+#  ifdef USE_LIBZSTD
+      if (UStringExt::isZstd(*pbody))
+         {
+         if (U_http_is_accept_zstd == false) *UClientImage_Base::body = UStringExt::unzstd(*pbody);
+         else
+            {
+            char* ptr = ext->data();
+
+            u_put_unalignedp64(ptr,    U_MULTICHAR_CONSTANT64('C','o','n','t','e','n','t','-'));
+            u_put_unalignedp64(ptr+8,  U_MULTICHAR_CONSTANT64('E','n','c','o','d','i','n','g'));
+            u_put_unalignedp64(ptr+16, U_MULTICHAR_CONSTANT64(':',' ','z','s','t','d','\r','\n'));
+
+            ext->rep->_length = U_CONSTANT_SIZE("Content-Encoding: zstd\r\n");
+
+            *UClientImage_Base::body = *pbody;
+            }
+
+         goto next;
+         }
+#  endif
+
 #  ifdef USE_LIBZ
       if (UStringExt::isGzip(*pbody))
          {
@@ -7734,7 +8224,7 @@ void UHTTP::setDynamicResponse()
          }
 #  endif
 
-#  if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+#  if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
       if (checkForCompression(clength) == false)
 #  endif
       {
@@ -7760,7 +8250,7 @@ void UHTTP::setDynamicResponse()
 
       ext->setBuffer(U_CAPACITY);
 
-#  if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+#  if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
       if (checkForCompression(clength) == false)
 #  endif
       {
@@ -7770,11 +8260,11 @@ void UHTTP::setDynamicResponse()
       }
       }
 
-#if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
    U_ASSERT(checkForCompression(clength))
 #endif
 
-#if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
    if (compress(*ext, UClientImage_Base::wbuffer->substr(U_http_info.endHeader, clength))) clength = UClientImage_Base::body->size();
    else
       {
@@ -9013,21 +9503,176 @@ U_NO_EXPORT void UHTTP::setDataInCache(const UString& fmt, const UString& conten
    setHeaderForCache(file_data, header);
 }
 
-#ifdef USE_LIBBROTLI
-U_NO_EXPORT void UHTTP::checkArrayCompressData(UFileCacheData* ptr)
+#if defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+U_NO_EXPORT void UHTTP::checkArrayCompressData(UFileCacheData* ptr, uint32_t idx)
 {
-   U_TRACE(0, "UHTTP::checkArrayCompressData(%p)", ptr)
+   U_TRACE(0, "UHTTP::checkArrayCompressData(%p,%u)", ptr, idx)
 
-   if (ptr->array->size() == 2)
+   U_INTERNAL_ASSERT_EQUALS(idx & 1, 0)
+
+   // NB: the slots are fixed (2-3 gzip, 4-5 brotli, 6-7 zstd), we fill with null the ones before idx that we don't have...
+
+   while (ptr->array->size() < idx)
       {
-      ptr->array->push_back(UString::getStringNull()); // 2 gzip(content) 
-      ptr->array->push_back(UString::getStringNull()); // 3 gzip(header)
+      ptr->array->push_back(UString::getStringNull()); // content
+      ptr->array->push_back(UString::getStringNull()); // header
 
 #  ifndef U_HTTP2_DISABLE
-      ptr->http2->push_back(UString::getStringNull()); // 1 gzip(header)
+      ptr->http2->push_back(UString::getStringNull()); // header
+#  endif
+      }
+}
+#endif
+
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+U_NO_EXPORT UString UHTTP::getCompressedSibling(const char* suffix, uint32_t len)
+{
+   U_TRACE(0, "UHTTP::getCompressedSibling(%.*S,%u)", len, suffix, len)
+
+   U_INTERNAL_ASSERT_POINTER(file)
+   U_INTERNAL_ASSERT_POINTER(file_data)
+
+   /**
+    * NB: if there is a precompressed version of the file (Ex: index.html.gz, index.html.br, index.html.zst) we use
+    * it instead of compressing the content at startup, but only if it is not older than the file and it is smaller...
+    */
+
+   UString result;
+   UFile sibling(file->getPath() + UString(suffix, len));
+
+   if (sibling.stat()                         &&
+       sibling.st_mtime >= file_data->mtime    &&
+       sibling.st_size  <  (off_t)file_data->size)
+      {
+      result = sibling.getContent(true, false);
+
+      if (result.empty()                                                             ||
+          (suffix[1] == 'g' && UStringExt::isGzip(result) == false) || // ".gz"
+          (suffix[1] == 'z' && UStringExt::isZstd(result) == false))   // ".zst"
+         {
+         U_SRV_LOG("WARNING: precompressed file not valid: %V", sibling.getPath().rep);
+
+         return UString::getStringNull();
+         }
+
+      UStringExt::ratio = (result.size() * 100U) / file_data->size;
+
+      U_SRV_LOG("Using precompressed file: %V - %u bytes", sibling.getPath().rep, result.size());
+      }
+
+   U_RETURN_STRING(result);
+}
+
+# ifdef U_STDCPP_ENABLE
+static UString getCompressHeader(const char* encoding, uint32_t encoding_len, const UString& header, uint32_t size)
+{
+   U_TRACE(0, "getCompressHeader(%.*S,%u,%V,%u)", encoding_len, encoding, encoding_len, header.rep, size)
+
+   // NB: the header of the content have the Content-Length of the content, we change it with the size of the compressed one...
+
+   UString result(U_CAPACITY);
+   uint32_t end, start = header.find("Content-Length: ", 0, U_CONSTANT_SIZE("Content-Length: "));
+
+   if (start == U_NOT_FOUND) result.snprintf(U_CONSTANT_TO_PARAM("%.*s%v"), encoding_len, encoding, header.rep);
+   else
+      {
+      start += U_CONSTANT_SIZE("Content-Length: ");
+
+      end = header.find('\r', start);
+
+      U_INTERNAL_ASSERT_DIFFERS(end, U_NOT_FOUND)
+
+      result.snprintf(U_CONSTANT_TO_PARAM("%.*s%.*s%u%.*s"), encoding_len, encoding, start, header.data(), size, header.size() - end, header.c_pointer(end));
+      }
+
+   U_RETURN_STRING(result);
+}
+
+U_NO_EXPORT bool UHTTP::compressDataFromStore(UStringRep* key, void* value)
+{
+   U_TRACE(0, "UHTTP::compressDataFromStore(%V,%p)", key, value)
+
+   U_INTERNAL_ASSERT_POINTER(value)
+
+   UFileCacheData* ptr = (UFileCacheData*)value;
+
+   // NB: the entries loaded from a store have mode 0 (see the copy ctor) and only content, header and gzip(content, header)...
+
+   if (ptr->mode  == 0         &&
+       ptr->link  == false     &&
+       ptr->array != U_NULLPTR &&
+       ptr->array->size() <= 4 &&
+       u_is_img(ptr->mime_index) == false)
+      {
+      // NB: we add the other compressed versions, with the precompressed siblings of the file if they exist (as putDataInCache() do)...
+
+      U_INTERNAL_ASSERT_MAJOR(ptr->array->size(), 1)
+
+      UString content = ptr->array->at(0),
+              header  = ptr->array->at(1), encoded, decoded;
+
+      file->setPath(UString(key));
+
+      file_data = ptr;
+
+#  ifdef USE_LIBZ
+      if (ptr->array->size() == 2)
+         {
+         encoded = getCompressedSibling(U_CONSTANT_TO_PARAM(".gz"));
+
+         if (encoded.empty()) encoded = UStringExt::deflate(content); // zopfli...
+
+         if (encoded)
+            {
+            ptr->array->push_back(encoded); // 2 gzip(content)
+
+            decoded = getCompressHeader(U_CONSTANT_TO_PARAM("Content-Encoding: gzip\r\n"), header, encoded.size());
+
+            setHeaderForCache(ptr, decoded); // 3 gzip(header)
+            }
+         }
+#  endif
+
+#  ifdef USE_LIBBROTLI
+      encoded = getCompressedSibling(U_CONSTANT_TO_PARAM(".br"));
+
+      if (encoded.empty()) encoded = UStringExt::brotli(content);
+
+      if (encoded)
+         {
+         checkArrayCompressData(ptr, 4);
+
+         ptr->array->push_back(encoded); // 4 brotli(content)
+
+         decoded = getCompressHeader(U_CONSTANT_TO_PARAM("Content-Encoding: br\r\n"), header, encoded.size());
+
+         setHeaderForCache(ptr, decoded); // 5 brotli(header)
+         }
+#  endif
+
+#  ifdef USE_LIBZSTD
+      encoded = getCompressedSibling(U_CONSTANT_TO_PARAM(".zst"));
+
+      if (encoded.empty()) encoded = UStringExt::zstd(content);
+
+      if (encoded)
+         {
+         checkArrayCompressData(ptr, 6);
+
+         ptr->array->push_back(encoded); // 6 zstd(content)
+
+         decoded = getCompressHeader(U_CONSTANT_TO_PARAM("Content-Encoding: zstd\r\n"), header, encoded.size());
+
+         setHeaderForCache(ptr, decoded); // 7 zstd(header)
+         }
 #  endif
+
+      file_data = U_NULLPTR;
       }
+
+   U_RETURN(true);
 }
+# endif
 #endif
 
 U_NO_EXPORT void UHTTP::putDataInCache(const UString& path, const UString& fmt, UString& content)
@@ -9040,9 +9685,9 @@ U_NO_EXPORT void UHTTP::putDataInCache(const UString& path, const UString& fmt,
    U_INTERNAL_ASSERT_MAJOR(file_data->size, 0)
    U_INTERNAL_ASSERT_EQUALS(file_data->mime_index, mime_index)
 
-   U_NEW(UVector<UString>, file_data->array, UVector<UString>(6U));
+   U_NEW(UVector<UString>, file_data->array, UVector<UString>(8U));
 #ifndef U_HTTP2_DISABLE
-   U_NEW(UVector<UString>, file_data->http2, UVector<UString>(3U));
+   U_NEW(UVector<UString>, file_data->http2, UVector<UString>(4U));
 #endif
 
    setDataInCache(fmt, content, U_NULLPTR, 0);
@@ -9057,7 +9702,7 @@ U_NO_EXPORT void UHTTP::putDataInCache(const UString& path, const UString& fmt,
    U_INTERNAL_ASSERT_EQUALS(file_data->size, content.size())
 
 #ifndef U_LOG_DISABLE
-   uint32_t ratio1 = 100, ratio2 = 100;
+   uint32_t ratio1 = 100, ratio2 = 100, ratio3 = 100;
 #endif
 
    if (u_is_img(mime_index))
@@ -9123,10 +9768,39 @@ U_NO_EXPORT void UHTTP::putDataInCache(const UString& path, const UString& fmt,
 #endif
 
 next:
-#if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
    if (u_is_compressable(mime_index) &&
        file_data->size > U_MIN_SIZE_FOR_DEFLATE)
       {
+      bool bfast = false;
+
+#  if defined(HAVE_SYS_INOTIFY_H) && defined(U_HTTP_INOTIFY_SUPPORT)
+#   ifdef ENABLE_THREAD
+      UCompressJob* job = U_NULLPTR;
+#   endif
+
+      if (inotify_compress_fast)
+         {
+         // NB: we are on the event loop, we compress with the levels for the dynamic content and a thread compress with the max levels...
+
+#     ifdef ENABLE_THREAD
+         if (compress_job &&
+             compress_job->content == content)
+            {
+            job = compress_job; // the content is not changed, we install the result of the thread
+            }
+         else
+#     endif
+            {
+            bfast = true;
+
+#        ifdef ENABLE_THREAD
+            addCompressJob(path, content);
+#        endif
+            }
+         }
+#  endif
+
 #  ifdef USE_LIBZ
       /**
        * http://zoompf.com/blog/2012/02/lose-the-wait-http-compression
@@ -9155,12 +9829,21 @@ next:
        * Sending raw DEFLATE data is just not a good idea. As Mark says "[it's] simply more reliable to only use GZIP"
        */
 
-      UString content1 = UStringExt::deflate(content); // zopfli...
+      UString content1 = getCompressedSibling(U_CONSTANT_TO_PARAM(".gz"));
+
+      if (content1.empty())
+         {
+#     if defined(HAVE_SYS_INOTIFY_H) && defined(U_HTTP_INOTIFY_SUPPORT) && defined(ENABLE_THREAD)
+         if (job) content1 = job->gzip;
+         else
+#     endif
+         content1 = UStringExt::deflate(content, (bfast ? gzip_level_for_dynamic_content : 0)); // 0 => zopfli...
+         }
 
       if (content1)
          {
 #     ifndef U_LOG_DISABLE
-         ratio1 = UStringExt::ratio;
+         ratio1 = (content1.size() * 100U) / content.size(); // NB: the content can come from the thread that compress in background...
 #     endif
 
          setDataInCache(fmt, content1, U_CONSTANT_TO_PARAM("Content-Encoding: gzip\r\n"));
@@ -9168,23 +9851,56 @@ next:
 #  endif
 
 #  ifdef USE_LIBBROTLI
-      UString content2 = UStringExt::brotli(content);
+      UString content2 = getCompressedSibling(U_CONSTANT_TO_PARAM(".br"));
+
+      if (content2.empty())
+         {
+#     if defined(HAVE_SYS_INOTIFY_H) && defined(U_HTTP_INOTIFY_SUPPORT) && defined(ENABLE_THREAD)
+         if (job) content2 = job->brotli;
+         else
+#     endif
+         content2 = UStringExt::brotli(content, (bfast ? brotli_level_for_dynamic_content : BROTLI_MAX_QUALITY));
+         }
 
       if (content2)
          {
 #     ifndef U_LOG_DISABLE
-         ratio2 = UStringExt::ratio;
+         ratio2 = (content2.size() * 100U) / content.size();
 #     endif
 
-         checkArrayCompressData(file_data);
+         checkArrayCompressData(file_data, 4);
 
          setDataInCache(fmt, content2, U_CONSTANT_TO_PARAM("Content-Encoding: br\r\n"));
          }
 #  endif
+
+#  ifdef USE_LIBZSTD
+      UString content3 = getCompressedSibling(U_CONSTANT_TO_PARAM(".zst"));
+
+      if (content3.empty())
+         {
+#     if defined(HAVE_SYS_INOTIFY_H) && defined(U_HTTP_INOTIFY_SUPPORT) && defined(ENABLE_THREAD)
+         if (job) content3 = job->zstd;
+         else
+#     endif
+         content3 = UStringExt::zstd(content, (bfast ? 3 : 19)); // 3 => the default level of zstd
+         }
+
+      if (content3)
+         {
+#     ifndef U_LOG_DISABLE
+         ratio3 = (content3.size() * 100U) / content.size();
+#     endif
+
+         checkArrayCompressData(file_data, 6);
+
+         setDataInCache(fmt, content3, U_CONSTANT_TO_PARAM("Content-Encoding: zstd\r\n"));
+         }
+#  endif
       }
 #endif
 
-   U_SRV_LOG("File cached: %V - %u bytes - compression ratio (%s %u%%, brotli %u%%)", path.rep, file_data->size, UStringExt::deflate_agent, 100-ratio1, 100-ratio2);
+   U_SRV_LOG("File cached: %V - %u bytes - compression ratio (%s %u%%, brotli %u%%, zstd %u%%)", path.rep, file_data->size, UStringExt::deflate_agent, 100-ratio1, 100-ratio2, 100-ratio3);
 }
 
 void UHTTP::checkFileForCache(const UString& path)
@@ -9752,7 +10468,7 @@ U_NO_EXPORT void UHTTP::processDataFromCache()
 
    U_ASSERT(isDataFromCache())
 
-   U_INTERNAL_DUMP("U_http_is_accept_gzip = %b U_http_is_accept_brotli = %b", U_http_is_accept_gzip, U_http_is_accept_brotli)
+   U_INTERNAL_DUMP("U_http_is_accept_gzip = %b U_http_is_accept_brotli = %b U_http_is_accept_zstd = %b", U_http_is_accept_gzip, U_http_is_accept_brotli, U_http_is_accept_zstd)
 
 #ifdef USE_LIBBROTLI
    if (U_http_is_accept_brotli &&
@@ -9768,6 +10484,20 @@ U_NO_EXPORT void UHTTP::processDataFromCache()
       }
 #endif
 
+#ifdef USE_LIBZSTD
+   if (U_http_is_accept_zstd &&
+       (*ext = getHeaderCompressZstdFromCache()))
+      {
+#  ifndef U_CACHE_REQUEST_DISABLE
+      is_response_compressed = 3; // zstd
+#  endif
+
+      *UClientImage_Base::body = getBodyCompressZstdFromCache();
+
+      return;
+      }
+#endif
+
 #ifdef USE_LIBZ
    if (U_http_is_accept_gzip &&
        (*ext = getHeaderCompressFromCache()))
@@ -12506,6 +13236,8 @@ next:    if (*ptr1 == '?')
 
          usp->runDynamicPage();
 
+         UValue::endRequestArena();
+
          if (U_ClientImage_parallelization < U_PARALLELIZATION_PARENT)
             {
             U_INTERNAL_DUMP("U_http_usp_flag = %u UClientImage_Base::wbuffer(%u) = %V", U_http_usp_flag, UClientImage_Base::wbuffer->size(), UClientImage_Base::wbuffer->rep)
@@ -12686,9 +13418,9 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
 
             if (vec.empty() == false)
                {
-               U_NEW(UVector<UString>, d.array, UVector<UString>(6U));
+               U_NEW(UVector<UString>, d.array, UVector<UString>(8U));
 #           ifndef U_HTTP2_DISABLE
-               U_NEW(UVector<UString>, d.http2, UVector<UString>(3U));
+               U_NEW(UVector<UString>, d.http2, UVector<UString>(4U));
 #           endif
 
                UString encoded, decoded;
@@ -12719,10 +13451,6 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
 
                d.array->push_back(decoded);
 
-#           if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
-               UString content = decoded;
-#           endif
-
                // header
 
                encoded = vec[1];
@@ -12732,10 +13460,6 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
 
                UHTTP::setHeaderForCache(&d, decoded);
 
-#           if defined(USE_LIBZ) || defined(USE_LIBBROTLI)
-               UString header = decoded;
-#           endif
-
                encoded = vec[2];
 
                if (encoded)
@@ -12757,29 +13481,8 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
 
                   UHTTP::setHeaderForCache(&d, decoded);
                   }
-#           ifdef USE_LIBZ
-               else if (u_is_img(d.mime_index) == false)
-                  {
-                  d.array->push_back(UStringExt::deflate(content)); // 2 gzip(content) 
-
-                  decoded = U_STRING_FROM_CONSTANT("Content-Encoding: gzip\r\n") + header;
-
-                  UHTTP::setHeaderForCache(&d, decoded); // 3 gzip(header)
-                  }
-#           endif
 
-#           ifdef USE_LIBBROTLI
-               if (u_is_img(d.mime_index) == false)
-                  {
-                  UHTTP::checkArrayCompressData(&d);
-
-                  d.array->push_back(UStringExt::brotli(content)); // 4 brotli(content)
-
-                  decoded = U_STRING_FROM_CONSTANT("Content-Encoding: br\r\n") + header;
-
-                  UHTTP::setHeaderForCache(&d, decoded); // 5 brotli(header)
-                  }
-#           endif
+               // NB: the other compressed versions are set by UHTTP::compressDataFromStore() because we need the key (path) for the precompressed siblings...
 
                U_ASSERT(d.array->check_memory())
                }
@@ -12817,7 +13520,7 @@ U_EXPORT ostream& operator<<(ostream& os, const UHTTP::UFileCacheData& d)
       os.put(' ');
       os.put('(');
 
-      if (d.array && // content, header, gzip(content, header)
+      if (d.array && // content, header, gzip(content, header) (NB: brotli and zstd are computed again at load...)
           d.size < (64 * 1024))
          {
          U_INTERNAL_ASSERT_EQUALS(d.ptr, U_NULLPTR)
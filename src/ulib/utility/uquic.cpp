@@ -28,6 +28,10 @@ quiche_config*          UQuic::qconfig;
 struct sockaddr_storage       UQuic::peer_addr;
 UHashMap<UClientImage_Base*>* UQuic::peers;
 
+uint8_t                 UQuic::out[U_UDP_MAX_SEGMENT * U_MAX_DATAGRAM_SIZE];
+uint32_t                UQuic::max_payload_size = U_MAX_DATAGRAM_SIZE;
+uint32_t                UQuic::vsize[U_UDP_MAX_SEGMENT];
+
 int UQuic::loadConfigParam()
 {
    U_TRACE_NO_PARAM(0, "UQuic::loadConfigParam()")
@@ -111,6 +115,8 @@ int UQuic::loadConfigParam()
          U_SYSCALL_VOID(quiche_config_set_max_packet_size, "%p,%lu", qconfig, param0);
 #     endif
 
+         max_payload_size = U_min(param0, U_UDP_MAX_GSO_SIZE);
+
          param0 = UServer_Base::pcfg->readLong(U_CONSTANT_TO_PARAM("QUICHE_INITIAL_MAX_DATA"), 10485760);
 
          U_SYSCALL_VOID(quiche_config_set_initial_max_data, "%p,%lu", qconfig, param0);
@@ -161,6 +167,96 @@ int UQuic::loadConfigParam()
    U_RETURN(U_PLUGIN_HANDLER_OK);
 }
 
+// Batched UDP I/O (see UUDPBatch): the packets that quiche produces for a connection in one pass of the send loop are sent together by flush()
+
+void UQuic::initSocket()
+{
+   U_TRACE_NO_PARAM(0, "UQuic::initSocket()")
+
+   U_INTERNAL_ASSERT(UServer_Base::budp)
+   U_INTERNAL_ASSERT_POINTER(UServer_Base::socket)
+
+   USocket* sk = UServer_Base::socket;
+
+   // NB: GRO only if the read buffer (where io_uring read with recvmsg()) can contain a super datagram of 64k, otherwise the data is truncated...
+
+   UUDPBatch::init(sk->iSockDesc, (UServer_Base::rbuffer_size >= U_UDP_BATCH_SIZE));
+
+#if defined(U_LINUX) && (!defined(U_SERVER_CAPTIVE_PORTAL) || defined(ENABLE_THREAD)) && !defined(HAVE_OLD_IOSTREAM)
+   if (USocket::breuseport &&
+       UServer_Base::preforked_num_kids > 1)
+      {
+      // NB: the filter replace the one (cpu based) attached by USocket::reusePort() and it is shared by the SO_REUSEPORT group...
+
+      if (sk->enable_bpf_quic(UServer_Base::preforked_num_kids) == false) U_WARNING("SO_ATTACH_REUSEPORT_CBPF (QUIC connection ID steering) failed, port %u", sk->iLocalPort);
+      }
+#endif
+
+   U_INTERNAL_DUMP("max_payload_size = %u", max_payload_size)
+
+   U_SRV_LOG("QUIC socket: batch of %u datagrams, GRO %s, GSO %s", U_UDP_BATCH, UUDPBatch::bgro ? "on" : "off", UUDPBatch::bgso ? "on" : "off");
+}
+
+uint32_t UQuic::nextDatagram()
+{
+   U_TRACE_NO_PARAM(0, "UQuic::nextDatagram()")
+
+   uint32_t sz = UUDPBatch::next(UServer_Base::rbuffer->data(), UServer_Base::rbuffer_size, &peer_addr, &peer_addr_len);
+
+   if (sz) UServer_Base::rbuffer->size_adjust_force(sz);
+
+   U_RETURN(sz);
+}
+
+bool UQuic::flush(quiche_conn* lconn)
+{
+   U_TRACE(0, "UQuic::flush(%p)", lconn)
+
+   U_INTERNAL_ASSERT_POINTER(lconn)
+   U_INTERNAL_ASSERT_MINOR(max_payload_size, sizeof(out))
+
+   ssize_t written;
+   uint32_t n = 0, start = 0;
+
+   while (true)
+      {
+      if (n == U_UDP_MAX_SEGMENT ||
+          (sizeof(out) - start) < max_payload_size)
+         {
+         if (sendPackets(n) == false) U_RETURN(false);
+
+         n = start = 0;
+         }
+
+      written = U_SYSCALL(quiche_conn_send, "%p,%p,%u", lconn, out + start, max_payload_size);
+
+      if (written == QUICHE_ERR_DONE)
+         {
+         U_DEBUG("quiche: done writing")
+
+         break;
+         }
+
+      if (written < 0)
+         {
+         U_DEBUG("UQuic::flush(): failed to create packet: %d", written)
+
+         break;
+         }
+
+      vsize[n++] = written;
+      start     += written;
+      }
+
+   if (n &&
+       sendPackets(n) == false)
+      {
+      U_RETURN(false);
+      }
+
+   U_RETURN(true);
+}
+
 bool UQuic::parseHeader()
 {
    U_TRACE_NO_PARAM(0, "UQuic::parseHeader()")
@@ -197,64 +293,22 @@ bool UQuic::handlerRead(quiche_conn* lconn, bool bwait_for_data)
    int iBytesRead;
    char* ptr = UServer_Base::rbuffer->data();
 
-   // Read incoming UDP packets from the socket and feed them to quiche, until there are no more packets to read
+   // Read incoming UDP packets from the socket (a batch at a time) and feed them to quiche, until there are no more packets to read
 
 loop:
-   peer_addr_len = sizeof(peer_addr);
-
-   (void) U_SYSCALL(memset, "%p,%u,%u", &peer_addr, 0, U_SIZE_SOCKADDR);
-
-   iBytesRead = U_SYSCALL(recvfrom, "%d,%p,%u,%u,%p,%p", UServer_Base::fds[0], ptr, UServer_Base::rbuffer_size, (bwait_for_data ? 0 : MSG_DONTWAIT),
-                                                         (struct sockaddr*)&peer_addr, &peer_addr_len);
-
-   if (iBytesRead <= 0)
+   if ((iBytesRead = nextDatagram()) == 0)
       {
+      if (UUDPBatch::read(UServer_Base::fds[0], bwait_for_data) > 0) goto loop;
+
       if (errno == EAGAIN)
          {
-         U_DEBUG("quiche: recvfrom would block")
+         U_DEBUG("quiche: recvmmsg would block")
 
          U_INTERNAL_ASSERT_EQUALS(bwait_for_data, false)
 
          if (lconn) // reported no read packets, we will then proceed with the send loop
             {
-            uint8_t out[65536];
-            ssize_t written, sent;
-            uint32_t start = 0, remain = sizeof(out);
-
-            while (true)
-               {
-               written = U_SYSCALL(quiche_conn_send, "%p,%p,%u", lconn, &out[start], remain);
-
-               if (written == QUICHE_ERR_DONE)
-                  {
-                  U_DEBUG("quiche: done writing")
-
-                  break;
-                  }
-
-               if (written < 0)
-                  {
-                  U_DEBUG("UQuic::handlerRead(): failed to create packet: %d", written)
-
-                  break;
-                  }
-
-               start  += written;
-               remain -= written;
-
-               U_INTERNAL_ASSERT_MINOR(start, sizeof(out))
-
-               U_DEBUG("quiche: sent %u bytes", written)
-               }
-
-            sent = U_SYSCALL(sendto, "%d,%p,%u,%u,%p,%d", UServer_Base::fds[0], out, start, 0, (struct sockaddr*)&USocket::peer_addr, USocket::peer_addr_len);
-
-            if (sent != start)
-               {
-               U_DEBUG("UQuic::handlerRead(): failed to send")
-
-               U_RETURN(false);
-               }
+            if (flush(lconn) == false) U_RETURN(false);
 
             if (U_SYSCALL(quiche_conn_is_closed, "%p", lconn))
                {
@@ -275,7 +329,7 @@ loop:
          goto loop;
          }
 
-      U_WARNING("recvfrom on fd %d got %d%R", UServer_Base::fds[0], iBytesRead, 0); // NB: the last argument (0) is necessary...
+      U_WARNING("recvmmsg on fd %d failed%R", UServer_Base::fds[0], 0); // NB: the last argument (0) is necessary...
 
       if (errno == EINTR) UInterrupt::checkForEventSignalPending();
 
@@ -286,13 +340,11 @@ loop:
 
    U_INTERNAL_ASSERT_MAJOR(peer_addr_len, 0)
 
-   UServer_Base::rbuffer->size_adjust_force(iBytesRead);
-
    if (memcmp(&peer_addr, &USocket::peer_addr, peer_addr_len) != 0)
       {
       // TODO
 
-      U_WARNING("recvfrom() different address");
+      U_WARNING("recvmmsg() different address");
 
       /* Lookup a connection based on the packet's connection ID. If there is no connection matching, create a new one
 
@@ -317,7 +369,7 @@ bool UQuic::handlerNewConnection()
    const char* ptr;
    ssize_t written, sent;
    const char* pkt = "vneg";
-   uint8_t out[U_MAX_DATAGRAM_SIZE];
+   uint8_t out[U_MAX_DATAGRAM_SIZE], cid[U_LOCAL_CONN_ID_LEN];
 
    conn = U_NULLPTR;
 
@@ -389,14 +441,22 @@ pkt:  if (written < 0)
 
       token_len = 6 + USocket::peer_addr_len + conn_id_len;
 
-      U_INTERNAL_DUMP("scid(%u) = %.*S conn_id(%u) = %.*S token(%u) = %.*S pkt_version = %p",
-                      scid_len, scid_len, scid, conn_id_len, conn_id_len, conn_id, token_len, token_len, token, pkt_version)
+      // Generate the connection ID that the client will use from now on. The first byte is the same of the destination connection ID
+      // chosen by the client, so the connection ID steering of the SO_REUSEPORT group (see USocket::enable_bpf_quic()) keeps all the
+      // packets of the connection on the socket of this process, the other bytes are random
+
+      cid[0] = conn_id[0];
+
+      for (uint32_t i = 1; i < U_LOCAL_CONN_ID_LEN; ++i) cid[i] = (uint8_t)u_get_num_random();
+
+      U_INTERNAL_DUMP("scid(%u) = %.*S conn_id(%u) = %.*S cid(%u) = %.*S token(%u) = %.*S pkt_version = %p",
+                      scid_len, scid_len, scid, conn_id_len, conn_id_len, conn_id, U_LOCAL_CONN_ID_LEN, U_LOCAL_CONN_ID_LEN, cid, token_len, token_len, token, pkt_version)
 
       // Writes a retry packet
 #  ifdef LIBQUICHE_AT_LEAST_0_5
-      written = U_SYSCALL(quiche_retry, "%p,%u,%p,%u,%p,%u,%p,%u,%u,%p,%u", scid, scid_len, conn_id, conn_id_len, conn_id, conn_id_len, token, token_len, pkt_version, out, sizeof(out));
+      written = U_SYSCALL(quiche_retry, "%p,%u,%p,%u,%p,%u,%p,%u,%u,%p,%u", scid, scid_len, conn_id, conn_id_len, cid, U_LOCAL_CONN_ID_LEN, token, token_len, pkt_version, out, sizeof(out));
 #  else
-      written = U_SYSCALL(quiche_retry, "%p,%u,%p,%u,%p,%u,%p,%u,   %p,%u", scid, scid_len, conn_id, conn_id_len, conn_id, conn_id_len, token, token_len,              out, sizeof(out));
+      written = U_SYSCALL(quiche_retry, "%p,%u,%p,%u,%p,%u,%p,%u,   %p,%u", scid, scid_len, conn_id, conn_id_len, cid, U_LOCAL_CONN_ID_LEN, token, token_len,              out, sizeof(out));
 #  endif
 
       pkt = "retry";
@@ -428,14 +488,18 @@ pkt:  if (written < 0)
    ptr       += USocket::peer_addr_len;
    token_len -= USocket::peer_addr_len;
 
-   if (conn_id_len != token_len) // The token was not valid, meaning the retry failed, so drop the packet
+   // The rest of the token is the original destination connection ID. If it is not valid the retry failed, so drop the packet
+
+   if (token_len == 0 ||
+       token_len > QUICHE_MAX_CONN_ID_LEN ||
+       conn_id_len != U_LOCAL_CONN_ID_LEN)
       {
       U_DEBUG("UQuic::handlerNewConnection(): invalid address validation token")
 
       U_RETURN(false);
       }
 
-   // Reuse the source connection ID we sent in the Retry packet, instead of changing it again. Creates a new server-side connection
+   // Reuse the source connection ID we sent in the Retry packet (it is the destination connection ID of this packet), instead of changing it again. Creates a new server-side connection
    conn = (quiche_conn*) U_SYSCALL(quiche_accept, "%p,%u,%p,%u,%p", conn_id, conn_id_len, (const uint8_t*)ptr, token_len, qconfig);
 
    if (conn == U_NULLPTR)
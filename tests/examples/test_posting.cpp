@@ -0,0 +1,263 @@
+// test_posting.cpp
+
+// NB: the block codec and the intersection of the postings are static in posting.cpp, so we include it...
+
+#include "../../examples/IR/posting.cpp"
+
+UCDB* cdb_names;
+UCDB* cdb_words;
+UCDB* cdb_stats;
+UCDB* cdb_delta_names;
+UCDB* cdb_delta_words;
+UCDB* cdb_delta_stats;
+
+static uint64_t seed = 88172645463325252ULL;
+
+static inline uint64_t next_random() // xorshift
+{
+   seed ^= seed << 13;
+   seed ^= seed >>  7;
+   seed ^= seed << 17;
+
+   return seed;
+}
+
+// scalar reference of the intersection of two sorted vector of DOC id
+
+static uint32_t u_intersect_scalar(const uint64_t* a, uint32_t na, const uint64_t* b, uint32_t nb, uint64_t* out)
+{
+   uint32_t i = 0, j = 0, k = 0;
+
+   while (i < na &&
+          j < nb)
+      {
+           if (a[i] < b[j]) ++i;
+      else if (a[i] > b[j]) ++j;
+      else
+         {
+         out[k++] = a[i];
+
+         ++i;
+         ++j;
+         }
+      }
+
+   return k;
+}
+
+// sorted vector of n distinct DOC id, every one with probability 1/density on the range
+
+static uint32_t u_random_doc_id(uint64_t* vdoc, uint32_t n, uint32_t density)
+{
+   uint64_t doc_id = 1;
+
+   for (uint32_t i = 0; i < n; ++i) vdoc[i] = (doc_id += 1 + (next_random() % density));
+
+   return n;
+}
+
+// NB: UPosting is friend of a class named Application...
+
+class Application {
+public:
+
+   // the posting in memory of the DOC id of vdoc: the DOC id i has (i % 5) + 1 positions, with also a jump back to check the modular delta
+
+   static UString build(const uint64_t* vdoc, uint32_t n, bool reverse)
+      {
+      U_TRACE(5, "Application::build(%p,%u,%b)", vdoc, n, reverse)
+
+      UString s(sizeof(uint32_t) + (n * (sizeof(UPosting::u_posting) + (5 * sizeof(uint32_t)))));
+
+      char* start = s.data();
+      char* q     = start + sizeof(uint32_t);
+      uint32_t i, k, freq, last = 0;
+
+      for (i = 0; i < n; ++i)
+         {
+         uint64_t doc_id = vdoc[reverse ? n-1-i : i];
+
+         freq = (uint32_t)(doc_id % 5) + 1;
+
+         u_put_unalignedp64(&(((UPosting::u_posting*)(q))->doc_id),    doc_id);
+         u_put_unalignedp32(&(((UPosting::u_posting*)(q))->word_freq), freq);
+
+         for (k = 0; k < freq; ++k) u_put_unalignedp32(q+sizeof(UPosting::u_posting)+(k*sizeof(uint32_t)), (k == 3 ? 1 : (uint32_t)(doc_id % 7) + (k * 300)));
+
+         last = q - start;
+
+         q += POSTING_SIZE(q);
+         }
+
+      u_put_unalignedp32(start, last);
+
+      s.size_adjust(q - start);
+
+      U_RETURN_STRING(s);
+      }
+
+   // encode: the blocks and the skip table, decode: the posting in memory sorted by DOC id
+
+   static void testCodec(uint64_t* vdoc, uint32_t n)
+      {
+      U_TRACE(5, "Application::testCodec(%p,%u)", vdoc, n)
+
+      u_posting_cursor c;
+      uint32_t b, i, last;
+
+      *UPosting::posting = build(vdoc, n, true);
+
+      UPosting::encode();
+
+      U_INTERNAL_ASSERT(UPosting::isBlock())
+      U_INTERNAL_ASSERT_EQUALS(u_get_unalignedp32(UPosting::posting->data()), U_POSTING_FLAG | n)
+
+      u_open_cursor(&c, UPosting::posting->data());
+
+      U_INTERNAL_ASSERT_EQUALS(c.ndoc, n)
+      U_INTERNAL_ASSERT_EQUALS(c.nblock, (n + U_POSTING_BLOCK - 1) / U_POSTING_BLOCK)
+      U_INTERNAL_ASSERT_EQUALS(c.skip == U_NULLPTR, c.nblock == 1)
+
+      for (b = 0; b < c.nblock; ++b)
+         {
+         if (b) u_load_block(&c, b);
+
+         last = U_min(n, (b + 1) * U_POSTING_BLOCK) - 1;
+
+         U_INTERNAL_ASSERT_EQUALS(c.n, last + 1 - (b * U_POSTING_BLOCK))
+
+         if (c.skip) U_INTERNAL_ASSERT_EQUALS(U_SKIP_LAST(&c, b), vdoc[last])
+
+         for (i = 0; i < c.n; ++i)
+            {
+            U_INTERNAL_ASSERT_EQUALS(c.vdoc[i],  vdoc[(b * U_POSTING_BLOCK) + i])
+            U_INTERNAL_ASSERT_EQUALS(c.vfreq[i], (uint32_t)(c.vdoc[i] % 5) + 1)
+            }
+         }
+
+      // the seek on the skip table (galloping) and in the block
+
+      u_open_cursor(&c, UPosting::posting->data());
+
+      for (i = 0; i < n; i += 7)
+         {
+         U_INTERNAL_ASSERT(u_seek(&c, vdoc[i]))
+         U_INTERNAL_ASSERT_EQUALS(c.iblock, i / U_POSTING_BLOCK)
+         U_INTERNAL_ASSERT_EQUALS(c.idoc,   i % U_POSTING_BLOCK)
+
+         if ((vdoc[i] + 1) < vdoc[i+1 < n ? i+1 : i]) U_INTERNAL_ASSERT_EQUALS(u_seek(&c, vdoc[i] + 1), false)
+         }
+
+      U_INTERNAL_ASSERT_EQUALS(u_seek(&c, vdoc[n-1] + 1), false)
+
+      UPosting::decode();
+
+      U_INTERNAL_ASSERT_EQUALS(UPosting::isBlock(), false)
+      U_INTERNAL_ASSERT_EQUALS(*UPosting::posting, build(vdoc, n, false))
+      }
+
+   // the intersection of the SIMD path (with the scalar tail) against the scalar reference
+
+   static void testIntersectBlock(uint32_t na, uint32_t nb, uint32_t density)
+      {
+      U_TRACE(5, "Application::testIntersectBlock(%u,%u,%u)", na, nb, density)
+
+      uint64_t a[300], b[300], out[300], ref[300];
+
+      U_INTERNAL_ASSERT(na <= U_NUM_ELEMENTS(a))
+      U_INTERNAL_ASSERT(nb <= U_NUM_ELEMENTS(b))
+
+      (void) u_random_doc_id(a, na, density);
+      (void) u_random_doc_id(b, nb, density);
+
+      uint32_t k = u_intersect_block(a, na, b, nb, out);
+
+      U_INTERNAL_ASSERT_EQUALS(k, u_intersect_scalar(a, na, b, nb, ref))
+      U_INTERNAL_ASSERT_EQUALS(memcmp(out, ref, k * sizeof(uint64_t)), 0)
+
+      // with itself
+
+      U_INTERNAL_ASSERT_EQUALS(u_intersect_block(a, na, a, na, out), na)
+      U_INTERNAL_ASSERT_EQUALS(memcmp(out, a, na * sizeof(uint64_t)), 0)
+      }
+
+   // the intersection of a vector of DOC id with a posting: galloping (sparse) and SIMD on the block (dense), across the block boundaries
+
+   static void testIntersect(uint64_t* vdoc, uint32_t n, uint32_t step)
+      {
+      U_TRACE(5, "Application::testIntersect(%p,%u,%u)", vdoc, n, step)
+
+      u_posting_cursor c;
+      uint64_t cand[2048], ref[2048];
+      uint32_t i, k, ncand = 0;
+
+      *UPosting::posting = build(vdoc, n, false);
+
+      UPosting::encode();
+
+      u_open_cursor(&c, UPosting::posting->data());
+
+      // the candidates: the DOC id of the posting every step, each one with a missing DOC id after it
+
+      for (i = 0; i < n && ncand < (U_NUM_ELEMENTS(cand) - 1); i += step)
+         {
+         cand[ncand++] = vdoc[i];
+
+         if ((vdoc[i] + 1) < vdoc[i+1 < n ? i+1 : i]) cand[ncand++] = vdoc[i] + 1;
+         }
+
+      k = u_intersect_scalar(cand, ncand, vdoc, n, ref);
+
+      U_INTERNAL_ASSERT_EQUALS(u_intersect(cand, ncand, &c), k)
+      U_INTERNAL_ASSERT_EQUALS(memcmp(cand, ref, k * sizeof(uint64_t)), 0)
+      }
+};
+
+int
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   UPosting* p;
+   uint32_t i, j;
+   uint64_t vdoc[1000];
+
+   U_NEW(UPosting, p, UPosting(0, false, false));
+
+   // the block boundaries, and DOC id with varint of more bytes
+
+   static const uint32_t vn[] = { 1, 2, 127, 128, 129, 256, 257, 1000 };
+
+   for (i = 0; i < U_NUM_ELEMENTS(vn); ++i)
+      {
+      Application::testCodec(vdoc, u_random_doc_id(vdoc, vn[i], 3));
+
+      for (j = 0; j < vn[i]; ++j) vdoc[j] <<= 33;
+
+      Application::testCodec(vdoc, vn[i]);
+      }
+
+   // the SIMD intersection: even and odd length (the scalar tail), dense and sparse
+
+   for (i = 0; i < 300; i += 37)
+      {
+      for (j = 0; j < 300; j += 41)
+         {
+         Application::testIntersectBlock(i,   j,   2);
+         Application::testIntersectBlock(i+1, j,   4);
+         Application::testIntersectBlock(i,   j+1, 64);
+         }
+      }
+
+   // dense (>= 8 candidates in the block) and sparse candidates
+
+   (void) u_random_doc_id(vdoc, 1000, 3);
+
+   static const uint32_t vstep[] = { 1, 2, 5, 16, 50, 200, 999 };
+
+   for (i = 0; i < U_NUM_ELEMENTS(vstep); ++i) Application::testIntersect(vdoc, 1000, vstep[i]);
+
+   U_DELETE(p)
+}
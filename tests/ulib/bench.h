@@ -0,0 +1,40 @@
+// bench.h
+
+// Support shared by all the eval_* programs (like test_bison.h and json_obj.h it is not part of a single program):
+// timing with the monotonic clock and generation of the keys.
+
+#ifndef __BENCH_HDR
+#define __BENCH_HDR
+
+#include <ulib/string.h>
+
+#include <time.h>
+
+// return the monotonic clock in ns
+
+static inline uint64_t bench_clock(void)
+{
+   struct timespec t;
+
+   (void) clock_gettime(CLOCK_MONOTONIC, &t);
+
+   return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+// return the ns elapsed from start (a value of bench_clock())
+
+static inline double bench_elapsed(uint64_t start) { return (double)(bench_clock() - start); }
+
+// fill vkey with "key_%u" and vmiss with "miss%u": a key with the same length that is not present...
+
+static inline void bench_keys(UString* vkey, UString* vmiss, uint32_t n)
+{
+   char buffer[32];
+
+   for (uint32_t i = 0; i < n; ++i)
+      {
+                 vkey[i]  = UString((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("key_%u"), i));
+      if (vmiss) vmiss[i] = UString((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("miss%u"), i));
+      }
+}
+#endif
@@ -0,0 +1,128 @@
+/**
+ * eval_cache.cpp
+ *
+ * Testing UCache vs UShardCache: throughput of get/add shared by N forked workers (like the preforked children of the server)...
+ */
+
+#include <ulib/cache.h>
+#include <ulib/process.h>
+
+#include "bench.h"
+
+#define KEYS 10000U
+
+static UString* vkey;
+
+// NB: a worker do 90% of get and 10% of add (a miss is followed by an add like a real cache)...
+
+static void worker(UCache* cache, ULock* lock, UShardCache* scache, uint32_t nop)
+{
+   UString key, data;
+
+   for (uint32_t i = 0; i < nop; ++i)
+      {
+      key = vkey[u_get_num_random_range1(KEYS)];
+
+      if (scache)
+         {
+         data = scache->get(key);
+
+         if (data.empty() || (i % 10) == 0) scache->add(key, key);
+
+         continue;
+         }
+
+      lock->lock();
+
+      data = cache->get(U_STRING_TO_PARAM(key));
+
+      if (data.empty() || (i % 10) == 0) cache->add(key, key);
+
+      lock->unlock();
+      }
+}
+
+static sem_t* psem; // NB: the lock of the single cache, in shared memory like the one of the server...
+
+static double bench(uint32_t nworker, uint32_t nop, bool bshard)
+{
+   UCache cache;
+   ULock lock;
+   UShardCache scache;
+   uint64_t start;
+
+   if (bshard) (void) scache.open(U_STRING_FROM_CONSTANT("/tmp/eval_cache.shard"), 4 * U_1M, nworker * 2, U_NULLPTR, true);
+   else
+      {
+      (void) cache.open(U_STRING_FROM_CONSTANT("/tmp/eval_cache.cache"), 4 * U_1M, U_NULLPTR, true);
+
+      lock.init(psem);
+      }
+
+   UProcess* proc = new UProcess[nworker];
+
+   start = bench_clock();
+
+   for (uint32_t i = 0; i < nworker; ++i)
+      {
+      if (proc[i].fork() &&
+          proc[i].child())
+         {
+         worker(&cache, &lock, (bshard ? &scache : U_NULLPTR), nop);
+
+         ::_exit(0);
+         }
+      }
+
+   for (uint32_t i = 0; i < nworker; ++i) (void) UProcess::waitpid(proc[i].pid(), U_NULLPTR, 0);
+
+   double t = bench_elapsed(start) / (nworker * nop);
+
+   if (bshard)
+      {
+      UShardCache::cache_shard_stats total;
+
+      scache.getStats(total);
+
+      printf("shard  workers = %2u %6.1f ns/op (shards = %3u hits = %llu misses = %llu evictions = %llu)\n",
+             nworker, t, scache.getNumShard(), (unsigned long long)total.hits, (unsigned long long)total.misses, (unsigned long long)total.evictions);
+      }
+   else
+      {
+      printf("single workers = %2u %6.1f ns/op\n", nworker, t);
+      }
+
+   delete[] proc;
+
+   return t;
+}
+
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   printf("=> Testing cache...\n");
+
+   uint32_t shm_size = sizeof(sem_t);
+
+   psem = (sem_t*) UFile::mmap(&shm_size);
+   vkey = new UString[KEYS];
+
+   bench_keys(vkey, U_NULLPTR, KEYS);
+
+   static const uint32_t vn[] = { 1, 2, 4, 8, 16 };
+
+   uint32_t nop = (argc > 1 ? u_atoi(argv[1]) : 100000);
+
+   for (uint32_t i = 0; i < U_NUM_ELEMENTS(vn); ++i)
+      {
+      (void) bench(vn[i], nop, false);
+      (void) bench(vn[i], nop, true);
+      }
+
+   UFile::munmap(psem, shm_size);
+
+   delete[] vkey;
+}
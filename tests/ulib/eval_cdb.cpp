@@ -0,0 +1,88 @@
+/**
+ * eval_cdb.cpp
+ *
+ * Testing UCDB: lookup throughput of the classic format vs the cdb64 format (64-bit offsets, xxh3 hashing)...
+ */
+
+#include <ulib/db/cdb.h>
+
+#include "bench.h"
+
+static double lookup(UCDB& cdb, UString* vkey, uint32_t n, uint32_t& found)
+{
+   uint64_t start;
+
+   start = bench_clock();
+
+   for (uint32_t i = 0; i < n; ++i) if (cdb.find(vkey[i])) ++found;
+
+   return bench_elapsed(start) / n;
+}
+
+static void bench(UString* vkey, UString* vmiss, uint32_t n)
+{
+   uint32_t i, found = 0, tbl_space = 0;
+   UHashMap<void*> table(u_nextPowerOfTwo(n));
+   double t_hit32, t_miss32, t_hit64, t_miss64;
+
+   for (i = 0; i < n; ++i)
+      {
+      table.insert(vkey[i], vkey[i].rep); // NB: the data is the key...
+
+      tbl_space += vkey[i].size() * 2;
+      }
+
+   UString path32 = U_STRING_FROM_CONSTANT("/tmp/eval_cdb.cdb"),
+           path64 = U_STRING_FROM_CONSTANT("/tmp/eval_cdb64.cdb");
+
+   if (UCDB::writeTo(path32, &table, tbl_space) == false) U_ERROR("cannot write %V", path32.rep);
+
+   UCDB cdb32(path32, false),
+        cdb64(path64, false);
+
+   if (cdb32.open()                 == false ||
+       cdb32.copyTo(path64, true)   == false ||
+       cdb64.open()                 == false)
+      {
+      U_ERROR("cannot convert %V", path32.rep);
+      }
+
+   U_INTERNAL_ASSERT(cdb64.isCdb64())
+
+   t_hit32  = lookup(cdb32, vkey,  n, found);
+   t_miss32 = lookup(cdb32, vmiss, n, found);
+   t_hit64  = lookup(cdb64, vkey,  n, found);
+   t_miss64 = lookup(cdb64, vmiss, n, found);
+
+   U_INTERNAL_ASSERT_EQUALS(found, n * 2)
+
+   printf("n = %7u classic: hit = %6.1f miss = %6.1f ns/op (size %9u) cdb64: hit = %6.1f miss = %6.1f ns/op (size %9u) (found = %u)\n",
+          n, t_hit32, t_miss32, (uint32_t)cdb32.UFile::st_size, t_hit64, t_miss64, (uint32_t)cdb64.UFile::st_size, found);
+
+   cdb32.UFile::munmap();
+   cdb64.UFile::munmap();
+
+   (void) UFile::_unlink(path32.data());
+   (void) UFile::_unlink(path64.data());
+}
+
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   printf("=> Testing cdb lookup...\n");
+
+   static const uint32_t vn[] = { 1000, 100000, 1000000 };
+
+   UString* vkey  = new UString[1000000];
+   UString* vmiss = new UString[1000000];
+
+   bench_keys(vkey, vmiss, 1000000);
+
+   for (uint32_t i = 0; i < U_NUM_ELEMENTS(vn); ++i) bench(vkey, vmiss, vn[i]);
+
+   delete[] vkey;
+   delete[] vmiss;
+}
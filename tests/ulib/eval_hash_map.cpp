@@ -0,0 +1,80 @@
+/**
+ * eval_hash_map.cpp
+ *
+ * Testing UHashMap: insert/lookup/erase (build the library with -DU_ROBIN_HOOD_HASHING to have the numbers of the previous implementation)...
+ */
+
+#include <ulib/container/hash_map.h>
+
+#include "bench.h"
+
+static void bench(UString* vkey, UString* vmiss, uint32_t n)
+{
+   uint32_t i, found;
+   uint64_t start;
+   double t_insert, t_hit, t_miss, t_node, t_erase;
+
+   UHashMap<void*> table; // NB: we start from the default capacity so we measure also the cost of the resize...
+
+   start = bench_clock();
+
+   for (i = 0; i < n; ++i) table.insert(vkey[i], (void*)(long)(i+1));
+
+   t_insert = bench_elapsed(start);
+
+   start = bench_clock();
+
+   for (found = i = 0; i < n; ++i) if (table[vkey[i]]) ++found;
+
+   t_hit = bench_elapsed(start);
+
+   U_INTERNAL_ASSERT_EQUALS(found, n)
+
+   start = bench_clock();
+
+   for (i = 0; i < n; ++i) if (table[vmiss[i]]) ++found;
+
+   t_miss = bench_elapsed(start);
+
+   start = bench_clock();
+
+   for (i = 0; i < n; ++i) if (table.findNode(vkey[i])) ++found;
+
+   t_node = bench_elapsed(start);
+
+   start = bench_clock();
+
+   for (i = 0; i < n; ++i) if (table.erase(vkey[i])) ++found;
+
+   t_erase = bench_elapsed(start);
+
+   U_INTERNAL_ASSERT(table.empty())
+
+   printf("n = %7u insert = %6.1f lookup(hit) = %6.1f lookup(miss) = %6.1f findNode(hit) = %6.1f erase = %6.1f ns/op (found = %u)\n",
+          n, t_insert / n, t_hit / n, t_miss / n, t_node / n, t_erase / n, found);
+}
+
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+#ifdef U_SWISS_TABLE
+   printf("=> Testing hash map (swiss table)...\n");
+#else
+   printf("=> Testing hash map (robin hood)...\n");
+#endif
+
+   static const uint32_t vn[] = { 1000, 100000, 1000000 };
+
+   UString* vkey  = new UString[1000000];
+   UString* vmiss = new UString[1000000];
+
+   bench_keys(vkey, vmiss, 1000000);
+
+   for (uint32_t i = 0; i < U_NUM_ELEMENTS(vn); ++i) bench(vkey, vmiss, vn[i]);
+
+   delete[] vkey;
+   delete[] vmiss;
+}
@@ -0,0 +1,108 @@
+/**
+ * eval_hpack.cpp
+ *
+ * Testing the HPACK encoder: header bytes per response and ns/header on a connection of 100 streams, stateless (literal) vs output dynamic table...
+ */
+
+#include <ulib/utility/http2.h>
+
+#include "bench.h"
+
+#define STREAMS 100U
+
+// NB: UHTTP2 is friend of a class named Application...
+
+class Application {
+public:
+
+   static void init() { UHTTP2::buildTable(); }
+
+   static void bench(UVector<UString>& vname, UVector<UString>& vvalue, uint32_t nconn, bool bdyntbl)
+      {
+      U_TRACE(5, "Application::bench(%p,%p,%u,%b)", &vname, &vvalue, nconn, bdyntbl)
+
+      unsigned char buffer[8192];
+      uint64_t nbytes = 0, nheader = 0;
+      UHTTP2::Connection* pconn = new UHTTP2::Connection;
+
+      uint64_t start = bench_clock();
+
+      for (uint32_t c = 0; c < nconn; ++c)
+         {
+         UHTTP2::HpackDynamicTable* dyntbl = (bdyntbl ? &(pconn->odyntbl) : U_NULLPTR);
+
+         for (uint32_t i = 0; i < STREAMS; ++i)
+            {
+            unsigned char* dst = buffer;
+
+            *dst++ = 0x80 | 8; // :status 200
+
+            for (uint32_t j = 0, n = vname.size(); j < n; ++j)
+               {
+               if (vname[j].equal(U_CONSTANT_TO_PARAM("Content-Length")))
+                  {
+                  char num[16];
+
+                  dst = UHTTP2::hpackEncodeHeader(dst, dyntbl, vname[j], num, u_num2str32(1000+i*7, num) - num); // NB: it changes with every response...
+                  }
+               else
+                  {
+                  dst = UHTTP2::hpackEncodeHeader(dst, dyntbl, vname[j], vvalue[j]);
+                  }
+               }
+
+            nbytes  += (dst - buffer);
+            nheader += vname.size() + 1;
+            }
+
+         UHTTP2::clearHpackDynTbl(&(pconn->odyntbl));
+         }
+
+      double t = bench_elapsed(start);
+
+      printf("%-9s %6.1f bytes/response %6.1f ns/header\n", (bdyntbl ? "dyntbl" : "stateless"), (double)nbytes / (nconn * STREAMS), t / nheader);
+
+      delete pconn;
+      }
+};
+
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   printf("=> Testing hpack encoder...\n");
+
+#ifndef U_HTTP2_DISABLE
+   Application::init();
+
+   // a typical response of a dynamic page
+
+   static const char* headers[] = {
+      "Server",                "ULib",
+      "Date",                  "Wed, 20 Jun 2012 11:43:17 GMT",
+      "Content-Type",          "text/html; charset=UTF-8",
+      "Content-Length",        "",
+      "Cache-Control",         "private, max-age=0, no-cache",
+      "Vary",                  "Accept-Encoding",
+      "Set-Cookie",            "ulib.s1=ab8d7f0c1e3a4b2d; path=/; HttpOnly",
+      "Strict-Transport-Security", "max-age=31536000; includeSubDomains",
+      "X-Frame-Options",       "SAMEORIGIN",
+      "X-Content-Type-Options", "nosniff"
+   };
+
+   UVector<UString> vname, vvalue;
+
+   for (uint32_t i = 0; i < U_NUM_ELEMENTS(headers); i += 2)
+      {
+      vname.push_back(UString(headers[i]));
+      vvalue.push_back(UString(headers[i+1]));
+      }
+
+   uint32_t nconn = (argc > 1 ? u_atoi(argv[1]) : 1000);
+
+   Application::bench(vname, vvalue, nconn, false);
+   Application::bench(vname, vvalue, nconn, true);
+#endif
+}
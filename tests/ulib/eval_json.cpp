@@ -0,0 +1,83 @@
+/**
+ * eval_json.cpp
+ *
+ * Testing UValue: parse + free of the tree with the memory pool (node by node) and with the arena (bulk release)...
+ */
+
+#include <ulib/json/value.h>
+
+#include "bench.h"
+
+static UString makeDocument(uint32_t sz)
+{
+   char buffer[256];
+   UString doc(sz + sizeof(buffer));
+
+   doc.push_back('[');
+
+   for (uint32_t i = 0; doc.size() < sz; ++i)
+      {
+      if (i) doc.push_back(',');
+
+      (void) doc.append(buffer, u__snprintf(buffer, sizeof(buffer),
+                        U_CONSTANT_TO_PARAM("{\"id\":%u,\"name\":\"user_%u\",\"active\":%s,\"score\":%u.%u,\"tags\":[\"tag%u\",\"tag%u\"],\"geo\":{\"lat\":-%u.25,\"lon\":%u.5}}"),
+                        i, i, (i & 1 ? "true" : "false"), i % 100, i % 10, i % 7, i % 13, i % 90, i % 180));
+      }
+
+   doc.push_back(']');
+
+   return doc;
+}
+
+static void bench(const UString& doc, uint32_t n)
+{
+   uint32_t i;
+   UValue json;
+   double t_pool, t_arena;
+   uint64_t start = bench_clock();
+
+   for (i = 0; i < n; ++i)
+      {
+      if (json.parse(doc) == false) U_ERROR("parse failed");
+
+      json.clear();
+      }
+
+   t_pool = bench_elapsed(start);
+
+   UValueArena arena;
+
+   (void) UValue::setArena(&arena);
+
+   start = bench_clock();
+
+   for (i = 0; i < n; ++i)
+      {
+      if (json.parse(doc) == false) U_ERROR("parse failed");
+
+      json.clear(); // NB: the nodes of the arena are not visited...
+
+      arena.reset();
+      }
+
+   t_arena = bench_elapsed(start);
+
+   (void) UValue::setArena(U_NULLPTR);
+
+   printf("doc = %8u bytes parse+free: pool = %10.1f arena = %10.1f us/doc (%5.1f%%, %u blocks)\n",
+          doc.size(), t_pool / n / 1e3, t_arena / n / 1e3, 100.0 * (t_pool - t_arena) / t_pool, arena.getNumBlock());
+}
+
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   printf("=> Testing json parse + free (memory pool vs arena)...\n");
+
+   static const uint32_t vsz[] = { 1024, 100 * 1024, 10 * 1024 * 1024 },
+                         vn[]  = { 20000,     200,                    5 };
+
+   for (uint32_t i = 0; i < U_NUM_ELEMENTS(vsz); ++i) bench(makeDocument(vsz[i]), vn[i]);
+}
@@ -0,0 +1,105 @@
+/**
+ * eval_timer.cpp
+ *
+ * Testing UTimer: sorted list vs hierarchical timing wheel (insert/erase/expire)...
+ */
+
+#include <ulib/timer.h>
+
+#include "bench.h"
+
+static uint32_t fired;
+
+class MyAlarm : public UEventTime {
+public:
+
+   MyAlarm() : UEventTime(0L, 1L) {}
+
+   void set(long ms)
+      {
+      UTimeVal::setMilliSecond(ms);
+
+      setTolerance();
+      }
+
+   virtual int handlerTime() U_DECL_FINAL
+      {
+      ++fired;
+
+      return -1;
+      }
+};
+
+static void bench(MyAlarm* vec, uint32_t n, bool bwheel)
+{
+   uint32_t i;
+   uint64_t start;
+   double t_insert, t_erase, t_expire;
+
+   UTimer::init(UTimer::NOSIGNAL, bwheel);
+
+   // insert/erase: timeouts spread on one minute like the connection REQ_TIMEOUT
+
+   for (i = 0; i < n; ++i) vec[i].set(1000L + (u_get_num_random_range1(59000)));
+
+   start = bench_clock();
+
+   for (i = 0; i < n; ++i) UTimer::insert(vec+i);
+
+   t_insert = bench_elapsed(start);
+
+   start = bench_clock();
+
+   for (i = 0; i < n; ++i) UTimer::erase(vec+i);
+
+   t_erase = bench_elapsed(start);
+
+   // expire: timeouts spread on 50ms, then we wait for all of them
+
+   for (i = 0; i < n; ++i)
+      {
+      vec[i].set(1L + u_get_num_random_range1(49));
+
+      UTimer::insert(vec+i);
+      }
+
+   UTimeVal::nanosleep(100L);
+
+   fired = 0;
+
+   start = bench_clock();
+
+   UTimer::run();
+
+   t_expire = bench_elapsed(start);
+
+   printf("%-5s n = %7u insert = %9.1f ns/op erase = %9.1f ns/op expire = %9.1f ns/op (fired = %u)\n",
+          bwheel ? "wheel" : "list", n, t_insert / n, t_erase / n, t_expire / n, fired);
+
+   UTimer::clear();
+}
+
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   printf("=> Testing timer...\n");
+
+   // NB: the sorted list is O(n) for insert, with 100k timers it take minutes, so we run it only on request (argv[1] = "all")
+
+   bool ball = (argc > 1 && strcmp(argv[1], "all") == 0);
+   static const uint32_t vn[] = { 1000, 100000, 1000000 };
+
+   MyAlarm* vec = new MyAlarm[1000000];
+
+   for (uint32_t i = 0; i < U_NUM_ELEMENTS(vn); ++i)
+      {
+      if (vn[i] == 1000 || ball) bench(vec, vn[i], false);
+
+      bench(vec, vn[i], true);
+      }
+
+   delete[] vec;
+}
@@ -0,0 +1,225 @@
+/**
+ * eval_udp.cpp
+ *
+ * Testing the UDP I/O of UQuic on loopback: packets/s of datagrams of U_MAX_DATAGRAM_SIZE with one syscall per datagram (sendto/recvfrom),
+ * with sendmmsg/recvmmsg and with GSO (sendmsg with UDP_SEGMENT) plus recvmmsg with GRO...
+ *
+ * NB: it don't depend from libquiche, the constants are the same of <ulib/net/udpbatch.h> (the batched UDP I/O of UQuic, see test_udpbatch)
+ */
+
+#include "bench.h"
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+#define U_MAX_DATAGRAM_SIZE 1350
+#define U_QUIC_BATCH          16
+#define U_QUIC_BATCH_SIZE  65535
+#define U_SEGMENT             32 // datagrams sent with one syscall (the burst of quiche_conn_send() of a connection)
+
+static int fds, fdr;
+static struct sockaddr_in addr;
+static char buffer[U_QUIC_BATCH][U_QUIC_BATCH_SIZE];
+
+static void init(bool bgro)
+{
+   U_TRACE(5, "init(%b)", bgro)
+
+   socklen_t len = sizeof(addr);
+   int size = 32 * 1024 * 1024, val = 1;
+
+   fds = socket(AF_INET, SOCK_DGRAM, 0);
+   fdr = socket(AF_INET, SOCK_DGRAM, 0);
+
+   (void) memset(&addr, 0, sizeof(addr));
+
+   addr.sin_family      = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   (void) setsockopt(fdr, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+   (void) setsockopt(fds, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+   if (bind(fdr, (struct sockaddr*)&addr, sizeof(addr)) ||
+       getsockname(fdr, (struct sockaddr*)&addr, &len))
+      {
+      U_ERROR("bind() on loopback failed");
+      }
+
+   if (bgro) (void) setsockopt(fdr, SOL_UDP, UDP_GRO, &val, sizeof(val));
+}
+
+static void clear()
+{
+   U_TRACE_NO_PARAM(5, "clear()")
+
+   (void) close(fds);
+   (void) close(fdr);
+}
+
+// return the number of datagrams received (with GRO a buffer can hold more datagrams)
+
+static uint32_t recvBatch(bool bmmsg)
+{
+   U_TRACE(5, "recvBatch(%b)", bmmsg)
+
+   if (bmmsg == false) return (recvfrom(fdr, buffer[0], U_QUIC_BATCH_SIZE, 0, U_NULLPTR, U_NULLPTR) > 0);
+
+   struct iovec iov[U_QUIC_BATCH];
+   struct mmsghdr msgs[U_QUIC_BATCH];
+   char control[U_QUIC_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+
+   (void) memset(msgs, 0, sizeof(msgs));
+
+   for (uint32_t i = 0; i < U_QUIC_BATCH; ++i)
+      {
+      iov[i].iov_base = buffer[i];
+      iov[i].iov_len  = U_QUIC_BATCH_SIZE;
+
+      msgs[i].msg_hdr.msg_iov        = iov+i;
+      msgs[i].msg_hdr.msg_iovlen     = 1;
+      msgs[i].msg_hdr.msg_control    = control[i];
+      msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+      }
+
+   int n = recvmmsg(fdr, msgs, U_QUIC_BATCH, MSG_WAITFORONE, U_NULLPTR);
+
+   if (n <= 0) return 0;
+
+   uint32_t count = 0;
+
+   for (int i = 0; i < n; ++i) count += (msgs[i].msg_len + U_MAX_DATAGRAM_SIZE - 1) / U_MAX_DATAGRAM_SIZE; // NB: the last segment can be shorter...
+
+   return count;
+}
+
+// send U_SEGMENT datagrams: 0 => sendto() for every one, 1 => sendmmsg(), 2 => one sendmsg() with UDP_SEGMENT
+
+static bool sendBurst(int mode)
+{
+   U_TRACE(5, "sendBurst(%d)", mode)
+
+   static char payload[U_SEGMENT * U_MAX_DATAGRAM_SIZE];
+
+   if (mode == 0)
+      {
+      for (uint32_t i = 0; i < U_SEGMENT; ++i)
+         {
+         if (sendto(fds, payload + i * U_MAX_DATAGRAM_SIZE, U_MAX_DATAGRAM_SIZE, 0, (struct sockaddr*)&addr, sizeof(addr)) < 0) return false;
+         }
+
+      return true;
+      }
+
+   if (mode == 1)
+      {
+      struct iovec iov[U_SEGMENT];
+      struct mmsghdr msgs[U_SEGMENT];
+
+      (void) memset(msgs, 0, sizeof(msgs));
+
+      for (uint32_t i = 0; i < U_SEGMENT; ++i)
+         {
+         iov[i].iov_base = payload + i * U_MAX_DATAGRAM_SIZE;
+         iov[i].iov_len  = U_MAX_DATAGRAM_SIZE;
+
+         msgs[i].msg_hdr.msg_name    = &addr;
+         msgs[i].msg_hdr.msg_namelen = sizeof(addr);
+         msgs[i].msg_hdr.msg_iov     = iov+i;
+         msgs[i].msg_hdr.msg_iovlen  = 1;
+         }
+
+      return (sendmmsg(fds, msgs, U_SEGMENT, 0) == U_SEGMENT);
+      }
+
+   struct msghdr msg;
+   struct cmsghdr* cmsg;
+   struct iovec iov = { payload, sizeof(payload) };
+   char control[CMSG_SPACE(sizeof(uint16_t))];
+
+   (void) memset(&msg,    0, sizeof(msg));
+   (void) memset(control, 0, sizeof(control));
+
+   msg.msg_name       = &addr;
+   msg.msg_namelen    = sizeof(addr);
+   msg.msg_iov        = &iov;
+   msg.msg_iovlen     = 1;
+   msg.msg_control    = control;
+   msg.msg_controllen = sizeof(control);
+
+   cmsg = CMSG_FIRSTHDR(&msg);
+
+   cmsg->cmsg_level = SOL_UDP;
+   cmsg->cmsg_type  = UDP_SEGMENT;
+   cmsg->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+
+   *(uint16_t*)CMSG_DATA(cmsg) = U_MAX_DATAGRAM_SIZE;
+
+   return (sendmsg(fds, &msg, 0) == (ssize_t)sizeof(payload));
+}
+
+static void bench(const char* name, int mode, uint32_t npacket)
+{
+   U_TRACE(5, "bench(%S,%d,%u)", name, mode, npacket)
+
+   init(mode == 2);
+
+   uint64_t start = bench_clock();
+   uint32_t sent = 0, received = 0, burst = npacket / U_SEGMENT;
+
+   for (uint32_t i = 0; i < burst; ++i)
+      {
+      if (sendBurst(mode) == false)
+         {
+         printf("%-18s not supported (errno = %d)\n", name, errno);
+
+         clear();
+
+         return;
+         }
+
+      sent += U_SEGMENT;
+
+      // NB: we read the burst before we send the next one, so the socket buffer of loopback never drops...
+
+      while (received < sent)
+         {
+         uint32_t n = recvBatch(mode != 0);
+
+         if (n == 0) break;
+
+         received += n;
+         }
+      }
+
+   double t = bench_elapsed(start);
+
+   printf("%-18s %8.0f pkt/s %7.1f ns/pkt (sent = %u received = %u)\n", name, received * 1e9 / t, t / received, sent, received);
+
+   clear();
+}
+
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   printf("=> Testing UDP I/O on loopback (datagram of %u bytes)...\n", U_MAX_DATAGRAM_SIZE);
+
+   uint32_t npacket = (argc > 1 ? u_atoi(argv[1]) : 1000000);
+
+   bench("sendto/recvfrom",   0, npacket);
+   bench("sendmmsg/recvmmsg", 1, npacket);
+   bench("GSO/recvmmsg+GRO",  2, npacket);
+}
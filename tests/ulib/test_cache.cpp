@@ -325,4 +325,79 @@ U_EXPORT main (int argc, char* argv[])
    U_INTERNAL_ASSERT( ok )
 
    cout << c;
+
+   // sharded cache
+   // -------------
+
+   UShardCache sc;
+
+   if (sc.open(U_STRING_FROM_CONSTANT("tmp/shard.cache"), 64 * 1024, 4, U_NULLPTR, true))
+      {
+      U_INTERNAL_ASSERT_EQUALS(sc.getNumShard(), 4)
+
+      char buffer[32];
+      uint32_t i, n, len, found = 0;
+      UShardCache::cache_shard_stats total;
+
+      for (i = 0; i < 5000; ++i)
+         {
+         len = u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("key_%u"), i);
+
+         sc.addContent(UString((const void*)buffer, len), UString((const void*)buffer, len));
+         }
+
+      for (i = 0; i < 5000; ++i)
+         {
+         len = u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("key_%u"), i);
+
+         UString content = sc.getContent(buffer, len);
+
+         if (content)
+            {
+            ok = content.equal(buffer, len);
+
+            U_INTERNAL_ASSERT( ok )
+
+            ++found;
+            }
+         }
+
+      sc.getStats(total);
+
+      // NB: 5000 entries don't fit in 64k, so the oldest are evicted...
+
+      U_INTERNAL_ASSERT_MAJOR(found, 0)
+      U_INTERNAL_ASSERT_MINOR(found, 5000)
+      U_INTERNAL_ASSERT_EQUALS(total.hits, found)
+      U_INTERNAL_ASSERT_EQUALS(total.misses, 5000 - found)
+      U_INTERNAL_ASSERT_MAJOR(total.evictions, 0)
+
+      for (i = n = 0; i < sc.getNumShard(); ++i) if (sc.getStats(i)->hits) ++n;
+
+      U_INTERNAL_ASSERT_EQUALS(n, 4) // NB: the keys are spread on all the shards...
+
+      sc.resetStats();
+      sc.getStats(total);
+
+      U_INTERNAL_ASSERT_EQUALS(total.hits + total.misses + total.evictions, 0)
+      }
+
+   // NB: the semaphores given by the caller limit the number of shards, and an existing file with more shards is rejected...
+
+   sem_t sem[2];
+   UShardCache sc1, sc2, sc3;
+
+   if (sc1.open(U_STRING_FROM_CONSTANT("tmp/shard1.cache"), 64 * 1024, 8, U_NULLPTR, false, sem, 2))
+      {
+      U_INTERNAL_ASSERT_EQUALS(sc1.getNumShard(), 2)
+      }
+
+   if (sc2.open(U_STRING_FROM_CONSTANT("tmp/shard2.cache"), 64 * 1024, 4))
+      {
+      U_INTERNAL_ASSERT_EQUALS(sc2.getNumShard(), 4)
+
+      ok = sc3.open(U_STRING_FROM_CONSTANT("tmp/shard2.cache"), 64 * 1024, 4, U_NULLPTR, false, sem, 2);
+
+      U_INTERNAL_ASSERT_EQUALS(ok, false)
+      }
 }
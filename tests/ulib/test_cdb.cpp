@@ -144,6 +144,52 @@ U_EXPORT main (int argc, char* argv[], char* env[])
 
       vec_values.clear();
 
+      // cdb64 format
+      // ------------
+
+      U_ASSERT( x.isCdb64() == false )
+
+      UCDB y(U_STRING_FROM_CONSTANT("tmp/input64.cdb"), false);
+
+      if (x.copyTo(y.UFile::getPath(), true) &&
+          y.open(true))
+         {
+         U_ASSERT( y.isCdb64() )
+         U_ASSERT( y.size() == x.size() )
+
+         U_ASSERT( y[U_STRING_FROM_CONSTANT("echo/tcp")] == U_STRING_FROM_CONSTANT("7") )
+         U_ASSERT( y.findNext() == 0 )
+         U_ASSERT( y[U_STRING_FROM_CONSTANT("users/udp")] == U_STRING_FROM_CONSTANT("11") )
+         U_ASSERT( y[U_STRING_FROM_CONSTANT("users/xxx")].empty() )
+
+         U_ASSERT( y[U_STRING_FROM_CONSTANT("one")] == U_STRING_FROM_CONSTANT("Hello") )
+         U_ASSERT( y.findNext() == 1 )
+         U_ASSERT( y.elem() == U_STRING_FROM_CONSTANT("Goodbye") )
+         U_ASSERT( y.findNext() == 1 )
+         U_ASSERT( y.elem() == U_STRING_FROM_CONSTANT("Another") )
+         U_ASSERT( y.findNext() == 0 )
+
+         U_ASSERT( y[U_STRING_FROM_CONSTANT(LKEY)] == U_STRING_FROM_CONSTANT(LDATA) )
+
+         // ...and back to the classic format
+
+         bool result = y.copyTo(U_STRING_FROM_CONSTANT("tmp/input32.cdb"), false);
+
+         y.UFile::munmap();
+         y.UFile::reset();
+
+         if (result &&
+             y.open(U_STRING_FROM_CONSTANT("tmp/input32.cdb")))
+            {
+            U_ASSERT( y.isCdb64() == false )
+            U_ASSERT( y.size() == x.size() )
+            U_ASSERT( y[U_STRING_FROM_CONSTANT("discard/udp")] == U_STRING_FROM_CONSTANT("9") )
+
+            y.UFile::munmap();
+            y.UFile::reset();
+            }
+         }
+
    // x.UFile::close();
       x.UFile::munmap();
       x.UFile::reset();
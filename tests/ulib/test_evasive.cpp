@@ -0,0 +1,191 @@
+// test_evasive.cpp
+
+#include <ulib/net/server/server.h>
+
+#ifdef U_EVASIVE_SUPPORT
+// NB: UServer_Base is friend of a class named Application...
+
+class Application {
+public:
+
+   static UServer_Base::uevasive_table* table;
+
+   static void init(uint64_t now)
+      {
+      U_TRACE(5, "Application::init(%llu)", now)
+
+      (void) memset(table, 0, sizeof(UServer_Base::uevasive_table));
+
+      table->cms_epoch = now / 1000;
+
+      UServer_Base::evasive_table = table;
+      UServer_Base::page_interval =
+      UServer_Base::site_interval = 10;
+      }
+
+   // the sliding window: the count of the previous window is weighted with the part of it still inside the window
+
+   static void testWindow(uint64_t now)
+      {
+      U_TRACE(5, "Application::testWindow(%llu)", now)
+
+      init(now);
+
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::findEvasiveSlot(1, false, now), U_NULLPTR)
+
+      UServer_Base::uevasive_slot* pslot = UServer_Base::findEvasiveSlot(1, true, now);
+
+      U_INTERNAL_ASSERT_POINTER(pslot)
+      U_INTERNAL_ASSERT_EQUALS(pslot->key, 1)
+      U_INTERNAL_ASSERT_EQUALS(pslot->window, now)
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::findEvasiveSlot(1, false, now), pslot)
+
+      uint32_t i, estimate = 0;
+
+      for (i = 0; i < 5; ++i) estimate = UServer_Base::hitEvasiveSlot(pslot, now, 10);
+
+      U_INTERNAL_ASSERT_EQUALS(estimate, 5)
+
+      // the next window: all the previous one counts
+
+      estimate = UServer_Base::hitEvasiveSlot(pslot, now + 10000, 10);
+
+      U_INTERNAL_ASSERT_EQUALS(pslot->prev, 5)
+      U_INTERNAL_ASSERT_EQUALS(pslot->window, now + 10000)
+      U_INTERNAL_ASSERT_EQUALS(estimate, 1 + 5)
+
+      // half of the window: half of the previous one counts
+
+      estimate = UServer_Base::hitEvasiveSlot(pslot, now + 15000, 10);
+
+      U_INTERNAL_ASSERT_EQUALS(estimate, 2 + 5 / 2)
+
+      // more than two windows later: the previous one is forgotten, the start of the window stay aligned
+
+      estimate = UServer_Base::hitEvasiveSlot(pslot, now + 35000, 10);
+
+      U_INTERNAL_ASSERT_EQUALS(pslot->prev, 0)
+      U_INTERNAL_ASSERT_EQUALS(pslot->window, now + 30000)
+      U_INTERNAL_ASSERT_EQUALS(estimate, 1)
+      }
+
+   // the count-min sketch: a key gets a slot only when it has been seen more than half of the threshold, it is cleared every max interval
+
+   static void testSketch(uint64_t now)
+      {
+      U_TRACE(5, "Application::testSketch(%llu)", now)
+
+      init(now);
+
+      uint32_t i, estimate;
+      uint64_t key = U_MULTICHAR_CONSTANT64('_','1','2','7','.','0','.','1');
+
+      for (i = 1; i <= 10; ++i)
+         {
+         estimate = UServer_Base::hitEvasiveSketch(key, now);
+
+         U_INTERNAL_ASSERT_EQUALS(estimate, i)
+         }
+
+      // a flood of unique keys don't raise the estimate of the other keys beyond their hits
+
+      for (i = 0; i < 1000; ++i) (void) UServer_Base::hitEvasiveSketch(((uint64_t)(i + 1) << 32) | (i * 2654435761U), now);
+
+      estimate = UServer_Base::hitEvasiveSketch(key, now + 1000);
+
+      U_INTERNAL_ASSERT_EQUALS(estimate, 11)
+
+      estimate = UServer_Base::hitEvasiveSketch(key, now + 10000);
+
+      U_INTERNAL_ASSERT_EQUALS(estimate, 1)
+      U_INTERNAL_ASSERT_EQUALS(table->cms_epoch, (now + 10000) / 1000)
+      }
+
+   // CLOCK: the keys with the same low 32 bit compete for the same U_EVASIVE_MAX_PROBE slots
+
+   static void testClock(uint64_t now)
+      {
+      U_TRACE(5, "Application::testClock(%llu)", now)
+
+      init(now);
+
+      uint32_t i;
+      uint64_t key[U_EVASIVE_MAX_PROBE+3];
+      UServer_Base::uevasive_slot* pslot;
+      UServer_Base::uevasive_slot* vslot[U_EVASIVE_MAX_PROBE];
+
+      for (i = 0; i < U_NUM_ELEMENTS(key); ++i) key[i] = ((uint64_t)(i + 1) << 32) | 1234;
+
+      for (i = 0; i < U_EVASIVE_MAX_PROBE; ++i)
+         {
+         vslot[i] = UServer_Base::findEvasiveSlot(key[i], true, now);
+
+         U_INTERNAL_ASSERT_EQUALS(vslot[i], table->slot + 1234 + i)
+         }
+
+      U_INTERNAL_ASSERT_EQUALS(table->nevicted, 0)
+
+      // all the slots are referenced: the first sweep clears the reference bits, the second one takes the first slot
+
+      pslot = UServer_Base::findEvasiveSlot(key[U_EVASIVE_MAX_PROBE], true, now);
+
+      U_INTERNAL_ASSERT_EQUALS(pslot, vslot[0])
+      U_INTERNAL_ASSERT_EQUALS(table->nevicted, 1)
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::findEvasiveSlot(key[0], false, now), U_NULLPTR)
+
+      // second chance: the new key is referenced, so the next victim is the following slot
+
+      (void) UServer_Base::hitEvasiveSlot(vslot[2], now, 10);
+
+      pslot = UServer_Base::findEvasiveSlot(key[U_EVASIVE_MAX_PROBE+1], true, now);
+
+      U_INTERNAL_ASSERT_EQUALS(pslot, vslot[1])
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::findEvasiveSlot(key[U_EVASIVE_MAX_PROBE], false, now), vslot[0])
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::findEvasiveSlot(key[2],                   false, now), vslot[2])
+
+      // a stale slot is taken immediately, also if referenced
+
+      for (i = 0; i < U_EVASIVE_MAX_PROBE; ++i) vslot[i]->ref = 1;
+
+      vslot[5]->window = now - 20001;
+
+      pslot = UServer_Base::findEvasiveSlot(key[U_EVASIVE_MAX_PROBE+2], true, now);
+
+      U_INTERNAL_ASSERT_EQUALS(pslot, vslot[5])
+
+      // the addresses on the blocking list are never replaced: the new key is refused
+
+      for (i = 0; i < U_EVASIVE_MAX_PROBE; ++i) vslot[i]->hold = (now / 1000) + 1;
+
+      pslot = UServer_Base::findEvasiveSlot(key[0], true, now);
+
+      U_INTERNAL_ASSERT_EQUALS(pslot, U_NULLPTR)
+      U_INTERNAL_ASSERT_EQUALS(table->nrefused, 1)
+      U_INTERNAL_ASSERT_EQUALS(table->nevicted, 3)
+      }
+};
+
+UServer_Base::uevasive_table* Application::table;
+#endif
+
+int
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+#ifdef U_EVASIVE_SUPPORT
+   uint64_t now = 1000000; // NB: 1000 sec, the time is given to the functions of the table...
+
+   Application::table = (UServer_Base::uevasive_table*) malloc(sizeof(UServer_Base::uevasive_table));
+
+   Application::testWindow(now);
+   Application::testSketch(now);
+   Application::testClock(now);
+
+   UServer_Base::evasive_table = U_NULLPTR;
+
+   free(Application::table);
+#endif
+}
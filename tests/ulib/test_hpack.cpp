@@ -0,0 +1,186 @@
+// test_hpack.cpp
+
+#include <ulib/utility/http2.h>
+
+// NB: UHTTP2 is friend of a class named Application...
+
+class Application {
+public:
+
+   static void init()
+      {
+      U_TRACE_NO_PARAM(5, "Application::init()")
+
+      UHTTP2::buildTable();
+
+      U_http_version = '2';
+
+#  ifdef DEBUG
+      UHTTP2::bdecodeHeadersDebug = true; // NB: we decode a response...
+#  endif
+      }
+
+   static bool check(UHashMap<UString>* table, const char* name, const char* value)
+      {
+      U_TRACE(5, "Application::check(%p,%S,%S)", table, name, value)
+
+      UString key(name);
+
+      UHashMap<void*>::lhash = key.hashIgnoreCase();
+
+      if (table->lookup(key) &&
+          ((UStringRep*)table->elem())->equal(value, u__strlen(value, __PRETTY_FUNCTION__)))
+         {
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
+   // encode the headers with the output dynamic table of the connection and decode them with the input one (as the peer would do)
+
+   static uint32_t roundTrip(UHTTP2::Connection* pconn, const char** headers, uint32_t n)
+      {
+      U_TRACE(5, "Application::roundTrip(%p,%p,%u)", pconn, headers, n)
+
+      uint32_t i;
+      unsigned char buffer[4096];
+      unsigned char* dst = buffer;
+
+      for (i = 0; i < n; i += 2)
+         {
+         dst = UHTTP2::hpackEncodeHeader(dst, &(pconn->odyntbl), UString(headers[i]), headers[i+1], u__strlen(headers[i+1], __PRETTY_FUNCTION__));
+
+         U_INTERNAL_ASSERT_EQUALS(UHTTP2::hpack_errno, 0)
+         }
+
+      U_INTERNAL_ASSERT_MINOR(dst - buffer, (ptrdiff_t)sizeof(buffer))
+
+#  ifdef DEBUG
+      UHashMap<UString>* table = &(pconn->dtable);
+
+      table->clear();
+
+      UHTTP2::nerror      =
+      UHTTP2::hpack_errno = 0;
+
+      UHTTP2::decodeHeaders(table, &(pconn->ddyntbl), buffer, dst);
+
+      U_INTERNAL_ASSERT_EQUALS(UHTTP2::nerror, 0)
+      U_INTERNAL_ASSERT_EQUALS(UHTTP2::hpack_errno, 0)
+
+      for (i = 0; i < n; i += 2)
+         {
+         U_INTERNAL_ASSERT(check(table, headers[i], headers[i+1]))
+         }
+
+      // NB: the two dynamic tables must stay in sync...
+
+      U_INTERNAL_ASSERT_EQUALS(pconn->odyntbl.num_entries, pconn->ddyntbl.num_entries)
+      U_INTERNAL_ASSERT_EQUALS(pconn->odyntbl.hpack_size,  pconn->ddyntbl.hpack_size)
+#  endif
+
+      U_RETURN(dst - buffer);
+      }
+
+   static void run()
+      {
+      U_TRACE_NO_PARAM(5, "Application::run()")
+
+      unsigned char buffer[64];
+      UHTTP2::Connection* pconn = new UHTTP2::Connection;
+
+      // static table: full match (:status 200) and the name only (server)
+
+      unsigned char* dst = UHTTP2::hpackEncodeHeader(buffer, &(pconn->odyntbl), *UString::str_status, U_STRING_FROM_CONSTANT("200"));
+
+      U_INTERNAL_ASSERT_EQUALS(dst - buffer, 1)
+      U_INTERNAL_ASSERT_EQUALS(buffer[0], 0x80 | 8)
+
+      dst = UHTTP2::hpackEncodeHeader(buffer, &(pconn->odyntbl), *UString::str_server, *UString::str_ULib);
+
+      U_INTERNAL_ASSERT_EQUALS(buffer[0], 0x40 | 54) // literal with incremental indexing, indexed name
+
+      UHTTP2::clearHpackDynTbl(&(pconn->odyntbl));
+
+      // Huffman only if shorter, literal otherwise, and an empty string is only the length
+
+      U_INTERNAL_ASSERT_MINOR(UHTTP2::hpackHuffmanLen(U_CONSTANT_TO_PARAM("text/html; charset=UTF-8")), U_CONSTANT_SIZE("text/html; charset=UTF-8"))
+      U_INTERNAL_ASSERT(UHTTP2::hpackHuffmanLen(U_CONSTANT_TO_PARAM("~|~|~|")) >= U_CONSTANT_SIZE("~|~|~|"))
+
+      dst = UHTTP2::hpackEncodeString(buffer, U_CONSTANT_TO_PARAM("text/html; charset=UTF-8"));
+
+      U_INTERNAL_ASSERT_EQUALS(buffer[0] & 0x80, 0x80)
+
+      dst = UHTTP2::hpackEncodeString(buffer, U_CONSTANT_TO_PARAM("~|~|~|"));
+
+      U_INTERNAL_ASSERT_EQUALS(buffer[0], U_CONSTANT_SIZE("~|~|~|"))
+
+      dst = UHTTP2::hpackEncodeString(buffer, U_CONSTANT_TO_PARAM(""));
+
+      U_INTERNAL_ASSERT_EQUALS(dst - buffer, 1)
+      U_INTERNAL_ASSERT_EQUALS(buffer[0], 0x00)
+
+      dst = UHTTP2::hpackEncodeString(buffer, "", 0, true);
+
+      U_INTERNAL_ASSERT_EQUALS(dst - buffer, 1)
+      U_INTERNAL_ASSERT_EQUALS(buffer[0], 0x00)
+
+      // the round trip: the first response fills the dynamic table, the second one hits it
+
+      const char* response1[] = {
+         ":status",         "200",
+         "server",          "ULib",
+         "content-type",    "text/html; charset=UTF-8",
+         "content-length",  "1234",
+         "cache-control",   "private, max-age=0, no-cache",
+         "set-cookie",      "ulib.s1=ab8d7f0c1e3a4b2d; path=/; HttpOnly",
+         "x-frame-options", "SAMEORIGIN",
+         "x-literal",       "~|~|~|",
+         "x-empty",         ""
+      };
+
+      const char* response2[] = {
+         ":status",         "404",
+         "server",          "ULib",
+         "content-type",    "text/html; charset=UTF-8",
+         "content-length",  "56789",
+         "cache-control",   "private, max-age=0, no-cache",
+         "set-cookie",      "ulib.s1=ab8d7f0c1e3a4b2d; path=/; HttpOnly",
+         "x-frame-options", "DENY", // NB: the name is indexed in the dynamic table, the value is not...
+         "x-literal",       "~|~|~|",
+         "x-empty",         ""
+      };
+
+      uint32_t len1 = roundTrip(pconn, response1, U_NUM_ELEMENTS(response1)),
+               len2 = roundTrip(pconn, response2, U_NUM_ELEMENTS(response2));
+
+      U_INTERNAL_DUMP("len1 = %u len2 = %u", len1, len2)
+
+      U_INTERNAL_ASSERT_MINOR(len2, len1)
+      U_INTERNAL_ASSERT_MAJOR(pconn->odyntbl.num_entries, 0)
+
+      // the same response again: now also x-frame-options: DENY is a full match
+
+      uint32_t len3 = roundTrip(pconn, response2, U_NUM_ELEMENTS(response2));
+
+      U_INTERNAL_ASSERT_MINOR(len3, len2)
+
+      UHTTP2::clearHpackDynTbl(&(pconn->odyntbl));
+
+      delete pconn;
+      }
+};
+
+int
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+#ifndef U_HTTP2_DISABLE
+   Application::init();
+   Application::run();
+#endif
+}
@@ -36,6 +36,36 @@ int U_EXPORT main(int argc, char* argv[], char* env[])
    U_ASSERT(x.empty())
 #endif
 
+#if defined(USE_LIBZ) || defined(USE_LIBBROTLI) || defined(USE_LIBZSTD)
+   // Accept-Encoding with quality values (RFC 7231 5.3.4)
+
+   uint8_t all = 0;
+
+# ifdef USE_LIBZ
+   all |= HTTP_IS_ACCEPT_GZIP;
+# endif
+# ifdef USE_LIBBROTLI
+   all |= HTTP_IS_ACCEPT_BROTLI;
+# endif
+# ifdef USE_LIBZSTD
+   all |= HTTP_IS_ACCEPT_ZSTD;
+# endif
+
+   U_ASSERT_EQUALS(UHTTP::getAcceptEncoding(U_CONSTANT_TO_PARAM("identity")), 0)
+   U_ASSERT_EQUALS(UHTTP::getAcceptEncoding(U_CONSTANT_TO_PARAM("*;q=0")), 0)
+   U_ASSERT_EQUALS(UHTTP::getAcceptEncoding(U_CONSTANT_TO_PARAM("*")), all)
+   U_ASSERT_EQUALS(UHTTP::getAcceptEncoding(U_CONSTANT_TO_PARAM("gzip;q=0.5, br;q=0.5, zstd;q=0.5")), all)
+   U_ASSERT_EQUALS(UHTTP::getAcceptEncoding(U_CONSTANT_TO_PARAM("gzip;q=0, *;q=0.1")), all & ~HTTP_IS_ACCEPT_GZIP)
+
+# ifdef USE_LIBZ
+   U_ASSERT_EQUALS(UHTTP::getAcceptEncoding(U_CONSTANT_TO_PARAM("gzip, deflate")), HTTP_IS_ACCEPT_GZIP)
+   U_ASSERT_EQUALS(UHTTP::getAcceptEncoding(U_CONSTANT_TO_PARAM("x-gzip ; q=0.8")), HTTP_IS_ACCEPT_GZIP)
+   U_ASSERT_EQUALS(UHTTP::getAcceptEncoding(U_CONSTANT_TO_PARAM("gzip;q=0")), 0)
+   U_ASSERT_EQUALS(UHTTP::getAcceptEncoding(U_CONSTANT_TO_PARAM("br;q=0.8, gzip;q=1.0")), HTTP_IS_ACCEPT_GZIP)
+   U_ASSERT_EQUALS(UHTTP::getAcceptEncoding(U_CONSTANT_TO_PARAM("br;q=0.801,gzip;q=0.8")), (all & HTTP_IS_ACCEPT_BROTLI ? HTTP_IS_ACCEPT_BROTLI : HTTP_IS_ACCEPT_GZIP))
+# endif
+#endif
+
    UHttpClient<UTCPSocket> http(U_NULLPTR);
 
 #ifndef JOHN
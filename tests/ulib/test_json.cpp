@@ -129,6 +129,17 @@ static void testQuery(const UString& json, const char* cquery, const UString& ex
               UValue::getJReadErrorDescription()));
 
    U_INTERNAL_ASSERT_EQUALS(result, expected)
+
+   // the same query with the on-demand parser
+
+   result.clear();
+
+   dataType = UJsonOnDemand(json).jread(query, result);
+
+   cout.write(buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("dataType = (%d %S) query = %V result(%u) = %V (on-demand)\n"),
+              dataType, UValue::getDataTypeDescription(dataType), query.rep, result.size(), result.rep));
+
+   U_INTERNAL_ASSERT_EQUALS(result, expected)
 }
 
 int
@@ -350,6 +361,27 @@ U_EXPORT main (int argc, char* argv[], char* env[])
 
    cerr.write(buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("# Time Consumed with              jreadArrayStep() = %4ld ms\n"), crono.getTimeElapsed()));
 
+   // now with the on-demand parser (the index of the structural characters is built only one time)...
+
+   crono.start();
+
+   UJsonOnDemand doc(array);
+
+   for (i = 0; i < n; ++i)
+      {
+      result.clear();
+
+      (void) doc.jread(U_STRING_FROM_CONSTANT("[*{'Users'"), result, &i);
+
+   // cout.write(buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("array[%d] \"Users\": = %V\n"), i, result.rep));
+      }
+
+   crono.stop();
+
+   cerr.write(buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("# Time Consumed with         UJsonOnDemand::jread() = %4ld ms\n"), crono.getTimeElapsed()));
+
+   U_INTERNAL_ASSERT_EQUALS(doc.getNumElement(0), n)
+
    UString searchJson = U_STRING_FROM_CONSTANT("{\"took\":1,\"timed_out\":false,\"_shards\":{\"total\":1,\"successful\":1,\"failed\":0},"
                                                "\"hits\":{\"total\":1,\"max_score\":1.0,\"hits\":[{\"_index\":\"tfb\",\"_type\":\"world\",\"_id\":\"6464\",\"_score\":1.0,"
                                                "\"_source\":{ \"randomNumber\" : 9342 }}]}}");
@@ -396,6 +428,12 @@ U_EXPORT main (int argc, char* argv[], char* env[])
 
    result1.clear();
 
+   (void) UJsonOnDemand(searchJson).jfind(U_CONSTANT_TO_PARAM("\"randomNumber\""), result1);
+
+   U_INTERNAL_ASSERT_EQUALS(result1, "9342")
+
+   result1.clear();
+
    testQuery( U_STRING_FROM_CONSTANT("{ \"_id\" : 3457, \"id\" : 3457, \"randomNumber\" : 8427 }"), "{'randomNumber'", U_STRING_FROM_CONSTANT("8427") );
    testQuery( exampleJson, "", exampleJson );
    testQuery( exampleJson, "[1", UString::getStringNull() );
@@ -455,6 +493,47 @@ U_EXPORT main (int argc, char* argv[], char* env[])
    U_INTERNAL_ASSERT(ok)
 #endif
 
+   // NB: a tree of the arena remember its arena, it can be destroyed after the reset or while another arena is set...
+   {
+   UValueArena arena1, arena2;
+   UValue* tree1;
+   UValue* tree2;
+
+   U_NEW(UValue, tree1, UValue);
+   U_NEW(UValue, tree2, UValue);
+
+   (void) UValue::setArena(&arena1);
+
+   ok = tree1->parse(U_STRING_FROM_CONSTANT("{\"key\":[\"value\",{\"a\":1}]}"));
+   U_INTERNAL_ASSERT(ok)
+
+   (void) UValue::setArena(&arena2);
+
+   ok = tree2->parse(U_STRING_FROM_CONSTANT("[\"one\",\"two\"]"));
+   U_INTERNAL_ASSERT(ok)
+
+   UVector<UString> members;
+
+   ok = (tree1->getMemberNames(members) == 1 && members[0] == U_STRING_FROM_CONSTANT("key"));
+   U_INTERNAL_ASSERT(ok)
+
+   U_DELETE(tree1) // NB: arena2 is set...
+
+   arena2.reset();
+
+   (void) UValue::setArena(U_NULLPTR);
+
+   U_DELETE(tree2) // NB: after the reset of its arena...
+
+   ok = json.parse(U_STRING_FROM_CONSTANT("[\"heap\"]"));
+   U_INTERNAL_ASSERT(ok)
+
+   ok = (json.isArena() == false && json.at(0)->getString() == U_STRING_FROM_CONSTANT("heap"));
+   U_INTERNAL_ASSERT(ok)
+
+   json.clear();
+   }
+
    while (cin >> filename)
       {
       content = UFile::contentOf(filename);
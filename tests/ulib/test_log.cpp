@@ -29,5 +29,26 @@ U_EXPORT main (int argc, char* argv[], char* env[])
       y.msync();
       }
 
+#if defined(ENABLE_THREAD) && !defined(_MSWINDOWS_)
+   ULog z(U_STRING_FROM_CONSTANT("$PWD/test_log_ring.log"), 64 * 1024);
+
+   z.setRing(2, 16 * 1024);
+
+   U_INTERNAL_ASSERT(z.isRing())
+
+   for (i = 0; i < n; ++i) z.log(U_CONSTANT_TO_PARAM("ring message %6d"), i+1);
+
+   z.flush();
+   z.closeLog();
+
+   UString content = UFile::contentOf(U_STRING_FROM_CONSTANT("test_log_ring.log"));
+
+   uint32_t pos = 0, count = 0;
+
+   while ((pos = content.find("ring message", pos, U_CONSTANT_SIZE("ring message"))) != U_NOT_FOUND) { ++pos; ++count; }
+
+   U_INTERNAL_ASSERT_EQUALS(count, n)
+#endif
+
    cout << "ok" << '\n';
 }
@@ -3,6 +3,7 @@
 #include <ulib/debug/crono.h>
 #include <ulib/string.h>
 #include <ulib/utility/interrupt.h>
+#include <ulib/thread.h>
 #include <sys/time.h>
 
 //#define PRINT_SIZE
@@ -169,6 +170,48 @@ static void check_size()
    U_ASSERT( U_SIZE_TO_STACK_INDEX(U_STACK_TYPE_9 - 0) ==  9 )
 }
 
+#if defined(ENABLE_THREAD) && defined(ENABLE_MEMPOOL)
+static UString* vstr[1024];
+
+static void allocTask(void* arg) // NB: every thread allocate and free on its magazines...
+{
+   U_TRACE(5, "::allocTask(%p)", arg)
+
+   UString* obj[64];
+
+   for (int i = 0; i < 1000; ++i)
+      {
+      for (int k = 0; k < 64; ++k) U_NEW_STRING(obj[k], UString(U_CONSTANT_TO_PARAM("allocated")));
+      for (int k = 0; k < 64; ++k) delete obj[k];
+      }
+}
+
+static void freeTask(void* arg, uint32_t i) // NB: the strings are allocated by the main thread (cross-thread free)...
+{
+   U_TRACE(5, "::freeTask(%p,%u)", arg, i)
+
+   delete vstr[i];
+}
+
+static void check_magazine()
+{
+   U_TRACE(5, "check_magazine()")
+
+   UThreadPool pool(4);
+
+   for (int i = 0; i < 8; ++i) pool.addTask(allocTask, U_NULLPTR);
+
+   pool.waitForWorkToBeFinished();
+
+   for (int i = 0; i < 1024; ++i) U_NEW_STRING(vstr[i], UString(U_CONSTANT_TO_PARAM("cross")));
+
+   pool.parallelFor(1024, freeTask, U_NULLPTR);
+
+   U_ASSERT(UMemoryPool::magazine_refill > 0)
+   U_ASSERT(UMemoryPool::magazine_drain > 0)
+}
+#endif
+
 static struct itimerval timeval = { { 0, 2000 }, { 0, 2000 } };
 
 static RETSIGTYPE
@@ -238,6 +281,10 @@ U_EXPORT main(int argc, char** argv)
 
    if (argc > 2) printf("Time Consumed with U_NUM_ENTRY_MEM_BLOCK(%d) = %ld ms\n", n, crono.getTimeElapsed());
 
+#if defined(ENABLE_THREAD) && defined(ENABLE_MEMPOOL)
+   check_magazine();
+#endif
+
 #ifdef DEBUG
    UMemoryPool::printInfo(cout);
 #endif
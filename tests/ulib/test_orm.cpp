@@ -384,6 +384,49 @@ static void testComplexType(UOrmSession* sql)
    U_ASSERT(p2 == c2)
 }
 
+static int batch_id;
+static UString* batch_name;
+
+static void bindUser(uint32_t i)
+{
+   U_TRACE(5, "bindUser(%u)", i)
+
+   batch_id = 10 + i;
+
+   batch_name->snprintf(U_CONSTANT_TO_PARAM("user%u"), i);
+}
+
+static void testBatch(UOrmSession* sql)
+{
+   U_TRACE(5, "testBatch(%p)", sql)
+
+   int count = 0;
+   UString name(100U);
+
+   batch_name = &name;
+
+   UOrmStatement select(*sql, U_CONSTANT_TO_PARAM("SELECT COUNT(*) FROM users"));
+
+   select.into(count);
+
+   // NB: the same statement of insert1 (in use) is prepared again, the second time it is taken from the cache...
+
+   for (uint32_t i = 0; i < 2; ++i)
+      {
+      UOrmStatement insert(*sql, U_CONSTANT_TO_PARAM("INSERT INTO users(id, name) VALUES(?, ?)"));
+
+      insert.use(batch_id, name);
+
+      bool ok = insert.executeMany(3 + i, bindUser);
+
+      select.execute();
+
+      cout << "Batch: " << ok << ", there are " << count << " users\n";
+
+      *sql << "DELETE FROM users WHERE id >= 10";
+      }
+}
+
 #define  PGSQL_AUTO_INCREMENT "serial  primary key"
 #define  MYSQL_AUTO_INCREMENT "integer primary key auto_increment"
 #define SQLITE_AUTO_INCREMENT "integer primary key autoincrement"
@@ -523,6 +566,8 @@ U_EXPORT main(int argc, char* argv[])
 
    cout << "Deleted " << sql.affected() << " rows\n";
 
+   testBatch(&sql);
+
    testBinding(&sql);
    testSimpleAccess(&sql);
    testSimpleAccessVector(&sql);
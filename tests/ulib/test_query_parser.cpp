@@ -9,6 +9,20 @@ static bool eval(UStringRep* word)
    return false;
 }
 
+static bool eval1(UStringRep* word)
+{
+   U_TRACE(5,"eval1(%.*S)", U_STRING_TO_TRACE(*word))
+
+   return (word->size() == 1 && (word->first_char() - 'a') % 2 == 0); // a c e g i ...
+}
+
+static uint32_t cost(UStringRep* word)
+{
+   U_TRACE(5,"cost(%.*S)", U_STRING_TO_TRACE(*word))
+
+   return (word->size() == 1 ? 'z' - word->first_char() : 0);
+}
+
 int
 U_EXPORT main (int argc, char* argv[])
 {
@@ -22,6 +36,7 @@ U_EXPORT main (int argc, char* argv[])
    uint32_t i, sz;
    UQueryNode* term;
    UQueryParser parser;
+   UVector<UString> vquery;
    UVector<UQueryNode*> termRoots;
    UVector<UString> positives, negatives;
 
@@ -49,11 +64,39 @@ U_EXPORT main (int argc, char* argv[])
 
       parser.startEvaluate(eval);
 
-      cout << "Evaluate   : " << (parser.evaluate() ? "true" : "false")
+      cout << "Evaluate   : " << (parser.evaluate() ? "true" : "false") << "\n";
+
+      parser.setFunction(eval1);
+
+      cout << "Evaluate1  : " << (parser.evaluate() ? "true" : "false")
            << "\n--------------------------------------------------------------------------------------\n";
 
+      vquery.push_back(query);
+
           query.clear();
       termRoots.clear();
          parser.clear();
       }
+
+   // compiled program with the cost of the words and the cache (the second time the query is not parsed)
+
+   UQueryParser::setCache(32);
+
+   for (uint32_t k = 0; k < 2; ++k)
+      {
+      for (i = 0, sz = vquery.size(); i < sz; ++i)
+         {
+         if (parser.compile(vquery[i], cost))
+            {
+            parser.setFunction(eval1);
+
+            cout << "Program    : " << *parser.getProgram() << "\n"
+                 << "Evaluate1  : " << (parser.evaluate() ? "true" : "false") << (parser.getTree() ? "" : " (cache)") << "\n";
+
+            parser.clear();
+            }
+         }
+      }
+
+   UQueryParser::clearCache();
 }
@@ -1,5 +1,6 @@
 // test_rdb.cpp
 
+#include <ulib/process.h>
 #include <ulib/db/rdb.h>
 
 static int print(UStringRep* key, UStringRep* data)
@@ -54,6 +55,103 @@ static void transaction(URDB& rdb)
       }
 }
 
+static void compaction(const UString& name)
+{
+   U_TRACE(5, "::compaction(%V)", name.rep)
+
+   // NB: with a semaphore reorganize() build the new cdb without the lock while a child process continue to write...
+
+   URDB rdb(false);
+   char buffer[32];
+   uint32_t i, n = 0;
+
+   if (rdb.open(name, 1024 * 1024, true, true, true, U_NULLPTR))
+      {
+      for (i = 0; i < 10000; ++i)
+         {
+         UString key((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("key_%u"), i));
+
+         rdb.store(key, key, RDB_INSERT);
+         }
+
+      UProcess proc;
+
+      if (proc.fork() &&
+          proc.child())
+         {
+         for (i = 0; i < 10000; ++i)
+            {
+            UString key((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("new_%u"), i));
+
+            rdb.store(key, key, RDB_INSERT);
+            }
+
+         ::_exit(0);
+         }
+
+      while (UProcess::waitpid(proc.pid()) == 0) if (rdb.reorganize()) ++n;
+
+      if (rdb.reorganize()) ++n;
+
+      U_ASSERT( n > 0 )
+      U_ASSERT( rdb.size() == 20000 )
+      U_ASSERT( URDB::ncompaction >= n )
+
+      for (i = 0; i < 10000; ++i)
+         {
+         UString key((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("new_%u"), i));
+
+         U_ASSERT( rdb[key] == key )
+         }
+
+      rdb.close();
+      }
+}
+
+static void journalFull(const UString& name)
+{
+   U_TRACE(5, "::journalFull(%V)", name.rep)
+
+   // NB: with two references the journal cannot grow, so the store fail when it is full and the node allocated must be given back...
+
+   int result;
+   URDB x(false), y(false);
+   char buffer[32];
+   uint32_t i, n, capacity;
+   UString data(1000U, 'x');
+
+   if (x.open(name, 64 * 1024, true) &&
+       y.open(name, 64 * 1024))
+      {
+      for (n = 0; n < 1000; ++n)
+         {
+         UString key((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("key_%u"), n));
+
+         if (x.store(key, data, RDB_INSERT)) break;
+         }
+
+      capacity = x.getCapacity();
+
+      for (i = 0; i < 1000; ++i) // NB: without the give back of the node the journal is exhausted and htAlloc() fail...
+         {
+         UString key((const void*)buffer, u__snprintf(buffer, sizeof(buffer), U_CONSTANT_TO_PARAM("new_%u"), i));
+
+         result = x.store(key, data, RDB_INSERT);
+
+         U_ASSERT( result == -3 )
+         U_ASSERT( x.remove(key) == -1 )
+         U_ASSERT( x.getCapacity() == capacity )
+         }
+
+      U_ASSERT( x.size() == n )
+
+      cout << "journal full: " << n << " records, capacity " << (x.getCapacity() == capacity ? "unchanged" : "changed") << endl;
+
+      y.close();
+      x.close();
+      }
+}
+
 int
 U_EXPORT main(int argc, char* argv[], char* env[])
 {
@@ -239,5 +337,9 @@ U_EXPORT main(int argc, char* argv[], char* env[])
 
          x.close();
          }
+
+      compaction(name + U_STRING_FROM_CONSTANT(".online"));
+
+      journalFull(name + U_STRING_FROM_CONSTANT(".full"));
       }
 }
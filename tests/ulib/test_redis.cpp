@@ -2,6 +2,15 @@
 
 #include <ulib/net/client/redis.h>
 
+static void getAsyncReply(UREDISClient_Base* prc, void* arg)
+{
+   U_TRACE(5, "::getAsyncReply(%p,%p)", prc, arg)
+
+   U_INTERNAL_ASSERT_EQUALS(prc->getError(), U_RC_OK)
+
+   ++(*(uint32_t*)arg);
+}
+
 int main(int argc, char *argv[], char* env[])
 {
    U_ULIB_INIT(argv);
@@ -105,6 +114,17 @@ int main(int argc, char *argv[], char* env[])
 
       U_INTERNAL_ASSERT(ok)
 
+      uint32_t nreply = 0;
+
+      for (uint32_t i = 0; i < 100; ++i) (void) rc.asyncRequest(getAsyncReply, &nreply, U_CONSTANT_TO_PARAM("INCR MYCOUNTER"));
+
+      U_INTERNAL_ASSERT_EQUALS(rc.asyncPending(), 100)
+
+      ok = rc.asyncWait(); // all the commands are sent with one write, the replies are matched in order
+
+      U_INTERNAL_ASSERT(ok)
+      U_INTERNAL_ASSERT_EQUALS(nreply, 100)
+
       ok = rc.deleteKeys(U_CONSTANT_TO_PARAM("MY*"));
 
       U_INTERNAL_ASSERT(ok)
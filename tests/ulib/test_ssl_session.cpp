@@ -0,0 +1,141 @@
+// test_ssl_session.cpp
+
+#include <ulib/net/server/server.h>
+#include <ulib/ssl/net/ssl_session.h>
+
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+#  define U_HMAC_CTX HMAC_CTX
+#else
+#  define U_HMAC_CTX EVP_MAC_CTX
+#endif
+
+// NB: USSLSession is friend of a class named Application...
+
+class Application {
+public:
+
+   static void init()
+      {
+      U_TRACE_NO_PARAM(5, "Application::init()")
+
+      UServer_Base::ptr_shared_data = (UServer_Base::shared_data*) calloc(1, sizeof(UServer_Base::shared_data));
+
+      USSLSocket::sctx = SSL_CTX_new(TLS_server_method());
+
+      USSLSession::ticket_key_rotate = U_ONE_HOUR_IN_SECOND;
+
+      USSLSession::initTicketKey();
+
+      ectx = EVP_CIPHER_CTX_new();
+#  if OPENSSL_VERSION_NUMBER < 0x30000000L
+      hctx = HMAC_CTX_new();
+#  else
+      mac  = EVP_MAC_fetch(U_NULLPTR, "HMAC", U_NULLPTR);
+      hctx = EVP_MAC_CTX_new(mac);
+#  endif
+      }
+
+   static void clear()
+      {
+      U_TRACE_NO_PARAM(5, "Application::clear()")
+
+      EVP_CIPHER_CTX_free(ectx);
+#  if OPENSSL_VERSION_NUMBER < 0x30000000L
+      HMAC_CTX_free(hctx);
+#  else
+      EVP_MAC_CTX_free(hctx);
+      EVP_MAC_free(mac);
+#  endif
+
+      SSL_CTX_free(USSLSocket::sctx);
+
+      free(UServer_Base::ptr_shared_data);
+      }
+
+   static int ticket(unsigned char* name, int enc)
+      {
+      U_TRACE(5, "Application::ticket(%p,%d)", name, enc)
+
+      unsigned char iv[16];
+
+      (void) memset(iv, 0, sizeof(iv));
+
+      return USSLSession::ticketKey(U_NULLPTR, name, iv, ectx, hctx, enc);
+      }
+
+   static bool isZero(const unsigned char* key)
+      {
+      for (uint32_t i = 0; i < sizeof(U_SRV_SSL_TICKET_KEY[0]); ++i) if (key[i]) return false;
+
+      return true;
+      }
+
+   // all the slots have a random key, a forged ticket with a zero name (and zero keys) is rejected
+
+   static void testKey()
+      {
+      U_TRACE_NO_PARAM(5, "Application::testKey()")
+
+      unsigned char name[16], zero[16];
+
+      (void) memset(zero, 0, sizeof(zero));
+
+      for (uint32_t i = 0; i < U_SSL_TICKET_KEY_NUM; ++i) cout << "slot " << i << " zero: " << isZero(U_SRV_SSL_TICKET_KEY[i]) << '\n';
+
+      cout << "zero ticket: " << ticket(zero, 0) << '\n';
+
+      cout << "new ticket: " << ticket(name, 1) << '\n'
+           << "new ticket name: " << (memcmp(name, U_SRV_SSL_TICKET_KEY[0], 16) == 0) << '\n'
+           << "new ticket resumed: " << ticket(name, 0) << '\n';
+
+      // NB: before the first rotation there is no previous key...
+
+      (void) memcpy(name, U_SRV_SSL_TICKET_KEY[U_SSL_TICKET_KEY_NUM-1], 16);
+
+      cout << "previous key before rotation: " << ticket(name, 0) << '\n';
+
+      // the rotation: the ticket of the previous key is renewed
+
+      U_SRV_SSL_TICKET_KEY_TIME -= USSLSession::ticket_key_rotate;
+
+      (void) memcpy(name, U_SRV_SSL_TICKET_KEY[0], 16);
+
+      cout << "old ticket renewed: " << ticket(name, 0) << '\n'
+           << "key index: " << U_SRV_SSL_TICKET_KEY_INDEX << '\n'
+           << "zero ticket: " << ticket(zero, 0) << '\n';
+
+      // two rotations: the ticket of the key before the previous one is expired
+
+      U_SRV_SSL_TICKET_KEY_TIME -= USSLSession::ticket_key_rotate;
+
+      cout << "old ticket expired: " << ticket(name, 0) << '\n'
+           << "key index: " << U_SRV_SSL_TICKET_KEY_INDEX << '\n';
+      }
+
+private:
+   static EVP_CIPHER_CTX* ectx;
+   static U_HMAC_CTX*     hctx;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   static EVP_MAC*        mac;
+#endif
+};
+
+EVP_CIPHER_CTX* Application::ectx;
+U_HMAC_CTX*     Application::hctx;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+EVP_MAC*        Application::mac;
+#endif
+
+int
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   u_gettimenow();
+
+   Application::init();
+   Application::testKey();
+   Application::clear();
+}
@@ -2178,6 +2178,22 @@ U_EXPORT main(int argc, char* argv[])
    U_ASSERT( z == y )
 #endif
 
+#ifdef USE_LIBZSTD
+   x = UStringExt::zstd(z);
+
+   U_ASSERT( UStringExt::isZstd(x) )
+
+   y = UStringExt::unzstd(x);
+
+   U_ASSERT( z == y )
+
+   x = UStringExt::zstd(z, 1);
+
+   y = UStringExt::unzstd(x);
+
+   U_ASSERT( z == y )
+#endif
+
    y = U_STRING_FROM_CONSTANT("ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+/");
    z = U_STRING_FROM_CONSTANT("abcdefghijklmnopqrstuvwxyz0123456789+/");
 
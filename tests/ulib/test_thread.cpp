@@ -193,6 +193,20 @@ public:
       }
 };
 
+static void incTask(void* arg)
+{
+   U_TRACE(5, "::incTask(%p)", arg)
+
+   (void) __sync_add_and_fetch((long*)arg, 1L);
+}
+
+static void squareIndex(void* arg, uint32_t i)
+{
+   U_TRACE(5, "::squareIndex(%p,%u)", arg, i)
+
+   ((uint64_t*)arg)[i] = (uint64_t)i * i;
+}
+
 int U_EXPORT main(int argc, char* argv[])
 {
    U_ULIB_INIT(argv);
@@ -308,6 +322,25 @@ int U_EXPORT main(int argc, char* argv[])
 
    cout << "thread pool finished" << endl;
 
+   long counter = 0;
+
+   for (int i = 0; i < 100000; ++i) tp.addTask(incTask, &counter);
+
+   tp.waitForWorkToBeFinished();
+
+   cout << "- thread pool should run 100000 tasks..." << (counter == 100000 ? "ok" : "ko") << endl;
+
+   uint32_t i, n = 1000000;
+   uint64_t* vec = new uint64_t[n];
+
+   tp.parallelFor(n, squareIndex, vec);
+
+   for (i = 0; i < n; ++i) if (vec[i] != (uint64_t)i * i) break;
+
+   delete[] vec;
+
+   cout << "- thread pool parallelFor should fill the vector..." << (i == n ? "ok" : "ko") << endl;
+
    printf("\nNow program should finish... :)\n");
 
    return 0;
@@ -0,0 +1,151 @@
+// test_throttling.cpp
+
+#include <ulib/net/server/server.h>
+
+#ifdef U_THROTTLING_SUPPORT
+#  define U_BURST(kbs) ((kbs) * 1024LL * 2) // NB: U_THROTTLE_TIME is 2 seconds...
+
+// NB: UServer_Base is friend of a class named Application...
+
+class Application {
+public:
+
+   static void init()
+      {
+      U_TRACE_NO_PARAM(5, "Application::init()")
+
+      UServer_Base::ptr_shared_data = (UServer_Base::shared_data*) calloc(1, sizeof(UServer_Base::shared_data));
+
+      // rule 0: two exact patterns, rule 1: prefix with min rate, rule 2: two suffix, rule 3: generic glob, rule 4: exact pattern shared with rule 0
+
+      U_NEW_STRING(UServer_Base::throttling_mask, UString(U_CONSTANT_TO_PARAM("/index.html|/big.bin 100\n"
+                                                                             "/download/*          50-200\n"
+                                                                             "*.iso|*.mp4          10\n"
+                                                                             "/a?c/*.txt           20\n"
+                                                                             "/index.html          30\n")));
+
+      UServer_Base::initThrottlingServer();
+      }
+
+   static void clear()
+      {
+      U_TRACE_NO_PARAM(5, "Application::clear()")
+
+      U_DELETE(UServer_Base::throttling_exact)
+      U_DELETE(UServer_Base::throttling_mask)
+
+      UMemoryPool::_free(UServer_Base::throttling_glob, UServer_Base::throttling_num_rule * 4, sizeof(UServer_Base::uthrottling_glob));
+
+      free(UServer_Base::ptr_shared_data);
+
+      UServer_Base::throttling_bucket = U_NULLPTR;
+      }
+
+   static uint32_t rule(const char* uri) { return UServer_Base::getThrottlingRule(uri, u__strlen(uri, __PRETTY_FUNCTION__)); }
+
+   // the patterns without wildcard go in the hash table, the others are compiled as prefix, suffix or generic glob
+
+   static void testRule()
+      {
+      U_TRACE_NO_PARAM(5, "Application::testRule()")
+
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::throttling_num_rule, 5)
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::throttling_num_glob, 4)
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::throttling_exact->size(), 2)
+
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::throttling_glob[0].type, 'p')
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::throttling_glob[1].type, 's')
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::throttling_glob[2].type, 's')
+      U_INTERNAL_ASSERT_EQUALS(UServer_Base::throttling_glob[3].type, 'g')
+
+      U_INTERNAL_ASSERT_EQUALS(rule("/index.html"), 1U | 16U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/big.bin"),    1U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/index.htm"),  0U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/index.html/"), 0U)
+
+      U_INTERNAL_ASSERT_EQUALS(rule("/download/"),          2U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/download/a.zip"),     2U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/download/a.iso"),     2U | 4U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/downloads/a.zip"),    0U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/movie.mp4"),          4U)
+      U_INTERNAL_ASSERT_EQUALS(rule(".iso"),                4U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/a.iso.txt"),          0U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/abc/readme.txt"),     8U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/axc/d/readme.txt"),   8U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/ac/readme.txt"),      0U)
+      U_INTERNAL_ASSERT_EQUALS(rule("/abc/readme.doc"),     0U)
+
+      UServer_Base::uthrottling_bucket* pbucket = UServer_Base::throttling_bucket;
+
+      U_INTERNAL_ASSERT_EQUALS(pbucket[0].tokens, U_BURST(100))
+      U_INTERNAL_ASSERT_EQUALS(pbucket[1].min_limit, 50)
+      U_INTERNAL_ASSERT_EQUALS(pbucket[1].max_limit, 200)
+      U_INTERNAL_ASSERT_EQUALS(pbucket[1].tokens, U_BURST(200))
+      }
+
+   // the token bucket: the charge can go in debt, the refill add max rate * elapsed and is clamped to the burst
+
+   static void testBucket()
+      {
+      U_TRACE_NO_PARAM(5, "Application::testBucket()")
+
+      UServer_Base::uthrottling_bucket* pbucket = UServer_Base::throttling_bucket;
+
+      uint64_t now = pbucket[0].refill_ms;
+
+      UServer_Base::chargeThrottling(1U, 300 * 1024);
+
+      U_INTERNAL_ASSERT_EQUALS(pbucket[0].tokens, U_BURST(100) - 300 * 1024)
+      U_INTERNAL_ASSERT_EQUALS(pbucket[0].bytes,  300 * 1024)
+      U_INTERNAL_ASSERT_EQUALS(pbucket[4].tokens, U_BURST(30))
+
+      // one second: 100 kB
+
+      UServer_Base::refillThrottling(pbucket, now + 1000);
+
+      U_INTERNAL_ASSERT_EQUALS(pbucket[0].tokens,    U_BURST(100) - 200 * 1024)
+      U_INTERNAL_ASSERT_EQUALS(pbucket[0].refill_ms, now + 1000)
+
+      // the same time or a time in the past: nothing
+
+      UServer_Base::refillThrottling(pbucket, now + 1000);
+      UServer_Base::refillThrottling(pbucket, now);
+
+      U_INTERNAL_ASSERT_EQUALS(pbucket[0].tokens,    U_BURST(100) - 200 * 1024)
+      U_INTERNAL_ASSERT_EQUALS(pbucket[0].refill_ms, now + 1000)
+
+      // a long idle period: the bucket is full at most of the burst
+
+      UServer_Base::refillThrottling(pbucket, now + 61000);
+
+      U_INTERNAL_ASSERT_EQUALS(pbucket[0].tokens, U_BURST(100))
+
+      // the debt, and a quarter of second: 25 kB
+
+      UServer_Base::chargeThrottling(1U | 16U, U_BURST(100) + 50 * 1024);
+
+      U_INTERNAL_ASSERT_EQUALS(pbucket[0].tokens, -50 * 1024)
+      U_INTERNAL_ASSERT_EQUALS(pbucket[4].tokens, U_BURST(30) - U_BURST(100) - 50 * 1024)
+      U_INTERNAL_ASSERT_EQUALS(pbucket[4].bytes,  U_BURST(100) + 50 * 1024)
+
+      UServer_Base::refillThrottling(pbucket, now + 61250);
+
+      U_INTERNAL_ASSERT_EQUALS(pbucket[0].tokens, -25 * 1024)
+      }
+};
+#endif
+
+int
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+#ifdef U_THROTTLING_SUPPORT
+   Application::init();
+   Application::testRule();
+   Application::testBucket();
+   Application::clear();
+#endif
+}
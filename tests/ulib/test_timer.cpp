@@ -78,6 +78,124 @@ public:
 #endif
 };
 
+// the hierarchical timing wheel: the alarm record the order of expiration, printed by testWheel()
+
+class MyAlarm3 : public UEventTime {
+public:
+
+   static long vfired[16];
+   static uint32_t nfired;
+
+   long ms;
+   int nrun;
+
+   // COSTRUTTORI
+
+   MyAlarm3(long _ms, int _nrun = 1) : UEventTime(0L, 1L), ms(_ms), nrun(_nrun)
+      {
+      U_TRACE_CTOR(0, MyAlarm3, "%ld,%d", _ms, _nrun)
+
+      UTimeVal::setMilliSecond(_ms);
+
+      setTolerance();
+      }
+
+   virtual ~MyAlarm3()
+      {
+      U_TRACE_DTOR(0, MyAlarm3)
+      }
+
+   bool isPending() const { return (ptimer != U_NULLPTR); }
+
+   virtual int handlerTime()
+      {
+      U_TRACE(0+256, "MyAlarm3::handlerTime()")
+
+      U_INTERNAL_ASSERT_MINOR(nfired, U_NUM_ELEMENTS(vfired))
+
+      vfired[nfired++] = ms;
+
+      if (--nrun > 0) U_RETURN(0);
+
+      U_RETURN(-1);
+      }
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
+#endif
+};
+
+long     MyAlarm3::vfired[16];
+uint32_t MyAlarm3::nfired;
+
+static void printFired(const char* label, uint32_t start)
+{
+   U_TRACE(5, "::printFired(%S,%u)", label, start)
+
+   cout << "wheel: " << label << " fired";
+
+   for (uint32_t i = start; i < MyAlarm3::nfired; ++i) cout << ' ' << MyAlarm3::vfired[i];
+
+   cout << '\n';
+}
+
+static void testWheel()
+{
+   U_TRACE_NO_PARAM(5, "testWheel()")
+
+   // NB: the lines that start with "wheel:" are compared with ok/timer.ok (see timer.test)...
+
+   UTimer::init(UTimer::NOSIGNAL, true);
+
+   // NB: 3, 10, 20 and 40 ms go in the level 0, 70, 100 and 130 ms in the level 1 (they are cascaded), 5000 ms in the level 2...
+
+   MyAlarm3 a130(130), a3(3), a70(70), a40(40), a100(100), a10(10), a20(20, 2), a5000(5000);
+
+   UTimer::insert(&a130);
+   UTimer::insert(&a3);
+   UTimer::insert(&a70);
+   UTimer::insert(&a40);
+   UTimer::insert(&a100);
+   UTimer::insert(&a10);
+   UTimer::insert(&a20);
+   UTimer::insert(&a5000);
+
+   // erase an item of the level 0 and one of the level 1
+
+   UTimer::erase(&a40);
+   UTimer::erase(&a100);
+
+   cout << "wheel: erase 40 pending " << a40.isPending() << " erase 100 pending " << a100.isPending() << '\n';
+
+   UTimeVal::nanosleep(200L);
+
+   UTimer::run();
+
+   // NB: the monitoring alarm (20 ms) is reinserted from the current time, so it expire again only at the next run...
+
+   uint32_t n = MyAlarm3::nfired;
+
+   printFired("run 1", 0);
+
+   cout << "wheel: 20 pending " << a20.isPending() << " 130 pending " << a130.isPending() << '\n';
+
+   UTimeVal(0L, 50L * 1000L).nanosleep();
+
+   UTimer::run();
+
+   printFired("run 2", n);
+
+   // the far alarm is still pending
+
+   cout << "wheel: 20 pending " << a20.isPending() << " 5000 pending " << a5000.isPending() << " empty " << UTimer::empty() << '\n';
+
+   UTimer::erase(&a5000);
+
+   cout << "wheel: erase 5000 empty " << UTimer::empty() << '\n';
+
+   UTimer::clear();
+}
+
 int U_EXPORT main (int argc, char* argv[])
 {
    U_ULIB_INIT(argv);
@@ -136,4 +254,6 @@ int U_EXPORT main (int argc, char* argv[])
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
    if (argc > 2) UTimer::printInfo(cout);
 #endif
+
+   testWheel();
 }
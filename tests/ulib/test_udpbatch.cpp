@@ -0,0 +1,166 @@
+// test_udpbatch.cpp
+
+#include <ulib/net/udpbatch.h>
+
+#include <netinet/in.h>
+
+static int fds, fdr;
+static struct sockaddr_in addr;
+
+static uint32_t vsize[U_UDP_MAX_SEGMENT];
+static uint8_t out[U_UDP_MAX_SEGMENT * 1500];
+
+// the packets of a pass of the send loop: runs of the same size (the last one shorter), a single and some small, every one with a different payload
+
+static uint32_t fill()
+{
+   U_TRACE_NO_PARAM(5, "fill()")
+
+   static const uint32_t vrun[][2] = { { 10, 1200 }, { 1, 500 }, { 3, 800 }, { 1, 1350 }, { 5, 100 } };
+
+   uint32_t i, j, n = 0;
+
+   for (i = 0; i < U_NUM_ELEMENTS(vrun); ++i)
+      {
+      for (j = 0; j < vrun[i][0]; ++j) vsize[n++] = vrun[i][1];
+      }
+
+   for (i = 0; i < sizeof(out); ++i) out[i] = (uint8_t)((i * 31) + (i >> 8));
+
+   return n;
+}
+
+// the datagrams returned by next() must be the packets sent, in order and with the same size and payload (GRO split the coalesced ones)
+
+static uint32_t receive(uint32_t n)
+{
+   U_TRACE(5, "receive(%u)", n)
+
+   char buffer[2048];
+   struct sockaddr_storage peer;
+   uint32_t k = 0, sz, peer_len, offset = 0;
+
+   while (k < n)
+      {
+      if ((sz = UUDPBatch::next(buffer, sizeof(buffer), &peer, &peer_len)) == 0)
+         {
+         if (UUDPBatch::read(fdr, true) <= 0) break;
+
+         continue;
+         }
+
+      if (sz != vsize[k] ||
+          peer_len != sizeof(struct sockaddr_in) ||
+          memcmp(buffer, out + offset, sz) != 0)
+         {
+         break;
+         }
+
+      offset += sz;
+
+      ++k;
+      }
+
+   return k;
+}
+
+static void check(const char* label, bool bgro, bool bgso)
+{
+   U_TRACE(5, "check(%S,%b,%b)", label, bgro, bgso)
+
+   uint32_t n = fill();
+
+   UUDPBatch::init(fdr, bgro);
+
+   if (bgso == false) UUDPBatch::bgso = false; // NB: the fall back to sendmmsg()...
+
+   bool ok = UUDPBatch::send(fds, (const struct sockaddr*)&addr, sizeof(addr), out, vsize, n);
+
+   cout << label << ": send " << ok << ", received " << receive(n) << " of " << n << " datagrams\n";
+}
+
+// the datagram read with recvmsg() (io_uring): split() return the first segment and keep the others for next()
+
+static void checkSplit()
+{
+   U_TRACE_NO_PARAM(5, "checkSplit()")
+
+   char data[U_UDP_BATCH_SIZE], buffer[2048];
+   struct iovec iov = { data, sizeof(data) };
+   struct sockaddr_storage peer, from;
+   struct msghdr msg;
+   uint32_t i, n = 4, k = 0, sz, peer_len;
+
+   for (i = 0; i < n; ++i) vsize[i] = 1000;
+
+   UUDPBatch::init(fdr, true);
+
+   (void) UUDPBatch::send(fds, (const struct sockaddr*)&addr, sizeof(addr), out, vsize, n);
+
+   while (k < n)
+      {
+      (void) memset(&msg, 0, sizeof(msg));
+
+      msg.msg_name       = &from;
+      msg.msg_namelen    = sizeof(from);
+      msg.msg_iov        = &iov;
+      msg.msg_iovlen     = 1;
+      msg.msg_control    = UUDPBatch::rcontrol;
+      msg.msg_controllen = sizeof(UUDPBatch::rcontrol);
+
+      ssize_t len = recvmsg(fdr, &msg, 0);
+
+      if (len <= 0) break;
+
+      sz = (UUDPBatch::bgro ? UUDPBatch::split(&msg, data, len) : len);
+
+      if (sz != 1000 || memcmp(data, out + (k * 1000), sz) != 0) break;
+
+      for (++k; (sz = UUDPBatch::next(buffer, sizeof(buffer), &peer, &peer_len)); ++k)
+         {
+         if (sz != 1000 || memcmp(buffer, out + (k * 1000), sz) != 0) goto end;
+         }
+      }
+
+end:
+
+   cout << "split: received " << k << " of " << n << " datagrams\n";
+}
+
+int
+U_EXPORT main(int argc, char* argv[])
+{
+   U_ULIB_INIT(argv);
+
+   U_TRACE(5,"main(%d)",argc)
+
+   socklen_t len = sizeof(addr);
+   int size = 4 * 1024 * 1024;
+
+   fds = socket(AF_INET, SOCK_DGRAM, 0);
+   fdr = socket(AF_INET, SOCK_DGRAM, 0);
+
+   (void) memset(&addr, 0, sizeof(addr));
+
+   addr.sin_family      = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   (void) setsockopt(fdr, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+   if (bind(fdr, (struct sockaddr*)&addr, sizeof(addr)) ||
+       getsockname(fdr, (struct sockaddr*)&addr, &len))
+      {
+      U_ERROR("bind() on loopback failed");
+      }
+
+   // NB: GRO and GSO are used only if the kernel support them, the result must be the same...
+
+   check("recvmmsg",     false, true);
+   check("recvmmsg+GRO", true,  true);
+   check("sendmmsg+GRO", true,  false);
+
+   checkSplit();
+
+   (void) close(fds);
+   (void) close(fdr);
+}